@@ -0,0 +1,192 @@
+// client_sim.cpp
+//
+// Paho C++ sample application that simulates a large number of devices,
+// each with its own connection to the server, to load-test the server.
+//
+// The clients are made by a client_pool, without persistence, so that
+// they are cheap to create. They are connected at a limited rate, then
+// each publishes a number of messages to its own topic, and the totals
+// for all of them are reported at the end.
+//
+// USAGE:
+//     client_sim [options] [address]
+//
+// OPTIONS:
+//     -c <count>  The number of clients (1000)
+//     -r <rate>   The number of connections to start per second (100)
+//     -n <count>  The number of messages for each client (10)
+//     -s <size>   The size of each payload, in bytes (64)
+//     -q <qos>    The QoS of the messages (1)
+//     -i <ms>     The interval between a client's messages, in ms (100)
+//
+
+/*******************************************************************************
+ * Copyright (c) 2025 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "mqtt/async_client.h"
+#include "mqtt/client_pool.h"
+
+using namespace std;
+using namespace std::chrono;
+
+const string DFLT_SERVER_ADDRESS{"mqtt://localhost:1883"};
+const string CLIENT_ID_PREFIX{"client_sim"};
+const string TOPIC{"test/sim"};
+
+// How long to wait for all the connections to complete
+const auto CONNECT_TIMEOUT = seconds(60);
+
+// Convert a duration to a count of milliseconds
+template <class Rep, class Period>
+int64_t msec(const std::chrono::duration<Rep, Period>& dur)
+{
+    return (int64_t)duration_cast<milliseconds>(dur).count();
+}
+
+// Gets a rate per second, without dividing by zero for a fast run
+int64_t rate(uint64_t n, int64_t ms) { return int64_t(n * 1000 / std::max<int64_t>(ms, 1)); }
+
+/////////////////////////////////////////////////////////////////////////////
+
+int main(int argc, char* argv[])
+{
+    string address = DFLT_SERVER_ADDRESS;
+    size_t nClients = 1000, msgSz = 64;
+    double connRate = 100.0;
+    int nMsg = 10, qos = 1, intervalMs = 100;
+
+    try {
+        for (int i = 1; i < argc; ++i) {
+            string arg{argv[i]};
+            if (arg.size() == 2 && arg[0] == '-') {
+                if (++i >= argc)
+                    throw std::invalid_argument("Missing value for " + arg);
+                string val{argv[i]};
+                switch (arg[1]) {
+                    case 'c':
+                        nClients = std::max<size_t>(atol(val.c_str()), 1);
+                        break;
+                    case 'r':
+                        connRate = atof(val.c_str());
+                        break;
+                    case 'n':
+                        nMsg = atoi(val.c_str());
+                        break;
+                    case 's':
+                        msgSz = (size_t)atol(val.c_str());
+                        break;
+                    case 'q':
+                        qos = atoi(val.c_str());
+                        break;
+                    case 'i':
+                        intervalMs = atoi(val.c_str());
+                        break;
+                    default:
+                        throw std::invalid_argument("Unknown option " + arg);
+                }
+            }
+            else
+                address = arg;
+        }
+    }
+    catch (const std::exception& exc) {
+        cerr << exc.what() << "\nUSAGE: client_sim [-c clients] [-r rate] [-n count] "
+             << "[-s size] [-q qos] [-i interval] [address]" << endl;
+        return 2;
+    }
+
+    cout << "Server:    " << address << "\nClients:   " << nClients
+         << "\nRamp:      " << connRate << " connections/sec\nMessages:  " << nMsg
+         << " each, every " << intervalMs << "ms\nPayload:   " << msgSz << " bytes"
+         << "\nQoS:       " << qos << endl;
+
+    try {
+        // No persistence, and nothing that gives each client its own
+        // thread, to keep the clients light.
+        auto createOpts = mqtt::create_options_builder()
+                              .server_uri(address)
+                              .client_id(CLIENT_ID_PREFIX)
+                              .finalize();
+
+        cout << "\nCreating the clients..." << flush;
+        auto start = steady_clock::now();
+        mqtt::client_pool pool{createOpts, nClients};
+        cout << "OK (" << msec(steady_clock::now() - start) << "ms)" << endl;
+
+        auto connOpts = mqtt::connect_options_builder()
+                            .clean_session()
+                            .keep_alive_interval(seconds(60))
+                            .finalize();
+
+        cout << "Connecting..." << flush;
+        start = steady_clock::now();
+        auto connTok = pool.connect(connOpts, connRate);
+        if (!connTok->wait_for(CONNECT_TIMEOUT)) {
+            cerr << "\nTimed out connecting the clients" << endl;
+            return 1;
+        }
+        auto connMs = msec(steady_clock::now() - start);
+        cout << "OK (" << connMs << "ms, " << rate(nClients, connMs) << " connections/sec)"
+             << endl;
+
+        // Each round, every client publishes one message to its own topic
+        mqtt::binary payload(msgSz, 'x');
+        vector<mqtt::delivery_token_ptr> toks;
+        toks.reserve(nClients * size_t(std::max(nMsg, 0)));
+
+        cout << "Publishing..." << flush;
+        start = steady_clock::now();
+        auto next = start;
+
+        for (int i = 0; i < nMsg; ++i) {
+            for (size_t j = 0; j < pool.size(); ++j) {
+                auto& cli = pool.get_client(j);
+                auto topic = TOPIC + "/" + to_string(j);
+                toks.push_back(cli.publish(mqtt::make_message(topic, payload, qos, false)));
+            }
+            next += milliseconds(intervalMs);
+            this_thread::sleep_until(next);
+        }
+
+        mqtt::wait_all(toks);
+        auto pubMs = msec(steady_clock::now() - start);
+        cout << "OK" << endl;
+
+        auto stats = pool.get_stats();
+        cout << "\nPublished " << stats.msgsPublished << " messages, " << stats.bytesPublished
+             << " bytes, in " << pubMs << "ms\n  " << rate(stats.msgsPublished, pubMs)
+             << " msg/sec, " << rate(stats.bytesPublished, pubMs) << " bytes/sec\n  "
+             << stats.publishErrors << " errors" << endl;
+
+        cout << "\nDisconnecting..." << flush;
+        pool.disconnect()->wait();
+        cout << "OK" << endl;
+    }
+    catch (const mqtt::exception& exc) {
+        cerr << "\n" << exc << endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -1,10 +1,27 @@
 // pub_speed_test.cpp
 //
-// Paho C++ sample client application to do a simple test of the speed at
-// which messages can be published.
+// Paho C++ sample client application to test the speed at which messages
+// can be published, and optionally, the latency for them to get back to a
+// subscriber.
 //
+// USAGE:
+//     pub_speed_test [options] [address [n_msg [msg_size [qos]]]]
+//
+// OPTIONS:
+//     -n <count>  The number of messages for each publisher (1000)
+//     -s <size>   The size of each payload, in bytes (1024)
+//     -q <qos>    The QoS, or a list of them to cycle through, like "0,1,2"
+//     -t <count>  The number of publishers, each with its own connection (1)
+//     -l          Measure the end-to-end latency with an echo subscriber
+//
+// In latency mode a separate client subscribes to the test topics, and each
+// message carries the time that it was published in the first eight bytes
+// of its payload. The subscriber records the time for each message to
+// arrive in a histogram, and prints the percentiles at the end.
+//
+
 /*******************************************************************************
- * Copyright (c) 2013-2023 Frank Pagliughi <fpagliughi@mindspring.com>
+ * Copyright (c) 2013-2025 Frank Pagliughi <fpagliughi@mindspring.com>
  *
  * All rights reserved. This program and the accompanying materials
  * are made available under the terms of the Eclipse Public License v2.0
@@ -19,17 +36,23 @@
  *    Frank Pagliughi - initial implementation and documentation
  *******************************************************************************/
 
+#include <algorithm>
 #include <atomic>
 #include <chrono>
+#include <cmath>
+#include <condition_variable>
 #include <cstdlib>
 #include <cstring>
 #include <future>
+#include <iomanip>
 #include <iostream>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <thread>
+#include <vector>
 
 #include "mqtt/async_client.h"
-#include "mqtt/thread_queue.h"
 
 using namespace std;
 using namespace std::chrono;
@@ -43,8 +66,11 @@ const string TOPIC{"test/speed"};
 
 const char* LWT_PAYLOAD = "pub_speed_test died unexpectedly.";
 
-// Queue for passing tokens to the wait thread
-mqtt::thread_queue<mqtt::delivery_token_ptr> que;
+// The bytes at the front of the payload that hold the publish time
+const size_t TIMESTAMP_SIZE = sizeof(int64_t);
+
+// How long the subscriber waits for stragglers after publishing is done
+const auto RECV_TIMEOUT = seconds(10);
 
 // Get the current time on the steady clock
 steady_clock::time_point now() { return steady_clock::now(); }
@@ -56,31 +82,134 @@ int64_t msec(const std::chrono::duration<Rep, Period>& dur)
     return (int64_t)duration_cast<milliseconds>(dur).count();
 }
 
+// Gets a rate in k msg/sec, without dividing by zero for a fast run
+int64_t krate(int64_t n, int64_t ms) { return n / std::max<int64_t>(ms, 1); }
+
 // --------------------------------------------------------------------------
-// Thread function will wait for all the tokens to complete.
-// Any exceptions thrown from here will be caught in main().
+// A histogram of latencies, in microseconds.
+//
+// Like HdrHistogram, the buckets are linear within each power of two, with
+// 64 sub-buckets for each, so that any value is reported to within about
+// 1.5%, with a fixed amount of memory and no allocations to record.
 
-void token_wait_func()
+class latency_histogram
 {
-    while (true) {
-        mqtt::delivery_token_ptr tok = que.get();
-        if (!tok)
-            break;
-        // cout.put('x');
-        tok->wait();
+    static constexpr int SUB_BITS = 6;
+    static constexpr int64_t SUB_COUNT = int64_t(1) << SUB_BITS;
+    static constexpr int N_BUCKETS = 64 - SUB_BITS;
+
+    vector<uint64_t> counts_;
+    uint64_t total_{0};
+    int64_t max_{0};
+
+    // Values below 2 * SUB_COUNT go in the first bucket, one to a slot.
+    static size_t index_of(int64_t val) {
+        int bucket = 0;
+        while ((val >> bucket) >= 2 * SUB_COUNT) ++bucket;
+        auto sub = (val >> bucket) - ((bucket == 0) ? 0 : SUB_COUNT);
+        return size_t(bucket * SUB_COUNT + sub + ((bucket == 0) ? 0 : SUB_COUNT));
     }
-}
+
+    // The highest value that lands in the slot
+    static int64_t value_of(size_t idx) {
+        if (idx < size_t(2 * SUB_COUNT))
+            return int64_t(idx);
+        auto bucket = int64_t(idx / SUB_COUNT) - 1;
+        auto sub = int64_t(idx % SUB_COUNT) + SUB_COUNT;
+        return ((sub + 1) << bucket) - 1;
+    }
+
+public:
+    latency_histogram() : counts_((N_BUCKETS + 1) * SUB_COUNT, 0) {}
+
+    void record(int64_t us) {
+        us = std::max<int64_t>(us, 0);
+        ++counts_[index_of(us)];
+        ++total_;
+        max_ = std::max(max_, us);
+    }
+
+    uint64_t count() const { return total_; }
+    int64_t max() const { return max_; }
+
+    // Gets the value at or below which the percentage of samples fall
+    int64_t percentile(double pct) const {
+        if (total_ == 0)
+            return 0;
+        auto target = uint64_t(std::ceil(total_ * pct / 100.0));
+        target = std::max<uint64_t>(target, 1);
+        uint64_t n = 0;
+        for (size_t i = 0; i < counts_.size(); ++i) {
+            n += counts_[i];
+            if (n >= target)
+                return std::min(value_of(i), max_);
+        }
+        return max_;
+    }
+};
 
 // --------------------------------------------------------------------------
+// The subscriber for latency mode.
+// It reads the publish time from each message as it arrives.
 
-int main(int argc, char* argv[])
+class echo_subscriber
 {
-    string address = (argc > 1) ? string(argv[1]) : DFLT_SERVER_ADDRESS;
-    int nMsg = (argc > 2) ? atoi(argv[2]) : DFLT_N_MSG;
-    size_t msgSz = (size_t)((argc > 3) ? atol(argv[3]) : DFLT_PAYLOAD_SIZE);
-    int qos = (argc > 4) ? atoi(argv[4]) : DFLT_QOS;
+    mqtt::async_client cli_;
+    latency_histogram hist_;
+    mutex lock_;
+    condition_variable cv_;
+    size_t nRecv_{0};
+
+public:
+    explicit echo_subscriber(const string& address) : cli_(address, "") {
+        cli_.set_message_callback([this](mqtt::const_message_ptr msg) {
+            const auto& payload = msg->get_payload_ref();
+            if (payload.size() < TIMESTAMP_SIZE)
+                return;
+
+            int64_t t;
+            memcpy(&t, payload.data(), TIMESTAMP_SIZE);
+            auto lat = now().time_since_epoch() - steady_clock::duration(t);
+
+            lock_guard<mutex> lk{lock_};
+            hist_.record(duration_cast<microseconds>(lat).count());
+            ++nRecv_;
+            cv_.notify_all();
+        });
+    }
+
+    void start(int qos) {
+        auto connOpts = mqtt::connect_options_builder().clean_session().finalize();
+        cli_.connect(connOpts)->wait();
+        cli_.subscribe(TOPIC + "/#", qos)->wait();
+    }
+
+    // Waits for the messages to arrive, or a timeout
+    size_t wait_for(size_t n, steady_clock::duration timeout) {
+        unique_lock<mutex> lk{lock_};
+        cv_.wait_for(lk, timeout, [this, n] { return nRecv_ >= n; });
+        return nRecv_;
+    }
+
+    void stop() { cli_.disconnect()->wait(); }
 
-    cout << "Initializing for server '" << address << "'..." << flush;
+    const latency_histogram& histogram() const { return hist_; }
+};
+
+// --------------------------------------------------------------------------
+// A publisher, with its own connection and a thread to wait for the tokens
+// to complete.
+// Any exceptions thrown from here will be caught in main().
+
+struct pub_results
+{
+    steady_clock::duration pubTime, ackTime;
+};
+
+pub_results publisher_func(
+    string address, int id, int nMsg, size_t msgSz, vector<int> qosList, bool latency
+)
+{
     mqtt::async_client cli(address, "");
 
     mqtt::message willmsg(TOPIC, LWT_PAYLOAD, 1, true);
@@ -90,58 +219,192 @@ int main(int argc, char* argv[])
     connOpts.set_clean_session(true);
     connOpts.set_will(will);
 
+    cli.connect(connOpts)->wait();
+
+    vector<mqtt::delivery_token_ptr> toks;
+    toks.reserve(size_t(nMsg));
+
     // Create a payload
     mqtt::binary payload;
     for (size_t i = 0; i < msgSz; ++i) payload.push_back('a' + i % 26);
 
-    cout << "OK" << endl;
+    const string topic = TOPIC + "/" + to_string(id);
+    auto start = now();
+
+    for (int i = 0; i < nMsg; ++i) {
+        int qos = qosList[size_t(i) % qosList.size()];
+
+        // The timestamp has to be fresh, so the message is made here.
+        if (latency) {
+            int64_t t = now().time_since_epoch().count();
+            memcpy(&payload[0], &t, TIMESTAMP_SIZE);
+        }
+
+        auto msg = mqtt::make_message(topic, payload, qos, false);
+        toks.push_back(cli.publish(msg));
+    }
+
+    auto pubend = now();
+
+    // Wait for all the tokens to complete, with a single wakeup
+    mqtt::wait_all(toks);
+    auto end = now();
+
+    cli.disconnect(seconds(10))->wait();
+    return pub_results{pubend - start, end - start};
+}
+
+// --------------------------------------------------------------------------
+
+// Parses a list of QoS values like "0,1,2"
+vector<int> parse_qos(const string& s)
+{
+    vector<int> qosList;
+    size_t pos = 0;
+    while (pos <= s.size()) {
+        auto comma = s.find(',', pos);
+        if (comma == string::npos)
+            comma = s.size();
+        int qos = atoi(s.substr(pos, comma - pos).c_str());
+        if (qos < 0 || qos > 2)
+            throw std::invalid_argument("QoS must be 0, 1, or 2");
+        qosList.push_back(qos);
+        pos = comma + 1;
+    }
+    return qosList;
+}
+
+int main(int argc, char* argv[])
+{
+    string address = DFLT_SERVER_ADDRESS;
+    int nMsg = DFLT_N_MSG, nPub = 1;
+    size_t msgSz = DFLT_PAYLOAD_SIZE;
+    vector<int> qosList{DFLT_QOS};
+    bool latency = false;
 
     try {
-        // Create the message (move payload into it)
-        auto msg = mqtt::make_message(TOPIC, std::move(payload), qos, false);
+        int npos = 0;
+        for (int i = 1; i < argc; ++i) {
+            string arg{argv[i]};
 
-        // Connect to the broker
-        cout << "\nConnecting..." << flush;
-        auto start = now();
-        cli.connect(connOpts)->wait();
-        auto end = now();
-        cout << "OK" << endl;
+            if (arg == "-l") {
+                latency = true;
+            }
+            else if (arg.size() == 2 && arg[0] == '-') {
+                if (++i == argc)
+                    throw std::invalid_argument("Missing value for " + arg);
+                string val{argv[i]};
+
+                switch (arg[1]) {
+                    case 'n':
+                        nMsg = atoi(val.c_str());
+                        break;
+                    case 's':
+                        msgSz = (size_t)atol(val.c_str());
+                        break;
+                    case 'q':
+                        qosList = parse_qos(val);
+                        break;
+                    case 't':
+                        nPub = std::max(atoi(val.c_str()), 1);
+                        break;
+                    default:
+                        throw std::invalid_argument("Unknown option " + arg);
+                }
+            }
+            else {
+                // The original positional arguments
+                switch (npos++) {
+                    case 0:
+                        address = arg;
+                        break;
+                    case 1:
+                        nMsg = atoi(arg.c_str());
+                        break;
+                    case 2:
+                        msgSz = (size_t)atol(arg.c_str());
+                        break;
+                    case 3:
+                        qosList = parse_qos(arg);
+                        break;
+                    default:
+                        throw std::invalid_argument("Too many arguments");
+                }
+            }
+        }
+    }
+    catch (const std::exception& exc) {
+        cerr << exc.what() << "\nUSAGE: pub_speed_test [-n count] [-s size] [-q qos[,qos...]] "
+             << "[-t publishers] [-l] [address [n_msg [msg_size [qos]]]]" << endl;
+        return 2;
+    }
+
+    if (latency)
+        msgSz = std::max(msgSz, TIMESTAMP_SIZE);
 
-        cout << "Connected in " << msec(end - start) << "ms" << endl;
+    cout << "Server:     " << address << "\nPublishers: " << nPub
+         << "\nMessages:   " << nMsg << " each\nPayload:    " << msgSz << " bytes\nQoS:        ";
+    for (size_t i = 0; i < qosList.size(); ++i) cout << (i ? "," : "") << qosList[i];
+    cout << endl;
 
-        auto fut = std::async(launch::async, token_wait_func);
+    try {
+        unique_ptr<echo_subscriber> sub;
 
-        // Publish the messages
-        cout << "\nPublishing " << nMsg << " messages..." << flush;
-        start = now();
-        for (int i = 0; i < nMsg; ++i) {
-            auto dtok = cli.publish(msg);
-            // cout.put('^');
-            que.put(std::move(dtok));
+        if (latency) {
+            cout << "\nStarting the echo subscriber..." << flush;
+            sub = std::make_unique<echo_subscriber>(address);
+            sub->start(*std::max_element(qosList.begin(), qosList.end()));
+            cout << "OK" << endl;
         }
-        auto pubend = now();
-        que.put(mqtt::delivery_token_ptr());
 
-        // Wait for all the tokens to complete
-        fut.get();
-        end = now();
+        // Connect and publish from each publisher at once
+        cout << "\nPublishing " << (int64_t(nPub) * nMsg) << " messages..." << flush;
+        auto start = now();
+
+        vector<future<pub_results>> futs;
+        for (int i = 0; i < nPub; ++i) {
+            futs.push_back(std::async(
+                launch::async, publisher_func, address, i, nMsg, msgSz, qosList, latency
+            ));
+        }
+
+        vector<pub_results> results;
+        for (auto& fut : futs) results.push_back(fut.get());
+        auto end = now();
 
         cout << "OK" << endl;
-        auto ms = msec(pubend - start);
-        cout << "Published in    " << ms << "ms " << (nMsg / ms) << "k msg/sec" << endl;
+
+        int64_t nTotal = int64_t(nPub) * nMsg;
+        for (size_t i = 0; i < results.size() && nPub > 1; ++i) {
+            auto ms = msec(results[i].ackTime);
+            cout << "  Publisher " << i << ": " << ms << "ms " << krate(nMsg, ms)
+                 << "k msg/sec" << endl;
+        }
+
+        auto slowest = std::max_element(
+            results.begin(), results.end(),
+            [](const pub_results& a, const pub_results& b) { return a.pubTime < b.pubTime; }
+        );
+        auto ms = msec(slowest->pubTime);
+        cout << "Published in    " << ms << "ms " << krate(nTotal, ms) << "k msg/sec" << endl;
         ms = msec(end - start);
-        cout << "Acknowledged in " << ms << "ms " << (nMsg / ms) << "k msg/sec" << endl;
+        cout << "Acknowledged in " << ms << "ms " << krate(nTotal, ms) << "k msg/sec" << endl;
 
-        // Disconnect
-        cout << "\nDisconnecting..." << flush;
-        start = now();
-        cli.disconnect(seconds(10))->wait();
-        end = now();
-        cout << "OK" << endl;
-        cout << "Disconnected in " << msec(end - start) << "ms" << endl;
+        if (sub) {
+            auto nRecv = sub->wait_for(size_t(nTotal), RECV_TIMEOUT);
+            sub->stop();
+
+            const auto& hist = sub->histogram();
+            cout << "\nReceived " << nRecv << " of " << nTotal << " messages" << endl;
+            cout << "Latency (us):\n"
+                 << "  p50:    " << setw(10) << hist.percentile(50.0) << "\n"
+                 << "  p90:    " << setw(10) << hist.percentile(90.0) << "\n"
+                 << "  p99:    " << setw(10) << hist.percentile(99.0) << "\n"
+                 << "  p99.9:  " << setw(10) << hist.percentile(99.9) << "\n"
+                 << "  max:    " << setw(10) << hist.max() << endl;
+        }
     }
     catch (const mqtt::exception& exc) {
-        que.put(mqtt::delivery_token_ptr{});
         cerr << exc.what() << endl;
         return 1;
     }
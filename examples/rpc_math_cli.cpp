@@ -40,7 +40,7 @@
 #include <thread>
 
 #include "mqtt/async_client.h"
-#include "mqtt/properties.h"
+#include "mqtt/rpc_client.h"
 
 using namespace std;
 using namespace std::chrono;
@@ -63,8 +63,6 @@ int main(int argc, char* argv[])
     // Create a client
     mqtt::async_client cli(SERVER_ADDRESS, "");
 
-    cli.start_consuming();
-
     try {
         cout << "Connecting..." << flush;
         auto connOpts = mqtt::connect_options::v5();
@@ -86,9 +84,13 @@ int main(int argc, char* argv[])
         string repTopic = "replies/" + clientId + "/math";
         cout << "    Reply topic: " << repTopic << endl;
 
+        // The RPC client matches the replies on that topic to the
+        // requests, with the correlation data that it puts into them.
         // Subscribe to the reply topic and verify the QoS
 
-        tok = cli.subscribe(repTopic, QOS);
+        mqtt::rpc_client rpc(cli, repTopic, QOS);
+
+        tok = rpc.subscribe();
         tok->wait();
 
         if (int(tok->get_reason_code()) != QOS) {
@@ -101,11 +103,6 @@ int main(int argc, char* argv[])
 
         string req{argv[1]}, reqTopic{REQ_TOPIC_HDR + req};
 
-        mqtt::properties props{
-            {mqtt::property::RESPONSE_TOPIC, repTopic},
-            {mqtt::property::CORRELATION_DATA, "1"}
-        };
-
         ostringstream os;
         os << "[ ";
         for (int i = 2; i < argc - 1; ++i) os << argv[i] << ", ";
@@ -114,26 +111,20 @@ int main(int argc, char* argv[])
         string reqArgs{os.str()};
 
         cout << "\nSending '" << req << "' request " << os.str() << "..." << flush;
-        auto pubmsg = mqtt::message_ptr_builder()
-                          .topic(reqTopic)
-                          .payload(reqArgs)
-                          .qos(QOS)
-                          .properties(props)
-                          .finalize();
-
-        cli.publish(pubmsg)->wait_for(TIMEOUT);
+        auto fut = rpc.call(reqTopic, reqArgs, TIMEOUT);
         cout << "OK" << endl;
 
         // Wait for reply.
 
-        auto msg = cli.try_consume_message_for(seconds(5));
-        if (!msg) {
+        try {
+            auto msg = fut.get();
+            cout << "  Result: " << msg->to_string() << endl;
+        }
+        catch (const mqtt::timeout_error&) {
             cerr << "Didn't receive a reply from the service." << endl;
             return 1;
         }
 
-        cout << "  Result: " << msg->to_string() << endl;
-
         // Unsubscribe
 
         cli.unsubscribe(repTopic)->wait();
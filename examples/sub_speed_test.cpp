@@ -0,0 +1,293 @@
+// sub_speed_test.cpp
+//
+// Paho C++ sample client application to test the speed at which messages
+// can be received, comparing the different ways that an application can
+// consume them.
+//
+// USAGE:
+//     sub_speed_test [options] [address]
+//
+// OPTIONS:
+//     -m <mode>   The delivery mode: queue, handler, callback, or all (all)
+//     -n <count>  The number of messages to send for each mode (10000)
+//     -s <size>   The size of each payload, in bytes (64)
+//     -q <qos>    The QoS for the messages and subscription (0)
+//
+// For each mode, the app connects a subscriber and a publisher to the
+// broker. The publisher sends the messages as fast as it can, with the time
+// that each was published in the front of its payload. The subscriber
+// counts them as they're consumed, and records how long each took to
+// arrive. The modes are:
+//
+//     queue     start_consuming() with a thread calling consume_message()
+//     handler   set_message_callback()
+//     callback  a callback object with message_arrived()
+//
+// The handler and callback modes are run on the library's thread as each
+// message arrives, so the latency in the queue mode over the others is the
+// time that the messages sit in the consumer queue.
+//
+
+/*******************************************************************************
+ * Copyright (c) 2025 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "mqtt/async_client.h"
+
+using namespace std;
+using namespace std::chrono;
+
+const std::string DFLT_SERVER_ADDRESS{"mqtt://localhost:1883"};
+
+const size_t DFLT_PAYLOAD_SIZE = 64;
+const int DFLT_N_MSG = 10000, DFLT_QOS = 0;
+
+const string TOPIC{"test/sub_speed/"};
+
+// The bytes at the front of the payload that hold the publish time
+const size_t TIMESTAMP_SIZE = sizeof(int64_t);
+
+// How long to wait for the messages after publishing is done
+const auto RECV_TIMEOUT = seconds(10);
+
+// Get the current time on the steady clock
+steady_clock::time_point now() { return steady_clock::now(); }
+
+// Convert a duration to a count of milliseconds
+template <class Rep, class Period>
+int64_t msec(const std::chrono::duration<Rep, Period>& dur)
+{
+    return (int64_t)duration_cast<milliseconds>(dur).count();
+}
+
+// --------------------------------------------------------------------------
+// The statistics for the messages received in one mode.
+// Only one thread at a time records a message, but the main thread waits
+// on the count.
+
+class receive_stats
+{
+    mutex lock_;
+    condition_variable cv_;
+    size_t nRecv_{0};
+    steady_clock::time_point first_, last_;
+    // The latencies, in microseconds
+    vector<int64_t> lat_;
+
+public:
+    explicit receive_stats(size_t n) { lat_.reserve(n); }
+
+    void record(const mqtt::const_message_ptr& msg) {
+        auto t = now();
+        const auto& payload = msg->get_payload_ref();
+
+        lock_guard<mutex> lk{lock_};
+        if (nRecv_++ == 0)
+            first_ = t;
+        last_ = t;
+
+        if (payload.size() >= TIMESTAMP_SIZE) {
+            int64_t ts;
+            memcpy(&ts, payload.data(), TIMESTAMP_SIZE);
+            auto lat = t.time_since_epoch() - steady_clock::duration(ts);
+            lat_.push_back(duration_cast<microseconds>(lat).count());
+        }
+        cv_.notify_all();
+    }
+
+    // Waits for the messages to arrive, or a timeout
+    size_t wait_for(size_t n, steady_clock::duration timeout) {
+        unique_lock<mutex> lk{lock_};
+        cv_.wait_for(lk, timeout, [this, n] { return nRecv_ >= n; });
+        return nRecv_;
+    }
+
+    void print(ostream& os) {
+        lock_guard<mutex> lk{lock_};
+        auto us = duration_cast<microseconds>(last_ - first_).count();
+        auto rate = (us > 0) ? int64_t(nRecv_ * 1000000.0 / us) : int64_t(0);
+        os << "  Received " << nRecv_ << " in " << (us / 1000) << "ms, " << rate << " msg/sec"
+           << endl;
+
+        if (lat_.empty())
+            return;
+
+        sort(lat_.begin(), lat_.end());
+        auto pct = [this](double p) {
+            auto i = size_t(p / 100.0 * (lat_.size() - 1));
+            return lat_[i];
+        };
+
+        os << "  Latency (us): p50 " << pct(50.0) << ", p99 " << pct(99.0) << ", p99.9 "
+           << pct(99.9) << ", max " << lat_.back() << endl;
+    }
+};
+
+// --------------------------------------------------------------------------
+// The callback object for the 'callback' mode.
+
+class stats_callback : public virtual mqtt::callback
+{
+    receive_stats& stats_;
+
+    void message_arrived(mqtt::const_message_ptr msg) override { stats_.record(msg); }
+
+public:
+    explicit stats_callback(receive_stats& stats) : stats_(stats) {}
+};
+
+// --------------------------------------------------------------------------
+// Runs the test for one delivery mode.
+
+void run_test(const string& address, const string& mode, int nMsg, size_t msgSz, int qos)
+{
+    const string topic = TOPIC + mode;
+    receive_stats stats{size_t(nMsg)};
+
+    mqtt::async_client sub(address, "");
+    stats_callback cb(stats);
+    thread consumer;
+
+    if (mode == "queue")
+        sub.start_consuming();
+    else if (mode == "handler")
+        sub.set_message_callback([&stats](mqtt::const_message_ptr msg) { stats.record(msg); });
+    else
+        sub.set_callback(cb);
+
+    auto connOpts = mqtt::connect_options_builder().clean_session().finalize();
+    sub.connect(connOpts)->wait();
+    sub.subscribe(topic, qos)->wait();
+
+    size_t maxDepth = 0;
+
+    if (mode == "queue") {
+        consumer = thread([&sub, &stats, &maxDepth] {
+            while (true) {
+                maxDepth = std::max(maxDepth, sub.consumer_queue_size());
+                auto msg = sub.consume_message();
+                if (!msg)
+                    break;
+                stats.record(msg);
+            }
+        });
+    }
+
+    // Blast out the messages
+    mqtt::async_client pub(address, "");
+    pub.connect(connOpts)->wait();
+
+    mqtt::binary payload;
+    for (size_t i = 0; i < msgSz; ++i) payload.push_back('a' + i % 26);
+
+    mqtt::delivery_token_ptr tok;
+    for (int i = 0; i < nMsg; ++i) {
+        int64_t t = now().time_since_epoch().count();
+        memcpy(&payload[0], &t, TIMESTAMP_SIZE);
+        tok = pub.publish(mqtt::make_message(topic, payload, qos, false));
+    }
+    if (tok)
+        tok->wait();
+
+    stats.wait_for(size_t(nMsg), RECV_TIMEOUT);
+
+    pub.disconnect()->wait();
+    sub.disconnect()->wait();
+
+    if (consumer.joinable()) {
+        // Closing the queue wakes the consumer to exit
+        sub.stop_consuming();
+        consumer.join();
+    }
+
+    cout << "\n" << mode << ":" << endl;
+    stats.print(cout);
+    if (mode == "queue")
+        cout << "  Max queue depth: " << maxDepth << endl;
+}
+
+// --------------------------------------------------------------------------
+
+int main(int argc, char* argv[])
+{
+    string address = DFLT_SERVER_ADDRESS;
+    string mode{"all"};
+    int nMsg = DFLT_N_MSG, qos = DFLT_QOS;
+    size_t msgSz = DFLT_PAYLOAD_SIZE;
+
+    for (int i = 1; i < argc; ++i) {
+        string arg{argv[i]};
+
+        if (arg.size() == 2 && arg[0] == '-' && i + 1 < argc) {
+            string val{argv[++i]};
+            switch (arg[1]) {
+                case 'm':
+                    mode = val;
+                    break;
+                case 'n':
+                    nMsg = atoi(val.c_str());
+                    break;
+                case 's':
+                    msgSz = (size_t)atol(val.c_str());
+                    break;
+                case 'q':
+                    qos = atoi(val.c_str());
+                    break;
+                default:
+                    cerr << "Unknown option " << arg << endl;
+                    return 2;
+            }
+        }
+        else {
+            address = arg;
+        }
+    }
+
+    vector<string> modes;
+    if (mode == "all")
+        modes = {"queue", "handler", "callback"};
+    else if (mode == "queue" || mode == "handler" || mode == "callback")
+        modes = {mode};
+    else {
+        cerr << "Unknown mode '" << mode << "'" << endl;
+        return 2;
+    }
+
+    msgSz = std::max(msgSz, TIMESTAMP_SIZE);
+
+    cout << "Server:   " << address << "\nMessages: " << nMsg << "\nPayload:  " << msgSz
+         << " bytes\nQoS:      " << qos << endl;
+
+    try {
+        for (const auto& m : modes) run_test(address, m, nMsg, msgSz, qos);
+    }
+    catch (const mqtt::exception& exc) {
+        cerr << exc.what() << endl;
+        return 1;
+    }
+
+    return 0;
+}
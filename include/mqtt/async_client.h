@@ -34,29 +34,67 @@
 #ifndef __mqtt_async_client_h
 #define __mqtt_async_client_h
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
 #include <functional>
 #include <list>
+#include <map>
 #include <memory>
+#include <mutex>
+#include <new>
 #include <stdexcept>
+#include <thread>
 #include <tuple>
+#include <unordered_map>
 #include <vector>
 
 #include "MQTTAsync.h"
+#include "mqtt/batch_token.h"
+#include "mqtt/bulk_subscribe_token.h"
 #include "mqtt/callback.h"
+#include "mqtt/callback_timing.h"
+#include "mqtt/client_stats.h"
+#include "mqtt/concurrent_topic_matcher.h"
+#include "mqtt/consumer_options.h"
+#include "mqtt/consumer_queue.h"
 #include "mqtt/create_options.h"
+#include "mqtt/credential_provider.h"
 #include "mqtt/delivery_token.h"
 #include "mqtt/event.h"
 #include "mqtt/exception.h"
 #include "mqtt/iaction_listener.h"
 #include "mqtt/iasync_client.h"
 #include "mqtt/iclient_persistence.h"
+#include "mqtt/memory_budget.h"
 #include "mqtt/message.h"
+#include "mqtt/message_dispatcher.h"
+#include "mqtt/message_pool.h"
+#include "mqtt/message_template.h"
+#include "mqtt/message_trace.h"
+#include "mqtt/offline_buffer.h"
+#include "mqtt/payload_codec.h"
+#include "mqtt/platform.h"
 #include "mqtt/properties.h"
+#include "mqtt/publish_shaper.h"
+#include "mqtt/publish_window.h"
+#include "mqtt/rcu_ptr.h"
+#include "mqtt/response_options.h"
+#include "mqtt/retained_cache.h"
 #include "mqtt/string_collection.h"
+#include "mqtt/string_intern.h"
 #include "mqtt/thread_queue.h"
+#include "mqtt/timer_wheel.h"
 #include "mqtt/token.h"
+#include "mqtt/token_wait.h"
+#include "mqtt/topic_alias_map.h"
 #include "mqtt/types.h"
 
+#if defined(PAHO_MQTTPP_COROUTINES)
+    #include <coroutine>
+#endif
+
 namespace mqtt {
 
 // OBSOLETE: The legacy constants that lacked the "PAHO_MQTTPP_" prefix
@@ -136,19 +174,34 @@ const string COPYRIGHT("Copyright (c) 2013-2025 Frank Pagliughi");
 class async_client : public virtual iasync_client
 {
 public:
+    /**
+     * The packet size limit for a bulk subscribe, when the server doesn't
+     * report a maximum.
+     */
+    static constexpr size_t DFLT_MAX_PACKET_SIZE = 256 * 1024;
+    /** The most filters sent in one packet by a bulk subscribe */
+    static constexpr size_t MAX_BULK_FILTERS = 1024;
     /** Smart/shared pointer for an object of this class */
     using ptr_t = std::shared_ptr<async_client>;
     /** Type for a thread-safe queue to consume events synchronously */
-    using consumer_queue_type = std::unique_ptr<thread_queue<event>>;
+    using consumer_queue_type = std::unique_ptr<iconsumer_queue>;
 
     /** Handler type for registering an individual message callback */
     using message_handler = std::function<void(const_message_ptr)>;
+    /** A table of message handlers, by topic filter */
+    using message_handler_table = topic_matcher<message_handler>;
+    /** A read-only snapshot of the message handlers for the topic filters */
+    using message_handler_snapshot = std::shared_ptr<const message_handler_table>;
     /** Handler type for when a connection is made or lost */
     using connection_handler = std::function<void(const string& cause)>;
     /** Handler type for when a disconnect packet is received */
     using disconnected_handler = std::function<void(const properties&, ReasonCode)>;
     /** Handler for updating connection data before an auto-reconnect. */
     using update_connection_handler = std::function<bool(connect_data&)>;
+    /** Handler type to receive an event asynchronously from the consumer */
+    using consume_event_handler = std::function<void(event)>;
+    /** Handler type to receive a message asynchronously from the consumer */
+    using consume_message_handler = std::function<void(const_message_ptr)>;
 
 private:
     /** Lock guard type for this class */
@@ -158,6 +211,14 @@ private:
 
     /** Object monitor mutex */
     mutable std::mutex lock_;
+    /** Lock for the pending (non-delivery) tokens */
+    mutable std::mutex tokLock_;
+    /** Lock for the pending delivery tokens */
+    mutable std::mutex deliveryTokLock_;
+    /** Lock for the delivery completions waiting to be passed to the user */
+    std::mutex complLock_;
+    /** The delivery completions waiting to be passed to the user */
+    std::vector<delivery_token_ptr> complToks_;
     /** The underlying C-lib client. */
     MQTTAsync cli_;
     /** The options used to create the client */
@@ -167,27 +228,277 @@ private:
     /** A user persistence wrapper (if any) */
     std::unique_ptr<MQTTClient_persistence> persist_{};
     /** Callback supplied by the user (if any) */
-    callback* userCallback_{};
+    std::atomic<callback*> userCallback_{nullptr};
     /** Connection handler */
-    connection_handler connHandler_;
+    rcu_ptr<connection_handler> connHandler_;
     /** Connection lost handler */
-    connection_handler connLostHandler_;
+    rcu_ptr<connection_handler> connLostHandler_;
     /** Disconnected handler */
-    disconnected_handler disconnectedHandler_;
+    rcu_ptr<disconnected_handler> disconnectedHandler_;
     /** Update connect data/options */
-    update_connection_handler updateConnectionHandler_;
+    rcu_ptr<update_connection_handler> updateConnectionHandler_;
+    /** Supplies the credentials for each connection attempt */
+    rcu_ptr<credential_provider> credProvider_;
     /** Message handler */
-    message_handler msgHandler_;
+    rcu_ptr<message_handler> msgHandler_;
+    /** Message handlers for specific topic filters */
+    concurrent_topic_matcher<message_handler> filterHandlers_;
+    /** Whether any filter handlers were ever added */
+    std::atomic<bool> hasFilterHandlers_{false};
+    /** Executor to run the user callbacks (if any) */
+    rcu_ptr<executor_type> executor_;
     /** Cached options from the last connect */
     connect_options connOpts_;
     /** Copy of connect token (for re-connects) */
     token_ptr connTok_;
-    /** A list of tokens that are in play */
-    std::list<token_ptr> pendingTokens_;
-    /** A list of delivery tokens that are in play */
-    std::list<delivery_token_ptr> pendingDeliveryTokens_;
+    /** The tokens that are in play, keyed by address */
+    std::unordered_map<const token*, token_ptr> pendingTokens_;
+    /** The account of the memory held for messages, with any limit */
+    std::unique_ptr<memory_budget> memBudget_;
+    /** The bytes held by the messages pending delivery */
+    std::atomic<size_t> pendingBytes_{0};
+    /** The delivery tokens that are in play, keyed by address */
+    std::unordered_map<const token*, delivery_token_ptr> pendingDeliveryTokens_;
+    /**
+     * The pending delivery tokens are also linked through the tokens, in
+     * the order they were added, so the oldest can be found right away.
+     */
+    delivery_token* oldestPending_{nullptr};
+    /** The most recent delivery token to be added */
+    delivery_token* newestPending_{nullptr};
+    /** The number of delivery tokens in play, readable without the lock */
+    std::atomic<size_t> nPendingDelivery_{0};
     /** A queue of messages for consumer API */
     consumer_queue_type que_;
+    /** The consumer queue, if its memory is counted */
+    metered_consumer_queue* meteredQue_{nullptr};
+    /** What to do with incoming messages when the queue is full */
+    std::atomic<overflow_policy> overflowPolicy_{overflow_policy::BLOCK};
+    /** Dispatcher to handle messages on a pool of threads */
+    message_dispatcher_ptr dispatcher_;
+    /** Optional pool for creating incoming messages */
+    message_pool_ptr msgPool_;
+    /** Optional pool for creating delivery tokens */
+    message_pool_ptr tokPool_;
+    /** Optional table to intern the topics of incoming messages */
+    string_intern_ptr topicTbl_;
+    /** Optional window to limit the messages pending delivery */
+    std::unique_ptr<publish_window> pubWindow_;
+    /** Lock for the topic aliases, held while a message is sent */
+    std::mutex aliasLock_;
+    /** Optional aliases for the topics that are published */
+    std::unique_ptr<topic_alias_map> topicAliases_;
+    /** Lock for the topic aliases sent by the server */
+    std::mutex inAliasLock_;
+    /** The topics for the aliases sent by the server, indexed by alias */
+    std::vector<string_ref> inAliases_;
+
+    /** A QoS 1 or 2 message held back by the server's receive maximum */
+    struct deferred_send
+    {
+        delivery_token_ptr tok;
+        trace_clock::time_point pubTime;
+    };
+
+    /** Whether to hold back messages past the server's receive maximum */
+    bool flowControl_{false};
+    /** Lock for the flow control of QoS 1 & 2 messages */
+    mutable std::mutex flowLock_;
+    /** The most QoS 1 & 2 messages that the server will take at once */
+    size_t recvMax_{65535};
+    /** The QoS 1 & 2 messages given to the C library and not yet done */
+    size_t nInFlight_{0};
+    /** The messages waiting to be sent, in the order they were published */
+    std::deque<deferred_send> deferred_;
+    /** Whether a thread is sending the deferred messages */
+    bool sendingDeferred_{false};
+
+    /** The thread that races the servers for connect_race() */
+    std::thread raceThread_;
+    /** Lock for cancelling the race */
+    std::mutex raceLock_;
+    /** Signaled as the race attempts complete, or it's cancelled */
+    std::condition_variable raceCond_;
+    /** Whether the race has been cancelled */
+    bool raceCancel_{false};
+    /** Whether a race is running, and hasn't yet made the real connect */
+    bool raceRunning_{false};
+
+    /** The thread that makes the reconnects with a backoff policy */
+    std::thread reconnThread_;
+    /** Lock for the reconnects made by the client */
+    std::mutex reconnLock_;
+    /** Signaled when a reconnect is needed, or called off */
+    std::condition_variable reconnCond_;
+    /** The backoff for reconnects made by the client, if any */
+    reconnect_backoff_ptr backoff_;
+    /** Whether the client should be reconnecting */
+    bool reconnPending_{false};
+    /** Whether the reconnect thread should exit */
+    bool reconnStop_{false};
+
+    /** The local cache of retained messages, if any */
+    retained_cache_ptr retainedCache_;
+    /** The rate limits for the outgoing messages, if any */
+    publish_shaper_ptr shaper_;
+    /** Lock for the tokens of the messages held by the shaper */
+    std::mutex shapedLock_;
+    /** The token for the message held by the shaper, by topic */
+    std::map<string, delivery_token_ptr> shapedToks_;
+    /** The filter for duplicate incoming messages, if any */
+    dedup_filter_ptr dedupFilter_;
+    /** The tracker for the sequence numbers of incoming messages, if any */
+    sequence_tracker_ptr seqTracker_;
+    /** The traffic counters for a set of topic filters, if any */
+    topic_stats_ptr topicStats_;
+    /** The sampler for the incoming messages, if any */
+    message_sampler_ptr sampler_;
+    /** The reassembler for chunked transfers, if any */
+    chunk_reassembler_ptr reassembler_;
+    /** A subscription, tracked to restore it after a reconnect */
+    struct tracked_subscription
+    {
+        int qos;
+        subscribe_options opts;
+    };
+
+    /** Whether to restore the subscriptions when a session is lost */
+    bool restoreSubs_{false};
+    /** Lock for the tracked subscriptions */
+    mutable std::mutex subsLock_;
+    /** The tracked subscriptions, by filter */
+    std::map<string, tracked_subscription> subs_;
+    /**
+     * The tracked subscriptions, laid out for a bulk subscribe. These are
+     * only rebuilt after the subscriptions change, not on each reconnect.
+     */
+    mutable const_string_collection_ptr subFilters_;
+    mutable qos_collection subQos_;
+    mutable std::vector<subscribe_options> subOpts_;
+    /** The token for the last restore of the subscriptions */
+    bulk_subscribe_token_ptr restoreTok_;
+    /** Whether the client loops its messages back, without a server */
+    bool loopback_{false};
+    /** Whether the client is "connected" in loopback mode */
+    std::atomic<bool> loopConnected_{false};
+    /** The last message ID given out in loopback mode */
+    std::atomic<int> loopMsgId_{0};
+    /** Whether the app acknowledges the incoming QoS 1 & 2 messages */
+    bool manualAck_{false};
+    /** The most unacknowledged incoming messages (0=no limit) */
+    size_t maxUnacked_{0};
+    /** Lock for the unacknowledged messages */
+    mutable std::mutex ackLock_;
+    /** The unacknowledged messages, by the order they arrived */
+    std::map<uint64_t, const_message_ptr> unacked_;
+    /** The arrival number of each unacknowledged message */
+    std::unordered_map<const message*, uint64_t> unackedSeq_;
+    /** The arrival number for the next unacknowledged message */
+    uint64_t nextAckSeq_{0};
+    /** The number of unacknowledged messages, read without the lock */
+    std::atomic<size_t> nUnacked_{0};
+    /** The buffer for messages published while disconnected, if any */
+    offline_buffer_ptr offlineBuf_;
+    /** The thread that sends the offline buffer after a reconnect */
+    std::thread drainThread_;
+    /** Lock for the state of the offline buffer */
+    std::mutex drainLock_;
+    /** Signaled when there's something for the drain thread to do */
+    std::condition_variable drainCond_;
+    /** Whether the client is connected, so the buffer can be sent */
+    bool drainOnline_{false};
+    /** Whether the drain thread is sending a message from the buffer */
+    bool draining_{false};
+    /** Whether the drain thread should exit */
+    bool drainStop_{false};
+
+    /** The number of messages published */
+    std::atomic<uint64_t> nPublished_{0};
+    /** The number of bytes published */
+    std::atomic<uint64_t> nBytesPublished_{0};
+    /** The number of messages received */
+    std::atomic<uint64_t> nReceived_{0};
+    /** The number of bytes received */
+    std::atomic<uint64_t> nBytesReceived_{0};
+    /** The number of times that the client connected */
+    std::atomic<uint64_t> nConnects_{0};
+    /** The most events that were in the consumer queue */
+    std::atomic<size_t> queHighWater_{0};
+    /** The number of incoming messages dropped by the overflow policy */
+    std::atomic<uint64_t> nDropped_{0};
+    /** The number of incoming messages dropped as duplicates */
+    std::atomic<uint64_t> nDuplicates_{0};
+    /** The number of failed fire-and-forget publishes */
+    std::atomic<uint64_t> nPublishErrors_{0};
+    /** The times from publish to acknowledgment */
+    latency_histogram ackLatency_;
+
+    /** Handler for the message trace points */
+    rcu_ptr<trace_handler> traceHandler_;
+    /** Trace one message in this many (0=none) */
+    std::atomic<unsigned> traceRate_{0};
+    /** Counter to pick the messages to trace */
+    std::atomic<unsigned> traceCount_{0};
+
+    /** Handler for the user callbacks that are slow */
+    rcu_ptr<slow_callback_handler> slowCbHandler_;
+    /** Whether the user callbacks are timed */
+    std::atomic<bool> timeCallbacks_{false};
+    /** The time over which a user callback is slow, in microseconds */
+    std::atomic<int64_t> slowCbThreshold_{0};
+    /** The number of slow user callbacks */
+    std::atomic<uint64_t> nSlowCallbacks_{0};
+    /** The times taken by the user callbacks */
+    latency_histogram callbackTime_;
+
+    /** Lock for sending an RTT probe, and matching its acknowledgment */
+    std::mutex rttLock_;
+    /** The topic for the RTT probes */
+    string rttTopic_;
+    /** The time between RTT probes */
+    std::chrono::milliseconds rttInterval_{0};
+    /** Each start or stop of the probes, so a stale timer can tell */
+    std::atomic<uint64_t> rttGen_{0};
+    /** Whether a probe is waiting for its acknowledgment */
+    bool rttPending_{false};
+    /** The message ID of the probe waiting for its acknowledgment */
+    MQTTAsync_token rttTok_{0};
+    /** The time the waiting probe was sent */
+    trace_clock::time_point rttSent_{};
+    /** The moving average of the round trip times, in microseconds */
+    std::atomic<int64_t> rttAvg_{0};
+    /** The round trip times */
+    latency_histogram rttLatency_;
+
+    /** An asynchronous consumer waiting for an event */
+    struct consume_waiter
+    {
+        /** Whether the consumer only wants messages (and disconnects) */
+        bool msgsOnly;
+        /** The handler to receive the event */
+        consume_event_handler handler;
+    };
+    /** Lock for the asynchronous consumers */
+    std::mutex consumeLock_;
+    /** The asynchronous consumers waiting for an event */
+    std::deque<consume_waiter> consumeWaiters_;
+    /** The number of asynchronous consumers that are waiting */
+    std::atomic<size_t> nConsumeWaiters_{0};
+
+    /** The end of the consumer fd that's polled (-1=none) */
+    int fdRead_{-1};
+    /** The end of the consumer fd that's signaled, which may be the same */
+    std::atomic<int> fdWrite_{-1};
+    /** Whether the consumer fd was signaled since it was last cleared */
+    std::atomic<bool> fdSignaled_{false};
+
+    /** Guards the start of the timer wheel */
+    std::once_flag timersOnce_;
+    /** The timers for the deadlines of the operations, once needed */
+    timer_wheel_ptr timers_;
+
+    /** Gets the timer wheel, starting it on first use */
+    const timer_wheel_ptr& timers();
 
     /** Callbacks from the C library */
     static void on_connected(void* context, char* cause);
@@ -200,20 +511,538 @@ private:
     );
     static void on_delivery_complete(void* context, MQTTAsync_token tok);
     static int on_update_connection(void* context, MQTTAsync_connectData* cdata);
+    /**
+     * Puts a user name and password into the C connect data, in buffers
+     * that the C library takes over.
+     */
+    static void set_connect_data(
+        MQTTAsync_connectData* cdata, std::string_view userName, std::string_view password
+    );
 
     /** Manage internal list of active tokens */
     friend class token;
     virtual void add_token(token_ptr tok);
     virtual void add_token(delivery_token_ptr tok);
+    /**
+     * Starts tracking a delivery token.
+     * This must be called with the delivery token lock held.
+     * @param tok The delivery token.
+     * @param now The current time.
+     */
+    void insert_pending(
+        const delivery_token_ptr& tok, std::chrono::steady_clock::time_point now
+    );
     virtual void remove_token(token* tok) override;
     virtual void remove_token(token_ptr tok) { remove_token(tok.get()); }
     void remove_token(delivery_token_ptr tok) { remove_token(tok.get()); }
 
+    /**
+     * Gets the size of a message, as counted by the publish window.
+     * @param msg The message.
+     * @return The size of the topic and payload of the message.
+     */
+    static size_t window_size(const const_message_ptr& msg) {
+        return msg ? (msg->get_topic().size() + msg->get_payload_ref().size()) : 0;
+    }
+    /**
+     * Gets the memory held by an outgoing message while it is pending
+     * delivery, as charged to the memory budget.
+     * @param msg The message.
+     * @return The size of a delivery token and the memory of the message.
+     */
+    static size_t token_memory(const const_message_ptr& msg) {
+        return sizeof(delivery_token) + (msg ? msg->memory_size() : 0);
+    }
+    /**
+     * Charges the memory for a delivery token to the budget.
+     * @param tok The delivery token, as it is added to the pending tokens.
+     */
+    void charge_token(delivery_token& tok);
+    /**
+     * Makes room in the memory budget for an incoming message, as the
+     * overflow policy says.
+     * @param m The incoming message.
+     * @return @em true if the message should be queued, @em false to drop
+     *  	   it.
+     */
+    bool make_room(const message& m);
+    /**
+     * Encodes the payload of an outgoing message with the payload codec,
+     * if the client has one and the message qualifies.
+     * @param msg The message.
+     * @return A copy of the message with the encoded payload and its tag,
+     *  	   or the original message if it's not encoded.
+     */
+    const_message_ptr encode_payload(const_message_ptr msg) const;
+    /**
+     * Determines if the next message should be traced.
+     * @return The time now if the message is traced, otherwise a default
+     *  	   (zero) time point.
+     */
+    trace_clock::time_point trace_start() noexcept;
+    /**
+     * Reports a trace point to the handler, if there is one.
+     * @param pt The trace point.
+     * @param msg The message.
+     * @param t The time that the message reached the point.
+     */
+    void trace(trace_point pt, const message& msg, trace_clock::time_point t) const;
+    /**
+     * Reports that a message was read from the consumer queue, if the
+     * message is being traced.
+     * @param msg The message.
+     */
+    void trace_consumed(const const_message_ptr& msg) const {
+        if (msg && msg->traced_)
+            trace(trace_point::CONSUMED, *msg, trace_clock::now());
+    }
+    /**
+     * Gets the executor that runs the user callbacks.
+     * @return The executor, or null if callbacks are run in place.
+     */
+    executor_ptr get_executor() const override { return executor_.load(); }
+    /**
+     * Gets the policy for spinning before a wait on a token blocks.
+     * @return The spin-then-block policy from the create options.
+     */
+    spin_wait get_spin_wait() const override { return createOpts_.get_spin_wait(); }
+    /**
+     * Gets the time that a user callback is starting, if they're timed.
+     * @return The current time, or the epoch if callbacks aren't timed.
+     */
+    trace_clock::time_point callback_start() const noexcept override {
+        return timeCallbacks_.load(std::memory_order_relaxed) ? trace_clock::now()
+                                                              : trace_clock::time_point{};
+    }
+    /**
+     * Records the time taken by a user callback, and reports it if it was
+     * slow.
+     * @param pt The kind of callback.
+     * @param what What the callback was for, like the topic.
+     * @param start The time the callback started, from callback_start().
+     */
+    void callback_done(callback_point pt, std::string_view what, trace_clock::time_point start);
+    /**
+     * Records the time taken by the action listener or completion
+     * handlers for a token.
+     * @param tok The token.
+     * @param start The time they started, from callback_start().
+     */
+    void listener_done(const token& tok, trace_clock::time_point start) override;
+    /**
+     * Schedules the next RTT probe.
+     * @param gen The generation of the probes that it is for.
+     */
+    void schedule_rtt_probe(uint64_t gen);
+    /**
+     * Sends an RTT probe, if the client is connected and the last one was
+     * answered, then schedules the next.
+     * @param gen The generation of the probes that it is for.
+     */
+    void send_rtt_probe(uint64_t gen);
+    /**
+     * Records the round trip time of a probe.
+     * @param rtt The time from sending the probe to its acknowledgment.
+     */
+    void record_rtt(trace_clock::duration rtt);
+    /**
+     * Completes the probe with the message ID, if it's the one waiting.
+     * @param tok The message ID from the C library.
+     * @param ok Whether the probe was acknowledged.
+     */
+    void on_rtt_complete(MQTTAsync_token tok, bool ok);
+
+    /** Callbacks from the C library for the RTT probes */
+    static void on_rtt_success(void* context, MQTTAsync_successData* rsp);
+    static void on_rtt_success5(void* context, MQTTAsync_successData5* rsp);
+    static void on_rtt_failure(void* context, MQTTAsync_failureData* rsp);
+    static void on_rtt_failure5(void* context, MQTTAsync_failureData5* rsp);
+    /**
+     * Runs a user callback on the executor, if there is one, otherwise
+     * runs it in place.
+     * @param fn The callback function.
+     */
+    template <typename Func>
+    void run_callback(Func&& fn) {
+        if (auto ex = executor_.load())
+            (*ex)(task_type{std::forward<Func>(fn)});
+        else
+            fn();
+    }
+    /**
+     * Hands events from the consumer queue to any asynchronous consumers
+     * that are waiting for them.
+     */
+    void notify_consumers();
+    /**
+     * Puts an incoming message into the consumer queue, following the
+     * overflow policy if the queue is full.
+     * @param m The message.
+     * @return @em true if the message was queued, @em false if it was
+     *  	   dropped.
+     */
+    bool queue_message(message_ptr m);
+    /**
+     * Queues a delivery completion for the user callback. The completions
+     * that arrive before the callback gets to run are passed together.
+     * @param cb The user callback.
+     * @param tok The token for the completed delivery.
+     */
+    void queue_delivery_complete(callback* cb, delivery_token_ptr tok);
+    /**
+     * Resets the topic aliases for a new connection, or when the
+     * connection is lost.
+     * @param connected Whether the client just connected.
+     */
+    void reset_topic_aliases(bool connected);
+    /**
+     * Sends a message to the server through the C library, with a topic
+     * alias if they're in use.
+     * @param msg The message.
+     * @param opts The response options for the C library.
+     * @return The return code from the C library.
+     */
+    int send_publish(const message& msg, MQTTAsync_responseOptions* opts);
+    /**
+     * Gets the topic for an incoming message that has a topic alias. If
+     * the message has a topic, it's saved for the alias, otherwise the
+     * one saved earlier is used.
+     * @param alias The topic alias from the message.
+     * @param topic The topic from the message, which may be empty.
+     * @return The topic for the message, or a null reference if the alias
+     *  	   was never given a topic on this connection.
+     */
+    string_ref resolve_topic_alias(uint16_t alias, string_ref topic);
+    /**
+     * Clears the topic aliases sent by the server.
+     */
+    void clear_incoming_topic_aliases();
+    /**
+     * Gets the properties that the server sent in the CONNACK for the
+     * current connection.
+     * @return The properties from the server, which are empty for MQTT
+     *  	   v3 connections.
+     */
+    properties connect_properties() const;
+    /**
+     * Sends a message to the server, and counts it as published.
+     * @param tok The delivery token for the message.
+     * @param pubTime The time the message was published, if it's traced.
+     * @param rspOpts The response options, which are set for the token.
+     * @return The return code from the C library.
+     */
+    int transmit(
+        const delivery_token_ptr& tok, trace_clock::time_point pubTime,
+        delivery_response_options& rspOpts
+    );
+    /**
+     * Holds back a QoS 1 or 2 message, if flow control is on and the
+     * server's receive maximum has been reached, otherwise counts it as
+     * in flight.
+     * @param tok The delivery token for the message.
+     * @param pubTime The time the message was published, if it's traced.
+     * @return @em true if the message was held back, @em false if it
+     *  	   should be sent now.
+     */
+    bool defer_send(const delivery_token_ptr& tok, trace_clock::time_point pubTime);
+    /**
+     * Sends the messages that were held back, as long as there's room
+     * under the server's receive maximum.
+     */
+    void send_deferred();
+    /**
+     * Fails all the messages that were held back, since they won't be
+     * sent.
+     * @param rc The return code for the failed tokens.
+     */
+    void fail_deferred(int rc);
+    /**
+     * Runs a connect race, then connects to the winner, completing the
+     * client's connect token. This is run on the race thread.
+     * @param opts The connect options, with the list of servers.
+     * @param stagger The time between starting each of the attempts.
+     */
+    void race_servers(connect_options opts, std::chrono::milliseconds stagger);
+    /**
+     * Cancels any connect race in progress and waits for it to end.
+     */
+    void stop_race();
+    /**
+     * Takes over the automatic reconnects from the C library, if the
+     * connect options have a backoff policy.
+     * @param opts The options for the connect, which are updated.
+     */
+    void set_reconnect_backoff(connect_options& opts);
+    /**
+     * Starts reconnecting with the backoff policy, if there is one.
+     */
+    void schedule_reconnect();
+    /**
+     * The loop for the reconnect thread.
+     */
+    void run_reconnects();
+    /**
+     * Puts a message into the offline buffer, if the client is offline or
+     * the buffer still holds messages to be sent ahead of it.
+     * The token is kept with the message while it's in memory, and
+     * completes when the message is sent. If the message spills to disk,
+     * the token is completed right away.
+     * @param msg The message.
+     * @param userContext The user context for the listener, if any.
+     * @param cb The listener for the completion, if any.
+     * @return The delivery token for the message if it was buffered, or
+     *  	   null if it should be sent now.
+     * @throw exception if the buffer is full.
+     */
+    delivery_token_ptr buffer_offline(
+        const const_message_ptr& msg, void* userContext = nullptr, iaction_listener* cb = nullptr
+    );
+    /**
+     * Tells the drain thread whether the client is connected.
+     * @param on @em true if the client is connected.
+     */
+    void set_buffer_online(bool on);
+    /**
+     * The loop for the thread that sends the offline buffer.
+     */
+    void run_drain();
+    /**
+     * Pins the calling C library thread to the CPUs in the create options,
+     * if it hasn't been pinned already.
+     */
+    void pin_library_thread() const;
+    /**
+     * Makes the consumer fd readable, if it isn't already.
+     */
+    void signal_consumer_fd();
+    /**
+     * Publishes a message right away, skipping the offline buffer.
+     * @param msg The message.
+     * @param tok The delivery token for the message, if it already has
+     *  		  one, such as from the offline buffer.
+     * @return The delivery token for the message.
+     */
+    delivery_token_ptr publish_now(
+        const_message_ptr msg, delivery_token_ptr tok = delivery_token_ptr{}
+    );
+    /**
+     * Passes an outgoing message through the publish shaper.
+     * A message that is held is scheduled to be released. Its token is
+     * kept with it, to complete when it's sent, and the token of a held
+     * message that it replaces fails with MQTTASYNC_MAX_BUFFERED_MESSAGES.
+     * @param msg The message.
+     * @param canWait Whether the caller can block until the message is
+     *  			  within the rate.
+     * @param tok The token for the message, if it has one.
+     * @return What to do with the message. One that had to wait has
+     *  	   already waited, and is to be sent.
+     */
+    publish_shaper::action shape(
+        const const_message_ptr& msg, bool canWait,
+        const delivery_token_ptr& tok = delivery_token_ptr{}
+    );
+    /**
+     * Gets the token for a message that the shaper didn't let through.
+     * A held or coalesced message keeps its token pending until it's sent
+     * or replaced, while one that was refused fails with
+     * MQTTASYNC_MAX_BUFFERED_MESSAGES.
+     * @param tok The token for the message.
+     * @param act What the shaper did with the message.
+     * @return The token.
+     */
+    static delivery_token_ptr shaped_token(delivery_token_ptr tok, publish_shaper::action act);
+    /**
+     * Sends the message that the shaper held for a topic, without
+     * blocking, and completes its token with the result.
+     * @param topic The topic.
+     */
+    void release_shaped(const string& topic);
+    /**
+     * Sends a message if there is room for it, without blocking, skipping
+     * the offline buffer and the shaper.
+     * @param msg The message.
+     * @param tok The delivery token for the message, if it already has
+     *  		  one, such as from the shaper.
+     * @return The token for the message, or the error code.
+     */
+    publish_result try_send(
+        const_message_ptr msg, delivery_token_ptr tok = delivery_token_ptr{}
+    );
+    /**
+     * Creates a delivery token for a message, from the token pool if
+     * there is one.
+     * @param msg The message.
+     * @return The delivery token.
+     */
+    delivery_token_ptr make_delivery_token(const_message_ptr msg) {
+        return tokPool_ ? tokPool_->make_shared<delivery_token>(*this, std::move(msg))
+                        : delivery_token::create(*this, std::move(msg));
+    }
+    /**
+     * Creates a delivery token for a message, with a listener, from the
+     * token pool if there is one.
+     * @param msg The message.
+     * @param userContext The user context for the listener.
+     * @param cb The listener for the completion.
+     * @return The delivery token.
+     */
+    delivery_token_ptr make_delivery_token(
+        const_message_ptr msg, void* userContext, iaction_listener& cb
+    ) {
+        return tokPool_ ? tokPool_->make_shared<delivery_token>(
+                              *this, std::move(msg), userContext, cb
+                          )
+                        : delivery_token::create(*this, std::move(msg), userContext, cb);
+    }
+    /**
+     * Sends a message, tracked by the delivery token.
+     * This assumes that any room for the message in the publish window
+     * has already been acquired.
+     * @param tok The delivery token for the message.
+     * @param pubTime The time that the message was published, if it's
+     *  			  traced, from trace_start().
+     * @return The delivery token.
+     */
+    delivery_token_ptr send_message(
+        delivery_token_ptr tok, trace_clock::time_point pubTime = trace_clock::time_point{}
+    );
+    /**
+     * Sends a message, tracked by its delivery token, reporting a failure
+     * by return code. On failure, the token is removed from the client.
+     * @param tok The delivery token for the message.
+     * @param pubTime The time that the message was published, if it's
+     *  			  traced, from trace_start().
+     * @return MQTTASYNC_SUCCESS if the message was sent or deferred,
+     *  	   otherwise the error code.
+     */
+    int send_token(const delivery_token_ptr& tok, trace_clock::time_point pubTime);
+    /**
+     * Publishes a batch of messages, tracked by the token.
+     * @param btok The batch token to track the messages.
+     * @param msgs The messages to publish.
+     * @return The batch token.
+     */
+    batch_token_ptr publish_batch(
+        batch_token_ptr btok, const std::vector<const_message_ptr>& msgs
+    );
+    /**
+     * Publishes a copy of one message to each of a number of topics,
+     * tracked by the token.
+     * @param btok The batch token to track the messages.
+     * @param topics The topics for the messages.
+     * @param msg The message to send to each of the topics.
+     * @return The batch token.
+     */
+    batch_token_ptr publish_fanout(
+        batch_token_ptr btok, const std::vector<string>& topics, const_message_ptr msg
+    );
+    /**
+     * Sends the messages that were added to a batch token.
+     * The batch is charged to the memory budget, and its delivery tokens
+     * registered with the client, all at once.
+     * @param btok The batch token, holding the delivery tokens.
+     * @return The batch token.
+     */
+    batch_token_ptr send_batch(batch_token_ptr btok);
+    /**
+     * Subscribes to the filters of a bulk token, in chunks.
+     * @param btok The bulk token, holding the topic filters.
+     * @param qos The QoS for each of the filters.
+     * @param opts The MQTT v5 subscribe options, one for each filter, or
+     *  		   empty for the defaults.
+     * @param props The MQTT v5 properties, sent with each chunk.
+     * @return The bulk token.
+     */
+    bulk_subscribe_token_ptr subscribe_bulk(
+        bulk_subscribe_token_ptr btok, const qos_collection& qos,
+        const std::vector<subscribe_options>& opts, const properties& props
+    );
+    /**
+     * Gets the largest packet that the server will accept, as reported
+     * in the CONNACK, or the default for bulk subscribes if it gave none.
+     * @return The maximum packet size, in bytes.
+     */
+    size_t max_packet_size() const;
+    /**
+     * Sends the chunks of a bulk subscribe, without tracking the filters.
+     * @return The bulk token.
+     */
+    bulk_subscribe_token_ptr send_bulk(
+        bulk_subscribe_token_ptr btok, const qos_collection& qos,
+        const std::vector<subscribe_options>& opts, const properties& props
+    );
+    /**
+     * Adds filters to the subscriptions to restore after a reconnect, if
+     * the client is tracking them.
+     * @param filters The topic filters.
+     * @param qos The QoS for each of the filters.
+     * @param opts The subscribe options for each filter, or empty for the
+     *  		   defaults.
+     */
+    void track_subscriptions(
+        const string_collection& filters, const qos_collection& qos,
+        const std::vector<subscribe_options>& opts
+    );
+    /**
+     * Removes filters from the subscriptions to restore.
+     * @param filters The topic filters.
+     */
+    void untrack_subscriptions(const string_collection& filters);
+    /**
+     * Builds the bulk layout of the tracked subscriptions, if they changed.
+     * This must be called with the subscription lock held.
+     */
+    void update_subscription_layout() const;
+    /**
+     * Subscribes again to all of the tracked subscriptions, if the server
+     * didn't keep the session. Called when the client connects.
+     */
+    void restore_subscriptions();
+    /**
+     * Starts dispatching incoming messages to the workers of a dispatcher,
+     * in place of any current one.
+     * @param disp The dispatcher.
+     */
+    void set_dispatcher(message_dispatcher_ptr disp);
+    /**
+     * Keeps an incoming message until the app acknowledges it.
+     * @param msg The message.
+     */
+    void track_unacked(const const_message_ptr& msg);
+    /**
+     * In loopback mode, delivers a message back to the client as an
+     * arrival, then completes the publish.
+     * @param msg The message that was published.
+     * @param opts The response options for the publish.
+     * @return The return code for the publish.
+     */
+    int loopback_publish(const message& msg, MQTTAsync_responseOptions* opts);
+    /**
+     * In loopback mode, completes a request that would otherwise go to
+     * the server, such as a subscribe, successfully.
+     * @param opts The response options for the request.
+     * @return The return code for the request.
+     */
+    int loopback_complete(MQTTAsync_responseOptions* opts);
+    /**
+     * In loopback mode, completes a connect successfully, with a connect
+     * response for the token.
+     */
+    void loopback_connect();
+
     /** Non-copyable */
     async_client() = delete;
     async_client(const async_client&) = delete;
     async_client& operator=(const async_client&) = delete;
 
+    /**
+     * Moves the messages from a batch of consumer events into the vector,
+     * skipping the connected events.
+     * @return The number of events in the batch, including any that were
+     *  	   skipped.
+     */
+    size_t add_messages(std::vector<event>& evts, std::vector<const_message_ptr>& msgs) const;
+
     /** Checks a function return code and throws on error. */
     static void check_ret(int rc) {
         if (rc != MQTTASYNC_SUCCESS)
@@ -295,6 +1124,15 @@ public:
      * @throw exception if an argument is invalid
      */
     async_client(const create_options& opts) : createOpts_{opts} { create(); }
+    /**
+     * Create an async_client that can be used to communicate with an MQTT
+     * server, moving in the create options.
+     * This saves a copy of the options when creating a large number of
+     * clients.
+     * @param opts The create options
+     * @throw exception if an argument is invalid
+     */
+    async_client(create_options&& opts) : createOpts_{std::move(opts)} { create(); }
     /**
      * Destructor
      */
@@ -335,12 +1173,95 @@ public:
      * @param cb The callback functor to register with the library.
      */
     void set_message_callback(message_handler cb) /*override*/;
+    /**
+     * Adds a handler for the messages that arrive on topics matching a
+     * filter.
+     *
+     * Each incoming message is passed to every handler with a filter
+     * that it matches, after the general message handler, if any. The
+     * handlers are kept in a topic matcher, so finding them is a search
+     * on the fields of the topic, regardless of the number of filters.
+     * Adding a handler for a filter that already has one replaces it.
+     *
+     * This does not subscribe to the filter.
+     *
+     * @param filter The topic filter. This can contain wildcards.
+     * @param cb The handler for the matching messages. If this is empty,
+     *  		 any handler for the filter is removed.
+     */
+    void add_message_handler(const string& filter, message_handler cb);
+    /**
+     * Removes the handler for a topic filter.
+     * @param filter The topic filter, as given to add_message_handler().
+     * @return @em true if there was a handler for the filter, @em false
+     *  	   otherwise.
+     */
+    bool remove_message_handler(const string& filter);
+    /**
+     * Replaces all the handlers for the topic filters at once.
+     *
+     * This is for routing rules that change at runtime. The new table can
+     * be built separately, for as long as it takes, while messages keep
+     * being routed through the current one. It's then swapped in
+     * atomically, so each message is routed entirely through either the
+     * old table or the new one. The lookups never take a lock, either
+     * way.
+     *
+     * This does not change the subscriptions.
+     *
+     * @param handlers The new table of handlers, by topic filter. None of
+     *  			   the handlers should be empty.
+     * @return A snapshot of the table that was replaced.
+     */
+    message_handler_snapshot set_message_handlers(message_handler_table&& handlers);
+    /**
+     * Gets a snapshot of the handlers for the topic filters.
+     * This is not affected by any later changes to the handlers.
+     * @return A read-only snapshot of the table of handlers.
+     */
+    message_handler_snapshot get_message_handlers() const {
+        return filterHandlers_.snapshot();
+    }
     /**
      * Sets a callback to allow the application to update the connection
      * data on automatic reconnects.
      * @param cb The callback functor to register with the library.
      */
     void set_update_connection_handler(update_connection_handler cb);
+    /**
+     * Sets a provider for the credentials of each connection attempt.
+     *
+     * Before each connect and automatic reconnect, the client takes the
+     * credentials from the provider and puts them straight into the
+     * library's connect data, without calling the update connection
+     * handler. If the provider has no credentials, the handler is called
+     * as usual, if there is one. The provider is called on the library's
+     * thread, so it must not block; see @ref refreshing_credential_provider
+     * for one that makes new credentials ahead of time.
+     *
+     * @param prov The credential provider. If this is null, any provider
+     *  		   is removed.
+     */
+    void set_credential_provider(credential_provider_ptr prov);
+    /**
+     * Sets an executor to run the user callbacks, handlers, and token
+     * listeners, rather than running them on the library's callback
+     * thread.
+     *
+     * The executor is passed each callback as a task to run, and can
+     * hand it off to a thread pool or an event loop, such as with
+     * `asio::post(ioc, std::move(task))`. A multi-threaded executor may
+     * run the callbacks in a different order than they arrived. When an
+     * executor is set, a token's wait() may return before its action
+     * listener has run.
+     *
+     * The connection update handler is always run in place, since its
+     * result is needed by the library.
+     *
+     * @param ex The executor, or an empty function to run the callbacks
+     *  in place.
+     */
+    void set_executor(executor_type ex);
     /**
      * Connects to an MQTT server using the default options.
      * @return token used to track and wait for the connect to complete. The
@@ -389,6 +1310,41 @@ public:
     token_ptr connect(void* userContext, iaction_listener& cb) override {
         return connect(connect_options{}, userContext, cb);
     }
+    /**
+     * Connects to the first of a number of servers to respond.
+     *
+     * When the connect options have a list of servers, the C library tries
+     * them one after another, so an unreachable server at the front of the
+     * list costs a full connect timeout before the next is tried. This
+     * instead starts a trial connection to each of the servers, staggered
+     * in the "happy eyeballs" style, and then connects the client to the
+     * first one that accepts, with the others behind it in the list, in
+     * case of a later reconnect.
+     * @par
+     * The trial connections are made from separate, temporary clients
+     * that use the same connect options, but with a clean session, an
+     * empty client ID, no Last Will, and no automatic reconnect. They are
+     * dropped as soon as the race is over. A server that doesn't take an
+     * empty client ID will lose every race, so this isn't suitable then.
+     * @par
+     * The race runs on a separate thread, and the returned token tracks
+     * the connection of this client, as with connect(). If no server
+     * accepts within the connect timeout, the client tries the servers in
+     * the original order. With no more than one server in the options,
+     * this is the same as connect().
+     * @par
+     * A disconnect while the race is running cancels it, and fails the
+     * token. The client can't be reconnected until the race is over.
+     *
+     * @param opts The options for the connection, with the list of
+     *  		   servers.
+     * @param stagger The time between starting each trial connection.
+     * @return A token to track and wait for the connect to complete.
+     */
+    token_ptr connect_race(
+        connect_options opts,
+        std::chrono::milliseconds stagger = std::chrono::milliseconds{250}
+    );
     /**
      * Reconnects the client using options from the previous connect.
      * The client must have previously called connect() for this to work.
@@ -496,9 +1452,227 @@ public:
     delivery_token_ptr get_pending_delivery_token(int msgID) const override;
     /**
      * Returns the delivery tokens for any outstanding publish operations.
+     * The tokens are returned in no particular order.
      * @return delivery_token[]
      */
     std::vector<delivery_token_ptr> get_pending_delivery_tokens() const override;
+    /**
+     * Returns the delivery tokens that have been pending for at least a
+     * given time, oldest first.
+     * This includes all the tokens that the client is tracking, even ones
+     * that have not yet been sent. The tokens are kept in the order they
+     * were published, so this only looks at the ones that are returned,
+     * and is cheap if few are that old, no matter how many are pending.
+     * It's meant for a watchdog to find any publishes that are stuck.
+     * @param age The least time that a token has been pending.
+     * @return The tokens that have been pending for at least that long.
+     */
+    std::vector<delivery_token_ptr> get_pending_delivery_tokens(
+        std::chrono::steady_clock::duration age
+    ) const;
+    /**
+     * Gets the number of delivery tokens that the client is tracking.
+     * This doesn't take any locks.
+     * @return The number of outstanding publish operations.
+     */
+    size_t num_pending_delivery_tokens() const noexcept {
+        return nPendingDelivery_.load(std::memory_order_relaxed);
+    }
+    /**
+     * Gets how long the oldest of the outstanding publish operations has
+     * been pending.
+     * @return The time since the oldest pending delivery token was
+     *  	   published, or zero if there are none.
+     */
+    std::chrono::steady_clock::duration oldest_pending_delivery_age() const;
+    /**
+     * Gets a snapshot of the activity of the client.
+     *
+     * The counters are kept with relaxed atomics as the client runs, so
+     * getting them has little effect on the client. The reconnects are
+     * counted from the connected callback, so they're only seen when the
+     * client has a callback, a handler, or a consumer that receives them.
+     * @return The statistics for the client.
+     */
+    client_stats get_stats() const;
+    /**
+     * Gets the local cache of retained messages, if the client has one.
+     * @return The retained message cache, or null if there is none.
+     */
+    retained_cache_ptr get_retained_cache() const { return retainedCache_; }
+    /**
+     * Sets a deadline for an operation.
+     *
+     * If the operation hasn't completed in the time given, its token is
+     * failed with a @ref timeout_error, which wakes any threads waiting on
+     * it and calls its listener and completion handlers. The deadlines for
+     * all the operations of the client are kept by a single timer thread,
+     * in a @ref timer_wheel, so there's no need for a thread or a timed
+     * wait for each of them. The timer thread is started the first time a
+     * deadline is set.
+     * @par
+     * This doesn't cancel the operation in the library, which might still
+     * complete later, such as a publish that is delivered after it timed
+     * out, but its result is then ignored. To set a deadline for all the
+     * operations, use create_options::set_operation_timeout().
+     *
+     * @param tok The token for the operation.
+     * @param timeout The time that the operation has to complete. This is
+     *  			  accurate to the tick of the timer wheel, 10ms.
+     */
+    void set_deadline(const token_ptr& tok, timer_wheel::duration timeout);
+    /**
+     * Gets the filter for duplicate incoming messages, if the client has
+     * one.
+     * @return The duplicate message filter, or null if there is none.
+     */
+    dedup_filter_ptr get_dedup_filter() const { return dedupFilter_; }
+    /**
+     * Gets the tracker for the sequence numbers of incoming messages, if
+     * the client has one.
+     * @return The sequence tracker, or null if there is none.
+     */
+    sequence_tracker_ptr get_sequence_tracker() const { return seqTracker_; }
+    /**
+     * Gets the traffic counters for a set of topic filters, if the client
+     * has them.
+     * @return The topic counters, or null if there are none.
+     */
+    topic_stats_ptr get_topic_stats() const { return topicStats_; }
+    /**
+     * Gets the sampler for the incoming messages, if the client has one.
+     * @return The message sampler, or null if there is none.
+     */
+    message_sampler_ptr get_message_sampler() const { return sampler_; }
+/**
+ * Sets the server's receive maximum, as if it came in a connect response,
+ * for the unit tests.
+ */
+#if defined(UNIT_TESTS)
+    void set_receive_maximum(size_t n) {
+        guard g(flowLock_);
+        recvMax_ = n;
+    }
+#endif
+/**
+ * Records a round trip time, as if a probe was answered, for the unit
+ * tests.
+ */
+#if defined(UNIT_TESTS)
+    void record_rtt_sample(std::chrono::microseconds rtt) { record_rtt(rtt); }
+#endif
+/**
+ * Drops the connection, as if it was lost, in loopback mode, for the unit
+ * tests.
+ */
+#if defined(UNIT_TESTS)
+    void lose_connection() {
+        loopConnected_ = false;
+        on_connection_lost(this, nullptr);
+    }
+#endif
+/**
+ * Gets the topic saved for an incoming topic alias, for the unit tests.
+ */
+#if defined(UNIT_TESTS)
+    string_ref incoming_topic_alias(uint16_t alias) { return resolve_topic_alias(alias, {}); }
+#endif
+    /**
+     * Gets the reassembler for chunked transfers, if the client has one.
+     * @return The chunk reassembler, or null if there is none.
+     */
+    chunk_reassembler_ptr get_chunk_reassembler() const { return reassembler_; }
+    /**
+     * Gets the retained messages that the client has received for the
+     * topics matching a filter, from the local cache.
+     * This doesn't contact the server, so it only knows of the retained
+     * messages that the client's subscriptions have brought in.
+     * @param filter The topic filter, which may have wildcards.
+     * @return The retained messages for the matching topics. This is
+     *  	   empty if the client has no retained message cache.
+     */
+    std::vector<const_message_ptr> get_retained(std::string_view filter) const {
+        return retainedCache_ ? retainedCache_->get_retained(filter)
+                              : std::vector<const_message_ptr>{};
+    }
+    /**
+     * Sets a handler for the trace points in the life of the messages.
+     *
+     * The handler is called as each sampled message is published, handed
+     * to the C library, and delivered, and as each sampled incoming message
+     * arrives, is put into the consumer queue, and is read from it. This
+     * is meant to let a tracing or telemetry system follow the messages
+     * through the client.
+     *
+     * Tracing can be left out of the library entirely by building it with
+     * the CMake option `PAHO_WITH_TRACING` turned off, in which case the
+     * handler is never called.
+     *
+     * @param cb The handler, or an empty function to stop tracing.
+     * @param sampleRate Trace one message out of this many, so 1 traces
+     *  				 every message.
+     */
+    void set_trace_handler(trace_handler cb, unsigned sampleRate = 1);
+    /**
+     * Starts timing the user callbacks, and sets a handler for the ones
+     * that are slow.
+     *
+     * User callbacks, such as the message handler or an action listener,
+     * are normally run on a thread of the C library, so one that takes too
+     * long stalls the connection, and with it every other callback. Once
+     * timing is on, every callback is timed, into a histogram that is
+     * reported by get_stats(), and those that take at least the threshold
+     * are counted, and passed to the handler with what they were for,
+     * such as the topic of the message.
+     *
+     * Timing costs two reads of the clock for each callback, so it's off
+     * until this is called.
+     *
+     * @param cb The handler for the slow callbacks, or an empty function
+     *  		 to stop timing them.
+     * @param threshold The time at which a callback is considered slow.
+     */
+    void set_slow_callback_handler(
+        slow_callback_handler cb,
+        std::chrono::microseconds threshold = std::chrono::milliseconds(100)
+    );
+    /**
+     * Starts measuring the round trip time to the server.
+     *
+     * While the client is connected, it publishes a small QoS 1 probe
+     * message at each interval, and times how long the server takes to
+     * acknowledge it. The times are reported in get_stats(), as a moving
+     * average and percentiles, and the average is available from
+     * get_rtt(). A new probe isn't sent until the last one is answered,
+     * or an interval has gone by without an answer.
+     * @par
+     * The C library doesn't expose the timing of its keep-alive pings, so
+     * the probe is an ordinary publish, and the server must allow the
+     * client to publish to the topic. Nothing needs to subscribe to it.
+     * The probes don't reach the delivery callbacks, tokens, or
+     * publishing counts of the client; they are only sent as a QoS 1
+     * message through the C library. In loopback mode there's no server,
+     * so nothing is measured.
+     *
+     * @param interval The time between the probes.
+     * @param topic The topic for the probes. If this is empty, it is
+     *  			"paho/rtt/<client ID>".
+     */
+    void start_rtt_probe(std::chrono::milliseconds interval, const string& topic = string{});
+    /**
+     * Stops measuring the round trip time to the server.
+     * The times measured so far are kept, and a probe that hasn't been
+     * answered yet is dropped.
+     */
+    void stop_rtt_probe();
+    /**
+     * Gets the moving average of the round trip time to the server.
+     * @return The average round trip time, or zero if none was measured.
+     * @see start_rtt_probe()
+     */
+    std::chrono::microseconds get_rtt() const {
+        return std::chrono::microseconds(rttAvg_.load(std::memory_order_relaxed));
+    }
     /**
      * Returns the client ID used by this client.
      * @return The client ID used by this client.
@@ -532,7 +1706,9 @@ public:
      * Determines if this client is currently connected to the server.
      * @return true if connected, false otherwise.
      */
-    bool is_connected() const override { return to_bool(MQTTAsync_isConnected(cli_)); }
+    bool is_connected() const override {
+        return loopback_ ? loopConnected_.load() : to_bool(MQTTAsync_isConnected(cli_));
+    }
     /**
      * Publishes a message to a topic on the server
      * @param topic The topic to deliver the message to
@@ -612,6 +1788,16 @@ public:
      * Publishes a message to a topic on the server Takes an Message
      * message and delivers it to the server at the requested quality of
      * service.
+     *
+     * If the client was created with a limit on the messages pending
+     * delivery, this blocks until there is room in the publish window. So
+     * it should not be called from a callback, which would keep earlier
+     * deliveries from completing. Use try_publish() there instead.
+     * @par
+     * If the client has a publish shaper, the message is checked against
+     * its rate limits first, which may delay, hold, or drop it. See
+     * @ref publish_shaper.
+     *
      * @param msg the message to deliver to the server
      * @return token used to track and wait for the publish to complete. The
      *  	   token will be passed to callback methods if set.
@@ -631,6 +1817,226 @@ public:
     delivery_token_ptr publish(
         const_message_ptr msg, void* userContext, iaction_listener& cb
     ) override;
+    /**
+     * Forwards a message, such as one received by another client, to a
+     * topic on the server.
+     *
+     * The message that is sent shares its payload and properties with the
+     * original rather than copying them, so a bridge can pass messages on
+     * without copying their contents. See message::forward().
+     *
+     * @param msg The message to forward.
+     * @param topic The topic to send the message to. If this is empty,
+     *  			the topic of the original message is used.
+     * @return token used to track and wait for the publish to complete. The
+     *  	   token will be passed to callback methods if set.
+     */
+    delivery_token_ptr publish(const_message_ptr msg, string_ref topic) {
+        return publish(message::forward(msg, std::move(topic)));
+    }
+    /**
+     * Attempts to publish a message without waiting for room in the publish
+     * window.
+     *
+     * If the client was created with a limit on the number of messages or
+     * bytes pending delivery, and the window is full, or with a memory
+     * budget that is used up, this returns immediately with a null token,
+     * rather than blocking like publish(). The same goes for a message
+     * that the publish shaper would delay.
+     * Otherwise it is the same as publish().
+     *
+     * @param msg The message to deliver to the server.
+     * @return A token to track and wait for the publish to complete, or a
+     *  	   null token if the publish window or memory budget is full.
+     */
+    delivery_token_ptr try_publish(const_message_ptr msg);
+    /**
+     * Attempts to publish a message, reporting the expected failures by
+     * return code rather than by exception.
+     *
+     * This is try_publish() for hot paths that can't afford the cost of
+     * throwing and unwinding for the conditions that come with a high
+     * rate, like a full buffer or a lost connection. If the publish window
+     * or memory budget is full, or the publish shaper would delay the
+     * message, this fails with
+     * MQTTASYNC_MAX_BUFFERED_MESSAGES, the same as the library does when
+     * its own buffer is full. Any other error from the C library, like
+     * MQTTASYNC_DISCONNECTED, is returned as it is.
+     *
+     * @param msg The message to deliver to the server.
+     * @return The token for the message, or the error code.
+     */
+    publish_result try_publish(const_message_ptr msg, const std::nothrow_t&) noexcept;
+    /**
+     * Attempts to publish a message, reporting the expected failures by
+     * return code rather than by exception.
+     * @param topic The topic to deliver the message to.
+     * @param payload The bytes to use as the message payload.
+     * @param n The number of bytes in the payload.
+     * @param qos The quality of service to deliver the message.
+     * @param retained Whether the message should be retained by the server.
+     * @return The token for the message, or the error code.
+     * @see try_publish(const_message_ptr, const std::nothrow_t&)
+     */
+    publish_result try_publish(
+        string_ref topic, const void* payload, size_t n, int qos, bool retained,
+        const std::nothrow_t&
+    ) noexcept;
+    /**
+     * Publishes a QoS 0 message without tracking its delivery.
+     *
+     * This is a lighter path for high-rate, fire-and-forget messages, like
+     * telemetry, that the application doesn't need to track. No delivery
+     * token is created or held by the client, and the message doesn't take
+     * room in the publish window, as there is no completion to release it.
+     * Any error is given by the return code, rather than an exception, and
+     * is counted in the @ref client_stats::publishErrors of the client. A
+     * message that the publish shaper would delay or drop fails with
+     * MQTTASYNC_MAX_BUFFERED_MESSAGES.
+     *
+     * @param msg The message to deliver to the server. This must be QoS 0.
+     * @return MQTTASYNC_SUCCESS if the message was queued for sending,
+     *  	   MQTTASYNC_BAD_QOS if the message is not QoS 0, or the error
+     *  	   from the C library, like MQTTASYNC_DISCONNECTED.
+     */
+    int publish_nowait(const_message_ptr msg) noexcept;
+    /**
+     * Publishes a QoS 0 message without tracking its delivery.
+     * @param topic The topic to deliver the message to.
+     * @param payload The bytes to use as the message payload.
+     * @param n The number of bytes in the payload.
+     * @param retained Whether the message should be retained by the server.
+     * @return MQTTASYNC_SUCCESS if the message was queued for sending,
+     *  	   otherwise the error code.
+     * @see publish_nowait(const_message_ptr)
+     */
+    int publish_nowait(
+        string_ref topic, const void* payload, size_t n, bool retained = false
+    ) noexcept;
+    /**
+     * Attempts to publish a message, waiting a limited time for room in
+     * the publish window.
+     * @param msg The message to deliver to the server.
+     * @param relTime The maximum amount of time to wait for room in the
+     *  			  window.
+     * @return A token to track and wait for the publish to complete, or a
+     *  	   null token if the publish window or memory budget stayed
+     *  	   full.
+     * @sa try_publish()
+     */
+    template <typename Rep, class Period>
+    delivery_token_ptr try_publish_for(
+        const_message_ptr msg, const std::chrono::duration<Rep, Period>& relTime
+    ) {
+        delivery_token_ptr tok;
+        if (shaper_) {
+            tok = delivery_token::create(*this, msg);
+            if (auto act = shape(msg, false, tok); act != publish_shaper::action::SEND)
+                return (act == publish_shaper::action::WAIT) ? delivery_token_ptr{}
+                                                             : shaped_token(std::move(tok), act);
+        }
+        auto t = trace_start();
+        msg = encode_payload(std::move(msg));
+        if (!memBudget_->wait_for(token_memory(msg), relTime))
+            return delivery_token_ptr{};
+        if (pubWindow_ && !pubWindow_->try_acquire_for(window_size(msg), relTime))
+            return delivery_token_ptr{};
+        if (tok)
+            tok->set_message(std::move(msg));
+        else
+            tok = delivery_token::create(*this, std::move(msg));
+        return send_message(std::move(tok), t);
+    }
+    /**
+     * Gets the number of messages pending in the publish window.
+     * @return The number of publishes that have yet to complete, if the
+     *  	   client was created with a publish window, otherwise zero.
+     */
+    size_t get_pending_window_count() const {
+        return pubWindow_ ? pubWindow_->messages() : size_t(0);
+    }
+    /**
+     * Publishes a batch of messages to the server.
+     *
+     * This is the same as publishing each of the messages in turn, but
+     * amortizes the overhead of tracking them, and returns a single token
+     * that completes when all of the messages have completed.
+     *
+     * The batch succeeds if all of the messages were delivered. If any
+     * fail, including any that could not be sent, the batch fails with the
+     * error of the first failure. The delivery tokens of the individual
+     * messages can be inspected to find which ones failed. Unlike
+     * publish(), this does not throw if a message can not be sent.
+     *
+     * @param msgs The messages to deliver to the server.
+     * @return A token to track and wait for the whole batch to complete.
+     */
+    batch_token_ptr publish_batch(const std::vector<const_message_ptr>& msgs) {
+        return publish_batch(batch_token::create(*this), msgs);
+    }
+    /**
+     * Publishes a batch of messages to the server.
+     * @param msgs The messages to deliver to the server.
+     * @param userContext optional object used to pass context to the
+     *  				  callback. Use @em nullptr if not required.
+     * @param cb Listener that will be notified when the whole batch has
+     *  		 completed.
+     * @return A token to track and wait for the whole batch to complete.
+     * @sa publish_batch(const std::vector<const_message_ptr>&)
+     */
+    batch_token_ptr publish_batch(
+        const std::vector<const_message_ptr>& msgs, void* userContext, iaction_listener& cb
+    ) {
+        return publish_batch(batch_token::create(*this, userContext, cb), msgs);
+    }
+    /**
+     * Publishes the same payload to each of a number of topics.
+     *
+     * This is for sending one thing, like a configuration, to a large
+     * number of topics, such as one for each device. All of the messages
+     * share the one payload, which is encoded only once if the client has
+     * a payload codec, and they are sent as a batch, with a single token
+     * that completes when all of them have completed, as with
+     * publish_batch().
+     *
+     * @param topics The topics to publish to.
+     * @param payload The payload for all of the messages.
+     * @param qos The quality of service for the messages.
+     * @param retained Whether the messages should be retained by the
+     *  			   server.
+     * @return A token to track and wait for all of the messages.
+     * @sa publish_batch(const std::vector<const_message_ptr>&)
+     */
+    batch_token_ptr publish_fanout(
+        const std::vector<string>& topics, binary_ref payload, int qos = message::DFLT_QOS,
+        bool retained = message::DFLT_RETAINED
+    ) {
+        return publish_fanout(
+            batch_token::create(*this), topics,
+            make_message(string_ref{}, std::move(payload), qos, retained)
+        );
+    }
+    /**
+     * Publishes a message to each of a number of topics.
+     * The messages share the payload and properties of the one given,
+     * which is sent to each of the topics in turn, ignoring its own topic.
+     * @param topics The topics to publish to.
+     * @param msg The message to send to each of the topics.
+     * @param userContext optional object used to pass context to the
+     *  				  callback. Use @em nullptr if not required.
+     * @param cb Listener that will be notified when all of the messages
+     *  		 have completed.
+     * @return A token to track and wait for all of the messages.
+     * @sa publish_fanout(const std::vector<string>&, binary_ref, int, bool)
+     */
+    batch_token_ptr publish_fanout(
+        const std::vector<string>& topics, const_message_ptr msg, void* userContext,
+        iaction_listener& cb
+    ) {
+        return publish_fanout(
+            batch_token::create(*this, userContext, cb), topics, std::move(msg)
+        );
+    }
     /**
      * Subscribe to a topic, which may include wildcards.
      * @param topicFilter the topic to subscribe to, which can include
@@ -710,6 +2116,113 @@ public:
         const std::vector<subscribe_options>& opts = std::vector<subscribe_options>(),
         const properties& props = properties()
     ) override;
+    /**
+     * Subscribes to a large number of topic filters.
+     *
+     * This is like subscribing to a collection of filters, but the filters
+     * are split into as many SUBSCRIBE packets as it takes to keep each
+     * one under the maximum packet size of the server, and no more than
+     * @ref MAX_BULK_FILTERS filters. The packets are all sent at once,
+     * without waiting for the acknowledgments of the earlier ones, and
+     * the returned token completes when all of them have completed. Its
+     * reason codes cover all of the filters, in order.
+     *
+     * Unlike subscribe(), this does not throw if a chunk can not be sent;
+     * the chunk fails, and the token with it.
+     *
+     * @param topicFilters The collection of topic filters to subscribe to,
+     *                     any of which can include wildcards
+     * @param qos The maximum quality of service for each filter.
+     * @param opts The MQTT v5 subscribe options (one for each topic)
+     * @param props The MQTT v5 properties, sent with each packet.
+     * @return A token to track and wait for all of the chunks.
+     * @throw std::invalid_argument if the sizes of the collections don't
+     *  	  match.
+     */
+    bulk_subscribe_token_ptr subscribe_bulk(
+        const_string_collection_ptr topicFilters, const qos_collection& qos,
+        const std::vector<subscribe_options>& opts = std::vector<subscribe_options>(),
+        const properties& props = properties()
+    ) {
+        return subscribe_bulk(bulk_subscribe_token::create(*this, topicFilters), qos, opts, props);
+    }
+    /**
+     * Subscribes to a large number of topic filters.
+     * @param topicFilters The collection of topic filters to subscribe to,
+     *                     any of which can include wildcards
+     * @param qos The maximum quality of service for each filter.
+     * @param userContext Optional object used to pass context to the
+     *  				  callback. Use @em nullptr if not required.
+     * @param cb Listener that will be notified when all of the chunks
+     *  		 have completed.
+     * @param opts The MQTT v5 subscribe options (one for each topic)
+     * @param props The MQTT v5 properties, sent with each packet.
+     * @return A token to track and wait for all of the chunks.
+     * @throw std::invalid_argument if the sizes of the collections don't
+     *  	  match.
+     * @sa subscribe_bulk(const_string_collection_ptr, const qos_collection&,
+     *  				  const std::vector<subscribe_options>&, const properties&)
+     */
+    bulk_subscribe_token_ptr subscribe_bulk(
+        const_string_collection_ptr topicFilters, const qos_collection& qos,
+        void* userContext, iaction_listener& cb,
+        const std::vector<subscribe_options>& opts = std::vector<subscribe_options>(),
+        const properties& props = properties()
+    ) {
+        return subscribe_bulk(
+            bulk_subscribe_token::create(*this, topicFilters, userContext, cb), qos, opts, props
+        );
+    }
+    /**
+     * Gets the topic filters that the client would restore after a
+     * reconnect.
+     * This is only tracked if the client was created with
+     * create_options::set_restore_subscriptions().
+     * @return The tracked topic filters, which is empty if the client
+     *  	   isn't tracking them.
+     */
+    const_string_collection_ptr get_subscriptions() const;
+    /**
+     * Gets the token for the last time that the client restored its
+     * subscriptions.
+     * The client resubscribes on its own when it connects, so this is how
+     * the application finds out whether that worked. The token is in
+     * place by the time the connected callbacks run, and completes, like
+     * the one from subscribe_bulk(), when all the chunks have.
+     * @return The token for the last restore, or null if the client
+     *  	   hasn't had to restore any subscriptions since it last
+     *  	   connected.
+     */
+    bulk_subscribe_token_ptr get_restore_token() const;
+    /**
+     * Acknowledges an incoming message, in manual acknowledgment mode.
+     * See create_options::set_manual_ack().
+     * @param msg The message, as it was received.
+     * @return @em true if the message was waiting to be acknowledged,
+     *  	   @em false if not, such as if it was already acknowledged.
+     */
+    bool ack(const const_message_ptr& msg);
+    /**
+     * Acknowledges an incoming message and all the ones that arrived
+     * before it, in manual acknowledgment mode.
+     * This lets a consumer acknowledge a batch of messages at once, after
+     * it has handled them all.
+     * @param msg The last message to acknowledge, as it was received.
+     * @return The number of messages acknowledged.
+     */
+    size_t ack_through(const const_message_ptr& msg);
+    /**
+     * Gets the incoming messages that are waiting to be acknowledged, in
+     * the order they arrived.
+     * @return The unacknowledged messages.
+     */
+    std::vector<const_message_ptr> get_unacked() const;
+    /**
+     * Gets the number of incoming messages that are waiting to be
+     * acknowledged.
+     * @return The number of unacknowledged messages.
+     */
+    size_t unacked_count() const { return nUnacked_.load(std::memory_order_relaxed); }
     /**
      * Requests the server unsubscribe the client from a topic.
      * @param topicFilter The topic to unsubscribe from. It must match a
@@ -786,6 +2299,62 @@ public:
      * push events into the queue in the order received.
      */
     void start_consuming() override;
+    /**
+     * Start consuming messages using a specific queue.
+     *
+     * This is the same as start_consuming(), but lets the application
+     * choose the queue that holds the events. For example, a bounded,
+     * lock-free queue can be used to keep the library's callback thread
+     * from contending with the consumer for a lock:
+     *
+     * @code
+     *     cli.start_consuming(std::make_unique<mqtt::lock_free_consumer_queue>(8192));
+     * @endcode
+     *
+     * Note that if the queue is bounded, the callback thread will block
+     * when it is full, until the consumer removes some events, unless the
+     * client was created with a different overflow policy.
+     *
+     * A @ref priority_consumer_queue can be used so that some messages,
+     * like commands, are consumed ahead of a backlog of others:
+     *
+     * @code
+     *     cli.start_consuming(std::make_unique<mqtt::priority_consumer_queue>(
+     *         3, mqtt::lanes_by_qos()
+     *     ));
+     * @endcode
+     *
+     * If the client was created with a spin policy, it is given to the
+     * queue, so that the consumer spins before it blocks.
+     *
+     * @param que The queue to receive the events. If this is null, the
+     *  		  default, unbounded queue is used.
+     */
+    void start_consuming(consumer_queue_type que);
+    /**
+     * Start consuming messages with a queue made from the options.
+     *
+     * This is the same as start_consuming(), but the client creates the
+     * queue with the type and capacity in the options, and uses their
+     * overflow policy, if one is set, in place of the one from the create
+     * options. This puts a bound on the memory used by the events when the
+     * consumer stalls:
+     *
+     * @code
+     *     cli.start_consuming(mqtt::consumer_options_builder()
+     *                             .capacity(10000)
+     *                             .overflow_policy(mqtt::overflow_policy::DROP_OLDEST)
+     *                             .finalize());
+     * @endcode
+     *
+     * With a maximum number of bytes, the deque is bounded by the total
+     * size of the topics and payloads of the messages in it.
+     *
+     * @param opts The options for the consumer queue.
+     * @throw std::invalid_argument if a maximum number of bytes is given for
+     *  	  the ring queue.
+     */
+    void start_consuming(const consumer_options& opts);
     /**
      * Stop consuming messages.
      *
@@ -795,6 +2364,103 @@ public:
      * This will also wake up any thread waiting on the queue.
      */
     void stop_consuming() override;
+    /**
+     * Start dispatching messages to a handler on a pool of worker threads.
+     *
+     * Incoming messages are normally delivered to the message callback on
+     * the library's single callback thread, so one slow handler delays
+     * all the messages for the connection. With this, each message is
+     * instead queued to one of a number of worker threads, which call the
+     * handler.
+     *
+     * The worker for a message is chosen by a key, which by default is a
+     * hash of the message topic. Messages with the same key are handled in
+     * the order they arrived, while messages with different keys may be
+     * handled in parallel. So by default, the order of the messages on any
+     * one topic is preserved.
+     *
+     * This is an alternative to the consumer queue and message callback,
+     * although they may all be used at the same time. Like
+     * start_consuming(), it should be called before connecting.
+     *
+     * @param cb The message handler. It will be called from the worker
+     *  		 threads, and must be thread safe.
+     * @param nWorkers The number of worker threads. If this is zero, the
+     *  			   number of hardware threads is used.
+     * @param keyFunc A function to get the dispatch key for a message. If
+     *  			  this is empty, a hash of the topic is used.
+     */
+    void start_dispatching(
+        message_handler cb, size_t nWorkers = 0,
+        message_dispatcher::key_func keyFunc = message_dispatcher::key_func{}
+    );
+    /**
+     * Start dispatching incoming messages to a pool of worker threads,
+     * with the specified mode.
+     *
+     * With dispatch_mode::UNORDERED, the messages are not kept in order by
+     * topic. They are spread over the workers in turn, and a worker that
+     * runs out of messages steals from the others, so the work stays
+     * balanced even when a few topics carry most of the traffic. This is
+     * meant for topics where the order doesn't matter, such as independent
+     * device events. See start_dispatching(cb, nWorkers, keyFunc).
+     *
+     * @param cb The message handler. It will be called from the worker
+     *  		 threads, and must be thread safe.
+     * @param nWorkers The number of worker threads. If this is zero, the
+     *  			   number of hardware threads is used.
+     * @param mode How the messages are assigned to the workers.
+     */
+    void start_dispatching(message_handler cb, size_t nWorkers, dispatch_mode mode);
+    /**
+     * Stop dispatching messages to the worker pool.
+     *
+     * This blocks until the workers have finished handling any messages
+     * that were already queued. It must not be called from the handler.
+     */
+    void stop_dispatching();
+    /**
+     * Pins the dispatcher's worker threads to a set of CPUs.
+     * @param cpus The CPUs for the workers.
+     * @param onePerWorker If @em true, each worker is pinned to one of the
+     *  				   CPUs, in turn, rather than to all of them.
+     * @return @em true if all the workers were pinned, @em false if the
+     *  	   client isn't dispatching, or they couldn't be pinned.
+     * @see message_dispatcher::set_cpu_affinity()
+     */
+    bool set_dispatcher_affinity(const cpu_set& cpus, bool onePerWorker = false) {
+        return dispatcher_ && dispatcher_->set_cpu_affinity(cpus, onePerWorker);
+    }
+    /**
+     * Gets a file descriptor that can be polled for events in the consumer
+     * queue.
+     *
+     * This allows the consumer queue to be handled in an event loop, like
+     * one using epoll, poll, or select, alongside sockets and other
+     * descriptors, without a thread blocked in consume_message(). The
+     * descriptor becomes readable when events are put into the queue. When
+     * it is, the loop calls clear_consumer_fd(), then reads the queue with
+     * try_consume_message() or try_consume_event() until it is empty. The
+     * descriptor is also signaled when the queue is closed by
+     * stop_consuming().
+     *
+     * The descriptor is made on the first call, after which the same one
+     * is returned. It's an eventfd on Linux, and the read end of a pipe on
+     * other POSIX systems. It is owned by the client and closed when the
+     * client is destroyed, so it must not be closed by the application, or
+     * read except through clear_consumer_fd().
+     *
+     * @return A non-blocking file descriptor to poll for readability.
+     * @throw exception if the consumer wasn't started, the descriptor
+     *  	  can't be made, or the platform doesn't support it.
+     */
+    int consumer_fd();
+    /**
+     * Clears the readiness of the consumer fd.
+     * This must be called before reading the events from the queue, so
+     * that any that arrive while it's being read signal the fd again.
+     */
+    void clear_consumer_fd();
     /**
      * This clears the consumer queue, discarding any pending event.
      */
@@ -933,6 +2599,92 @@ public:
      *  	   available.
      */
     bool try_consume_message(const_message_ptr* msg) override;
+    /**
+     * Reads the next event from the queue without blocking the caller.
+     *
+     * If an event is available, it is returned immediately, and the
+     * handler is not used. Otherwise, the handler is registered and will
+     * be called once with the next event, from the thread that puts the
+     * event into the queue, which is typically the library's callback
+     * thread. If the consumer queue is closed, a shutdown event is
+     * returned.
+     *
+     * Handlers are called in the order they were registered. This is
+     * meant for asynchronous consumers like coroutines, rather than
+     * blocking a thread in consume_event().
+     *
+     * @param evt Pointer to the value to receive the event if one is
+     *  		  available now.
+     * @param handler The handler to receive the next event, if one is not
+     *  			  available now.
+     * @return @em true if the event was read now, @em false if the handler
+     *  	   was registered to receive it later.
+     */
+    bool consume_event_async(event* evt, consume_event_handler handler);
+    /**
+     * Reads the next message from the queue without blocking the caller.
+     *
+     * This is the same as consume_event_async() but, as with
+     * consume_message(), 'connected' events are skipped, and any
+     * disconnect or shutdown is returned as an empty message pointer.
+     *
+     * @param msg Pointer to the value to receive the message if one is
+     *  		  available now.
+     * @param handler The handler to receive the next message, if one is
+     *  			  not available now.
+     * @return @em true if the message was read now, @em false if the
+     *  	   handler was registered to receive it later.
+     */
+    bool consume_message_async(const_message_ptr* msg, consume_message_handler handler);
+
+#if defined(PAHO_MQTTPP_COROUTINES)
+    /**
+     * An awaitable to read the next message from the consumer queue in a
+     * coroutine.
+     */
+    class consume_awaiter
+    {
+        /** The client */
+        async_client& cli_;
+        /** The message that was read */
+        const_message_ptr msg_;
+
+    public:
+        explicit consume_awaiter(async_client& cli) : cli_{cli} {}
+
+        bool await_ready() const noexcept { return false; }
+
+        bool await_suspend(std::coroutine_handle<> h) {
+            // Note that the coroutine could be resumed on another thread as
+            // soon as the handler is registered.
+            return !cli_.consume_message_async(&msg_, [this, h](const_message_ptr msg) {
+                msg_ = std::move(msg);
+                h.resume();
+            });
+        }
+
+        const_message_ptr await_resume() { return std::move(msg_); }
+    };
+    /**
+     * Reads the next message from the consumer queue in a coroutine.
+     *
+     * This suspends the coroutine until a message arrives, rather than
+     * blocking the thread:
+     *
+     * @code
+     *     while (auto msg = co_await cli.async_consume())
+     *         handle(msg);
+     * @endcode
+     *
+     * The coroutine is resumed on the thread that delivered the message,
+     * which is typically the library's callback thread, so it should hand
+     * any lengthy work off to an executor. As with consume_message(), a
+     * disconnect returns an empty message pointer.
+     *
+     * @return An awaitable that produces the next message.
+     */
+    consume_awaiter async_consume() { return consume_awaiter{*this}; }
+#endif
     /**
      * Waits a limited time for a message to arrive.
      * @param msg Pointer to the value to receive the message
@@ -953,8 +2705,9 @@ public:
             if (!try_consume_event_for(&evt, relTime))
                 return false;
 
-            if (const auto* pval = evt.get_message_if()) {
+            if (auto* pval = evt.get_message_if()) {
                 *msg = std::move(*pval);
+                trace_consumed(*msg);
                 break;
             }
 
@@ -999,8 +2752,9 @@ public:
             if (!try_consume_event_until(&evt, absTime))
                 return false;
 
-            if (const auto* pval = evt.get_message_if()) {
+            if (auto* pval = evt.get_message_if()) {
                 *msg = std::move(*pval);
+                trace_consumed(*msg);
                 break;
             }
 
@@ -1025,6 +2779,71 @@ public:
         this->try_consume_message_until(&msg, absTime);
         return msg;
     }
+    /**
+     * Try to read a number of messages from the queue without blocking.
+     *
+     * This removes up to the specified number of events from the consumer
+     * queue at once, which is considerably more efficient than reading
+     * them individually when messages are arriving at a high rate.
+     *
+     * As with consume_message(), the 'connected' events are skipped and
+     * any disconnect event is returned as an empty message pointer.
+     *
+     * @param msgs The vector to receive the messages. They are appended to
+     *  		   any items already in the vector.
+     * @param maxMsgs The maximum number of events to remove from the queue.
+     * @return The number of events removed from the queue, which includes
+     *  	   any connected events that were skipped. It's zero only if
+     *  	   the queue was empty. The number of messages is the growth of
+     *  	   the vector.
+     */
+    size_t try_consume_messages(std::vector<const_message_ptr>& msgs, size_t maxMsgs);
+    /**
+     * Removes everything from the consumer queue at once, such as to save
+     * the messages that are left on shutdown.
+     *
+     * With the default consumer queue, this swaps out the contents in
+     * constant time, with a single lock, however many events are waiting,
+     * rather than taking them out one at a time. It's typically called
+     * after stop_consuming(), which closes the queue so that no more
+     * arrive.
+     *
+     * The events are returned as they were queued, so they include the
+     * connection events as well as the messages. Use
+     * event::get_message_if() to pick out the messages.
+     *
+     * @return The events that were in the queue, oldest first.
+     * @throw exception if the consumer wasn't started.
+     */
+    std::deque<event> drain_consumer_queue();
+    /**
+     * Reads a number of messages from the queue, waiting a limited time
+     * for the first one to arrive.
+     *
+     * Once a message arrives, this removes up to the specified number of
+     * events from the consumer queue at once, in the same manner as
+     * try_consume_messages().
+     *
+     * @param msgs The vector to receive the messages. They are appended to
+     *  		   any items already in the vector.
+     * @param maxMsgs The maximum number of events to remove from the queue.
+     * @param relTime The maximum amount of time to wait for an event.
+     * @return The number of events removed from the queue, which includes
+     *  	   any connected events that were skipped. It's zero only on a
+     *  	   timeout. The number of messages is the growth of the vector.
+     */
+    template <typename Rep, class Period>
+    size_t consume_messages(
+        std::vector<const_message_ptr>& msgs, size_t maxMsgs,
+        const std::chrono::duration<Rep, Period>& relTime
+    ) {
+        if (!que_)
+            throw mqtt::exception(-1, "Consumer not started");
+
+        std::vector<event> evts;
+        que_->try_get_bulk_for(evts, maxMsgs, relTime);
+        return add_messages(evts, msgs);
+    }
 };
 
 /** Smart/shared pointer to an asynchronous MQTT client object */
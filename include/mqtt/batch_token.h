@@ -0,0 +1,181 @@
+/////////////////////////////////////////////////////////////////////////////
+/// @file batch_token.h
+/// Declaration of MQTT batch_token class
+/// @author Frank Pagliughi
+/////////////////////////////////////////////////////////////////////////////
+
+/*******************************************************************************
+ * Copyright (c) 2025 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+#ifndef __mqtt_batch_token_h
+#define __mqtt_batch_token_h
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "mqtt/delivery_token.h"
+#include "mqtt/iaction_listener.h"
+#include "mqtt/token.h"
+
+namespace mqtt {
+
+/////////////////////////////////////////////////////////////////////////////
+
+/**
+ * A token to track the delivery of a batch of messages.
+ *
+ * This is returned by async_client::publish_batch(). It completes when
+ * all the messages in the batch have completed. It succeeds if they all
+ * succeeded, otherwise it fails with the return code of the first message
+ * that failed.
+ *
+ * The delivery tokens for the individual messages are available from the
+ * batch, so the application can find out which of them failed, and why.
+ */
+class batch_token : public token
+{
+    /** Listener for the completion of the individual messages */
+    class delivery_listener : public iaction_listener
+    {
+        batch_token* batch_;
+
+        void on_success(const token&) override { batch_->on_delivery_complete(); }
+        void on_failure(const token& tok) override { batch_->on_delivery_failure(tok); }
+
+    public:
+        explicit delivery_listener(batch_token* batch) : batch_{batch} {}
+    };
+
+    /** The delivery tokens for the messages in the batch */
+    std::vector<delivery_token_ptr> toks_;
+    /** The listener for the delivery tokens */
+    delivery_listener dlvrListener_;
+    /**
+     * The number of messages in flight. This is biased by one while the
+     * batch is being sent, so it can't complete before all are sent.
+     */
+    std::atomic<size_t> nPending_{1};
+    /** The number of messages that failed */
+    std::atomic<size_t> nFailed_{0};
+    /** The return code of the first failure */
+    std::atomic<int> firstRc_{MQTTASYNC_SUCCESS};
+
+    /** The client has special access */
+    friend class async_client;
+
+    /**
+     * Creates a delivery token for a message, and adds it to the batch.
+     * @param msg The message.
+     * @return The delivery token for the message.
+     */
+    delivery_token_ptr add(const_message_ptr msg);
+    /**
+     * Called once all the messages have been sent, to release the bias on
+     * the pending count.
+     */
+    void sent() { on_delivery_complete(); }
+    /**
+     * Called when the delivery of a message completes.
+     */
+    void on_delivery_complete();
+    /**
+     * Called when the delivery of a message fails.
+     * @param tok The delivery token for the message.
+     */
+    void on_delivery_failure(const token& tok);
+    /**
+     * Completes the batch token, once all the messages are done.
+     */
+    void complete();
+
+public:
+    /** Smart/shared pointer to an object of this class */
+    using ptr_t = std::shared_ptr<batch_token>;
+    /** Smart/shared pointer to a const object of this class */
+    using const_ptr_t = std::shared_ptr<const batch_token>;
+
+    /**
+     * Creates an empty batch token connected to a particular client.
+     * @param cli The asynchronous client object.
+     */
+    batch_token(iasync_client& cli)
+        : token{token::Type::PUBLISH, cli}, dlvrListener_{this} {}
+    /**
+     * Creates an empty batch token connected to a particular client.
+     * @param cli The asynchronous client object.
+     * @param userContext Optional object used to pass context to the
+     *  				  listener. Use @em nullptr if not required.
+     * @param cb Listener that will be notified when the whole batch has
+     *  		 completed.
+     */
+    batch_token(iasync_client& cli, void* userContext, iaction_listener& cb)
+        : token{token::Type::PUBLISH, cli, userContext, cb}, dlvrListener_{this} {}
+
+    batch_token(const batch_token&) = delete;
+    batch_token& operator=(const batch_token&) = delete;
+
+    /**
+     * Creates an empty batch token connected to a particular client.
+     * @param cli The asynchronous client object.
+     * @return A smart/shared pointer to the new token.
+     */
+    static ptr_t create(iasync_client& cli) { return std::make_shared<batch_token>(cli); }
+    /**
+     * Creates an empty batch token connected to a particular client.
+     * @param cli The asynchronous client object.
+     * @param userContext Optional object used to pass context to the
+     *  				  listener. Use @em nullptr if not required.
+     * @param cb Listener that will be notified when the whole batch has
+     *  		 completed.
+     * @return A smart/shared pointer to the new token.
+     */
+    static ptr_t create(iasync_client& cli, void* userContext, iaction_listener& cb) {
+        return std::make_shared<batch_token>(cli, userContext, cb);
+    }
+    /**
+     * Gets the number of messages in the batch.
+     * @return The number of messages in the batch.
+     */
+    size_t size() const { return toks_.size(); }
+    /**
+     * Gets the delivery tokens for the messages in the batch.
+     * The tokens are in the same order as the messages.
+     * @return The delivery tokens for the messages in the batch.
+     */
+    const std::vector<delivery_token_ptr>& get_delivery_tokens() const { return toks_; }
+    /**
+     * Gets the number of messages that failed, so far.
+     * @return The number of messages that failed.
+     */
+    size_t failed_count() const { return nFailed_; }
+    /**
+     * Gets the delivery tokens for the messages that failed, so far.
+     * @return The delivery tokens for the messages that failed.
+     */
+    std::vector<delivery_token_ptr> get_failed_tokens() const;
+};
+
+/** Smart/shared pointer to a batch token */
+using batch_token_ptr = batch_token::ptr_t;
+
+/** Smart/shared pointer to a const batch token */
+using const_batch_token_ptr = batch_token::const_ptr_t;
+
+/////////////////////////////////////////////////////////////////////////////
+}  // namespace mqtt
+
+#endif  // __mqtt_batch_token_h
@@ -25,7 +25,14 @@
 #define __mqtt_buffer_ref_h
 
 #include <cstring>
+#include <functional>
 #include <iostream>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <variant>
 
 #include "mqtt/types.h"
 
@@ -48,6 +55,20 @@ namespace mqtt {
  * If no value has been assigned to a reference, then it is in a default
  * "null" state. It is not safe to call any member functions on a null
  * reference, other than to check if the object is null or empty.
+ *
+ * A reference can also adopt a buffer that was allocated elsewhere, such
+ * as by the C library, along with a function to free it when the last
+ * reference goes away. This avoids copying the data, and the contents can
+ * be read through data() and size(). A string copy of the data is only
+ * made if one is requested with str(), c_str(), or ptr(). Alternately, the
+ * reference can hold a share of any object that owns the memory. A message
+ * with an adopted payload is published directly from that memory.
+ *
+ * Small buffers, such as short topics and tiny payloads, are held in place
+ * in the reference itself, using the small-string storage of the blob. A
+ * copy of a small reference copies the data rather than sharing it, but
+ * avoids the heap allocation and atomic reference count of a shared
+ * buffer. A small buffer is never shared, so ptr() gives a new copy of it.
  * @verbatim
  * string_ref sr;
  * if (!sr)
@@ -76,9 +97,79 @@ public:
      */
     using pointer_type = std::shared_ptr<const blob>;
 
+    /** The type of function used to free an adopted buffer */
+    using deleter_type = std::function<void(const value_type*)>;
+
+    /**
+     * The largest buffer that is held in place in the reference rather
+     * than shared. This fits in the small-string storage of the blob in
+     * the common standard libraries.
+     */
+    static constexpr size_t SMALL_SIZE = 15 / sizeof(T);
+
 private:
-    /** Our data is a shared pointer to a const buffer */
-    pointer_type data_;
+    /**
+     * An external buffer adopted by the reference.
+     * A blob copy of the data is only created the first time it's
+     * requested.
+     */
+    struct external
+    {
+        /** The adopted memory */
+        const value_type* buf;
+        /** The size of the adopted memory */
+        size_t n;
+        /** The function to free the memory */
+        deleter_type del;
+        /** Flag to create the blob only once */
+        std::once_flag once;
+        /** A copy of the data, if requested */
+        pointer_type blobPtr;
+
+        external(const value_type* b, size_t len, deleter_type d)
+            : buf{b}, n{len}, del{std::move(d)} {}
+        ~external() {
+            if (del)
+                del(buf);
+        }
+        const pointer_type& to_blob() {
+            std::call_once(once, [this] { blobPtr = std::make_shared<blob>(buf, n); });
+            return blobPtr;
+        }
+    };
+
+    /** A shared blob, which is null for a null reference */
+    static constexpr size_t SHARED = 0;
+    /** An adopted buffer */
+    static constexpr size_t EXTERNAL = 1;
+    /** A small buffer held in place */
+    static constexpr size_t SMALL = 2;
+
+    /**
+     * Our data is a shared pointer to a const buffer, an adopted buffer,
+     * or, for a small buffer, the data itself, held in place.
+     */
+    std::variant<pointer_type, std::shared_ptr<external>, blob> data_;
+
+    /** Gets the adopted buffer, if any. */
+    external* ext() const noexcept {
+        auto p = std::get_if<EXTERNAL>(&data_);
+        return p ? p->get() : nullptr;
+    }
+    /** Sets the reference to a copy of the data */
+    void assign(const value_type* buf, size_t n) {
+        if (n <= SMALL_SIZE)
+            data_.template emplace<SMALL>(buf, n);
+        else
+            data_ = std::make_shared<blob>(buf, n);
+    }
+    /** Sets the reference to the data moved from a string */
+    void assign(blob&& b) {
+        if (b.size() <= SMALL_SIZE)
+            data_.template emplace<SMALL>(std::move(b));
+        else
+            data_ = std::make_shared<blob>(std::move(b));
+    }
 
 public:
     /**
@@ -91,21 +182,22 @@ public:
      */
     buffer_ref(const buffer_ref& buf) = default;
     /**
-     * Move constructor only moves a shared pointer.
+     * Move constructor only moves a shared pointer, or the data of a small
+     * buffer. The other reference is left null.
      * @param buf Another buffer reference.
      */
-    buffer_ref(buffer_ref&& buf) = default;
+    buffer_ref(buffer_ref&& buf) noexcept : data_{std::exchange(buf.data_, pointer_type{})} {}
     /**
      * Creates a reference to a new buffer by copying data.
      * @param b A string from which to create a new buffer.
      */
-    buffer_ref(const blob& b) : data_{std::make_shared<blob>(b)} {}
+    buffer_ref(const blob& b) { assign(b.data(), b.size()); }
     /**
      * Creates a reference to a new buffer by moving a string into the
      * buffer.
      * @param b A string from which to create a new buffer.
      */
-    buffer_ref(blob&& b) : data_{std::make_shared<blob>(std::move(b))} {}
+    buffer_ref(blob&& b) { assign(std::move(b)); }
     /**
      * Creates a reference to an existing buffer by copying the shared
      * pointer.
@@ -127,7 +219,7 @@ public:
      * @param buf The memory to copy
      * @param n The number of bytes to copy.
      */
-    buffer_ref(const value_type* buf, size_t n) : data_{std::make_shared<blob>(buf, n)} {}
+    buffer_ref(const value_type* buf, size_t n) { assign(buf, n); }
     /**
      * Creates a reference to a new buffer containing a copy of the
      * NUL-terminated char array.
@@ -139,6 +231,45 @@ public:
             sizeof(char) == sizeof(T), "can only use C arr with char or byte buffers"
         );
     }
+    /**
+     * Creates a reference that adopts an existing buffer, without copying
+     * the data.
+     * The buffer must not be modified while any reference to it exists.
+     * When the last reference is released, the deleter is called to free
+     * the memory.
+     * @param buf The memory to adopt.
+     * @param n The number of bytes in the buffer.
+     * @param del A function to free the memory.
+     */
+    buffer_ref(const value_type* buf, size_t n, deleter_type del)
+        : data_{std::make_shared<external>(buf, n, std::move(del))} {}
+    /**
+     * Creates a reference that adopts an existing buffer, without copying
+     * the data, with the shared state taken from an allocator.
+     * @param buf The memory to adopt.
+     * @param n The number of bytes in the buffer.
+     * @param del A function to free the memory.
+     * @param alloc The allocator for the shared state of the reference.
+     */
+    template <typename Alloc>
+    buffer_ref(const value_type* buf, size_t n, deleter_type del, const Alloc& alloc)
+        : data_{std::allocate_shared<external>(alloc, buf, n, std::move(del))} {}
+    /**
+     * Creates a reference to memory that is kept alive by another object,
+     * without copying the data.
+     *
+     * This can refer to memory owned by anything that can be held by a
+     * shared pointer, such as a memory-mapped file, a DMA buffer, or a
+     * block from an application allocator. The reference holds a share of
+     * the owner until the last reference to the buffer is released.
+     * The memory must not be modified while any reference to it exists.
+     *
+     * @param buf The memory to reference.
+     * @param n The number of bytes in the buffer.
+     * @param owner The object that owns the memory.
+     */
+    buffer_ref(const value_type* buf, size_t n, std::shared_ptr<const void> owner)
+        : buffer_ref(buf, n, [owner = std::move(owner)](const value_type*) {}) {}
 
     /**
      * Copy the reference to the buffer.
@@ -151,7 +282,11 @@ public:
      * @param rhs The other reference to move.
      * @return A reference to this object.
      */
-    buffer_ref& operator=(buffer_ref&& rhs) = default;
+    buffer_ref& operator=(buffer_ref&& rhs) noexcept {
+        if (&rhs != this)
+            data_ = std::exchange(rhs.data_, pointer_type{});
+        return *this;
+    }
     /**
      * Copy a string into this object, creating a new buffer.
      * Modifies the reference for this object, pointing it to a
@@ -161,7 +296,7 @@ public:
      * @return A reference to this object.
      */
     buffer_ref& operator=(const blob& b) {
-        data_.reset(new blob(b));
+        assign(b.data(), b.size());
         return *this;
     }
     /**
@@ -173,7 +308,7 @@ public:
      * @return A reference to this object.
      */
     buffer_ref& operator=(blob&& b) {
-        data_.reset(new blob(std::move(b)));
+        assign(std::move(b));
         return *this;
     }
     /**
@@ -185,7 +320,7 @@ public:
         static_assert(
             sizeof(char) == sizeof(T), "can only use C arr with char or byte buffers"
         );
-        data_.reset(new blob(reinterpret_cast<const value_type*>(cstr), strlen(cstr)));
+        assign(reinterpret_cast<const value_type*>(cstr), strlen(cstr));
         return *this;
     }
     /**
@@ -202,13 +337,13 @@ public:
         static_assert(
             sizeof(OT) == sizeof(T), "Can only assign buffers if values the same size"
         );
-        data_.reset(new blob(reinterpret_cast<const value_type*>(rhs.data()), rhs.size()));
+        assign(reinterpret_cast<const value_type*>(rhs.data()), rhs.size());
         return *this;
     }
     /**
      * Clears the reference to nil.
      */
-    void reset() { data_.reset(); }
+    void reset() { data_ = pointer_type{}; }
     /**
      * Determines if the reference is valid.
      * If the reference is invalid then it is not safe to call @em any
@@ -216,7 +351,7 @@ public:
      * @return @em true if referring to a valid buffer, @em false if the
      *  	   reference (pointer) is null.
      */
-    explicit operator bool() const { return bool(data_); }
+    explicit operator bool() const { return !is_null(); }
     /**
      * Determines if the reference is invalid.
      * If the reference is invalid then it is not safe to call @em any
@@ -224,33 +359,78 @@ public:
      * @return @em true if the reference is null, @em false if it is
      *  	   referring to a valid buffer,
      */
-    bool is_null() const { return !data_; }
+    bool is_null() const {
+        auto p = std::get_if<SHARED>(&data_);
+        return p && !*p;
+    }
     /**
      * Determines if the buffer is empty.
      * @return @em true if the buffer is empty or the reference is null,
      *  	   @em false if the buffer contains data.
      */
-    bool empty() const { return !data_ || data_->empty(); }
+    bool empty() const { return is_null() || size() == 0; }
+    /**
+     * Determines if the reference is to an adopted, external buffer.
+     * @return @em true if the reference adopted an external buffer, @em
+     *  	   false otherwise.
+     */
+    bool is_external() const { return data_.index() == EXTERNAL; }
+    /**
+     * Determines if the data is held in place in the reference, as a
+     * small buffer.
+     * @return @em true if the data is held in a small buffer, @em false
+     *  	   otherwise.
+     */
+    bool is_small() const { return data_.index() == SMALL; }
     /**
      * Gets a const pointer to the data buffer.
      * @return A pointer to the data buffer.
      */
-    const value_type* data() const { return data_->data(); }
+    const value_type* data() const {
+        switch (data_.index()) {
+            case EXTERNAL:
+                return ext()->buf;
+            case SMALL:
+                return std::get<SMALL>(data_).data();
+            default:
+                return std::get<SHARED>(data_)->data();
+        }
+    }
     /**
      * Gets the size of the data buffer.
      * @return The size of the data buffer.
      */
-    size_t size() const { return data_->size(); }
+    size_t size() const {
+        switch (data_.index()) {
+            case EXTERNAL:
+                return ext()->n;
+            case SMALL:
+                return std::get<SMALL>(data_).size();
+            default:
+                return std::get<SHARED>(data_)->size();
+        }
+    }
     /**
      * Gets the size of the data buffer.
      * @return The size of the data buffer.
      */
-    size_t length() const { return data_->length(); }
+    size_t length() const { return size(); }
     /**
      * Gets the data buffer as a string.
+     * For an adopted buffer, this makes a copy of the data the first time
+     * it is called.
      * @return The data buffer as a string.
      */
-    const blob& str() const { return *data_; }
+    const blob& str() const {
+        switch (data_.index()) {
+            case EXTERNAL:
+                return *ext()->to_blob();
+            case SMALL:
+                return std::get<SMALL>(data_);
+            default:
+                return *std::get<SHARED>(data_);
+        }
+    }
     /**
      * Gets the data buffer as a string.
      * @return The data buffer as a string.
@@ -261,18 +441,39 @@ public:
      * Note that the reference must be set to call this function.
      * @return The data buffer as a string.
      */
-    const char* c_str() const { return data_->c_str(); }
+    const char* c_str() const { return str().c_str(); }
+    /**
+     * Gets a view of a character buffer, without copying it.
+     * This is safe to use with a null reference, giving an empty view.
+     * @return A view of the data buffer.
+     */
+    template <typename U = T, typename = std::enable_if_t<std::is_same<U, char>::value>>
+    operator std::string_view() const noexcept {
+        return is_null() ? std::string_view{} : std::string_view{data(), size()};
+    }
     /**
      * Gets a shared pointer to the (const) data buffer.
+     * For an adopted buffer, this makes a copy of the data the first time
+     * it is called. A small buffer is never shared, so each call gets a
+     * new copy of it.
      * @return A shared pointer to the (const) data buffer.
      */
-    const pointer_type& ptr() const { return data_; }
+    pointer_type ptr() const {
+        switch (data_.index()) {
+            case EXTERNAL:
+                return ext()->to_blob();
+            case SMALL:
+                return std::make_shared<blob>(std::get<SMALL>(data_));
+            default:
+                return std::get<SHARED>(data_);
+        }
+    }
     /**
      * Gets elemental access to the data buffer (read only)
      * @param i The index into the buffer.
      * @return The value at the specified index.
      */
-    const value_type& operator[](size_t i) const { return (*data_)[i]; }
+    const value_type& operator[](size_t i) const { return data()[i]; }
 };
 
 /**
@@ -25,6 +25,7 @@
 #define __mqtt_buffer_view_h
 
 #include <iostream>
+#include <string_view>
 
 #include "mqtt/types.h"
 
@@ -105,6 +106,13 @@ public:
         );
         return string(reinterpret_cast<const char*>(data_), sz_);
     }
+    /**
+     * Gets the view as a standard string view.
+     * @return A standard string view of the same items.
+     */
+    operator std::basic_string_view<value_type>() const noexcept {
+        return std::basic_string_view<value_type>(data_, sz_);
+    }
 };
 
 /**
@@ -0,0 +1,184 @@
+/////////////////////////////////////////////////////////////////////////////
+/// @file bulk_subscribe_token.h
+/// Declaration of MQTT bulk_subscribe_token class
+/// @author Frank Pagliughi
+/////////////////////////////////////////////////////////////////////////////
+
+/*******************************************************************************
+ * Copyright (c) 2025 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+
+#ifndef __mqtt_bulk_subscribe_token_h
+#define __mqtt_bulk_subscribe_token_h
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "mqtt/reason_code.h"
+#include "mqtt/string_collection.h"
+#include "mqtt/token.h"
+
+namespace mqtt {
+
+/////////////////////////////////////////////////////////////////////////////
+
+/**
+ * A token to track a subscription to a large number of topic filters,
+ * sent in chunks.
+ *
+ * This is returned by async_client::subscribe_bulk(). The filters are
+ * split into a number of SUBSCRIBE packets, each with a token of its own,
+ * which are all sent without waiting for the acknowledgments of the
+ * others. This completes when all of them have completed. It succeeds if
+ * they all succeeded, otherwise it fails with the return code of the
+ * first one that failed.
+ *
+ * The reason codes for all of the filters, in order, are available from
+ * get_reason_codes(), whichever chunks they were sent in.
+ */
+class bulk_subscribe_token : public token
+{
+    /** The tokens for the chunks */
+    std::vector<token_ptr> toks_;
+    /** The index of the first filter in each chunk */
+    std::vector<size_t> firsts_;
+    /**
+     * The number of chunks in flight. This is biased by one while they
+     * are being sent, so it can't complete before all are sent.
+     */
+    std::atomic<size_t> nPending_{1};
+    /** The return code of the first failure */
+    std::atomic<int> firstRc_{MQTTASYNC_SUCCESS};
+
+    /** The client has special access */
+    friend class async_client;
+
+    /**
+     * Adds the token for a chunk.
+     * @param tok The token for the chunk.
+     * @param first The index of the first filter in the chunk.
+     */
+    void add(token_ptr tok, size_t first);
+    /**
+     * Called once all the chunks have been sent, to release the bias on the
+     * pending count.
+     */
+    void sent() { on_chunk_complete(nullptr); }
+    /**
+     * Called when the subscribe for a chunk completes.
+     * @param tok The token for the chunk, or null for the release of the
+     *  		  bias.
+     */
+    void on_chunk_complete(const token* tok);
+    /**
+     * Completes the token, once all the chunks are done.
+     */
+    void complete();
+
+public:
+    /** Smart/shared pointer to an object of this class */
+    using ptr_t = std::shared_ptr<bulk_subscribe_token>;
+
+    /**
+     * Creates an empty token for a bulk subscribe.
+     * @param cli The client that the token is associated with.
+     * @param topics The topic filters for the subscribe.
+     */
+    bulk_subscribe_token(iasync_client& cli, const_string_collection_ptr topics)
+        : token{token::Type::SUBSCRIBE, cli, topics} {}
+    /**
+     * Creates an empty token for a bulk subscribe.
+     * @param cli The client that the token is associated with.
+     * @param topics The topic filters for the subscribe.
+     * @param userContext Optional object used to pass context to the
+     *  				  listener. Use @em nullptr if not required.
+     * @param cb Listener that will be notified when all the chunks have
+     *  		 completed.
+     */
+    bulk_subscribe_token(
+        iasync_client& cli, const_string_collection_ptr topics, void* userContext,
+        iaction_listener& cb
+    )
+        : token{token::Type::SUBSCRIBE, cli, topics, userContext, cb} {}
+
+    bulk_subscribe_token(const bulk_subscribe_token&) = delete;
+    bulk_subscribe_token& operator=(const bulk_subscribe_token&) = delete;
+
+    /**
+     * Creates an empty token for a bulk subscribe.
+     * @param cli The client that the token is associated with.
+     * @param topics The topic filters for the subscribe.
+     * @return A smart/shared pointer to the new token.
+     */
+    static ptr_t create(iasync_client& cli, const_string_collection_ptr topics) {
+        return std::make_shared<bulk_subscribe_token>(cli, std::move(topics));
+    }
+    /**
+     * Creates an empty token for a bulk subscribe.
+     * @param cli The client that the token is associated with.
+     * @param topics The topic filters for the subscribe.
+     * @param userContext Optional object used to pass context to the
+     *  				  listener. Use @em nullptr if not required.
+     * @param cb Listener that will be notified when all the chunks have
+     *  		 completed.
+     * @return A smart/shared pointer to the new token.
+     */
+    static ptr_t create(
+        iasync_client& cli, const_string_collection_ptr topics, void* userContext,
+        iaction_listener& cb
+    ) {
+        return std::make_shared<bulk_subscribe_token>(cli, std::move(topics), userContext, cb);
+    }
+    /**
+     * Gets the number of chunks that the filters were sent in.
+     * @return The number of SUBSCRIBE packets.
+     */
+    size_t num_chunks() const { return toks_.size(); }
+    /**
+     * Gets the tokens for the chunks, in the order of the filters.
+     * @return The tokens for the chunks.
+     */
+    const std::vector<token_ptr>& get_tokens() const { return toks_; }
+    /**
+     * Gets the index of the first filter in a chunk.
+     * @param i The index of the chunk.
+     * @return The index, in the collection, of the first filter in the
+     *  	   chunk.
+     */
+    size_t chunk_start(size_t i) const { return firsts_.at(i); }
+    /**
+     * Gets the reason codes for all the filters, in the order of the
+     * collection.
+     *
+     * This waits for the subscribe to complete. On success, the code for
+     * each filter is the QoS that the server granted, as with a single
+     * subscribe, or an MQTT v5 error code of 0x80 or more. The filters in
+     * a chunk that failed as a whole, such as from a lost connection, are
+     * given @ref ReasonCode::UNSPECIFIED_ERROR.
+     *
+     * @return The reason codes for all of the filters.
+     */
+    std::vector<ReasonCode> get_reason_codes() const;
+};
+
+/** Smart/shared pointer to a bulk subscribe token */
+using bulk_subscribe_token_ptr = bulk_subscribe_token::ptr_t;
+
+/////////////////////////////////////////////////////////////////////////////
+}  // namespace mqtt
+
+#endif  // __mqtt_bulk_subscribe_token_h
@@ -72,6 +72,23 @@ public:
      * acknowledgments have been received.
      */
     virtual void delivery_complete(delivery_token_ptr /*tok*/) {}
+    /**
+     * Called with the deliveries that completed since the last call.
+     *
+     * When the callbacks are run on an executor, the completions that
+     * arrive while an earlier notification is still waiting to run are
+     * gathered up and passed together, so that an application can do its
+     * bookkeeping once for each batch, rather than once per message.
+     * Without an executor, each is passed on its own, as it completes.
+     * They are given in the order that they completed.
+     *
+     * The default calls delivery_complete() for each of the tokens.
+     *
+     * @param toks The delivery tokens for the completed messages.
+     */
+    virtual void delivery_complete_batch(const std::vector<delivery_token_ptr>& toks) {
+        for (const auto& tok : toks) delivery_complete(tok);
+    }
 };
 
 /** Smart/shared pointer to a callback object */
@@ -0,0 +1,101 @@
+/////////////////////////////////////////////////////////////////////////////
+/// @file callback_timing.h
+/// Declaration of the MQTT user callback timing points
+/// @author Frank Pagliughi
+/////////////////////////////////////////////////////////////////////////////
+
+/*******************************************************************************
+ * Copyright (c) 2025 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+#ifndef __mqtt_callback_timing_h
+#define __mqtt_callback_timing_h
+
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <string_view>
+
+namespace mqtt {
+
+/////////////////////////////////////////////////////////////////////////////
+
+/**
+ * The kinds of user callbacks that the client can time.
+ */
+enum class callback_point {
+    /** The connected callback or handler */
+    CONNECTED,
+    /** The connection lost callback or handler */
+    CONNECTION_LOST,
+    /** The disconnected handler */
+    DISCONNECTED,
+    /** The message callback, handler, or filter handlers */
+    MESSAGE_ARRIVED,
+    /** The delivery complete callback */
+    DELIVERY_COMPLETE,
+    /** An action listener, or completion handler, for a token */
+    ACTION
+};
+
+/**
+ * Handler type for the user callbacks that are slow.
+ * It receives the kind of callback, what it was for, and how long it took.
+ * What it was for is the topic for a message or delivery, the cause for a
+ * connection callback, or the operation and any topic for an action
+ * listener, like "subscribe data/#". The string is only valid for the
+ * call. It's called from the thread that ran the callback, right after it
+ * returns, so it should be quick, and thread safe.
+ */
+using slow_callback_handler =
+    std::function<void(callback_point, std::string_view what, std::chrono::microseconds)>;
+
+/**
+ * Gets a printable name for a callback point.
+ * @param pt The callback point.
+ * @return The name of the callback point.
+ */
+inline const char* callback_point_name(callback_point pt) noexcept {
+    switch (pt) {
+        case callback_point::CONNECTED:
+            return "CONNECTED";
+        case callback_point::CONNECTION_LOST:
+            return "CONNECTION_LOST";
+        case callback_point::DISCONNECTED:
+            return "DISCONNECTED";
+        case callback_point::MESSAGE_ARRIVED:
+            return "MESSAGE_ARRIVED";
+        case callback_point::DELIVERY_COMPLETE:
+            return "DELIVERY_COMPLETE";
+        case callback_point::ACTION:
+            return "ACTION";
+    }
+    return "UNKNOWN";
+}
+
+/**
+ * Stream inserter for a callback point.
+ * @param os The output stream.
+ * @param pt The callback point.
+ * @return A reference to the output stream.
+ */
+inline std::ostream& operator<<(std::ostream& os, callback_point pt) {
+    return os << callback_point_name(pt);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+}  // namespace mqtt
+
+#endif  // __mqtt_callback_timing_h
@@ -0,0 +1,215 @@
+/////////////////////////////////////////////////////////////////////////////
+/// @file chunk_reassembler.h
+/// Declaration of MQTT chunk_reassembler class
+/// @author Frank Pagliughi
+/////////////////////////////////////////////////////////////////////////////
+
+/*******************************************************************************
+ * Copyright (c) 2025 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+#ifndef __mqtt_chunk_reassembler_h
+#define __mqtt_chunk_reassembler_h
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <unordered_map>
+
+#include "mqtt/message.h"
+
+namespace mqtt {
+
+/////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Puts the chunks of a transfer back together into a single message.
+ *
+ * This is the receiving side of a @ref stream_publisher. Each chunk of a
+ * transfer has MQTT v5 user properties with the ID of the transfer and
+ * the byte offset of the chunk in the data, and the last chunk is marked.
+ * The chunks are collected by topic and transfer ID, and once all of the
+ * data has arrived, it's delivered as one message, with the properties of
+ * the last chunk, less the ones for the transfer.
+ * @par
+ * Each chunk is copied straight into its place in the buffer for the
+ * whole message, which becomes the payload without another copy. When
+ * the chunks carry the total size, the buffer is allocated once, on the
+ * first chunk, otherwise it grows as they arrive. Chunks can arrive in
+ * any order, and a repeated chunk is ignored.
+ * @par
+ * The memory held for incomplete transfers is bounded. When a transfer
+ * needs more than is left, the ones that were idle longest are dropped to
+ * make room, and a transfer bigger than the whole limit is dropped. A
+ * transfer that gets no chunks for the timeout is dropped too. Messages
+ * without a transfer ID pass through untouched.
+ * @par
+ * When given to a client in the create options, the client passes each
+ * message that it receives through the reassembler, and only the whole
+ * messages reach the consumer and the handlers. It is safe to use from
+ * any thread.
+ */
+class chunk_reassembler
+{
+public:
+    /** Smart/shared pointer to an object of this class. */
+    using ptr_t = std::shared_ptr<chunk_reassembler>;
+    /** The clock for the timeout */
+    using clock = std::chrono::steady_clock;
+
+    /** The default for the most memory held for incomplete transfers */
+    static constexpr size_t DFLT_MAX_BYTES = 256 * 1024 * 1024;
+    /** The default time that an incomplete transfer is kept without chunks */
+    static constexpr std::chrono::seconds DFLT_TIMEOUT{60};
+
+private:
+    /** A transfer in progress */
+    struct transfer
+    {
+        /** The data, with the chunks in place */
+        binary buf;
+        /** The memory charged for the buffer */
+        size_t charged{0};
+        /** The offsets of the chunks that arrived */
+        std::set<uint64_t> offsets;
+        /** The number of bytes that arrived */
+        uint64_t received{0};
+        /** The total size of the data, if it's known yet */
+        uint64_t total{0};
+        /** Whether the total size is known */
+        bool haveTotal{false};
+        /** The time that the last chunk arrived */
+        clock::time_point lastTime;
+    };
+
+    /** Lock for the transfers */
+    mutable std::mutex lock_;
+    /** The transfers in progress, by topic and ID */
+    std::unordered_map<string, transfer> xfers_;
+    /** The most memory held for incomplete transfers */
+    size_t maxBytes_;
+    /** How long a transfer is kept without chunks, or zero for no limit */
+    clock::duration timeout_;
+    /** The memory held for incomplete transfers */
+    size_t bytes_{0};
+    /** The number of transfers completed */
+    uint64_t nCompleted_{0};
+    /** The number of transfers dropped */
+    uint64_t nDropped_{0};
+
+    /** Drops a transfer (unsafe) */
+    void drop(std::unordered_map<string, transfer>::iterator it);
+    /** Drops the transfers that timed out (unsafe) */
+    size_t expire(clock::time_point now);
+    /**
+     * Makes room for more data, by dropping the transfers idle the
+     * longest, other than the one that needs the room (unsafe).
+     * @return @em true if there is room.
+     */
+    bool make_room(size_t n, const transfer* keep);
+
+public:
+    /**
+     * Creates a reassembler.
+     * @param maxBytes The most memory to hold for incomplete transfers.
+     * @param timeout How long to keep a transfer that gets no chunks. If
+     *  			  this is zero, transfers are only dropped to make
+     *  			  room.
+     */
+    explicit chunk_reassembler(
+        size_t maxBytes = DFLT_MAX_BYTES, clock::duration timeout = DFLT_TIMEOUT
+    )
+        : maxBytes_{maxBytes}, timeout_{timeout} {}
+    /**
+     * Creates a reassembler.
+     * @param maxBytes The most memory to hold for incomplete transfers.
+     * @param timeout How long to keep a transfer that gets no chunks, or
+     *  			  zero for no limit.
+     * @return A shared pointer to the new reassembler.
+     */
+    static ptr_t create(size_t maxBytes = DFLT_MAX_BYTES, clock::duration timeout = DFLT_TIMEOUT) {
+        return std::make_shared<chunk_reassembler>(maxBytes, timeout);
+    }
+    /**
+     * Adds a message that was received.
+     * @param msg The message.
+     * @return The message itself if it isn't a chunk, the whole message
+     *  	   if this chunk completed it, or null if the transfer isn't
+     *  	   complete yet or the chunk was dropped.
+     */
+    message_ptr add(message_ptr msg);
+    /**
+     * Drops the transfers that got no chunks for the timeout.
+     * This is also done as each chunk arrives.
+     * @return The number of transfers dropped.
+     */
+    size_t expire();
+    /**
+     * Gets the number of transfers in progress.
+     * @return The number of incomplete transfers.
+     */
+    size_t pending() const {
+        std::lock_guard<std::mutex> g{lock_};
+        return xfers_.size();
+    }
+    /**
+     * Gets the memory held for incomplete transfers.
+     * @return The size of the buffers for the incomplete transfers.
+     */
+    size_t bytes() const {
+        std::lock_guard<std::mutex> g{lock_};
+        return bytes_;
+    }
+    /**
+     * Gets the most memory held for incomplete transfers.
+     * @return The most memory held for incomplete transfers, in bytes.
+     */
+    size_t max_bytes() const { return maxBytes_; }
+    /**
+     * Gets how long a transfer is kept without chunks.
+     * @return The timeout, or zero for no limit.
+     */
+    clock::duration timeout() const { return timeout_; }
+    /**
+     * Gets the number of transfers that were completed.
+     * @return The number of transfers completed.
+     */
+    uint64_t completed() const {
+        std::lock_guard<std::mutex> g{lock_};
+        return nCompleted_;
+    }
+    /**
+     * Gets the number of transfers that were dropped, for time or memory.
+     * @return The number of transfers dropped.
+     */
+    uint64_t dropped() const {
+        std::lock_guard<std::mutex> g{lock_};
+        return nDropped_;
+    }
+    /**
+     * Drops all of the transfers in progress.
+     */
+    void clear();
+};
+
+/** Smart/shared pointer to a chunk reassembler */
+using chunk_reassembler_ptr = chunk_reassembler::ptr_t;
+
+/////////////////////////////////////////////////////////////////////////////
+}  // namespace mqtt
+
+#endif  // __mqtt_chunk_reassembler_h
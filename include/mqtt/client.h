@@ -24,7 +24,10 @@
 #ifndef __mqtt_client_h
 #define __mqtt_client_h
 
+#include <functional>
 #include <future>
+#include <memory>
+#include <thread>
 
 #include "mqtt/async_client.h"
 
@@ -43,6 +46,36 @@ class client : private callback
     /** The default quality of service */
     PAHO_MQTTPP_EXPORT static const int DFLT_QOS;  // =1;
 
+    /**
+     * A long-lived thread to run user callbacks off of the library's
+     * thread, so that they can call back into the client without
+     * deadlocking it. The caller waits for each callback to finish.
+     */
+    class callback_thread
+    {
+        /** The callbacks waiting to run */
+        thread_queue<std::function<void()>> que_;
+        /** The thread to run them */
+        std::thread thr_;
+
+    public:
+        /** Starts the thread */
+        callback_thread();
+        /** Stops the thread, after running any queued callbacks */
+        ~callback_thread();
+        /**
+         * Runs a function on the thread, blocking until it completes.
+         * If called from the thread itself, it is run directly.
+         * @param fn The function to run.
+         */
+        void run(std::function<void()> fn);
+    };
+
+    /**
+     * The thread for user callbacks. This is created with the user
+     * callback, and declared before the client so that it outlives it.
+     */
+    std::unique_ptr<callback_thread> cbThread_;
     /** The actual client */
     async_client cli_;
     /** The longest time to wait for an operation to complete.  */
@@ -66,21 +99,22 @@ class client : private callback
     }
 
     // User callbacks
-    // Most are launched in a separate thread, for convenience, except
+    // Most are run on the callback thread, for convenience, except
     // message_arrived, for performance.
     void connected(const string& cause) override {
-        std::async(std::launch::async, &callback::connected, userCallback_, cause).wait();
+        cbThread_->run([this, &cause] { userCallback_->connected(cause); });
     }
     void connection_lost(const string& cause) override {
-        std::async(std::launch::async, &callback::connection_lost, userCallback_, cause)
-            .wait();
+        cbThread_->run([this, &cause] { userCallback_->connection_lost(cause); });
     }
     void message_arrived(const_message_ptr msg) override {
         userCallback_->message_arrived(msg);
     }
     void delivery_complete(delivery_token_ptr tok) override {
-        std::async(std::launch::async, &callback::delivery_complete, userCallback_, tok)
-            .wait();
+        cbThread_->run([this, &tok] { userCallback_->delivery_complete(tok); });
+    }
+    void delivery_complete_batch(const std::vector<delivery_token_ptr>& toks) override {
+        cbThread_->run([this, &toks] { userCallback_->delivery_complete_batch(toks); });
     }
 
     /** Non-copyable */
@@ -276,6 +310,21 @@ public:
      * @param msg The message
      */
     virtual void publish(const message& msg) { cli_.publish(ptr(msg))->wait(); }
+    /**
+     * Publishes a number of messages and returns once they are all
+     * delivered.
+     * This hands all the messages to the underlying async client before
+     * waiting, so they are pipelined to the server rather than each one
+     * waiting for the acknowledgment of the one before it. The timeout is
+     * for the whole set of messages.
+     * @param msgs The messages to publish.
+     * @throw timeout_error if the messages were not all delivered in time.
+     * @throw exception with the error of the first message that failed.
+     */
+    virtual void publish_many(const std::vector<const_message_ptr>& msgs) {
+        if (!cli_.publish_batch(msgs)->wait_for(timeout_))
+            throw timeout_error();
+    }
     /**
      * Sets the callback listener to use for events that happen
      * asynchronously.
@@ -418,6 +467,64 @@ maked      * @param props The MQTT v5 properties.
     ) {
         return cli_.try_consume_message_until(msg, absTime);
     }
+    /**
+     * Try to read a number of messages from the queue without blocking.
+     *
+     * This removes up to the specified number of events from the consumer
+     * queue at once, which is considerably more efficient than reading
+     * them individually when messages are arriving at a high rate. As with
+     * consume_message(), the 'connected' events are skipped.
+     *
+     * @param msgs The vector to receive the messages. They are appended to
+     *  		   any items already in the vector.
+     * @param maxMsgs The maximum number of events to remove from the queue.
+     * @return The number of events removed from the queue, which includes
+     *  	   any connected events that were skipped. It's zero only if
+     *  	   the queue was empty.
+     */
+    size_t try_consume_messages(std::vector<const_message_ptr>& msgs, size_t maxMsgs) {
+        return cli_.try_consume_messages(msgs, maxMsgs);
+    }
+    /**
+     * Reads a number of messages from the queue, waiting a limited time
+     * for the first one to arrive.
+     *
+     * Once a message arrives, this removes up to the specified number of
+     * events from the queue at once, in the same manner as
+     * try_consume_messages().
+     *
+     * @param msgs The vector to receive the messages. They are appended to
+     *  		   any items already in the vector.
+     * @param maxMsgs The maximum number of events to remove from the queue.
+     * @param relTime The maximum amount of time to wait for a message.
+     * @return The number of events removed from the queue, which includes
+     *  	   any connected events that were skipped. It's zero only on a
+     *  	   timeout.
+     */
+    template <typename Rep, class Period>
+    size_t consume_messages(
+        std::vector<const_message_ptr>& msgs, size_t maxMsgs,
+        const std::chrono::duration<Rep, Period>& relTime
+    ) {
+        return cli_.consume_messages(msgs, maxMsgs, relTime);
+    }
+    /**
+     * Reads a number of messages from the queue, waiting a limited time
+     * for the first one to arrive.
+     * @param maxMsgs The maximum number of events to remove from the queue.
+     * @param relTime The maximum amount of time to wait for a message.
+     * @return The messages that were read. This is empty on a timeout, but
+     *  	   also if only connected events were read. Use the overload
+     *  	   that takes a vector to tell them apart.
+     */
+    template <typename Rep, class Period>
+    std::vector<const_message_ptr> consume_messages(
+        size_t maxMsgs, const std::chrono::duration<Rep, Period>& relTime
+    ) {
+        std::vector<const_message_ptr> msgs;
+        cli_.consume_messages(msgs, maxMsgs, relTime);
+        return msgs;
+    }
 };
 
 /** Smart/shared pointer to an MQTT synchronous client object */
@@ -0,0 +1,398 @@
+/////////////////////////////////////////////////////////////////////////////
+/// @file client_pool.h
+/// Declaration of MQTT client_pool and pool_token classes
+/// @author Frank Pagliughi
+/////////////////////////////////////////////////////////////////////////////
+
+/*******************************************************************************
+ * Copyright (c) 2025 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+#ifndef __mqtt_client_pool_h
+#define __mqtt_client_pool_h
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+#include "mqtt/async_client.h"
+#include "mqtt/client_stats.h"
+#include "mqtt/token.h"
+
+namespace mqtt {
+
+/////////////////////////////////////////////////////////////////////////////
+
+/**
+ * A token to track an operation done on all the clients of a pool.
+ *
+ * This is returned by the client_pool for operations like connect and
+ * disconnect. It completes when the operation has completed on every
+ * client. It succeeds if they all succeeded, otherwise it fails with the
+ * return code of the first one that failed. The tokens for the individual
+ * clients are available from it.
+ */
+class pool_token : public token
+{
+    /** The tokens for the individual clients */
+    std::vector<token_ptr> toks_;
+    /**
+     * The number of operations in progress. This is biased by one while
+     * they are being started, so it can't complete before all are added.
+     */
+    std::atomic<size_t> nPending_{1};
+    /** The return code of the first failure */
+    std::atomic<int> firstRc_{MQTTASYNC_SUCCESS};
+
+    /** The pool has special access */
+    friend class client_pool;
+
+    /**
+     * Adds the token for one of the clients to the group.
+     * @param tok The token for the client's operation.
+     */
+    void add(token_ptr tok);
+    /**
+     * Called once all the operations have been started, to release the
+     * bias on the pending count.
+     */
+    void started() { on_member_complete(nullptr); }
+    /**
+     * Called when the operation for one client completes.
+     * @param tok The token for the client's operation, or null for the
+     *  		  release of the bias.
+     */
+    void on_member_complete(const token* tok);
+    /**
+     * Completes the pool token, once all the operations are done.
+     */
+    void complete();
+
+public:
+    /** Smart/shared pointer to an object of this class */
+    using ptr_t = std::shared_ptr<pool_token>;
+
+    /**
+     * Creates an empty pool token.
+     * @param typ The type of the operation.
+     * @param cli The client that the token is associated with.
+     */
+    pool_token(Type typ, iasync_client& cli) : token{typ, cli} {}
+
+    pool_token(const pool_token&) = delete;
+    pool_token& operator=(const pool_token&) = delete;
+
+    /**
+     * Creates an empty pool token.
+     * @param typ The type of the operation.
+     * @param cli The client that the token is associated with.
+     * @return A smart/shared pointer to the new token.
+     */
+    static ptr_t create(Type typ, iasync_client& cli) {
+        return std::make_shared<pool_token>(typ, cli);
+    }
+    /**
+     * Gets the number of clients in the operation.
+     * @return The number of clients in the operation.
+     */
+    size_t size() const { return toks_.size(); }
+    /**
+     * Gets the tokens for the individual clients.
+     * These are in the same order as the clients in the pool.
+     * @return The tokens for the individual clients.
+     */
+    const std::vector<token_ptr>& get_tokens() const { return toks_; }
+};
+
+/** Smart/shared pointer to a pool token */
+using pool_token_ptr = pool_token::ptr_t;
+
+/////////////////////////////////////////////////////////////////////////////
+
+/**
+ * A pool of client connections to the same server, for publishing.
+ *
+ * A single client sends all of its messages over one connection, through
+ * one thread in the C library, which limits the rate that it can publish.
+ * The pool spreads the messages over a number of clients, each with its
+ * own connection.
+ * @par
+ * The clients are all made from the same create options, with client IDs
+ * made by adding the index of each client to a common prefix, like
+ * "prefix-0", "prefix-1", and so on. A message is sent by the client
+ * chosen by a hash of its topic, so all the messages for a topic go out
+ * over the same connection, in the order that they were published.
+ * @par
+ * The pool is intended for publishing. Subscribing through more than one
+ * of the clients would deliver the same messages more than once, but each
+ * client can be reached through get_client() for anything not covered by
+ * the pool.
+ * @par
+ * A pool can also be used to simulate a large number of devices, such as
+ * to load-test a server. The C library runs all the clients in a process
+ * on the same few threads, so a client is mostly the memory for its
+ * state. To keep them light, create them without persistence and without
+ * an offline buffer, which gives each client a thread of its own, and
+ * start the connections at a limited rate with connect(opts, rate). See
+ * the client_sim example.
+ */
+class client_pool
+{
+    /** The clients in the pool */
+    std::vector<std::unique_ptr<async_client>> clis_;
+
+public:
+    /** Smart/shared pointer to an object of this class */
+    using ptr_t = std::shared_ptr<client_pool>;
+
+    /**
+     * Creates a pool of clients.
+     * @param opts The create options for the clients. The client ID in the
+     *  		   options is used as the prefix for the IDs of the
+     *  		   clients. If it is empty, the clients have empty IDs,
+     *  		   for the server to assign.
+     * @param n The number of clients in the pool.
+     * @throw std::invalid_argument if the number of clients is zero.
+     */
+    client_pool(const create_options& opts, size_t n);
+    /**
+     * Creates a pool of clients.
+     * @param serverURI The address of the server.
+     * @param clientIdPrefix The prefix for the IDs of the clients.
+     * @param n The number of clients in the pool.
+     * @param persistence The persistence for the clients.
+     * @throw std::invalid_argument if the number of clients is zero.
+     */
+    client_pool(
+        const string& serverURI, const string& clientIdPrefix, size_t n,
+        const persistence_type& persistence = NO_PERSISTENCE
+    )
+        : client_pool(create_options{serverURI, clientIdPrefix, persistence}, n) {}
+
+    client_pool(const client_pool&) = delete;
+    client_pool& operator=(const client_pool&) = delete;
+
+    /**
+     * Makes the ID for one of the clients in a pool.
+     * @param prefix The prefix for the IDs.
+     * @param idx The index of the client in the pool.
+     * @return The client ID, or an empty string if the prefix is empty.
+     */
+    static string make_client_id(const string& prefix, size_t idx);
+    /**
+     * Gets the number of clients in the pool.
+     * @return The number of clients in the pool.
+     */
+    size_t size() const { return clis_.size(); }
+    /**
+     * Gets one of the clients in the pool.
+     * @param idx The index of the client.
+     * @return A reference to the client.
+     * @throw std::out_of_range if the index is past the end of the pool.
+     */
+    async_client& get_client(size_t idx) { return *clis_.at(idx); }
+    /**
+     * Gets one of the clients in the pool.
+     * @param idx The index of the client.
+     * @return A reference to the client.
+     * @throw std::out_of_range if the index is past the end of the pool.
+     */
+    const async_client& get_client(size_t idx) const { return *clis_.at(idx); }
+    /**
+     * Gets the index of the client that publishes for a topic.
+     * @param topic The topic.
+     * @return The index of the client that publishes for the topic.
+     */
+    size_t index_for(std::string_view topic) const {
+        return std::hash<std::string_view>{}(topic) % clis_.size();
+    }
+    /**
+     * Gets the client that publishes for a topic.
+     * @param topic The topic.
+     * @return A reference to the client that publishes for the topic.
+     */
+    async_client& client_for(std::string_view topic) { return *clis_[index_for(topic)]; }
+    /**
+     * Gets the index of the connected client with the lowest round trip
+     * time to its server.
+     * This relies on the clients measuring their round trip times, with
+     * start_rtt_probe(). A client that hasn't measured one yet is only
+     * picked if none of the others has either.
+     * @return The index of the client with the lowest round trip time, or
+     *  	   of the first connected client if none were measured, or zero
+     *  	   if none are connected.
+     */
+    size_t index_lowest_rtt() const;
+    /**
+     * Gets the connected client with the lowest round trip time to its
+     * server.
+     * @return A reference to the client with the lowest round trip time.
+     * @see index_lowest_rtt()
+     */
+    async_client& lowest_rtt_client() { return *clis_[index_lowest_rtt()]; }
+    /**
+     * Starts all the clients measuring the round trip times to their
+     * servers.
+     * @param interval The time between the probes.
+     * @param topic The topic for the probes. If this is empty, each client
+     *  			uses "paho/rtt/<client ID>".
+     * @see async_client::start_rtt_probe()
+     */
+    void start_rtt_probe(std::chrono::milliseconds interval, const string& topic = string{}) {
+        for (auto& cli : clis_) cli->start_rtt_probe(interval, topic);
+    }
+    /**
+     * Stops all the clients measuring the round trip times to their
+     * servers.
+     */
+    void stop_rtt_probe() {
+        for (auto& cli : clis_) cli->stop_rtt_probe();
+    }
+    /**
+     * Connects all the clients to the server.
+     * @return A token that completes when all the clients have connected.
+     */
+    pool_token_ptr connect() { return connect(connect_options{}); }
+    /**
+     * Connects all the clients to the server.
+     * @param opts The connect options, used for all of the clients.
+     * @return A token that completes when all the clients have connected.
+     */
+    pool_token_ptr connect(const connect_options& opts);
+    /**
+     * Connects all the clients to the server, at a limited rate.
+     *
+     * This starts the connections one at a time, spaced out to the given
+     * rate, so that a large pool doesn't hit the server with all of its
+     * connections and TLS handshakes at once. It blocks the caller until
+     * all the connections are started, but returns without waiting for
+     * them to complete.
+     *
+     * @param opts The connect options, used for all of the clients.
+     * @param rate The maximum number of connections to start per second.
+     *  		   If this is zero, they are all started at once.
+     * @return A token that completes when all the clients have connected.
+     */
+    pool_token_ptr connect(const connect_options& opts, double rate);
+    /**
+     * Determines if all the clients are connected.
+     * @return @em true if every client in the pool is connected.
+     */
+    bool is_connected() const;
+    /**
+     * Disconnects all the clients from the server.
+     * @return A token that completes when all the clients have
+     *  	   disconnected.
+     */
+    pool_token_ptr disconnect() { return disconnect(disconnect_options{}); }
+    /**
+     * Disconnects all the clients from the server.
+     * @param opts The disconnect options, used for all of the clients.
+     * @return A token that completes when all the clients have
+     *  	   disconnected.
+     */
+    pool_token_ptr disconnect(const disconnect_options& opts);
+    /**
+     * Publishes a message, with the client for its topic.
+     * @param msg The message to deliver to the server.
+     * @return The token from the client to track the delivery.
+     */
+    delivery_token_ptr publish(const_message_ptr msg) {
+        return client_for(msg->get_topic()).publish(std::move(msg));
+    }
+    /**
+     * Publishes a message, with the client for its topic.
+     * @param msg The message to deliver to the server.
+     * @param userContext Optional object used to pass context to the
+     *  				  callback. Use @em nullptr if not required.
+     * @param cb Listener that will be notified when message delivery has
+     *  		 completed.
+     * @return The token from the client to track the delivery.
+     */
+    delivery_token_ptr publish(const_message_ptr msg, void* userContext, iaction_listener& cb) {
+        return client_for(msg->get_topic()).publish(std::move(msg), userContext, cb);
+    }
+    /**
+     * Publishes a message, with the client for its topic.
+     * @param topic The topic to deliver the message to.
+     * @param payload The bytes to use as the message payload.
+     * @param n The number of bytes in the payload.
+     * @param qos The quality of service to deliver the message.
+     * @param retained Whether the message should be retained by the server.
+     * @return The token from the client to track the delivery.
+     */
+    delivery_token_ptr publish(
+        string_ref topic, const void* payload, size_t n, int qos, bool retained
+    ) {
+        return publish(make_message(std::move(topic), payload, n, qos, retained));
+    }
+    /**
+     * Publishes a message, with the client for its topic, using the
+     * default QoS and retained flag.
+     * @param topic The topic to deliver the message to.
+     * @param payload The bytes to use as the message payload.
+     * @param n The number of bytes in the payload.
+     * @return The token from the client to track the delivery.
+     */
+    delivery_token_ptr publish(string_ref topic, const void* payload, size_t n) {
+        return publish(make_message(std::move(topic), payload, n));
+    }
+    /**
+     * Publishes a message, with the client for its topic.
+     * @param topic The topic to deliver the message to.
+     * @param payload The message payload.
+     * @param qos The quality of service to deliver the message.
+     * @param retained Whether the message should be retained by the server.
+     * @return The token from the client to track the delivery.
+     */
+    delivery_token_ptr publish(string_ref topic, binary_ref payload, int qos, bool retained) {
+        return publish(make_message(std::move(topic), std::move(payload), qos, retained));
+    }
+    /**
+     * Publishes a message, with the client for its topic, using the
+     * default QoS and retained flag.
+     * @param topic The topic to deliver the message to.
+     * @param payload The message payload.
+     * @return The token from the client to track the delivery.
+     */
+    delivery_token_ptr publish(string_ref topic, binary_ref payload) {
+        return publish(make_message(std::move(topic), std::move(payload)));
+    }
+    /**
+     * Gets the delivery tokens for the messages that are pending on all
+     * the clients.
+     * @return The delivery tokens for all of the pending messages.
+     */
+    std::vector<delivery_token_ptr> get_pending_delivery_tokens() const;
+    /**
+     * Gets a snapshot of the activity of all the clients.
+     * The counts are the totals for the clients, and the consumer queue
+     * high-water mark is the highest of them. The memory high-water mark
+     * is the total of those of the clients, which is an upper bound for
+     * the pool, since they may not have peaked together. The latency
+     * percentiles can't be combined exactly from those of each client, so
+     * they, and the average round trip time, are the highest of the
+     * clients, also an upper bound.
+     * @return The statistics for the pool.
+     */
+    client_stats get_stats() const;
+};
+
+/////////////////////////////////////////////////////////////////////////////
+}  // namespace mqtt
+
+#endif  // __mqtt_client_pool_h
@@ -0,0 +1,228 @@
+/////////////////////////////////////////////////////////////////////////////
+/// @file client_stats.h
+/// Declaration of MQTT client_stats and latency_histogram classes
+/// @author Frank Pagliughi
+/////////////////////////////////////////////////////////////////////////////
+
+/*******************************************************************************
+ * Copyright (c) 2025 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+#ifndef __mqtt_client_stats_h
+#define __mqtt_client_stats_h
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "mqtt/topic_stats.h"
+
+namespace mqtt {
+
+/////////////////////////////////////////////////////////////////////////////
+
+/**
+ * A histogram of latencies that can be updated from any thread.
+ *
+ * The values are kept in microseconds, in buckets that are linear within
+ * each power of two, so that a value is reported to within about 3% with
+ * a fixed amount of memory. Recording a value is an increment of a relaxed
+ * atomic counter, without locks or allocations, so it can be done on the
+ * hot path. Reading the percentiles while values are being recorded gives
+ * a close approximation.
+ *
+ * Latencies over about 19 hours are counted in the highest bucket.
+ */
+class latency_histogram
+{
+    /** The number of bits of precision in each power of two */
+    static constexpr int SUB_BITS = 5;
+    /** The number of buckets for each power of two */
+    static constexpr size_t SUB_COUNT = size_t(1) << SUB_BITS;
+    /** The number of bits in the largest value, in microseconds */
+    static constexpr int MAX_BITS = 36;
+    /** The total number of buckets */
+    static constexpr size_t N_BUCKETS = (MAX_BITS - SUB_BITS + 1) * SUB_COUNT;
+
+    /** The counts for each bucket */
+    std::atomic<uint64_t> counts_[N_BUCKETS];
+    /** The total number of values */
+    std::atomic<uint64_t> total_{0};
+    /** The largest value, in microseconds */
+    std::atomic<uint64_t> max_{0};
+
+    /** Gets the bucket for a value */
+    static size_t index_of(uint64_t us);
+    /** Gets the largest value that lands in a bucket */
+    static uint64_t value_of(size_t idx);
+
+public:
+    /** The type for the values */
+    using duration = std::chrono::microseconds;
+
+    /**
+     * Creates an empty histogram.
+     */
+    latency_histogram() { clear(); }
+
+    latency_histogram(const latency_histogram&) = delete;
+    latency_histogram& operator=(const latency_histogram&) = delete;
+    /**
+     * Records a value.
+     * @param d The latency.
+     */
+    template <typename Rep, class Period>
+    void record(const std::chrono::duration<Rep, Period>& d) {
+        auto us = std::chrono::duration_cast<duration>(d).count();
+        record_us((us < 0) ? uint64_t(0) : uint64_t(us));
+    }
+    /**
+     * Records a value.
+     * @param us The latency, in microseconds.
+     */
+    void record_us(uint64_t us);
+    /**
+     * Gets the number of values recorded.
+     * @return The number of values recorded.
+     */
+    uint64_t count() const { return total_.load(std::memory_order_relaxed); }
+    /**
+     * Gets the largest value recorded.
+     * @return The largest value recorded, or zero if there are none.
+     */
+    duration max() const { return duration(max_.load(std::memory_order_relaxed)); }
+    /**
+     * Gets the value at a percentile.
+     * @param pct The percentile, from 0 to 100, like 99.9
+     * @return The value at or below which the percentage of the recorded
+     *  	   values fall, or zero if there are none.
+     */
+    duration percentile(double pct) const;
+    /**
+     * Removes all the values.
+     * This should not be called while values are being recorded.
+     */
+    void clear();
+};
+
+/////////////////////////////////////////////////////////////////////////////
+
+/**
+ * A snapshot of the activity of a client.
+ *
+ * This is returned by `async_client::get_stats()`. The counts are from
+ * the time that the client was created.
+ */
+struct client_stats
+{
+    /** The number of messages sent to the C library for publishing */
+    uint64_t msgsPublished{0};
+    /** The number of bytes published, counting the topics and payloads */
+    uint64_t bytesPublished{0};
+    /** The number of QoS 1 and 2 messages acknowledged by the server */
+    uint64_t msgsAcked{0};
+    /** The number of messages received */
+    uint64_t msgsReceived{0};
+    /** The number of bytes received, counting the topics and payloads */
+    uint64_t bytesReceived{0};
+    /** The number of delivery tokens that are waiting to complete */
+    size_t pendingDeliveryTokens{0};
+    /** The bytes of memory held by the messages pending delivery */
+    size_t pendingDeliveryBytes{0};
+    /** How long the oldest message pending delivery has been waiting */
+    std::chrono::microseconds oldestPendingDelivery{0};
+    /** The number of events in the consumer queue */
+    size_t consumerQueueSize{0};
+    /**
+     * The bytes of memory held by the messages in the consumer queue.
+     * This is only counted when the client has a memory limit.
+     */
+    size_t consumerQueueBytes{0};
+    /** The most events that were ever in the consumer queue */
+    size_t consumerQueueHighWater{0};
+    /** The number of incoming messages dropped because the queue was full */
+    uint64_t msgsDropped{0};
+    /** The number of incoming messages dropped as duplicates */
+    uint64_t msgsDuplicated{0};
+    /** The sequence numbers skipped in the incoming messages */
+    uint64_t seqGaps{0};
+    /** The incoming messages that repeated a sequence number */
+    uint64_t seqDuplicates{0};
+    /** The incoming messages that arrived out of sequence */
+    uint64_t seqOutOfOrder{0};
+    /** The number of fire-and-forget publishes that failed to be sent */
+    uint64_t publishErrors{0};
+    /** The QoS 1 & 2 messages sent to the server and not yet acknowledged */
+    size_t msgsInFlight{0};
+    /** The QoS 1 & 2 messages held back by the server's receive maximum */
+    size_t msgsDeferred{0};
+    /** The messages waiting in the offline buffer, in memory and on disk */
+    size_t offlineBuffered{0};
+    /** The bytes of messages held in memory by the offline buffer */
+    size_t offlineBufferBytes{0};
+    /** The messages in the offline buffer that spilled to disk */
+    size_t offlineSpilled{0};
+    /** The bytes of memory held for messages, counted against the budget */
+    size_t memoryUsed{0};
+    /** The most bytes of memory that were ever held for messages */
+    size_t memoryHighWater{0};
+    /** The number of times the client was connected again, after the first */
+    uint64_t reconnects{0};
+    /** The median time from publish to acknowledgment */
+    std::chrono::microseconds ackLatencyP50{0};
+    /** The 99th percentile time from publish to acknowledgment */
+    std::chrono::microseconds ackLatencyP99{0};
+    /** The 99.9th percentile time from publish to acknowledgment */
+    std::chrono::microseconds ackLatencyP999{0};
+    /** The longest time from publish to acknowledgment */
+    std::chrono::microseconds ackLatencyMax{0};
+    /** The number of user callbacks that were timed */
+    uint64_t callbacksTimed{0};
+    /** The number of timed user callbacks that were over the threshold */
+    uint64_t slowCallbacks{0};
+    /** The median time taken by a user callback */
+    std::chrono::microseconds callbackTimeP50{0};
+    /** The 99th percentile time taken by a user callback */
+    std::chrono::microseconds callbackTimeP99{0};
+    /** The longest time taken by a user callback */
+    std::chrono::microseconds callbackTimeMax{0};
+    /** The number of round trips timed by the RTT probe */
+    uint64_t rttProbes{0};
+    /** The moving average of the round trip time to the server */
+    std::chrono::microseconds rttAverage{0};
+    /** The median round trip time to the server */
+    std::chrono::microseconds rttP50{0};
+    /** The 99th percentile round trip time to the server */
+    std::chrono::microseconds rttP99{0};
+    /** The longest round trip time to the server */
+    std::chrono::microseconds rttMax{0};
+    /** The outgoing messages the publish shaper delayed or held */
+    uint64_t shapedDelayed{0};
+    /** The held outgoing messages replaced by later ones for the topic */
+    uint64_t shapedCoalesced{0};
+    /** The outgoing messages the publish shaper dropped */
+    uint64_t shapedDropped{0};
+    /** The incoming messages the message sampler dropped */
+    uint64_t msgsSampledOut{0};
+    /** The traffic for each filter of the topic counters, if any */
+    std::vector<topic_traffic> topicTraffic;
+};
+
+/////////////////////////////////////////////////////////////////////////////
+}  // namespace mqtt
+
+#endif  // __mqtt_client_stats_h
@@ -0,0 +1,308 @@
+/////////////////////////////////////////////////////////////////////////////
+/// @file coalescing_publisher.h
+/// Declaration of MQTT coalescing_publisher and record_batch classes
+/// @author Frank Pagliughi
+/////////////////////////////////////////////////////////////////////////////
+
+/*******************************************************************************
+ * Copyright (c) 2025 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+#ifndef __mqtt_coalescing_publisher_h
+#define __mqtt_coalescing_publisher_h
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <iterator>
+#include <map>
+#include <mutex>
+#include <thread>
+
+#include "mqtt/async_client.h"
+#include "mqtt/buffer_view.h"
+
+namespace mqtt {
+
+/////////////////////////////////////////////////////////////////////////////
+
+/**
+ * A read-only view of the records packed into a payload by a
+ * @ref coalescing_publisher.
+ *
+ * Each record in the payload is prefixed by its length, as an MQTT
+ * variable byte integer, which is a single byte for a record of up to 127
+ * bytes. The records are returned as views into the payload, so they
+ * aren't copied, and are only valid for as long as this object. The
+ * framing is checked when the batch is made, so iterating over it can't
+ * fail.
+ *
+ * @code
+ *     for (const auto& rec : mqtt::record_batch{msg->get_payload_ref()})
+ *         handle_reading(rec);
+ * @endcode
+ */
+class record_batch
+{
+    /** The payload with the records */
+    binary_ref payload_;
+    /** The number of records */
+    size_t n_{0};
+
+public:
+    /** The longest record, the most a variable byte integer can hold */
+    static constexpr size_t MAX_RECORD_SIZE = 268'435'455;
+
+    /**
+     * Iterator over the records in a batch.
+     */
+    class const_iterator
+    {
+        /** The position of the next length prefix */
+        const char* pos_{nullptr};
+        /** The end of the payload */
+        const char* end_{nullptr};
+        /** The current record, with a null pointer at the end */
+        binary_view rec_{nullptr, 0};
+
+        friend class record_batch;
+        /** Creates an iterator at the record starting at a position */
+        const_iterator(const char* pos, const char* end);
+
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = binary_view;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const binary_view*;
+        using reference = const binary_view&;
+
+        /** Creates an end iterator */
+        const_iterator() {}
+        /** Gets the current record */
+        reference operator*() const { return rec_; }
+        /** Gets a pointer to the current record */
+        pointer operator->() const { return &rec_; }
+        /** Moves to the next record */
+        const_iterator& operator++() {
+            *this = const_iterator{pos_, end_};
+            return *this;
+        }
+        /** Moves to the next record */
+        const_iterator operator++(int) {
+            auto tmp = *this;
+            ++(*this);
+            return tmp;
+        }
+        /** Compares two iterators */
+        bool operator==(const const_iterator& rhs) const {
+            return rec_.data() == rhs.rec_.data();
+        }
+        /** Compares two iterators */
+        bool operator!=(const const_iterator& rhs) const { return !(*this == rhs); }
+    };
+
+    /**
+     * Creates a view of the records in a payload.
+     * @param payload The payload with the records.
+     * @throw exception if the payload isn't a valid batch of records.
+     */
+    explicit record_batch(binary_ref payload);
+    /**
+     * Creates a view of the records in the payload of a message.
+     * @param msg The message.
+     * @throw exception if the payload isn't a valid batch of records.
+     */
+    explicit record_batch(const message& msg) : record_batch{msg.get_payload_ref()} {}
+    /**
+     * Adds a record to the end of a payload, with its length prefix.
+     * @param buf The payload to add to.
+     * @param data The record.
+     * @param n The size of the record, in bytes.
+     * @throw std::invalid_argument if the record is larger than
+     *  	  @ref MAX_RECORD_SIZE.
+     */
+    static void append(binary& buf, const void* data, size_t n);
+    /**
+     * Gets the number of records in the batch.
+     * @return The number of records.
+     */
+    size_t size() const { return n_; }
+    /**
+     * Determines if the batch has no records.
+     * @return @em true if there are no records.
+     */
+    bool empty() const { return n_ == 0; }
+    /**
+     * Gets an iterator to the first record.
+     * @return An iterator to the first record.
+     */
+    const_iterator begin() const {
+        return const_iterator{payload_.data(), payload_.data() + payload_.size()};
+    }
+    /**
+     * Gets an iterator past the last record.
+     * @return An iterator past the last record.
+     */
+    const_iterator end() const { return const_iterator{}; }
+};
+
+/////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Packs small messages for the same topic into larger ones.
+ *
+ * A message for a small reading, like a sensor value, is mostly overhead:
+ * the MQTT header, the topic, and an acknowledgment for each one. This
+ * collects the records published for each topic, for up to a time limit
+ * or a size limit, and then publishes them together, as a single
+ * message, framed as a @ref record_batch, which the receiver uses to get
+ * at the individual records.
+ * @par
+ * The batches are sent from the caller's thread when they reach the size
+ * limit, and from a thread of the publisher's when they reach the time
+ * limit. Any that are left are sent when the publisher is flushed or
+ * destroyed. With MQTT v5, each batch has a user property with the
+ * number of records in it. The errors from publishing the batches are
+ * counted, rather than thrown.
+ */
+class coalescing_publisher
+{
+    /** The clock for the time limits */
+    using clock = std::chrono::steady_clock;
+
+    /** The records waiting for a topic */
+    struct pending
+    {
+        /** The packed records */
+        binary buf;
+        /** The number of records */
+        size_t n{0};
+        /** The time by which they must be sent */
+        clock::time_point deadline;
+    };
+
+    /** The client to publish with */
+    async_client& cli_;
+    /** The QoS for the batches */
+    int qos_;
+    /** The longest a record waits to be sent */
+    std::chrono::milliseconds maxDelay_;
+    /** The size at which a batch is sent */
+    size_t maxBytes_;
+    /** Lock for the pending records */
+    mutable std::mutex lock_;
+    /**
+     * Held while sending batches, so those for a topic go out in order.
+     * It's taken while holding the lock for the records.
+     */
+    std::mutex sendLock_;
+    /** Signaled when there are new records, or to stop */
+    std::condition_variable cond_;
+    /** The records waiting to be sent, by topic */
+    std::map<string, pending> pending_;
+    /** Whether the thread should exit */
+    bool stop_{false};
+    /** The number of records published */
+    std::atomic<uint64_t> nRecords_{0};
+    /** The number of batches published */
+    std::atomic<uint64_t> nBatches_{0};
+    /** The number of batches that failed to publish */
+    std::atomic<uint64_t> nErrors_{0};
+    /** The thread that sends the batches at their time limit */
+    std::thread thr_;
+
+    /** Publishes a batch of records for a topic */
+    void send(const string& topic, pending&& recs);
+    /** Sends the batches when they reach their time limit */
+    void run();
+
+public:
+    /** The default for the longest a record waits to be sent */
+    static constexpr std::chrono::milliseconds DFLT_MAX_DELAY{100};
+    /** The default size at which a batch is sent */
+    static constexpr size_t DFLT_MAX_BYTES = 4096;
+    /** The name of the user property with the number of records */
+    static constexpr const char* COUNT_PROPERTY_NAME = "records";
+
+    /**
+     * Creates a coalescing publisher.
+     * @param cli The client to publish with.
+     * @param qos The QoS for the batches.
+     * @param maxDelay The longest a record waits to be sent.
+     * @param maxBytes The size at which a batch is sent right away. This
+     *  			   should be comfortably under the maximum packet size
+     *  			   of the server.
+     * @throw std::invalid_argument if the size limit is zero.
+     */
+    coalescing_publisher(
+        async_client& cli, int qos = 0, std::chrono::milliseconds maxDelay = DFLT_MAX_DELAY,
+        size_t maxBytes = DFLT_MAX_BYTES
+    );
+    /**
+     * Destructor. This sends any records that are waiting.
+     */
+    ~coalescing_publisher();
+
+    coalescing_publisher(const coalescing_publisher&) = delete;
+    coalescing_publisher& operator=(const coalescing_publisher&) = delete;
+
+    /**
+     * Adds a record to the batch for a topic.
+     * @param topic The topic.
+     * @param data The record.
+     * @param n The size of the record, in bytes.
+     * @throw std::invalid_argument if the record is too large.
+     */
+    void publish(const string& topic, const void* data, size_t n);
+    /**
+     * Adds a record to the batch for a topic.
+     * @param topic The topic.
+     * @param rec The record.
+     * @throw std::invalid_argument if the record is too large.
+     */
+    void publish(const string& topic, std::string_view rec) {
+        publish(topic, rec.data(), rec.size());
+    }
+    /**
+     * Sends all the batches that are waiting, right away.
+     */
+    void flush();
+    /**
+     * Gets the number of records waiting to be sent.
+     * @return The number of records waiting to be sent.
+     */
+    size_t pending_records() const;
+    /**
+     * Gets the number of records that were published.
+     * @return The number of records that were published.
+     */
+    uint64_t records() const { return nRecords_.load(std::memory_order_relaxed); }
+    /**
+     * Gets the number of batches that were published.
+     * @return The number of batches that were published.
+     */
+    uint64_t batches() const { return nBatches_.load(std::memory_order_relaxed); }
+    /**
+     * Gets the number of batches that failed to publish.
+     * @return The number of batches that failed to publish.
+     */
+    uint64_t errors() const { return nErrors_.load(std::memory_order_relaxed); }
+};
+
+/////////////////////////////////////////////////////////////////////////////
+}  // namespace mqtt
+
+#endif  // __mqtt_coalescing_publisher_h
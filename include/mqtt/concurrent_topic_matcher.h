@@ -0,0 +1,199 @@
+/////////////////////////////////////////////////////////////////////////////
+/// @file concurrent_topic_matcher.h
+/// Declaration of MQTT concurrent_topic_matcher class
+/// @author Frank Pagliughi
+/////////////////////////////////////////////////////////////////////////////
+
+/*******************************************************************************
+ * Copyright (c) 2025 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+#ifndef __mqtt_concurrent_topic_matcher_h
+#define __mqtt_concurrent_topic_matcher_h
+
+#include <initializer_list>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <utility>
+
+#include "mqtt/rcu_ptr.h"
+#include "mqtt/topic_matcher.h"
+
+namespace mqtt {
+
+/////////////////////////////////////////////////////////////////////////////
+
+/**
+ * A thread-safe collection of MQTT topic filters mapped to arbitrary
+ * values, for read-mostly use.
+ *
+ * This wraps a `topic_matcher` that is never modified once it's shared.
+ * Readers search an immutable snapshot of the collection, which they get
+ * without blocking, so any number of threads can match topics in
+ * parallel. Writers are serialized. Each change builds a new copy of the
+ * collection and publishes it atomically in place of the old one, which
+ * is freed once the last reader lets go of it.
+ *
+ * This makes changes expensive, in proportion to the size of the
+ * collection, so it's intended for tables that are matched against
+ * constantly, such as to route incoming messages, but only change
+ * occasionally, such as when subscribing. Use `update()` to make a number
+ * of changes at once, with a single copy.
+ *
+ * @code
+ * concurrent_topic_matcher<int> tm;
+ * tm.insert({"data/#", 42});
+ *
+ * // From any thread...
+ * tm.for_each_match("data/temp", [](const auto& val) { ... });
+ * @endcode
+ */
+template <typename T>
+class concurrent_topic_matcher
+{
+public:
+    /** The type of collection that is shared */
+    using matcher_type = topic_matcher<T>;
+    using key_type = typename matcher_type::key_type;
+    using mapped_type = typename matcher_type::mapped_type;
+    using value_type = typename matcher_type::value_type;
+    using mapped_ptr = typename matcher_type::mapped_ptr;
+    /** A read-only snapshot of the collection */
+    using snapshot_ptr = std::shared_ptr<const matcher_type>;
+
+private:
+    /** The current version of the collection */
+    rcu_ptr<matcher_type> snap_;
+    /** Lock to serialize the writers */
+    std::mutex writeLock_;
+
+    /**
+     * Makes a modifiable copy of a version of the collection.
+     * @param snap The version to copy.
+     * @return A new collection with the same items.
+     */
+    static std::shared_ptr<matcher_type> copy(const snapshot_ptr& snap) {
+        auto tm = std::make_shared<matcher_type>();
+        for (auto it = snap->cbegin(); it != snap->cend(); ++it) tm->insert(*it);
+        return tm;
+    }
+
+public:
+    /**
+     * Creates a new, empty collection.
+     */
+    concurrent_topic_matcher() { snap_.store(std::make_shared<matcher_type>()); }
+    /**
+     * Creates a new collection with a list of key/value pairs.
+     * @param lst The list of key/value pairs to populate the collection.
+     */
+    concurrent_topic_matcher(std::initializer_list<value_type> lst) {
+        snap_.store(std::make_shared<matcher_type>(lst));
+    }
+    /**
+     * Gets a snapshot of the current version of the collection.
+     *
+     * This never blocks. The snapshot is not affected by later changes, and
+     * can be used to iterate over the items, or to get a `match_iterator`,
+     * for as long as it's kept.
+     *
+     * @return A read-only snapshot of the collection.
+     */
+    snapshot_ptr snapshot() const noexcept { return snap_.load(); }
+    /**
+     * Determines if the collection is empty.
+     * @return @em true if the collection is empty, @em false if it contains
+     *         any filters.
+     */
+    bool empty() const { return snapshot()->empty(); }
+    /**
+     * Makes a number of changes to the collection at once.
+     *
+     * The function is given a copy of the current collection to modify,
+     * which becomes the current version when it returns. Other writers
+     * are blocked until then, but readers are not.
+     *
+     * @param fn The function to modify the collection, as
+     *  		 `fn(matcher_type&)`.
+     */
+    template <typename Func>
+    void update(Func fn) {
+        std::lock_guard<std::mutex> g{writeLock_};
+        auto tm = copy(snap_.load());
+        fn(*tm);
+        snap_.store(std::move(tm));
+    }
+    /**
+     * Replaces the whole collection with one that was built separately.
+     *
+     * This is for swapping in a large table, such as a new set of routing
+     * rules, which can be built off to the side without copying the
+     * current one or holding up the other writers. It is installed with a
+     * single atomic store, so readers see either the old collection or the
+     * new one, never a mix of the two.
+     *
+     * @param tm The new collection.
+     * @return A snapshot of the collection that was replaced.
+     */
+    snapshot_ptr exchange(matcher_type&& tm) {
+        auto snap = std::make_shared<matcher_type>(std::move(tm));
+        std::lock_guard<std::mutex> g{writeLock_};
+        auto old = snap_.load();
+        snap_.store(std::move(snap));
+        return old;
+    }
+    /**
+     * Inserts a new key/value pair into the collection.
+     * @param val The value to place in the collection.
+     */
+    void insert(value_type val) {
+        update([&val](matcher_type& tm) { tm.insert(std::move(val)); });
+    }
+    /**
+     * Removes an entry from the collection.
+     * @param filter The topic filter to remove.
+     * @return A unique pointer to the value, if any.
+     */
+    mapped_ptr remove(const key_type& filter) {
+        mapped_ptr val;
+        update([&](matcher_type& tm) { val = tm.remove(filter); });
+        return val;
+    }
+    /**
+     * Determines if there are any matches for the specified topic.
+     * @param topic The topic to search for matches.
+     * @return Whether there are any matches for the topic in the
+     *         collection.
+     */
+    bool has_match(std::string_view topic) const { return snapshot()->has_match(topic); }
+    /**
+     * Calls a function for each item that matches the topic, in the
+     * current version of the collection.
+     * @param topic The topic to search for matches.
+     * @param fn The function to call with each matching item, as
+     *  		 `fn(const value_type&)`.
+     */
+    template <typename Func>
+    void for_each_match(std::string_view topic, Func fn) const {
+        auto snap = snapshot();
+        snap->for_each_match(topic, std::move(fn));
+    }
+};
+
+/////////////////////////////////////////////////////////////////////////////
+}  // namespace mqtt
+
+#endif  // __mqtt_concurrent_topic_matcher_h
@@ -0,0 +1,517 @@
+/////////////////////////////////////////////////////////////////////////////
+/// @file conflating_queue.h
+/// Implementation of the template class 'conflating_queue', a thread-safe,
+/// blocking queue that keeps only the latest item for each key, for
+/// passing data between threads.
+/////////////////////////////////////////////////////////////////////////////
+
+/*******************************************************************************
+ * Copyright (c) 2025 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+#ifndef __mqtt_conflating_queue_h
+#define __mqtt_conflating_queue_h
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <limits>
+#include <list>
+#include <mutex>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "mqtt/thread_queue.h"
+
+namespace mqtt {
+
+/////////////////////////////////////////////////////////////////////////////
+
+/**
+ * A thread-safe queue that keeps only the latest item for each key.
+ *
+ * This has the same API as the @ref thread_queue, but a function given to
+ * the constructor gets a key for each item as it is put into the queue. If
+ * an item with the same key is already waiting in the queue, the new item
+ * replaces it, in place, so it keeps the position of the old one, and the
+ * old one is discarded. An item with an empty key is never replaced, and
+ * is always added to the back of the queue.
+ * @par
+ * This is meant for consumers that only care about the newest value of
+ * each topic, like a display or a control loop. When the consumer falls
+ * behind, the queue holds at most one item per key, so its length is
+ * bounded by the number of distinct keys rather than the rate that items
+ * arrive, and the consumer never processes a stale value.
+ * @par
+ * The key is a view that must refer to data held by the item itself, like
+ * the topic of a message, since the queue keeps it for as long as the item
+ * is waiting.
+ * @par
+ * The capacity bounds the number of items in the queue. A put that
+ * replaces an item never blocks, since it doesn't add to the size. A put
+ * of a new key to a full queue blocks, and the queue can be closed, all
+ * with the same semantics as the @ref thread_queue.
+ *
+ * @tparam T The type of the items to be held in the queue.
+ */
+template <typename T>
+class conflating_queue
+{
+public:
+    /** The type of items to be held in the queue. */
+    using value_type = T;
+    /** The type used to specify number of items in the container. */
+    using size_type = std::size_t;
+    /**
+     * The type of function to get the key for an item. An empty key means
+     * that the item is never replaced.
+     */
+    using key_function = std::function<std::string_view(const value_type&)>;
+
+    /** The maximum capacity of the queue. */
+    static constexpr size_type MAX_CAPACITY = std::numeric_limits<size_type>::max();
+
+private:
+    /** The container for the items, which keeps iterators stable */
+    using container_type = std::list<value_type>;
+    /** An iterator to an item in the queue */
+    using iterator = typename container_type::iterator;
+
+    /** Object lock */
+    mutable std::mutex lock_;
+    /** Condition get signaled when item added to empty queue */
+    std::condition_variable notEmptyCond_;
+    /** Condition gets signaled then item removed from full queue */
+    std::condition_variable notFullCond_;
+    /** The items, in the order they were first queued */
+    container_type que_;
+    /** The items that can be replaced, by key */
+    std::unordered_map<std::string_view, iterator> index_;
+    /** The function to get the key for an item */
+    key_function keyFunc_;
+    /** The capacity of the queue */
+    size_type cap_{MAX_CAPACITY};
+    /** The number of items that were replaced by newer ones */
+    size_type nConflated_{0};
+    /** Whether the queue is closed */
+    bool closed_{false};
+
+    /** Simple, scope-based lock guard */
+    using guard = std::lock_guard<std::mutex>;
+    /** General purpose guard */
+    using unique_guard = std::unique_lock<std::mutex>;
+
+    /** Checks if the queue is done (unsafe) */
+    bool is_done() const { return closed_ && que_.empty(); }
+
+    /** Gets the key for an item */
+    std::string_view key_of(const value_type& val) const {
+        return keyFunc_ ? keyFunc_(val) : std::string_view{};
+    }
+
+    /**
+     * Replaces the waiting item with the same key, if there is one
+     * (unsafe).
+     * @return @em true if the item was replaced, @em false if there is no
+     *  	   item waiting with the key.
+     */
+    bool replace(std::string_view key, value_type& val) {
+        if (key.empty())
+            return false;
+
+        auto it = index_.find(key);
+        if (it == index_.end())
+            return false;
+
+        // The key refers to the old item, so it's re-keyed from the new one
+        auto pos = it->second;
+        index_.erase(it);
+        *pos = std::move(val);
+        index_.emplace(key_of(*pos), pos);
+        ++nConflated_;
+        return true;
+    }
+
+    /** Adds an item to the back of the queue (unsafe) */
+    void push(value_type&& val) {
+        que_.emplace_back(std::move(val));
+        auto key = key_of(que_.back());
+        if (!key.empty())
+            index_.emplace(key, std::prev(que_.end()));
+        notEmptyCond_.notify_one();
+    }
+
+    /** Either replaces or adds the item, if there's room (unsafe) */
+    bool put_if_room(std::string_view key, value_type& val) {
+        if (closed_)
+            return false;
+        if (replace(key, val))
+            return true;
+        if (que_.size() >= cap_)
+            return false;
+        push(std::move(val));
+        return true;
+    }
+
+    /** Determines if a put can go ahead without waiting (unsafe) */
+    bool can_put(std::string_view key) const {
+        return closed_ || que_.size() < cap_ || (!key.empty() && index_.count(key) != 0);
+    }
+
+    /**
+     * Removes the next item from the queue (unsafe).
+     * The queue must not be empty.
+     */
+    value_type pop() {
+        auto pos = que_.begin();
+        auto key = key_of(*pos);
+        if (!key.empty())
+            index_.erase(key);
+        value_type val = std::move(*pos);
+        que_.erase(pos);
+        notFullCond_.notify_one();
+        return val;
+    }
+
+    /**
+     * Moves up to the specified number of items from the queue into the
+     * vector, in the order they would be retrieved individually (unsafe).
+     * @return The number of items moved.
+     */
+    size_type pop_bulk(std::vector<value_type>& vec, size_type maxItems) {
+        size_type n = std::min(maxItems, que_.size());
+        if (n == 0)
+            return 0;
+
+        vec.reserve(vec.size() + n);
+        for (size_type i = 0; i < n; ++i) vec.emplace_back(pop());
+        notFullCond_.notify_all();
+        return n;
+    }
+
+public:
+    /**
+     * Constructs a queue.
+     * @param keyFunc The function to get the key for each item. An item
+     *  			  replaces the waiting one with the same key. An empty
+     *  			  key means the item is never replaced.
+     * @param cap The maximum number of items that can be placed in the
+     *  		  queue. The minimum capacity is 1.
+     */
+    explicit conflating_queue(key_function keyFunc, size_type cap = MAX_CAPACITY)
+        : keyFunc_(std::move(keyFunc)), cap_(std::max<size_type>(cap, 1)) {}
+    /**
+     * Determine if the queue is empty.
+     * @return @em true if there are no elements in the queue, @em false if
+     *  	   there are any items in the queue.
+     */
+    bool empty() const {
+        guard g{lock_};
+        return que_.empty();
+    }
+    /**
+     * Gets the capacity of the queue.
+     * @return The maximum number of elements before the queue is full.
+     */
+    size_type capacity() const {
+        guard g{lock_};
+        return cap_;
+    }
+    /**
+     * Sets the capacity of the queue.
+     * As with the @ref thread_queue, this can be smaller than the current
+     * size of the queue, in which case puts of new keys will block until
+     * enough items are removed.
+     * @param cap The maximum number of elements in the queue.
+     */
+    void capacity(size_type cap) {
+        guard g{lock_};
+        cap_ = cap;
+        notFullCond_.notify_all();
+    }
+    /**
+     * Gets the number of items in the queue.
+     * @return The number of items in the queue.
+     */
+    size_type size() const {
+        guard g{lock_};
+        return que_.size();
+    }
+    /**
+     * Gets the number of items that were discarded because a newer item
+     * with the same key replaced them.
+     * @return The number of items that were replaced.
+     */
+    size_type conflated() const {
+        guard g{lock_};
+        return nConflated_;
+    }
+    /**
+     * Close the queue.
+     * Once closed, the queue will not accept any new items, but receievers
+     * will still be able to get any remaining items out of the queue until
+     * it is empty.
+     */
+    void close() {
+        guard g{lock_};
+        closed_ = true;
+        notFullCond_.notify_all();
+        notEmptyCond_.notify_all();
+    }
+    /**
+     * Determines if the queue is closed.
+     * @return @em true if the queue is closed, @false otherwise.
+     */
+    bool closed() const {
+        guard g{lock_};
+        return closed_;
+    }
+    /**
+     * Determines if all possible operations are done on the queue.
+     * @return @true if the queue is closed and empty, @em false otherwise.
+     */
+    bool done() const {
+        guard g{lock_};
+        return is_done();
+    }
+    /**
+     * Clear the contents of the queue.
+     * This discards all items in the queue.
+     */
+    void clear() {
+        guard g{lock_};
+        index_.clear();
+        que_.clear();
+        notFullCond_.notify_all();
+    }
+    /**
+     * Put an item into the queue.
+     * If an item with the same key is waiting, it is replaced. Otherwise,
+     * if the queue is full, this will block the caller until items are
+     * removed bringing the size less than the capacity.
+     * @param val The value to add to the queue.
+     * @throw queue_closed if the queue is closed.
+     */
+    void put(value_type val) {
+        auto key = key_of(val);
+        unique_guard g{lock_};
+        notFullCond_.wait(g, [this, key] { return can_put(key); });
+        if (!put_if_room(key, val))
+            throw queue_closed{};
+    }
+    /**
+     * Non-blocking attempt to place an item into the queue.
+     * @param val The value to add to the queue.
+     * @return @em true if the item was added to the queue or replaced the
+     *  	   waiting one with the same key, @em false if the item was not
+     *  	   added because the queue is currently full.
+     */
+    bool try_put(value_type val) {
+        auto key = key_of(val);
+        guard g{lock_};
+        return put_if_room(key, val);
+    }
+    /**
+     * Attempt to place an item in the queue with a bounded wait.
+     * @param val The value to add to the queue.
+     * @param relTime The amount of time to wait until timing out.
+     * @return @em true if the value was added to the queue, @em false if a
+     *  	   timeout occurred.
+     */
+    template <typename Rep, class Period>
+    bool try_put_for(value_type val, const std::chrono::duration<Rep, Period>& relTime) {
+        auto key = key_of(val);
+        unique_guard g{lock_};
+        notFullCond_.wait_for(g, relTime, [this, key] { return can_put(key); });
+        return put_if_room(key, val);
+    }
+    /**
+     * Attempt to place an item in the queue with a bounded wait to an
+     * absolute time point.
+     * @param val The value to add to the queue.
+     * @param absTime The absolute time to wait to before timing out.
+     * @return @em true if the value was added to the queue, @em false if a
+     *  	   timeout occurred.
+     */
+    template <class Clock, class Duration>
+    bool try_put_until(
+        value_type val, const std::chrono::time_point<Clock, Duration>& absTime
+    ) {
+        auto key = key_of(val);
+        unique_guard g{lock_};
+        notFullCond_.wait_until(g, absTime, [this, key] { return can_put(key); });
+        return put_if_room(key, val);
+    }
+    /**
+     * Retrieve a value from the queue.
+     * If the queue is empty, this will block indefinitely until a value is
+     * added to the queue by another thread,
+     * @param val Pointer to a variable to receive the value.
+     * @return @em true if a value was retrieved, @em false if the queue is
+     *  	   closed and empty.
+     */
+    bool get(value_type* val) {
+        if (!val)
+            return false;
+
+        unique_guard g{lock_};
+        notEmptyCond_.wait(g, [this] { return !que_.empty() || closed_; });
+        if (que_.empty())  // We must be done
+            return false;
+
+        *val = pop();
+        return true;
+    }
+    /**
+     * Retrieve a value from the queue.
+     * If the queue is empty, this will block indefinitely until a value is
+     * added to the queue by another thread,
+     * @return The value removed from the queue
+     * @throw queue_closed if the queue is closed and empty.
+     */
+    value_type get() {
+        unique_guard g{lock_};
+        notEmptyCond_.wait(g, [this] { return !que_.empty() || closed_; });
+        if (que_.empty())  // We must be done
+            throw queue_closed{};
+
+        return pop();
+    }
+    /**
+     * Attempts to remove a value from the queue without blocking.
+     * @param val Pointer to a variable to receive the value.
+     * @return @em true if a value was removed from the queue, @em false if
+     *  	   the queue is empty.
+     */
+    bool try_get(value_type* val) {
+        if (!val)
+            return false;
+
+        guard g{lock_};
+        if (que_.empty())
+            return false;
+
+        *val = pop();
+        return true;
+    }
+    /**
+     * Attempt to remove an item from the queue for a bounded amount of time.
+     * @param val Pointer to a variable to receive the value.
+     * @param relTime The amount of time to wait until timing out.
+     * @return @em true if the value was removed the queue, @em false if a
+     *  	   timeout occurred.
+     */
+    template <typename Rep, class Period>
+    bool try_get_for(value_type* val, const std::chrono::duration<Rep, Period>& relTime) {
+        if (!val)
+            return false;
+
+        unique_guard g{lock_};
+        notEmptyCond_.wait_for(g, relTime, [this] { return !que_.empty() || closed_; });
+        if (que_.empty())
+            return false;
+
+        *val = pop();
+        return true;
+    }
+    /**
+     * Attempt to remove an item from the queue, waiting until a specific
+     * time if it is empty.
+     * @param val Pointer to a variable to receive the value.
+     * @param absTime The absolute time to wait to before timing out.
+     * @return @em true if the value was removed from the queue, @em false
+     *  	   if a timeout occurred.
+     */
+    template <class Clock, class Duration>
+    bool try_get_until(
+        value_type* val, const std::chrono::time_point<Clock, Duration>& absTime
+    ) {
+        if (!val)
+            return false;
+
+        unique_guard g{lock_};
+        notEmptyCond_.wait_until(g, absTime, [this] { return !que_.empty() || closed_; });
+        if (que_.empty())
+            return false;
+
+        *val = pop();
+        return true;
+    }
+    /**
+     * Removes all the items currently in the queue without blocking.
+     * @return A vector of the items that were in the queue, in order. It
+     *  	   is empty if the queue was empty.
+     */
+    std::vector<value_type> get_all() {
+        std::vector<value_type> vec;
+        try_get_bulk(vec, MAX_CAPACITY);
+        return vec;
+    }
+    /**
+     * Attempts to remove a number of items from the queue without
+     * blocking.
+     * @param vec The vector to receive the items.
+     * @param maxItems The maximum number of items to remove.
+     * @return The number of items removed from the queue.
+     */
+    size_type try_get_bulk(std::vector<value_type>& vec, size_type maxItems) {
+        guard g{lock_};
+        return pop_bulk(vec, maxItems);
+    }
+    /**
+     * Attempts to remove a number of items from the queue, waiting for a
+     * bounded amount of time for one to arrive if the queue is empty.
+     * @param vec The vector to receive the items.
+     * @param maxItems The maximum number of items to remove.
+     * @param relTime The amount of time to wait until timing out.
+     * @return The number of items removed from the queue. This is zero if
+     *  	   a timeout occurred.
+     */
+    template <typename Rep, class Period>
+    size_type try_get_bulk_for(
+        std::vector<value_type>& vec, size_type maxItems,
+        const std::chrono::duration<Rep, Period>& relTime
+    ) {
+        unique_guard g{lock_};
+        notEmptyCond_.wait_for(g, relTime, [this] { return !que_.empty() || closed_; });
+        return pop_bulk(vec, maxItems);
+    }
+    /**
+     * Attempts to remove a number of items from the queue, waiting until a
+     * specific time for one to arrive if the queue is empty.
+     * @param vec The vector to receive the items.
+     * @param maxItems The maximum number of items to remove.
+     * @param absTime The absolute time to wait to before timing out.
+     * @return The number of items removed from the queue. This is zero if
+     *  	   a timeout occurred.
+     */
+    template <class Clock, class Duration>
+    size_type try_get_bulk_until(
+        std::vector<value_type>& vec, size_type maxItems,
+        const std::chrono::time_point<Clock, Duration>& absTime
+    ) {
+        unique_guard g{lock_};
+        notEmptyCond_.wait_until(g, absTime, [this] { return !que_.empty() || closed_; });
+        return pop_bulk(vec, maxItems);
+    }
+};
+
+/////////////////////////////////////////////////////////////////////////////
+}  // namespace mqtt
+
+#endif  // __mqtt_conflating_queue_h
@@ -31,6 +31,7 @@
 #include "MQTTAsync.h"
 #include "mqtt/message.h"
 #include "mqtt/platform.h"
+#include "mqtt/reconnect_backoff.h"
 #include "mqtt/ssl_options.h"
 #include "mqtt/string_collection.h"
 #include "mqtt/token.h"
@@ -97,6 +98,9 @@ class connect_options
     /** Secure HTTPS proxy for websockets */
     string httpsProxy_;
 
+    /** The backoff for reconnects made by the client, if any */
+    reconnect_backoff_ptr backoff_;
+
     /** The client has special access */
     friend class async_client;
 
@@ -506,6 +510,27 @@ public:
             (int)to_seconds_count(minRetryInterval), (int)to_seconds_count(maxRetryInterval)
         );
     }
+    /**
+     * Gets the backoff policy for reconnects made by the client.
+     * @return The backoff policy, or null if the reconnects are left to
+     *  	   the C library.
+     */
+    reconnect_backoff_ptr get_reconnect_backoff() const { return backoff_; }
+    /**
+     * Sets a backoff policy for automatic reconnects.
+     *
+     * When set, the client makes the automatic reconnects itself, rather
+     * than leaving them to the C library, with jittered delays from the
+     * policy, so that a large number of clients don't all reconnect at
+     * the same times. This turns on automatic reconnects, and the retry
+     * intervals in the options are not used. See @ref reconnect_backoff.
+     *
+     * @param backoff The backoff policy, or null to leave reconnects to
+     *  			  the C library.
+     */
+    void set_reconnect_backoff(reconnect_backoff_ptr backoff) {
+        backoff_ = std::move(backoff);
+    }
     /**
      * Gets the connect properties.
      * @return A const reference to the properties for the connect.
@@ -901,6 +926,16 @@ public:
         opts_.set_automatic_reconnect(minRetryInterval, maxRetryInterval);
         return *this;
     }
+    /**
+     * Sets a backoff policy for automatic reconnects, made by the client
+     * rather than the C library.
+     * @param backoff The backoff policy.
+     * @return A reference to this object
+     */
+    auto reconnect_backoff(reconnect_backoff_ptr backoff) -> self& {
+        opts_.set_reconnect_backoff(std::move(backoff));
+        return *this;
+    }
     /**
      * Sets the 'clean start' flag for the connection. (MQTT v5 only)
      * @param on @em true to set the 'clean start' flag for the connect,
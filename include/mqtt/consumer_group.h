@@ -0,0 +1,244 @@
+/////////////////////////////////////////////////////////////////////////////
+/// @file consumer_group.h
+/// Declaration of MQTT consumer_group class
+/// @author Frank Pagliughi
+/////////////////////////////////////////////////////////////////////////////
+
+/*******************************************************************************
+ * Copyright (c) 2025 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+#ifndef __mqtt_consumer_group_h
+#define __mqtt_consumer_group_h
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "mqtt/client_pool.h"
+#include "mqtt/message_dispatcher.h"
+#include "mqtt/subscribe_options.h"
+
+namespace mqtt {
+
+/////////////////////////////////////////////////////////////////////////////
+
+/**
+ * A snapshot of the activity of a consumer group.
+ */
+struct consumer_group_stats
+{
+    /** The number of messages received by all the connections */
+    uint64_t msgsReceived{0};
+    /** The number of bytes received, counting the topics and payloads */
+    uint64_t bytesReceived{0};
+    /** The number of messages that the handler has finished with */
+    uint64_t msgsHandled{0};
+    /** The number of messages received that are waiting to be handled */
+    size_t lag{0};
+    /** The number of connections that are currently up */
+    size_t connected{0};
+    /** The number of times a connection was made again, after the first */
+    uint64_t reconnects{0};
+    /** The time since the group was created */
+    std::chrono::steady_clock::duration elapsed{0};
+    /** The average number of messages handled per second */
+    double handledRate{0.0};
+};
+
+/////////////////////////////////////////////////////////////////////////////
+
+/**
+ * A member of a shared-subscription consumer group.
+ *
+ * This opens a number of connections to the server, and subscribes each
+ * of them to the same shared subscriptions, like "$share/group/filter",
+ * so that the server spreads the messages over the connections, and over
+ * any other processes that are members of the same group. The messages
+ * from all the connections are fed to a single handler, run on a pool of
+ * worker threads by a @ref message_dispatcher. Messages with the same
+ * topic are handled in order by the same worker.
+ * @par
+ * The subscriptions are made again each time a connection is made, so
+ * with automatic reconnect in the connect options, the group recovers on
+ * its own from lost connections. Scaling the consumer is then a matter of
+ * the number of connections and workers given to the constructor, and the
+ * number of processes started with the same group name.
+ *
+ * @code
+ *     mqtt::consumer_group grp{
+ *         mqtt::create_options{"mqtt://localhost:1883", "worker"}, "sensors",
+ *         handle_message, 4
+ *     };
+ *     grp.subscribe("data/#", 1);
+ *     grp.connect(mqtt::connect_options_builder()
+ *             .automatic_reconnect()
+ *             .finalize())->wait();
+ * @endcode
+ */
+class consumer_group
+{
+public:
+    /** The handler for the messages */
+    using handler_type = message_dispatcher::handler_type;
+    /** A function to get the dispatch key for a message */
+    using key_func = message_dispatcher::key_func;
+
+private:
+    /** A subscription for the group */
+    struct subscription
+    {
+        string filter;
+        int qos;
+        subscribe_options opts;
+    };
+
+    /** The name of the group */
+    string group_;
+    /** The time the group was created */
+    std::chrono::steady_clock::time_point startTime_;
+    /** The number of messages received */
+    std::atomic<uint64_t> nReceived_{0};
+    /** The number of bytes received */
+    std::atomic<uint64_t> nBytesReceived_{0};
+    /** The number of messages handled */
+    std::atomic<uint64_t> nHandled_{0};
+    /** Lock for the subscriptions */
+    mutable std::mutex subLock_;
+    /** The subscriptions, as given by the application */
+    std::vector<subscription> subs_;
+    /** The worker pool for the messages */
+    message_dispatcher dispatcher_;
+    /** The connections. This is destroyed first, to stop the callbacks */
+    client_pool pool_;
+
+    /** Called by a client when a message arrives */
+    void on_message(const_message_ptr msg);
+    /** Called by a client when it (re)connects */
+    void on_connected(async_client& cli);
+
+public:
+    /**
+     * Creates a consumer group.
+     * @param opts The create options for the connections. The client ID
+     *  		   is used as the prefix for the IDs of the connections.
+     * @param group The name of the shared subscription group.
+     * @param handler The handler for the messages.
+     * @param nConnections The number of connections to the server.
+     * @param nWorkers The number of threads to run the handler. If this is
+     *  			   zero, the number of hardware threads is used.
+     * @param keyFunc A function to get the dispatch key for a message. If
+     *  			  this is empty, a hash of the topic is used.
+     * @throw std::invalid_argument if the number of connections is zero.
+     */
+    consumer_group(
+        const create_options& opts, const string& group, handler_type handler,
+        size_t nConnections = 1, size_t nWorkers = 0, key_func keyFunc = key_func{}
+    );
+    /**
+     * Destructor. This stops the connections and then the workers, which
+     * handle any messages that were already received.
+     */
+    ~consumer_group();
+
+    consumer_group(const consumer_group&) = delete;
+    consumer_group& operator=(const consumer_group&) = delete;
+
+    /**
+     * Makes the filter for a shared subscription.
+     * @param group The name of the shared subscription group.
+     * @param filter The topic filter.
+     * @return The shared subscription filter, "$share/<group>/<filter>"
+     */
+    static string share_filter(const string& group, const string& filter) {
+        return "$share/" + group + "/" + filter;
+    }
+    /**
+     * Gets the name of the group.
+     * @return The name of the shared subscription group.
+     */
+    const string& get_group() const { return group_; }
+    /**
+     * Gets the number of connections.
+     * @return The number of connections to the server.
+     */
+    size_t num_connections() const { return pool_.size(); }
+    /**
+     * Gets the number of worker threads.
+     * @return The number of worker threads.
+     */
+    size_t num_workers() const { return dispatcher_.num_workers(); }
+    /**
+     * Pins the worker threads to a set of CPUs.
+     * @param cpus The CPUs for the workers.
+     * @param onePerWorker If @em true, each worker is pinned to one of the
+     *  				   CPUs, in turn, rather than to all of them.
+     * @return @em true if all the workers were pinned.
+     * @see message_dispatcher::set_cpu_affinity()
+     */
+    bool set_worker_affinity(const cpu_set& cpus, bool onePerWorker = false) {
+        return dispatcher_.set_cpu_affinity(cpus, onePerWorker);
+    }
+    /**
+     * Gets one of the connections.
+     * @param idx The index of the connection.
+     * @return A reference to the client for the connection.
+     * @throw std::out_of_range if the index is past the end.
+     */
+    async_client& get_client(size_t idx) { return pool_.get_client(idx); }
+    /**
+     * Adds a subscription for the group.
+     * The filter is made into a shared subscription for the group. If the
+     * connections are already up, they are subscribed right away,
+     * otherwise they subscribe as they connect.
+     * @param filter The topic filter, without the "$share/<group>/" prefix.
+     * @param qos The QoS for the subscription.
+     * @param opts The options for the subscription.
+     */
+    void subscribe(
+        const string& filter, int qos, const subscribe_options& opts = subscribe_options{}
+    );
+    /**
+     * Connects all the connections to the server.
+     * @param opts The connect options, used for all of the connections.
+     * @return A token that completes when all of the connections are up.
+     */
+    pool_token_ptr connect(const connect_options& opts = connect_options{}) {
+        return pool_.connect(opts);
+    }
+    /**
+     * Determines if all the connections are up.
+     * @return @em true if all the connections are up.
+     */
+    bool is_connected() const { return pool_.is_connected(); }
+    /**
+     * Disconnects all the connections from the server.
+     * @return A token that completes when all of the connections are down.
+     */
+    pool_token_ptr disconnect() { return pool_.disconnect(); }
+    /**
+     * Gets a snapshot of the activity of the group.
+     * @return The statistics for the group.
+     */
+    consumer_group_stats get_stats() const;
+};
+
+/////////////////////////////////////////////////////////////////////////////
+}  // namespace mqtt
+
+#endif  // __mqtt_consumer_group_h
@@ -0,0 +1,202 @@
+/////////////////////////////////////////////////////////////////////////////
+/// @file consumer_options.h
+/// Declaration of MQTT consumer_options class
+/// @author Frank Pagliughi
+/////////////////////////////////////////////////////////////////////////////
+
+/*******************************************************************************
+ * Copyright (c) 2025 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+#ifndef __mqtt_consumer_options_h
+#define __mqtt_consumer_options_h
+
+#include <cstddef>
+#include <optional>
+
+#include "mqtt/create_options.h"
+
+namespace mqtt {
+
+/////////////////////////////////////////////////////////////////////////////
+
+/**
+ * The kind of queue that holds the events for the consumer.
+ */
+enum class queue_backend {
+    /**
+     * A locking queue over a std::deque, which allocates as it grows. This
+     * can be unbounded. (thread_consumer_queue)
+     */
+    DEQUE,
+    /**
+     * A lock-free ring buffer with all of its slots allocated up front, so
+     * the memory for the queue is fixed. The capacity is rounded up to a
+     * power of two. (lock_free_consumer_queue)
+     */
+    RING
+};
+
+/////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Options for the queue that the client creates for the consumer API.
+ *
+ * These are given to `async_client::start_consuming()` to choose the type
+ * and size of the queue, and what happens when it fills up, so that the
+ * memory used when the application falls behind is bounded.
+ */
+class consumer_options
+{
+    /** The maximum number of events in the queue (0=no limit) */
+    size_t capacity_{0};
+    /** The maximum number of message bytes in the queue (0=no limit) */
+    size_t maxBytes_{0};
+    /** The type of queue */
+    queue_backend backend_{queue_backend::DEQUE};
+    /** The overflow policy, if it overrides the create options */
+    std::optional<overflow_policy> overflowPolicy_;
+
+    /** The builder has special access */
+    friend class consumer_options_builder;
+
+public:
+    /**
+     * Creates the default options: an unbounded deque.
+     */
+    consumer_options() = default;
+    /**
+     * Creates options for a bounded queue.
+     * @param capacity The maximum number of events in the queue.
+     * @param backend The type of queue.
+     */
+    explicit consumer_options(size_t capacity, queue_backend backend = queue_backend::DEQUE)
+        : capacity_{capacity}, backend_{backend} {}
+    /**
+     * Gets the maximum number of events in the queue.
+     * @return The queue capacity. Zero means there is no limit for a
+     *  	   deque, or the default size for a ring.
+     */
+    size_t get_capacity() const { return capacity_; }
+    /**
+     * Sets the maximum number of events in the queue.
+     * @param n The queue capacity. Zero means there is no limit for a
+     *  		deque, or the default size for a ring.
+     */
+    void set_capacity(size_t n) { capacity_ = n; }
+    /**
+     * Gets the maximum number of bytes of messages in the queue.
+     * @return The maximum total size of the topics and payloads of the
+     *  	   messages in the queue. Zero means there is no limit.
+     */
+    size_t get_max_bytes() const { return maxBytes_; }
+    /**
+     * Sets the maximum number of bytes of messages in the queue.
+     * This bounds the memory held by the queue when the messages vary
+     * widely in size. A single message larger than this is still accepted
+     * into an empty queue. This is only supported by the deque backend.
+     * @param n The maximum total size of the topics and payloads of the
+     *  		messages in the queue. Zero means there is no limit.
+     */
+    void set_max_bytes(size_t n) { maxBytes_ = n; }
+    /**
+     * Gets the type of queue.
+     * @return The type of queue.
+     */
+    queue_backend get_backend() const { return backend_; }
+    /**
+     * Sets the type of queue.
+     * @param backend The type of queue.
+     */
+    void set_backend(queue_backend backend) { backend_ = backend; }
+    /**
+     * Gets the policy for incoming messages when the queue is full.
+     * @return The overflow policy, if it was set, otherwise the one in the
+     *  	   client's create options is used.
+     */
+    std::optional<overflow_policy> get_overflow_policy() const { return overflowPolicy_; }
+    /**
+     * Sets the policy for incoming messages when the queue is full.
+     * This overrides the one in the client's create options.
+     * @param policy The overflow policy.
+     */
+    void set_overflow_policy(overflow_policy policy) { overflowPolicy_ = policy; }
+};
+
+/////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Builder class to generate the consumer options.
+ */
+class consumer_options_builder
+{
+    /** The underlying options */
+    consumer_options opts_;
+
+public:
+    /** This class */
+    using self = consumer_options_builder;
+    /**
+     * Default constructor.
+     */
+    consumer_options_builder() {}
+    /**
+     * Sets the maximum number of events in the queue.
+     * @param n The queue capacity.
+     * @return A reference to this object
+     */
+    auto capacity(size_t n) -> self& {
+        opts_.capacity_ = n;
+        return *this;
+    }
+    /**
+     * Sets the maximum number of bytes of messages in the queue.
+     * @param n The maximum total size of the topics and payloads of the
+     *  		messages in the queue.
+     * @return A reference to this object
+     */
+    auto max_bytes(size_t n) -> self& {
+        opts_.maxBytes_ = n;
+        return *this;
+    }
+    /**
+     * Sets the type of queue.
+     * @param backend The type of queue.
+     * @return A reference to this object
+     */
+    auto backend(queue_backend backend) -> self& {
+        opts_.backend_ = backend;
+        return *this;
+    }
+    /**
+     * Sets the policy for incoming messages when the queue is full.
+     * @param policy The overflow policy.
+     * @return A reference to this object
+     */
+    auto overflow_policy(mqtt::overflow_policy policy) -> self& {
+        opts_.overflowPolicy_ = policy;
+        return *this;
+    }
+    /**
+     * Finish building the options and return them.
+     * @return The option struct as built.
+     */
+    consumer_options finalize() { return opts_; }
+};
+
+/////////////////////////////////////////////////////////////////////////////
+}  // namespace mqtt
+
+#endif  // __mqtt_consumer_options_h
@@ -0,0 +1,670 @@
+/////////////////////////////////////////////////////////////////////////////
+/// @file consumer_queue.h
+/// Declaration of the interface for the queue used by the client to pass
+/// events to a consumer, and an adapter to fit concrete queues to it.
+/////////////////////////////////////////////////////////////////////////////
+
+/*******************************************************************************
+ * Copyright (c) 2025 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+#ifndef __mqtt_consumer_queue_h
+#define __mqtt_consumer_queue_h
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <deque>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "mqtt/conflating_queue.h"
+#include "mqtt/event.h"
+#include "mqtt/lock_free_queue.h"
+#include "mqtt/memory_budget.h"
+#include "mqtt/multi_lane_queue.h"
+#include "mqtt/spin_wait.h"
+#include "mqtt/thread_queue.h"
+#include "mqtt/topic.h"
+
+namespace mqtt {
+
+/////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Interface for the queue that the client uses to pass events to the
+ * application's consumer.
+ *
+ * This is the subset of the @ref thread_queue API that the client needs
+ * to run the consumer. It allows the application to choose the
+ * implementation of the queue when it calls
+ * async_client::start_consuming(). The @ref consumer_queue template can
+ * be used to adapt any queue having the @ref thread_queue API.
+ */
+class iconsumer_queue
+{
+protected:
+    /**
+     * Attempt to remove an event from the queue, waiting until a specific
+     * time if it is empty.
+     * @param evt Pointer to a variable to receive the event.
+     * @param absTime The time point to wait until, before timing out.
+     * @return @em true if the event was removed from the queue, @em false
+     *  	   if a timeout occurred.
+     */
+    virtual bool try_get_until_steady(
+        event* evt, const std::chrono::steady_clock::time_point& absTime
+    ) = 0;
+    /**
+     * Attempt to remove a number of events from the queue, waiting until a
+     * specific time for one to arrive if it is empty.
+     * @param vec The vector to receive the events.
+     * @param maxEvents The maximum number of events to remove.
+     * @param absTime The time point to wait until, before timing out.
+     * @return The number of events removed from the queue.
+     */
+    virtual std::size_t try_get_bulk_until_steady(
+        std::vector<event>& vec, std::size_t maxEvents,
+        const std::chrono::steady_clock::time_point& absTime
+    ) = 0;
+
+public:
+    /** The type used to specify number of events in the queue. */
+    using size_type = std::size_t;
+
+    /**
+     * Virtual destructor.
+     */
+    virtual ~iconsumer_queue() {}
+    /**
+     * Determine if the queue is empty.
+     * @return @em true if there are no events in the queue.
+     */
+    virtual bool empty() const = 0;
+    /**
+     * Gets the capacity of the queue.
+     * @return The maximum number of events before the queue is full.
+     */
+    virtual size_type capacity() const = 0;
+    /**
+     * Gets the number of events in the queue.
+     * @return The number of events in the queue.
+     */
+    virtual size_type size() const = 0;
+    /**
+     * Close the queue.
+     * Once closed, the queue will not accept any new events, but receivers
+     * will still be able to get any remaining events out of the queue.
+     */
+    virtual void close() = 0;
+    /**
+     * Determines if the queue is closed.
+     * @return @em true if the queue is closed, @false otherwise.
+     */
+    virtual bool closed() const = 0;
+    /**
+     * Determines if the queue is closed and empty.
+     * @return @true if the queue is closed and empty, @em false otherwise.
+     */
+    virtual bool done() const = 0;
+    /**
+     * Clear the contents of the queue, discarding any events.
+     */
+    virtual void clear() = 0;
+    /**
+     * Sets the policy for spinning before a get blocks.
+     * A queue that can't spin ignores this, and always blocks right away.
+     * @param sw The spin-then-block policy for the consumers.
+     */
+    virtual void spin(const spin_wait& /*sw*/) {}
+    /**
+     * Determines if the memory held by the events can be counted as they
+     * go in and come out of the queue. This is not the case for a queue
+     * that discards events on its own, like one that replaces waiting
+     * messages with newer ones.
+     * @return @em true if the events in the queue can be metered.
+     */
+    virtual bool can_meter() const { return true; }
+    /**
+     * Put an event into the queue, blocking if the queue is full.
+     * @param evt The event to add to the queue.
+     * @throw queue_closed if the queue is closed.
+     */
+    virtual void put(event evt) = 0;
+    /**
+     * Non-blocking attempt to place an event into the queue.
+     * @param evt The event to add to the queue.
+     * @return @em true if the event was added to the queue, @em false if
+     *  	   the queue is full or closed.
+     */
+    virtual bool try_put(event evt) = 0;
+    /**
+     * Retrieve an event from the queue, blocking if the queue is empty.
+     * @param evt Pointer to a variable to receive the event.
+     * @return @em true if an event was retrieved, @em false if the queue is
+     *  	   closed and empty.
+     */
+    virtual bool get(event* evt) = 0;
+    /**
+     * Retrieve an event from the queue, blocking if the queue is empty.
+     * @return The event removed from the queue.
+     * @throw queue_closed if the queue is closed and empty.
+     */
+    virtual event get() = 0;
+    /**
+     * Attempts to remove an event from the queue without blocking.
+     * @param evt Pointer to a variable to receive the event.
+     * @return @em true if an event was removed from the queue, @em false if
+     *  	   the queue is empty.
+     */
+    virtual bool try_get(event* evt) = 0;
+    /**
+     * Attempt to remove an event from the queue for a bounded amount of
+     * time.
+     * @param evt Pointer to a variable to receive the event.
+     * @param relTime The amount of time to wait until timing out.
+     * @return @em true if the event was removed the queue, @em false if a
+     *  	   timeout occurred.
+     */
+    template <typename Rep, class Period>
+    bool try_get_for(event* evt, const std::chrono::duration<Rep, Period>& relTime) {
+        using std::chrono::steady_clock;
+        return try_get_until_steady(
+            evt, steady_clock::now() +
+                     std::chrono::duration_cast<steady_clock::duration>(relTime)
+        );
+    }
+    /**
+     * Attempt to remove an event from the queue, waiting until a specific
+     * time if it is empty.
+     * @param evt Pointer to a variable to receive the event.
+     * @param absTime The absolute time to wait to before timing out.
+     * @return @em true if the event was removed from the queue, @em false
+     *  	   if a timeout occurred.
+     */
+    template <class Clock, class Duration>
+    bool try_get_until(event* evt, const std::chrono::time_point<Clock, Duration>& absTime) {
+        return try_get_for(evt, absTime - Clock::now());
+    }
+    /**
+     * Attempt to remove an event from the queue, waiting until a specific
+     * time if it is empty.
+     * @param evt Pointer to a variable to receive the event.
+     * @param absTime The absolute time to wait to before timing out.
+     * @return @em true if the event was removed from the queue, @em false
+     *  	   if a timeout occurred.
+     */
+    bool try_get_until(event* evt, const std::chrono::steady_clock::time_point& absTime) {
+        return try_get_until_steady(evt, absTime);
+    }
+    /**
+     * Removes all the events currently in the queue without blocking.
+     * @return A vector of the events that were in the queue.
+     */
+    virtual std::vector<event> get_all() = 0;
+    /**
+     * Removes all the events currently in the queue, as quickly as the
+     * queue allows.
+     * A queue that keeps its events in a deque, like the default
+     * @ref thread_consumer_queue, swaps out its contents in constant time.
+     * Others move them out with get_all().
+     * @return The events that were in the queue, in order from the front.
+     */
+    virtual std::deque<event> drain() {
+        auto vec = get_all();
+        return std::deque<event>(
+            std::make_move_iterator(vec.begin()), std::make_move_iterator(vec.end())
+        );
+    }
+    /**
+     * Attempts to remove a number of events from the queue without
+     * blocking.
+     * @param vec The vector to receive the events. They are appended to
+     *  		  any items already in the vector.
+     * @param maxEvents The maximum number of events to remove.
+     * @return The number of events removed from the queue.
+     */
+    virtual size_type try_get_bulk(std::vector<event>& vec, size_type maxEvents) = 0;
+    /**
+     * Attempts to remove a number of events from the queue, waiting for a
+     * bounded amount of time for one to arrive if the queue is empty.
+     * @param vec The vector to receive the events.
+     * @param maxEvents The maximum number of events to remove.
+     * @param relTime The amount of time to wait until timing out.
+     * @return The number of events removed from the queue. This is zero
+     *  	   if a timeout occurred.
+     */
+    template <typename Rep, class Period>
+    size_type try_get_bulk_for(
+        std::vector<event>& vec, size_type maxEvents,
+        const std::chrono::duration<Rep, Period>& relTime
+    ) {
+        using std::chrono::steady_clock;
+        return try_get_bulk_until_steady(
+            vec, maxEvents,
+            steady_clock::now() + std::chrono::duration_cast<steady_clock::duration>(relTime)
+        );
+    }
+    /**
+     * Attempts to remove a number of events from the queue, waiting until a
+     * specific time for one to arrive if the queue is empty.
+     * @param vec The vector to receive the events.
+     * @param maxEvents The maximum number of events to remove.
+     * @param absTime The absolute time to wait to before timing out.
+     * @return The number of events removed from the queue. This is zero
+     *  	   if a timeout occurred.
+     */
+    template <class Clock, class Duration>
+    size_type try_get_bulk_until(
+        std::vector<event>& vec, size_type maxEvents,
+        const std::chrono::time_point<Clock, Duration>& absTime
+    ) {
+        return try_get_bulk_for(vec, maxEvents, absTime - Clock::now());
+    }
+};
+
+/////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Determines if a queue type has a spin(const spin_wait&) method.
+ */
+template <class Queue, class = void>
+struct queue_can_spin : std::false_type
+{
+};
+
+template <class Queue>
+struct queue_can_spin<
+    Queue, std::void_t<decltype(std::declval<Queue&>().spin(std::declval<const spin_wait&>()))>>
+    : std::true_type
+{
+};
+
+/**
+ * Determines if a queue type has a drain() method that returns a deque of
+ * events.
+ */
+template <class Queue, class = void>
+struct queue_can_drain : std::false_type
+{
+};
+
+template <class Queue>
+struct queue_can_drain<
+    Queue, std::enable_if_t<std::is_same_v<
+               decltype(std::declval<Queue&>().drain()), std::deque<event>>>>
+    : std::true_type
+{
+};
+
+/**
+ * Determines if a queue type replaces the waiting items that have the same
+ * key as a new one, as determined by a key_function.
+ */
+template <class Queue, class = void>
+struct queue_replaces_items : std::false_type
+{
+};
+
+template <class Queue>
+struct queue_replaces_items<Queue, std::void_t<typename Queue::key_function>>
+    : std::true_type
+{
+};
+
+/**
+ * Adapter to use a concrete queue as the client's consumer queue.
+ *
+ * @tparam Queue The type of queue to hold the events. It must have the
+ *  			 same API as @ref thread_queue.
+ */
+template <class Queue>
+class consumer_queue : public iconsumer_queue
+{
+    /** The queue that holds the events */
+    Queue que_;
+
+protected:
+    bool try_get_until_steady(
+        event* evt, const std::chrono::steady_clock::time_point& absTime
+    ) override {
+        return que_.try_get_until(evt, absTime);
+    }
+    size_type try_get_bulk_until_steady(
+        std::vector<event>& vec, size_type maxEvents,
+        const std::chrono::steady_clock::time_point& absTime
+    ) override {
+        return size_type(que_.try_get_bulk_until(vec, maxEvents, absTime));
+    }
+
+public:
+    /**
+     * Creates the queue, passing any arguments to the constructor of the
+     * underlying queue.
+     */
+    template <typename... Args>
+    explicit consumer_queue(Args&&... args) : que_(std::forward<Args>(args)...) {}
+
+    bool empty() const override { return que_.empty(); }
+    size_type capacity() const override { return size_type(que_.capacity()); }
+    size_type size() const override { return size_type(que_.size()); }
+    void close() override { que_.close(); }
+    bool closed() const override { return que_.closed(); }
+    bool done() const override { return que_.done(); }
+    void clear() override { que_.clear(); }
+    void spin(const spin_wait& sw) override {
+        if constexpr (queue_can_spin<Queue>::value)
+            que_.spin(sw);
+    }
+    bool can_meter() const override { return !queue_replaces_items<Queue>::value; }
+    void put(event evt) override { que_.put(std::move(evt)); }
+    bool try_put(event evt) override { return que_.try_put(std::move(evt)); }
+    bool get(event* evt) override { return que_.get(evt); }
+    event get() override { return que_.get(); }
+    bool try_get(event* evt) override { return que_.try_get(evt); }
+    std::vector<event> get_all() override { return que_.get_all(); }
+    std::deque<event> drain() override {
+        if constexpr (queue_can_drain<Queue>::value)
+            return que_.drain();
+        else
+            return iconsumer_queue::drain();
+    }
+    size_type try_get_bulk(std::vector<event>& vec, size_type maxEvents) override {
+        return size_type(que_.try_get_bulk(vec, maxEvents));
+    }
+};
+
+/**
+ * Gets the number of bytes held by an event, for a consumer queue that is
+ * bounded by weight.
+ * This is the size of the topic and payload for a message. Other events
+ * are considered to be empty, so they always fit into the queue.
+ * @param evt The event.
+ * @return The number of bytes held by the event.
+ */
+inline std::size_t event_bytes(const event& evt) {
+    auto pmsg = evt.get_message_if();
+    if (!pmsg || !*pmsg)
+        return 0;
+    return (*pmsg)->get_topic_ref().size() + (*pmsg)->get_payload_ref().size();
+}
+
+/**
+ * Gets the number of bytes of memory held by an event.
+ * This is the size of the event itself, plus the memory held by its
+ * message, if it has one. See message::memory_size().
+ * @param evt The event.
+ * @return The approximate number of bytes held by the event.
+ */
+inline std::size_t event_memory(const event& evt) {
+    auto pmsg = evt.get_message_if();
+    return sizeof(event) + ((pmsg && *pmsg) ? (*pmsg)->memory_size() : 0);
+}
+
+/** The default, unbounded, locking consumer queue */
+using thread_consumer_queue = consumer_queue<thread_queue<event>>;
+
+/** A bounded, lock-free consumer queue */
+using lock_free_consumer_queue = consumer_queue<lock_free_queue<event>>;
+
+/**
+ * A locking consumer queue that serves the events by priority.
+ * See @ref multi_lane_queue for how the lanes are served.
+ *
+ * @code
+ *     cli.start_consuming(std::make_unique<mqtt::priority_consumer_queue>(
+ *         2, mqtt::lanes_by_topic({"cmd/#"})
+ *     ));
+ * @endcode
+ */
+using priority_consumer_queue = consumer_queue<multi_lane_queue<event>>;
+
+/**
+ * Gets a function that puts events into the lanes of a
+ * @ref priority_consumer_queue by the QoS of the messages.
+ * QoS 2 messages go into lane 0, QoS 1 into lane 1, and QoS 0 into lane 2,
+ * so the queue should have three lanes. Events that are not messages, like
+ * a lost connection, go into lane 0.
+ * @return A function to choose the lane for an event.
+ */
+inline multi_lane_queue<event>::lane_function lanes_by_qos() {
+    return [](const event& evt) -> size_t {
+        auto pmsg = evt.get_message_if();
+        if (!pmsg || !*pmsg)
+            return 0;
+        return size_t(2 - std::min(std::max((*pmsg)->get_qos(), 0), 2));
+    };
+}
+
+/**
+ * Gets a function that puts events into the lanes of a
+ * @ref priority_consumer_queue by the topics of the messages.
+ * A message goes into the lane of the first filter that matches its topic,
+ * so the first filter is for lane 0, the next for lane 1, and so on. A
+ * message that doesn't match any filter goes into the lane after the last
+ * one, so the queue should have one more lane than the number of filters.
+ * Events that are not messages, like a lost connection, go into lane 0.
+ * @param filters The topic filters for the lanes, highest priority first.
+ * @return A function to choose the lane for an event.
+ */
+inline multi_lane_queue<event>::lane_function lanes_by_topic(
+    const std::vector<string>& filters
+) {
+    std::vector<topic_filter> tfs;
+    for (const auto& f : filters) tfs.emplace_back(f);
+
+    return [tfs = std::move(tfs)](const event& evt) -> size_t {
+        auto pmsg = evt.get_message_if();
+        if (!pmsg || !*pmsg)
+            return 0;
+
+        const auto& topic = (*pmsg)->get_topic();
+        for (size_t i = 0; i < tfs.size(); ++i) {
+            if (tfs[i].matches(topic))
+                return i;
+        }
+        return tfs.size();
+    };
+}
+
+/**
+ * A locking consumer queue that keeps only the latest message for each
+ * topic.
+ * A message that arrives while an older one on the same topic is still
+ * waiting replaces it in place, so the queue never holds more messages
+ * than there are topics. See @ref conflating_queue.
+ *
+ * @code
+ *     cli.start_consuming(std::make_unique<mqtt::conflating_consumer_queue>(
+ *         mqtt::conflate_by_topic()
+ *     ));
+ * @endcode
+ */
+using conflating_consumer_queue = consumer_queue<conflating_queue<event>>;
+
+/**
+ * Gets a function that keys the events of a @ref conflating_consumer_queue
+ * by the topics of the messages, so that a newer message replaces a
+ * waiting one on the same topic. Events that are not messages, like a lost
+ * connection, are never replaced.
+ * @return A function to get the key for an event.
+ */
+inline conflating_queue<event>::key_function conflate_by_topic() {
+    return [](const event& evt) -> std::string_view {
+        auto pmsg = evt.get_message_if();
+        if (!pmsg || !*pmsg)
+            return std::string_view{};
+        return (*pmsg)->get_topic();
+    };
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+/**
+ * A consumer queue that counts the memory held by the events in another
+ * queue, and charges it to a memory budget.
+ *
+ * The client puts this around its consumer queue, to account for the
+ * incoming messages that are waiting for the application. The memory for
+ * an event is counted as it goes into the queue, and released as it comes
+ * out, so this is not for queues that discard events on their own, like a
+ * @ref conflating_consumer_queue.
+ */
+class metered_consumer_queue : public iconsumer_queue
+{
+    /** The queue that holds the events */
+    std::unique_ptr<iconsumer_queue> que_;
+    /** The budget to charge, if any */
+    memory_budget* budget_;
+    /** The number of bytes held by the events in the queue */
+    std::atomic<size_type> bytes_{0};
+
+    /** Counts the memory for an event going into the queue */
+    void charge(size_type n) {
+        bytes_.fetch_add(n, std::memory_order_relaxed);
+        if (budget_)
+            budget_->charge(n);
+    }
+    /** Releases the memory for an event coming out of the queue */
+    void release(size_type n) {
+        bytes_.fetch_sub(n, std::memory_order_relaxed);
+        if (budget_)
+            budget_->release(n);
+    }
+    /** Releases the memory for the events at the end of a vector */
+    size_type release(const std::vector<event>& vec, size_type n) {
+        size_type nbytes = 0;
+        for (auto i = vec.size() - n; i < vec.size(); ++i) nbytes += event_memory(vec[i]);
+        if (nbytes)
+            release(nbytes);
+        return n;
+    }
+
+protected:
+    bool try_get_until_steady(
+        event* evt, const std::chrono::steady_clock::time_point& absTime
+    ) override {
+        if (!que_->try_get_until(evt, absTime))
+            return false;
+        release(event_memory(*evt));
+        return true;
+    }
+    size_type try_get_bulk_until_steady(
+        std::vector<event>& vec, size_type maxEvents,
+        const std::chrono::steady_clock::time_point& absTime
+    ) override {
+        return release(vec, que_->try_get_bulk_until(vec, maxEvents, absTime));
+    }
+
+public:
+    /**
+     * Creates a metered queue around another consumer queue.
+     * @param que The queue to hold the events.
+     * @param budget The budget to charge for the events, if any. It must
+     *  			 outlive this queue.
+     */
+    explicit metered_consumer_queue(
+        std::unique_ptr<iconsumer_queue> que, memory_budget* budget = nullptr
+    )
+        : que_{std::move(que)}, budget_{budget} {}
+    /**
+     * Destructor. This releases the charge for any events that are still
+     * in the queue.
+     */
+    ~metered_consumer_queue() override {
+        if (budget_)
+            budget_->release(bytes());
+    }
+    /**
+     * Gets the number of bytes of memory held by the events in the queue.
+     * @return The approximate number of bytes held by the queue.
+     */
+    size_type bytes() const { return bytes_.load(std::memory_order_relaxed); }
+
+    bool empty() const override { return que_->empty(); }
+    size_type capacity() const override { return que_->capacity(); }
+    size_type size() const override { return que_->size(); }
+    void close() override { que_->close(); }
+    bool closed() const override { return que_->closed(); }
+    bool done() const override { return que_->done(); }
+    void clear() override {
+        event evt;
+        while (que_->try_get(&evt)) release(event_memory(evt));
+    }
+    void spin(const spin_wait& sw) override { que_->spin(sw); }
+    bool can_meter() const override { return que_->can_meter(); }
+    void put(event evt) override {
+        auto n = event_memory(evt);
+        charge(n);
+        try {
+            que_->put(std::move(evt));
+        }
+        catch (...) {
+            release(n);
+            throw;
+        }
+    }
+    bool try_put(event evt) override {
+        auto n = event_memory(evt);
+        charge(n);
+        if (que_->try_put(std::move(evt)))
+            return true;
+        release(n);
+        return false;
+    }
+    bool get(event* evt) override {
+        if (!que_->get(evt))
+            return false;
+        release(event_memory(*evt));
+        return true;
+    }
+    event get() override {
+        auto evt = que_->get();
+        release(event_memory(evt));
+        return evt;
+    }
+    bool try_get(event* evt) override {
+        if (!que_->try_get(evt))
+            return false;
+        release(event_memory(*evt));
+        return true;
+    }
+    std::vector<event> get_all() override {
+        auto vec = que_->get_all();
+        release(vec, vec.size());
+        return vec;
+    }
+    std::deque<event> drain() override {
+        auto que = que_->drain();
+        size_type nbytes = 0;
+        for (const auto& evt : que) nbytes += event_memory(evt);
+        if (nbytes)
+            release(nbytes);
+        return que;
+    }
+    size_type try_get_bulk(std::vector<event>& vec, size_type maxEvents) override {
+        return release(vec, que_->try_get_bulk(vec, maxEvents));
+    }
+};
+
+/////////////////////////////////////////////////////////////////////////////
+}  // namespace mqtt
+
+#endif  // __mqtt_consumer_queue_h
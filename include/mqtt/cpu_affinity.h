@@ -0,0 +1,159 @@
+/////////////////////////////////////////////////////////////////////////////
+/// @file cpu_affinity.h
+/// Declaration of MQTT cpu_set class, for thread affinity
+/// @author Frank Pagliughi
+/////////////////////////////////////////////////////////////////////////////
+
+/*******************************************************************************
+ * Copyright (c) 2025 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+
+#ifndef __mqtt_cpu_affinity_h
+#define __mqtt_cpu_affinity_h
+
+#include <initializer_list>
+#include <thread>
+#include <vector>
+
+#include "mqtt/types.h"
+
+namespace mqtt {
+
+/////////////////////////////////////////////////////////////////////////////
+
+/**
+ * A set of CPUs, to pin threads to.
+ *
+ * On a machine with more than one NUMA node, a message that is received
+ * by a thread on one node and handled by a thread on another crosses the
+ * interconnect between them. Pinning the threads that handle a stream of
+ * messages to the CPUs of the same node keeps the messages, and the
+ * memory of the queues between the threads, local to that node.
+ * @par
+ * There's no separate control of where memory is allocated. The operating
+ * systems that support NUMA place a page on the node of the thread that
+ * first touches it, so the messages and queue blocks allocated by pinned
+ * threads end up on their node.
+ * @par
+ * Pinning is supported on Linux and Windows. On Windows, only the
+ * CPUs of the first processor group, 0-63, can be used. On other
+ * platforms, the functions that pin threads always fail.
+ */
+class cpu_set
+{
+    /** The CPU numbers, in order, without duplicates */
+    std::vector<unsigned> cpus_;
+
+public:
+    /**
+     * Creates an empty set.
+     */
+    cpu_set() {}
+    /**
+     * Creates a set from a list of CPU numbers.
+     * @param cpus The CPU numbers.
+     */
+    cpu_set(std::initializer_list<unsigned> cpus);
+    /**
+     * Creates a set from a list of CPU numbers.
+     * @param cpus The CPU numbers.
+     */
+    explicit cpu_set(const std::vector<unsigned>& cpus);
+    /**
+     * Creates a set of a range of CPUs.
+     * @param first The first CPU in the range.
+     * @param last The last CPU in the range, inclusive.
+     * @return The set of CPUs.
+     */
+    static cpu_set range(unsigned first, unsigned last);
+    /**
+     * Parses a set in the Linux "cpulist" format, like "0-3,8,10-11".
+     * @param str The list of CPUs and ranges of CPUs.
+     * @return The set of CPUs.
+     * @throw std::invalid_argument if the string isn't a valid list.
+     */
+    static cpu_set parse(const string& str);
+    /**
+     * Gets the CPUs of a NUMA node.
+     * This is only available on Linux, where it is read from sysfs.
+     * @param node The number of the node.
+     * @return The CPUs of the node, or an empty set if the node doesn't
+     *  	   exist or the platform doesn't say.
+     */
+    static cpu_set numa_node(unsigned node);
+    /**
+     * Adds a CPU to the set.
+     * @param cpu The CPU number.
+     */
+    void add(unsigned cpu);
+    /**
+     * Determines if a CPU is in the set.
+     * @param cpu The CPU number.
+     * @return @em true if the CPU is in the set.
+     */
+    bool contains(unsigned cpu) const;
+    /**
+     * Determines if the set is empty.
+     * @return @em true if there are no CPUs in the set.
+     */
+    bool empty() const { return cpus_.empty(); }
+    /**
+     * Gets the number of CPUs in the set.
+     * @return The number of CPUs in the set.
+     */
+    size_t size() const { return cpus_.size(); }
+    /**
+     * Gets the CPUs in the set.
+     * @return The CPU numbers, in order.
+     */
+    const std::vector<unsigned>& cpus() const { return cpus_; }
+    /**
+     * Gets one of the CPUs in the set.
+     * @param i The index of the CPU, which wraps around past the end.
+     * @return The CPU number.
+     */
+    unsigned operator[](size_t i) const { return cpus_[i % cpus_.size()]; }
+    /**
+     * Pins the calling thread to the CPUs in the set.
+     * @return @em true if the thread was pinned, @em false if the set is
+     *  	   empty, or the platform doesn't support it, or it failed.
+     */
+    bool pin_current_thread() const;
+    /**
+     * Pins a thread to the CPUs in the set.
+     * @param thr The thread.
+     * @return @em true if the thread was pinned, @em false if the set is
+     *  	   empty, or the platform doesn't support it, or it failed.
+     */
+    bool pin(std::thread& thr) const;
+    /**
+     * Compares two sets.
+     * @param rhs The other set.
+     * @return @em true if the sets hold the same CPUs.
+     */
+    bool operator==(const cpu_set& rhs) const { return cpus_ == rhs.cpus_; }
+    /**
+     * Compares two sets.
+     * @param rhs The other set.
+     * @return @em true if the sets don't hold the same CPUs.
+     */
+    bool operator!=(const cpu_set& rhs) const { return cpus_ != rhs.cpus_; }
+};
+
+/////////////////////////////////////////////////////////////////////////////
+}  // namespace mqtt
+
+#endif  // __mqtt_cpu_affinity_h
@@ -24,16 +24,54 @@
 #ifndef __mqtt_create_options_h
 #define __mqtt_create_options_h
 
+#include <chrono>
+#include <memory_resource>
 #include <variant>
 
 #include "MQTTAsync.h"
+#include "mqtt/chunk_reassembler.h"
+#include "mqtt/cpu_affinity.h"
+#include "mqtt/dedup_filter.h"
 #include "mqtt/iclient_persistence.h"
+#include "mqtt/offline_buffer.h"
+#include "mqtt/payload_codec.h"
+#include "mqtt/message_sampler.h"
+#include "mqtt/publish_shaper.h"
+#include "mqtt/retained_cache.h"
+#include "mqtt/sequence_tracker.h"
+#include "mqtt/spin_wait.h"
+#include "mqtt/topic_stats.h"
 #include "mqtt/types.h"
 
 namespace mqtt {
 
 /////////////////////////////////////////////////////////////////////////////
 
+/**
+ * What the client does with an incoming message when the consumer queue
+ * is full.
+ *
+ * This only matters for a bounded queue, such as a
+ * @ref lock_free_consumer_queue, or a @ref thread_consumer_queue created
+ * with a capacity. Blocking holds up the C library's thread, which also
+ * handles the keepalives for the connection, so a consumer that falls far
+ * enough behind can get the client disconnected. The other policies keep
+ * the connection alive by discarding messages, which are counted in the
+ * client's statistics.
+ */
+enum class overflow_policy {
+    /** Wait for room in the queue */
+    BLOCK,
+    /** Discard the incoming message */
+    DROP_NEWEST,
+    /** Discard the oldest events in the queue to make room */
+    DROP_OLDEST,
+    /** Discard an incoming QoS 0 message, but wait for room for QoS 1 & 2 */
+    DROP_QOS0
+};
+
+/////////////////////////////////////////////////////////////////////////////
+
 /** An empty type that can be used as a `persistent_type` variant option. */
 struct no_persistence
 {
@@ -87,6 +125,70 @@ class create_options
     /** The persistence for the client */
     persistence_type persistence_{};
 
+    /** Whether incoming payloads are adopted from the C lib, not copied */
+    bool zeroCopyPayloads_{false};
+
+    /** The number of free blocks to hold in the message pool (0=none) */
+    size_t messagePoolSize_{0};
+    /** The memory resource for incoming messages, if any */
+    std::pmr::memory_resource* memResource_{nullptr};
+    /** The number of free blocks to hold in the token pool (0=none) */
+    size_t tokenPoolSize_{0};
+
+    /** The maximum number of incoming topics to intern (0=none) */
+    size_t maxInternedTopics_{0};
+    /** The maximum number of topic aliases to use for publishing (0=none) */
+    size_t maxTopicAliases_{0};
+    /** Whether to hold back messages past the server's receive maximum */
+    bool flowControl_{false};
+    /** The buffer for messages published while disconnected, if any */
+    offline_buffer_ptr offlineBuffer_{};
+    /** The local cache of retained messages, if any */
+    retained_cache_ptr retainedCache_{};
+    /** The rate limits for the outgoing messages, if any */
+    publish_shaper_ptr publishShaper_{};
+    /** The filter for duplicate incoming messages, if any */
+    dedup_filter_ptr dedupFilter_{};
+    /** The tracker for the sequence numbers of incoming messages, if any */
+    sequence_tracker_ptr seqTracker_{};
+    /** The traffic counters for a set of topic filters, if any */
+    topic_stats_ptr topicStats_{};
+    /** The sampler for incoming messages, if any */
+    message_sampler_ptr sampler_{};
+    /** The reassembler for chunked transfers, if any */
+    chunk_reassembler_ptr reassembler_{};
+    /** The CPUs to pin the C library threads to, if any */
+    cpu_set libAffinity_{};
+    /** How long the waits on tokens and the consumer queue spin */
+    spin_wait spinWait_{};
+    /** The deadline for the operations on the server (0=none) */
+    std::chrono::milliseconds opTimeout_{0};
+    /** The most memory the client can hold for messages (0=no limit) */
+    size_t maxMemory_{0};
+    /** Whether to restore the subscriptions when a session is lost */
+    bool restoreSubs_{false};
+    /** Whether the client loops its messages back, without a server */
+    bool loopback_{false};
+    /** Whether the app acknowledges the incoming QoS 1 & 2 messages */
+    bool manualAck_{false};
+    /** The most unacknowledged incoming messages (0=no limit) */
+    size_t maxUnacked_{0};
+
+    /** The maximum number of messages pending delivery (0=no limit) */
+    size_t maxPendingMessages_{0};
+
+    /** The maximum number of bytes pending delivery (0=no limit) */
+    size_t maxPendingBytes_{0};
+
+    /** The codec for outgoing and incoming payloads, if any */
+    const_payload_codec_ptr payloadCodec_{};
+
+    /** Outgoing payloads larger than this are encoded by the codec */
+    size_t codecThreshold_{0};
+
+    /** What to do with incoming messages when the consumer queue is full */
+    overflow_policy overflowPolicy_{overflow_policy::BLOCK};
+
     /** The client and tests have special access */
     friend class async_client;
     friend class create_options_builder;
@@ -171,7 +273,35 @@ public:
         : opts_{opts.opts_},
           serverURI_{serverURI},
           clientId_{clientId},
-          persistence_{persistence} {}
+          persistence_{persistence},
+          zeroCopyPayloads_{opts.zeroCopyPayloads_},
+          messagePoolSize_{opts.messagePoolSize_},
+          memResource_{opts.memResource_},
+          tokenPoolSize_{opts.tokenPoolSize_},
+          maxInternedTopics_{opts.maxInternedTopics_},
+          maxTopicAliases_{opts.maxTopicAliases_},
+          flowControl_{opts.flowControl_},
+          offlineBuffer_{opts.offlineBuffer_},
+          retainedCache_{opts.retainedCache_},
+          publishShaper_{opts.publishShaper_},
+          dedupFilter_{opts.dedupFilter_},
+          seqTracker_{opts.seqTracker_},
+          topicStats_{opts.topicStats_},
+          sampler_{opts.sampler_},
+          reassembler_{opts.reassembler_},
+          libAffinity_{opts.libAffinity_},
+          spinWait_{opts.spinWait_},
+          opTimeout_{opts.opTimeout_},
+          maxMemory_{opts.maxMemory_},
+          restoreSubs_{opts.restoreSubs_},
+          loopback_{opts.loopback_},
+          manualAck_{opts.manualAck_},
+          maxUnacked_{opts.maxUnacked_},
+          maxPendingMessages_{opts.maxPendingMessages_},
+          maxPendingBytes_{opts.maxPendingBytes_},
+          payloadCodec_{opts.payloadCodec_},
+          codecThreshold_{opts.codecThreshold_},
+          overflowPolicy_{opts.overflowPolicy_} {}
     /**
      * Copy constructor.
      * @param opts The other options.
@@ -180,7 +310,35 @@ public:
         : opts_{opts.opts_},
           serverURI_{opts.serverURI_},
           clientId_{opts.clientId_},
-          persistence_{opts.persistence_} {}
+          persistence_{opts.persistence_},
+          zeroCopyPayloads_{opts.zeroCopyPayloads_},
+          messagePoolSize_{opts.messagePoolSize_},
+          memResource_{opts.memResource_},
+          tokenPoolSize_{opts.tokenPoolSize_},
+          maxInternedTopics_{opts.maxInternedTopics_},
+          maxTopicAliases_{opts.maxTopicAliases_},
+          flowControl_{opts.flowControl_},
+          offlineBuffer_{opts.offlineBuffer_},
+          retainedCache_{opts.retainedCache_},
+          publishShaper_{opts.publishShaper_},
+          dedupFilter_{opts.dedupFilter_},
+          seqTracker_{opts.seqTracker_},
+          topicStats_{opts.topicStats_},
+          sampler_{opts.sampler_},
+          reassembler_{opts.reassembler_},
+          libAffinity_{opts.libAffinity_},
+          spinWait_{opts.spinWait_},
+          opTimeout_{opts.opTimeout_},
+          maxMemory_{opts.maxMemory_},
+          restoreSubs_{opts.restoreSubs_},
+          loopback_{opts.loopback_},
+          manualAck_{opts.manualAck_},
+          maxUnacked_{opts.maxUnacked_},
+          maxPendingMessages_{opts.maxPendingMessages_},
+          maxPendingBytes_{opts.maxPendingBytes_},
+          payloadCodec_{opts.payloadCodec_},
+          codecThreshold_{opts.codecThreshold_},
+          overflowPolicy_{opts.overflowPolicy_} {}
     /**
      * Move constructor.
      * @param opts The other options.
@@ -189,7 +347,35 @@ public:
         : opts_{opts.opts_},
           serverURI_{std::move(opts.serverURI_)},
           clientId_{std::move(opts.clientId_)},
-          persistence_{std::move(opts.persistence_)} {}
+          persistence_{std::move(opts.persistence_)},
+          zeroCopyPayloads_{opts.zeroCopyPayloads_},
+          messagePoolSize_{opts.messagePoolSize_},
+          memResource_{opts.memResource_},
+          tokenPoolSize_{opts.tokenPoolSize_},
+          maxInternedTopics_{opts.maxInternedTopics_},
+          maxTopicAliases_{opts.maxTopicAliases_},
+          flowControl_{opts.flowControl_},
+          offlineBuffer_{opts.offlineBuffer_},
+          retainedCache_{opts.retainedCache_},
+          publishShaper_{opts.publishShaper_},
+          dedupFilter_{opts.dedupFilter_},
+          seqTracker_{opts.seqTracker_},
+          topicStats_{opts.topicStats_},
+          sampler_{opts.sampler_},
+          reassembler_{opts.reassembler_},
+          libAffinity_{opts.libAffinity_},
+          spinWait_{opts.spinWait_},
+          opTimeout_{opts.opTimeout_},
+          maxMemory_{opts.maxMemory_},
+          restoreSubs_{opts.restoreSubs_},
+          loopback_{opts.loopback_},
+          manualAck_{opts.manualAck_},
+          maxUnacked_{opts.maxUnacked_},
+          maxPendingMessages_{opts.maxPendingMessages_},
+          maxPendingBytes_{opts.maxPendingBytes_},
+          payloadCodec_{std::move(opts.payloadCodec_)},
+          codecThreshold_{opts.codecThreshold_},
+          overflowPolicy_{opts.overflowPolicy_} {}
 
     create_options& operator=(const create_options& rhs);
     create_options& operator=(create_options&& rhs);
@@ -304,6 +490,550 @@ public:
      * @param on @em true if QoS 0 messages are persisted, @em false if not.
      */
     void set_persist_qos0(bool on) { opts_.persistQoS0 = to_int(on); }
+    /**
+     * Whether the client adopts the payload buffers of incoming messages
+     * from the C library, rather than copying them.
+     * @return @em true if incoming payloads are not copied, @em false if
+     *  	   they are.
+     */
+    bool get_zero_copy_payloads() const { return zeroCopyPayloads_; }
+    /**
+     * Determine whether the client adopts the payload buffers of incoming
+     * messages from the C library, rather than copying them.
+     *
+     * When enabled, the payload of each incoming message refers directly to
+     * the memory that the C library allocated for it, which is freed when
+     * the last reference to the payload is released. This avoids a copy of
+     * the payload for each message, which can be significant for large
+     * payloads. The payload data should then be read with
+     * `get_payload_ref().data()` and `size()`, since asking for the payload
+     * as a string would create a copy of it.
+     *
+     * @param on @em true to adopt incoming payloads without copying, @em
+     *  		 false to copy them.
+     */
+    void set_zero_copy_payloads(bool on) { zeroCopyPayloads_ = on; }
+    /**
+     * Gets the size of the pool used to recycle incoming messages.
+     * @return The maximum number of free blocks held in the message pool
+     *  	   for each block size. Zero means no pool is used.
+     */
+    size_t get_message_pool_size() const { return messagePoolSize_; }
+    /**
+     * Sets the size of the pool used to recycle incoming messages.
+     *
+     * When set, the client creates incoming messages from a pool of
+     * memory blocks, which are recycled when the last reference to a
+     * message is released, rather than going back to the heap. See
+     * @ref message_pool.
+     *
+     * @param n The maximum number of free blocks held in the message pool
+     *  		for each block size. Zero disables the pool.
+     */
+    void set_message_pool_size(size_t n) { messagePoolSize_ = n; }
+    /**
+     * Gets the memory resource for incoming messages.
+     * @return The memory resource, or null if the messages come from the
+     *  	   heap or the message pool.
+     */
+    std::pmr::memory_resource* get_memory_resource() const { return memResource_; }
+    /**
+     * Sets a memory resource for incoming messages.
+     *
+     * When set, the client creates the incoming messages, with their topic
+     * and payload buffers, from a @ref message_pool that takes its memory
+     * from the resource, such as a monotonic arena that the application
+     * releases in bulk. The message pool size then sets the number of
+     * freed blocks that are recycled, which should be zero for a resource
+     * that only releases in bulk. The resource must outlive the client and
+     * all of the messages that it creates. Payloads adopted from the C
+     * library with zero-copy payloads still come from its heap.
+     *
+     * @param mr The memory resource, or null for the heap.
+     */
+    void set_memory_resource(std::pmr::memory_resource* mr) { memResource_ = mr; }
+    /**
+     * Gets the size of the pool used to recycle delivery tokens.
+     * @return The maximum number of free delivery tokens held in the pool.
+     *  	   Zero means no pool is used.
+     */
+    size_t get_token_pool_size() const { return tokenPoolSize_; }
+    /**
+     * Sets the size of the pool used to recycle delivery tokens.
+     *
+     * When set, the client creates the delivery tokens for published
+     * messages from a pool of memory blocks, which are recycled when the
+     * last reference to a token is released. This saves a heap allocation
+     * and release for each message when publishing at a high rate.
+     *
+     * @param n The maximum number of free delivery tokens held in the
+     *  		pool. Zero disables the pool.
+     */
+    void set_token_pool_size(size_t n) { tokenPoolSize_ = n; }
+    /**
+     * Gets the maximum number of incoming topic names that the client
+     * will intern.
+     * @return The maximum number of interned topics. Zero means that
+     *  	   topics are not interned.
+     */
+    size_t get_max_interned_topics() const { return maxInternedTopics_; }
+    /**
+     * Sets the maximum number of incoming topic names that the client
+     * will intern.
+     *
+     * When set, incoming messages on the same topic share a single topic
+     * string, rather than each message allocating and copying its own.
+     * This helps when an application receives a lot of messages on a
+     * limited set of topics. Once the table is full, messages on any new
+     * topics get their own copy of the topic string. See
+     * @ref string_intern.
+     *
+     * @param n The maximum number of interned topics. Zero disables
+     *  		interning.
+     */
+    void set_max_interned_topics(size_t n) { maxInternedTopics_ = n; }
+    /**
+     * Gets the maximum number of topic aliases that the client will use
+     * for publishing.
+     * @return The maximum number of topic aliases. Zero means that
+     *  	   aliases are not used.
+     */
+    size_t get_max_topic_aliases() const { return maxTopicAliases_; }
+    /**
+     * Sets the maximum number of topic aliases that the client will use
+     * for publishing.
+     *
+     * When set, for an MQTT v5 connection, the client assigns an alias to
+     * each topic that it publishes to, up to the smaller of this and the
+     * Topic Alias Maximum from the server, and sends the later messages to
+     * the topic with just the alias and an empty topic name. When all the
+     * aliases are in use, the one for the least recently published topic
+     * is given to the next new topic. See @ref topic_alias_map.
+     * @par
+     * Aliases are only used for QoS 0 messages sent while the client is
+     * connected. Messages with a higher QoS may be sent again later on
+     * a new connection, where the alias would not be valid. The aliases
+     * are also not applied to messages that already have a Topic Alias
+     * property.
+     *
+     * @param n The maximum number of topic aliases. Zero disables them.
+     */
+    void set_max_topic_aliases(size_t n) { maxTopicAliases_ = n; }
+    /**
+     * Determines whether the client limits the QoS 1 & 2 messages in
+     * flight to the receive maximum of the server.
+     * @return @em true if the client holds back messages past the server's
+     *  	   receive maximum.
+     */
+    bool get_flow_control() const { return flowControl_; }
+    /**
+     * Sets whether the client limits the QoS 1 & 2 messages in flight to
+     * the receive maximum of the server.
+     *
+     * When enabled, the client keeps no more QoS 1 & 2 messages in the C
+     * library than the Receive Maximum that the server gave in the CONNACK,
+     * or 65,535 if it gave none. Any more are held in order in the client,
+     * and sent as the earlier ones are acknowledged. The number waiting is
+     * reported in the @ref client_stats of the client. QoS 0 messages are
+     * not affected. The messages still held back when the application
+     * disconnects fail with MQTTASYNC_DISCONNECTED, and those held when the
+     * client is destroyed fail with MQTTASYNC_OPERATION_INCOMPLETE.
+     *
+     * @param on @em true to hold back messages past the receive maximum,
+     *  		 @em false to pass them all to the C library.
+     */
+    void set_flow_control(bool on) { flowControl_ = on; }
+    /**
+     * Gets the buffer for messages published while disconnected.
+     * @return The offline buffer, or null if there is none.
+     */
+    offline_buffer_ptr get_offline_buffer() const { return offlineBuffer_; }
+    /**
+     * Sets a buffer for messages published while disconnected.
+     *
+     * While the client is disconnected, it puts the messages published with
+     * publish() or try_publish() into the buffer, rather than giving them to
+     * the C library. When it reconnects, it sends the messages from the
+     * buffer in order, at no more than the buffer's drain rate, and their
+     * delivery is reported to the callback. If the buffer is full, the
+     * publish fails with MQTTASYNC_MAX_BUFFERED_MESSAGES. See
+     * @ref offline_buffer.
+     * @par
+     * The token for a message held in memory completes when the message is
+     * delivered, or fails if it can't be sent, or with
+     * MQTTASYNC_OPERATION_INCOMPLETE if the client is destroyed first. A
+     * message that spills to disk can't keep its token, which is complete
+     * as soon as the message is buffered.
+     *
+     * @param buf The offline buffer, or null for none. A buffer should only
+     *  		  be used by one client.
+     */
+    void set_offline_buffer(offline_buffer_ptr buf) { offlineBuffer_ = std::move(buf); }
+    /**
+     * Gets the local cache of retained messages.
+     * @return The retained message cache, or null if there is none.
+     */
+    retained_cache_ptr get_retained_cache() const { return retainedCache_; }
+    /**
+     * Sets a local cache of retained messages.
+     * The client updates the cache with each retained message that it
+     * receives. See @ref retained_cache.
+     * @param cache The retained message cache, or null for none. A cache
+     *  			can be shared by a number of clients.
+     */
+    void set_retained_cache(retained_cache_ptr cache) { retainedCache_ = std::move(cache); }
+    /**
+     * Gets the rate limits for the outgoing messages.
+     * @return The publish shaper, or null if there is none.
+     */
+    publish_shaper_ptr get_publish_shaper() const { return publishShaper_; }
+    /**
+     * Sets rate limits for the outgoing messages, by topic.
+     * The client checks each message that it publishes against the rules
+     * of the shaper, before it's handed to the C library. See
+     * @ref publish_shaper.
+     * @par
+     * The token for a message that the shaper holds completes when the
+     * message is released and delivered, or fails if it can't be sent
+     * then, or with MQTTASYNC_OPERATION_INCOMPLETE if the client is
+     * destroyed first. A held message that is replaced by a later one for
+     * the same topic is never sent, so its token fails with
+     * MQTTASYNC_MAX_BUFFERED_MESSAGES, as does that of a message that is
+     * dropped.
+     *
+     * @param shaper The publish shaper, or null for none. A shaper can be
+     *  			 shared by a number of clients, unless it has rules
+     *  			 that coalesce, since the messages it holds are kept
+     *  			 by topic.
+     */
+    void set_publish_shaper(publish_shaper_ptr shaper) { publishShaper_ = std::move(shaper); }
+    /**
+     * Gets the filter for duplicate incoming messages.
+     * @return The duplicate message filter, or null if there is none.
+     */
+    dedup_filter_ptr get_dedup_filter() const { return dedupFilter_; }
+    /**
+     * Sets a filter for duplicate incoming messages.
+     * The client drops each message that the filter has already seen,
+     * before it reaches the consumer or any of the handlers. See
+     * @ref dedup_filter.
+     * @param filter The duplicate message filter, or null for none. A
+     *  			 filter can be shared by a number of clients.
+     */
+    void set_dedup_filter(dedup_filter_ptr filter) { dedupFilter_ = std::move(filter); }
+    /**
+     * Gets the tracker for the sequence numbers of incoming messages.
+     * @return The sequence tracker, or null if there is none.
+     */
+    sequence_tracker_ptr get_sequence_tracker() const { return seqTracker_; }
+    /**
+     * Sets a tracker for the sequence numbers of incoming messages.
+     * The client checks each message that it receives, and reports the
+     * counts in its statistics. See @ref sequence_tracker.
+     * @param tracker The sequence tracker, or null for none.
+     */
+    void set_sequence_tracker(sequence_tracker_ptr tracker) {
+        seqTracker_ = std::move(tracker);
+    }
+    /**
+     * Gets the traffic counters for a set of topic filters.
+     * @return The topic counters, or null if there are none.
+     */
+    topic_stats_ptr get_topic_stats() const { return topicStats_; }
+    /**
+     * Sets traffic counters for a set of topic filters.
+     * The client counts each message that it sends or receives against
+     * the filters that match its topic, and reports the counts in its
+     * statistics. See @ref topic_stats.
+     * @param stats The topic counters, or null for none. The counters can
+     *  			be shared by a number of clients.
+     */
+    void set_topic_stats(topic_stats_ptr stats) { topicStats_ = std::move(stats); }
+    /**
+     * Gets the sampler for the incoming messages.
+     * @return The message sampler, or null if there is none.
+     */
+    message_sampler_ptr get_message_sampler() const { return sampler_; }
+    /**
+     * Sets a sampler for the incoming messages.
+     * The client checks each message that arrives against the rules of
+     * the sampler as soon as it gets it, and drops the ones that aren't
+     * wanted before doing anything else with them. See
+     * @ref message_sampler.
+     * @param sampler The message sampler, or null for none.
+     */
+    void set_message_sampler(message_sampler_ptr sampler) { sampler_ = std::move(sampler); }
+    /**
+     * Gets the reassembler for chunked transfers.
+     * @return The chunk reassembler, or null if there is none.
+     */
+    chunk_reassembler_ptr get_chunk_reassembler() const { return reassembler_; }
+    /**
+     * Sets a reassembler for chunked transfers.
+     * The client passes each message that it receives through the
+     * reassembler, after the duplicate filter, so that the chunks of a
+     * transfer reach the consumer and the handlers as one whole message.
+     * See @ref chunk_reassembler.
+     * @param reassembler The chunk reassembler, or null for none.
+     */
+    void set_chunk_reassembler(chunk_reassembler_ptr reassembler) {
+        reassembler_ = std::move(reassembler);
+    }
+    /**
+     * Gets the CPUs that the C library threads are pinned to.
+     * @return The CPUs for the library threads, or an empty set if they
+     *  	   aren't pinned.
+     */
+    const cpu_set& get_library_affinity() const { return libAffinity_; }
+    /**
+     * Sets the CPUs to pin the C library threads to.
+     *
+     * The C library starts its own threads to send and receive packets,
+     * which the application can't reach directly. Instead, the client pins
+     * each of them the first time it calls into one of the client's
+     * callbacks, such as on a connect or the arrival of a message. The
+     * library's threads are shared by all the clients in the process, so
+     * they are pinned by the first client with a set that they call into.
+     * See @ref cpu_set.
+     *
+     * @param cpus The CPUs for the library threads. An empty set leaves
+     *  		   them as they are.
+     */
+    void set_library_affinity(const cpu_set& cpus) { libAffinity_ = cpus; }
+    /**
+     * Gets the policy for spinning before a wait blocks.
+     * @return The spin-then-block policy for the client's waits.
+     */
+    const spin_wait& get_spin_wait() const { return spinWait_; }
+    /**
+     * Sets the policy for spinning before a wait blocks.
+     *
+     * This applies to the waits on the client's tokens, and to the
+     * consumer queue, when the client starts consuming. A thread that
+     * waits for a publish to be acknowledged or for the next message
+     * first spins and yields, checking for it, and only then sleeps. This
+     * can shave microseconds off the latency for a thread with a core to
+     * itself, but burns that core while it waits, so it is off by default.
+     *
+     * @param sw The spin-then-block policy for the client's waits.
+     */
+    void set_spin_wait(const spin_wait& sw) { spinWait_ = sw; }
+    /**
+     * Gets the deadline for the operations on the server.
+     * @return The time that a publish, subscribe, or unsubscribe has to
+     *  	   complete before it fails with a timeout. Zero means there
+     *  	   is no deadline.
+     */
+    std::chrono::milliseconds get_operation_timeout() const { return opTimeout_; }
+    /**
+     * Sets the deadline for the operations on the server.
+     *
+     * Each publish, subscribe, and unsubscribe that hasn't completed in
+     * this time is failed with a @ref timeout_error, by a single timer
+     * thread for the client, rather than by the threads that wait on the
+     * tokens. See async_client::set_deadline().
+     *
+     * @param timeout The deadline for each operation. Zero means there is
+     *  			  no deadline.
+     */
+    template <class Rep, class Period>
+    void set_operation_timeout(const std::chrono::duration<Rep, Period>& timeout) {
+        opTimeout_ = to_milliseconds(timeout);
+    }
+    /**
+     * Gets the maximum number of published messages that can be pending
+     * delivery at any time.
+     * @return The maximum number of pending messages. Zero means there is
+     *  	   no limit.
+     */
+    size_t get_max_pending_messages() const { return maxPendingMessages_; }
+    /**
+     * Sets the maximum number of published messages that can be pending
+     * delivery at any time.
+     *
+     * When set, the client keeps a @ref publish_window of messages that
+     * are pending delivery. Once it is full, publish() blocks until the
+     * delivery of earlier messages completes, and try_publish() returns a
+     * null token.
+     *
+     * @param n The maximum number of pending messages. Zero means there
+     *  		is no limit.
+     */
+    void set_max_pending_messages(size_t n) { maxPendingMessages_ = n; }
+    /**
+     * Gets the maximum number of bytes of published messages that can be
+     * pending delivery at any time.
+     * @return The maximum number of pending bytes. Zero means there is no
+     *  	   limit.
+     */
+    size_t get_max_pending_bytes() const { return maxPendingBytes_; }
+    /**
+     * Sets the maximum number of bytes of published messages that can be
+     * pending delivery at any time.
+     * The size of a message is the size of its topic and payload.
+     * @param n The maximum number of pending bytes. Zero means there is
+     *  		no limit.
+     * @sa set_max_pending_messages()
+     */
+    void set_max_pending_bytes(size_t n) { maxPendingBytes_ = n; }
+    /**
+     * Gets the most memory that the client can hold for messages.
+     * @return The memory budget for the client, in bytes. Zero means there
+     *  	   is no limit.
+     */
+    size_t get_max_memory() const { return maxMemory_; }
+    /**
+     * Sets the most memory that the client can hold for messages.
+     *
+     * This is a budget for the outgoing messages that are waiting for
+     * their delivery to complete, together with the incoming messages in
+     * the consumer queue, as counted by message::memory_size(). Once it is
+     * used up, publish() blocks until deliveries complete and release some
+     * of it, and try_publish() returns a null token. An incoming message
+     * that doesn't fit is handled by the overflow policy, as if the
+     * consumer queue were full. Since the budget is shared, a consumer
+     * that falls behind also holds up the publishers. The offline buffer
+     * has limits of its own, and isn't counted.
+     *
+     * The memory held at any time is reported in the client's statistics.
+     * Without a budget, this is only the outgoing messages, since the
+     * consumer queue isn't metered.
+     *
+     * @param n The memory budget, in bytes. Zero means there is no limit.
+     * @sa set_overflow_policy()
+     */
+    void set_max_memory(size_t n) { maxMemory_ = n; }
+    /**
+     * Determines whether the client restores its subscriptions after it
+     * reconnects without a session.
+     * @return @em true if the client restores its subscriptions.
+     */
+    bool get_restore_subscriptions() const { return restoreSubs_; }
+    /**
+     * Sets whether the client restores its subscriptions after it
+     * reconnects without a session.
+     *
+     * When enabled, the client keeps track of the filters that it is
+     * subscribed to, with their QoS and subscribe options. Whenever it
+     * connects and the server reports no session present, such as after a
+     * failover to another server, it subscribes to all of them again, in
+     * pipelined chunks as with async_client::subscribe_bulk(). This is
+     * done on the library thread that reports the connection, before the
+     * connected callbacks are run and the connected event is queued. The
+     * result is reported through async_client::get_restore_token().
+     * @par
+     * A subscribe made while the client is disconnected still throws, but
+     * the filter is tracked, and is sent when the client connects.
+     *
+     * @param on @em true to restore the subscriptions after a reconnect.
+     */
+    void set_restore_subscriptions(bool on) { restoreSubs_ = on; }
+    /**
+     * Determines whether the client is in loopback mode.
+     * @return @em true if the client loops its messages back to itself.
+     */
+    bool get_loopback() const { return loopback_; }
+    /**
+     * Sets whether the client is in loopback mode.
+     *
+     * In loopback mode the client never talks to a server. Connecting and
+     * disconnecting complete right away, subscribing and unsubscribing
+     * succeed without a response, and each message that is published is
+     * delivered back to the client as an arrival, through the same path
+     * as a message from the server, whether or not it matches a
+     * subscription. The publish completes once the message is delivered.
+     * @par
+     * This is meant for benchmarks and tests of the library itself, to
+     * measure the cost of the messages, tokens, and queues without the
+     * noise of a network and a server. The arrival is processed on the
+     * thread that publishes, before the publish returns, so a callback
+     * that publishes in turn recurses, and a full, blocking consumer
+     * queue would block the publisher.
+     *
+     * @param on @em true to loop the messages back to the client.
+     */
+    void set_loopback(bool on) { loopback_ = on; }
+    /**
+     * Determines whether the application acknowledges the incoming QoS 1
+     * and 2 messages.
+     * @return @em true if the client is in manual acknowledgment mode.
+     */
+    bool get_manual_ack() const { return manualAck_; }
+    /**
+     * Gets the most incoming messages that can be waiting for the
+     * application to acknowledge them.
+     * @return The most unacknowledged messages, or zero for no limit.
+     */
+    size_t get_max_unacked() const { return maxUnacked_; }
+    /**
+     * Sets whether the application acknowledges the incoming QoS 1 and 2
+     * messages, once it's done with them.
+     *
+     * In manual acknowledgment mode, the client keeps each incoming QoS 1
+     * or 2 message from the time it arrives until the application
+     * acknowledges it with async_client::ack() or, for all the messages
+     * up to one, async_client::ack_through(). So the messages can be
+     * handled on other threads, and in batches, while the ones not yet
+     * done are always available from async_client::get_unacked().
+     * @par
+     * The C library takes in a message, and acknowledges it to the server,
+     * before it's handed to this client, so the acknowledgment can't be
+     * held back from the server. What can be held back is the client
+     * taking the message from the C library. Once the limit of
+     * unacknowledged messages is reached, the client refuses any more,
+     * which leaves them in the C library, and in its persistence store if
+     * it has one, to be offered again later. So with a limit and a
+     * persistent client, no more than that number of messages are only in
+     * memory at any time.
+     *
+     * @param on @em true for the application to acknowledge the messages.
+     * @param maxUnacked The most unacknowledged messages, or zero for no
+     *  				 limit.
+     */
+    void set_manual_ack(bool on, size_t maxUnacked = 0) {
+        manualAck_ = on;
+        maxUnacked_ = maxUnacked;
+    }
+    /**
+     * Gets the codec used to transform message payloads.
+     * @return The payload codec, or a null pointer if there is none.
+     */
+    const_payload_codec_ptr get_payload_codec() const { return payloadCodec_; }
+    /**
+     * Gets the payload size over which outgoing messages are encoded.
+     * @return The size threshold, in bytes, for encoding payloads.
+     */
+    size_t get_payload_codec_threshold() const { return codecThreshold_; }
+    /**
+     * Sets a codec to transform message payloads, such as to compress
+     * them.
+     *
+     * Outgoing payloads larger than the threshold are encoded and tagged
+     * with a user property, and incoming messages with the tag are
+     * decoded, before the app sees them. This only applies to MQTT v5
+     * connections, since the tag is a property. See @ref payload_codec.
+     *
+     * @param codec The payload codec. A null pointer disables encoding.
+     * @param threshold Outgoing payloads larger than this number of bytes
+     *  				are encoded. Smaller ones are sent as they are.
+     */
+    void set_payload_codec(const_payload_codec_ptr codec, size_t threshold = 0) {
+        payloadCodec_ = std::move(codec);
+        codecThreshold_ = threshold;
+    }
+    /**
+     * Gets the policy for incoming messages when the consumer queue is
+     * full.
+     * @return The overflow policy for the consumer queue.
+     */
+    overflow_policy get_overflow_policy() const { return overflowPolicy_; }
+    /**
+     * Sets the policy for incoming messages when the consumer queue is
+     * full.
+     * @param policy The overflow policy for the consumer queue.
+     * @sa overflow_policy
+     */
+    void set_overflow_policy(overflow_policy policy) { overflowPolicy_ = policy; }
 };
 
 /** Smart/shared pointer to a connection options object. */
@@ -417,6 +1147,276 @@ public:
         opts_.opts_.persistQoS0 = to_int(on);
         return *this;
     }
+    /**
+     * Whether the client adopts the payload buffers of incoming messages
+     * from the C library, rather than copying them. (Defaults false)
+     *
+     * @param on @em true to adopt incoming payloads without copying, @em
+     *  		 false to copy them.
+     * @return A reference to this object
+     */
+    auto zero_copy_payloads(bool on = true) -> self& {
+        opts_.zeroCopyPayloads_ = on;
+        return *this;
+    }
+    /**
+     * Sets the size of the pool used to recycle incoming messages.
+     *
+     * @param n The maximum number of free blocks held in the message pool
+     *  		for each block size. Zero disables the pool.
+     * @return A reference to this object
+     */
+    auto message_pool_size(size_t n) -> self& {
+        opts_.messagePoolSize_ = n;
+        return *this;
+    }
+    /**
+     * Sets a memory resource for incoming messages.
+     * See create_options::set_memory_resource().
+     * @param mr The memory resource, or null for the heap.
+     * @return A reference to this object
+     */
+    auto memory_resource(std::pmr::memory_resource* mr) -> self& {
+        opts_.memResource_ = mr;
+        return *this;
+    }
+    /**
+     * Sets the size of the pool used to recycle delivery tokens.
+     *
+     * @param n The maximum number of free delivery tokens held in the
+     *  		pool. Zero disables the pool.
+     * @return A reference to this object
+     */
+    auto token_pool_size(size_t n) -> self& {
+        opts_.tokenPoolSize_ = n;
+        return *this;
+    }
+    /**
+     * Sets the maximum number of incoming topic names that the client
+     * will intern.
+     *
+     * @param n The maximum number of interned topics. Zero disables
+     *  		interning.
+     * @return A reference to this object
+     */
+    auto max_interned_topics(size_t n) -> self& {
+        opts_.maxInternedTopics_ = n;
+        return *this;
+    }
+    /**
+     * Sets the maximum number of topic aliases that the client will use
+     * for publishing.
+     *
+     * @param n The maximum number of topic aliases. Zero disables them.
+     * @return A reference to this object
+     */
+    auto max_topic_aliases(size_t n) -> self& {
+        opts_.maxTopicAliases_ = n;
+        return *this;
+    }
+    /**
+     * Sets whether the client limits the QoS 1 & 2 messages in flight to
+     * the receive maximum of the server.
+     *
+     * @param on @em true to hold back messages past the receive maximum,
+     *  		 @em false to pass them all to the C library.
+     * @return A reference to this object
+     */
+    auto flow_control(bool on = true) -> self& {
+        opts_.flowControl_ = on;
+        return *this;
+    }
+    /**
+     * Sets a buffer for messages published while disconnected.
+     * @param buf The offline buffer, or null for none.
+     * @return A reference to this object
+     */
+    auto offline_buffer(offline_buffer_ptr buf) -> self& {
+        opts_.set_offline_buffer(std::move(buf));
+        return *this;
+    }
+    /**
+     * Sets a local cache of retained messages.
+     * @param cache The retained message cache, or null for none.
+     * @return A reference to this object
+     */
+    auto retained_cache(retained_cache_ptr cache) -> self& {
+        opts_.set_retained_cache(std::move(cache));
+        return *this;
+    }
+    /**
+     * Sets rate limits for the outgoing messages, by topic.
+     * @param shaper The publish shaper, or null for none.
+     * @return A reference to this object
+     */
+    auto publish_shaper(publish_shaper_ptr shaper) -> self& {
+        opts_.set_publish_shaper(std::move(shaper));
+        return *this;
+    }
+    /**
+     * Sets a filter for duplicate incoming messages.
+     * @param filter The duplicate message filter, or null for none.
+     * @return A reference to this object
+     */
+    auto dedup_filter(dedup_filter_ptr filter) -> self& {
+        opts_.set_dedup_filter(std::move(filter));
+        return *this;
+    }
+    /**
+     * Sets a tracker for the sequence numbers of incoming messages.
+     * @param tracker The sequence tracker, or null for none.
+     * @return A reference to this object
+     */
+    auto sequence_tracker(sequence_tracker_ptr tracker) -> self& {
+        opts_.set_sequence_tracker(std::move(tracker));
+        return *this;
+    }
+    /**
+     * Sets traffic counters for a set of topic filters.
+     * @param stats The topic counters, or null for none.
+     * @return A reference to this object
+     */
+    auto topic_stats(topic_stats_ptr stats) -> self& {
+        opts_.set_topic_stats(std::move(stats));
+        return *this;
+    }
+    /**
+     * Sets a sampler for the incoming messages.
+     * @param sampler The message sampler, or null for none.
+     * @return A reference to this object
+     */
+    auto message_sampler(message_sampler_ptr sampler) -> self& {
+        opts_.set_message_sampler(std::move(sampler));
+        return *this;
+    }
+    /**
+     * Sets a reassembler for chunked transfers.
+     * @param reassembler The chunk reassembler, or null for none.
+     * @return A reference to this object
+     */
+    auto chunk_reassembler(chunk_reassembler_ptr reassembler) -> self& {
+        opts_.set_chunk_reassembler(std::move(reassembler));
+        return *this;
+    }
+    /**
+     * Sets the CPUs to pin the C library threads to.
+     * @param cpus The CPUs for the library threads.
+     * @return A reference to this object
+     */
+    auto library_affinity(const cpu_set& cpus) -> self& {
+        opts_.set_library_affinity(cpus);
+        return *this;
+    }
+    /**
+     * Sets the policy for spinning before a wait blocks.
+     * @param nSpins The number of times to spin, pausing the CPU.
+     * @param nYields The number of times to yield the CPU after that.
+     * @return A reference to this object
+     */
+    auto spin_wait(unsigned nSpins, unsigned nYields = 0) -> self& {
+        opts_.set_spin_wait(mqtt::spin_wait{nSpins, nYields});
+        return *this;
+    }
+    /**
+     * Sets the deadline for the operations on the server.
+     * @param timeout The deadline for each publish, subscribe, and
+     *  			  unsubscribe. Zero means there is no deadline.
+     * @return A reference to this object
+     */
+    template <class Rep, class Period>
+    auto operation_timeout(const std::chrono::duration<Rep, Period>& timeout) -> self& {
+        opts_.set_operation_timeout(timeout);
+        return *this;
+    }
+    /**
+     * Sets the maximum number of published messages that can be pending
+     * delivery at any time.
+     * @param n The maximum number of pending messages. Zero means there
+     *  		is no limit.
+     * @return A reference to this object
+     */
+    auto max_pending_messages(size_t n) -> self& {
+        opts_.maxPendingMessages_ = n;
+        return *this;
+    }
+    /**
+     * Sets the maximum number of bytes of published messages that can be
+     * pending delivery at any time.
+     * @param n The maximum number of pending bytes. Zero means there is
+     *  		no limit.
+     * @return A reference to this object
+     */
+    auto max_pending_bytes(size_t n) -> self& {
+        opts_.maxPendingBytes_ = n;
+        return *this;
+    }
+    /**
+     * Sets the most memory that the client can hold for messages.
+     * See create_options::set_max_memory().
+     * @param n The memory budget, in bytes. Zero means there is no limit.
+     * @return A reference to this object
+     */
+    auto max_memory(size_t n) -> self& {
+        opts_.maxMemory_ = n;
+        return *this;
+    }
+    /**
+     * Sets whether the client restores its subscriptions after it
+     * reconnects without a session.
+     * See create_options::set_restore_subscriptions().
+     * @param on @em true to restore the subscriptions after a reconnect.
+     * @return A reference to this object
+     */
+    auto restore_subscriptions(bool on = true) -> self& {
+        opts_.restoreSubs_ = on;
+        return *this;
+    }
+    /**
+     * Sets whether the client is in loopback mode, echoing the messages
+     * that it publishes back to itself, without a server.
+     * See create_options::set_loopback().
+     * @param on @em true to loop the messages back to the client.
+     * @return A reference to this object
+     */
+    auto loopback(bool on = true) -> self& {
+        opts_.loopback_ = on;
+        return *this;
+    }
+    /**
+     * Puts the client in manual acknowledgment mode, where the application
+     * acknowledges the incoming QoS 1 & 2 messages once it's done with
+     * them.
+     * See create_options::set_manual_ack().
+     * @param maxUnacked The most unacknowledged messages, or zero for no
+     *  				 limit.
+     * @return A reference to this object
+     */
+    auto manual_ack(size_t maxUnacked = 0) -> self& {
+        opts_.set_manual_ack(true, maxUnacked);
+        return *this;
+    }
+    /**
+     * Sets a codec to transform message payloads, such as to compress
+     * them.
+     * @param codec The payload codec.
+     * @param threshold Outgoing payloads larger than this number of bytes
+     *  				are encoded.
+     * @return A reference to this object
+     */
+    auto payload_codec(const_payload_codec_ptr codec, size_t threshold = 0) -> self& {
+        opts_.set_payload_codec(std::move(codec), threshold);
+        return *this;
+    }
+    /**
+     * Sets the policy for incoming messages when the consumer queue is
+     * full.
+     * @param policy The overflow policy for the consumer queue.
+     * @return A reference to this object
+     */
+    auto overflow_policy(mqtt::overflow_policy policy) -> self& {
+        opts_.overflowPolicy_ = policy;
+        return *this;
+    }
     /**
      * Finish building the options and return them.
      * @return The option struct as built.
@@ -0,0 +1,220 @@
+/////////////////////////////////////////////////////////////////////////////
+/// @file credential_provider.h
+/// Declaration of MQTT credential_provider class
+/// @author Frank Pagliughi
+/////////////////////////////////////////////////////////////////////////////
+
+/*******************************************************************************
+ * Copyright (c) 2025 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+
+#ifndef __mqtt_credential_provider_h
+#define __mqtt_credential_provider_h
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "mqtt/rcu_ptr.h"
+#include "mqtt/types.h"
+
+namespace mqtt {
+
+/////////////////////////////////////////////////////////////////////////////
+
+/**
+ * The credentials for a connection to the server.
+ */
+struct credentials
+{
+    /** The clock for the expiry time, like that of a JWT */
+    using clock = std::chrono::system_clock;
+
+    /** The user name */
+    string userName;
+    /** The password, or token */
+    binary password;
+    /** The time that the credentials expire */
+    clock::time_point expires{clock::time_point::max()};
+};
+
+/** Smart/shared pointer to a const set of credentials */
+using credentials_ptr = std::shared_ptr<const credentials>;
+
+/////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Interface for an object that supplies the credentials for each
+ * connection attempt of a client.
+ *
+ * The client asks the provider for the credentials from the library's
+ * thread, just before it connects, including each automatic reconnect.
+ * So get_credentials() must not block, such as on a request to mint a
+ * token. It should hand out credentials that were made ahead of time, as
+ * @ref refreshing_credential_provider does. See
+ * async_client::set_credential_provider().
+ */
+class credential_provider
+{
+public:
+    /** Smart/shared pointer to an object of this class. */
+    using ptr_t = std::shared_ptr<credential_provider>;
+
+    /**
+     * Virtual destructor.
+     */
+    virtual ~credential_provider() {}
+    /**
+     * Gets the credentials for a connection.
+     * This is called on the library's thread, and must not block.
+     * @return The credentials, or a null pointer to leave those of the
+     *  	   connection as they are.
+     */
+    virtual credentials_ptr get_credentials() const = 0;
+};
+
+/** Smart/shared pointer to a credential provider */
+using credential_provider_ptr = credential_provider::ptr_t;
+
+/////////////////////////////////////////////////////////////////////////////
+
+/**
+ * A credential provider that keeps a cached set of credentials, and makes
+ * new ones on a thread of its own before they expire.
+ *
+ * An application function mints the credentials, such as by getting a
+ * JWT from an auth service. It is called once by the constructor, so the
+ * provider always has credentials, and then again some time ahead of the
+ * expiry of each set, so that a reconnect never waits for one. If minting
+ * fails by throwing an exception, the last credentials are kept and it is
+ * tried again after a delay. A single provider can be shared by any number
+ * of clients, such as a pool of simulated devices with the same account.
+ *
+ * @code
+ *     auto creds = std::make_shared<mqtt::refreshing_credential_provider>(
+ *         [] {
+ *             auto jwt = mint_jwt();
+ *             return mqtt::credentials{"device", jwt.token, jwt.expires};
+ *         }
+ *     );
+ *     cli.set_credential_provider(creds);
+ * @endcode
+ */
+class refreshing_credential_provider : public credential_provider
+{
+public:
+    /** The function to mint a new set of credentials */
+    using mint_function = std::function<credentials()>;
+    /** The type for the times before expiry and between attempts */
+    using duration = std::chrono::steady_clock::duration;
+
+    /** The default time before expiry to make new credentials */
+    static constexpr std::chrono::seconds DFLT_LEAD_TIME{60};
+    /** The default time to wait after a failure to mint them */
+    static constexpr std::chrono::seconds DFLT_RETRY_INTERVAL{5};
+
+private:
+    /** Lock guard type for this class */
+    using guard = std::lock_guard<std::mutex>;
+    /** Unique lock type for this class */
+    using unique_guard = std::unique_lock<std::mutex>;
+
+    /** The function to mint the credentials */
+    mint_function mint_;
+    /** The time before expiry to make new credentials */
+    duration leadTime_;
+    /** The time to wait after a failure */
+    duration retryInterval_;
+    /** The current credentials */
+    rcu_ptr<credentials> creds_;
+    /** The number of times the credentials were made */
+    std::atomic<uint64_t> nRefreshes_{0};
+    /** The number of times minting them failed */
+    std::atomic<uint64_t> nFailures_{0};
+    /** Lock for the refresh thread */
+    std::mutex lock_;
+    /** Condition to wake the refresh thread */
+    std::condition_variable cond_;
+    /** Whether a refresh was asked for right away */
+    bool refreshNow_{false};
+    /** Whether the thread should stop */
+    bool stop_{false};
+    /** The thread that refreshes the credentials */
+    std::thread thr_;
+
+    /**
+     * Mints a new set of credentials.
+     * @return @em true on success, @em false if the function threw.
+     */
+    bool mint();
+    /** The refresh thread function */
+    void run();
+
+public:
+    /**
+     * Creates the provider, minting the first set of credentials.
+     * @param mint The function to mint the credentials.
+     * @param leadTime The time before the credentials expire to make new
+     *  			   ones.
+     * @param retryInterval The time to wait after a failure to mint them,
+     *  					before trying again.
+     * @throw Whatever the mint function throws for the first set.
+     */
+    explicit refreshing_credential_provider(
+        mint_function mint, duration leadTime = DFLT_LEAD_TIME,
+        duration retryInterval = DFLT_RETRY_INTERVAL
+    );
+    /**
+     * Destructor. This stops the refresh thread.
+     */
+    ~refreshing_credential_provider() override;
+
+    refreshing_credential_provider(const refreshing_credential_provider&) = delete;
+    refreshing_credential_provider& operator=(const refreshing_credential_provider&) = delete;
+
+    /**
+     * Gets the current credentials.
+     * This is lock-free, and never waits on minting.
+     * @return The current credentials.
+     */
+    credentials_ptr get_credentials() const override { return creds_.load(); }
+    /**
+     * Asks for a new set of credentials to be made right away, such as
+     * after the server rejected the current ones. This doesn't wait for
+     * them.
+     */
+    void refresh();
+    /**
+     * Gets the number of times that the credentials were made.
+     * @return The number of successful calls to the mint function.
+     */
+    uint64_t refreshes() const { return nRefreshes_.load(std::memory_order_relaxed); }
+    /**
+     * Gets the number of times that minting the credentials failed.
+     * @return The number of calls to the mint function that threw.
+     */
+    uint64_t failures() const { return nFailures_.load(std::memory_order_relaxed); }
+};
+
+/////////////////////////////////////////////////////////////////////////////
+}  // namespace mqtt
+
+#endif  // __mqtt_credential_provider_h
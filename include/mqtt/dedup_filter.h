@@ -0,0 +1,196 @@
+/////////////////////////////////////////////////////////////////////////////
+/// @file dedup_filter.h
+/// Declaration of MQTT dedup_filter class
+/// @author Frank Pagliughi
+/////////////////////////////////////////////////////////////////////////////
+
+/*******************************************************************************
+ * Copyright (c) 2025 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+
+#ifndef __mqtt_dedup_filter_h
+#define __mqtt_dedup_filter_h
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <unordered_set>
+
+#include "mqtt/message.h"
+
+namespace mqtt {
+
+/////////////////////////////////////////////////////////////////////////////
+
+/**
+ * A filter that drops incoming messages that were already received.
+ *
+ * After a reconnect, the server sends again any QoS 1 messages that it
+ * didn't see acknowledged, and the publisher itself might send a message
+ * more than once. When given to a client in the create options, the
+ * client checks each message that it receives against the filter, and
+ * drops the ones that it has already seen, before they reach the consumer
+ * queue or any of the message handlers.
+ * @par
+ * Each message is reduced to a 64-bit key by a function given to the
+ * constructor. The default is a hash of the topic and payload, so that a
+ * message is a duplicate if the same payload arrived on the same topic
+ * within the window. If the publisher tags each message with an ID, in a
+ * user property, use by_user_property() instead, which only drops a
+ * message with the same ID. A key of zero means the message isn't checked.
+ * @par
+ * The filter remembers the keys of the most recent messages, up to a
+ * maximum number of them, and optionally for a maximum time, so that its
+ * memory is bounded. A duplicate that arrives after its key was forgotten
+ * gets through. The filter can be shared by a number of clients, and is
+ * safe to use from any thread.
+ */
+class dedup_filter
+{
+public:
+    /** Smart/shared pointer to an object of this class. */
+    using ptr_t = std::shared_ptr<dedup_filter>;
+    /** The clock for the time window */
+    using clock = std::chrono::steady_clock;
+    /** The type of function to get the key for a message */
+    using key_function = std::function<uint64_t(const message&)>;
+
+    /** The default number of keys that are remembered */
+    static constexpr size_t DFLT_MAX_SIZE = 4096;
+
+private:
+    /** A key and the time it was seen */
+    struct entry
+    {
+        uint64_t key;
+        clock::time_point time;
+    };
+
+    /** Lock for the keys */
+    mutable std::mutex lock_;
+    /** The keys that were seen, oldest first */
+    std::deque<entry> order_;
+    /** The keys that were seen, for lookup */
+    std::unordered_set<uint64_t> keys_;
+    /** The most keys that are remembered */
+    size_t maxSize_;
+    /** How long a key is remembered, or zero for no limit */
+    clock::duration window_;
+    /** The function to get the key for a message */
+    key_function keyFunc_;
+    /** The number of duplicates found */
+    uint64_t nDuplicates_{0};
+
+    /** Forgets the keys that are past the window (unsafe) */
+    void expire(clock::time_point now);
+
+public:
+    /**
+     * Creates a filter.
+     * @param maxSize The most keys to remember. The minimum is 1.
+     * @param window How long to remember a key. If this is zero, a key is
+     *  			 only forgotten when it is pushed out by newer ones.
+     * @param keyFunc The function to get the key for a message. If this is
+     *  			  empty, a hash of the topic and payload is used.
+     */
+    explicit dedup_filter(
+        size_t maxSize = DFLT_MAX_SIZE, clock::duration window = clock::duration::zero(),
+        key_function keyFunc = key_function{}
+    );
+    /**
+     * Creates a filter.
+     * @param maxSize The most keys to remember. The minimum is 1.
+     * @param window How long to remember a key, or zero for no limit.
+     * @param keyFunc The function to get the key for a message. If this is
+     *  			  empty, a hash of the topic and payload is used.
+     * @return A shared pointer to the new filter.
+     */
+    static ptr_t create(
+        size_t maxSize = DFLT_MAX_SIZE, clock::duration window = clock::duration::zero(),
+        key_function keyFunc = key_function{}
+    ) {
+        return std::make_shared<dedup_filter>(maxSize, window, std::move(keyFunc));
+    }
+    /**
+     * Gets a function that keys a message by a hash of its topic and
+     * payload.
+     * @return A function to get the key for a message.
+     */
+    static key_function by_payload();
+    /**
+     * Gets a function that keys a message by the value of a user property,
+     * like a message ID set by the publisher. A message without the
+     * property isn't checked.
+     * @param name The name of the user property.
+     * @return A function to get the key for a message.
+     */
+    static key_function by_user_property(const string& name);
+    /**
+     * Checks a message against the filter, and remembers it.
+     * @param msg The message.
+     * @return @em true if a message with the same key was already seen
+     *  	   within the window, @em false if it is new.
+     */
+    bool is_duplicate(const message& msg);
+    /**
+     * Checks a key against the filter, and remembers it.
+     * @param key The key for a message. Zero is never a duplicate.
+     * @return @em true if the key was already seen within the window,
+     *  	   @em false if it is new.
+     */
+    bool is_duplicate_key(uint64_t key);
+    /**
+     * Gets the number of keys that are remembered.
+     * @return The number of keys that are remembered.
+     */
+    size_t size() const {
+        std::lock_guard<std::mutex> g{lock_};
+        return keys_.size();
+    }
+    /**
+     * Gets the most keys that are remembered.
+     * @return The most keys that are remembered.
+     */
+    size_t max_size() const { return maxSize_; }
+    /**
+     * Gets how long a key is remembered.
+     * @return How long a key is remembered, or zero for no limit.
+     */
+    clock::duration window() const { return window_; }
+    /**
+     * Gets the number of duplicates that the filter has found.
+     * @return The number of duplicates found.
+     */
+    uint64_t duplicates() const {
+        std::lock_guard<std::mutex> g{lock_};
+        return nDuplicates_;
+    }
+    /**
+     * Forgets all the keys.
+     */
+    void clear();
+};
+
+/** Smart/shared pointer to a duplicate message filter */
+using dedup_filter_ptr = dedup_filter::ptr_t;
+
+/////////////////////////////////////////////////////////////////////////////
+}  // namespace mqtt
+
+#endif  // __mqtt_dedup_filter_h
@@ -24,6 +24,7 @@
 #ifndef __mqtt_delivery_token_h
 #define __mqtt_delivery_token_h
 
+#include <chrono>
 #include <memory>
 
 #include "MQTTAsync.h"
@@ -43,6 +44,20 @@ class delivery_token : public token
 {
     /** The message being tracked. */
     const_message_ptr msg_;
+    /** The time that the message was sent, for the client's statistics */
+    std::chrono::steady_clock::time_point sendTime_;
+    /** Whether the client is tracing this message */
+    bool traced_{false};
+    /** Whether the message counts against the server's receive maximum */
+    bool inFlight_{false};
+    /** The bytes charged to the client's memory budget */
+    size_t memCharge_{0};
+    /** The time that the client started tracking the token */
+    std::chrono::steady_clock::time_point pendingSince_;
+    /** The next older token in the client's list of pending tokens */
+    delivery_token* olderPending_{nullptr};
+    /** The next newer token in the client's list of pending tokens */
+    delivery_token* newerPending_{nullptr};
 
     /** Client has special access. */
     friend class async_client;
@@ -129,6 +144,72 @@ using delivery_token_ptr = delivery_token::ptr_t;
 /** Smart/shared pointer to a const delivery_token */
 using const_delivery_token_ptr = delivery_token::const_ptr_t;
 
+/////////////////////////////////////////////////////////////////////////////
+
+/**
+ * The result of a publish that reports errors without throwing.
+ *
+ * This holds either the delivery token for a message that was accepted
+ * for sending, or the error code for one that wasn't, like the
+ * `std::expected` of C++23.
+ *
+ * @code
+ *     auto res = cli.try_publish(msg, std::nothrow);
+ *     if (!res)
+ *         handle_error(res.error());
+ * @endcode
+ */
+class publish_result
+{
+    /** The token, if the message was accepted */
+    delivery_token_ptr tok_;
+    /** The return code */
+    int rc_{MQTTASYNC_SUCCESS};
+
+public:
+    /**
+     * Creates a successful result.
+     * @param tok The token for the message.
+     */
+    publish_result(delivery_token_ptr tok) noexcept : tok_{std::move(tok)} {}
+    /**
+     * Creates a failed result.
+     * @param rc The error code.
+     */
+    publish_result(int rc) noexcept : rc_{rc} {}
+    /**
+     * Determines if the message was accepted for sending.
+     * @return @em true if the message was accepted.
+     */
+    bool ok() const noexcept { return rc_ == MQTTASYNC_SUCCESS; }
+    /**
+     * Determines if the message was accepted for sending.
+     * @return @em true if the message was accepted.
+     */
+    explicit operator bool() const noexcept { return ok(); }
+    /**
+     * Gets the return code.
+     * @return MQTTASYNC_SUCCESS if the message was accepted, otherwise the
+     *  	   error code.
+     */
+    int error() const noexcept { return rc_; }
+    /**
+     * Gets the token to track the delivery of the message.
+     * @return The delivery token, or null if the publish failed.
+     */
+    const delivery_token_ptr& token() const noexcept { return tok_; }
+    /**
+     * Gets the token to track the delivery of the message.
+     * @return The delivery token, or null if the publish failed.
+     */
+    const delivery_token_ptr& operator*() const noexcept { return tok_; }
+    /**
+     * Gets the token to track the delivery of the message.
+     * @return A pointer to the delivery token.
+     */
+    delivery_token* operator->() const noexcept { return tok_.get(); }
+};
+
 /////////////////////////////////////////////////////////////////////////////
 }  // namespace mqtt
 
@@ -0,0 +1,223 @@
+/////////////////////////////////////////////////////////////////////////////
+/// @file group_commit_persistence.h
+/// Declaration of MQTT group_commit_persistence class
+/// @author Frank Pagliughi
+/////////////////////////////////////////////////////////////////////////////
+
+/*******************************************************************************
+ * Copyright (c) 2025 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+#ifndef __mqtt_group_commit_persistence_h
+#define __mqtt_group_commit_persistence_h
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <thread>
+
+#include "mqtt/iclient_persistence.h"
+#include "mqtt/types.h"
+
+namespace mqtt {
+
+/////////////////////////////////////////////////////////////////////////////
+
+/**
+ * A persistence adapter that groups the writes to another store, making
+ * them durable together.
+ *
+ * A store that syncs each write to disk limits the client to a few
+ * hundred persisted messages per second. This adapter queues the puts
+ * and removes from the client and applies them to the wrapped store in
+ * batches, from a background thread, followed by a single call to the
+ * store's `sync()`. A batch is committed once per interval, or sooner if
+ * it reaches the maximum batch size.
+ *
+ * Reads see the queued changes, so to the client the store is always
+ * up to date. When a message is put and removed within the same batch,
+ * as when a QoS 1 message is acknowledged quickly, neither ever reaches
+ * the wrapped store.
+ *
+ * The trade-off is that a change is only durable once its batch is
+ * committed, up to one interval after it was made. Call `commit()` to
+ * wait until everything queued so far is durable, such as before
+ * treating a set of publish tokens as complete.
+ *
+ * @code
+ * auto store = std::make_shared<mqtt::log_persistence>("/var/lib/myapp");
+ * mqtt::group_commit_persistence persist{store};
+ *
+ * mqtt::async_client cli(serverURI, clientId, &persist);
+ * @endcode
+ */
+class group_commit_persistence : public iclient_persistence
+{
+    /** The store that receives the changes */
+    iclient_persistence_ptr store_;
+    /** The longest time that a change waits to be committed */
+    std::chrono::milliseconds interval_;
+    /** The number of queued changes that triggers a commit */
+    size_t maxBatch_;
+
+    /** A queued change: the data for a put, or empty for a remove */
+    using change_map = std::map<string, std::optional<string>>;
+
+    /** Lock for the queues and state */
+    mutable std::mutex lock_;
+    /** Lock for the wrapped store */
+    mutable std::mutex storeLock_;
+    /** Signals the committer that there's work */
+    std::condition_variable cv_;
+    /** Signals that a batch was committed */
+    std::condition_variable doneCv_;
+    /** The changes waiting for the next commit */
+    change_map pending_;
+    /** The changes being committed */
+    change_map inflight_;
+    /** The number of changes queued, ever */
+    uint64_t queuedSeq_{0};
+    /** The number of changes committed, ever */
+    uint64_t committedSeq_{0};
+    /** Whether someone is waiting for a commit */
+    bool commitReq_{false};
+    /** Whether the store is open, with the committer running */
+    bool running_{false};
+    /** Whether the committer should exit */
+    bool stop_{false};
+    /** The error from the last commit, if it failed */
+    std::exception_ptr err_;
+    /** The committer thread */
+    std::thread thr_;
+
+    /** The committer thread function */
+    void run();
+    /** Writes a batch of changes to the store, and syncs it */
+    void write_batch(const change_map& batch);
+    /** Queues a change. The lock must be held. */
+    void queue_change(const string& key, std::optional<string> val);
+    /** Looks for a queued change. The lock must be held. */
+    const std::optional<string>* find_change(const string& key) const;
+    /** Throws if not open, or the last commit failed. The lock must be held. */
+    void check_error();
+    /** Stops the committer thread, after it commits the queue */
+    void stop();
+
+public:
+    /** The default commit interval */
+    static constexpr std::chrono::milliseconds DFLT_INTERVAL{10};
+    /** The default maximum batch size */
+    static constexpr size_t DFLT_MAX_BATCH = 1024;
+
+    /**
+     * Creates an adapter for a persistence store.
+     * @param store The store that receives the changes.
+     * @param interval The longest time that a change waits to be
+     *  			   committed.
+     * @param maxBatch The number of queued changes that triggers a commit
+     *  			   before the interval is up.
+     */
+    explicit group_commit_persistence(
+        iclient_persistence_ptr store, std::chrono::milliseconds interval = DFLT_INTERVAL,
+        size_t maxBatch = DFLT_MAX_BATCH
+    )
+        : store_{std::move(store)}, interval_{interval}, maxBatch_{maxBatch} {}
+    /**
+     * Commits any queued changes and closes the store, if open.
+     */
+    ~group_commit_persistence() override;
+    /**
+     * Gets the wrapped store.
+     * @return The store that receives the changes.
+     */
+    iclient_persistence_ptr get_store() const { return store_; }
+    /**
+     * Waits until all the changes queued so far are committed to the
+     * wrapped store, and synced.
+     * @throw persistence_exception if the commit failed.
+     */
+    void commit();
+    /**
+     * Opens the wrapped store and starts the committer.
+     * @param clientId The identifier string for the client.
+     * @param serverURI The server to which the client is connected.
+     */
+    void open(const string& clientId, const string& serverURI) override;
+    /**
+     * Commits any queued changes and closes the wrapped store.
+     */
+    void close() override;
+    /**
+     * Discards any queued changes and clears the wrapped store.
+     */
+    void clear() override;
+    /**
+     * Determines if there is data for the key.
+     * @param key The key to find
+     * @return @em true if the key exists, @em false if not.
+     */
+    bool contains_key(const string& key) override;
+    /**
+     * Gets the keys in the store, including those waiting to be
+     * committed.
+     * @return A collection of the keys in the store.
+     */
+    string_collection keys() const override;
+    /**
+     * Queues the data to be put into the store.
+     * @param key The key.
+     * @param bufs The data to store
+     * @throw persistence_exception if the store is not open, or the last
+     *  	  commit failed.
+     */
+    void put(const string& key, const std::vector<string_view>& bufs) override;
+    /**
+     * Gets the data for the key.
+     * @param key The key
+     * @return The data associated with the key.
+     * @throw persistence_exception if the key is not in the store.
+     */
+    string get(const string& key) const override;
+    /**
+     * Gets the data for the key, copied directly into a buffer for the C
+     * library.
+     * @param key The key
+     * @param n On return, the size of the data, in bytes.
+     * @return A buffer with the data, from @ref persistence_malloc().
+     * @throw persistence_exception if the key is not in the store.
+     */
+    char* get_buffer(const string& key, size_t& n) const override;
+    /**
+     * Queues the removal of the data for the key.
+     * @param key The key
+     * @throw persistence_exception if the key is not in the store, or the
+     *  	  last commit failed.
+     */
+    void remove(const string& key) override;
+    /**
+     * Waits for all the changes so far to be committed.
+     * This is the same as `commit()`.
+     */
+    void sync() override { commit(); }
+};
+
+/////////////////////////////////////////////////////////////////////////////
+}  // namespace mqtt
+
+#endif  // __mqtt_group_commit_persistence_h
@@ -24,6 +24,9 @@
 #ifndef __mqtt_iasync_client_h
 #define __mqtt_iasync_client_h
 
+#include <chrono>
+#include <functional>
+#include <memory>
 #include <vector>
 
 #include "mqtt/callback.h"
@@ -35,6 +38,7 @@
 #include "mqtt/iaction_listener.h"
 #include "mqtt/iclient_persistence.h"
 #include "mqtt/message.h"
+#include "mqtt/spin_wait.h"
 #include "mqtt/subscribe_options.h"
 #include "mqtt/token.h"
 #include "mqtt/types.h"
@@ -58,8 +62,46 @@ namespace mqtt {
  */
 class iasync_client
 {
+public:
+    /** A unit of work to be run by an executor */
+    using task_type = std::function<void()>;
+    /** A function that runs tasks, such as posting them to a thread pool */
+    using executor_type = std::function<void(task_type)>;
+    /** Smart/shared pointer to an executor */
+    using executor_ptr = std::shared_ptr<const executor_type>;
+
+private:
     friend class token;
+    friend class batch_token;
     virtual void remove_token(token* tok) = 0;
+    /**
+     * Gets the executor that should run the callbacks for the client.
+     * @return The executor, or null to run the callbacks in place.
+     */
+    virtual executor_ptr get_executor() const { return executor_ptr{}; }
+    /**
+     * Gets the policy for spinning before a wait on a token blocks.
+     * @return The spin-then-block policy for the client's tokens.
+     */
+    virtual spin_wait get_spin_wait() const { return spin_wait{}; }
+    /**
+     * Gets the time that a user callback is starting, if the client times
+     * them.
+     * @return The current time, or the epoch if callbacks aren't timed.
+     */
+    virtual std::chrono::steady_clock::time_point callback_start() const noexcept {
+        return std::chrono::steady_clock::time_point{};
+    }
+    /**
+     * Records the time taken by the action listener or completion
+     * handlers for a token.
+     * @param tok The token.
+     * @param start The time they started, from callback_start().
+     */
+    virtual void listener_done(const token& tok, std::chrono::steady_clock::time_point start) {
+        (void)tok;
+        (void)start;
+    }
 
 public:
     /** Type for a collection of QOS values */
@@ -134,11 +134,34 @@ public:
      * @return A const view of the data associated with the key.
      */
     virtual string get(const string& key) const = 0;
+    /**
+     * Gets the specified data out of the persistent store, in a buffer
+     * for the C library.
+     *
+     * This is how the client reads back the data, such as to restore the
+     * messages that were in flight. The default implementation copies the
+     * result of get() into a new buffer. A store that holds the data in
+     * memory, or can read it directly, should override this to fill the
+     * buffer from its own storage with a single copy.
+     *
+     * @param key The key
+     * @param n On return, the size of the data, in bytes.
+     * @return A buffer with the data, allocated with @ref
+     *  	   persistence_malloc(). The caller takes ownership of it.
+     */
+    virtual char* get_buffer(const string& key, size_t& n) const;
     /**
      * Remove the data for the specified key.
      * @param key The key
      */
     virtual void remove(const string& key) = 0;
+    /**
+     * Makes the data written to the store so far durable, such as by
+     * flushing it to disk.
+     * This is optional. By default it does nothing, which suits a store
+     * that makes each write durable on its own.
+     */
+    virtual void sync() {}
 };
 
 /** Smart/shared pointer to a persistence client */
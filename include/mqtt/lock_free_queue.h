@@ -0,0 +1,593 @@
+/////////////////////////////////////////////////////////////////////////////
+/// @file lock_free_queue.h
+/// Implementation of the template class 'lock_free_queue', a bounded,
+/// thread-safe ring-buffer queue for passing data between threads, that
+/// only blocks when it is empty or full.
+/////////////////////////////////////////////////////////////////////////////
+
+/*******************************************************************************
+ * Copyright (c) 2025 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+#ifndef __mqtt_lock_free_queue_h
+#define __mqtt_lock_free_queue_h
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "mqtt/spin_wait.h"
+#include "mqtt/thread_queue.h"
+
+namespace mqtt {
+
+/////////////////////////////////////////////////////////////////////////////
+
+/**
+ * A bounded, lock-free queue for inter-thread communication.
+ *
+ * This is a drop-in alternative to the @ref thread_queue for cases where
+ * the producer and consumer are contending heavily for the queue. Items
+ * are held in a fixed-size ring buffer, and placing or removing an item
+ * is done with atomic operations on the head and tail positions. Any
+ * number of threads can put items into the queue and any number can take
+ * them out, although the common use is a single consumer.
+ * @par
+ * The queue only resorts to a mutex and condition variable when a thread
+ * needs to block, meaning when a get() on an empty queue, or a put() on a
+ * full queue, has to wait. Threads that put or get an item from a queue
+ * that is not empty or full never block, and signal another thread only if
+ * one is known to be waiting.
+ * @par
+ * Unlike the @ref thread_queue, this queue is always bounded, and the
+ * capacity can not be changed after it is created. The capacity is rounded
+ * up to the next power of two.
+ * @par
+ * The queue can be closed, with the same semantics as that of the
+ * @ref thread_queue. After that, no new items can be placed into it, but
+ * receivers can still get any items that were added before it was closed.
+ *
+ * @tparam T The type of the items to be held in the queue. It must be
+ *  		 default constructible and movable.
+ */
+template <typename T>
+class lock_free_queue
+{
+public:
+    /** The type of items to be held in the queue. */
+    using value_type = T;
+    /** The type used to specify number of items in the container. */
+    using size_type = std::size_t;
+
+    /** The default capacity of the queue */
+    static constexpr size_type DFLT_CAPACITY = 16 * 1024;
+
+private:
+    /** The size of a cache line, to keep the positions apart */
+    static constexpr size_t CACHE_LINE_SIZE = 64;
+
+    /** A slot in the ring buffer */
+    struct cell
+    {
+        /** Sequence number to coordinate producers and consumers */
+        std::atomic<size_type> seq;
+        /** The item in the slot */
+        value_type val;
+    };
+
+    /** The capacity of the queue (always a power of two) */
+    const size_type cap_;
+    /** Mask to get a slot index from a position */
+    const size_type mask_;
+    /** The ring buffer */
+    std::unique_ptr<cell[]> buf_;
+
+    /** The position for the next item to be placed into the queue */
+    alignas(CACHE_LINE_SIZE) std::atomic<size_type> tail_{0};
+    /** The position of the next item to be removed from the queue */
+    alignas(CACHE_LINE_SIZE) std::atomic<size_type> head_{0};
+
+    /** Whether the queue is closed */
+    alignas(CACHE_LINE_SIZE) std::atomic<bool> closed_{false};
+    /** The number of threads blocked waiting to get an item */
+    std::atomic<int> nGetWaiters_{0};
+    /** The number of threads blocked waiting to put an item */
+    std::atomic<int> nPutWaiters_{0};
+    /** The number of times a get spins before blocking */
+    std::atomic<unsigned> nSpins_{0};
+    /** The number of times a get yields before blocking */
+    std::atomic<unsigned> nYields_{0};
+
+    /** Lock used only for blocking */
+    mutable std::mutex lock_;
+    /** Condition get signaled when item added to empty queue */
+    std::condition_variable notEmptyCond_;
+    /** Condition gets signaled then item removed from full queue */
+    std::condition_variable notFullCond_;
+
+    /** General purpose guard */
+    using unique_guard = std::unique_lock<std::mutex>;
+
+    /** Rounds the requested capacity up to a power of two. */
+    static size_type round_capacity(size_type cap) {
+        size_type n = 2;
+        while (n < cap) n <<= 1;
+        return n;
+    }
+
+    /**
+     * Attempts to place an item into the ring buffer without blocking.
+     * The value is only moved out of if it was placed in the queue.
+     */
+    bool push(value_type& val) {
+        size_type pos = tail_.load(std::memory_order_relaxed);
+        while (true) {
+            cell& c = buf_[pos & mask_];
+            size_type seq = c.seq.load(std::memory_order_acquire);
+            auto dif = std::ptrdiff_t(seq) - std::ptrdiff_t(pos);
+
+            if (dif == 0) {
+                if (tail_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    c.val = std::move(val);
+                    c.seq.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (dif < 0)
+                return false;  // full
+            else
+                pos = tail_.load(std::memory_order_relaxed);
+        }
+    }
+    /**
+     * Attempts to remove an item from the ring buffer without blocking.
+     */
+    bool pop(value_type* val) {
+        size_type pos = head_.load(std::memory_order_relaxed);
+        while (true) {
+            cell& c = buf_[pos & mask_];
+            size_type seq = c.seq.load(std::memory_order_acquire);
+            auto dif = std::ptrdiff_t(seq) - std::ptrdiff_t(pos + 1);
+
+            if (dif == 0) {
+                if (head_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    *val = std::move(c.val);
+                    c.val = value_type{};
+                    c.seq.store(pos + mask_ + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (dif < 0)
+                return false;  // empty
+            else
+                pos = head_.load(std::memory_order_relaxed);
+        }
+    }
+    /**
+     * Wakes a consumer if any are blocked.
+     * This is the only place where a producer touches the lock, and then
+     * only when a consumer is known to be waiting.
+     */
+    void signal_not_empty() {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (nGetWaiters_.load(std::memory_order_relaxed) > 0) {
+            unique_guard g{lock_};
+            notEmptyCond_.notify_one();
+        }
+    }
+    /**
+     * Wakes a producer if any are blocked.
+     * @param all Whether to wake all the blocked producers, such as after
+     *  		  a number of items were removed at once.
+     */
+    void signal_not_full(bool all = false) {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (nPutWaiters_.load(std::memory_order_relaxed) > 0) {
+            unique_guard g{lock_};
+            if (all)
+                notFullCond_.notify_all();
+            else
+                notFullCond_.notify_one();
+        }
+    }
+    /**
+     * Places an item into the queue, blocking with the supplied wait
+     * function if it is full.
+     * The count of waiters is registered before the push is re-tried, so
+     * that a consumer removing an item is sure to see it.
+     */
+    template <typename Wait>
+    bool do_put(value_type& val, Wait wait) {
+        if (closed_.load())
+            return false;
+
+        bool ok = push(val);
+        if (!ok) {
+            unique_guard g{lock_};
+            ++nPutWaiters_;
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            wait(notFullCond_, g, [&] { return closed_.load() || (ok = push(val)); });
+            --nPutWaiters_;
+        }
+        if (ok)
+            signal_not_empty();
+        return ok;
+    }
+    /**
+     * Removes an item from the queue, blocking with the supplied wait
+     * function if it is empty.
+     */
+    template <typename Wait>
+    bool do_get(value_type* val, Wait wait) {
+        bool ok = pop(val);
+        if (!ok) {
+            spin_wait sw = spin();
+            if (sw.enabled())
+                sw([&] { return (ok = pop(val)) || closed_.load(); });
+        }
+        if (!ok) {
+            unique_guard g{lock_};
+            ++nGetWaiters_;
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            wait(notEmptyCond_, g, [&] { return (ok = pop(val)) || closed_.load(); });
+            --nGetWaiters_;
+        }
+        if (ok)
+            signal_not_full();
+        return ok;
+    }
+    /**
+     * Moves up to the specified number of items from the queue into the
+     * vector, without blocking.
+     * @return The number of items moved.
+     */
+    size_type pop_bulk(std::vector<value_type>& vec, size_type maxItems) {
+        size_type n = 0;
+        value_type val;
+
+        while (n < maxItems && pop(&val)) {
+            vec.emplace_back(std::move(val));
+            ++n;
+        }
+        if (n > 0)
+            signal_not_full(true);
+        return n;
+    }
+    /**
+     * Moves up to the specified number of items from the queue into the
+     * vector, blocking with the supplied wait function for the first one
+     * if the queue is empty.
+     */
+    template <typename Wait>
+    size_type do_get_bulk(std::vector<value_type>& vec, size_type maxItems, Wait wait) {
+        value_type val;
+        if (maxItems == 0 || !do_get(&val, wait))
+            return 0;
+
+        vec.emplace_back(std::move(val));
+        return 1 + pop_bulk(vec, maxItems - 1);
+    }
+
+public:
+    /**
+     * Constructs a queue with the default capacity.
+     */
+    lock_free_queue() : lock_free_queue(DFLT_CAPACITY) {}
+    /**
+     * Constructs a queue with the specified capacity.
+     * @param cap The maximum number of items that can be placed in the
+     *  		  queue. This is rounded up to the next power of two.
+     */
+    explicit lock_free_queue(size_type cap)
+        : cap_(round_capacity(cap)), mask_(cap_ - 1), buf_(new cell[cap_]) {
+        for (size_type i = 0; i < cap_; ++i)
+            buf_[i].seq.store(i, std::memory_order_relaxed);
+    }
+    /**
+     * Determine if the queue is empty.
+     * @return @em true if there are no elements in the queue, @em false if
+     *  	   there are any items in the queue.
+     */
+    bool empty() const { return size() == 0; }
+    /**
+     * Gets the capacity of the queue.
+     * @return The maximum number of elements before the queue is full.
+     */
+    size_type capacity() const { return cap_; }
+    /**
+     * Gets the policy for spinning before a get blocks.
+     * @return The spin-then-block policy for the consumers.
+     */
+    spin_wait spin() const {
+        return spin_wait{
+            nSpins_.load(std::memory_order_relaxed), nYields_.load(std::memory_order_relaxed)
+        };
+    }
+    /**
+     * Sets the policy for spinning before a get blocks.
+     * When the queue is empty, the blocking and timed gets first spin and
+     * yield, trying to pop an item, before they take the lock to wait.
+     * @param sw The spin-then-block policy for the consumers.
+     */
+    void spin(const spin_wait& sw) {
+        nSpins_.store(sw.spins(), std::memory_order_relaxed);
+        nYields_.store(sw.yields(), std::memory_order_relaxed);
+    }
+    /**
+     * Gets the number of items in the queue.
+     * When other threads are using the queue, this is only a snapshot.
+     * @return The number of items in the queue.
+     */
+    size_type size() const {
+        size_type head = head_.load(std::memory_order_acquire),
+                  tail = tail_.load(std::memory_order_acquire);
+        return (tail > head) ? (tail - head) : 0;
+    }
+    /**
+     * Close the queue.
+     * Once closed, the queue will not accept any new items, but receievers
+     * will still be able to get any remaining items out of the queue until
+     * it is empty.
+     */
+    void close() {
+        unique_guard g{lock_};
+        closed_ = true;
+        notFullCond_.notify_all();
+        notEmptyCond_.notify_all();
+    }
+    /**
+     * Determines if the queue is closed.
+     * @return @em true if the queue is closed, @false otherwise.
+     */
+    bool closed() const { return closed_.load(); }
+    /**
+     * Determines if all possible operations are done on the queue.
+     * If the queue is closed and empty, then no further useful operations
+     * can be done on it.
+     * @return @true if the queue is closed and empty, @em false otherwise.
+     */
+    bool done() const { return closed_.load() && empty(); }
+    /**
+     * Clear the contents of the queue.
+     * This discards all items in the queue.
+     */
+    void clear() {
+        value_type val;
+        bool any = false;
+        while (pop(&val)) any = true;
+        if (any) {
+            unique_guard g{lock_};
+            notFullCond_.notify_all();
+        }
+    }
+    /**
+     * Put an item into the queue.
+     * If the queue is full, this will block the caller until items are
+     * removed bringing the size less than the capacity.
+     * @param val The value to add to the queue.
+     */
+    void put(value_type val) {
+        auto wait = [](std::condition_variable& cond, unique_guard& g, auto pred) {
+            cond.wait(g, pred);
+        };
+        if (!do_put(val, wait))
+            throw queue_closed{};
+    }
+    /**
+     * Non-blocking attempt to place an item into the queue.
+     * @param val The value to add to the queue.
+     * @return @em true if the item was added to the queue, @em false if the
+     *  	   item was not added because the queue is currently full.
+     */
+    bool try_put(value_type val) {
+        if (closed_.load() || !push(val))
+            return false;
+
+        signal_not_empty();
+        return true;
+    }
+    /**
+     * Attempt to place an item in the queue with a bounded wait.
+     * This will attempt to place the value in the queue, but if it is full,
+     * it will wait up to the specified time duration before timing out.
+     * @param val The value to add to the queue.
+     * @param relTime The amount of time to wait until timing out.
+     * @return @em true if the value was added to the queue, @em false if a
+     *  	   timeout occurred.
+     */
+    template <typename Rep, class Period>
+    bool try_put_for(value_type val, const std::chrono::duration<Rep, Period>& relTime) {
+        auto wait = [&relTime](std::condition_variable& cond, unique_guard& g, auto pred) {
+            cond.wait_for(g, relTime, pred);
+        };
+        return do_put(val, wait);
+    }
+    /**
+     * Attempt to place an item in the queue with a bounded wait to an
+     * absolute time point.
+     * This will attempt to place the value in the queue, but if it is full,
+     * it will wait up until the specified time before timing out.
+     * @param val The value to add to the queue.
+     * @param absTime The absolute time to wait to before timing out.
+     * @return @em true if the value was added to the queue, @em false if a
+     *  	   timeout occurred.
+     */
+    template <class Clock, class Duration>
+    bool try_put_until(
+        value_type val, const std::chrono::time_point<Clock, Duration>& absTime
+    ) {
+        auto wait = [&absTime](std::condition_variable& cond, unique_guard& g, auto pred) {
+            cond.wait_until(g, absTime, pred);
+        };
+        return do_put(val, wait);
+    }
+    /**
+     * Retrieve a value from the queue.
+     * If the queue is empty, this will block indefinitely until a value is
+     * added to the queue by another thread,
+     * @param val Pointer to a variable to receive the value.
+     * @return @em true if a value was retrieved, @em false if the queue
+     *  	   is closed and empty.
+     */
+    bool get(value_type* val) {
+        if (!val)
+            return false;
+
+        auto wait = [](std::condition_variable& cond, unique_guard& g, auto pred) {
+            cond.wait(g, pred);
+        };
+        return do_get(val, wait);
+    }
+    /**
+     * Retrieve a value from the queue.
+     * If the queue is empty, this will block indefinitely until a value is
+     * added to the queue by another thread,
+     * @return The value removed from the queue
+     */
+    value_type get() {
+        value_type val;
+        if (!get(&val))
+            throw queue_closed{};
+        return val;
+    }
+    /**
+     * Attempts to remove a value from the queue without blocking.
+     * If the queue is currently empty, this will return immediately with a
+     * failure, otherwise it will get the next value and return it.
+     * @param val Pointer to a variable to receive the value.
+     * @return @em true if a value was removed from the queue, @em false if
+     *  	   the queue is empty.
+     */
+    bool try_get(value_type* val) {
+        if (!val || !pop(val))
+            return false;
+
+        signal_not_full();
+        return true;
+    }
+    /**
+     * Attempt to remove an item from the queue for a bounded amount of time.
+     * This will retrieve the next item from the queue. If the queue is
+     * empty, it will wait the specified amount of time for an item to arrive
+     * before timing out.
+     * @param val Pointer to a variable to receive the value.
+     * @param relTime The amount of time to wait until timing out.
+     * @return @em true if the value was removed the queue, @em false if a
+     *  	   timeout occurred.
+     */
+    template <typename Rep, class Period>
+    bool try_get_for(value_type* val, const std::chrono::duration<Rep, Period>& relTime) {
+        if (!val)
+            return false;
+
+        auto wait = [&relTime](std::condition_variable& cond, unique_guard& g, auto pred) {
+            cond.wait_for(g, relTime, pred);
+        };
+        return do_get(val, wait);
+    }
+    /**
+     * Attempt to remove an item from the queue for a bounded amount of time.
+     * This will retrieve the next item from the queue. If the queue is
+     * empty, it will wait until the specified time for an item to arrive
+     * before timing out.
+     * @param val Pointer to a variable to receive the value.
+     * @param absTime The absolute time to wait to before timing out.
+     * @return @em true if the value was removed from the queue, @em false
+     *  	   if a timeout occurred.
+     */
+    template <class Clock, class Duration>
+    bool try_get_until(
+        value_type* val, const std::chrono::time_point<Clock, Duration>& absTime
+    ) {
+        if (!val)
+            return false;
+
+        auto wait = [&absTime](std::condition_variable& cond, unique_guard& g, auto pred) {
+            cond.wait_until(g, absTime, pred);
+        };
+        return do_get(val, wait);
+    }
+    /**
+     * Removes all the items currently in the queue without blocking.
+     * @return A vector of the items that were in the queue. It is empty if
+     *  	   the queue was empty.
+     */
+    std::vector<value_type> get_all() {
+        std::vector<value_type> vec;
+        vec.reserve(size());
+        pop_bulk(vec, cap_);
+        return vec;
+    }
+    /**
+     * Attempts to remove a number of items from the queue without
+     * blocking.
+     * This removes up to the specified number of items, and appends them
+     * to the vector.
+     * @param vec The vector to receive the items.
+     * @param maxItems The maximum number of items to remove.
+     * @return The number of items removed from the queue.
+     */
+    size_type try_get_bulk(std::vector<value_type>& vec, size_type maxItems) {
+        return pop_bulk(vec, maxItems);
+    }
+    /**
+     * Attempts to remove a number of items from the queue, waiting for a
+     * bounded amount of time for one to arrive if the queue is empty.
+     * @param vec The vector to receive the items.
+     * @param maxItems The maximum number of items to remove.
+     * @param relTime The amount of time to wait until timing out.
+     * @return The number of items removed from the queue. This is zero if
+     *  	   a timeout occurred.
+     */
+    template <typename Rep, class Period>
+    size_type try_get_bulk_for(
+        std::vector<value_type>& vec, size_type maxItems,
+        const std::chrono::duration<Rep, Period>& relTime
+    ) {
+        auto wait = [&relTime](std::condition_variable& cond, unique_guard& g, auto pred) {
+            cond.wait_for(g, relTime, pred);
+        };
+        return do_get_bulk(vec, maxItems, wait);
+    }
+    /**
+     * Attempts to remove a number of items from the queue, waiting until a
+     * specific time for one to arrive if the queue is empty.
+     * @param vec The vector to receive the items.
+     * @param maxItems The maximum number of items to remove.
+     * @param absTime The absolute time to wait to before timing out.
+     * @return The number of items removed from the queue. This is zero if
+     *  	   a timeout occurred.
+     */
+    template <class Clock, class Duration>
+    size_type try_get_bulk_until(
+        std::vector<value_type>& vec, size_type maxItems,
+        const std::chrono::time_point<Clock, Duration>& absTime
+    ) {
+        auto wait = [&absTime](std::condition_variable& cond, unique_guard& g, auto pred) {
+            cond.wait_until(g, absTime, pred);
+        };
+        return do_get_bulk(vec, maxItems, wait);
+    }
+};
+
+/////////////////////////////////////////////////////////////////////////////
+}  // namespace mqtt
+
+#endif  // __mqtt_lock_free_queue_h
@@ -0,0 +1,212 @@
+/////////////////////////////////////////////////////////////////////////////
+/// @file log_persistence.h
+/// Declaration of MQTT log_persistence class
+/// @author Frank Pagliughi
+/////////////////////////////////////////////////////////////////////////////
+
+/*******************************************************************************
+ * Copyright (c) 2025 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+#ifndef __mqtt_log_persistence_h
+#define __mqtt_log_persistence_h
+
+#include <cstdio>
+#include <map>
+#include <mutex>
+
+#include "mqtt/iclient_persistence.h"
+#include "mqtt/types.h"
+
+namespace mqtt {
+
+/////////////////////////////////////////////////////////////////////////////
+
+/**
+ * A persistence store that keeps the data in a single, append-only log
+ * file.
+ *
+ * The C library's file persistence writes each message to its own file,
+ * which costs an open, write, close, and eventually an unlink, for every
+ * QoS 1 and 2 message. This store appends a record to a log for each put
+ * or remove, with a single write, and serves reads from a copy of the
+ * live data held in memory. When the log grows past a size threshold,
+ * with mostly removed data, it's compacted by writing out the live data
+ * to a new log which replaces the old one.
+ *
+ * Each record has a checksum. When the store is opened, the log is read
+ * back up to the first record that was not completely written, such as
+ * after a crash, and anything after it is discarded.
+ *
+ * The log is written through to the OS after each record, so data
+ * survives the application crashing, but not necessarily the system.
+ * Calling `sync()` flushes it to the storage device, which is best done
+ * for a group of writes, with a @ref group_commit_persistence adapter.
+ *
+ * @code
+ * mqtt::log_persistence persist{"/var/lib/myapp"};
+ *
+ * auto createOpts = mqtt::create_options_builder()
+ *                       .server_uri(serverURI)
+ *                       .client_id(clientId)
+ *                       .persistence(&persist)
+ *                       .finalize();
+ * @endcode
+ */
+class log_persistence : public iclient_persistence
+{
+    /** The directory for the log file */
+    string dir_;
+    /** The path to the log file, once opened */
+    string path_;
+    /** The log file, if opened */
+    std::FILE* file_{nullptr};
+    /** The live data */
+    std::map<string, string> store_;
+    /** The size of the log file, in bytes */
+    size_t logSize_{0};
+    /** The size of the records for the live data, in bytes */
+    size_t liveSize_{0};
+    /** The log size at which compaction is considered */
+    size_t compactSize_;
+    /** Scratch buffer to build a record */
+    string rec_;
+    /** Lock for the store */
+    mutable std::mutex lock_;
+
+    /** Record types */
+    enum : char { PUT = 'P', REMOVE = 'R' };
+
+    /**
+     * Builds a record in the scratch buffer.
+     * @return The size of the record.
+     */
+    size_t make_record(char type, const string& key, const std::vector<string_view>& bufs);
+    /** Appends the record in the scratch buffer to the log. */
+    void append_record();
+    /** Reads back the log file to recover the live data. */
+    bool recover();
+    /** Rewrites the log with just the live data */
+    void compact();
+    /** Compacts the log if it's big enough and mostly dead records */
+    void maybe_compact();
+    /** Opens the log file for appending */
+    void open_log(const char* mode);
+    /** Closes the log file, if open */
+    void close_log();
+
+public:
+    /** The default log size at which compaction is considered: 1MB */
+    static constexpr size_t DFLT_COMPACT_SIZE = 1024 * 1024;
+
+    /**
+     * Creates a log persistence store.
+     * @param dir The directory in which to place the log file. It must
+     *  		  already exist.
+     * @param compactSize The log size, in bytes, at which compaction is
+     *  				  considered. The log is compacted once it reaches
+     *  				  this size, if more than half of it is data that
+     *  				  was removed or overwritten.
+     */
+    explicit log_persistence(const string& dir = ".", size_t compactSize = DFLT_COMPACT_SIZE)
+        : dir_{dir}, compactSize_{compactSize} {}
+    /**
+     * Closes the store, if open.
+     */
+    ~log_persistence() override;
+    /**
+     * Gets the path to the log file.
+     * @return The path to the log file, or an empty string if the store
+     *  	   has not been opened.
+     */
+    string get_path() const;
+    /**
+     * Gets the current size of the log file.
+     * @return The size of the log file, in bytes.
+     */
+    size_t get_log_size() const;
+    /**
+     * Opens the store, reading back any data in the log.
+     *
+     * The log file is placed in the directory given to the constructor,
+     * and is named from the client ID and server URI, with any characters
+     * that aren't valid in a file name replaced.
+     *
+     * @param clientId The identifier string for the client.
+     * @param serverURI The server to which the client is connected.
+     * @throw persistence_exception if the log can not be opened.
+     */
+    void open(const string& clientId, const string& serverURI) override;
+    /**
+     * Closes the store.
+     */
+    void close() override;
+    /**
+     * Clears the store, leaving an empty log.
+     */
+    void clear() override;
+    /**
+     * Determines if there is data for the key.
+     * @param key The key to find
+     * @return @em true if the key exists, @em false if not.
+     */
+    bool contains_key(const string& key) override;
+    /**
+     * Gets the keys in the store.
+     * @return A collection of the keys in the store.
+     */
+    string_collection keys() const override;
+    /**
+     * Puts the data into the store, appending it to the log.
+     * @param key The key.
+     * @param bufs The data to store
+     * @throw persistence_exception if the log can not be written.
+     */
+    void put(const string& key, const std::vector<string_view>& bufs) override;
+    /**
+     * Gets the data for the key.
+     * @param key The key
+     * @return The data associated with the key.
+     * @throw persistence_exception if the key is not in the store.
+     */
+    string get(const string& key) const override;
+    /**
+     * Gets the data for the key, copied directly into a buffer for the C
+     * library.
+     * @param key The key
+     * @param n On return, the size of the data, in bytes.
+     * @return A buffer with the data, from @ref persistence_malloc().
+     * @throw persistence_exception if the key is not in the store.
+     */
+    char* get_buffer(const string& key, size_t& n) const override;
+    /**
+     * Removes the data for the key, appending the removal to the log.
+     * @param key The key
+     * @throw persistence_exception if the key is not in the store, or the
+     *  	  log can not be written.
+     */
+    void remove(const string& key) override;
+    /**
+     * Flushes the log to the storage device, so that the data written so
+     * far survives a system crash.
+     * @throw persistence_exception if the log can not be flushed.
+     */
+    void sync() override;
+};
+
+/////////////////////////////////////////////////////////////////////////////
+}  // namespace mqtt
+
+#endif  // __mqtt_log_persistence_h
@@ -0,0 +1,142 @@
+/////////////////////////////////////////////////////////////////////////////
+/// @file memory_budget.h
+/// Declaration of MQTT memory_budget class
+/// @author Frank Pagliughi
+/////////////////////////////////////////////////////////////////////////////
+
+/*******************************************************************************
+ * Copyright (c) 2025 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+
+#ifndef __mqtt_memory_budget_h
+#define __mqtt_memory_budget_h
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+
+namespace mqtt {
+
+/////////////////////////////////////////////////////////////////////////////
+
+/**
+ * An account of the bytes of memory held by a client, with an optional
+ * limit.
+ *
+ * The client charges the budget for the messages that it holds, such as
+ * the outgoing messages that are waiting for their delivery to complete and
+ * the incoming messages in the consumer queue, and releases the charge
+ * when it lets go of them. The count is relaxed atomics, so keeping it
+ * costs little when there is no limit.
+ * @par
+ * With a limit, the client checks for room before taking on another
+ * message, and waits or discards messages to stay under it, as set by its
+ * back-pressure and overflow policies. A single message is always allowed
+ * when nothing is charged, even if it is larger than the limit, so that it
+ * can't block forever.
+ */
+class memory_budget
+{
+    /** Lock guard type for this class */
+    using guard = std::lock_guard<std::mutex>;
+    /** Unique lock type for this class */
+    using unique_guard = std::unique_lock<std::mutex>;
+
+    /** The maximum number of bytes (0=no limit) */
+    const size_t limit_;
+    /** The number of bytes charged */
+    std::atomic<size_t> used_{0};
+    /** The most bytes that were ever charged */
+    std::atomic<size_t> highWater_{0};
+    /** Lock for waiting on room */
+    mutable std::mutex lock_;
+    /** Condition to signal that some of the budget was released */
+    std::condition_variable releasedCond_;
+
+public:
+    /**
+     * Creates a memory budget.
+     * @param limit The maximum number of bytes. Zero for no limit.
+     */
+    explicit memory_budget(size_t limit = 0) : limit_{limit} {}
+
+    memory_budget(const memory_budget&) = delete;
+    memory_budget& operator=(const memory_budget&) = delete;
+
+    /**
+     * Gets the limit of the budget.
+     * @return The maximum number of bytes, or zero if there is no limit.
+     */
+    size_t limit() const { return limit_; }
+    /**
+     * Gets the number of bytes charged to the budget.
+     * @return The number of bytes charged to the budget.
+     */
+    size_t used() const { return used_.load(std::memory_order_relaxed); }
+    /**
+     * Gets the most bytes that were ever charged to the budget.
+     * @return The high-water mark of the budget, in bytes.
+     */
+    size_t high_water() const { return highWater_.load(std::memory_order_relaxed); }
+    /**
+     * Determines if there is room in the budget for more bytes.
+     * @param n The number of bytes.
+     * @return @em true if the bytes fit within the limit, if there is no
+     *  	   limit, or if nothing is charged.
+     */
+    bool has_room(size_t n) const {
+        if (limit_ == 0)
+            return true;
+        auto used = used_.load(std::memory_order_relaxed);
+        return used == 0 || used + n <= limit_;
+    }
+    /**
+     * Charges bytes to the budget, whether or not they fit.
+     * @param n The number of bytes.
+     */
+    void charge(size_t n);
+    /**
+     * Releases bytes that were charged to the budget.
+     * @param n The number of bytes.
+     */
+    void release(size_t n);
+    /**
+     * Waits until there is room in the budget for more bytes.
+     * This doesn't charge them, so another thread can use the room first.
+     * @param n The number of bytes.
+     */
+    void wait(size_t n);
+    /**
+     * Waits a limited time for there to be room in the budget.
+     * @param n The number of bytes.
+     * @param relTime The most time to wait.
+     * @return @em true if there is room, @em false on a timeout.
+     */
+    template <typename Rep, class Period>
+    bool wait_for(size_t n, const std::chrono::duration<Rep, Period>& relTime) {
+        if (has_room(n))
+            return true;
+        unique_guard g{lock_};
+        return releasedCond_.wait_for(g, relTime, [this, n] { return has_room(n); });
+    }
+};
+
+/////////////////////////////////////////////////////////////////////////////
+}  // namespace mqtt
+
+#endif  // __mqtt_memory_budget_h
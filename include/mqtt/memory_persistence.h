@@ -0,0 +1,179 @@
+/////////////////////////////////////////////////////////////////////////////
+/// @file memory_persistence.h
+/// Declaration of MQTT memory_persistence class
+/// @author Frank Pagliughi
+/////////////////////////////////////////////////////////////////////////////
+
+/*******************************************************************************
+ * Copyright (c) 2025 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+#ifndef __mqtt_memory_persistence_h
+#define __mqtt_memory_persistence_h
+
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "mqtt/iclient_persistence.h"
+#include "mqtt/types.h"
+
+namespace mqtt {
+
+/////////////////////////////////////////////////////////////////////////////
+
+/**
+ * A persistence store that keeps the data in memory.
+ *
+ * This keeps the state of QoS 1 and 2 messages across reconnects, but not
+ * if the process exits. Each entry, key and data together, is held in a
+ * single block taken from slabs of memory owned by the store. Blocks come
+ * in power-of-two sizes, and a freed block is kept on a list for its size
+ * to be reused by the next entry, so a steady flow of messages through
+ * the store doesn't go to the heap. The buffers given to `put()` are
+ * copied straight into the block.
+ *
+ * Entries larger than `MAX_BLOCK_SIZE` are allocated from the heap on
+ * their own. The slabs are only released by `clear()`, or when the store
+ * is destroyed.
+ */
+class memory_persistence : public iclient_persistence
+{
+public:
+    /** The smallest block for an entry */
+    static constexpr size_t MIN_BLOCK_SIZE = 64;
+    /** The largest block taken from a slab */
+    static constexpr size_t MAX_BLOCK_SIZE = 64 * 1024;
+    /** The size of each slab */
+    static constexpr size_t SLAB_SIZE = 64 * 1024;
+
+private:
+    /** The number of block sizes: 64, 128, ... 64k */
+    static constexpr size_t N_SIZES = 11;
+
+    /** An entry in the store */
+    struct entry
+    {
+        /** The block holding the key, then the data */
+        char* blk;
+        /** The size of the data */
+        size_t len;
+        /** The index of the block size, or N_SIZES for a heap block */
+        size_t sizeIdx;
+    };
+
+    /** Lock for the store */
+    mutable std::mutex lock_;
+    /** The entries, keyed by a view of the key in the block */
+    std::unordered_map<std::string_view, entry> store_;
+    /** The slabs of memory for the blocks */
+    std::vector<std::unique_ptr<char[]>> slabs_;
+    /** The free blocks for each size */
+    std::vector<char*> freeBlks_[N_SIZES];
+
+    /** Gets the index of the smallest block size that holds n bytes */
+    static size_t size_index(size_t n);
+    /** Gets a block of the size index */
+    char* allocate(size_t sizeIdx, size_t n);
+    /** Returns an entry's block */
+    void deallocate(const entry& e) noexcept;
+
+public:
+    /**
+     * Creates an empty in-memory store.
+     */
+    memory_persistence() = default;
+    /**
+     * Destroys the store, releasing the memory.
+     */
+    ~memory_persistence() override;
+
+    memory_persistence(const memory_persistence&) = delete;
+    memory_persistence& operator=(const memory_persistence&) = delete;
+
+    /**
+     * Gets the number of entries in the store.
+     * @return The number of entries in the store.
+     */
+    size_t size() const;
+    /**
+     * Gets the number of free blocks held for reuse.
+     * @return The number of free blocks, of all sizes.
+     */
+    size_t free_count() const;
+    /**
+     * Opens the store.
+     * This does nothing. Data kept from before is still available.
+     * @param clientId The identifier string for the client.
+     * @param serverURI The server to which the client is connected.
+     */
+    void open(const string& /*clientId*/, const string& /*serverURI*/) override {}
+    /**
+     * Closes the store.
+     * This does nothing. The data is kept for when it's opened again.
+     */
+    void close() override {}
+    /**
+     * Clears the store, releasing all the memory.
+     */
+    void clear() override;
+    /**
+     * Determines if there is data for the key.
+     * @param key The key to find
+     * @return @em true if the key exists, @em false if not.
+     */
+    bool contains_key(const string& key) override;
+    /**
+     * Gets the keys in the store.
+     * @return A collection of the keys in the store.
+     */
+    string_collection keys() const override;
+    /**
+     * Puts the data into the store, replacing any that was there for the
+     * key.
+     * @param key The key.
+     * @param bufs The data to store
+     */
+    void put(const string& key, const std::vector<string_view>& bufs) override;
+    /**
+     * Gets the data for the key.
+     * @param key The key
+     * @return A copy of the data associated with the key.
+     * @throw persistence_exception if the key is not in the store.
+     */
+    string get(const string& key) const override;
+    /**
+     * Gets the data for the key, copied directly into a buffer for the C
+     * library.
+     * @param key The key
+     * @param n On return, the size of the data, in bytes.
+     * @return A buffer with the data, from @ref persistence_malloc().
+     * @throw persistence_exception if the key is not in the store.
+     */
+    char* get_buffer(const string& key, size_t& n) const override;
+    /**
+     * Removes the data for the key.
+     * @param key The key
+     * @throw persistence_exception if the key is not in the store.
+     */
+    void remove(const string& key) override;
+};
+
+/////////////////////////////////////////////////////////////////////////////
+}  // namespace mqtt
+
+#endif  // __mqtt_memory_persistence_h
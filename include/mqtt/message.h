@@ -25,7 +25,9 @@
 #ifndef __mqtt_message_h
 #define __mqtt_message_h
 
+#include <initializer_list>
 #include <memory>
+#include <string_view>
 
 #include "MQTTAsync.h"
 #include "mqtt/buffer_ref.h"
@@ -77,15 +79,31 @@ private:
     binary_ref payload_;
     /** The properties for the message  */
     properties props_;
+    /** Properties shared with other messages, made from a template */
+    std::shared_ptr<const properties> sharedProps_;
+    /** Whether the client is tracing this incoming message */
+    bool traced_{false};
 
     /** The client has special access. */
     friend class async_client;
+    /** Templates set the shared properties. */
+    friend class message_template;
 
     /**
      * Set the dup flag in the underlying message
      * @param dup Whether to set the dup flag.
      */
     void set_duplicate(bool dup) { msg_.dup = to_int(dup); }
+    /**
+     * Uses properties that are shared with other messages, rather than
+     * a copy of them.
+     * @param props The shared properties.
+     */
+    void share_properties(std::shared_ptr<const properties> props) {
+        props_.clear();
+        sharedProps_ = std::move(props);
+        msg_.properties = sharedProps_->c_struct();
+    }
 
 public:
     /** Smart/shared pointer to this class. */
@@ -148,6 +166,16 @@ public:
      * @param cmsg A "C" MQTTAsync_message structure.
      */
     message(string_ref topic, const MQTTAsync_message& cmsg);
+    /**
+     * Constructs a message from the message structure, but with the
+     * specified payload in place of the one in the C struct.
+     * This is typically used to adopt the payload buffer from the C
+     * library without copying it.
+     * @param topic The message topic
+     * @param cmsg A "C" MQTTAsync_message structure.
+     * @param payload The payload for the message.
+     */
+    message(string_ref topic, const MQTTAsync_message& cmsg, binary_ref payload);
     /**
      * Constructs a message as a copy of the other message.
      * @param other The message to copy into this one.
@@ -228,6 +256,36 @@ public:
     static ptr_t create(string_ref topic, const MQTTAsync_message& msg) {
         return std::make_shared<message>(std::move(topic), msg);
     }
+    /**
+     * Constructs a message from the C message struct, but with the
+     * specified payload in place of the one in the C struct.
+     * @param topic The message topic
+     * @param msg A "C" MQTTAsync_message structure.
+     * @param payload The payload for the message.
+     */
+    static ptr_t create(
+        string_ref topic, const MQTTAsync_message& msg, binary_ref payload
+    ) {
+        return std::make_shared<message>(std::move(topic), msg, std::move(payload));
+    }
+    /**
+     * Creates a message to forward another one, such as one that was
+     * received, possibly to a different topic.
+     *
+     * The new message shares the topic (unless it's overridden), payload,
+     * and properties of the original, rather than copying them, and keeps
+     * the original alive for as long as it needs its properties. It has
+     * the same QoS and retained flag. The properties that only go from a
+     * server to a client, the subscription identifiers and topic alias,
+     * can't be sent on, so if the original has any of them, the new
+     * message gets a copy of the other properties instead.
+     *
+     * @param msg The message to forward.
+     * @param topic The topic for the new message. If this is empty, the
+     *  			topic of the original message is used.
+     * @return A new message with the contents of the original.
+     */
+    static ptr_t forward(const const_ptr_t& msg, string_ref topic = string_ref{});
     /**
      * Copies another message to this one.
      * @param rhs The other message.
@@ -314,6 +372,42 @@ public:
     void set_payload(const void* payload, size_t n) {
         set_payload(binary_ref(static_cast<const binary_ref::value_type*>(payload), n));
     }
+    /**
+     * Sets the payload of this message from a sequence of segments, such
+     * as a header, body, and trailer.
+     *
+     * The segments are gathered into a single payload buffer, sized up
+     * front, so the data is copied once, and the segments don't need to
+     * outlive the call.
+     *
+     * @param first Iterator to the first segment. Each segment must be
+     *  			convertible to a `std::string_view`, such as a
+     *  			`binary`, `binary_view`, or `binary_ref`.
+     * @param last Iterator to one past the last segment.
+     */
+    template <typename InputIt>
+    void set_payload(InputIt first, InputIt last) {
+        size_t n = 0;
+        for (auto it = first; it != last; ++it) n += std::string_view(*it).size();
+
+        binary buf;
+        buf.reserve(n);
+        for (auto it = first; it != last; ++it) buf.append(std::string_view(*it));
+        set_payload(std::move(buf));
+    }
+    /**
+     * Sets the payload of this message from a list of segments, such as a
+     * header, body, and trailer.
+     *
+     * The segments are gathered into a single payload buffer, sized up
+     * front, so the data is copied once, and the segments don't need to
+     * outlive the call.
+     *
+     * @param segments The segments, in order.
+     */
+    void set_payload(std::initializer_list<std::string_view> segments) {
+        set_payload(segments.begin(), segments.end());
+    }
     /**
      * Sets the quality of service for this message.
      * @param qos The integer Quality of Service for the message
@@ -341,12 +435,28 @@ public:
      * Gets the properties in the message.
      * @return A const reference to the properties in the message.
      */
-    const properties& get_properties() const { return props_; }
+    const properties& get_properties() const {
+        return sharedProps_ ? *sharedProps_ : props_;
+    }
+    /**
+     * Gets an estimate of the memory held by the message.
+     * This counts the message object, its topic and payload, and its own
+     * properties, but not any properties that it shares with other
+     * messages. A topic or payload shared with other messages is counted
+     * in full.
+     * @return The approximate number of bytes held by the message.
+     */
+    size_t memory_size() const {
+        const auto& props = props_.c_struct();
+        return sizeof(message) + topic_.size() + payload_.size() +
+               size_t(props.max_count) * sizeof(MQTTProperty) + size_t(props.length);
+    }
     /**
      * Sets the properties in the message.
      * @param props The properties to place into the message.
      */
     void set_properties(const properties& props) {
+        sharedProps_.reset();
         props_ = props;
         msg_.properties = props_.c_struct();
     }
@@ -355,6 +465,7 @@ public:
      * @param props The properties to move into the message.
      */
     void set_properties(properties&& props) {
+        sharedProps_.reset();
         props_ = std::move(props);
         msg_.properties = props_.c_struct();
     }
@@ -468,6 +579,15 @@ public:
         msg_->set_payload(payload, n);
         return *this;
     }
+    /**
+     * Sets the payload of this message from a list of segments.
+     * The segments are copied into a single payload buffer.
+     * @param segments The segments, in order.
+     */
+    auto payload(std::initializer_list<std::string_view> segments) -> self& {
+        msg_->set_payload(segments);
+        return *this;
+    }
     /**
      * Sets the quality of service for this message.
      * @param qos The integer Quality of Service for the message
@@ -0,0 +1,221 @@
+/////////////////////////////////////////////////////////////////////////////
+/// @file message_dispatcher.h
+/// Declaration of MQTT message_dispatcher class
+/// @author Frank Pagliughi
+/////////////////////////////////////////////////////////////////////////////
+
+/*******************************************************************************
+ * Copyright (c) 2025 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+#ifndef __mqtt_message_dispatcher_h
+#define __mqtt_message_dispatcher_h
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "mqtt/cpu_affinity.h"
+#include "mqtt/message.h"
+#include "mqtt/thread_queue.h"
+
+namespace mqtt {
+
+/////////////////////////////////////////////////////////////////////////////
+
+/**
+ * How a dispatcher assigns the messages to its workers.
+ */
+enum class dispatch_mode {
+    /** Messages with the same key go to the same worker, in order */
+    ORDERED,
+    /** Messages go to any worker, with idle workers taking from busy ones */
+    UNORDERED
+};
+
+/////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Dispatches messages to a handler on a pool of worker threads.
+ *
+ * Each message is assigned to one of the workers by a key, which by
+ * default is a hash of the message's topic. All the messages with the same
+ * key go to the same worker, and are handled in the order that they were
+ * dispatched. Messages with different keys may be handled in parallel.
+ *
+ * Each worker has its own queue, so a slow handler will only delay other
+ * messages assigned to the same worker.
+ *
+ * When the order of the messages doesn't matter, such as for events from
+ * independent devices, the dispatcher can be made unordered instead. The
+ * messages are then spread over the workers in turn, and a worker that
+ * runs out of messages steals them from the others. So the work stays
+ * balanced over all of the workers, even when a few topics carry most of
+ * the traffic, or some messages take much longer to handle than others.
+ *
+ * Any exception that escapes the handler is caught and discarded by the
+ * worker, so that it can continue on to the next message.
+ */
+class message_dispatcher
+{
+public:
+    /** Smart/shared pointer to an object of this class. */
+    using ptr_t = std::unique_ptr<message_dispatcher>;
+    /** The handler for the messages */
+    using handler_type = std::function<void(const_message_ptr)>;
+    /** How the messages are assigned to the workers */
+    using mode_type = dispatch_mode;
+    /** A function to get the dispatch key for a message */
+    using key_func = std::function<size_t(const const_message_ptr&)>;
+
+private:
+    /** Worker thread and its queue */
+    struct worker
+    {
+        thread_queue<const_message_ptr> que;
+        std::thread thr;
+    };
+
+    /** The message handler */
+    handler_type handler_;
+    /** Function to find the key for a message */
+    key_func keyFunc_;
+    /** The workers */
+    std::vector<std::unique_ptr<worker>> workers_;
+    /** How the messages are assigned to the workers */
+    dispatch_mode mode_{dispatch_mode::ORDERED};
+    /** The next worker to get a message, when unordered */
+    std::atomic<size_t> next_{0};
+    /** The number of messages queued to all the workers, when unordered */
+    std::atomic<size_t> nQueued_{0};
+    /** The number of workers waiting for messages, when unordered */
+    std::atomic<size_t> nIdle_{0};
+    /** Lock for the idle workers to wait on */
+    std::mutex idleLock_;
+    /** Signaled when there are messages for an idle worker */
+    std::condition_variable idleCond_;
+    /** Whether the dispatcher is stopping */
+    bool stopping_{false};
+
+    /** Creates the workers and starts their threads */
+    void start(size_t nWorkers);
+    /** The worker thread function */
+    void run(worker& w);
+    /** The worker thread function, when unordered */
+    void run_unordered(size_t idx);
+    /**
+     * Takes the next message for a worker from its own queue, or failing
+     * that, from one of the others.
+     */
+    bool take(size_t idx, const_message_ptr* msg);
+
+public:
+    /**
+     * Creates a dispatcher and starts the worker threads.
+     * @param handler The message handler.
+     * @param nWorkers The number of worker threads. If this is zero, the
+     *  			   number of hardware threads is used.
+     * @param keyFunc A function to get the dispatch key for a message. If
+     *  			  this is empty, a hash of the topic is used.
+     */
+    message_dispatcher(handler_type handler, size_t nWorkers, key_func keyFunc = key_func{});
+    /**
+     * Creates a dispatcher with the specified mode and starts the worker
+     * threads. An ordered dispatcher uses the hash of the topic as the key.
+     * @param handler The message handler.
+     * @param nWorkers The number of worker threads. If this is zero, the
+     *  			   number of hardware threads is used.
+     * @param mode How the messages are assigned to the workers.
+     */
+    message_dispatcher(handler_type handler, size_t nWorkers, dispatch_mode mode);
+    /**
+     * Destructor stops the dispatcher, handling any pending messages.
+     */
+    ~message_dispatcher();
+
+    message_dispatcher(const message_dispatcher&) = delete;
+    message_dispatcher& operator=(const message_dispatcher&) = delete;
+
+    /**
+     * Gets the default key for a message, which is a hash of the topic.
+     * @param msg The message.
+     * @return The hash of the message topic.
+     */
+    static size_t topic_key(const const_message_ptr& msg);
+    /**
+     * Gets the number of worker threads.
+     * @return The number of worker threads.
+     */
+    size_t num_workers() const { return workers_.size(); }
+    /**
+     * Gets how the messages are assigned to the workers.
+     * @return The dispatch mode.
+     */
+    dispatch_mode get_mode() const { return mode_; }
+    /**
+     * Gets the worker that handles messages with the specified key.
+     * This only applies to an ordered dispatcher.
+     * @param key The dispatch key.
+     * @return The index of the worker for the key.
+     */
+    size_t worker_index(size_t key) const { return key % workers_.size(); }
+    /**
+     * Gets the number of messages waiting to be handled.
+     * This is the total of the queues of all the workers, not counting any
+     * messages that are being handled at the moment.
+     * @return The number of messages waiting to be handled.
+     */
+    size_t pending() const;
+    /**
+     * Pins the worker threads to a set of CPUs.
+     * The memory for a worker's queue is allocated by the threads that
+     * dispatch to it, so to keep the messages on one NUMA node, the
+     * threads receiving the messages should be pinned to the same node.
+     * @param cpus The CPUs for the workers.
+     * @param onePerWorker If @em true, each worker is pinned to one of the
+     *  				   CPUs, in turn, rather than to all of them.
+     * @return @em true if all the workers were pinned, @em false if the
+     *  	   set is empty, or the platform doesn't support it.
+     */
+    bool set_cpu_affinity(const cpu_set& cpus, bool onePerWorker = false);
+    /**
+     * Queues a message to be handled by the worker for its key, or, if the
+     * dispatcher is unordered, by the next worker in turn.
+     * @param msg The message.
+     * @return @em true if the message was queued, @em false if the
+     *  	   dispatcher has been stopped.
+     */
+    bool dispatch(const_message_ptr msg);
+    /**
+     * Stops the dispatcher.
+     * No more messages are accepted. This blocks until the workers have
+     * handled all the messages that were already queued, and then exited.
+     * This must not be called from within the handler.
+     */
+    void stop();
+};
+
+/** Smart/shared pointer to a message dispatcher */
+using message_dispatcher_ptr = message_dispatcher::ptr_t;
+
+/////////////////////////////////////////////////////////////////////////////
+}  // namespace mqtt
+
+#endif  // __mqtt_message_dispatcher_h
@@ -0,0 +1,291 @@
+/////////////////////////////////////////////////////////////////////////////
+/// @file message_pool.h
+/// Declaration of MQTT message_pool class
+/// @author Frank Pagliughi
+/////////////////////////////////////////////////////////////////////////////
+
+/*******************************************************************************
+ * Copyright (c) 2025 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+#ifndef __mqtt_message_pool_h
+#define __mqtt_message_pool_h
+
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <vector>
+
+#include "MQTTAsync.h"
+#include "mqtt/buffer_ref.h"
+#include "mqtt/message.h"
+
+namespace mqtt {
+
+/////////////////////////////////////////////////////////////////////////////
+
+/**
+ * A pool of recycled memory blocks for creating messages.
+ *
+ * Each incoming message is normally created with `std::make_shared`,
+ * which does a heap allocation for the message object and the shared
+ * pointer's control block, and more for the shared payload buffer and its
+ * data. When a client is receiving a high rate of messages, this pool can
+ * be used to recycle those blocks. When the last reference to a message
+ * or payload is released, its memory is returned to the pool to be
+ * re-used for the next message, rather than being returned to the heap.
+ * @par
+ * The payload data is held in blocks rounded up to a power of two, so
+ * that it can be recycled for payloads of about the same size. The data
+ * of a payload larger than @ref MAX_POOLED_SIZE isn't pooled. The pooled
+ * payload is adopted by its buffer, so it's read in place through the
+ * buffer reference, such as with message::get_payload_ref(). Getting it
+ * as a string, with message::get_payload_str(), makes a copy of it from
+ * the heap the first time.
+ *
+ * The memory is held in a shared arena that is kept alive by any message
+ * created from it, so the messages can safely outlive the pool and the
+ * client that owns it.
+ *
+ * The memory can also be taken from a `std::pmr::memory_resource`, such
+ * as a monotonic arena from the application, in place of the heap. Then
+ * the message objects, the topic and payload buffers, and their shared
+ * pointer control blocks all come from the resource, so that they can be
+ * released in bulk with it. The property lists are allocated by the C
+ * library, and still come from the heap. The resource doesn't need to be
+ * thread safe, since the pool serializes its use of it, but it must
+ * outlive all the messages created from it.
+ *
+ * The pool is thread safe. Messages are typically created by the C
+ * library's callback thread, and released by any application thread.
+ */
+class message_pool
+{
+public:
+    /** Smart/shared pointer to an object of this class. */
+    using ptr_t = std::shared_ptr<message_pool>;
+
+    /** The default number of free blocks held for each size */
+    static constexpr size_t DFLT_MAX_FREE = 1024;
+    /** The largest payload whose data is held in a pooled block */
+    static constexpr size_t MAX_POOLED_SIZE = 16 * 1024;
+
+private:
+    /**
+     * The memory store for the pool.
+     * It holds lists of free blocks, each list for a fixed block size.
+     */
+    class arena
+    {
+        /** A list of free blocks, all of the same size */
+        struct free_list
+        {
+            size_t blkSize;
+            std::vector<void*> blks;
+        };
+
+        /** Lock to protect the free lists */
+        std::mutex lock_;
+        /** The maximum number of free blocks held for each size */
+        size_t maxFree_;
+        /** The free lists. There should only be a few different sizes */
+        std::vector<free_list> lists_;
+        /** Where the memory comes from, or null for the heap */
+        std::pmr::memory_resource* upstream_;
+
+        /** Gets the list for blocks of the size (must hold lock) */
+        free_list& get_list(size_t n);
+
+    public:
+        explicit arena(size_t maxFree, std::pmr::memory_resource* upstream = nullptr)
+            : maxFree_{maxFree}, upstream_{upstream} {}
+        ~arena();
+
+        arena(const arena&) = delete;
+        arena& operator=(const arena&) = delete;
+
+        /** Gets a block of memory of the specified size */
+        void* allocate(size_t n);
+        /** Returns a block to the pool */
+        void deallocate(void* p, size_t n) noexcept;
+        /** Gets memory for a buffer from the upstream, bypassing the free lists */
+        void* allocate_data(size_t n);
+        /** Returns the memory for a buffer to the upstream */
+        void deallocate_data(void* p, size_t n) noexcept;
+        /** Gets the upstream memory resource, if any */
+        std::pmr::memory_resource* upstream() const { return upstream_; }
+        /** Gets the number of free blocks in the pool */
+        size_t free_count();
+        /** Gets the maximum number of free blocks for each size */
+        size_t max_free() const { return maxFree_; }
+    };
+
+    /**
+     * A standard allocator that gets memory from the arena.
+     * This is suitable for use with `std::allocate_shared`.
+     */
+    template <typename T>
+    class allocator
+    {
+        /** The arena holding the memory. */
+        std::shared_ptr<arena> arena_;
+
+        template <typename U>
+        friend class allocator;
+
+    public:
+        using value_type = T;
+
+        explicit allocator(std::shared_ptr<arena> a) noexcept : arena_{std::move(a)} {}
+
+        template <typename U>
+        allocator(const allocator<U>& other) noexcept : arena_{other.arena_} {}
+
+        T* allocate(size_t n) { return static_cast<T*>(arena_->allocate(n * sizeof(T))); }
+        void deallocate(T* p, size_t n) noexcept { arena_->deallocate(p, n * sizeof(T)); }
+
+        template <typename U>
+        bool operator==(const allocator<U>& rhs) const noexcept {
+            return arena_ == rhs.arena_;
+        }
+        template <typename U>
+        bool operator!=(const allocator<U>& rhs) const noexcept {
+            return arena_ != rhs.arena_;
+        }
+    };
+
+    /** The smallest block for the payload data */
+    static constexpr size_t MIN_BLOCK_SIZE = 32;
+
+    /** The memory for the pool */
+    std::shared_ptr<arena> arena_;
+
+    /**
+     * Gets the size of the pooled block for a payload.
+     * @param n The size of the payload.
+     * @return The block size, or zero if the payload is too big to pool.
+     */
+    static size_t block_size(size_t n);
+
+public:
+    /**
+     * Creates a message pool.
+     * @param maxFree The maximum number of free blocks to keep in the pool
+     *  			  for re-use, for each block size. Blocks released
+     *  			  beyond this are returned to the heap.
+     */
+    explicit message_pool(size_t maxFree = DFLT_MAX_FREE)
+        : arena_{std::make_shared<arena>(maxFree)} {}
+    /**
+     * Creates a message pool.
+     * @param maxFree The maximum number of free blocks to keep in the pool
+     *  			  for re-use, for each block size.
+     * @return A shared pointer to a new message pool.
+     */
+    static ptr_t create(size_t maxFree = DFLT_MAX_FREE) {
+        return std::make_shared<message_pool>(maxFree);
+    }
+    /**
+     * Creates a message pool that takes its memory from a memory
+     * resource.
+     * @param upstream The memory resource for the messages and their
+     *  			   buffers. It must outlive all of the messages.
+     * @param maxFree The maximum number of free blocks to keep in the pool
+     *  			  for re-use, for each block size. Blocks released
+     *  			  beyond this are returned to the resource. With a
+     *  			  monotonic resource, which only releases memory in
+     *  			  bulk, this should be zero.
+     */
+    message_pool(std::pmr::memory_resource* upstream, size_t maxFree)
+        : arena_{std::make_shared<arena>(maxFree, upstream)} {}
+    /**
+     * Creates a message pool that takes its memory from a memory
+     * resource.
+     * @param upstream The memory resource for the messages and their
+     *  			   buffers. It must outlive all of the messages.
+     * @param maxFree The maximum number of free blocks to keep in the pool
+     *  			  for re-use, for each block size.
+     * @return A shared pointer to a new message pool.
+     */
+    static ptr_t create(std::pmr::memory_resource* upstream, size_t maxFree = 0) {
+        return std::make_shared<message_pool>(upstream, maxFree);
+    }
+    /**
+     * Gets the memory resource that the pool takes its memory from.
+     * @return The memory resource, or null if the memory comes from the
+     *  	   heap.
+     */
+    std::pmr::memory_resource* upstream_resource() const { return arena_->upstream(); }
+    /**
+     * Gets the maximum number of free blocks that are kept in the pool
+     * for each block size.
+     * @return The maximum number of free blocks per size.
+     */
+    size_t max_free() const { return arena_->max_free(); }
+    /**
+     * Gets the number of free blocks currently held in the pool.
+     * @return The number of free blocks currently held in the pool.
+     */
+    size_t free_count() const { return arena_->free_count(); }
+    /**
+     * Creates a shared buffer containing a copy of the data, with the data
+     * and the shared state taken from the pool.
+     * This can be used for topics or payloads.
+     * @param buf The data to copy
+     * @param n The number of bytes to copy.
+     * @return A reference to the new buffer.
+     */
+    binary_ref create_buffer(const void* buf, size_t n);
+    /**
+     * Creates a message from the C struct, copying the payload into a
+     * buffer taken from the pool.
+     * @param topic The message topic
+     * @param msg A "C" MQTTAsync_message structure.
+     * @return A shared pointer to the new message.
+     */
+    message_ptr create_message(string_ref topic, const MQTTAsync_message& msg);
+    /**
+     * Creates a message from the C struct, but with the specified payload
+     * in place of the one in the C struct.
+     * @param topic The message topic
+     * @param msg A "C" MQTTAsync_message structure.
+     * @param payload The payload for the message.
+     * @return A shared pointer to the new message.
+     */
+    message_ptr create_message(
+        string_ref topic, const MQTTAsync_message& msg, binary_ref payload
+    );
+    /**
+     * Creates an object of any type, with the shared pointer taken from
+     * the pool.
+     * The client uses this to recycle its delivery tokens, but it can be
+     * used for any object that is created and released at a high rate.
+     * @param args The arguments for the constructor of the object.
+     * @return A shared pointer to the new object.
+     */
+    template <typename T, typename... Args>
+    std::shared_ptr<T> make_shared(Args&&... args) {
+        return std::allocate_shared<T>(allocator<T>{arena_}, std::forward<Args>(args)...);
+    }
+};
+
+/** Smart/shared pointer to a message pool */
+using message_pool_ptr = message_pool::ptr_t;
+
+/////////////////////////////////////////////////////////////////////////////
+}  // namespace mqtt
+
+#endif  // __mqtt_message_pool_h
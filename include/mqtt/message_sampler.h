@@ -0,0 +1,168 @@
+/////////////////////////////////////////////////////////////////////////////
+/// @file message_sampler.h
+/// Declaration of MQTT message_sampler class
+/// @author Frank Pagliughi
+/////////////////////////////////////////////////////////////////////////////
+
+/*******************************************************************************
+ * Copyright (c) 2025 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+#ifndef __mqtt_message_sampler_h
+#define __mqtt_message_sampler_h
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+
+#include "mqtt/concurrent_topic_matcher.h"
+#include "mqtt/types.h"
+
+namespace mqtt {
+
+/////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Samples or drops the incoming messages, by topic.
+ *
+ * The sampler has a set of rules, each a topic filter with the number of
+ * messages to take one from. A rule of 10 keeps the first message on its
+ * topics and every tenth one after that, and a rule of zero drops them
+ * all. All the topics that match a filter share its count. An incoming
+ * message is checked against the first rule, in the order they were
+ * added, with a filter that matches its topic. A message that doesn't
+ * match any rule is kept.
+ * @par
+ * This is for high-volume topics that a consumer only needs a sample of.
+ * The client checks each message as soon as it arrives from the C
+ * library, against the raw topic, so the messages that aren't wanted are
+ * acknowledged and freed before any @ref message is built or queued for
+ * them. They don't reach the callbacks, the consumer queue, or the other
+ * filters, like the sequence tracker, which sees the skipped ones as
+ * gaps. A message that uses a topic alias is always kept, so that the
+ * client can resolve the alias.
+ * @par
+ * Sampling doesn't reduce what the server sends. Subscribing to the
+ * sampled topics at QoS 0 keeps the cost of the dropped messages to a
+ * minimum.
+ * @par
+ * It's given to a client with create_options::set_message_sampler(),
+ * and can be shared by a number of clients, such as those in a
+ * @ref client_pool, to sample them together. The rules are kept in a
+ * @ref concurrent_topic_matcher, so checking a message doesn't take a
+ * lock. Changing the rules is relatively expensive, so they should be
+ * set up front.
+ *
+ * @code
+ *     auto sampler = mqtt::message_sampler::create();
+ *     sampler->add_rule("telemetry/+/raw", 100);
+ *     sampler->drop("debug/#");
+ *
+ *     auto cli = mqtt::async_client{
+ *         mqtt::create_options_builder()
+ *             .server_uri("mqtt://localhost:1883")
+ *             .message_sampler(sampler)
+ *             .finalize()
+ *     };
+ * @endcode
+ */
+class message_sampler
+{
+    /** A rule for the topics matching a filter */
+    struct rule
+    {
+        /** The order the rule was added, to pick the first that matches */
+        size_t order;
+        /** The number of messages to keep one from, or zero to drop them */
+        uint64_t every;
+        /** The number of messages checked against the rule */
+        std::atomic<uint64_t> count{0};
+
+        rule(size_t ord, uint64_t n) : order{ord}, every{n} {}
+    };
+
+    /** The rules, by topic filter */
+    concurrent_topic_matcher<std::shared_ptr<rule>> rules_;
+    /** The number of rules ever added, for their order */
+    std::atomic<size_t> nAdded_{0};
+    /** The number of messages dropped */
+    std::atomic<uint64_t> nDropped_{0};
+
+public:
+    /** Smart/shared pointer to an object of this class */
+    using ptr_t = std::shared_ptr<message_sampler>;
+
+    /**
+     * Creates a sampler without any rules.
+     */
+    message_sampler() {}
+    /**
+     * Creates a sampler without any rules.
+     * @return A shared pointer to the new sampler.
+     */
+    static ptr_t create() { return std::make_shared<message_sampler>(); }
+
+    message_sampler(const message_sampler&) = delete;
+    message_sampler& operator=(const message_sampler&) = delete;
+
+    /**
+     * Adds a rule, or replaces the one for the same filter.
+     * A replaced rule keeps its place in the order, but starts its count
+     * over.
+     * @param filter The topic filter, which may have wildcards.
+     * @param every The number of messages to keep one from. One keeps
+     *  			them all, and zero drops them all.
+     */
+    void add_rule(const string& filter, uint64_t every);
+    /**
+     * Adds a rule to drop all the messages on the topics matching a
+     * filter.
+     * @param filter The topic filter, which may have wildcards.
+     */
+    void drop(const string& filter) { add_rule(filter, 0); }
+    /**
+     * Removes the rule for a filter.
+     * @param filter The topic filter of the rule.
+     * @return @em true if there was a rule for the filter.
+     */
+    bool remove_rule(const string& filter) { return bool(rules_.remove(filter)); }
+    /**
+     * Determines if there are no rules.
+     * @return @em true if there are no rules.
+     */
+    bool empty() const { return rules_.empty(); }
+    /**
+     * Checks an incoming message against the rules, counting it against
+     * the rule that it matches.
+     * @param topic The topic of the message.
+     * @return @em true if the message should be kept, @em false if it
+     *  	   should be dropped.
+     */
+    bool keep(std::string_view topic);
+    /**
+     * Gets the number of messages that were dropped.
+     * @return The number of messages that were dropped.
+     */
+    uint64_t num_dropped() const { return nDropped_.load(std::memory_order_relaxed); }
+};
+
+/** Smart/shared pointer to a message sampler */
+using message_sampler_ptr = message_sampler::ptr_t;
+
+/////////////////////////////////////////////////////////////////////////////
+}  // namespace mqtt
+
+#endif  // __mqtt_message_sampler_h
@@ -0,0 +1,164 @@
+/////////////////////////////////////////////////////////////////////////////
+/// @file message_template.h
+/// Declaration of MQTT message_template class
+/// @author Frank Pagliughi
+/////////////////////////////////////////////////////////////////////////////
+
+/*******************************************************************************
+ * Copyright (c) 2025 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+#ifndef __mqtt_message_template_h
+#define __mqtt_message_template_h
+
+#include <memory>
+
+#include "mqtt/message.h"
+
+namespace mqtt {
+
+/////////////////////////////////////////////////////////////////////////////
+
+/**
+ * A template for making messages that differ only in their payloads.
+ *
+ * When an application publishes many messages to the same topic, with the
+ * same QoS, retained flag, and MQTT v5 properties, the template holds
+ * those parts once. Each message made from it shares the topic string and
+ * the properties of the template, rather than making its own copies, so
+ * the only thing allocated for a new message is the message itself and
+ * its payload.
+ * @par
+ * The properties of a message made from a template can still be changed
+ * with message::set_properties(), which gives the message its own copy,
+ * and doesn't affect the template or the other messages.
+ *
+ * @code
+ *     mqtt::properties props{
+ *         {mqtt::property::CONTENT_TYPE, "application/json"}
+ *     };
+ *     mqtt::message_template tmpl{"data/temp", 1, false, props};
+ *     while (running)
+ *         cli.publish(tmpl.make(read_sensor_json()));
+ * @endcode
+ */
+class message_template
+{
+    /** The topic for the messages */
+    string_ref topic_;
+    /** The QoS for the messages */
+    int qos_;
+    /** The retained flag for the messages */
+    bool retained_;
+    /** The properties shared by the messages */
+    std::shared_ptr<const properties> props_;
+
+public:
+    /**
+     * Creates a message template.
+     * @param topic The topic for the messages.
+     * @param qos The QoS for the messages.
+     * @param retained Whether the messages should be retained by the
+     *  			   server.
+     * @param props The MQTT v5 properties for the messages.
+     * @throw exception if the QoS is invalid.
+     */
+    explicit message_template(
+        string_ref topic, int qos = message::DFLT_QOS,
+        bool retained = message::DFLT_RETAINED, const properties& props = properties()
+    )
+        : topic_{std::move(topic)},
+          qos_{qos},
+          retained_{retained},
+          props_{std::make_shared<const properties>(props)} {
+        message::validate_qos(qos);
+    }
+    /**
+     * Gets the topic for the messages.
+     * @return The topic for the messages.
+     */
+    const string& get_topic() const { return topic_ ? topic_.str() : message::EMPTY_STR; }
+    /**
+     * Gets the shared reference to the topic for the messages.
+     * @return The topic for the messages.
+     */
+    const string_ref& get_topic_ref() const { return topic_; }
+    /**
+     * Gets the QoS for the messages.
+     * @return The QoS for the messages.
+     */
+    int get_qos() const { return qos_; }
+    /**
+     * Determines if the messages are retained.
+     * @return @em true if the messages should be retained by the server.
+     */
+    bool is_retained() const { return retained_; }
+    /**
+     * Gets the properties for the messages.
+     * @return The MQTT v5 properties for the messages.
+     */
+    const properties& get_properties() const { return *props_; }
+    /**
+     * Sets the QoS for the messages made from now on.
+     * @param qos The QoS for the messages.
+     * @throw exception if the QoS is invalid.
+     */
+    void set_qos(int qos) {
+        message::validate_qos(qos);
+        qos_ = qos;
+    }
+    /**
+     * Sets the retained flag for the messages made from now on.
+     * @param retained Whether the messages should be retained by the
+     *  			   server.
+     */
+    void set_retained(bool retained) { retained_ = retained; }
+    /**
+     * Sets the properties for the messages made from now on.
+     * Messages already made keep the properties they were made with.
+     * @param props The MQTT v5 properties for the messages.
+     */
+    void set_properties(const properties& props) {
+        props_ = std::make_shared<const properties>(props);
+    }
+    /**
+     * Makes a message from the template.
+     * @param payload The payload for the message.
+     * @return A new message, which shares the topic and properties of the
+     *  	   template.
+     */
+    message_ptr make(binary_ref payload) const {
+        auto msg = message::create(topic_, std::move(payload), qos_, retained_);
+        msg->share_properties(props_);
+        return msg;
+    }
+    /**
+     * Makes a message from the template.
+     * @param payload The bytes to use as the message payload.
+     * @param n The number of bytes in the payload.
+     * @return A new message, which shares the topic and properties of the
+     *  	   template.
+     */
+    message_ptr make(const void* payload, size_t n) const {
+        auto msg = message::create(topic_, payload, n, qos_, retained_);
+        msg->share_properties(props_);
+        return msg;
+    }
+};
+
+/////////////////////////////////////////////////////////////////////////////
+}  // namespace mqtt
+
+#endif  // __mqtt_message_template_h
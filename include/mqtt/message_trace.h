@@ -0,0 +1,102 @@
+/////////////////////////////////////////////////////////////////////////////
+/// @file message_trace.h
+/// Declaration of the MQTT message trace points
+/// @author Frank Pagliughi
+/////////////////////////////////////////////////////////////////////////////
+
+/*******************************************************************************
+ * Copyright (c) 2025 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+#ifndef __mqtt_message_trace_h
+#define __mqtt_message_trace_h
+
+#include <chrono>
+#include <functional>
+#include <iostream>
+
+namespace mqtt {
+
+class message;
+
+/////////////////////////////////////////////////////////////////////////////
+
+/**
+ * The points in the life of a message that can be traced.
+ */
+enum class trace_point {
+    /** An outgoing message was given to publish() */
+    PUBLISH,
+    /** An outgoing message was handed to the C library to send */
+    SEND,
+    /** The delivery of an outgoing message completed successfully */
+    DELIVERED,
+    /** An incoming message arrived from the C library */
+    ARRIVED,
+    /** An incoming message was put into the consumer queue */
+    QUEUED,
+    /** An incoming message was read from the consumer queue */
+    CONSUMED
+};
+
+/** The clock for the time stamps of the trace points */
+using trace_clock = std::chrono::steady_clock;
+
+/**
+ * Handler type for the message trace points.
+ * It receives the trace point, the message, and the time that the message
+ * reached the point. It's called from whichever thread is handling the
+ * message at the time, so it should be quick, and thread safe.
+ */
+using trace_handler =
+    std::function<void(trace_point, const message&, trace_clock::time_point)>;
+
+/**
+ * Gets a printable name for a trace point.
+ * @param pt The trace point.
+ * @return The name of the trace point.
+ */
+inline const char* trace_point_name(trace_point pt) noexcept {
+    switch (pt) {
+        case trace_point::PUBLISH:
+            return "PUBLISH";
+        case trace_point::SEND:
+            return "SEND";
+        case trace_point::DELIVERED:
+            return "DELIVERED";
+        case trace_point::ARRIVED:
+            return "ARRIVED";
+        case trace_point::QUEUED:
+            return "QUEUED";
+        case trace_point::CONSUMED:
+            return "CONSUMED";
+    }
+    return "UNKNOWN";
+}
+
+/**
+ * Stream inserter for a trace point.
+ * @param os The output stream.
+ * @param pt The trace point.
+ * @return A reference to the output stream.
+ */
+inline std::ostream& operator<<(std::ostream& os, trace_point pt) {
+    return os << trace_point_name(pt);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+}  // namespace mqtt
+
+#endif  // __mqtt_message_trace_h
@@ -0,0 +1,529 @@
+/////////////////////////////////////////////////////////////////////////////
+/// @file multi_lane_queue.h
+/// Implementation of the template class 'multi_lane_queue', a thread-safe,
+/// blocking queue that holds items in separate lanes by priority, for
+/// passing data between threads.
+/////////////////////////////////////////////////////////////////////////////
+
+/*******************************************************************************
+ * Copyright (c) 2025 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+#ifndef __mqtt_multi_lane_queue_h
+#define __mqtt_multi_lane_queue_h
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <vector>
+
+#include "mqtt/thread_queue.h"
+
+namespace mqtt {
+
+/////////////////////////////////////////////////////////////////////////////
+
+/**
+ * A thread-safe queue that serves items by priority.
+ *
+ * This has the same API as the @ref thread_queue, but the items are kept in
+ * a number of FIFO "lanes". A function given to the constructor picks the
+ * lane for each item as it is put into the queue. Lane zero has the highest
+ * priority, and a get() always takes the next item from the highest
+ * priority lane that has one, so an urgent item doesn't wait behind a
+ * backlog of less important ones.
+ * @par
+ * So that a steady stream of high priority items can't starve the others,
+ * after a number of items in a row (the "burst") are taken from a higher
+ * lane while a lower one is waiting, the next item is taken from a lower
+ * lane. The lower lanes take these turns in round-robin order. Items within
+ * a lane are always kept in order.
+ * @par
+ * The capacity bounds the total number of items in all the lanes. A put to
+ * a full queue blocks, and the queue can be closed, all with the same
+ * semantics as the @ref thread_queue.
+ *
+ * @tparam T The type of the items to be held in the queue.
+ */
+template <typename T>
+class multi_lane_queue
+{
+public:
+    /** The type of items to be held in the queue. */
+    using value_type = T;
+    /** The type used to specify number of items in the container. */
+    using size_type = std::size_t;
+    /** The type of function to choose the lane for an item. */
+    using lane_function = std::function<size_t(const value_type&)>;
+
+    /** The maximum capacity of the queue. */
+    static constexpr size_type MAX_CAPACITY = std::numeric_limits<size_type>::max();
+    /**
+     * The default number of items taken in a row from the higher lanes
+     * before one is taken from a waiting lower lane.
+     */
+    static constexpr size_t DFLT_BURST = 16;
+
+private:
+    /** Object lock */
+    mutable std::mutex lock_;
+    /** Condition get signaled when item added to empty queue */
+    std::condition_variable notEmptyCond_;
+    /** Condition gets signaled then item removed from full queue */
+    std::condition_variable notFullCond_;
+    /** The lanes, highest priority first */
+    std::vector<std::deque<value_type>> lanes_;
+    /** The function to choose a lane */
+    lane_function laneFunc_;
+    /** The capacity of the queue */
+    size_type cap_{MAX_CAPACITY};
+    /** The number of items taken in a row that starve a lower lane */
+    size_t burst_{DFLT_BURST};
+    /** The total number of items in all the lanes */
+    size_type size_{0};
+    /** The number of items taken in a row while a lower lane waited */
+    size_t streak_{0};
+    /** The next lower lane to get a turn */
+    size_t nextLow_{0};
+    /** Whether the queue is closed */
+    bool closed_{false};
+
+    /** Simple, scope-based lock guard */
+    using guard = std::lock_guard<std::mutex>;
+    /** General purpose guard */
+    using unique_guard = std::unique_lock<std::mutex>;
+
+    /** Checks if the queue is done (unsafe) */
+    bool is_done() const { return closed_ && size_ == 0; }
+
+    /** Gets the lane for an item, clamped to the lowest one */
+    size_t lane_of(const value_type& val) const {
+        auto n = laneFunc_ ? laneFunc_(val) : size_t(0);
+        return std::min(n, lanes_.size() - 1);
+    }
+
+    /** Adds an item to the queue (unsafe) */
+    void push(size_t lane, value_type&& val) {
+        lanes_[lane].emplace_back(std::move(val));
+        ++size_;
+        notEmptyCond_.notify_one();
+    }
+
+    /**
+     * Picks the lane for the next item to remove (unsafe).
+     * The queue must not be empty.
+     */
+    size_t next_lane() {
+        size_t top = 0, n = lanes_.size();
+        while (lanes_[top].empty()) ++top;
+
+        // Only lanes below the top one can be starved
+        if (size_ == lanes_[top].size()) {
+            streak_ = 0;
+            return top;
+        }
+
+        if (++streak_ <= burst_)
+            return top;
+
+        // Give the next waiting lower lane a turn
+        streak_ = 0;
+        if (nextLow_ <= top || nextLow_ >= n)
+            nextLow_ = top + 1;
+
+        while (lanes_[nextLow_].empty())
+            if (++nextLow_ >= n)
+                nextLow_ = top + 1;
+
+        size_t lane = nextLow_;
+        if (++nextLow_ >= n)
+            nextLow_ = top + 1;
+        return lane;
+    }
+
+    /**
+     * Removes the next item from the queue (unsafe).
+     * The queue must not be empty.
+     */
+    value_type pop() {
+        auto& que = lanes_[next_lane()];
+        value_type val = std::move(que.front());
+        que.pop_front();
+        --size_;
+        notFullCond_.notify_one();
+        return val;
+    }
+
+    /**
+     * Moves up to the specified number of items from the queue into the
+     * vector, in the order they would be retrieved individually (unsafe).
+     * @return The number of items moved.
+     */
+    size_type pop_bulk(std::vector<value_type>& vec, size_type maxItems) {
+        size_type n = std::min(maxItems, size_);
+        if (n == 0)
+            return 0;
+
+        vec.reserve(vec.size() + n);
+        for (size_type i = 0; i < n; ++i) vec.emplace_back(pop());
+        notFullCond_.notify_all();
+        return n;
+    }
+
+public:
+    /**
+     * Constructs a queue.
+     * @param nLanes The number of lanes. The minimum is 1.
+     * @param laneFunc The function to choose the lane for each item, where
+     *  			   zero is the highest priority. A value past the last
+     *  			   lane puts the item in the last lane.
+     * @param cap The maximum total number of items that can be placed in
+     *  		  the queue. The minimum capacity is 1.
+     * @param burst The number of items that can be taken in a row from the
+     *  			higher lanes before a waiting lower lane gets a turn. The
+     *  			minimum is 1.
+     */
+    multi_lane_queue(
+        size_t nLanes, lane_function laneFunc, size_type cap = MAX_CAPACITY,
+        size_t burst = DFLT_BURST
+    )
+        : lanes_(std::max<size_t>(nLanes, 1)),
+          laneFunc_(std::move(laneFunc)),
+          cap_(std::max<size_type>(cap, 1)),
+          burst_(std::max<size_t>(burst, 1)) {}
+    /**
+     * Gets the number of lanes in the queue.
+     * @return The number of lanes in the queue.
+     */
+    size_t num_lanes() const { return lanes_.size(); }
+    /**
+     * Determine if the queue is empty.
+     * @return @em true if there are no elements in the queue, @em false if
+     *  	   there are any items in the queue.
+     */
+    bool empty() const {
+        guard g{lock_};
+        return size_ == 0;
+    }
+    /**
+     * Gets the capacity of the queue.
+     * @return The maximum number of elements before the queue is full.
+     */
+    size_type capacity() const {
+        guard g{lock_};
+        return cap_;
+    }
+    /**
+     * Sets the capacity of the queue.
+     * As with the @ref thread_queue, this can be smaller than the current
+     * size of the queue, in which case puts will block until enough items
+     * are removed.
+     * @param cap The maximum number of elements in the queue.
+     */
+    void capacity(size_type cap) {
+        guard g{lock_};
+        cap_ = cap;
+        notFullCond_.notify_all();
+    }
+    /**
+     * Gets the number of items in the queue.
+     * @return The number of items in all the lanes of the queue.
+     */
+    size_type size() const {
+        guard g{lock_};
+        return size_;
+    }
+    /**
+     * Gets the number of items in one lane of the queue.
+     * @param lane The lane, where zero is the highest priority.
+     * @return The number of items in the lane, or zero if there is no such
+     *  	   lane.
+     */
+    size_type lane_size(size_t lane) const {
+        guard g{lock_};
+        return (lane < lanes_.size()) ? lanes_[lane].size() : size_type(0);
+    }
+    /**
+     * Close the queue.
+     * Once closed, the queue will not accept any new items, but receievers
+     * will still be able to get any remaining items out of the queue until
+     * it is empty.
+     */
+    void close() {
+        guard g{lock_};
+        closed_ = true;
+        notFullCond_.notify_all();
+        notEmptyCond_.notify_all();
+    }
+    /**
+     * Determines if the queue is closed.
+     * @return @em true if the queue is closed, @false otherwise.
+     */
+    bool closed() const {
+        guard g{lock_};
+        return closed_;
+    }
+    /**
+     * Determines if all possible operations are done on the queue.
+     * @return @true if the queue is closed and empty, @em false otherwise.
+     */
+    bool done() const {
+        guard g{lock_};
+        return is_done();
+    }
+    /**
+     * Clear the contents of the queue.
+     * This discards all items in all the lanes.
+     */
+    void clear() {
+        guard g{lock_};
+        for (auto& que : lanes_) que.clear();
+        size_ = 0;
+        streak_ = 0;
+        notFullCond_.notify_all();
+    }
+    /**
+     * Put an item into the queue.
+     * If the queue is full, this will block the caller until items are
+     * removed bringing the size less than the capacity.
+     * @param val The value to add to the queue.
+     * @throw queue_closed if the queue is closed.
+     */
+    void put(value_type val) {
+        auto lane = lane_of(val);
+        unique_guard g{lock_};
+        notFullCond_.wait(g, [this] { return size_ < cap_ || closed_; });
+        if (closed_)
+            throw queue_closed{};
+        push(lane, std::move(val));
+    }
+    /**
+     * Non-blocking attempt to place an item into the queue.
+     * @param val The value to add to the queue.
+     * @return @em true if the item was added to the queue, @em false if the
+     *  	   item was not added because the queue is currently full.
+     */
+    bool try_put(value_type val) {
+        auto lane = lane_of(val);
+        guard g{lock_};
+        if (size_ >= cap_ || closed_)
+            return false;
+        push(lane, std::move(val));
+        return true;
+    }
+    /**
+     * Attempt to place an item in the queue with a bounded wait.
+     * @param val The value to add to the queue.
+     * @param relTime The amount of time to wait until timing out.
+     * @return @em true if the value was added to the queue, @em false if a
+     *  	   timeout occurred.
+     */
+    template <typename Rep, class Period>
+    bool try_put_for(value_type val, const std::chrono::duration<Rep, Period>& relTime) {
+        auto lane = lane_of(val);
+        unique_guard g{lock_};
+        bool to = !notFullCond_.wait_for(g, relTime, [this] {
+            return size_ < cap_ || closed_;
+        });
+        if (to || closed_)
+            return false;
+        push(lane, std::move(val));
+        return true;
+    }
+    /**
+     * Attempt to place an item in the queue with a bounded wait to an
+     * absolute time point.
+     * @param val The value to add to the queue.
+     * @param absTime The absolute time to wait to before timing out.
+     * @return @em true if the value was added to the queue, @em false if a
+     *  	   timeout occurred.
+     */
+    template <class Clock, class Duration>
+    bool try_put_until(
+        value_type val, const std::chrono::time_point<Clock, Duration>& absTime
+    ) {
+        auto lane = lane_of(val);
+        unique_guard g{lock_};
+        bool to = !notFullCond_.wait_until(g, absTime, [this] {
+            return size_ < cap_ || closed_;
+        });
+        if (to || closed_)
+            return false;
+        push(lane, std::move(val));
+        return true;
+    }
+    /**
+     * Retrieve a value from the queue.
+     * If the queue is empty, this will block indefinitely until a value is
+     * added to the queue by another thread,
+     * @param val Pointer to a variable to receive the value.
+     * @return @em true if a value was retrieved, @em false if the queue is
+     *  	   closed and empty.
+     */
+    bool get(value_type* val) {
+        if (!val)
+            return false;
+
+        unique_guard g{lock_};
+        notEmptyCond_.wait(g, [this] { return size_ > 0 || closed_; });
+        if (size_ == 0)  // We must be done
+            return false;
+
+        *val = pop();
+        return true;
+    }
+    /**
+     * Retrieve a value from the queue.
+     * If the queue is empty, this will block indefinitely until a value is
+     * added to the queue by another thread,
+     * @return The value removed from the queue
+     * @throw queue_closed if the queue is closed and empty.
+     */
+    value_type get() {
+        unique_guard g{lock_};
+        notEmptyCond_.wait(g, [this] { return size_ > 0 || closed_; });
+        if (size_ == 0)  // We must be done
+            throw queue_closed{};
+
+        return pop();
+    }
+    /**
+     * Attempts to remove a value from the queue without blocking.
+     * @param val Pointer to a variable to receive the value.
+     * @return @em true if a value was removed from the queue, @em false if
+     *  	   the queue is empty.
+     */
+    bool try_get(value_type* val) {
+        if (!val)
+            return false;
+
+        guard g{lock_};
+        if (size_ == 0)
+            return false;
+
+        *val = pop();
+        return true;
+    }
+    /**
+     * Attempt to remove an item from the queue for a bounded amount of time.
+     * @param val Pointer to a variable to receive the value.
+     * @param relTime The amount of time to wait until timing out.
+     * @return @em true if the value was removed the queue, @em false if a
+     *  	   timeout occurred.
+     */
+    template <typename Rep, class Period>
+    bool try_get_for(value_type* val, const std::chrono::duration<Rep, Period>& relTime) {
+        if (!val)
+            return false;
+
+        unique_guard g{lock_};
+        notEmptyCond_.wait_for(g, relTime, [this] { return size_ > 0 || closed_; });
+        if (size_ == 0)
+            return false;
+
+        *val = pop();
+        return true;
+    }
+    /**
+     * Attempt to remove an item from the queue, waiting until a specific
+     * time if it is empty.
+     * @param val Pointer to a variable to receive the value.
+     * @param absTime The absolute time to wait to before timing out.
+     * @return @em true if the value was removed from the queue, @em false
+     *  	   if a timeout occurred.
+     */
+    template <class Clock, class Duration>
+    bool try_get_until(
+        value_type* val, const std::chrono::time_point<Clock, Duration>& absTime
+    ) {
+        if (!val)
+            return false;
+
+        unique_guard g{lock_};
+        notEmptyCond_.wait_until(g, absTime, [this] { return size_ > 0 || closed_; });
+        if (size_ == 0)
+            return false;
+
+        *val = pop();
+        return true;
+    }
+    /**
+     * Removes all the items currently in the queue without blocking.
+     * @return A vector of the items that were in the queue, in priority
+     *  	   order. It is empty if the queue was empty.
+     */
+    std::vector<value_type> get_all() {
+        std::vector<value_type> vec;
+        try_get_bulk(vec, MAX_CAPACITY);
+        return vec;
+    }
+    /**
+     * Attempts to remove a number of items from the queue without
+     * blocking.
+     * @param vec The vector to receive the items.
+     * @param maxItems The maximum number of items to remove.
+     * @return The number of items removed from the queue.
+     */
+    size_type try_get_bulk(std::vector<value_type>& vec, size_type maxItems) {
+        guard g{lock_};
+        return pop_bulk(vec, maxItems);
+    }
+    /**
+     * Attempts to remove a number of items from the queue, waiting for a
+     * bounded amount of time for one to arrive if the queue is empty.
+     * @param vec The vector to receive the items.
+     * @param maxItems The maximum number of items to remove.
+     * @param relTime The amount of time to wait until timing out.
+     * @return The number of items removed from the queue. This is zero if
+     *  	   a timeout occurred.
+     */
+    template <typename Rep, class Period>
+    size_type try_get_bulk_for(
+        std::vector<value_type>& vec, size_type maxItems,
+        const std::chrono::duration<Rep, Period>& relTime
+    ) {
+        unique_guard g{lock_};
+        notEmptyCond_.wait_for(g, relTime, [this] { return size_ > 0 || closed_; });
+        return pop_bulk(vec, maxItems);
+    }
+    /**
+     * Attempts to remove a number of items from the queue, waiting until a
+     * specific time for one to arrive if the queue is empty.
+     * @param vec The vector to receive the items.
+     * @param maxItems The maximum number of items to remove.
+     * @param absTime The absolute time to wait to before timing out.
+     * @return The number of items removed from the queue. This is zero if
+     *  	   a timeout occurred.
+     */
+    template <class Clock, class Duration>
+    size_type try_get_bulk_until(
+        std::vector<value_type>& vec, size_type maxItems,
+        const std::chrono::time_point<Clock, Duration>& absTime
+    ) {
+        unique_guard g{lock_};
+        notEmptyCond_.wait_until(g, absTime, [this] { return size_ > 0 || closed_; });
+        return pop_bulk(vec, maxItems);
+    }
+};
+
+/////////////////////////////////////////////////////////////////////////////
+}  // namespace mqtt
+
+#endif  // __mqtt_multi_lane_queue_h
@@ -0,0 +1,263 @@
+/////////////////////////////////////////////////////////////////////////////
+/// @file offline_buffer.h
+/// Declaration of MQTT offline_buffer class
+/// @author Frank Pagliughi
+/////////////////////////////////////////////////////////////////////////////
+
+/*******************************************************************************
+ * Copyright (c) 2025 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+
+#ifndef __mqtt_offline_buffer_h
+#define __mqtt_offline_buffer_h
+
+#include <cstddef>
+#include <deque>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "mqtt/delivery_token.h"
+#include "mqtt/message.h"
+#include "mqtt/types.h"
+
+namespace mqtt {
+
+/////////////////////////////////////////////////////////////////////////////
+
+/**
+ * A buffer for the messages published while a client is disconnected.
+ *
+ * The buffer in the C library, set with
+ * create_options::set_max_buffered_messages(), is limited by a count of
+ * messages, and holds them all in memory. This is limited by the number
+ * of bytes it holds in memory instead, counting the topics and payloads.
+ * Once that's full, any more messages are appended to a segment file on
+ * disk, if one was given, and are read back as the messages ahead of them
+ * are taken out. The messages always come out in the order they were put
+ * in.
+ * @par
+ * The segment file is only an overflow area. It is truncated when the
+ * buffer is created and each time it's emptied, so it isn't used to
+ * recover messages after a restart; that's left to the persistence of the
+ * client. Only the topic, payload, QoS, and retained flag of a message
+ * are written to the file, so any MQTT v5 properties of the messages
+ * that spill are lost.
+ * @par
+ * A message held in memory can keep its delivery token with it, so that
+ * the client can complete the token when the message is finally sent. A
+ * token can't be written to the file, so it's given back when the
+ * message spills.
+ * @par
+ * The buffer is given to a client with create_options::set_offline_buffer().
+ * When the client reconnects, the messages are sent from the buffer, in
+ * order, no faster than the drain rate, so that a backlog doesn't swamp
+ * the server. Until the buffer is empty, new messages are put in behind
+ * the backlog. The object is thread safe, but it should only be used by
+ * a single client.
+ */
+class offline_buffer
+{
+public:
+    /** Smart/shared pointer to an object of this class */
+    using ptr_t = std::shared_ptr<offline_buffer>;
+
+private:
+    /** The most bytes to hold in memory */
+    size_t maxBytes_;
+    /** The number of messages per second to send on reconnect (0=unlimited) */
+    double drainRate_;
+    /** The path to the segment file, if any */
+    string spillPath_;
+    /** A message held in memory, with its delivery token, if any */
+    struct entry
+    {
+        const_message_ptr msg;
+        delivery_token_ptr tok;
+    };
+
+    /** The messages held in memory, oldest first */
+    std::deque<entry> msgs_;
+    /** The number of bytes held in memory */
+    size_t nBytes_{0};
+    /** The segment file */
+    std::fstream file_;
+    /** The position of the next message to read from the file */
+    std::streamoff readPos_{0};
+    /** The position to write the next message to the file */
+    std::streamoff writePos_{0};
+    /** The number of messages in the file */
+    size_t nSpilled_{0};
+    /** Lock for the state */
+    mutable std::mutex lock_;
+
+    /** Gets the number of bytes a message takes from the budget */
+    static size_t size_of(const const_message_ptr& msg) {
+        return msg->get_topic_ref().size() + msg->get_payload_ref().size();
+    }
+    /** Writes a message to the end of the segment file */
+    void spill(const message& msg);
+    /** Reads the next message from the segment file */
+    const_message_ptr unspill();
+    /** Empties the segment file */
+    void truncate();
+
+public:
+    /**
+     * Creates a buffer that only holds messages in memory.
+     * @param maxBytes The most bytes of messages to hold in memory.
+     * @param drainRate The most messages to send per second when the client
+     *  				reconnects. Zero sends them as fast as possible.
+     */
+    explicit offline_buffer(size_t maxBytes, double drainRate = 0.0)
+        : maxBytes_{maxBytes}, drainRate_{drainRate} {}
+    /**
+     * Creates a buffer that spills to a file once the memory is full.
+     * @param maxBytes The most bytes of messages to hold in memory.
+     * @param spillPath The path to the segment file. It is created if it
+     *  				doesn't exist, and truncated if it does.
+     * @param drainRate The most messages to send per second when the client
+     *  				reconnects. Zero sends them as fast as possible.
+     * @throw persistence_exception if the file can't be opened.
+     */
+    offline_buffer(size_t maxBytes, const string& spillPath, double drainRate = 0.0);
+    /**
+     * Creates a buffer that only holds messages in memory.
+     * @param maxBytes The most bytes of messages to hold in memory.
+     * @param drainRate The most messages to send per second when the client
+     *  				reconnects. Zero sends them as fast as possible.
+     * @return A shared pointer to a new buffer.
+     */
+    static ptr_t create(size_t maxBytes, double drainRate = 0.0) {
+        return std::make_shared<offline_buffer>(maxBytes, drainRate);
+    }
+    /**
+     * Creates a buffer that spills to a file once the memory is full.
+     * @param maxBytes The most bytes of messages to hold in memory.
+     * @param spillPath The path to the segment file.
+     * @param drainRate The most messages to send per second when the client
+     *  				reconnects. Zero sends them as fast as possible.
+     * @return A shared pointer to a new buffer.
+     * @throw persistence_exception if the file can't be opened.
+     */
+    static ptr_t create(size_t maxBytes, const string& spillPath, double drainRate = 0.0) {
+        return std::make_shared<offline_buffer>(maxBytes, spillPath, drainRate);
+    }
+
+    offline_buffer(const offline_buffer&) = delete;
+    offline_buffer& operator=(const offline_buffer&) = delete;
+
+    /**
+     * Gets the most bytes of messages held in memory.
+     * @return The memory budget, in bytes.
+     */
+    size_t max_bytes() const { return maxBytes_; }
+    /**
+     * Gets the path to the segment file.
+     * @return The path to the segment file, or an empty string if the
+     *  	   buffer doesn't spill to disk.
+     */
+    const string& spill_path() const { return spillPath_; }
+    /**
+     * Gets the most messages to send per second when the client reconnects.
+     * @return The drain rate, or zero for no limit.
+     */
+    double drain_rate() const { return drainRate_; }
+    /**
+     * Adds a message to the back of the buffer.
+     * @param msg The message.
+     * @return @em true if the message was added, @em false if the memory
+     *  	   is full and there's no segment file.
+     * @throw persistence_exception if the message can't be written to the
+     *  	  segment file.
+     */
+    bool push(const_message_ptr msg);
+    /**
+     * Adds a message to the back of the buffer, with its delivery token.
+     * @param msg The message.
+     * @param tok The delivery token for the message. If the message is
+     *  		  held in memory, the token is moved into the buffer with
+     *  		  it, leaving this null. If the message spills to disk, or
+     *  		  isn't added, the token is left here.
+     * @return @em true if the message was added, @em false if the memory
+     *  	   is full and there's no segment file.
+     * @throw persistence_exception if the message can't be written to the
+     *  	  segment file.
+     */
+    bool push(const_message_ptr msg, delivery_token_ptr& tok);
+    /**
+     * Takes the message from the front of the buffer.
+     * Any token that was kept with the message is dropped.
+     * @return The oldest message, or null if the buffer is empty.
+     * @throw persistence_exception if the message can't be read back from
+     *  	  the segment file.
+     */
+    const_message_ptr try_pop() {
+        delivery_token_ptr tok;
+        return try_pop(tok);
+    }
+    /**
+     * Takes the message from the front of the buffer, with its delivery
+     * token.
+     * @param tok Gets the token that was kept with the message, or null if
+     *  		  there was none, such as for a message that spilled.
+     * @return The oldest message, or null if the buffer is empty.
+     * @throw persistence_exception if the message can't be read back from
+     *  	  the segment file.
+     */
+    const_message_ptr try_pop(delivery_token_ptr& tok);
+    /**
+     * Takes the delivery tokens out of the buffer, leaving the messages.
+     * The client does this when it goes away, to fail the tokens, since
+     * it won't be sending the messages.
+     * @return The tokens that were kept with the messages, oldest first.
+     */
+    std::vector<delivery_token_ptr> release_tokens();
+    /**
+     * Determines if the buffer is empty.
+     * @return @em true if the buffer holds no messages.
+     */
+    bool empty() const;
+    /**
+     * Gets the number of messages in the buffer.
+     * @return The number of messages in memory and on disk.
+     */
+    size_t size() const;
+    /**
+     * Gets the number of bytes of messages held in memory.
+     * @return The number of bytes of messages held in memory.
+     */
+    size_t bytes_in_memory() const;
+    /**
+     * Gets the number of messages in the segment file.
+     * @return The number of messages that spilled to disk.
+     */
+    size_t num_spilled() const;
+    /**
+     * Removes all the messages from the buffer.
+     * Any tokens kept with them are dropped without being completed.
+     */
+    void clear();
+};
+
+/** Smart/shared pointer to an offline buffer */
+using offline_buffer_ptr = offline_buffer::ptr_t;
+
+/////////////////////////////////////////////////////////////////////////////
+}  // namespace mqtt
+
+#endif  // __mqtt_offline_buffer_h
@@ -0,0 +1,96 @@
+/////////////////////////////////////////////////////////////////////////////
+/// @file payload_codec.h
+/// Declaration of MQTT payload_codec interface
+/// @author Frank Pagliughi
+/////////////////////////////////////////////////////////////////////////////
+
+/*******************************************************************************
+ * Copyright (c) 2025 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+#ifndef __mqtt_payload_codec_h
+#define __mqtt_payload_codec_h
+
+#include <memory>
+#include <string_view>
+
+#include "mqtt/types.h"
+
+namespace mqtt {
+
+/////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Interface for a codec that transforms message payloads, such as to
+ * compress them.
+ *
+ * When a codec is set in the client's @ref create_options, outgoing
+ * payloads over a size threshold are encoded before they are published,
+ * and tagged with a user property, named by `PROPERTY_NAME`, whose value
+ * is the name of the codec. Incoming messages carrying the same tag are
+ * decoded before they are handed to the application. Since the tag is a
+ * property, this is only done for MQTT v5 connections.
+ *
+ * The library doesn't supply any codecs. An application can wrap LZ4,
+ * zstd, zlib, or the like in an implementation of this interface.
+ * Payloads are encoded on the publishing threads and decoded on the
+ * client's callback thread, so an implementation must be thread-safe.
+ */
+class payload_codec
+{
+public:
+    /** Smart/shared pointer to an object of this class. */
+    using ptr_t = std::shared_ptr<payload_codec>;
+    /** Smart/shared pointer to a const object of this class. */
+    using const_ptr_t = std::shared_ptr<const payload_codec>;
+
+    /** The name of the user property used to tag encoded payloads */
+    static constexpr const char* PROPERTY_NAME = "content-encoding";
+
+    /**
+     * Virtual base destructor.
+     */
+    virtual ~payload_codec() {}
+    /**
+     * Gets the name of the codec, like "lz4" or "zstd".
+     * This is the value of the property that tags an encoded payload.
+     * @return The name of the codec.
+     */
+    virtual string name() const = 0;
+    /**
+     * Encodes an outgoing payload.
+     * @param data The original payload.
+     * @return The encoded payload.
+     */
+    virtual binary encode(std::string_view data) const = 0;
+    /**
+     * Decodes an incoming payload.
+     * @param data The encoded payload.
+     * @return The original payload.
+     * @throw std::exception if the payload can not be decoded.
+     */
+    virtual binary decode(std::string_view data) const = 0;
+};
+
+/** Smart/shared pointer to a payload codec */
+using payload_codec_ptr = payload_codec::ptr_t;
+
+/** Smart/shared pointer to a const payload codec */
+using const_payload_codec_ptr = payload_codec::const_ptr_t;
+
+/////////////////////////////////////////////////////////////////////////////
+}  // namespace mqtt
+
+#endif  // __mqtt_payload_codec_h
@@ -0,0 +1,101 @@
+/////////////////////////////////////////////////////////////////////////////
+/// @file pem_file.h
+/// Declaration of MQTT pem_file class
+/// @author Frank Pagliughi
+/////////////////////////////////////////////////////////////////////////////
+
+/*******************************************************************************
+ * Copyright (c) 2025 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+
+#ifndef __mqtt_pem_file_h
+#define __mqtt_pem_file_h
+
+#include <memory>
+
+#include "mqtt/types.h"
+
+namespace mqtt {
+
+/////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Certificates or a key, held in memory, for the SSL options.
+ *
+ * The Paho C library only loads the trust store, key store, and private
+ * key from files. This writes PEM data held in memory, such as data read
+ * from a secrets store or built into the application, to a private,
+ * temporary file, which is removed when the object is destroyed. The
+ * file is made readable only by the process' user, where the system
+ * supports it.
+ * @par
+ * The object is shared by pointer, so one copy of the data, and one
+ * file, can be used by any number of clients, rather than each having to
+ * read and write its own:
+ *
+ * @code
+ *     auto ca = mqtt::pem_file::create(caCerts);
+ *     auto sslOpts = mqtt::ssl_options_builder().trust_store(ca).finalize();
+ *     // ...use sslOpts for each of the clients
+ * @endcode
+ *
+ * The library still creates a TLS context from the file for each
+ * connection, as it does for any other file.
+ */
+class pem_file
+{
+    /** The path to the temporary file */
+    string path_;
+
+public:
+    /** Smart/shared pointer to an object of this class. */
+    using ptr_t = std::shared_ptr<const pem_file>;
+
+    /**
+     * Writes the PEM data to a temporary file.
+     * @param pem The PEM data, such as one or more certificates, or a key.
+     * @throw mqtt::exception if the file can't be created or written.
+     */
+    explicit pem_file(const string& pem);
+    /**
+     * Removes the temporary file.
+     */
+    ~pem_file();
+
+    pem_file(const pem_file&) = delete;
+    pem_file& operator=(const pem_file&) = delete;
+
+    /**
+     * Writes the PEM data to a temporary file.
+     * @param pem The PEM data, such as one or more certificates, or a key.
+     * @return A shared pointer to the new object.
+     * @throw mqtt::exception if the file can't be created or written.
+     */
+    static ptr_t create(const string& pem) { return std::make_shared<pem_file>(pem); }
+    /**
+     * Gets the path to the file.
+     * @return The path to the temporary file holding the PEM data.
+     */
+    const string& path() const { return path_; }
+};
+
+/** Smart/shared pointer to a PEM file */
+using pem_file_ptr = pem_file::ptr_t;
+
+/////////////////////////////////////////////////////////////////////////////
+}  // namespace mqtt
+
+#endif  // __mqtt_pem_file_h
@@ -1,29 +1,37 @@
-/////////////////////////////////////////////////////////////////////////////
-/// @file platform.h
-/// Paho MQTT platform-specific code
-/// @date Nov 19, 2023
-/// @author Frank Pagliughi
-/////////////////////////////////////////////////////////////////////////////
-
-/*******************************************************************************
- * Copyright (c) 2023 Frank Pagliughi <fpagliughi@mindspring.com>
- *
- * All rights reserved. This program and the accompanying materials
- * are made available under the terms of the Eclipse Public License v2.0
- * and Eclipse Distribution License v1.0 which accompany this distribution.
- *
- * The Eclipse Public License is available at
- *    http://www.eclipse.org/legal/epl-v20.html
- * and the Eclipse Distribution License is available at
- *   http://www.eclipse.org/org/documents/edl-v10.php.
- *
- * Contributors:
- *    Frank Pagliughi - initial implementation and documentation
- *******************************************************************************/
-
-#ifndef __mqtt_platform_h
-#define __mqtt_platform_h
-
-#include "mqtt/export.h"
-
-#endif  // __mqtt_platform_h
+/////////////////////////////////////////////////////////////////////////////
+/// @file platform.h
+/// Paho MQTT platform-specific code
+/// @date Nov 19, 2023
+/// @author Frank Pagliughi
+/////////////////////////////////////////////////////////////////////////////
+
+/*******************************************************************************
+ * Copyright (c) 2023 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+#ifndef __mqtt_platform_h
+#define __mqtt_platform_h
+
+#include "mqtt/export.h"
+
+// Support for C++20 coroutines, if the compiler has them enabled.
+#if !defined(PAHO_MQTTPP_COROUTINES) && defined(__cpp_impl_coroutine) && \
+    defined(__has_include)
+    #if __has_include(<coroutine>)
+        #define PAHO_MQTTPP_COROUTINES 1
+    #endif
+#endif
+
+#endif  // __mqtt_platform_h
@@ -28,13 +28,18 @@ extern "C" {
 #include "MQTTProperties.h"
 }
 
+#include <array>
+#include <atomic>
 #include <initializer_list>
 #include <iostream>
+#include <iterator>
 #include <map>
 #include <stdexcept>
 #include <string_view>
 #include <tuple>
 #include <typeinfo>
+#include <unordered_map>
+#include <utility>
 
 #include "mqtt/buffer_ref.h"
 #include "mqtt/exception.h"
@@ -46,6 +51,12 @@ namespace mqtt {
 /** A pair of strings as a tuple. */
 using string_pair = std::tuple<string, string>;
 
+/**
+ * A pair of string views, for a user property that is read in place from
+ * a property list.
+ */
+using string_view_pair = std::pair<std::string_view, std::string_view>;
+
 /////////////////////////////////////////////////////////////////////////////
 
 /**
@@ -294,8 +305,40 @@ class properties
     /** The default C struct */
     static constexpr MQTTProperties DFLT_C_STRUCT MQTTProperties_initializer;
 
+    /** The largest property code, which bounds the index */
+    static constexpr size_t MAX_CODE = size_t(MQTTPROPERTY_CODE_SHARED_SUBSCRIPTION_AVAILABLE);
+
+    /** An index of the positions of the properties in the list */
+    struct index
+    {
+        /** Position of the first property with each code, plus one; zero if none */
+        std::array<int, MAX_CODE + 1> first{};
+        /** The number of properties with each code */
+        std::array<int, MAX_CODE + 1> count{};
+        /** The position of the first user property with each name */
+        std::unordered_map<std::string_view, int> userProps;
+    };
+
     /** The underlying C properties struct */
     MQTTProperties props_{DFLT_C_STRUCT};
+    /** The index, built the first time the list is searched */
+    mutable std::atomic<index*> idx_{nullptr};
+
+    /**
+     * Gets the index of the list, building it if needed.
+     * This is thread-safe, so a const list can be searched from any number
+     * of threads.
+     */
+    const index& get_index() const;
+    /** Discards the index, when the list changes. */
+    void reset_index() noexcept { delete idx_.exchange(nullptr); }
+    /**
+     * Finds a property in the list.
+     * @param propid The property ID (code).
+     * @param idx Which instance of the property to find.
+     * @return A pointer to the property, or @em nullptr if not found.
+     */
+    const MQTTProperty* find(property::code propid, size_t idx = 0) const;
 
     template <typename T>
     friend T get(const properties& props, property::code propid, size_t idx);
@@ -351,6 +394,116 @@ public:
         }
     };
 
+    /**
+     * An iterator over the user properties in the list.
+     *
+     * This skips the other properties, and gives the name and value of
+     * each user property as string views into the storage of the list,
+     * without copying them. The views are valid until the list changes
+     * or is destroyed.
+     */
+    class user_property_iterator
+    {
+        const MQTTProperty* curr_;
+        const MQTTProperty* end_;
+
+        friend properties;
+        user_property_iterator(const MQTTProperty* curr, const MQTTProperty* end) noexcept
+            : curr_{curr}, end_{end} {
+            skip();
+        }
+        /** Moves ahead to the next user property, if not at one. */
+        void skip() noexcept {
+            while (curr_ != end_ && curr_->identifier != MQTTPROPERTY_CODE_USER_PROPERTY)
+                ++curr_;
+        }
+        /** Gets a view of one of the strings in a property. */
+        static std::string_view view(const MQTTLenString& str) noexcept {
+            return str.data ? std::string_view(str.data, size_t(str.len)) : std::string_view{};
+        }
+
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = string_view_pair;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const value_type*;
+        using reference = value_type;
+
+        /**
+         * Gets the name and value of the current user property.
+         * @return Views of the name and value of the property.
+         */
+        value_type operator*() const noexcept {
+            return value_type{view(curr_->value.data), view(curr_->value.value)};
+        }
+        /**
+         * Postfix increment operator.
+         * @return An iterator pointing to the previous user property.
+         */
+        user_property_iterator operator++(int) noexcept {
+            auto tmp = *this;
+            ++*this;
+            return tmp;
+        }
+        /**
+         * Prefix increment operator.
+         * @return An iterator pointing to the next user property.
+         */
+        user_property_iterator& operator++() noexcept {
+            ++curr_;
+            skip();
+            return *this;
+        }
+        /**
+         * Compares two iterators to see if they refer to the same property.
+         * @param other The other iterator to compare against this one.
+         * @return @em true if they match, @em false if they don't
+         */
+        bool operator==(const user_property_iterator& other) const noexcept {
+            return curr_ == other.curr_;
+        }
+        /**
+         * Compares two iterators to see if they don't refer to the same
+         * property.
+         * @param other The other iterator to compare against this one.
+         * @return @em true if they don't match, @em false if they do
+         */
+        bool operator!=(const user_property_iterator& other) const noexcept {
+            return curr_ != other.curr_;
+        }
+    };
+
+    /**
+     * The user properties in a list, as a range for iterating over them.
+     * @sa user_properties()
+     */
+    class user_property_range
+    {
+        user_property_iterator begin_;
+        user_property_iterator end_;
+
+        friend properties;
+        user_property_range(const MQTTProperty* first, const MQTTProperty* last) noexcept
+            : begin_{first, last}, end_{last, last} {}
+
+    public:
+        /**
+         * Gets an iterator to the first user property.
+         * @return An iterator to the first user property.
+         */
+        user_property_iterator begin() const noexcept { return begin_; }
+        /**
+         * Gets an iterator past the last user property.
+         * @return An iterator past the last user property.
+         */
+        user_property_iterator end() const noexcept { return end_; }
+        /**
+         * Determines if there are no user properties.
+         * @return @em true if the list has no user properties.
+         */
+        bool empty() const noexcept { return begin_ == end_; }
+    };
+
     /**
      * Default constructor.
      * Creates an empty properties list.
@@ -360,19 +513,35 @@ public:
      * Copy constructor.
      * @param other The property list to copy.
      */
-    properties(const properties& other) : props_(::MQTTProperties_copy(&other.props_)) {}
+    properties(const properties& other) {
+        if (other.props_.count > 0)
+            props_ = ::MQTTProperties_copy(&other.props_);
+    }
     /**
      * Move constructor.
      * @param other The property list to move to this one.
      */
-    properties(properties&& other) : props_(other.props_) {
+    properties(properties&& other)
+        : props_(other.props_), idx_(other.idx_.exchange(nullptr)) {
         std::memset(&other.props_, 0, sizeof(MQTTProperties));
     }
     /**
      * Creates a list of properties from a C struct.
      * @param cprops The c struct of properties
      */
-    properties(const MQTTProperties& cprops) { props_ = ::MQTTProperties_copy(&cprops); }
+    properties(const MQTTProperties& cprops) {
+        if (cprops.count > 0)
+            props_ = ::MQTTProperties_copy(&cprops);
+    }
+    /**
+     * Creates a list of properties by taking over the contents of a C
+     * struct, without copying them.
+     * The C struct is left empty, so that freeing it is a no-op.
+     * @param cprops The c struct of properties
+     */
+    explicit properties(MQTTProperties&& cprops) noexcept : props_(cprops) {
+        cprops = DFLT_C_STRUCT;
+    }
     /**
      * Constructs from a list of property objects.
      * @param props An initializer list of property objects.
@@ -381,7 +550,11 @@ public:
     /**
      * Destructor.
      */
-    ~properties() { ::MQTTProperties_free(&props_); }
+    ~properties() {
+        reset_index();
+        if (props_.array)
+            ::MQTTProperties_free(&props_);
+    }
     /**
      * Gets a reference to the underlying C properties structure.
      * @return A const reference to the underlying C properties structure.
@@ -446,25 +619,49 @@ public:
      * @return A const iterator to the end of collection of properties.
      */
     const_iterator cend() const { return end(); }
+    /**
+     * Gets the user properties in the list, to iterate over them without
+     * copying.
+     *
+     * @code
+     *     for (auto [name, value] : msg->get_properties().user_properties()) {
+     *         ...
+     *     }
+     * @endcode
+     *
+     * The names and values are views into the list, which are valid until
+     * it changes or is destroyed.
+     *
+     * @return A range over the user properties in the list.
+     */
+    user_property_range user_properties() const noexcept {
+        return user_property_range{props_.array, props_.array + size()};
+    }
     /**
      * Adds a property to the list.
      * @param prop The property to add to the list.
      */
-    void add(const property& prop) { ::MQTTProperties_add(&props_, &prop.c_struct()); }
+    void add(const property& prop) {
+        reset_index();
+        ::MQTTProperties_add(&props_, &prop.c_struct());
+    }
     /**
      * Removes all the items from the property list.
      */
-    void clear() { ::MQTTProperties_free(&props_); }
+    void clear() {
+        reset_index();
+        ::MQTTProperties_free(&props_);
+    }
     /**
      * Determines if the list contains a specific property.
+     *
+     * The first search of the list builds an index of it by property ID,
+     * so that this and the other lookups don't need to scan the list.
+     *
      * @param propid The property ID (code).
      * @return @em true if the list contains the property, @em false if not.
      */
-    bool contains(property::code propid) const {
-        return ::MQTTProperties_hasProperty(
-                   const_cast<MQTTProperties*>(&props_), MQTTPropertyCodes(propid)
-               ) != 0;
-    }
+    bool contains(property::code propid) const { return find(propid) != nullptr; }
     /**
      * Get the number of properties in the list with the specified property
      * ID.
@@ -475,13 +672,7 @@ public:
      * @param propid The property ID (code).
      * @return The number of properties in the list with the specified ID.
      */
-    size_t count(property::code propid) const {
-        return size_t(
-            ::MQTTProperties_propertyCount(
-                const_cast<MQTTProperties*>(&props_), MQTTPropertyCodes(propid)
-            )
-        );
-    }
+    size_t count(property::code propid) const;
     /**
      * Gets the property with the specified ID.
      *
@@ -491,6 +682,21 @@ public:
      * @return The requested property
      */
     property get(property::code propid, size_t idx = 0) const;
+    /**
+     * Determines if the list contains a user property with the specified
+     * name.
+     * @param name The name of the user property.
+     * @return @em true if the list contains a user property with that
+     *  	   name, @em false if not.
+     */
+    bool contains_user_property(std::string_view name) const;
+    /**
+     * Gets the value of the first user property with the specified name.
+     * @param name The name of the user property.
+     * @return The value of the user property.
+     * @throw bad_cast if there is no user property with that name.
+     */
+    string get_user_property(std::string_view name) const;
 };
 
 // --------------------------------------------------------------------------
@@ -506,9 +712,7 @@ public:
  */
 template <typename T>
 inline T get(const properties& props, property::code propid, size_t idx) {
-    MQTTProperty* prop = MQTTProperties_getPropertyAt(
-        const_cast<MQTTProperties*>(&props.c_struct()), MQTTPropertyCodes(propid), int(idx)
-    );
+    const MQTTProperty* prop = props.find(propid, idx);
     if (!prop)
         throw bad_cast();
 
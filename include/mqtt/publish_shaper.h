@@ -0,0 +1,252 @@
+/////////////////////////////////////////////////////////////////////////////
+/// @file publish_shaper.h
+/// Declaration of MQTT publish_shaper class
+/// @author Frank Pagliughi
+/////////////////////////////////////////////////////////////////////////////
+
+/*******************************************************************************
+ * Copyright (c) 2025 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+#ifndef __mqtt_publish_shaper_h
+#define __mqtt_publish_shaper_h
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+
+#include "mqtt/message.h"
+#include "mqtt/topic_matcher.h"
+
+namespace mqtt {
+
+/////////////////////////////////////////////////////////////////////////////
+
+/**
+ * What the shaper does with a message that is over the rate for its
+ * topic.
+ */
+enum class shape_policy {
+    /** The publisher waits until the message is within the rate */
+    DELAY,
+    /** Only the latest message for the topic is sent, once it's in the rate */
+    COALESCE,
+    /** The message is dropped */
+    DROP
+};
+
+/////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Limits the rate of the messages that a client publishes, by topic.
+ *
+ * The shaper has a set of rules, each a topic filter with a token bucket
+ * that allows a burst of messages, and then no more than a steady rate.
+ * All the topics that match a filter share its bucket. When a message is
+ * published, it's checked against the first rule, in the order they were
+ * added, with a filter that matches its topic. A message that doesn't
+ * match any rule isn't limited.
+ * @par
+ * A message that is over the rate is handled by the policy of the rule.
+ * With @ref shape_policy::DELAY, the publisher blocks until the message
+ * is within the rate, or the non-blocking publishes refuse it. With
+ * @ref shape_policy::COALESCE the client holds the message, and sends it
+ * once the rate allows, but a later message for the same topic replaces
+ * it in the meantime, so only the latest value goes out. This suits
+ * telemetry, but loses the replaced messages, whatever their QoS. With
+ * @ref shape_policy::DROP the message is dropped.
+ * @par
+ * This is done by the client before the messages are handed to the C
+ * library, so that a busy, low-priority topic can't fill the library's
+ * queue and connection ahead of more urgent ones. It's given to a client
+ * with create_options::set_publish_shaper(), and can be shared by a
+ * number of clients, such as those in a @ref client_pool, to limit them
+ * together. The object is thread safe.
+ */
+class publish_shaper
+{
+public:
+    /** Smart/shared pointer to an object of this class */
+    using ptr_t = std::shared_ptr<publish_shaper>;
+    /** The clock for the token buckets */
+    using clock = std::chrono::steady_clock;
+    /** The type for the delays */
+    using duration = clock::duration;
+
+    /**
+     * What the client should do with a message.
+     */
+    enum class action {
+        /** The message is within the rate, and can be sent now */
+        SEND,
+        /** The message can be sent after the delay */
+        WAIT,
+        /** The message is held, to be released after the delay */
+        HOLD,
+        /** The message replaced one held for the same topic */
+        COALESCED,
+        /** The message is dropped */
+        DROP
+    };
+
+    /**
+     * The result of checking a message against the rules.
+     */
+    struct decision
+    {
+        /** What to do with the message */
+        action act{action::SEND};
+        /** The time to wait, for @ref action::WAIT or @ref action::HOLD */
+        duration delay{0};
+    };
+
+private:
+    /** A rule for the topics matching a filter */
+    struct rule
+    {
+        /** The order the rule was added, to pick the first that matches */
+        size_t order;
+        /** What to do with the messages over the rate */
+        shape_policy policy;
+        /** The time between messages at the steady rate */
+        duration interval;
+        /** How far ahead of the steady rate a burst can get */
+        duration tolerance;
+        /**
+         * The time of the next message at the steady rate. The bucket is
+         * full when this is in the past, and empty when it is the
+         * tolerance ahead.
+         */
+        clock::time_point nextTime{};
+        /** The latest held message for each topic, when coalescing */
+        std::map<string, const_message_ptr> held;
+    };
+
+    /** Lock for the rules */
+    mutable std::mutex lock_;
+    /** The rules, by topic filter */
+    topic_matcher<std::shared_ptr<rule>> rules_;
+    /** The number of rules */
+    size_t nRules_{0};
+    /** The number of rules ever added, for their order */
+    size_t nAdded_{0};
+    /** The number of messages that had to wait */
+    std::atomic<uint64_t> nDelayed_{0};
+    /** The number of held messages replaced by later ones */
+    std::atomic<uint64_t> nCoalesced_{0};
+    /** The number of messages dropped */
+    std::atomic<uint64_t> nDropped_{0};
+
+    /** Gets the first rule that matches a topic, if any */
+    rule* find_rule(const string& topic) const;
+    /**
+     * Takes the next slot in a bucket.
+     * @return The time of the slot.
+     */
+    static clock::time_point reserve(rule& r, clock::time_point now);
+
+public:
+    /**
+     * Creates a shaper without any rules.
+     */
+    publish_shaper() {}
+    /**
+     * Creates a shaper without any rules.
+     * @return A shared pointer to the new shaper.
+     */
+    static ptr_t create() { return std::make_shared<publish_shaper>(); }
+
+    publish_shaper(const publish_shaper&) = delete;
+    publish_shaper& operator=(const publish_shaper&) = delete;
+
+    /**
+     * Adds a rule, or replaces the one for the same filter.
+     * A replaced rule keeps its place in the order, but starts with a full
+     * bucket.
+     * @param filter The topic filter, which may have wildcards.
+     * @param rate The number of messages allowed per second, over time.
+     * @param burst The most messages that can be sent at once.
+     * @param policy What to do with the messages over the rate.
+     * @throw std::invalid_argument if the rate is not positive.
+     */
+    void add_rule(
+        const string& filter, double rate, size_t burst = 1,
+        shape_policy policy = shape_policy::DELAY
+    );
+    /**
+     * Removes the rule for a filter.
+     * Any messages held by the rule are dropped.
+     * @param filter The topic filter of the rule.
+     * @return @em true if there was a rule for the filter.
+     */
+    bool remove_rule(const string& filter);
+    /**
+     * Gets the number of rules.
+     * @return The number of rules.
+     */
+    size_t size() const {
+        std::lock_guard<std::mutex> g{lock_};
+        return nRules_;
+    }
+    /**
+     * Determines if there are no rules.
+     * @return @em true if there are no rules.
+     */
+    bool empty() const { return size() == 0; }
+    /**
+     * Checks a message against the rules, taking a slot in the bucket
+     * for it if it's sent now, or later.
+     * @param msg The message.
+     * @param canWait Whether the publisher can wait for the message to
+     *  			  be within the rate. If not, a message that would
+     *  			  have to wait gets @ref action::WAIT without taking a
+     *  			  slot, and should be refused.
+     * @return What the client should do with the message.
+     */
+    decision admit(const const_message_ptr& msg, bool canWait = true);
+    /**
+     * Takes the message held for a topic, once its delay is up.
+     * @param topic The topic.
+     * @return The latest message held for the topic, or null if there is
+     *  	   none.
+     */
+    const_message_ptr release(const string& topic);
+    /**
+     * Gets the number of messages that had to wait to be sent.
+     * @return The number of messages that had to wait.
+     */
+    uint64_t num_delayed() const { return nDelayed_.load(std::memory_order_relaxed); }
+    /**
+     * Gets the number of held messages that were replaced by later ones.
+     * @return The number of messages that were coalesced.
+     */
+    uint64_t num_coalesced() const { return nCoalesced_.load(std::memory_order_relaxed); }
+    /**
+     * Gets the number of messages that were dropped.
+     * @return The number of messages that were dropped.
+     */
+    uint64_t num_dropped() const { return nDropped_.load(std::memory_order_relaxed); }
+};
+
+/** Smart/shared pointer to a publish shaper */
+using publish_shaper_ptr = publish_shaper::ptr_t;
+
+/////////////////////////////////////////////////////////////////////////////
+}  // namespace mqtt
+
+#endif  // __mqtt_publish_shaper_h
@@ -0,0 +1,157 @@
+/////////////////////////////////////////////////////////////////////////////
+/// @file publish_window.h
+/// Declaration of MQTT publish_window class
+/// @author Frank Pagliughi
+/////////////////////////////////////////////////////////////////////////////
+
+/*******************************************************************************
+ * Copyright (c) 2025 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+#ifndef __mqtt_publish_window_h
+#define __mqtt_publish_window_h
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+
+namespace mqtt {
+
+/////////////////////////////////////////////////////////////////////////////
+
+/**
+ * A window to limit the number of messages that a publisher can have
+ * pending at any time.
+ *
+ * The window can limit the number of messages and/or the number of bytes
+ * of the messages. A limit of zero means that it is not checked. A
+ * publisher acquires space in the window before sending a message, and it
+ * is released when the delivery of the message completes, so that a fast
+ * publisher is held back to the pace of the connection.
+ *
+ * A single message is always allowed into an empty window, even if it is
+ * larger than the byte limit, so that it can't block forever.
+ */
+class publish_window
+{
+    /** Lock guard type for this class */
+    using guard = std::lock_guard<std::mutex>;
+    /** Unique lock type for this class */
+    using unique_guard = std::unique_lock<std::mutex>;
+
+    /** Object lock */
+    mutable std::mutex lock_;
+    /** Condition to signal that there is room in the window */
+    std::condition_variable notFullCond_;
+    /** The maximum number of pending messages (0=no limit) */
+    size_t maxMsgs_;
+    /** The maximum number of pending bytes (0=no limit) */
+    size_t maxBytes_;
+    /** The number of messages pending */
+    size_t nMsgs_{0};
+    /** The number of bytes pending */
+    size_t nBytes_{0};
+
+    /** Determines if a message of the size fits in the window. */
+    bool has_room(size_t n) const {
+        return nMsgs_ == 0 || ((maxMsgs_ == 0 || nMsgs_ < maxMsgs_) &&
+                               (maxBytes_ == 0 || nBytes_ + n <= maxBytes_));
+    }
+    /** Adds a message of the size to the window */
+    void add(size_t n) {
+        ++nMsgs_;
+        nBytes_ += n;
+    }
+
+public:
+    /**
+     * Creates a window with the specified limits.
+     * @param maxMsgs The maximum number of pending messages. Zero for no
+     *  			  limit.
+     * @param maxBytes The maximum number of pending bytes. Zero for no
+     *  			   limit.
+     */
+    publish_window(size_t maxMsgs, size_t maxBytes = 0)
+        : maxMsgs_{maxMsgs}, maxBytes_{maxBytes} {}
+    /**
+     * Gets the maximum number of pending messages.
+     * @return The maximum number of pending messages, or zero if there is
+     *  	   no limit.
+     */
+    size_t max_messages() const { return maxMsgs_; }
+    /**
+     * Gets the maximum number of pending bytes.
+     * @return The maximum number of pending bytes, or zero if there is no
+     *  	   limit.
+     */
+    size_t max_bytes() const { return maxBytes_; }
+    /**
+     * Gets the number of messages currently pending.
+     * @return The number of messages currently pending.
+     */
+    size_t messages() const {
+        guard g{lock_};
+        return nMsgs_;
+    }
+    /**
+     * Gets the number of bytes currently pending.
+     * @return The number of bytes currently pending.
+     */
+    size_t bytes() const {
+        guard g{lock_};
+        return nBytes_;
+    }
+    /**
+     * Acquires room in the window for a message, blocking until there's
+     * room.
+     * @param n The size of the message, in bytes.
+     */
+    void acquire(size_t n);
+    /**
+     * Attempts to acquire room in the window for a message without
+     * blocking.
+     * @param n The size of the message, in bytes.
+     * @return @em true if the message was added to the window, @em false
+     *  	   if the window is full.
+     */
+    bool try_acquire(size_t n);
+    /**
+     * Attempts to acquire room in the window for a message, waiting a
+     * bounded amount of time for there to be room.
+     * @param n The size of the message, in bytes.
+     * @param relTime The amount of time to wait until timing out.
+     * @return @em true if the message was added to the window, @em false
+     *  	   if a timeout occurred.
+     */
+    template <typename Rep, class Period>
+    bool try_acquire_for(size_t n, const std::chrono::duration<Rep, Period>& relTime) {
+        unique_guard g{lock_};
+        if (!notFullCond_.wait_for(g, relTime, [this, n] { return has_room(n); }))
+            return false;
+        add(n);
+        return true;
+    }
+    /**
+     * Releases the room held by a message, when its delivery completes.
+     * @param n The size of the message, in bytes.
+     */
+    void release(size_t n);
+};
+
+/////////////////////////////////////////////////////////////////////////////
+}  // namespace mqtt
+
+#endif  // __mqtt_publish_window_h
@@ -0,0 +1,106 @@
+/////////////////////////////////////////////////////////////////////////////
+/// @file rcu_ptr.h
+/// Declaration of MQTT rcu_ptr class template
+/// @author Frank Pagliughi
+/////////////////////////////////////////////////////////////////////////////
+
+/*******************************************************************************
+ * Copyright (c) 2025 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+#ifndef __mqtt_rcu_ptr_h
+#define __mqtt_rcu_ptr_h
+
+#include <atomic>
+#include <memory>
+#include <utility>
+
+namespace mqtt {
+
+/////////////////////////////////////////////////////////////////////////////
+
+/**
+ * A shared pointer to an immutable value that can be read and replaced
+ * concurrently, in a read-copy-update style.
+ *
+ * Readers get a snapshot of the current value with load(), and can keep
+ * using it even if a writer replaces it in the meantime. The old value is
+ * destroyed when the last reader releases its snapshot. The readers never
+ * contend with each other on a lock.
+ *
+ * This is meant for values that are read often, but rarely updated, like
+ * the callbacks and handlers in the client.
+ *
+ * @tparam T The type of the value.
+ */
+template <typename T>
+class rcu_ptr
+{
+public:
+    /** The type of pointer to the value. */
+    using ptr_t = std::shared_ptr<const T>;
+
+private:
+#if __cplusplus >= 202002L && defined(__cpp_lib_atomic_shared_ptr)
+    /** The current value */
+    std::atomic<ptr_t> ptr_;
+
+    ptr_t do_load() const noexcept { return ptr_.load(std::memory_order_acquire); }
+    void do_store(ptr_t p) noexcept { ptr_.store(std::move(p), std::memory_order_release); }
+#else
+    /** The current value */
+    ptr_t ptr_;
+
+    ptr_t do_load() const noexcept { return std::atomic_load_explicit(&ptr_, std::memory_order_acquire); }
+    void do_store(ptr_t p) noexcept {
+        std::atomic_store_explicit(&ptr_, std::move(p), std::memory_order_release);
+    }
+#endif
+
+public:
+    /**
+     * Creates an empty pointer.
+     */
+    rcu_ptr() = default;
+
+    rcu_ptr(const rcu_ptr&) = delete;
+    rcu_ptr& operator=(const rcu_ptr&) = delete;
+
+    /**
+     * Gets a snapshot of the current value.
+     * @return A shared pointer to the current value. This is null if there
+     *  	   is no value.
+     */
+    ptr_t load() const noexcept { return do_load(); }
+    /**
+     * Replaces the value.
+     * @param p A pointer to the new value. This can be null to clear it.
+     */
+    void store(ptr_t p) noexcept { do_store(std::move(p)); }
+    /**
+     * Replaces the value with a copy of the one given.
+     * @param val The new value.
+     */
+    void store(T val) { do_store(std::make_shared<const T>(std::move(val))); }
+    /**
+     * Clears the value.
+     */
+    void reset() noexcept { do_store(ptr_t{}); }
+};
+
+/////////////////////////////////////////////////////////////////////////////
+}  // namespace mqtt
+
+#endif  // __mqtt_rcu_ptr_h
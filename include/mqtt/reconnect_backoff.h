@@ -0,0 +1,164 @@
+/////////////////////////////////////////////////////////////////////////////
+/// @file reconnect_backoff.h
+/// Declaration of MQTT reconnect_backoff class
+/// @author Frank Pagliughi
+/////////////////////////////////////////////////////////////////////////////
+
+/*******************************************************************************
+ * Copyright (c) 2025 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+#ifndef __mqtt_reconnect_backoff_h
+#define __mqtt_reconnect_backoff_h
+
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <random>
+
+#include "mqtt/export.h"
+#include "mqtt/types.h"
+
+namespace mqtt {
+
+/////////////////////////////////////////////////////////////////////////////
+
+/**
+ * A policy for the delays between automatic reconnect attempts.
+ *
+ * The backoff in the C library doubles the delay after each failure, so a
+ * large number of clients that lose their connections at the same time,
+ * like when a server restarts, all try again at the same times. This uses
+ * "decorrelated jitter", in which each delay is picked at random between
+ * the minimum and three times the previous delay, up to the maximum, so
+ * that the attempts from the clients spread out.
+ * @par
+ * The attempts can also be limited by a token bucket, which allows a burst
+ * of attempts, and then no more than a steady rate. A bucket that is
+ * shared by a number of clients in the process, like those in a
+ * @ref client_pool, limits the attempts made by all of them together.
+ * @par
+ * A server, or a proxy in front of it, can ask the clients to wait before
+ * reconnecting. If a server disconnects the client with an MQTT v5
+ * DISCONNECT that has a user property named by @ref HINT_PROPERTY, its
+ * value is taken as the least number of seconds to wait before the next
+ * attempt. The application can give a hint with hint() as well.
+ * @par
+ * The object is thread safe, and can be shared by any number of clients.
+ * It's given to a client with connect_options::set_reconnect_backoff().
+ */
+class reconnect_backoff
+{
+public:
+    /** The type for the delays */
+    using duration = std::chrono::milliseconds;
+    /** Smart/shared pointer to an object of this class */
+    using ptr_t = std::shared_ptr<reconnect_backoff>;
+
+    /** The name of the user property for a delay from the server */
+    PAHO_MQTTPP_EXPORT static const string HINT_PROPERTY;
+
+private:
+    /** The clock for the token bucket */
+    using clock = std::chrono::steady_clock;
+
+    /** The shortest delay */
+    duration minDelay_;
+    /** The longest delay */
+    duration maxDelay_;
+    /** The previous delay */
+    duration prevDelay_;
+    /** The least time to wait for the next attempt, from a hint */
+    duration hint_{0};
+    /** The time between attempts at the steady rate (0=unlimited) */
+    clock::duration interval_{0};
+    /** How far ahead of the steady rate a burst of attempts can get */
+    clock::duration tolerance_{0};
+    /**
+     * The time of the next attempt at the steady rate. The bucket is full
+     * when this is in the past, and empty when it is the tolerance ahead.
+     */
+    clock::time_point nextTime_;
+    /** The random number generator for the jitter */
+    std::mt19937_64 rng_;
+    /** Lock for the state */
+    mutable std::mutex lock_;
+
+public:
+    /**
+     * Creates a backoff policy.
+     * @param minDelay The shortest delay between attempts.
+     * @param maxDelay The longest delay between attempts.
+     * @throw std::invalid_argument if the minimum is not positive, or is
+     *  	  greater than the maximum.
+     */
+    reconnect_backoff(duration minDelay, duration maxDelay);
+    /**
+     * Creates a backoff policy.
+     * @param minDelay The shortest delay between attempts.
+     * @param maxDelay The longest delay between attempts.
+     * @return A shared pointer to a new backoff policy.
+     */
+    static ptr_t create(duration minDelay, duration maxDelay) {
+        return std::make_shared<reconnect_backoff>(minDelay, maxDelay);
+    }
+
+    reconnect_backoff(const reconnect_backoff&) = delete;
+    reconnect_backoff& operator=(const reconnect_backoff&) = delete;
+
+    /**
+     * Gets the shortest delay between attempts.
+     * @return The shortest delay between attempts.
+     */
+    duration min_delay() const { return minDelay_; }
+    /**
+     * Gets the longest delay between attempts.
+     * @return The longest delay between attempts.
+     */
+    duration max_delay() const { return maxDelay_; }
+    /**
+     * Limits the attempts with a token bucket.
+     * @param rate The number of attempts allowed per second, over time.
+     *  		   Zero removes the limit.
+     * @param burst The most attempts that can be made at once.
+     */
+    void set_rate_limit(double rate, size_t burst = 1);
+    /**
+     * Gives the least time to wait before the next attempt.
+     * This is cleared once it's used.
+     * @param delay The least time to wait before the next attempt.
+     */
+    void hint(duration delay);
+    /**
+     * Gets the delay before the next attempt.
+     * This is the jittered delay, or the hint if it's longer, pushed back
+     * as needed to stay within the rate limit.
+     * @return The time to wait before the next attempt.
+     */
+    duration next_delay();
+    /**
+     * Starts over from the minimum delay, after a successful connection.
+     */
+    void reset();
+};
+
+/** Smart/shared pointer to a reconnect backoff policy */
+using reconnect_backoff_ptr = reconnect_backoff::ptr_t;
+
+/////////////////////////////////////////////////////////////////////////////
+}  // namespace mqtt
+
+#endif  // __mqtt_reconnect_backoff_h
@@ -0,0 +1,128 @@
+/////////////////////////////////////////////////////////////////////////////
+/// @file retained_cache.h
+/// Declaration of MQTT retained_cache class
+/// @author Frank Pagliughi
+/////////////////////////////////////////////////////////////////////////////
+
+/*******************************************************************************
+ * Copyright (c) 2025 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+
+#ifndef __mqtt_retained_cache_h
+#define __mqtt_retained_cache_h
+
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <vector>
+
+#include "mqtt/message.h"
+#include "mqtt/topic_matcher.h"
+
+namespace mqtt {
+
+/////////////////////////////////////////////////////////////////////////////
+
+/**
+ * A local copy of the retained messages seen by a client.
+ *
+ * When given to a client in the create options, the client keeps the cache
+ * up to date with each retained message that it receives: a message with
+ * a payload replaces the one for its topic, and an empty one removes it,
+ * as on the server. The current state of a set of topics can then be
+ * looked up locally with a filter, without subscribing again and waiting
+ * for the server to send the retained messages.
+ * @par
+ * The server only sets the retained flag on the messages that it sends
+ * when a subscription is made, unless the subscription asks for it to be
+ * kept as published. To have the cache follow the live updates, subscribe
+ * with the MQTT v5 "retain as published" option.
+ * @par
+ * The messages are held in a @ref topic_matcher, keyed by topic, so a
+ * lookup only visits the part of the tree that the filter selects. The
+ * cache can be shared by a number of clients, and is safe to use from
+ * any thread.
+ */
+class retained_cache
+{
+    /** Lock for the collection */
+    mutable std::mutex lock_;
+    /** The retained messages, by topic */
+    topic_matcher<const_message_ptr> msgs_;
+    /** The number of messages in the cache */
+    size_t n_{0};
+    /** The number of removals since the empty nodes were pruned */
+    size_t nRemoved_{0};
+
+public:
+    /** Smart/shared pointer to an object of this class. */
+    using ptr_t = std::shared_ptr<retained_cache>;
+
+    /**
+     * Creates an empty cache.
+     */
+    retained_cache() {}
+    /**
+     * Creates an empty cache.
+     * @return A shared pointer to the new cache.
+     */
+    static ptr_t create() { return std::make_shared<retained_cache>(); }
+    /**
+     * Updates the cache with a retained message.
+     * A message with a payload is stored for its topic, replacing any
+     * earlier one. A message with an empty payload clears the topic.
+     * @param msg The retained message.
+     */
+    void update(const_message_ptr msg);
+    /**
+     * Gets the retained message for a topic.
+     * @param topic The topic.
+     * @return The retained message for the topic, or null if there is none.
+     */
+    const_message_ptr get(const string& topic) const;
+    /**
+     * Gets the retained messages for all the topics a filter matches.
+     * @param filter The topic filter, which may have wildcards.
+     * @return The retained messages that match the filter, in no
+     *  	   particular order.
+     */
+    std::vector<const_message_ptr> get_retained(std::string_view filter) const;
+    /**
+     * Gets the number of messages in the cache.
+     * @return The number of messages in the cache.
+     */
+    size_t size() const {
+        std::lock_guard<std::mutex> g{lock_};
+        return n_;
+    }
+    /**
+     * Determines if the cache is empty.
+     * @return @em true if there are no messages in the cache.
+     */
+    bool empty() const { return size() == 0; }
+    /**
+     * Removes all the messages from the cache.
+     */
+    void clear();
+};
+
+/** Smart/shared pointer to a retained message cache */
+using retained_cache_ptr = retained_cache::ptr_t;
+
+/////////////////////////////////////////////////////////////////////////////
+}  // namespace mqtt
+
+#endif  // __mqtt_retained_cache_h
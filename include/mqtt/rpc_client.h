@@ -0,0 +1,233 @@
+/////////////////////////////////////////////////////////////////////////////
+/// @file rpc_client.h
+/// Declaration of MQTT rpc_client class
+/// @author Frank Pagliughi
+/////////////////////////////////////////////////////////////////////////////
+
+/*******************************************************************************
+ * Copyright (c) 2025 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+
+#ifndef __mqtt_rpc_client_h
+#define __mqtt_rpc_client_h
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "mqtt/async_client.h"
+
+namespace mqtt {
+
+/////////////////////////////////////////////////////////////////////////////
+
+/**
+ * A client for request/response calls over MQTT v5.
+ *
+ * Each call publishes a request with the RESPONSE_TOPIC property set to a
+ * reply topic for this client, and a unique CORRELATION_DATA value, which
+ * the service copies into its response. All the responses come back over
+ * a single subscription to the reply topic, and are matched to the calls
+ * by the correlation data. A call returns a future that gets the response
+ * message, or a @ref timeout_error if none arrives in time.
+ * @par
+ * So that a large number of calls can be outstanding at once, the table
+ * of pending calls is split into a number of stripes, each with its own
+ * lock, and the timeouts are kept in a timer wheel in each stripe, which
+ * is turned by a single thread. Adding a call or a timeout is a constant
+ * time operation, and the timeouts are accurate to within a tick of the
+ * wheel.
+ * @par
+ * The reply topic should be unique to this client, such as one made with
+ * the client ID, like "replies/<client-id>". The rpc_client installs a
+ * message handler for it in the async_client, and subscribe() subscribes
+ * to it, after the client is connected.
+ *
+ * @code
+ *     mqtt::rpc_client rpc{cli, "replies/" + clientId};
+ *     rpc.subscribe()->wait();
+ *     auto fut = rpc.call("requests/math/add", "[ 1, 2 ]", 5s);
+ *     auto rsp = fut.get();
+ * @endcode
+ */
+class rpc_client
+{
+public:
+    /** The clock for the timeouts */
+    using clock = std::chrono::steady_clock;
+    /** The future for the response to a call */
+    using future_type = std::future<const_message_ptr>;
+
+    /** The default number of stripes in the table of pending calls */
+    static constexpr size_t DFLT_STRIPES = 64;
+    /** The number of slots in the timer wheel */
+    static constexpr size_t WHEEL_SLOTS = 256;
+    /** The default time for each tick of the timer wheel */
+    static constexpr std::chrono::milliseconds DFLT_TICK{10};
+
+private:
+    /** A call that is waiting for a response */
+    struct pending
+    {
+        std::promise<const_message_ptr> prom;
+        clock::time_point deadline;
+    };
+
+    /** A part of the table of pending calls, with its own lock */
+    struct stripe
+    {
+        std::mutex lock;
+        std::unordered_map<uint64_t, pending> calls;
+        /** The IDs of the calls, by the slot of the wheel for their timeout */
+        std::vector<std::vector<uint64_t>> wheel;
+    };
+
+    /** The state shared with the message handler */
+    struct table
+    {
+        std::unique_ptr<stripe[]> stripes;
+        size_t nStripes;
+        /** The current slot of the timer wheel */
+        std::atomic<size_t> cursor{0};
+        /** The number of calls waiting for a response */
+        std::atomic<size_t> nPending{0};
+        /** The number of calls that timed out */
+        std::atomic<uint64_t> nTimeouts{0};
+
+        explicit table(size_t n);
+        stripe& stripe_for(uint64_t id) { return stripes[id % nStripes]; }
+        /** Completes a call with its response */
+        void complete(uint64_t id, const_message_ptr msg);
+        /** Times out the calls in the current slot of the wheel */
+        void expire(clock::time_point now, clock::duration tick);
+        /** Fails all the pending calls */
+        void fail_all(const exception& exc);
+    };
+
+    /** The client for the calls */
+    async_client& cli_;
+    /** The topic for the responses */
+    string replyTopic_;
+    /** The QoS for the requests and the reply subscription */
+    int qos_;
+    /** The time for each tick of the timer wheel */
+    clock::duration tick_;
+    /** The next correlation ID */
+    std::atomic<uint64_t> nextId_{1};
+    /** The pending calls */
+    std::shared_ptr<table> tbl_;
+    /** Lock for the timer thread */
+    std::mutex timerLock_;
+    /** Signaled to stop the timer thread */
+    std::condition_variable timerCond_;
+    /** Whether the timer thread should exit */
+    bool stop_{false};
+    /** The thread that turns the timer wheel */
+    std::thread timerThread_;
+
+    /** The timer thread function */
+    void timer_loop();
+    /** Called when a message arrives on the reply topic */
+    static void on_reply(const std::weak_ptr<table>& wtbl, const_message_ptr msg);
+
+public:
+    /**
+     * Creates an RPC client.
+     * @param cli The client used to send the requests and receive the
+     *  		  responses. It must outlive the rpc_client.
+     * @param replyTopic The topic for the responses, which should be unique
+     *  				 to this client.
+     * @param qos The QoS for the requests and the reply subscription.
+     * @param nStripes The number of stripes in the table of pending calls.
+     * @param tick The time for each tick of the timer wheel.
+     */
+    rpc_client(
+        async_client& cli, const string& replyTopic, int qos = 1,
+        size_t nStripes = DFLT_STRIPES, clock::duration tick = DFLT_TICK
+    );
+    /**
+     * Destructor.
+     * This removes the handler for the reply topic and fails any calls
+     * that are still pending.
+     */
+    ~rpc_client();
+
+    rpc_client(const rpc_client&) = delete;
+    rpc_client& operator=(const rpc_client&) = delete;
+
+    /**
+     * Gets the topic for the responses.
+     * @return The reply topic.
+     */
+    const string& get_reply_topic() const { return replyTopic_; }
+    /**
+     * Subscribes to the reply topic.
+     * This should be done each time that the client connects with a clean
+     * session.
+     * @return A token to track the subscription.
+     */
+    token_ptr subscribe() { return cli_.subscribe(replyTopic_, qos_); }
+    /**
+     * Makes a call.
+     * The RESPONSE_TOPIC and CORRELATION_DATA properties are added to the
+     * request. If the publish can't be started, the exception is thrown
+     * and there is no call.
+     * @param req The request message.
+     * @param timeout How long to wait for the response.
+     * @return A future for the response message. It fails with a
+     *  	   @ref timeout_error if no response arrives in time.
+     */
+    future_type call(message_ptr req, clock::duration timeout);
+    /**
+     * Makes a call.
+     * @param topic The topic for the request.
+     * @param payload The payload for the request.
+     * @param timeout How long to wait for the response.
+     * @return A future for the response message. It fails with a
+     *  	   @ref timeout_error if no response arrives in time.
+     */
+    future_type call(string_ref topic, binary_ref payload, clock::duration timeout) {
+        return call(make_message(std::move(topic), std::move(payload), qos_, false), timeout);
+    }
+    /**
+     * Gets the number of calls waiting for a response.
+     * @return The number of calls waiting for a response.
+     */
+    size_t pending_calls() const { return tbl_->nPending.load(std::memory_order_relaxed); }
+    /**
+     * Gets the number of calls that timed out.
+     * @return The number of calls that timed out.
+     */
+    uint64_t timeouts() const { return tbl_->nTimeouts.load(std::memory_order_relaxed); }
+/**
+ * Feeds a response to the client, as if it arrived, for the unit tests.
+ */
+#if defined(UNIT_TESTS)
+    void deliver(const_message_ptr msg) { on_reply(tbl_, std::move(msg)); }
+#endif
+};
+
+/////////////////////////////////////////////////////////////////////////////
+}  // namespace mqtt
+
+#endif  // __mqtt_rpc_client_h
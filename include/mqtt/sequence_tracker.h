@@ -0,0 +1,178 @@
+/////////////////////////////////////////////////////////////////////////////
+/// @file sequence_tracker.h
+/// Declaration of MQTT sequence_tracker class
+/// @author Frank Pagliughi
+/////////////////////////////////////////////////////////////////////////////
+
+/*******************************************************************************
+ * Copyright (c) 2025 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+
+#ifndef __mqtt_sequence_tracker_h
+#define __mqtt_sequence_tracker_h
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+
+#include "mqtt/message.h"
+
+namespace mqtt {
+
+/////////////////////////////////////////////////////////////////////////////
+
+/**
+ * The counts from a @ref sequence_tracker.
+ */
+struct sequence_stats
+{
+    /** The number of messages that had a sequence number */
+    uint64_t msgsTracked{0};
+    /** The number of sequence numbers that were skipped over */
+    uint64_t gaps{0};
+    /** The number of messages that repeated the last sequence number */
+    uint64_t duplicates{0};
+    /** The number of messages that arrived after a later one */
+    uint64_t outOfOrder{0};
+    /** The number of topics being tracked */
+    size_t topics{0};
+};
+
+/////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Tracks the sequence numbers of incoming messages, per topic, to detect
+ * lost, repeated, and reordered messages.
+ *
+ * The publisher puts an increasing sequence number for each topic into an
+ * MQTT v5 user property of each message. When the tracker is given to a
+ * client in the create options, the client checks each message that it
+ * receives, and the counts are reported in the client's statistics, so
+ * that message loss can be monitored all the time, without any work in
+ * the consumer.
+ * @par
+ * For each topic, the tracker keeps the highest sequence number seen.
+ * A message with the next number is in order. A higher number counts the
+ * numbers between as gaps, the same number is a duplicate, and a lower
+ * one arrived out of order, which might be a message that was counted in
+ * a gap before. Messages without the property, or with a value that isn't
+ * a number, are ignored.
+ * @par
+ * The tracker keeps one entry for each topic that it has seen, and can
+ * be shared by a number of clients. It is safe to use from any thread.
+ */
+class sequence_tracker
+{
+    /** The name of the user property with the sequence number */
+    string propName_;
+    /** Lock for the state */
+    mutable std::mutex lock_;
+    /** The highest sequence number seen for each topic */
+    std::unordered_map<string, uint64_t> last_;
+    /** The counts */
+    sequence_stats stats_;
+
+public:
+    /** Smart/shared pointer to an object of this class. */
+    using ptr_t = std::shared_ptr<sequence_tracker>;
+
+    /** The result of checking a message */
+    enum class result {
+        /** The message had no sequence number */
+        UNTRACKED,
+        /** The first message seen on the topic */
+        FIRST,
+        /** The message had the next sequence number */
+        IN_ORDER,
+        /** Some sequence numbers were skipped before the message */
+        GAP,
+        /** The message repeated the last sequence number */
+        DUPLICATE,
+        /** The message arrived after one with a higher number */
+        OUT_OF_ORDER
+    };
+
+    /** The default name of the user property with the sequence number */
+    static constexpr const char* DFLT_PROPERTY_NAME = "seq";
+
+    /**
+     * Creates a tracker.
+     * @param propName The name of the user property that has the sequence
+     *  			   number, as a decimal string.
+     */
+    explicit sequence_tracker(const string& propName = DFLT_PROPERTY_NAME)
+        : propName_{propName} {}
+    /**
+     * Creates a tracker.
+     * @param propName The name of the user property that has the sequence
+     *  			   number, as a decimal string.
+     * @return A shared pointer to the new tracker.
+     */
+    static ptr_t create(const string& propName = DFLT_PROPERTY_NAME) {
+        return std::make_shared<sequence_tracker>(propName);
+    }
+    /**
+     * Gets the name of the user property that has the sequence number.
+     * @return The name of the user property.
+     */
+    const string& get_property_name() const { return propName_; }
+    /**
+     * Gets the sequence number of a message.
+     * @param msg The message.
+     * @return The sequence number, if the message has one.
+     */
+    std::optional<uint64_t> sequence_of(const message& msg) const;
+    /**
+     * Checks the sequence number of a message against the last one for
+     * its topic, and updates the counts.
+     * @param msg The message.
+     * @return How the message fits into the sequence for its topic.
+     */
+    result check(const message& msg);
+    /**
+     * Checks a sequence number against the last one for a topic, and
+     * updates the counts.
+     * @param topic The topic.
+     * @param seq The sequence number.
+     * @return How the number fits into the sequence for the topic.
+     */
+    result check(const string& topic, uint64_t seq);
+    /**
+     * Gets the highest sequence number seen for a topic.
+     * @param topic The topic.
+     * @return The highest sequence number, if any were seen for the topic.
+     */
+    std::optional<uint64_t> last_sequence(const string& topic) const;
+    /**
+     * Gets a snapshot of the counts.
+     * @return The counts for all the topics.
+     */
+    sequence_stats get_stats() const;
+    /**
+     * Forgets all the topics and resets the counts.
+     */
+    void clear();
+};
+
+/** Smart/shared pointer to a sequence tracker */
+using sequence_tracker_ptr = sequence_tracker::ptr_t;
+
+/////////////////////////////////////////////////////////////////////////////
+}  // namespace mqtt
+
+#endif  // __mqtt_sequence_tracker_h
@@ -0,0 +1,143 @@
+/////////////////////////////////////////////////////////////////////////////
+/// @file spin_wait.h
+/// Declaration of MQTT spin_wait class
+/// @author Frank Pagliughi
+/////////////////////////////////////////////////////////////////////////////
+
+/*******************************************************************************
+ * Copyright (c) 2025 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+
+#ifndef __mqtt_spin_wait_h
+#define __mqtt_spin_wait_h
+
+#include <thread>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    #include <intrin.h>
+#endif
+
+namespace mqtt {
+
+/////////////////////////////////////////////////////////////////////////////
+
+/**
+ * A policy for how long a thread busy-waits for something before it
+ * blocks.
+ *
+ * Blocking on a condition variable puts the thread to sleep in the kernel,
+ * and waking it again takes several microseconds, even when the thing
+ * being waited for arrives right away. For a thread on a dedicated core
+ * that waits on a queue or a token in a tight request/response loop, some
+ * spinning first cuts that out of the latency, at the cost of the CPU time
+ * spent spinning.
+ * @par
+ * The wait first checks the condition the number of "spin" times, with a
+ * CPU pause instruction between them, then the number of "yield" times,
+ * giving up the CPU to other threads between them, and only then blocks.
+ * The default policy does neither, and blocks right away.
+ */
+class spin_wait
+{
+    /** The number of times to spin, checking the condition */
+    unsigned nSpins_{0};
+    /** The number of times to yield, checking the condition */
+    unsigned nYields_{0};
+
+public:
+    /**
+     * Creates a policy that blocks right away.
+     */
+    spin_wait() {}
+    /**
+     * Creates a spin-then-block policy.
+     * @param nSpins The number of times to check the condition, pausing
+     *  			 the CPU between them.
+     * @param nYields The number of times to check the condition after
+     *  			  that, yielding the CPU between them.
+     */
+    explicit spin_wait(unsigned nSpins, unsigned nYields = 0)
+        : nSpins_{nSpins}, nYields_{nYields} {}
+    /**
+     * Gets the number of times to spin.
+     * @return The number of times to spin.
+     */
+    unsigned spins() const { return nSpins_; }
+    /**
+     * Gets the number of times to yield.
+     * @return The number of times to yield.
+     */
+    unsigned yields() const { return nYields_; }
+    /**
+     * Determines if the policy does any waiting before blocking.
+     * @return @em true if it spins or yields before blocking.
+     */
+    bool enabled() const { return nSpins_ != 0 || nYields_ != 0; }
+    /**
+     * Tells the CPU that the thread is in a spin loop.
+     * This lowers the power and lets any other hardware thread on the core
+     * run, where the CPU supports it.
+     */
+    static void cpu_relax() noexcept {
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+        _mm_pause();
+#elif defined(__x86_64__) || defined(__i386__)
+        __builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+        asm volatile("yield");
+#endif
+    }
+    /**
+     * Spins and yields until a condition is met or the policy is used up.
+     * @param pred The condition. This is called a number of times, and
+     *  		   must not block.
+     * @return @em true if the condition was met, @em false if the caller
+     *  	   should block.
+     */
+    template <typename Pred>
+    bool operator()(Pred pred) const {
+        for (unsigned i = 0; i < nSpins_; ++i) {
+            if (pred())
+                return true;
+            cpu_relax();
+        }
+        for (unsigned i = 0; i < nYields_; ++i) {
+            if (pred())
+                return true;
+            std::this_thread::yield();
+        }
+        return pred();
+    }
+    /**
+     * Compares two policies.
+     * @param rhs The other policy.
+     * @return @em true if they are the same.
+     */
+    bool operator==(const spin_wait& rhs) const {
+        return nSpins_ == rhs.nSpins_ && nYields_ == rhs.nYields_;
+    }
+    /**
+     * Compares two policies.
+     * @param rhs The other policy.
+     * @return @em true if they differ.
+     */
+    bool operator!=(const spin_wait& rhs) const { return !(*this == rhs); }
+};
+
+/////////////////////////////////////////////////////////////////////////////
+}  // namespace mqtt
+
+#endif  // __mqtt_spin_wait_h
@@ -32,6 +32,7 @@
 
 #include "MQTTAsync.h"
 #include "mqtt/message.h"
+#include "mqtt/pem_file.h"
 #include "mqtt/platform.h"
 #include "mqtt/topic.h"
 #include "mqtt/types.h"
@@ -42,6 +43,21 @@ namespace mqtt {
 
 /**
  * Holds the set of SSL options for connection.
+ *
+ * The TLS connection is made and owned by the Paho C library, which sets
+ * up a new TLS context from these options and does a full handshake each
+ * time the client connects or reconnects. The C library does not expose
+ * the TLS session, so sessions or tickets can't be cached and resumed
+ * from here. Where the cost of the handshake matters, such as on links
+ * with a long round trip, it can be cut down by:
+ *   @li Letting the server and library negotiate TLS 1.3, by leaving the
+ *  	 SSL version at the default, which takes one round trip less than
+ *  	 TLS 1.2.
+ *   @li Using a pre-shared key, with set_psk_handler(), which skips the
+ *  	 exchange and verification of the certificates.
+ *   @li Keeping the connection up, with a keep-alive interval well
+ *  	 inside the timeouts of any NAT or firewall between the client and
+ *  	 the server, so that it is not reconnected as often.
  */
 class ssl_options
 {
@@ -87,6 +103,9 @@ private:
     /** The password to load the client's privateKey if encrypted. */
     string privateKeyPassword_;
 
+    /** The in-memory trust store, key store, and private key, if any */
+    pem_file_ptr trustStorePem_, keyStorePem_, privateKeyPem_;
+
     /** Path to a directory containing CA certificates in PEM format */
     string caPath_;
 
@@ -262,6 +281,25 @@ public:
      *  				 key.
      */
     void set_private_key(const string& privateKey);
+    /**
+     * Sets the public digital certificates trusted by the client, from
+     * memory.
+     * The options hold a reference to the file, which can be shared with
+     * any number of other options.
+     * @param trustStore The PEM data for the certificates.
+     */
+    void set_trust_store(pem_file_ptr trustStore);
+    /**
+     * Sets the public certificate chain of the client, from memory.
+     * @param keyStore The PEM data for the certificate chain. It may also
+     *  			   include the client's private key.
+     */
+    void set_key_store(pem_file_ptr keyStore);
+    /**
+     * Sets the client's private key, from memory.
+     * @param privateKey The PEM data for the private key.
+     */
+    void set_private_key(pem_file_ptr privateKey);
     /**
      * Sets the password to load the client's privateKey if encrypted.
      * @param privateKeyPassword The password to load the privateKey if
@@ -417,6 +455,31 @@ public:
         opts_.set_private_key(key);
         return *this;
     }
+    /**
+     * Sets the public digital certificates trusted by the client, from
+     * memory.
+     * @param store The PEM data for the certificates.
+     */
+    auto trust_store(pem_file_ptr store) -> self& {
+        opts_.set_trust_store(std::move(store));
+        return *this;
+    }
+    /**
+     * Sets the public certificate chain of the client, from memory.
+     * @param store The PEM data for the certificate chain.
+     */
+    auto key_store(pem_file_ptr store) -> self& {
+        opts_.set_key_store(std::move(store));
+        return *this;
+    }
+    /**
+     * Sets the client's private key, from memory.
+     * @param key The PEM data for the private key.
+     */
+    auto private_key(pem_file_ptr key) -> self& {
+        opts_.set_private_key(std::move(key));
+        return *this;
+    }
     /**
      * Sets the password to load the client's privateKey if encrypted.
      * @param passwd The password to load the privateKey if encrypted.
@@ -0,0 +1,153 @@
+/////////////////////////////////////////////////////////////////////////////
+/// @file static_topic_filter.h
+/// Declaration of MQTT static_topic_filter class
+/// @author Frank Pagliughi
+/////////////////////////////////////////////////////////////////////////////
+
+/*******************************************************************************
+ * Copyright (c) 2025 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+#ifndef __mqtt_static_topic_filter_h
+#define __mqtt_static_topic_filter_h
+
+#include <cstddef>
+#include <string_view>
+
+namespace mqtt {
+
+/////////////////////////////////////////////////////////////////////////////
+
+/**
+ * An MQTT topic filter that is known at compile time.
+ *
+ * This is a `constexpr` counterpart to `topic_filter` for filters that are
+ * fixed in the code. The layout of the filter, such as the number of
+ * fields and where the wildcards are, is worked out when it's
+ * constructed, which can be at compile time:
+ *
+ * @code
+ * constexpr static_topic_filter TEMP_FILTER{"sensors/+/temp"};
+ *
+ * if (TEMP_FILTER.matches(msg->get_topic_ref())) { ... }
+ * @endcode
+ *
+ * It refers to the filter string rather than copying it, and matching
+ * walks the filter and topic side by side, without splitting either of
+ * them, so it never allocates. A filter without wildcards is matched with
+ * a single string comparison.
+ */
+class static_topic_filter
+{
+    /** The filter string */
+    std::string_view filter_;
+    /** The number of fields in the filter */
+    size_t nFields_{0};
+    /** Whether the filter contains any wildcards */
+    bool hasWildcards_{false};
+    /** Whether the first field is a wildcard */
+    bool firstWildcard_{false};
+
+    /** Determines if the field is a wildcard, "+" or "#" */
+    static constexpr bool is_wildcard(std::string_view field) noexcept {
+        return field.size() == 1 && (field[0] == '+' || field[0] == '#');
+    }
+    /** Gets the field at the position, moving the position past it */
+    static constexpr std::string_view next_field(std::string_view s, size_t& pos) noexcept {
+        auto end = s.find('/', pos);
+        auto field = s.substr(pos, (end == std::string_view::npos) ? end : (end - pos));
+        pos = (end == std::string_view::npos) ? end : (end + 1);
+        return field;
+    }
+
+public:
+    /**
+     * Creates a topic filter.
+     * @param filter The filter string. This is a slash ('/') delimited
+     *  			 topic string that can contain wildcards '+' and '#'.
+     *  			 It must outlive the filter object, as it would when
+     *  			 it's a string literal.
+     */
+    constexpr explicit static_topic_filter(std::string_view filter) noexcept
+        : filter_{filter} {
+        for (size_t pos = filter_.empty() ? std::string_view::npos : 0;
+             pos != std::string_view::npos;) {
+            auto field = next_field(filter_, pos);
+            if (is_wildcard(field)) {
+                hasWildcards_ = true;
+                if (nFields_ == 0)
+                    firstWildcard_ = true;
+            }
+            ++nFields_;
+        }
+    }
+    /**
+     * Gets the filter string.
+     * @return The filter string.
+     */
+    constexpr std::string_view str() const noexcept { return filter_; }
+    /**
+     * Gets the number of fields in the filter.
+     * @return The number of fields in the filter.
+     */
+    constexpr size_t num_fields() const noexcept { return nFields_; }
+    /**
+     * Determines if the filter contains any wildcards.
+     * @return @em true if any of the fields are a wildcard, @em false if
+     *  	   not.
+     */
+    constexpr bool has_wildcards() const noexcept { return hasWildcards_; }
+    /**
+     * Determine if the topic matches this filter.
+     *
+     * This gives the same result as `topic_filter::matches()`.
+     *
+     * @param topic An MQTT topic. It should not contain wildcards.
+     * @return  @em true of the topic matches this filter, @em false
+     *  		otherwise.
+     */
+    constexpr bool matches(std::string_view topic) const noexcept {
+        if (!hasWildcards_)
+            return topic == filter_;
+
+        // Topics starting with '$' don't match wildcards in the first field
+        if (firstWildcard_ && !topic.empty() && topic[0] == '$')
+            return false;
+
+        // The filter has at least one field here, so the topic needs one.
+        if (topic.empty())
+            return false;
+
+        size_t fpos = 0, tpos = 0;
+
+        while (fpos != std::string_view::npos && tpos != std::string_view::npos) {
+            auto filt = next_field(filter_, fpos);
+            if (filt == "#")
+                return true;
+
+            auto field = next_field(topic, tpos);
+            if (filt != "+" && filt != field)
+                return false;
+        }
+
+        // Only a match if both ran out of fields together.
+        return fpos == tpos;
+    }
+};
+
+/////////////////////////////////////////////////////////////////////////////
+}  // namespace mqtt
+
+#endif  // __mqtt_static_topic_filter_h
@@ -0,0 +1,177 @@
+/////////////////////////////////////////////////////////////////////////////
+/// @file stream_publisher.h
+/// Declaration of MQTT stream_publisher class
+/// @author Frank Pagliughi
+/////////////////////////////////////////////////////////////////////////////
+
+/*******************************************************************************
+ * Copyright (c) 2025 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+#ifndef __mqtt_stream_publisher_h
+#define __mqtt_stream_publisher_h
+
+#include <cstdint>
+#include <iosfwd>
+
+#include "mqtt/async_client.h"
+#include "mqtt/sequence_tracker.h"
+
+namespace mqtt {
+
+/////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Publishes a large payload, such as a file, as a stream of chunks.
+ *
+ * The data is read from a file or an input stream a chunk at a time, and
+ * each chunk is published as a message of its own, to the same topic.
+ * No more than a fixed number of chunks are in flight at once; before
+ * reading the next one, the publisher waits for the oldest to complete.
+ * So the memory used is the chunk size times the in-flight limit, no
+ * matter how big the file is. Each chunk is read directly into the buffer
+ * that becomes its payload, so the data isn't copied again on the way to
+ * the C library.
+ * @par
+ * With MQTT v5, each chunk carries user properties with the ID of the
+ * transfer, the byte offset of the chunk, the total size of the data
+ * when it's known in advance, and a sequence number counting from zero,
+ * which a @ref sequence_tracker can check. The last chunk has a user
+ * property marking it as the last. A @ref chunk_reassembler on the
+ * receiving client puts the payloads back together. An empty stream is
+ * sent as a single, empty, last chunk. MQTT v3 has no properties, so the
+ * receiver must rely on the order of delivery, and a QoS of one or more,
+ * to join the chunks.
+ */
+class stream_publisher
+{
+    /** The client to publish with */
+    async_client& cli_;
+    /** The topic for the chunks */
+    string_ref topic_;
+    /** The QoS for the chunks */
+    int qos_;
+    /** The size of each chunk, in bytes */
+    size_t chunkSize_;
+    /** The most chunks in flight at once */
+    size_t maxInFlight_;
+    /** The name of the user property with the sequence number */
+    string seqProp_{sequence_tracker::DFLT_PROPERTY_NAME};
+    /** The number of chunks published by the last stream */
+    uint64_t nChunks_{0};
+    /** The ID of the last transfer */
+    string transferId_;
+    /** The number of transfers started, to make their IDs */
+    uint64_t nTransfers_{0};
+
+public:
+    /** The default size of each chunk */
+    static constexpr size_t DFLT_CHUNK_SIZE = 64 * 1024;
+    /** The default for the most chunks in flight at once */
+    static constexpr size_t DFLT_MAX_IN_FLIGHT = 16;
+    /** The name of the user property that marks the last chunk */
+    static constexpr const char* LAST_PROPERTY_NAME = "last";
+    /** The name of the user property with the ID of the transfer */
+    static constexpr const char* TRANSFER_PROPERTY_NAME = "transfer";
+    /** The name of the user property with the offset of the chunk */
+    static constexpr const char* OFFSET_PROPERTY_NAME = "offset";
+    /** The name of the user property with the total size of the data */
+    static constexpr const char* SIZE_PROPERTY_NAME = "size";
+
+    /**
+     * Creates a publisher for streams.
+     * @param cli The client to publish with.
+     * @param topic The topic for the chunks.
+     * @param qos The QoS for the chunks.
+     * @param chunkSize The size of each chunk, in bytes. This should be
+     *  				comfortably under the maximum packet size of the
+     *  				server.
+     * @param maxInFlight The most chunks to have in flight at once.
+     * @throw std::invalid_argument if the chunk size or the in-flight limit
+     *  	  is zero.
+     */
+    stream_publisher(
+        async_client& cli, string_ref topic, int qos = 1, size_t chunkSize = DFLT_CHUNK_SIZE,
+        size_t maxInFlight = DFLT_MAX_IN_FLIGHT
+    );
+
+    stream_publisher(const stream_publisher&) = delete;
+    stream_publisher& operator=(const stream_publisher&) = delete;
+
+    /**
+     * Gets the topic for the chunks.
+     * @return The topic for the chunks.
+     */
+    const string& get_topic() const { return topic_.str(); }
+    /**
+     * Gets the size of each chunk.
+     * @return The size of each chunk, in bytes.
+     */
+    size_t get_chunk_size() const { return chunkSize_; }
+    /**
+     * Gets the most chunks that can be in flight at once.
+     * @return The most chunks in flight at once.
+     */
+    size_t get_max_in_flight() const { return maxInFlight_; }
+    /**
+     * Gets the name of the user property with the sequence number.
+     * @return The name of the user property with the sequence number.
+     */
+    const string& get_sequence_property() const { return seqProp_; }
+    /**
+     * Sets the name of the user property with the sequence number.
+     * @param name The name of the user property with the sequence number.
+     */
+    void set_sequence_property(const string& name) { seqProp_ = name; }
+    /**
+     * Gets the number of chunks published for the last stream.
+     * @return The number of chunks of the last stream.
+     */
+    uint64_t chunks() const { return nChunks_; }
+    /**
+     * Gets the ID of the last transfer.
+     * @return The ID of the last transfer.
+     */
+    const string& get_transfer_id() const { return transferId_; }
+    /**
+     * Publishes the contents of a stream.
+     * This reads the stream to its end, and blocks until all of the chunks
+     * have been delivered. If the stream can seek, the size of the data is
+     * sent with the chunks, so the receiver can allocate it all at once.
+     * @param is The stream to read.
+     * @param transferId The ID for the transfer. If this is empty, one is
+     *  				 made from the client ID, the time, and a count.
+     * @return The number of bytes published.
+     * @throw exception if a chunk could not be published or delivered, or
+     *  	  the stream could not be read.
+     */
+    uint64_t publish(std::istream& is, const string& transferId = string{});
+    /**
+     * Publishes the contents of a file.
+     * This blocks until all of the chunks have been delivered.
+     * @param path The path to the file.
+     * @param transferId The ID for the transfer. If this is empty, one is
+     *  				 made from the client ID, the time, and a count.
+     * @return The number of bytes published.
+     * @throw exception if the file could not be opened or read, or a chunk
+     *  	  could not be published or delivered.
+     */
+    uint64_t publish_file(const string& path, const string& transferId = string{});
+};
+
+/////////////////////////////////////////////////////////////////////////////
+}  // namespace mqtt
+
+#endif  // __mqtt_stream_publisher_h
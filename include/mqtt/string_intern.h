@@ -0,0 +1,137 @@
+/////////////////////////////////////////////////////////////////////////////
+/// @file string_intern.h
+/// Declaration of MQTT string_intern class
+/// @author Frank Pagliughi
+/////////////////////////////////////////////////////////////////////////////
+
+/*******************************************************************************
+ * Copyright (c) 2025 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+#ifndef __mqtt_string_intern_h
+#define __mqtt_string_intern_h
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <unordered_map>
+
+#include "mqtt/buffer_ref.h"
+
+namespace mqtt {
+
+/////////////////////////////////////////////////////////////////////////////
+
+/**
+ * A table of shared, immutable strings.
+ *
+ * This is used to intern the topic names of incoming messages, so that
+ * messages on the same topic share a single @ref string_ref, rather than
+ * each one allocating and copying its own string. A lookup for a string
+ * that is already in the table costs a hash and compare, with no
+ * allocation. Two references from the table to the same string will
+ * share the same buffer, so they can be compared by pointer.
+ *
+ * The table is bounded. Once it holds the maximum number of strings, any
+ * new string is returned as a reference to a new buffer, and is not added
+ * to the table.
+ *
+ * The table is thread safe.
+ */
+class string_intern
+{
+    /** The table of strings, keyed by views into the shared buffers */
+    std::unordered_map<std::string_view, string_ref> tbl_;
+    /** The maximum number of strings in the table */
+    size_t maxSize_;
+    /** Lock to protect the table */
+    mutable std::mutex lock_;
+
+public:
+    /** Smart/shared pointer to an object of this class. */
+    using ptr_t = std::shared_ptr<string_intern>;
+
+    /**
+     * Creates an intern table.
+     * @param maxSize The maximum number of strings to hold in the table.
+     */
+    explicit string_intern(size_t maxSize) : maxSize_{maxSize} {}
+    /**
+     * Creates an intern table.
+     * @param maxSize The maximum number of strings to hold in the table.
+     * @return A shared pointer to a new intern table.
+     */
+    static ptr_t create(size_t maxSize) { return std::make_shared<string_intern>(maxSize); }
+    /**
+     * Gets the maximum number of strings held in the table.
+     * @return The maximum number of strings held in the table.
+     */
+    size_t max_size() const { return maxSize_; }
+    /**
+     * Gets the number of strings currently held in the table.
+     * @return The number of strings currently held in the table.
+     */
+    size_t size() const;
+    /**
+     * Removes all the strings from the table.
+     * Any references already handed out remain valid.
+     */
+    void clear();
+    /**
+     * Gets a shared reference to the string.
+     * If the string is already in the table, the existing reference is
+     * returned. Otherwise a new one is created and, if there is room,
+     * added to the table.
+     * @param sv The string to look up.
+     * @return A shared reference to the string.
+     */
+    string_ref get(std::string_view sv);
+    /**
+     * Gets a shared reference to the string.
+     * This is the same as @ref get, but uses the supplied function to
+     * create the reference if the string is not in the table, such as to
+     * take it from a @ref message_pool.
+     * @param sv The string to look up.
+     * @param fn A function `string_ref(std::string_view)` to create the
+     *  		 reference if the string is not in the table.
+     * @return A shared reference to the string.
+     */
+    template <typename Func>
+    string_ref get(std::string_view sv, Func fn) {
+        std::lock_guard<std::mutex> g{lock_};
+        auto it = tbl_.find(sv);
+        if (it != tbl_.end())
+            return it->second;
+
+        string_ref s = fn(sv);
+        if (tbl_.size() < maxSize_) {
+            // The key must view the string in the table, since a small
+            // string is held in place by each reference.
+            auto nh = tbl_.extract(tbl_.emplace(sv, s).first);
+            nh.key() = std::string_view{nh.mapped().data(), nh.mapped().size()};
+            tbl_.insert(std::move(nh));
+        }
+        return s;
+    }
+};
+
+/** Smart/shared pointer to a string intern table */
+using string_intern_ptr = string_intern::ptr_t;
+
+/////////////////////////////////////////////////////////////////////////////
+}  // namespace mqtt
+
+#endif  // __mqtt_string_intern_h
@@ -26,12 +26,17 @@
 #define __mqtt_thread_queue_h
 
 #include <algorithm>
+#include <atomic>
 #include <condition_variable>
 #include <deque>
+#include <functional>
 #include <limits>
 #include <mutex>
 #include <queue>
 #include <thread>
+#include <vector>
+
+#include "mqtt/spin_wait.h"
 
 namespace mqtt {
 
@@ -63,6 +68,15 @@ public:
  * queue will block until the number of items are removed from the queue to
  * bring the size below the new capacity.
  * @par
+ * The queue can also be bounded by the total "weight" of the items in it,
+ * such as the number of bytes that they hold, rather than just the number
+ * of them. This is done by giving the constructor a function to weigh each
+ * item, and the maximum total weight. A put to the queue will block until
+ * the new item fits within both the capacity and the maximum weight. An
+ * item is always accepted into an empty queue, though, even if it is
+ * heavier than the maximum weight, so an oversized item can't block the
+ * queue forever.
+ * @par
  * The queue can be closed. After that, no new items can be placed into it;
  * a `put()` calls will fail. Receivers can still continue to get any items
  * out of the queue that were added before it was closed. Once there are no
@@ -94,6 +108,11 @@ public:
 
     /** The maximum capacity of the queue. */
     static constexpr size_type MAX_CAPACITY = std::numeric_limits<size_type>::max();
+    /** The maximum total weight of the items in the queue. */
+    static constexpr size_t MAX_WEIGHT = std::numeric_limits<size_t>::max();
+
+    /** The type of function to get the weight of an item in the queue. */
+    using weight_function = std::function<size_t(const value_type&)>;
 
 private:
     /** Object lock */
@@ -106,10 +125,33 @@ private:
     size_type cap_{MAX_CAPACITY};
     /** Whether the queue is closed */
     bool closed_{false};
+    /** The function to get the weight of an item, if any */
+    weight_function weigher_;
+    /** The maximum total weight of the items in the queue */
+    size_t maxWeight_{MAX_WEIGHT};
+    /** The total weight of the items in the queue */
+    size_t weight_{0};
+    /**
+     * Whether a get would not block, because the queue has items or is
+     * closed. This can be read without the lock, for spinning.
+     */
+    std::atomic<bool> ready_{false};
+    /** The number of times a get spins before blocking */
+    std::atomic<unsigned> nSpins_{0};
+    /** The number of times a get yields before blocking */
+    std::atomic<unsigned> nYields_{0};
 
     /** The actual STL container to hold data */
     std::queue<T, Container> que_;
 
+    /** Gets at the container in a std::queue, to move it out whole */
+    struct queue_access : std::queue<T, Container>
+    {
+        static Container& container(std::queue<T, Container>& q) {
+            return q.*(&queue_access::c);
+        }
+    };
+
     /** Simple, scope-based lock guard */
     using guard = std::lock_guard<std::mutex>;
     /** General purpose guard */
@@ -118,6 +160,75 @@ private:
     /** Checks if the queue is done (unsafe) */
     bool is_done() const { return closed_ && que_.empty(); }
 
+    /** Updates the ready flag after a change to the queue (unsafe) */
+    void update_ready() {
+        ready_.store(closed_ || !que_.empty(), std::memory_order_release);
+    }
+
+    /**
+     * Spins, without the lock, until the queue looks ready or the spin
+     * policy is used up. The caller then takes the lock and checks the
+     * queue as usual, so this only decides how long to wait before
+     * blocking.
+     */
+    void spin_until_ready() const {
+        spin_wait sw{
+            nSpins_.load(std::memory_order_relaxed), nYields_.load(std::memory_order_relaxed)
+        };
+        if (sw.enabled())
+            sw([this] { return ready_.load(std::memory_order_acquire); });
+    }
+
+    /** Gets the weight of an item */
+    size_t weigh(const value_type& val) const { return weigher_ ? weigher_(val) : 0; }
+
+    /**
+     * Determines if an item with the specified weight can be added to the
+     * queue (unsafe).
+     */
+    bool has_room(size_t w) const {
+        return que_.size() < cap_ &&
+               (que_.empty() || (weight_ <= maxWeight_ && w <= maxWeight_ - weight_));
+    }
+
+    /** Removes the item at the front of the queue (unsafe) */
+    value_type pop_front() {
+        if (weigher_)
+            weight_ -= std::min(weight_, weigher_(que_.front()));
+        value_type val = std::move(que_.front());
+        que_.pop();
+        update_ready();
+        return val;
+    }
+
+    /**
+     * Signals the threads waiting to put items into the queue that one was
+     * removed. With weights, a single removal might make room for more
+     * than one waiter, or not enough for the next one, so all are woken.
+     */
+    void notify_not_full() {
+        if (weigher_)
+            notFullCond_.notify_all();
+        else
+            notFullCond_.notify_one();
+    }
+
+    /**
+     * Moves up to the specified number of items from the queue into the
+     * vector (unsafe).
+     * @return The number of items moved.
+     */
+    size_type pop_bulk(std::vector<value_type>& vec, size_type maxItems) {
+        size_type n = std::min(maxItems, que_.size());
+        if (n == 0)
+            return 0;
+
+        vec.reserve(vec.size() + n);
+        for (size_type i = 0; i < n; ++i) vec.emplace_back(pop_front());
+        notFullCond_.notify_all();
+        return n;
+    }
+
 public:
     /**
      * Constructs a queue with the maximum capacity.
@@ -131,6 +242,22 @@ public:
      *  		  queue. The minimum capacity is 1.
      */
     explicit thread_queue(size_t cap) : cap_(std::max<size_type>(cap, 1)) {}
+    /**
+     * Constructs a queue that is bounded by the total weight of the items
+     * in it, as well as the number of them.
+     * @param cap The maximum number of items that can be placed in the
+     *  		  queue. The minimum capacity is 1. Use @ref MAX_CAPACITY
+     *  		  to only bound the queue by weight.
+     * @param maxWeight The maximum total weight of the items in the queue.
+     * @param weigher A function to get the weight of an item, such as the
+     *  			  number of bytes it holds. This is called when the
+     *  			  item is added and again when it is removed, so it
+     *  			  must give the same value each time.
+     */
+    thread_queue(size_t cap, size_t maxWeight, weight_function weigher)
+        : cap_(std::max<size_type>(cap, 1)),
+          weigher_(std::move(weigher)),
+          maxWeight_(maxWeight) {}
     /**
      * Determine if the queue is empty.
      * @return @em true if there are no elements in the queue, @em false if
@@ -158,6 +285,59 @@ public:
         guard g{lock_};
         cap_ = cap;
     }
+    /**
+     * Gets the policy for spinning before a get blocks.
+     * @return The spin-then-block policy for the consumers.
+     */
+    spin_wait spin() const {
+        return spin_wait{
+            nSpins_.load(std::memory_order_relaxed), nYields_.load(std::memory_order_relaxed)
+        };
+    }
+    /**
+     * Sets the policy for spinning before a get blocks.
+     * When the queue is empty, the blocking and timed gets first spin
+     * and yield, checking for an item without the lock, before waiting on
+     * the condition variable. This can lower the latency for a consumer
+     * on a dedicated core, at the cost of the CPU time it spends spinning.
+     * @param sw The spin-then-block policy for the consumers.
+     */
+    void spin(const spin_wait& sw) {
+        nSpins_.store(sw.spins(), std::memory_order_relaxed);
+        nYields_.store(sw.yields(), std::memory_order_relaxed);
+    }
+    /**
+     * Gets the maximum total weight of the items in the queue.
+     * @return The maximum total weight of the items in the queue. This is
+     *  	   @ref MAX_WEIGHT if the queue is not bounded by weight.
+     */
+    size_t max_weight() const {
+        guard g{lock_};
+        return maxWeight_;
+    }
+    /**
+     * Sets the maximum total weight of the items in the queue.
+     * This only has an effect if the queue was created with a function to
+     * weigh the items. As with the capacity, it can be set smaller than the
+     * current weight of the queue, in which case puts will block until
+     * enough items are removed.
+     * @param maxWeight The maximum total weight of the items in the queue.
+     */
+    void max_weight(size_t maxWeight) {
+        guard g{lock_};
+        maxWeight_ = maxWeight;
+        notFullCond_.notify_all();
+    }
+    /**
+     * Gets the total weight of the items currently in the queue.
+     * @return The total weight of the items in the queue. This is always
+     *  	   zero if the queue was not created with a function to weigh
+     *  	   the items.
+     */
+    size_t weight() const {
+        guard g{lock_};
+        return weight_;
+    }
     /**
      * Gets the number of items in the queue.
      * @return The number of items in the queue.
@@ -175,6 +355,7 @@ public:
     void close() {
         guard g{lock_};
         closed_ = true;
+        update_ready();
         notFullCond_.notify_all();
         notEmptyCond_.notify_all();
     }
@@ -206,6 +387,8 @@ public:
     void clear() {
         guard g{lock_};
         while (!que_.empty()) que_.pop();
+        weight_ = 0;
+        update_ready();
         notFullCond_.notify_all();
     }
     /**
@@ -215,12 +398,15 @@ public:
      * @param val The value to add to the queue.
      */
     void put(value_type val) {
+        auto w = weigh(val);
         unique_guard g{lock_};
-        notFullCond_.wait(g, [this] { return que_.size() < cap_ || closed_; });
+        notFullCond_.wait(g, [this, w] { return has_room(w) || closed_; });
         if (closed_)
             throw queue_closed{};
 
+        weight_ += w;
         que_.emplace(std::move(val));
+        update_ready();
         notEmptyCond_.notify_one();
     }
     /**
@@ -230,11 +416,14 @@ public:
      *  	   item was not added because the queue is currently full.
      */
     bool try_put(value_type val) {
+        auto w = weigh(val);
         guard g{lock_};
-        if (que_.size() >= cap_ || closed_)
+        if (!has_room(w) || closed_)
             return false;
 
+        weight_ += w;
         que_.emplace(std::move(val));
+        update_ready();
         notEmptyCond_.notify_one();
         return true;
     }
@@ -249,14 +438,17 @@ public:
      */
     template <typename Rep, class Period>
     bool try_put_for(value_type val, const std::chrono::duration<Rep, Period>& relTime) {
+        auto w = weigh(val);
         unique_guard g{lock_};
-        bool to = !notFullCond_.wait_for(g, relTime, [this] {
-            return que_.size() < cap_ || closed_;
+        bool to = !notFullCond_.wait_for(g, relTime, [this, w] {
+            return has_room(w) || closed_;
         });
         if (to || closed_)
             return false;
 
+        weight_ += w;
         que_.emplace(std::move(val));
+        update_ready();
         notEmptyCond_.notify_one();
         return true;
     }
@@ -274,15 +466,18 @@ public:
     bool try_put_until(
         value_type val, const std::chrono::time_point<Clock, Duration>& absTime
     ) {
+        auto w = weigh(val);
         unique_guard g{lock_};
-        bool to = !notFullCond_.wait_until(g, absTime, [this] {
-            return que_.size() < cap_ || closed_;
+        bool to = !notFullCond_.wait_until(g, absTime, [this, w] {
+            return has_room(w) || closed_;
         });
 
         if (to || closed_)
             return false;
 
+        weight_ += w;
         que_.emplace(std::move(val));
+        update_ready();
         notEmptyCond_.notify_one();
         return true;
     }
@@ -296,14 +491,14 @@ public:
         if (!val)
             return false;
 
+        spin_until_ready();
         unique_guard g{lock_};
         notEmptyCond_.wait(g, [this] { return !que_.empty() || closed_; });
         if (que_.empty())  // We must be done
             return false;
 
-        *val = std::move(que_.front());
-        que_.pop();
-        notFullCond_.notify_one();
+        *val = pop_front();
+        notify_not_full();
         return true;
     }
     /**
@@ -313,14 +508,14 @@ public:
      * @return The value removed from the queue
      */
     value_type get() {
+        spin_until_ready();
         unique_guard g{lock_};
         notEmptyCond_.wait(g, [this] { return !que_.empty() || closed_; });
         if (que_.empty())  // We must be done
             throw queue_closed{};
 
-        value_type val = std::move(que_.front());
-        que_.pop();
-        notFullCond_.notify_one();
+        value_type val = pop_front();
+        notify_not_full();
         return val;
     }
     /**
@@ -339,9 +534,8 @@ public:
         if (que_.empty())
             return false;
 
-        *val = std::move(que_.front());
-        que_.pop();
-        notFullCond_.notify_one();
+        *val = pop_front();
+        notify_not_full();
         return true;
     }
     /**
@@ -359,15 +553,15 @@ public:
         if (!val)
             return false;
 
+        spin_until_ready();
         unique_guard g{lock_};
         notEmptyCond_.wait_for(g, relTime, [this] { return !que_.empty() || closed_; });
 
         if (que_.empty())
             return false;
 
-        *val = std::move(que_.front());
-        que_.pop();
-        notFullCond_.notify_one();
+        *val = pop_front();
+        notify_not_full();
         return true;
     }
     /**
@@ -387,16 +581,97 @@ public:
         if (!val)
             return false;
 
+        spin_until_ready();
         unique_guard g{lock_};
         notEmptyCond_.wait_until(g, absTime, [this] { return !que_.empty() || closed_; });
         if (que_.empty())
             return false;
 
-        *val = std::move(que_.front());
-        que_.pop();
-        notFullCond_.notify_one();
+        *val = pop_front();
+        notify_not_full();
         return true;
     }
+    /**
+     * Removes all the items currently in the queue without blocking.
+     * This takes the lock once for the whole operation.
+     * @return A vector of the items that were in the queue. It is empty if
+     *  	   the queue was empty.
+     */
+    std::vector<value_type> get_all() {
+        std::vector<value_type> vec;
+        try_get_bulk(vec, MAX_CAPACITY);
+        return vec;
+    }
+    /**
+     * Removes all the items currently in the queue, by swapping out the
+     * underlying container.
+     * Unlike get_all(), this doesn't move the items one at a time, so the
+     * lock is only held for a constant time, however many there are.
+     * @return The container of the items that were in the queue, in order
+     *  	   from the front.
+     */
+    container_type drain() {
+        std::queue<T, Container> q;
+        {
+            guard g{lock_};
+            que_.swap(q);
+            weight_ = 0;
+            update_ready();
+        }
+        notFullCond_.notify_all();
+        return std::move(queue_access::container(q));
+    }
+    /**
+     * Attempts to remove a number of items from the queue without
+     * blocking.
+     * This removes up to the specified number of items, and appends them
+     * to the vector, with a single lock of the queue.
+     * @param vec The vector to receive the items.
+     * @param maxItems The maximum number of items to remove.
+     * @return The number of items removed from the queue.
+     */
+    size_type try_get_bulk(std::vector<value_type>& vec, size_type maxItems) {
+        guard g{lock_};
+        return pop_bulk(vec, maxItems);
+    }
+    /**
+     * Attempts to remove a number of items from the queue, waiting for a
+     * bounded amount of time for one to arrive if the queue is empty.
+     * @param vec The vector to receive the items.
+     * @param maxItems The maximum number of items to remove.
+     * @param relTime The amount of time to wait until timing out.
+     * @return The number of items removed from the queue. This is zero if
+     *  	   a timeout occurred.
+     */
+    template <typename Rep, class Period>
+    size_type try_get_bulk_for(
+        std::vector<value_type>& vec, size_type maxItems,
+        const std::chrono::duration<Rep, Period>& relTime
+    ) {
+        spin_until_ready();
+        unique_guard g{lock_};
+        notEmptyCond_.wait_for(g, relTime, [this] { return !que_.empty() || closed_; });
+        return pop_bulk(vec, maxItems);
+    }
+    /**
+     * Attempts to remove a number of items from the queue, waiting until a
+     * specific time for one to arrive if the queue is empty.
+     * @param vec The vector to receive the items.
+     * @param maxItems The maximum number of items to remove.
+     * @param absTime The absolute time to wait to before timing out.
+     * @return The number of items removed from the queue. This is zero if
+     *  	   a timeout occurred.
+     */
+    template <class Clock, class Duration>
+    size_type try_get_bulk_until(
+        std::vector<value_type>& vec, size_type maxItems,
+        const std::chrono::time_point<Clock, Duration>& absTime
+    ) {
+        spin_until_ready();
+        unique_guard g{lock_};
+        notEmptyCond_.wait_until(g, absTime, [this] { return !que_.empty() || closed_; });
+        return pop_bulk(vec, maxItems);
+    }
 };
 
 /////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,196 @@
+/////////////////////////////////////////////////////////////////////////////
+/// @file timer_wheel.h
+/// Declaration of MQTT timer_wheel class
+/// @author Frank Pagliughi
+/////////////////////////////////////////////////////////////////////////////
+
+/*******************************************************************************
+ * Copyright (c) 2025 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+
+#ifndef __mqtt_timer_wheel_h
+#define __mqtt_timer_wheel_h
+
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace mqtt {
+
+/////////////////////////////////////////////////////////////////////////////
+
+/**
+ * A set of timers, run by a single thread, for a large number of
+ * deadlines.
+ *
+ * The timers are kept in a hierarchical timing wheel: four levels of 64
+ * slots each, where a slot of the first level is one tick, and a slot of
+ * each higher level spans a whole turn of the level below it. A timer is
+ * put into the level for how far off it is, and moved down a level each
+ * time the level below it comes around, until it fires. Starting and
+ * cancelling a timer are constant time operations, no matter how many are
+ * running, and the thread only wakes once per tick, and only while there
+ * are timers, so thousands of deadlines cost far less than a thread or a
+ * timed wait for each of them.
+ * @par
+ * The timers fire to within a tick of their deadlines. The handlers are
+ * run on the thread of the wheel, so they should be quick, and must not
+ * block. Timers past the range of the wheel, about 46 hours with the
+ * default tick, are held at its far end and put back when they come up.
+ */
+class timer_wheel
+{
+public:
+    /** Smart/shared pointer to an object of this class. */
+    using ptr_t = std::shared_ptr<timer_wheel>;
+    /** The clock for the timers */
+    using clock = std::chrono::steady_clock;
+    /** The type for the delays */
+    using duration = clock::duration;
+    /** The identifier for a timer. Zero never names a timer. */
+    using timer_id = uint64_t;
+    /** The function that runs when a timer fires */
+    using handler_type = std::function<void()>;
+
+    /** The default time for each tick of the wheel */
+    static constexpr std::chrono::milliseconds DFLT_TICK{10};
+
+private:
+    /** The number of bits of the tick count for each level */
+    static constexpr unsigned LEVEL_BITS = 6;
+    /** The number of slots in each level */
+    static constexpr size_t N_SLOTS = size_t(1) << LEVEL_BITS;
+    /** The number of levels */
+    static constexpr unsigned N_LEVELS = 4;
+
+    /** A timer in a slot of the wheel */
+    struct entry
+    {
+        timer_id id;
+        /** The tick at which the timer fires */
+        uint64_t expires;
+    };
+
+    /** The timers in a slot */
+    using slot_type = std::vector<entry>;
+
+    /** The time for each tick */
+    duration tick_;
+    /** Object lock */
+    mutable std::mutex lock_;
+    /** Signaled when a timer is added to an empty wheel, or to stop */
+    std::condition_variable cond_;
+    /** The slots of each level */
+    std::array<std::array<slot_type, N_SLOTS>, N_LEVELS> wheel_;
+    /** The handlers of the running timers. Cancelled ones are removed. */
+    std::unordered_map<timer_id, handler_type> handlers_;
+    /** The time of tick zero */
+    clock::time_point base_;
+    /** The current tick */
+    uint64_t now_{0};
+    /** The ID for the next timer */
+    timer_id nextId_{1};
+    /** Whether the thread should exit */
+    bool stop_{false};
+    /** The thread that runs the timers */
+    std::thread thr_;
+
+    /** Gets the number of ticks from the base to a time point (unsafe) */
+    uint64_t ticks_at(clock::time_point tp) const;
+    /** Puts a timer into the slot for its expiry tick (unsafe) */
+    void insert(const entry& ent);
+    /** Moves the timers in the current slot of a level down (unsafe) */
+    void cascade(unsigned level);
+    /**
+     * Advances the wheel by one tick, collecting the handlers of the
+     * timers that fire (unsafe).
+     */
+    void advance(std::vector<handler_type>& due);
+    /** The thread function */
+    void run();
+
+public:
+    /**
+     * Creates a timer wheel, and starts its thread.
+     * @param tick The time for each tick. The minimum is 1ms.
+     */
+    explicit timer_wheel(duration tick = DFLT_TICK);
+    /**
+     * Stops the thread. The timers that are still running are dropped
+     * without running.
+     */
+    ~timer_wheel();
+
+    timer_wheel(const timer_wheel&) = delete;
+    timer_wheel& operator=(const timer_wheel&) = delete;
+
+    /**
+     * Creates a timer wheel, and starts its thread.
+     * @param tick The time for each tick. The minimum is 1ms.
+     * @return A shared pointer to the new timer wheel.
+     */
+    static ptr_t create(duration tick = DFLT_TICK) {
+        return std::make_shared<timer_wheel>(tick);
+    }
+    /**
+     * Gets the time for each tick.
+     * @return The time for each tick.
+     */
+    duration tick() const { return tick_; }
+    /**
+     * Starts a timer.
+     * @param delay The time until the timer fires. This is rounded up to
+     *  			a whole number of ticks, of at least one.
+     * @param fn The function to run when it fires.
+     * @return The identifier for the timer, to cancel it.
+     */
+    timer_id schedule(duration delay, handler_type fn);
+    /**
+     * Cancels a timer.
+     * @param id The identifier for the timer.
+     * @return @em true if the timer was cancelled, @em false if it already
+     *  	   fired, or there was no such timer.
+     */
+    bool cancel(timer_id id);
+    /**
+     * Gets the number of timers that are running.
+     * @return The number of timers that are running.
+     */
+    size_t size() const {
+        std::lock_guard<std::mutex> g{lock_};
+        return handlers_.size();
+    }
+    /**
+     * Determines if there are no timers running.
+     * @return @em true if there are no timers running.
+     */
+    bool empty() const { return size() == 0; }
+};
+
+/** Smart/shared pointer to a timer wheel */
+using timer_wheel_ptr = timer_wheel::ptr_t;
+
+/////////////////////////////////////////////////////////////////////////////
+}  // namespace mqtt
+
+#endif  // __mqtt_timer_wheel_h
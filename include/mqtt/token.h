@@ -25,16 +25,25 @@
 #ifndef __mqtt_token_h
 #define __mqtt_token_h
 
+#include <atomic>
 #include <chrono>
 #include <condition_variable>
+#include <functional>
+#include <memory>
 #include <mutex>
 #include <thread>
+#include <type_traits>
 #include <vector>
 
+#if defined(PAHO_MQTTPP_COROUTINES)
+    #include <coroutine>
+#endif
+
 #include "MQTTAsync.h"
 #include "mqtt/buffer_ref.h"
 #include "mqtt/exception.h"
 #include "mqtt/iaction_listener.h"
+#include "mqtt/platform.h"
 #include "mqtt/properties.h"
 #include "mqtt/server_response.h"
 #include "mqtt/string_collection.h"
@@ -50,7 +59,7 @@ class iasync_client;
  * Provides a mechanism for tracking the completion of an asynchronous
  * action.
  */
-class token
+class token : public std::enable_shared_from_this<token>
 {
 public:
     /** Smart/shared pointer to an object of this class */
@@ -71,8 +80,12 @@ private:
 
     /** Object monitor mutex. */
     mutable std::mutex lock_;
-    /** Condition variable signals when the action completes */
-    mutable std::condition_variable cond_;
+    /**
+     * Condition variable signals when the action completes.
+     * Most tokens are never waited on, so this is only created when a
+     * thread needs to block on the token.
+     */
+    mutable std::unique_ptr<std::condition_variable> cond_;
 
     /** The type of request that the token is tracking */
     Type type_;
@@ -99,8 +112,19 @@ private:
     iaction_listener* listener_;
     /** The number of expected responses */
     size_t nExpected_;
-    /** Whether the action has yet to complete */
-    bool complete_;
+    /**
+     * Whether the action has completed.
+     * This is only set with the lock held, but can be read without it,
+     * to spin before blocking.
+     */
+    std::atomic<bool> complete_;
+    /**
+     * Whether the action was failed by a deadline, before the library
+     * finished with it.
+     */
+    bool timedOut_{false};
+    /** One-shot handlers to call when the action completes */
+    std::vector<std::function<void()>> completeHandlers_;
 
     /** Connection response (null if not available) */
     std::unique_ptr<connect_response> connRsp_;
@@ -112,6 +136,9 @@ private:
     /** Client and token-related options have special access */
     friend class async_client;
     friend class mock_async_client;
+    friend class batch_token;
+    friend class pool_token;
+    friend class bulk_subscribe_token;
 
     friend class connect_options;
     friend class response_options;
@@ -173,11 +200,76 @@ private:
     void on_failure(MQTTAsync_failureData* rsp);
     void on_failure5(MQTTAsync_failureData5* rsp);
 
+    /**
+     * Signals that the action has completed.
+     * This calls the listener and completion handlers, either directly or
+     * through the client's executor, and wakes any waiting threads.
+     * @param listener The action listener, if any.
+     * @param success Whether the action succeeded.
+     * @param handlers The completion handlers.
+     * @param release Whether the client can let go of the token. This is
+     *  			  @em false when the library still has it.
+     */
+    void signal_complete(
+        iaction_listener* listener, bool success,
+        std::vector<std::function<void()>> handlers, bool release = true
+    );
+    /**
+     * Lets the client release a token that was already failed by a
+     * deadline, when the library finally completes it.
+     * This must be called with the lock held, and unlocks it if the
+     * token was released.
+     * @param g The lock on the token.
+     * @return @em true if the token had timed out, and was released.
+     */
+    bool release_expired(unique_lock& g);
+    /**
+     * Fails the action with a timeout, if it hasn't completed.
+     * The library still has the token, so it is kept by the client until
+     * the library finishes with it, but the result is ignored.
+     * @return @em true if the token was failed by this call, @em false if
+     *  	   it had already completed.
+     */
+    bool expire();
+    /**
+     * Gets the condition variable, creating it if needed.
+     * This must be called with the lock held.
+     */
+    std::condition_variable& cond() const {
+        if (!cond_)
+            cond_ = std::make_unique<std::condition_variable>();
+        return *cond_;
+    }
+    /**
+     * Wakes any threads waiting for the action to complete.
+     */
+    void notify_waiters() {
+        guard g(lock_);
+        if (cond_)
+            cond_->notify_all();
+    }
+    /**
+     * Spins, without the lock, until the action completes or the client's
+     * spin policy is used up. The caller then takes the lock and waits as
+     * usual.
+     */
+    void spin_complete() const;
+    /**
+     * Blocks until the action completes.
+     * This must be called with the lock held.
+     * @param g The lock on the token.
+     */
+    void wait_complete(unique_lock& g) const {
+        if (!complete_)
+            cond().wait(g, [this] { return complete_.load(); });
+    }
     /**
      * Check the current return code and throw an exception if it is not a
      * success code.
      */
     void check_ret() const {
+        if (timedOut_)
+            throw timeout_error{};
         if (rc_ != MQTTASYNC_SUCCESS || reasonCode_ >= 0x80)
             throw exception(rc_, reasonCode_, errMsg_);
     }
@@ -426,6 +518,30 @@ public:
      * @return Error message for the operation
      */
     string get_error_message() const { return errMsg_; }
+    /**
+     * Determines if the action was failed by a deadline.
+     * @return @em true if the action timed out before it completed.
+     * @see async_client::set_deadline()
+     */
+    bool is_timed_out() const {
+        guard g(lock_);
+        return timedOut_;
+    }
+    /**
+     * Registers a function to be called once when the action completes.
+     *
+     * This is a non-blocking alternative to wait(), to be used by
+     * asynchronous frameworks like coroutines. The function is called from
+     * the thread that completes the token, typically the library's
+     * callback thread, after any action listener and after any waiting
+     * threads are signaled. If the action has already completed, the
+     * function is not registered, and the caller should proceed directly.
+     *
+     * @param fn The function to call when the action completes.
+     * @return @em true if the function was registered, @em false if the
+     *  	   action has already completed.
+     */
+    bool notify_on_complete(std::function<void()> fn);
     /**
      * Blocks the current thread until the action this token is associated
      * with has completed.
@@ -440,7 +556,7 @@ public:
         guard g(lock_);
         if (complete_)
             check_ret();
-        return complete_;
+        return complete_.load();
     }
     /**
      * Blocks the current thread until the action this token is associated
@@ -460,9 +576,10 @@ public:
      */
     template <class Rep, class Period>
     bool wait_for(const std::chrono::duration<Rep, Period>& relTime) {
+        spin_complete();
         unique_lock g(lock_);
-        if (!cond_.wait_for(g, std::chrono::milliseconds(relTime), [this] {
-                return complete_;
+        if (!complete_ && !cond().wait_for(g, std::chrono::milliseconds(relTime), [this] {
+                return complete_.load();
             }))
             return false;
         check_ret();
@@ -476,8 +593,9 @@ public:
      */
     template <class Clock, class Duration>
     bool wait_until(const std::chrono::time_point<Clock, Duration>& absTime) {
+        spin_complete();
         unique_lock g(lock_);
-        if (!cond_.wait_until(g, absTime, [this] { return complete_; }))
+        if (!complete_ && !cond().wait_until(g, absTime, [this] { return complete_.load(); }))
             return false;
         check_ret();
         return true;
@@ -515,6 +633,56 @@ using token_ptr = token::ptr_t;
 /** Smart/shared pointer to a const token object */
 using const_token_ptr = token::const_ptr_t;
 
+#if defined(PAHO_MQTTPP_COROUTINES)
+/**
+ * An awaitable for a token, to wait for an operation to complete in a
+ * coroutine.
+ *
+ * The coroutine is suspended until the operation completes, and then
+ * resumed on the thread that completed it, which is typically the
+ * library's callback thread. If the operation failed, an exception is
+ * thrown from the `co_await`, just like wait(). Otherwise the result is
+ * the token itself, from which any response can be read.
+ *
+ * @tparam T The type of token, such as @ref token or @ref delivery_token.
+ */
+template <typename T>
+class token_awaiter
+{
+    /** The token being awaited */
+    std::shared_ptr<T> tok_;
+
+public:
+    explicit token_awaiter(std::shared_ptr<T> tok) : tok_{std::move(tok)} {}
+
+    bool await_ready() const { return tok_->is_complete(); }
+
+    bool await_suspend(std::coroutine_handle<> h) {
+        return tok_->notify_on_complete([h] { h.resume(); });
+    }
+
+    std::shared_ptr<T> await_resume() {
+        tok_->try_wait();
+        return std::move(tok_);
+    }
+};
+
+/**
+ * Makes any token awaitable in a coroutine:
+ *
+ * @code
+ *     auto tok = co_await cli.publish(msg);
+ * @endcode
+ *
+ * @param tok The token to await.
+ * @return An awaitable for the token.
+ */
+template <typename T, typename = std::enable_if_t<std::is_base_of_v<token, T>>>
+token_awaiter<T> operator co_await(std::shared_ptr<T> tok) {
+    return token_awaiter<T>{std::move(tok)};
+}
+#endif
+
 /////////////////////////////////////////////////////////////////////////////
 }  // namespace mqtt
 
@@ -0,0 +1,214 @@
+/////////////////////////////////////////////////////////////////////////////
+/// @file token_wait.h
+/// Functions to wait on a number of MQTT tokens at once
+/// @author Frank Pagliughi
+/////////////////////////////////////////////////////////////////////////////
+
+/*******************************************************************************
+ * Copyright (c) 2025 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+
+#ifndef __mqtt_token_wait_h
+#define __mqtt_token_wait_h
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+#include "mqtt/token.h"
+
+namespace mqtt {
+
+/////////////////////////////////////////////////////////////////////////////
+
+/**
+ * A countdown of the completions of a number of tokens, with one waiter.
+ *
+ * Each token calls in once as it completes, with a completion handler,
+ * and the waiter is only woken when the target number of them have come
+ * in. So waiting on @em n tokens costs a single wakeup, rather than one
+ * for each token, as with a loop calling token::wait().
+ */
+class token_latch
+{
+    /** Lock for the counts */
+    std::mutex lock_;
+    /** Signaled when the target is reached */
+    std::condition_variable cond_;
+    /** The number of completions to wait for */
+    size_t target_;
+    /** The number of tokens that have completed */
+    size_t nDone_{0};
+    /** The index of the first token to complete */
+    size_t first_;
+
+    /** Determines if the target is reached (unsafe) */
+    bool is_done() const { return nDone_ >= target_; }
+
+public:
+    /**
+     * Creates a latch for a number of tokens.
+     * @param n The number of tokens.
+     * @param target The number of them that must complete to release the
+     *  			 waiter.
+     */
+    token_latch(size_t n, size_t target) : target_{target}, first_{n} {}
+    /**
+     * Counts the completion of a token.
+     * @param idx The index of the token.
+     */
+    void count_down(size_t idx) {
+        std::lock_guard<std::mutex> g{lock_};
+        if (nDone_++ == 0)
+            first_ = idx;
+        if (nDone_ == target_)
+            cond_.notify_one();
+    }
+    /**
+     * Waits for the target number of tokens to complete.
+     */
+    void wait() {
+        std::unique_lock<std::mutex> g{lock_};
+        cond_.wait(g, [this] { return is_done(); });
+    }
+    /**
+     * Waits for the target number of tokens to complete, up to a time.
+     * @param absTime The time to wait until.
+     * @return @em true if the target was reached, @em false on a timeout.
+     */
+    bool wait_until(const std::chrono::steady_clock::time_point& absTime) {
+        std::unique_lock<std::mutex> g{lock_};
+        return cond_.wait_until(g, absTime, [this] { return is_done(); });
+    }
+    /**
+     * Gets the index of the first token to complete.
+     * @return The index of the first token to complete, or the number of
+     *  	   tokens if none have completed.
+     */
+    size_t first() {
+        std::lock_guard<std::mutex> g{lock_};
+        return first_;
+    }
+
+    /**
+     * Creates a latch and hooks it to the completion of the tokens.
+     * Any that have already completed are counted right away.
+     * @param toks The tokens.
+     * @param target The number of them that must complete to release the
+     *  			 waiter.
+     * @return A shared pointer to the latch. The tokens that have not yet
+     *  	   completed hold a reference to it until they do.
+     */
+    template <typename T>
+    static std::shared_ptr<token_latch> create(
+        const std::vector<std::shared_ptr<T>>& toks, size_t target
+    ) {
+        auto latch = std::make_shared<token_latch>(toks.size(), target);
+        for (size_t i = 0; i < toks.size(); ++i) {
+            if (!toks[i] || !toks[i]->notify_on_complete([latch, i] { latch->count_down(i); }))
+                latch->count_down(i);
+        }
+        return latch;
+    }
+};
+
+/////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Blocks until all of the tokens have completed.
+ *
+ * This uses a single latch that the tokens signal as they complete, so the
+ * waiting thread is only woken once, when the last of them is done. It
+ * does not throw if any of the operations failed. The return codes of the
+ * tokens tell which, if any, did.
+ *
+ * @code
+ *     std::vector<mqtt::delivery_token_ptr> toks;
+ *     for (const auto& msg : msgs)
+ *         toks.push_back(cli.publish(msg));
+ *     mqtt::wait_all(toks);
+ * @endcode
+ *
+ * @param toks The tokens to wait on. Null pointers are skipped.
+ */
+template <typename T>
+void wait_all(const std::vector<std::shared_ptr<T>>& toks) {
+    if (!toks.empty())
+        token_latch::create(toks, toks.size())->wait();
+}
+/**
+ * Blocks until all of the tokens have completed, or a timeout.
+ * @param toks The tokens to wait on. Null pointers are skipped.
+ * @param relTime The longest time to wait.
+ * @return @em true if all the tokens completed, @em false on a timeout.
+ */
+template <typename T, class Rep, class Period>
+bool wait_all(
+    const std::vector<std::shared_ptr<T>>& toks,
+    const std::chrono::duration<Rep, Period>& relTime
+) {
+    using std::chrono::steady_clock;
+    if (toks.empty())
+        return true;
+
+    auto absTime = steady_clock::now() + std::chrono::duration_cast<steady_clock::duration>(relTime);
+    return token_latch::create(toks, toks.size())->wait_until(absTime);
+}
+/**
+ * Blocks until any one of the tokens has completed.
+ * @param toks The tokens to wait on. A null pointer counts as complete.
+ * @return The index of the first token found to be complete.
+ * @throw std::invalid_argument if there are no tokens.
+ */
+template <typename T>
+size_t wait_any(const std::vector<std::shared_ptr<T>>& toks) {
+    if (toks.empty())
+        throw std::invalid_argument("No tokens to wait on");
+
+    auto latch = token_latch::create(toks, 1);
+    latch->wait();
+    return latch->first();
+}
+/**
+ * Blocks until any one of the tokens has completed, or a timeout.
+ * @param toks The tokens to wait on. A null pointer counts as complete.
+ * @param relTime The longest time to wait.
+ * @return The index of the first token found to be complete, or the
+ *  	   number of tokens on a timeout.
+ */
+template <typename T, class Rep, class Period>
+size_t wait_any(
+    const std::vector<std::shared_ptr<T>>& toks,
+    const std::chrono::duration<Rep, Period>& relTime
+) {
+    using std::chrono::steady_clock;
+    if (toks.empty())
+        return 0;
+
+    auto absTime = steady_clock::now() + std::chrono::duration_cast<steady_clock::duration>(relTime);
+    auto latch = token_latch::create(toks, 1);
+    latch->wait_until(absTime);
+    return latch->first();
+}
+
+/////////////////////////////////////////////////////////////////////////////
+}  // namespace mqtt
+
+#endif  // __mqtt_token_wait_h
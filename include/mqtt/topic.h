@@ -24,11 +24,14 @@
 #ifndef __mqtt_topic_h
 #define __mqtt_topic_h
 
+#include <iterator>
+#include <string_view>
 #include <vector>
 
 #include "MQTTAsync.h"
 #include "mqtt/delivery_token.h"
 #include "mqtt/message.h"
+#include "mqtt/message_template.h"
 #include "mqtt/subscribe_options.h"
 #include "mqtt/types.h"
 
@@ -38,19 +41,126 @@ class iasync_client;
 
 /////////////////////////////////////////////////////////////////////////////
 
+/**
+ * A view of the individual fields of an MQTT topic or filter string.
+ *
+ * This splits the string lazily as it's iterated, producing each field as
+ * a `string_view` into the original, so it doesn't make any allocations.
+ * The string must outlive the view and its iterators. As with
+ * `topic::split()`, an empty string has no fields.
+ */
+class topic_fields
+{
+    /** The topic string */
+    std::string_view topic_;
+
+public:
+    /** Forward iterator over the fields */
+    class iterator
+    {
+        /** The topic string */
+        std::string_view topic_;
+        /** The position of the current field, or npos at the end */
+        size_t pos_;
+        /** The length of the current field */
+        size_t len_;
+
+        friend class topic_fields;
+
+        iterator(std::string_view topic, size_t pos) : topic_{topic}, pos_{pos}, len_{0} {
+            if (pos_ != std::string_view::npos)
+                find_end();
+        }
+        /** Finds the length of the field at the current position */
+        void find_end() noexcept {
+            auto end = topic_.find('/', pos_);
+            len_ = (end == std::string_view::npos) ? (topic_.size() - pos_) : (end - pos_);
+        }
+
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = std::string_view;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const std::string_view*;
+        using reference = std::string_view;
+
+        /**
+         * Gets the current field.
+         * @return The current field.
+         */
+        std::string_view operator*() const noexcept { return topic_.substr(pos_, len_); }
+        /**
+         * Prefix increment operator.
+         * @return An iterator pointing to the next field.
+         */
+        iterator& operator++() noexcept {
+            pos_ += len_;
+            if (pos_ >= topic_.size())
+                pos_ = std::string_view::npos;
+            else {
+                ++pos_;
+                find_end();
+            }
+            return *this;
+        }
+        /**
+         * Postfix increment operator.
+         * @return An iterator pointing to the previous field.
+         */
+        iterator operator++(int) noexcept {
+            auto tmp = *this;
+            ++(*this);
+            return tmp;
+        }
+        /**
+         * Determines if two iterators refer to the same field.
+         * @param other The other iterator.
+         * @return @em true if they refer to the same field.
+         */
+        bool operator==(const iterator& other) const noexcept { return pos_ == other.pos_; }
+        /**
+         * Determines if two iterators refer to different fields.
+         * @param other The other iterator.
+         * @return @em true if they refer to different fields.
+         */
+        bool operator!=(const iterator& other) const noexcept { return pos_ != other.pos_; }
+    };
+
+    /**
+     * Creates a view of the fields of a topic.
+     * @param topic A slash-delimited MQTT topic or filter string.
+     */
+    explicit topic_fields(std::string_view topic) noexcept : topic_{topic} {}
+    /**
+     * Gets an iterator to the first field.
+     * @return An iterator to the first field.
+     */
+    iterator begin() const noexcept {
+        return iterator{topic_, topic_.empty() ? std::string_view::npos : 0};
+    }
+    /**
+     * Gets an iterator past the last field.
+     * @return An iterator past the last field.
+     */
+    iterator end() const noexcept { return iterator{topic_, std::string_view::npos}; }
+};
+
+/////////////////////////////////////////////////////////////////////////////
+
 /**
  * Represents a topic destination, used for publish/subscribe messaging.
+ *
+ * The topic is a handle for publishing to the same topic over and over.
+ * It holds a @ref message_template for the topic, so all the messages it
+ * publishes share the one copy of the topic name and any MQTT v5
+ * properties, and making one only allocates the message and its payload.
  */
 class topic
 {
     /** The client to which this topic is connected */
     iasync_client& cli_;
-    /** The topic name */
-    string name_;
-    /** The default QoS */
-    int qos_;
-    /** The default retained flag */
-    bool retained_;
+    /** The name, default QoS, retained flag, and properties */
+    message_template tmpl_;
 
 public:
     /** A smart/shared pointer to this class. */
@@ -58,6 +168,9 @@ public:
     /** A smart/shared pointer to this class. */
     using const_ptr_t = std::shared_ptr<const topic>;
 
+    /** The maximum length of a topic name or filter, in bytes */
+    static constexpr size_t MAX_LENGTH = 65535;
+
     /**
      * Construct an MQTT topic destination for messages.
      * @param cli Client to which the topic is attached
@@ -69,7 +182,21 @@ public:
         iasync_client& cli, const string& name, int qos = message::DFLT_QOS,
         bool retained = message::DFLT_RETAINED
     )
-        : cli_(cli), name_(name), qos_(qos), retained_(retained) {}
+        : cli_(cli), tmpl_(string_ref{name}, qos, retained) {}
+    /**
+     * Construct an MQTT topic destination for messages, with properties.
+     * @param cli Client to which the topic is attached
+     * @param name The topic string
+     * @param qos The default QoS for publishing.
+     * @param retained The default retained flag for the topic.
+     * @param props The MQTT v5 properties for the messages published to
+     *  			the topic.
+     */
+    topic(
+        iasync_client& cli, const string& name, int qos, bool retained,
+        const properties& props
+    )
+        : cli_(cli), tmpl_(string_ref{name}, qos, retained, props) {}
     /**
      * Creates a new topic
      * @param cli Client to which the topic is attached
@@ -93,7 +220,12 @@ public:
      * Gets the name of the topic.
      * @return The name of the topic.
      */
-    const string& get_name() const { return name_; }
+    const string& get_name() const { return tmpl_.get_topic(); }
+    /**
+     * Gets the template for the messages published to the topic.
+     * @return The message template.
+     */
+    const message_template& get_template() const { return tmpl_; }
     /**
      * Splits a topic string into individual fields.
      *
@@ -101,29 +233,59 @@ public:
      * @return A vector containing the fields of the topic.
      */
     static std::vector<std::string> split(const std::string& topic);
+    /**
+     * Gets a view of the individual fields of a topic string, without
+     * copying them.
+     *
+     * @param topic A slash-delimited MQTT topic string.
+     * @return A view that iterates over the fields of the topic.
+     */
+    static topic_fields split_view(std::string_view topic) noexcept {
+        return topic_fields{topic};
+    }
+    /**
+     * Determines if a string is a valid topic name, to publish to.
+     *
+     * A topic name can't be empty or longer than @ref MAX_LENGTH bytes,
+     * must be well-formed UTF-8, and can't contain a null character or
+     * either of the wildcards, '+' and '#'. The string is checked a block
+     * at a time with SIMD instructions, where the compiler targets them,
+     * as long as it's plain ASCII.
+     *
+     * @param name The topic name.
+     * @return @em true if the name is valid to publish to.
+     */
+    static bool is_valid_name(std::string_view name) noexcept;
     /**
      * Gets the default quality of service for this topic.
      * @return The default quality of service for this topic.
      */
-    int get_qos() const { return qos_; }
+    int get_qos() const { return tmpl_.get_qos(); }
     /**
      * Gets the default retained flag used for this topic.
      * @return The default retained flag used for this topic.
      */
-    bool get_retained() const { return retained_; }
+    bool get_retained() const { return tmpl_.is_retained(); }
+    /**
+     * Gets the MQTT v5 properties for the messages published to the topic.
+     * @return The properties for the messages.
+     */
+    const properties& get_properties() const { return tmpl_.get_properties(); }
     /**
      * Sets the default quality of service for this topic.
      * @param qos The default quality of service for this topic.
      */
-    void set_qos(int qos) {
-        message::validate_qos(qos);
-        qos_ = qos;
-    }
+    void set_qos(int qos) { tmpl_.set_qos(qos); }
     /**
      * Sets the default retained flag used for this topic.
      * @param retained The default retained flag used for this topic.
      */
-    void set_retained(bool retained) { retained_ = retained; }
+    void set_retained(bool retained) { tmpl_.set_retained(retained); }
+    /**
+     * Sets the MQTT v5 properties for the messages published to the topic.
+     * @param props The properties for the messages.
+     */
+    void set_properties(const properties& props) { tmpl_.set_properties(props); }
     /**
      * Publishes a message on the topic using the default QoS and retained
      * flag.
@@ -173,7 +335,7 @@ public:
      * Returns a string representation of this topic.
      * @return The name of the topic
      */
-    string to_string() const { return name_; }
+    string to_string() const { return get_name(); }
 };
 
 /** A smart/shared pointer to a topic object. */
@@ -222,7 +384,19 @@ public:
      * @param s The string to check
      * @return @em true if `c` is a wildcard, "+" or "#"
      */
-    static bool is_wildcard(const string& s) { return s.size() == 1 && is_wildcard(s[0]); }
+    static bool is_wildcard(std::string_view s) { return s.size() == 1 && is_wildcard(s[0]); }
+    /**
+     * Determines if a string is a valid topic filter, to subscribe to.
+     *
+     * Like a topic name, a filter can't be empty or longer than
+     * topic::MAX_LENGTH bytes, must be well-formed UTF-8, and can't
+     * contain a null character. A wildcard must take up a whole field,
+     * and a '#' can only be the last field.
+     *
+     * @param filter The topic filter.
+     * @return @em true if the filter is valid to subscribe to.
+     */
+    static bool is_valid(std::string_view filter) noexcept;
     /**
      * Determines if the specified topic/filter contains any wildcards.
      *
@@ -241,11 +415,33 @@ public:
     /**
      * Determine if the topic matches this filter.
      *
+     * This doesn't make any allocations, and can take the topic of a
+     * message directly, as a `string_ref`.
+     *
      * @param topic An MQTT topic. It should not contain wildcards.
      * @return  @em true of the topic matches this filter, @em false
      *  		otherwise.
      */
-    bool matches(const string& topic) const;
+    bool matches(std::string_view topic) const;
+    /**
+     * Determine if the topic matches this filter, and get the parts of the
+     * topic that matched the wildcards.
+     *
+     * For each '+' in the filter, the captures get the field of the topic
+     * that it matched. For a trailing '#', they get the rest of the topic
+     * from that field on. So matching the filter `site/+/device/#` against
+     * the topic `site/a/device/b/temp` captures `a` and `b/temp`.
+     *
+     * The captures are views into the topic, which must outlive them. The
+     * vector is cleared first, and can be reused to avoid allocations.
+     * If the topic doesn't match, the contents are unspecified.
+     *
+     * @param topic An MQTT topic. It should not contain wildcards.
+     * @param captures Gets the parts of the topic matching the wildcards.
+     * @return @em true of the topic matches this filter, @em false
+     *  		otherwise.
+     */
+    bool match(std::string_view topic, std::vector<std::string_view>& captures) const;
 };
 
 /////////////////////////////////////////////////////////////////////////////
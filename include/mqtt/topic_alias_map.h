@@ -0,0 +1,124 @@
+/////////////////////////////////////////////////////////////////////////////
+/// @file topic_alias_map.h
+/// Declaration of MQTT topic_alias_map class
+/// @author Frank Pagliughi
+/////////////////////////////////////////////////////////////////////////////
+
+/*******************************************************************************
+ * Copyright (c) 2025 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+#ifndef __mqtt_topic_alias_map_h
+#define __mqtt_topic_alias_map_h
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <unordered_map>
+#include <vector>
+
+#include "mqtt/types.h"
+
+namespace mqtt {
+
+/////////////////////////////////////////////////////////////////////////////
+
+/**
+ * The MQTT v5 topic aliases that a client has assigned for publishing.
+ *
+ * Once an alias is sent to the server along with a topic, later messages
+ * to that topic can be sent with just the alias and an empty topic name.
+ * The server sets the most aliases that it will accept on a connection,
+ * and the application can set a lower limit. When all of the aliases are
+ * in use, the one for the topic that was least recently published is
+ * given to the new topic.
+ * @par
+ * Aliases only apply to a single connection, so the map must be reset
+ * each time the client connects.
+ * @par
+ * The map is not thread safe. The client holds a lock while it gets the
+ * alias and sends the message, so that the first message with a new alias
+ * is always sent before the ones with just the alias.
+ */
+class topic_alias_map
+{
+    /** An alias, and the position of its topic in the usage list */
+    struct entry
+    {
+        uint16_t alias;
+        std::list<const string*>::iterator pos;
+    };
+
+    /** The most aliases the application wants to use */
+    size_t maxAliases_;
+    /** The most aliases that can be used on the current connection */
+    size_t limit_{0};
+    /** The aliases, by topic */
+    std::unordered_map<string, entry> aliases_;
+    /** The topics, from most to least recently used */
+    std::list<const string*> lru_;
+    /** Aliases that were given up, and can be assigned again */
+    std::vector<uint16_t> free_;
+
+public:
+    /**
+     * Creates a map, which has no aliases until it is reset for a
+     * connection.
+     * @param maxAliases The most aliases to use on any connection.
+     */
+    explicit topic_alias_map(size_t maxAliases) : maxAliases_{maxAliases} {}
+    /**
+     * Gets the most aliases to use on any connection.
+     * @return The most aliases to use on any connection.
+     */
+    size_t max_aliases() const { return maxAliases_; }
+    /**
+     * Gets the most aliases that can be used on the current connection.
+     * @return The smaller of the application's and the server's limits.
+     */
+    size_t limit() const { return limit_; }
+    /**
+     * Gets the number of aliases that are assigned.
+     * @return The number of aliases that are assigned.
+     */
+    size_t size() const { return aliases_.size(); }
+    /**
+     * Removes all the aliases, and sets the limit for a new connection.
+     * @param serverMax The Topic Alias Maximum from the server, or zero
+     *  				if the server doesn't accept aliases.
+     */
+    void reset(size_t serverMax);
+    /**
+     * Gets the alias for a topic, assigning one if it has none.
+     * @param topic The topic name.
+     * @param known Set @em true if the alias was assigned to the topic
+     *  			earlier, so the server already knows it, or @em false
+     *  			if it is new, and must be sent along with the topic.
+     * @return The alias, or zero if aliases can't be used.
+     */
+    uint16_t get(const string& topic, bool& known);
+    /**
+     * Removes the alias for a topic.
+     * This is used when the message that would have told the server about
+     * a new alias could not be sent.
+     * @param topic The topic name.
+     */
+    void remove(const string& topic);
+};
+
+/////////////////////////////////////////////////////////////////////////////
+}  // namespace mqtt
+
+#endif  // __mqtt_topic_alias_map_h
@@ -24,11 +24,14 @@
 #ifndef __mqtt_topic_matcher_h
 #define __mqtt_topic_matcher_h
 
-#include <forward_list>
+#include <deque>
+#include <functional>
 #include <initializer_list>
-#include <map>
+#include <list>
 #include <memory>
 #include <string>
+#include <string_view>
+#include <unordered_map>
 #include <vector>
 
 #include "mqtt/topic.h"
@@ -72,7 +75,10 @@ namespace mqtt {
  *
  *<https://github.com/eclipse/paho.mqtt.python/blob/master/src/paho/mqtt/matcher.py>
  *
- * which use a prefix tree (trie) to store the values.
+ * which use a prefix tree (trie) to store the values. The children of each
+ * node are kept in a small, open-addressed hash table keyed by the level
+ * name, and the nodes themselves are allocated contiguously from a pool
+ * in the collection.
  *
  * For example, if you had a `topic_mapper<int>` and you inserted:
  * @code
@@ -102,7 +108,15 @@ namespace mqtt {
  * The more common use case is the `match_iterator`, returned by the
  * `topic_matcher::matches(string)` method. This is an optimized search
  * iterator for finding all the filters and values that match the specified
- * topic string.
+ * topic string. It keeps a single copy of the topic, and tracks the
+ * fields still to be searched as offsets into it.
+ *
+ * For the hot path, such as routing every incoming message, the
+ * `for_each_match()` method visits the matching items without making any
+ * heap allocations at all. If the same topics are matched over and over,
+ * a bounded cache of the results can be enabled with
+ * `set_match_cache_size()`, so that matching a recently seen topic is a
+ * single hash lookup.
  */
 template <typename T>
 class topic_matcher
@@ -118,45 +132,350 @@ public:
     using mapped_ptr = std::unique_ptr<mapped_type>;
 
 private:
+    struct node;
+
+    /**
+     * The children of a node, mapped by the next field of the topic.
+     *
+     * This is an open-addressed hash table with linear probing, which is
+     * searched directly with a `string_view` of the field. It's grown as
+     * needed, but never shrinks, other than when it's pruned.
+     */
+    class child_map
+    {
+        /** An entry in the table. It's empty if the node is null. */
+        struct slot
+        {
+            string key;
+            size_t hash = 0;
+            node* nd = nullptr;
+        };
+
+        /** The table. The size is always zero or a power of two. */
+        std::vector<slot> slots_;
+        /** The number of children in the table */
+        size_t n_ = 0;
+
+        static size_t hash_of(std::string_view key) noexcept {
+            return std::hash<std::string_view>{}(key);
+        }
+        /** Finds the slot for the key, or the empty slot where it belongs */
+        size_t find_slot(std::string_view key, size_t hash) const noexcept {
+            const size_t mask = slots_.size() - 1;
+            for (size_t i = hash & mask;; i = (i + 1) & mask) {
+                const auto& sl = slots_[i];
+                if (!sl.nd || (sl.hash == hash && sl.key == key))
+                    return i;
+            }
+        }
+        /** Moves the entries into a new table of the specified size */
+        void rehash(size_t n) {
+            std::vector<slot> old(n);
+            old.swap(slots_);
+            for (auto& sl : old) {
+                if (sl.nd)
+                    slots_[find_slot(sl.key, sl.hash)] = std::move(sl);
+            }
+        }
+
+    public:
+        /** Determines if there are no children */
+        bool empty() const noexcept { return n_ == 0; }
+        /** Gets the number of children */
+        size_t size() const noexcept { return n_; }
+        /**
+         * Finds the child for the field.
+         * @param key The field of the topic.
+         * @return The child node, or @em nullptr if not found.
+         */
+        node* find(std::string_view key) const noexcept {
+            return n_ == 0 ? nullptr : slots_[find_slot(key, hash_of(key))].nd;
+        }
+        /**
+         * Adds a child for a field that is not already in the map.
+         * @param key The field of the topic.
+         * @param nd The child node.
+         */
+        void insert(std::string_view key, node* nd) {
+            if (4 * (n_ + 1) > 3 * slots_.size())
+                rehash(slots_.empty() ? 4 : 2 * slots_.size());
+            auto hash = hash_of(key);
+            auto& sl = slots_[find_slot(key, hash)];
+            sl.key = string{key};
+            sl.hash = hash;
+            sl.nd = nd;
+            ++n_;
+        }
+        /**
+         * Calls a function for each child node.
+         * @param fn The function, as `fn(node*)`.
+         */
+        template <typename Func>
+        void for_each(Func fn) const {
+            for (const auto& sl : slots_) {
+                if (sl.nd)
+                    fn(sl.nd);
+            }
+        }
+        /**
+         * Calls a function for each child node, with its field.
+         * @param fn The function, as `fn(const string&, node*)`.
+         */
+        template <typename Func>
+        void for_each_entry(Func fn) const {
+            for (const auto& sl : slots_) {
+                if (sl.nd)
+                    fn(sl.key, sl.nd);
+            }
+        }
+        /**
+         * Removes the children that match a predicate.
+         * @param pred The predicate, as `pred(node*)`, returning @em true
+         *  		   if the child should be removed.
+         */
+        template <typename Pred>
+        void erase_if(Pred pred) {
+            size_t n = 0;
+            for (auto& sl : slots_) {
+                if (sl.nd && pred(sl.nd)) {
+                    sl = slot{};
+                    ++n;
+                }
+            }
+            if (n != 0) {
+                n_ -= n;
+                rehash(n_ == 0 ? 0 : slots_.size());
+            }
+        }
+        /** Removes all the children */
+        void clear() noexcept {
+            slots_.clear();
+            n_ = 0;
+        }
+    };
+
     /**
      * The nodes of the collection.
      */
     struct node
     {
-        using ptr_t = std::unique_ptr<node>;
-        using map_t = std::map<string, ptr_t>;
-
         /** The value that matches the topic at this node, if any */
         value_ptr content;
         /** Child nodes mapped by the next field of the topic */
-        map_t children;
+        child_map children;
 
-        /** Creates a new, empty node */
-        static ptr_t create() { return std::make_unique<node>(); }
         /** Determines if this node is empty (no content or children) */
         bool empty() const { return !content && children.empty(); }
+    };
 
-        /** Removes the empty nodes under this one. */
-        void prune() {
-            for (auto& child : children) {
-                child.second->prune();
-            }
+    /** The pool of nodes. A deque keeps them in place as it grows. */
+    std::deque<node> nodes_;
+    /** Nodes that were pruned, and can be reused */
+    std::vector<node*> freeNodes_;
+    /** The root node of the collection */
+    node* root_;
 
-            for (auto child = children.cbegin(); child != children.cend();) {
-                if (child->second->empty()) {
-                    child = children.erase(child);
-                }
-                else {
-                    ++child;
-                }
+    /** The cached matches for a topic */
+    struct cache_entry
+    {
+        string topic;
+        std::vector<value_type*> vals;
+    };
+    using cache_list = std::list<cache_entry>;
+
+    /** The maximum number of topics in the match cache (zero to disable) */
+    size_t cacheSize_{0};
+    /** The cached results, with the most recently used first */
+    cache_list cache_;
+    /** The cached results, indexed by the topic in the entry */
+    std::unordered_map<std::string_view, typename cache_list::iterator> cacheIdx_;
+
+    /** Clears the match cache */
+    void invalidate_cache() noexcept {
+        cacheIdx_.clear();
+        cache_.clear();
+    }
+    /**
+     * Gets the cached matches for the topic, searching for them if they're
+     * not already in the cache.
+     * @param topic The topic to match.
+     * @return The values that match the topic.
+     */
+    const std::vector<value_type*>& cached_matches(std::string_view topic) {
+        if (auto it = cacheIdx_.find(topic); it != cacheIdx_.end()) {
+            cache_.splice(cache_.begin(), cache_, it->second);
+            return it->second->vals;
+        }
+
+        if (cache_.size() >= cacheSize_) {
+            cacheIdx_.erase(cache_.back().topic);
+            cache_.pop_back();
+        }
+
+        cache_.push_front(cache_entry{string{topic}, {}});
+        auto& entry = cache_.front();
+        auto visit = [&entry](value_type& val) {
+            entry.vals.push_back(&val);
+            return true;
+        };
+        visit_matches(root_, topic, first_field(topic), true, visit);
+        cacheIdx_.emplace(entry.topic, cache_.begin());
+        return entry.vals;
+    }
+
+    /** Gets an empty node from the pool */
+    node* create_node() {
+        if (freeNodes_.empty())
+            return &nodes_.emplace_back();
+        auto nd = freeNodes_.back();
+        freeNodes_.pop_back();
+        return nd;
+    }
+    /** Removes the empty nodes under this one, returning them to the pool */
+    void prune(node* nd) {
+        nd->children.for_each([this](node* child) { prune(child); });
+        nd->children.erase_if([this](node* child) {
+            if (!child->empty())
+                return false;
+            freeNodes_.push_back(child);
+            return true;
+        });
+    }
+    /** Finds the node for a filter, optionally creating it */
+    node* find_node(std::string_view filter, bool create) {
+        auto nd = root_;
+        for (auto pos = first_field(filter); pos != NO_FIELDS;) {
+            auto field = next_field(filter, pos);
+            auto child = nd->children.find(field);
+            if (!child) {
+                if (!create)
+                    return nullptr;
+                child = create_node();
+                nd->children.insert(field, child);
             }
+            nd = child;
         }
-    };
-    using node_ptr = typename node::ptr_t;
-    using node_map = typename node::map_t;
+        return nd;
+    }
 
-    /** The root node of the collection */
-    node_ptr root_;
+    /** Position value signaling that all the fields have been searched */
+    static constexpr size_t NO_FIELDS = string::npos;
+
+    /**
+     * Gets the position of the first field in the topic.
+     * @param topic The topic.
+     * @return The position of the first field, or @em NO_FIELDS if the
+     *  	   topic is empty.
+     */
+    static size_t first_field(std::string_view topic) noexcept {
+        return topic.empty() ? NO_FIELDS : 0;
+    }
+    /**
+     * Gets the next field in the topic, and advances the position past it.
+     * @param topic The topic.
+     * @param pos The position of the field. On return this is the position
+     *  		  of the following field, or @em NO_FIELDS if this was the
+     *  		  last one.
+     * @return The field at the position.
+     */
+    static std::string_view next_field(std::string_view topic, size_t& pos) noexcept {
+        auto end = topic.find('/', pos);
+        auto field = topic.substr(pos, (end == NO_FIELDS) ? end : (end - pos));
+        pos = (end == NO_FIELDS) ? end : (end + 1);
+        return field;
+    }
+    /**
+     * Recursively visits the items that match a topic.
+     * @param nd The node to search.
+     * @param topic The topic being matched.
+     * @param pos The position of the next field of the topic to match.
+     * @param first Whether this is the root node.
+     * @param fn The function to call for each match. It returns @em false
+     *  		 to stop the search.
+     * @return @em false if the search was stopped, @em true otherwise.
+     */
+    template <typename Func>
+    static bool visit_matches(
+        node* nd, std::string_view topic, size_t pos, bool first, Func& fn
+    ) {
+        if (pos == NO_FIELDS)
+            return !nd->content || fn(*nd->content);
+
+        auto field = next_field(topic, pos);
+        const auto& children = nd->children;
+        node* child;
+
+        if ((child = children.find(field)) && !visit_matches(child, topic, pos, false, fn))
+            return false;
+
+        // Topics starting with '$' don't match wildcards in the first field
+        if (!first || field.empty() || field[0] != '$') {
+            if ((child = children.find("+")) && !visit_matches(child, topic, pos, false, fn))
+                return false;
+
+            // By definition, a '#' is a terminating leaf
+            if ((child = children.find("#")) && child->content && !fn(*child->content))
+                return false;
+        }
+        return true;
+    }
+
+    /**
+     * Recursively visits all the items at or below a node.
+     * @param nd The node to start from.
+     * @param first Whether this is the root node, in which case the
+     *  			children with fields starting with '$' are skipped.
+     * @param fn The function to call for each item.
+     */
+    template <typename Func>
+    static void visit_all(node* nd, bool first, Func& fn) {
+        if (nd->content)
+            fn(*nd->content);
+        nd->children.for_each_entry([first, &fn](const string& key, node* child) {
+            if (!first || key.empty() || key[0] != '$')
+                visit_all(child, false, fn);
+        });
+    }
+    /**
+     * Recursively visits the items with keys that are matched by a filter.
+     * This is the reverse of visit_matches(), for a collection of topics.
+     * @param nd The node to search.
+     * @param filter The filter being matched.
+     * @param pos The position of the next field of the filter to match.
+     * @param first Whether this is the root node.
+     * @param fn The function to call for each match.
+     */
+    template <typename Func>
+    static void visit_filtered(
+        node* nd, std::string_view filter, size_t pos, bool first, Func& fn
+    ) {
+        if (pos == NO_FIELDS) {
+            if (nd->content)
+                fn(*nd->content);
+            return;
+        }
+
+        auto field = next_field(filter, pos);
+
+        if (field == "#") {
+            // A '#' also matches the parent level, like "a/#" matches "a"
+            if (!first && nd->content)
+                fn(*nd->content);
+            nd->children.for_each_entry([first, &fn](const string& key, node* child) {
+                if (!first || key.empty() || key[0] != '$')
+                    visit_all(child, false, fn);
+            });
+        }
+        else if (field == "+") {
+            nd->children.for_each_entry([&](const string& key, node* child) {
+                if (!first || key.empty() || key[0] != '$')
+                    visit_filtered(child, filter, pos, false, fn);
+            });
+        }
+        else if (auto child = nd->children.find(field)) {
+            visit_filtered(child, filter, pos, false, fn);
+        }
+    }
 
 public:
     /** Generic iterator over all items in the collection. */
@@ -179,9 +498,7 @@ public:
             nodes_.pop_back();
 
             // Push the children onto the stack for later
-            for (auto const& child : snode->children) {
-                nodes_.push_back(child.second.get());
-            }
+            snode->children.for_each([this](node* child) { nodes_.push_back(child); });
 
             // If there's a value in this node, use it;
             // otherwise keep looking.
@@ -278,19 +595,19 @@ public:
         {
             /** The current node being searched. */
             node* node_;
-            /** The fields of the topic still to be searched. */
-            std::forward_list<string> fields_;
+            /** The position of the next field of the topic to search. */
+            size_t pos_;
             /** Whether this is the first/root node */
             bool first_;
 
-            search_node(node* nd, const std::forward_list<string>& sy, bool first = false)
-                : node_{nd}, fields_{sy}, first_{first} {}
-            search_node(node* nd, std::forward_list<string>&& sy, bool first = false)
-                : node_{nd}, fields_{std::move(sy)}, first_{first} {}
+            search_node(node* nd, size_t pos, bool first = false)
+                : node_{nd}, pos_{pos}, first_{first} {}
         };
 
         /** The last-found value */
         value_type* pval_;
+        /** The topic being matched */
+        string topic_;
         /** The nodes still to be checked, used as a stack */
         std::vector<search_node> nodes_;
 
@@ -309,12 +626,12 @@ public:
                 return;
 
             // Get the next node to search.
-            auto snode = std::move(nodes_.back());
+            auto snode = nodes_.back();
             nodes_.pop_back();
 
             // If we're at the end of the topic fields, we either have a value,
             // or need to move on to the next node to search.
-            if (snode.fields_.empty()) {
+            if (snode.pos_ == NO_FIELDS) {
                 pval_ = snode.node_->content.get();
                 if (!pval_)
                     this->next();
@@ -322,15 +639,15 @@ public:
             }
 
             // Get the next field of the topic to search
-            auto field = std::move(snode.fields_.front());
-            snode.fields_.pop_front();
+            auto pos = snode.pos_;
+            auto field = next_field(topic_, pos);
 
-            typename node_map::iterator child;
-            const auto map_end = snode.node_->children.end();
+            const auto& children = snode.node_->children;
+            node* child;
 
             // Look for an exact match
-            if ((child = snode.node_->children.find(field)) != map_end) {
-                nodes_.push_back({child->second.get(), snode.fields_});
+            if ((child = children.find(field))) {
+                nodes_.push_back({child, pos});
             }
 
             // Topics starting with '$' don't match wildcards in the first field
@@ -339,15 +656,15 @@ public:
 
             if (!snode.first_ || field.empty() || field[0] != '$') {
                 // Look for a single-field wildcard match
-                if ((child = snode.node_->children.find("+")) != map_end) {
-                    nodes_.push_back({child->second.get(), snode.fields_});
+                if ((child = children.find("+"))) {
+                    nodes_.push_back({child, pos});
                 }
 
                 // Look for a terminating match
-                if ((child = snode.node_->children.find("#")) != map_end) {
+                if ((child = children.find("#"))) {
                     // By definition, a '#' is a terminating leaf
-                    pval_ = child->second->content.get();
-                    return;
+                    if ((pval_ = child->content.get()))
+                        return;
                 }
             }
 
@@ -358,10 +675,8 @@ public:
 
         match_iterator() : pval_{nullptr} {}
         match_iterator(value_type* pval) : pval_{pval} {}
-        match_iterator(node* root, const string& topic) : pval_{nullptr} {
-            auto v = topic::split(topic);
-            std::forward_list<string> fields{v.begin(), v.end()};
-            nodes_.push_back(search_node{root, std::move(fields), true});
+        match_iterator(node* root, std::string_view topic) : pval_{nullptr}, topic_{topic} {
+            nodes_.push_back(search_node{root, first_field(topic_), true});
             next();
         }
 
@@ -441,7 +756,7 @@ public:
     /**
      * Creates  new, empty collection.
      */
-    topic_matcher() : root_(node::create()) {}
+    topic_matcher() : root_(create_node()) {}
     /**
      * Creates a new collection with a list of key/value pairs.
      *
@@ -456,33 +771,31 @@ public:
      *
      * @param lst The list of key/value pairs to populate the collection.
      */
-    topic_matcher(std::initializer_list<value_type> lst) : root_(node::create()) {
+    topic_matcher(std::initializer_list<value_type> lst) : root_(create_node()) {
         for (const auto& v : lst) {
             insert(v);
         }
     }
+    /** Non-copyable, as the nodes refer to each other in the pool */
+    topic_matcher(const topic_matcher&) = delete;
+    topic_matcher& operator=(const topic_matcher&) = delete;
+    /** Move constructor */
+    topic_matcher(topic_matcher&&) = default;
+    /** Move assignment */
+    topic_matcher& operator=(topic_matcher&&) = default;
     /**
      * Determines if the collection is empty.
      * @return @em true if the collection is empty, @em false if it contains
      *         any filters.
      */
-    bool empty() const { return root_.empty(); }
+    bool empty() const { return root_->empty(); }
     /**
      * Inserts a new key/value pair into the collection.
      * @param val The value to place in the collection.
      */
     void insert(value_type&& val) {
-        auto nd = root_.get();
-        auto fields = topic::split(val.first);
-
-        for (const auto& field : fields) {
-            auto it = nd->children.find(field);
-            if (it == nd->children.end()) {
-                nd->children[field] = node::create();
-                it = nd->children.find(field);
-            }
-            nd = it->second.get();
-        }
+        invalidate_cache();
+        auto nd = find_node(val.first, true);
         nd->content = std::make_unique<value_type>(std::move(val));
     }
     /**
@@ -503,30 +816,47 @@ public:
      * @return A unique pointer to the value, if any.
      */
     mapped_ptr remove(const key_type& filter) {
-        auto nd = root_.get();
-        auto fields = topic::split(filter);
-
-        for (auto& field : fields) {
-            auto it = nd->children.find(field);
-            if (it == nd->children.end())
-                return mapped_ptr{};
+        auto nd = find_node(filter, false);
+        if (!nd)
+            return mapped_ptr{};
 
-            nd = it->second.get();
-        }
         value_ptr valpair;
         nd->content.swap(valpair);
+        if (valpair)
+            invalidate_cache();
 
         return (valpair) ? std::make_unique<mapped_type>(valpair->second) : mapped_ptr{};
     }
+    /**
+     * Gets the maximum number of topics kept in the match cache.
+     * @return The maximum number of topics kept in the match cache, or zero
+     *  	   if the cache is disabled.
+     */
+    size_t get_match_cache_size() const noexcept { return cacheSize_; }
+    /**
+     * Sets the maximum number of topics kept in the match cache.
+     *
+     * The cache maps recently matched topics to the values that matched
+     * them, and is used by the non-const `for_each_match()`. When it's
+     * full, the least recently used topic is dropped. The whole cache is
+     * cleared whenever a value is inserted or removed.
+     *
+     * @param n The maximum number of topics to keep in the cache. Zero
+     *  		disables the cache.
+     */
+    void set_match_cache_size(size_t n) {
+        cacheSize_ = n;
+        invalidate_cache();
+    }
     /**
      * Removes the empty nodes in the collection.
      */
-    void prune() { root_->prune(); }
+    void prune() { prune(root_); }
     /**
      * Gets an iterator to the full collection of filters.
      * @return An iterator to the full collection of filters.
      */
-    iterator begin() { return iterator{root_.get()}; }
+    iterator begin() { return iterator{root_}; }
     /**
      * Gets an iterator to the end of the collection of filters.
      * @return An iterator to the end of collection of filters.
@@ -543,7 +873,7 @@ public:
      * Gets a const iterator to the full collection of filters.
      * @return A const iterator to the full collection of filters.
      */
-    const_iterator cbegin() const { return const_iterator{root_.get()}; }
+    const_iterator cbegin() const { return const_iterator{root_}; }
     /**
      * Gets a const iterator to the end of the collection of filters.
      * @return A const iterator to the end of collection of filters.
@@ -555,16 +885,8 @@ public:
      * @return An iterator to the value if found, @em end() if not found.
      */
     iterator find(const key_type& filter) {
-        auto nd = root_.get();
-        auto fields = topic::split(filter);
-
-        for (auto& field : fields) {
-            auto it = nd->children.find(field);
-            if (it == nd->children.end())
-                return end();
-            nd = it->second.get();
-        }
-        return iterator{nd->content.get()};
+        auto nd = find_node(filter, false);
+        return nd ? iterator{nd->content.get()} : end();
     }
     /**
      * Gets a const pointer to the value at the requested key.
@@ -580,14 +902,16 @@ public:
      * @param topic The topic to search for matches.
      * @return An iterator that can find the matches to the topic.
      */
-    match_iterator matches(const string& topic) { return match_iterator(root_.get(), topic); }
+    match_iterator matches(std::string_view topic) {
+        return match_iterator(root_, topic);
+    }
     /**
      * Gets a const iterator that can find the matches to the topic.
      * @param topic The topic to search for matches.
      * @return A const iterator that can find the matches to the topic.
      */
-    const_match_iterator matches(const string& topic) const {
-        return match_iterator(root_.get(), topic);
+    const_match_iterator matches(std::string_view topic) const {
+        return match_iterator(root_, topic);
     }
     /**
      * Gets an iterator for the end of the collection.
@@ -613,7 +937,73 @@ public:
      * @return Whether there are any matches for the topic in the
      *         collection.
      */
-    bool has_match(const string& topic) { return matches(topic) != matches_cend(); }
+    bool has_match(std::string_view topic) const {
+        bool found = false;
+        auto fn = [&found](const value_type&) {
+            found = true;
+            return false;
+        };
+        visit_matches(root_, topic, first_field(topic), true, fn);
+        return found;
+    }
+    /**
+     * Calls a function for each item that matches the topic.
+     *
+     * This is the fastest way to find the matches, as it doesn't make any
+     * heap allocations. The items are visited in no particular order.
+     *
+     * If the match cache is enabled, the matches are taken from the cache,
+     * when the topic is in it, and the topic is added when it is not. The
+     * function must not modify the collection.
+     *
+     * @param topic The topic to search for matches.
+     * @param fn The function to call with each matching item, as
+     *  		 `fn(value_type&)`.
+     */
+    template <typename Func>
+    void for_each_match(std::string_view topic, Func fn) {
+        if (cacheSize_ != 0) {
+            for (auto pval : cached_matches(topic)) fn(*pval);
+            return;
+        }
+        auto visit = [&fn](value_type& val) {
+            fn(val);
+            return true;
+        };
+        visit_matches(root_, topic, first_field(topic), true, visit);
+    }
+    /**
+     * Calls a function for each item that matches the topic.
+     * @param topic The topic to search for matches.
+     * @param fn The function to call with each matching item, as
+     *  		 `fn(const value_type&)`.
+     */
+    template <typename Func>
+    void for_each_match(std::string_view topic, Func fn) const {
+        auto visit = [&fn](const value_type& val) {
+            fn(val);
+            return true;
+        };
+        visit_matches(root_, topic, first_field(topic), true, visit);
+    }
+    /**
+     * Calls a function for each item with a key matched by a filter.
+     *
+     * This is the reverse of for_each_match(). It treats the keys in the
+     * collection as topics, and finds the ones that the filter would
+     * match, following the wildcards in the filter down the tree. So the
+     * cost depends on the number of topics that match, rather than the
+     * size of the collection. The items are visited in no particular
+     * order.
+     *
+     * @param filter The topic filter, which may have wildcards.
+     * @param fn The function to call with each matching item, as
+     *  		 `fn(const value_type&)`.
+     */
+    template <typename Func>
+    void for_each_filtered(std::string_view filter, Func fn) const {
+        visit_filtered(root_, filter, first_field(filter), true, fn);
+    }
 };
 
 /////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,233 @@
+/////////////////////////////////////////////////////////////////////////////
+/// @file topic_stats.h
+/// Declaration of MQTT topic_stats class
+/// @author Frank Pagliughi
+/////////////////////////////////////////////////////////////////////////////
+
+/*******************************************************************************
+ * Copyright (c) 2025 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+#ifndef __mqtt_topic_stats_h
+#define __mqtt_topic_stats_h
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <initializer_list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+#include "mqtt/concurrent_topic_matcher.h"
+#include "mqtt/message.h"
+
+namespace mqtt {
+
+/////////////////////////////////////////////////////////////////////////////
+
+/**
+ * The traffic counted for one of the topic filters of a @ref topic_stats.
+ * The bytes count the topics and payloads of the messages.
+ */
+struct topic_traffic
+{
+    /** The topic filter */
+    string filter;
+    /** The number of messages received on topics matching the filter */
+    uint64_t msgsReceived{0};
+    /** The number of bytes received on topics matching the filter */
+    uint64_t bytesReceived{0};
+    /** The number of messages published to topics matching the filter */
+    uint64_t msgsPublished{0};
+    /** The number of bytes published to topics matching the filter */
+    uint64_t bytesPublished{0};
+};
+
+/////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Counts the messages and bytes sent and received, for each of a set of
+ * topic filters.
+ *
+ * When this is given to a client in the create options, the client
+ * counts each message that it sends or receives against every filter
+ * that matches its topic, so the traffic can be broken down by the parts
+ * of the topic space, such as by the subscriptions, rather than just for
+ * the whole client. The counts are reported in the client's statistics.
+ * A message that matches more than one filter is counted in each of them,
+ * and one that matches none isn't counted at all.
+ * @par
+ * The filters are kept in a @ref concurrent_topic_matcher, so counting a
+ * message only searches a snapshot of them, without a lock. The counts
+ * for each filter are split into a few stripes, each on its own cache
+ * line, and each thread adds into its own stripe with a relaxed atomic
+ * increment, so the threads of a number of clients don't contend for the
+ * counters. They're merged when they are read.
+ * @par
+ * For rates, read the counts periodically and divide the difference by
+ * the time between the reads, or by the elapsed() time since the counts
+ * started.
+ * @par
+ * It can be shared by a number of clients, and is safe to use from any
+ * thread. Changing the filters is relatively expensive, so they should
+ * be set up front.
+ *
+ * @code
+ *     auto stats = mqtt::topic_stats::create({"sensors/#", "cmd/#"});
+ *     auto cli = mqtt::async_client{
+ *         mqtt::create_options_builder()
+ *             .server_uri("mqtt://localhost:1883")
+ *             .topic_stats(stats)
+ *             .finalize()
+ *     };
+ *     ...
+ *     for (const auto& t : stats->get_traffic())
+ *         std::cout << t.filter << ": " << t.msgsReceived << std::endl;
+ * @endcode
+ */
+class topic_stats
+{
+    /** The assumed size of a cache line, to keep the stripes apart */
+    static constexpr size_t CACHE_LINE_SIZE = 64;
+    /** The number of stripes of counters for each filter */
+    static constexpr size_t N_STRIPES = 8;
+
+    /** One stripe of the counters for a filter */
+    struct alignas(CACHE_LINE_SIZE) counters
+    {
+        std::atomic<uint64_t> msgsReceived{0};
+        std::atomic<uint64_t> bytesReceived{0};
+        std::atomic<uint64_t> msgsPublished{0};
+        std::atomic<uint64_t> bytesPublished{0};
+    };
+
+    /** The counters for a filter */
+    struct group
+    {
+        counters stripes[N_STRIPES];
+    };
+
+    /** The counters, by topic filter */
+    concurrent_topic_matcher<std::shared_ptr<group>> groups_;
+    /** Lock for the start time */
+    mutable std::mutex lock_;
+    /** The time the counts started */
+    std::chrono::steady_clock::time_point startTime_;
+
+    /** Gets the stripe of counters for the calling thread */
+    static size_t stripe() noexcept;
+    /** Merges the stripes of a group into a snapshot */
+    static topic_traffic merge(const string& filter, const group& grp);
+
+public:
+    /** Smart/shared pointer to an object of this class. */
+    using ptr_t = std::shared_ptr<topic_stats>;
+
+    /**
+     * Creates a set of counters without any filters.
+     */
+    topic_stats() : startTime_{std::chrono::steady_clock::now()} {}
+    /**
+     * Creates a set of counters for the filters.
+     * @param filters The topic filters to count.
+     */
+    explicit topic_stats(std::initializer_list<string> filters);
+    /**
+     * Creates a set of counters for the filters.
+     * @param filters The topic filters to count.
+     * @return A shared pointer to the new counters.
+     */
+    static ptr_t create(std::initializer_list<string> filters = {}) {
+        return std::make_shared<topic_stats>(filters);
+    }
+    /**
+     * Adds a topic filter to count.
+     * @param filter The topic filter.
+     * @return @em true if the filter was added, @em false if it was
+     *  	   already being counted.
+     */
+    bool add_filter(const string& filter);
+    /**
+     * Stops counting a topic filter.
+     * @param filter The topic filter.
+     * @return @em true if the filter was being counted.
+     */
+    bool remove_filter(const string& filter);
+    /**
+     * Determines if there are no filters.
+     * @return @em true if there are no filters.
+     */
+    bool empty() const { return groups_.empty(); }
+    /**
+     * Counts a message received from the server.
+     * @param topic The topic of the message.
+     * @param nbytes The size of the topic and payload of the message.
+     */
+    void count_received(std::string_view topic, size_t nbytes);
+    /**
+     * Counts a message received from the server.
+     * @param msg The message.
+     */
+    void count_received(const message& msg) {
+        const auto& topic = msg.get_topic();
+        count_received(topic, topic.size() + msg.get_payload_ref().size());
+    }
+    /**
+     * Counts a message published to the server.
+     * @param topic The topic of the message.
+     * @param nbytes The size of the topic and payload of the message.
+     */
+    void count_published(std::string_view topic, size_t nbytes);
+    /**
+     * Counts a message published to the server.
+     * @param msg The message.
+     */
+    void count_published(const message& msg) {
+        const auto& topic = msg.get_topic();
+        count_published(topic, topic.size() + msg.get_payload_ref().size());
+    }
+    /**
+     * Gets a snapshot of the counts for all the filters.
+     * @return The counts for each filter, sorted by the filter.
+     */
+    std::vector<topic_traffic> get_traffic() const;
+    /**
+     * Gets a snapshot of the counts for one of the filters.
+     * @param filter The topic filter.
+     * @return The counts for the filter, if it's being counted.
+     */
+    std::optional<topic_traffic> get_traffic(const string& filter) const;
+    /**
+     * Gets the time since the counts started, when the object was created
+     * or last reset.
+     * @return The time since the counts started.
+     */
+    std::chrono::steady_clock::duration elapsed() const;
+    /**
+     * Resets all the counts to zero, keeping the filters.
+     */
+    void reset();
+};
+
+/** Smart/shared pointer to a set of topic counters */
+using topic_stats_ptr = topic_stats::ptr_t;
+
+/////////////////////////////////////////////////////////////////////////////
+}  // namespace mqtt
+
+#endif  // __mqtt_topic_stats_h
@@ -19,13 +19,25 @@
 
 #include "mqtt/async_client.h"
 
+#include <algorithm>
+#include <cerrno>
 #include <chrono>
 #include <condition_variable>
+#include <cstdint>
 #include <cstdio>
 #include <cstring>
 #include <mutex>
 #include <thread>
 
+#if defined(__linux__)
+    #include <sys/eventfd.h>
+#endif
+
+#if !defined(_WIN32)
+    #include <fcntl.h>
+    #include <unistd.h>
+#endif
+
 #include "mqtt/disconnect_options.h"
 #include "mqtt/message.h"
 #include "mqtt/response_options.h"
@@ -82,9 +94,103 @@ void async_client::create()
     }
     if (rc != MQTTASYNC_SUCCESS)
         throw exception(rc);
+
+    if (auto mr = opts.get_memory_resource(); mr)
+        msgPool_ = message_pool::create(mr, opts.get_message_pool_size());
+    else if (opts.get_message_pool_size() > 0)
+        msgPool_ = message_pool::create(opts.get_message_pool_size());
+
+    if (opts.get_token_pool_size() > 0)
+        tokPool_ = message_pool::create(opts.get_token_pool_size());
+
+    if (opts.get_max_interned_topics() > 0)
+        topicTbl_ = string_intern::create(opts.get_max_interned_topics());
+
+    if (opts.get_max_topic_aliases() > 0)
+        topicAliases_ = std::make_unique<topic_alias_map>(opts.get_max_topic_aliases());
+
+    flowControl_ = opts.get_flow_control();
+    restoreSubs_ = opts.get_restore_subscriptions();
+    loopback_ = opts.get_loopback();
+    manualAck_ = opts.get_manual_ack();
+    maxUnacked_ = opts.get_max_unacked();
+
+    retainedCache_ = opts.get_retained_cache();
+    shaper_ = opts.get_publish_shaper();
+    dedupFilter_ = opts.get_dedup_filter();
+    seqTracker_ = opts.get_sequence_tracker();
+    topicStats_ = opts.get_topic_stats();
+    sampler_ = opts.get_message_sampler();
+    reassembler_ = opts.get_chunk_reassembler();
+
+    if ((offlineBuf_ = opts.get_offline_buffer()))
+        drainThread_ = std::thread([this] { run_drain(); });
+
+    overflowPolicy_ = opts.get_overflow_policy();
+    memBudget_ = std::make_unique<memory_budget>(opts.get_max_memory());
+
+    if (opts.get_max_pending_messages() > 0 || opts.get_max_pending_bytes() > 0) {
+        pubWindow_ = std::make_unique<publish_window>(
+            opts.get_max_pending_messages(), opts.get_max_pending_bytes()
+        );
+    }
 }
 
-async_client::~async_client() { MQTTAsync_destroy(&cli_); }
+async_client::~async_client()
+{
+    // No deadline should fire while the client goes away
+    timers_.reset();
+
+    stop_race();
+    {
+        guard g(reconnLock_);
+        reconnStop_ = true;
+    }
+    reconnCond_.notify_all();
+    if (reconnThread_.joinable())
+        reconnThread_.join();
+    {
+        guard g(drainLock_);
+        drainStop_ = true;
+    }
+    drainCond_.notify_all();
+    if (drainThread_.joinable())
+        drainThread_.join();
+
+    // Anyone waiting on a message that was held back would wait forever
+    fail_deferred(MQTTASYNC_OPERATION_INCOMPLETE);
+
+    // The same goes for those in the offline buffer, which can outlive the
+    // client, but mustn't keep tokens that refer to it.
+    if (offlineBuf_) {
+        for (auto& tok : offlineBuf_->release_tokens()) {
+            MQTTAsync_failureData rsp{};
+            rsp.code = MQTTASYNC_OPERATION_INCOMPLETE;
+            tok->on_failure(&rsp);
+        }
+    }
+
+    // And for the messages held by the shaper, now that no timer will
+    // release them.
+    for (auto& [topic, tok] : shapedToks_) {
+        if (tok) {
+            MQTTAsync_failureData rsp{};
+            rsp.code = MQTTASYNC_OPERATION_INCOMPLETE;
+            tok->on_failure(&rsp);
+        }
+    }
+
+    MQTTAsync_destroy(&cli_);
+
+#if !defined(_WIN32)
+    if (fdRead_ >= 0) {
+        auto fdWrite = fdWrite_.load();
+        ::close(fdRead_);
+        if (fdWrite != fdRead_)
+            ::close(fdWrite);
+    }
+#endif
+}
 
 // --------------------------------------------------------------------------
 // Class static callbacks.
@@ -102,26 +208,65 @@ void async_client::on_connected(void* context, char* cause)
         return;
 
     async_client* cli = static_cast<async_client*>(context);
+    cli->pin_library_thread();
+    cli->nConnects_.fetch_add(1, std::memory_order_relaxed);
 
     auto tok = cli->connTok_;
     if (tok)
         tok->on_success(nullptr);
 
-    callback* cb = cli->userCallback_;
-    auto& connHandler = cli->connHandler_;
+    if (cli->topicAliases_)
+        cli->reset_topic_aliases(true);
+    cli->clear_incoming_topic_aliases();
+
+    {
+        guard g(cli->reconnLock_);
+        if (cli->backoff_) {
+            cli->backoff_->reset();
+            cli->reconnPending_ = false;
+        }
+    }
+
+    if (cli->offlineBuf_)
+        cli->set_buffer_online(true);
+
+    if (cli->flowControl_) {
+        auto props = cli->connect_properties();
+        {
+            guard g(cli->flowLock_);
+            cli->recvMax_ = props.contains(property::RECEIVE_MAXIMUM)
+                                ? size_t(get<uint16_t>(props, property::RECEIVE_MAXIMUM))
+                                : size_t(65535);
+        }
+        cli->send_deferred();
+    }
+
+    if (cli->restoreSubs_)
+        cli->restore_subscriptions();
+
+    callback* cb = cli->userCallback_.load(std::memory_order_acquire);
+    auto connHandler = cli->connHandler_.load();
     auto& que = cli->que_;
 
     if (cb || connHandler || que) {
         string cause_str = cause ? string{cause} : string{};
 
-        if (cb)
-            cb->connected(cause_str);
+        if (cb || connHandler) {
+            cli->run_callback([cli, cb, connHandler, cause_str] {
+                auto t = cli->callback_start();
+                if (cb)
+                    cb->connected(cause_str);
 
-        if (connHandler)
-            connHandler(cause_str);
+                if (connHandler)
+                    (*connHandler)(cause_str);
+                cli->callback_done(callback_point::CONNECTED, cause_str, t);
+            });
+        }
 
-        if (que)
+        if (que) {
             que->put(connected_event{cause_str});
+            cli->notify_consumers();
+        }
     }
 }
 
@@ -137,22 +282,54 @@ void async_client::on_connection_lost(void* context, char* cause)
         return;
 
     async_client* cli = static_cast<async_client*>(context);
+    cli->pin_library_thread();
 
-    callback* cb = cli->userCallback_;
-    auto& connLostHandler = cli->connLostHandler_;
+    if (cli->topicAliases_)
+        cli->reset_topic_aliases(false);
+    cli->clear_incoming_topic_aliases();
+    cli->schedule_reconnect();
+
+    if (cli->offlineBuf_)
+        cli->set_buffer_online(false);
+
+    callback* cb = cli->userCallback_.load(std::memory_order_acquire);
+    auto connLostHandler = cli->connLostHandler_.load();
     auto& que = cli->que_;
 
     if (cb || connLostHandler || que) {
         string cause_str = cause ? string(cause) : string();
 
-        if (cb)
-            cb->connection_lost(cause_str);
+        if (cb || connLostHandler) {
+            cli->run_callback([cli, cb, connLostHandler, cause_str] {
+                auto t = cli->callback_start();
+                if (cb)
+                    cb->connection_lost(cause_str);
 
-        if (connLostHandler)
-            connLostHandler(cause_str);
+                if (connLostHandler)
+                    (*connLostHandler)(cause_str);
+                cli->callback_done(callback_point::CONNECTION_LOST, cause_str, t);
+            });
+        }
 
-        if (que)
+        if (que) {
             que->put(connection_lost_event{cause_str});
+            cli->notify_consumers();
+        }
+    }
+}
+
+// The C library's threads are shared by all of the clients in the process,
+// so each thread is only pinned once, by the first client it calls into
+// that has a CPU set. After that, this is just a check of a flag.
+
+void async_client::pin_library_thread() const
+{
+    thread_local bool pinned = false;
+
+    const auto& cpus = createOpts_.get_library_affinity();
+    if (!pinned && !cpus.empty()) {
+        pinned = true;
+        cpus.pin_current_thread();
     }
 }
 
@@ -166,18 +343,48 @@ void async_client::on_disconnected(
         return;
 
     async_client* cli = static_cast<async_client*>(context);
+    cli->pin_library_thread();
+
+    // The server can ask for a delay before the next reconnect
+    if (cprops && cprops->count > 0) {
+        guard g(cli->reconnLock_);
+        if (cli->backoff_) {
+            properties hintProps(*cprops);
+            if (hintProps.contains_user_property(reconnect_backoff::HINT_PROPERTY)) {
+                try {
+                    auto secs = std::stod(
+                        hintProps.get_user_property(reconnect_backoff::HINT_PROPERTY)
+                    );
+                    if (secs > 0.0)
+                        cli->backoff_->hint(std::chrono::duration_cast<reconnect_backoff::duration>(
+                            std::chrono::duration<double>(secs)
+                        ));
+                }
+                catch (const std::exception&) {
+                }
+            }
+        }
+    }
+    cli->schedule_reconnect();
 
-    auto& disconnectedHandler = cli->disconnectedHandler_;
+    auto disconnectedHandler = cli->disconnectedHandler_.load();
     auto& que = cli->que_;
 
     if (disconnectedHandler || que) {
         properties props(*cprops);
 
-        if (disconnectedHandler)
-            disconnectedHandler(props, ReasonCode(reasonCode));
+        if (disconnectedHandler) {
+            cli->run_callback([cli, disconnectedHandler, props, reasonCode] {
+                auto t = cli->callback_start();
+                (*disconnectedHandler)(props, ReasonCode(reasonCode));
+                cli->callback_done(callback_point::DISCONNECTED, std::string_view{}, t);
+            });
+        }
 
-        if (que)
+        if (que) {
             que->put(disconnected_event{std::move(props), ReasonCode(reasonCode)});
+            cli->notify_consumers();
+        }
     }
 }
 
@@ -192,24 +399,175 @@ int async_client::on_message_arrived(
         return to_int(true);
 
     async_client* cli = static_cast<async_client*>(context);
-    callback* cb = cli->userCallback_;
+    cli->pin_library_thread();
+
+    // Refusing the message leaves it with the C lib, which offers it again
+    if (cli->manualAck_ && cli->maxUnacked_ > 0 && msg->qos > 0 &&
+        cli->nUnacked_.load(std::memory_order_relaxed) >= cli->maxUnacked_)
+        return to_int(false);
+
+    callback* cb = cli->userCallback_.load(std::memory_order_acquire);
     auto& que = cli->que_;
-    auto& msgHandler = cli->msgHandler_;
+    auto msgHandler = cli->msgHandler_.load();
+    auto& dispatcher = cli->dispatcher_;
+    bool filtered = cli->hasFilterHandlers_.load(std::memory_order_acquire);
+
+    auto traceTime = cli->trace_start();
+
+    size_t len = (topicLen == 0) ? strlen(topicName) : size_t(topicLen);
+    cli->nReceived_.fetch_add(1, std::memory_order_relaxed);
+    cli->nBytesReceived_.fetch_add(len + size_t(msg->payloadlen), std::memory_order_relaxed);
+
+    // The messages that aren't wanted are dropped before anything is
+    // built for them. One with a topic alias is kept, so the alias can be
+    // resolved.
+    if (auto& sampler = cli->sampler_; sampler && len > 0 &&
+        !MQTTProperties_hasProperty(&msg->properties, MQTTPROPERTY_CODE_TOPIC_ALIAS) &&
+        !sampler->keep({topicName, len})) {
+        MQTTAsync_freeMessage(&msg);
+        MQTTAsync_free(topicName);
+        return to_int(true);
+    }
+
+    auto& cache = cli->retainedCache_;
+
+    if (cb || que || msgHandler || filtered || dispatcher || cache) {
+
+        auto& pool = cli->msgPool_;
+        auto& topicTbl = cli->topicTbl_;
+
+        auto make_topic = [&pool](std::string_view sv) {
+            return pool ? pool->create_buffer(sv.data(), sv.size()) : string_ref{string{sv}};
+        };
+
+        // Take over any properties from the C message rather than making
+        // a deep copy of them, leaving the C struct empty.
+        properties props{std::move(msg->properties)};
+        message_ptr m;
+
+        string_ref topic;
+        if (len > 0)
+            topic = topicTbl ? topicTbl->get({topicName, len}, make_topic)
+                             : make_topic({topicName, len});
+
+        // The server can send an alias in place of the topic, after it has
+        // sent the two together once on the connection.
+        if (props.contains(property::TOPIC_ALIAS))
+            topic = cli->resolve_topic_alias(
+                get<uint16_t>(props, property::TOPIC_ALIAS), std::move(topic)
+            );
+
+        if (!topic)
+            topic = make_topic({topicName, len});
+
+        // A payload tagged by our codec is decoded straight from the C
+        // buffer. If it can't be decoded, it's delivered as it is.
+        binary_ref decoded;
+        const auto& codec = cli->createOpts_.payloadCodec_;
+
+        if (codec && msg->payloadlen > 0 &&
+            props.contains_user_property(payload_codec::PROPERTY_NAME)) {
+            try {
+                if (props.get_user_property(payload_codec::PROPERTY_NAME) == codec->name())
+                    decoded = codec->decode(
+                        {static_cast<const char*>(msg->payload), size_t(msg->payloadlen)}
+                    );
+            }
+            catch (const std::exception&) {
+            }
+        }
+
+        if (decoded) {
+            m = pool ? pool->create_message(std::move(topic), *msg, std::move(decoded))
+                     : message::create(std::move(topic), *msg, std::move(decoded));
+        }
+        else if (cli->createOpts_.get_zero_copy_payloads() && msg->payloadlen > 0) {
+            // Take ownership of the payload buffer from the C lib, so
+            // that it isn't freed with the message struct.
+            binary_ref payload{
+                static_cast<const char*>(msg->payload), size_t(msg->payloadlen),
+                [](const char* p) { MQTTAsync_free(const_cast<char*>(p)); }
+            };
+            msg->payload = nullptr;
+            msg->payloadlen = 0;
+            m = pool ? pool->create_message(std::move(topic), *msg, std::move(payload))
+                     : message::create(std::move(topic), *msg, std::move(payload));
+        }
+        else {
+            m = pool ? pool->create_message(std::move(topic), *msg)
+                     : message::create(std::move(topic), *msg);
+        }
+
+        if (!props.empty())
+            m->set_properties(std::move(props));
+
+        // The tracker sees every arrival, including the duplicates
+        if (cli->seqTracker_)
+            cli->seqTracker_->check(*m);
+        if (cli->topicStats_)
+            cli->topicStats_->count_received(*m);
+
+        // A message that was already seen is dropped before anything
+        // else gets it.
+        if (cli->dedupFilter_ && cli->dedupFilter_->is_duplicate(*m)) {
+            cli->nDuplicates_.fetch_add(1, std::memory_order_relaxed);
+            MQTTAsync_freeMessage(&msg);
+            MQTTAsync_free(topicName);
+            return to_int(true);
+        }
+
+        // The chunks of a transfer are held until it's complete.
+        if (cli->reassembler_ && !(m = cli->reassembler_->add(std::move(m)))) {
+            MQTTAsync_freeMessage(&msg);
+            MQTTAsync_free(topicName);
+            return to_int(true);
+        }
+
+        if (cli->manualAck_ && m->get_qos() > 0)
+            cli->track_unacked(m);
+
+        m->traced_ = (traceTime != trace_clock::time_point{});
+        if (m->traced_)
+            cli->trace(trace_point::ARRIVED, *m, traceTime);
+
+        if (cache && m->is_retained())
+            cache->update(m);
 
-    if (cb || que || msgHandler) {
-        size_t len = (topicLen == 0) ? strlen(topicName) : size_t(topicLen);
+        // Each consumer of the message gets a copy of the pointer, but the
+        // last one gets it moved, so that with only one of them, the
+        // message is delivered without touching the reference count.
+        bool more = que || dispatcher;
 
-        string topic{topicName, len};
-        auto m = message::create(std::move(topic), *msg);
+        if (msgHandler || filtered || cb) {
+            cli->run_callback([cli, msgHandler, filtered, cb,
+                               m = more ? m : std::move(m)] {
+                auto t = cli->callback_start();
+                if (msgHandler)
+                    (*msgHandler)(m);
 
-        if (msgHandler)
-            msgHandler(m);
+                if (filtered) {
+                    cli->filterHandlers_.for_each_match(
+                        m->get_topic_ref(), [&m](const auto& val) { val.second(m); }
+                    );
+                }
+
+                if (cb)
+                    cb->message_arrived(m);
+                cli->callback_done(callback_point::MESSAGE_ARRIVED, m->get_topic(), t);
+            });
+        }
 
-        if (cb)
-            cb->message_arrived(m);
+        if (que && cli->queue_message(dispatcher ? message_ptr{m} : std::move(m))) {
+            auto n = que->size();
+            auto hw = cli->queHighWater_.load(std::memory_order_relaxed);
+            while (n > hw && !cli->queHighWater_.compare_exchange_weak(
+                                 hw, n, std::memory_order_relaxed
+                             ));
+            cli->notify_consumers();
+        }
 
-        if (que)
-            que->put(m);
+        if (dispatcher)
+            dispatcher->dispatch(std::move(m));
     }
 
     MQTTAsync_freeMessage(&msg);
@@ -219,37 +577,58 @@ int async_client::on_message_arrived(
 
 // Callback from the C lib for when a registered updateConnectOptions
 // needs to be called.
+// The C lib takes ownership of the user name and password in the connect
+// data, so they are copied into buffers from its allocator. Credentials
+// from a provider go straight in, without a round trip through a copy of
+// the connect data and the handler.
+
+void async_client::set_connect_data(
+    MQTTAsync_connectData* cdata, std::string_view userName, std::string_view password
+)
+{
+    auto n = userName.length();
+    if (n > 0) {
+        char* username = static_cast<char*>(MQTTAsync_malloc(n + 1));
+        memcpy(username, userName.data(), n);
+        username[n] = '\0';
+        cdata->username = username;
+    }
+    else
+        cdata->username = nullptr;
+
+    n = password.length();
+    if (n > 0) {
+        char* passwd = static_cast<char*>(MQTTAsync_malloc(n));
+        memcpy(passwd, password.data(), n);
+        cdata->binarypwd.data = passwd;
+    }
+    else
+        cdata->binarypwd.data = nullptr;
+    cdata->binarypwd.len = int(n);
+}
+
 int async_client::on_update_connection(void* context, MQTTAsync_connectData* cdata)
 {
     if (context) {
         async_client* cli = static_cast<async_client*>(context);
-        auto& updateConnection = cli->updateConnectionHandler_;
+
+        if (auto prov = cli->credProvider_.load()) {
+            if (auto creds = prov->get_credentials()) {
+                set_connect_data(cdata, creds->userName, creds->password);
+                return to_int(true);
+            }
+        }
+
+        auto updateConnection = cli->updateConnectionHandler_.load();
 
         if (updateConnection) {
             connect_data data(*cdata);
-            if (updateConnection(data)) {
-                // Copy username and password into newly allocated buffers.
-                // The C lib will take ownership of the memory
-                auto n = data.get_user_name().length();
-                if (n > 0) {
-                    char* username = static_cast<char*>(MQTTAsync_malloc(n + 1));
-                    strncpy(username, data.get_user_name().c_str(), n + 1);
-                    username[n] = '\0';
-                    cdata->username = username;
-                }
-                else
-                    cdata->username = nullptr;
-
-                n = data.get_password().length();
-                if (n > 0) {
-                    char* passwd = static_cast<char*>(MQTTAsync_malloc(n));
-                    memcpy(passwd, data.get_password().data(), n);
-                    cdata->binarypwd.data = passwd;
-                }
-                else
-                    cdata->binarypwd.data = nullptr;
-                cdata->binarypwd.len = int(n);
-
+            if ((*updateConnection)(data)) {
+                auto passwd = data.get_password();
+                set_connect_data(
+                    cdata, data.get_user_name(),
+                    passwd ? std::string_view(passwd.data(), passwd.size()) : std::string_view{}
+                );
                 return to_int(true);
             }
         }
@@ -263,53 +642,242 @@ int async_client::on_update_connection(void* context, MQTTAsync_connectData* cda
 void async_client::add_token(token_ptr tok)
 {
     if (tok) {
-        guard g(lock_);
-        pendingTokens_.push_back(tok);
+        {
+            guard g(tokLock_);
+            pendingTokens_.emplace(tok.get(), tok);
+        }
+
+        // Connect and disconnect have timeouts of their own
+        auto typ = tok->get_type();
+        auto timeout = createOpts_.get_operation_timeout();
+        if (timeout.count() > 0 && typ != token::Type::CONNECT &&
+            typ != token::Type::DISCONNECT)
+            set_deadline(tok, timeout);
     }
 }
 
 void async_client::add_token(delivery_token_ptr tok)
 {
     if (tok) {
-        guard g(lock_);
-        pendingDeliveryTokens_.push_back(tok);
+        charge_token(*tok);
+        auto now = std::chrono::steady_clock::now();
+        {
+            guard g(deliveryTokLock_);
+            insert_pending(tok, now);
+        }
+
+        auto timeout = createOpts_.get_operation_timeout();
+        if (timeout.count() > 0)
+            set_deadline(tok, timeout);
     }
 }
 
+void async_client::charge_token(delivery_token& tok)
+{
+    tok.memCharge_ = token_memory(tok.get_message());
+    pendingBytes_.fetch_add(tok.memCharge_, std::memory_order_relaxed);
+    memBudget_->charge(tok.memCharge_);
+}
+
+void async_client::insert_pending(
+    const delivery_token_ptr& tok, std::chrono::steady_clock::time_point now
+)
+{
+    if (!pendingDeliveryTokens_.emplace(tok.get(), tok).second)
+        return;
+    nPendingDelivery_.store(pendingDeliveryTokens_.size(), std::memory_order_relaxed);
+
+    tok->pendingSince_ = now;
+    tok->olderPending_ = newestPending_;
+    tok->newerPending_ = nullptr;
+    (newestPending_ ? newestPending_->newerPending_ : oldestPending_) = tok.get();
+    newestPending_ = tok.get();
+}
+
+const timer_wheel_ptr& async_client::timers()
+{
+    std::call_once(timersOnce_, [this] { timers_ = timer_wheel::create(); });
+    return timers_;
+}
+
+// The timer only holds a weak reference to the token, and the token only
+// a weak one to the wheel, to cancel the timer when it completes first.
+
+void async_client::set_deadline(const token_ptr& tok, timer_wheel::duration timeout)
+{
+    if (!tok || tok->is_complete())
+        return;
+
+    const auto& wheel = timers();
+    std::weak_ptr<token> wtok = tok;
+
+    auto id = wheel->schedule(timeout, [wtok] {
+        if (auto t = wtok.lock())
+            t->expire();
+    });
+
+    std::weak_ptr<timer_wheel> wwheel = wheel;
+    if (!tok->notify_on_complete([wwheel, id] {
+            if (auto w = wwheel.lock())
+                w->cancel(id);
+        }))
+        wheel->cancel(id);
+}
+
 // Note that we uniquely identify a token by the address of its raw pointer,
-// since the message ID is not unique.
+// since the message ID is not unique. The tokens are hashed by address so
+// that completing an operation doesn't depend on how many are in flight.
 
 void async_client::remove_token(token* tok)
 {
     if (!tok)
         return;
 
-    guard g(lock_);
-    for (auto p = pendingDeliveryTokens_.begin(); p != pendingDeliveryTokens_.end(); ++p) {
-        if (p->get() == tok) {
-            delivery_token_ptr dtok = *p;
-            pendingDeliveryTokens_.erase(p);
+    // Only publish tokens can be delivery tokens, so the others don't
+    // need to contend with the publishers for the delivery lock.
+    if (tok->get_type() == token::Type::PUBLISH) {
+        delivery_token_ptr dtok;
+        {
+            guard g(deliveryTokLock_);
+            auto p = pendingDeliveryTokens_.find(tok);
+            if (p != pendingDeliveryTokens_.end()) {
+                dtok = std::move(p->second);
+                pendingDeliveryTokens_.erase(p);
+                nPendingDelivery_.store(
+                    pendingDeliveryTokens_.size(), std::memory_order_relaxed
+                );
+
+                auto older = dtok->olderPending_;
+                auto newer = dtok->newerPending_;
+                (older ? older->newerPending_ : oldestPending_) = newer;
+                (newer ? newer->olderPending_ : newestPending_) = older;
+                dtok->olderPending_ = dtok->newerPending_ = nullptr;
+            }
+        }
 
-            // If there's a user callback registered, we can now call
-            // delivery_complete()
+        if (dtok) {
+            const_message_ptr msg = dtok->get_message();
 
-            if (userCallback_) {
-                const_message_ptr msg = dtok->get_message();
-                if (msg && msg->get_qos() > 0) {
-                    callback* cb = userCallback_;
-                    g.unlock();
-                    cb->delivery_complete(dtok);
+            if (pubWindow_)
+                pubWindow_->release(window_size(msg));
+
+            if (dtok->memCharge_ > 0) {
+                pendingBytes_.fetch_sub(dtok->memCharge_, std::memory_order_relaxed);
+                memBudget_->release(dtok->memCharge_);
+            }
+
+            if (dtok->inFlight_) {
+                {
+                    guard g(flowLock_);
+                    --nInFlight_;
                 }
+                send_deferred();
+            }
+
+            // Only a completed token was sent, and only QoS 1 & 2 are acked.
+            if (msg && dtok->is_complete() && dtok->get_return_code() == MQTTASYNC_SUCCESS) {
+                auto t = std::chrono::steady_clock::now();
+                if (msg->get_qos() > 0)
+                    ackLatency_.record(t - dtok->sendTime_);
+                if (dtok->traced_)
+                    trace(trace_point::DELIVERED, *msg, t);
+            }
+
+            // If there's a user callback registered, we can now call
+            // delivery_complete()
+            callback* cb = userCallback_.load(std::memory_order_acquire);
+            if (cb) {
+                if (msg && msg->get_qos() > 0)
+                    queue_delivery_complete(cb, std::move(dtok));
             }
             return;
         }
     }
-    for (auto p = pendingTokens_.begin(); p != pendingTokens_.end(); ++p) {
-        if (p->get() == tok) {
-            pendingTokens_.erase(p);
-            return;
-        }
+
+    guard g(tokLock_);
+    pendingTokens_.erase(tok);
+}
+
+// Only the first completion into an empty list schedules the callback. Any
+// that come in before it runs are picked up by the same call.
+
+void async_client::queue_delivery_complete(callback* cb, delivery_token_ptr tok)
+{
+    bool first;
+    {
+        guard g(complLock_);
+        first = complToks_.empty();
+        complToks_.push_back(std::move(tok));
+    }
+
+    if (first) {
+        run_callback([this, cb] {
+            std::vector<delivery_token_ptr> toks;
+            {
+                guard g(complLock_);
+                toks.swap(complToks_);
+            }
+            if (!toks.empty()) {
+                auto t = callback_start();
+                cb->delivery_complete_batch(toks);
+                auto msg = toks.front()->get_message();
+                callback_done(
+                    callback_point::DELIVERY_COMPLETE,
+                    msg ? std::string_view{msg->get_topic()} : std::string_view{}, t
+                );
+            }
+        });
+    }
+}
+
+// The incoming aliases are only valid for a connection, so they're cleared
+// whenever it's made or lost.
+
+string_ref async_client::resolve_topic_alias(uint16_t alias, string_ref topic)
+{
+    guard g(inAliasLock_);
+
+    if (topic) {
+        if (alias >= inAliases_.size())
+            inAliases_.resize(size_t(alias) + 1);
+        inAliases_[alias] = topic;
+        return topic;
+    }
+
+    return (alias < inAliases_.size()) ? inAliases_[alias] : string_ref{};
+}
+
+void async_client::clear_incoming_topic_aliases()
+{
+    guard g(inAliasLock_);
+    inAliases_.clear();
+}
+
+// The server's limits come in the CONNACK, which the library hands to the
+// connect token just before the connected callback.
+
+void async_client::reset_topic_aliases(bool connected)
+{
+    size_t serverMax = 0;
+
+    if (connected) {
+        auto props = connect_properties();
+        if (props.contains(property::TOPIC_ALIAS_MAXIMUM))
+            serverMax = get<uint16_t>(props, property::TOPIC_ALIAS_MAXIMUM);
+    }
+
+    guard g(aliasLock_);
+    topicAliases_->reset(serverMax);
+}
+
+properties async_client::connect_properties() const
+{
+    if (auto tok = connTok_; tok) {
+        token::guard g(tok->lock_);
+        if (tok->connRsp_ && tok->connRsp_->get_mqtt_version() >= MQTTVERSION_5)
+            return tok->connRsp_->get_properties();
     }
+    return properties{};
 }
 
 // --------------------------------------------------------------------------
@@ -317,10 +885,7 @@ void async_client::remove_token(token* tok)
 
 void async_client::set_callback(callback& cb)
 {
-    {
-        guard g(lock_);
-        userCallback_ = &cb;
-    }
+    userCallback_.store(&cb, std::memory_order_release);
     int rc = MQTTAsync_setConnected(cli_, this, &async_client::on_connected);
 
     if (rc == MQTTASYNC_SUCCESS) {
@@ -332,8 +897,7 @@ void async_client::set_callback(callback& cb)
     else {
         MQTTAsync_setConnected(cli_, nullptr, nullptr);
 
-        guard g(lock_);
-        userCallback_ = nullptr;
+        userCallback_.store(nullptr, std::memory_order_release);
         throw exception(rc);
     }
 }
@@ -355,13 +919,19 @@ void async_client::disable_callbacks()
 
 void async_client::set_connected_handler(connection_handler cb)
 {
-    connHandler_ = cb;
+    if (cb)
+        connHandler_.store(std::move(cb));
+    else
+        connHandler_.reset();
     check_ret(::MQTTAsync_setConnected(cli_, this, &async_client::on_connected));
 }
 
 void async_client::set_connection_lost_handler(connection_handler cb)
 {
-    connLostHandler_ = cb;
+    if (cb)
+        connLostHandler_.store(std::move(cb));
+    else
+        connLostHandler_.reset();
     check_ret(
         ::MQTTAsync_setConnectionLostCallback(cli_, this, &async_client::on_connection_lost)
     );
@@ -369,26 +939,89 @@ void async_client::set_connection_lost_handler(connection_handler cb)
 
 void async_client::set_disconnected_handler(disconnected_handler cb)
 {
-    disconnectedHandler_ = cb;
+    if (cb)
+        disconnectedHandler_.store(std::move(cb));
+    else
+        disconnectedHandler_.reset();
     check_ret(::MQTTAsync_setDisconnected(cli_, this, &async_client::on_disconnected));
 }
 
 void async_client::set_message_callback(message_handler cb)
 {
-    msgHandler_ = cb;
+    if (cb)
+        msgHandler_.store(std::move(cb));
+    else
+        msgHandler_.reset();
+    check_ret(
+        ::MQTTAsync_setMessageArrivedCallback(cli_, this, &async_client::on_message_arrived)
+    );
+}
+
+void async_client::add_message_handler(const string& filter, message_handler cb)
+{
+    if (!cb) {
+        remove_message_handler(filter);
+        return;
+    }
+
+    filterHandlers_.insert({filter, std::move(cb)});
+    hasFilterHandlers_.store(true, std::memory_order_release);
     check_ret(
         ::MQTTAsync_setMessageArrivedCallback(cli_, this, &async_client::on_message_arrived)
     );
 }
 
+bool async_client::remove_message_handler(const string& filter)
+{
+    return bool(filterHandlers_.remove(filter));
+}
+
+async_client::message_handler_snapshot async_client::set_message_handlers(
+    message_handler_table&& handlers
+)
+{
+    bool empty = handlers.empty();
+    auto old = filterHandlers_.exchange(std::move(handlers));
+
+    if (!empty) {
+        hasFilterHandlers_.store(true, std::memory_order_release);
+        check_ret(::MQTTAsync_setMessageArrivedCallback(
+            cli_, this, &async_client::on_message_arrived
+        ));
+    }
+    return old;
+}
+
 void async_client::set_update_connection_handler(update_connection_handler cb)
 {
-    updateConnectionHandler_ = cb;
+    if (cb)
+        updateConnectionHandler_.store(std::move(cb));
+    else
+        updateConnectionHandler_.reset();
+    check_ret(
+        ::MQTTAsync_setUpdateConnectOptions(cli_, this, &async_client::on_update_connection)
+    );
+}
+
+void async_client::set_credential_provider(credential_provider_ptr prov)
+{
+    if (prov)
+        credProvider_.store(std::move(prov));
+    else
+        credProvider_.reset();
     check_ret(
         ::MQTTAsync_setUpdateConnectOptions(cli_, this, &async_client::on_update_connection)
     );
 }
 
+void async_client::set_executor(executor_type ex)
+{
+    if (ex)
+        executor_.store(std::move(ex));
+    else
+        executor_.reset();
+}
+
 // --------------------------------------------------------------------------
 // Connect
 
@@ -406,6 +1039,8 @@ token_ptr async_client::connect(connect_options opts)
     else
         opts.opts_.cleansession = 0;
 
+    set_reconnect_backoff(opts);
+
     // TODO: If connTok_ is non-null, there could be a pending connect
     // which might complete after creating/assigning a new one. If that
     // happened, the callback would have the context address of the previous
@@ -417,9 +1052,20 @@ token_ptr async_client::connect(connect_options opts)
 
     opts.set_token(connTok_);
 
-    // TODO: Lock!
-    connOpts_ = std::move(opts);
-    int rc = MQTTAsync_connect(cli_, &connOpts_.opts_);
+    // The options are kept under the lock while the C lib reads them. It
+    // doesn't call back into the client from within the connect call.
+    int rc = MQTTASYNC_SUCCESS;
+    {
+        guard g(lock_);
+        connOpts_ = std::move(opts);
+        if (!loopback_)
+            rc = MQTTAsync_connect(cli_, &connOpts_.opts_);
+    }
+
+    if (loopback_) {
+        loopback_connect();
+        return connTok_;
+    }
 
     if (rc != MQTTASYNC_SUCCESS) {
         remove_token(connTok_);
@@ -442,6 +1088,8 @@ token_ptr async_client::connect(connect_options opts, void* userContext, iaction
     else
         opts.opts_.cleansession = 0;
 
+    set_reconnect_backoff(opts);
+
     // Keep the old connTok_ alive (see above)
     auto tmpTok = connTok_;
     connTok_ = token::create(token::Type::CONNECT, *this, userContext, cb);
@@ -449,8 +1097,19 @@ token_ptr async_client::connect(connect_options opts, void* userContext, iaction
 
     opts.set_token(connTok_);
 
-    connOpts_ = std::move(opts);
-    int rc = MQTTAsync_connect(cli_, &connOpts_.opts_);
+    // Store the options and connect under the lock (see above)
+    int rc = MQTTASYNC_SUCCESS;
+    {
+        guard g(lock_);
+        connOpts_ = std::move(opts);
+        if (!loopback_)
+            rc = MQTTAsync_connect(cli_, &connOpts_.opts_);
+    }
+
+    if (loopback_) {
+        loopback_connect();
+        return connTok_;
+    }
 
     if (rc != MQTTASYNC_SUCCESS) {
         remove_token(connTok_);
@@ -462,41 +1121,311 @@ token_ptr async_client::connect(connect_options opts, void* userContext, iaction
     return connTok_;
 }
 
-// --------------------------------------------------------------------------
-// Re-connect
+// The client's connect token is made up front so that it can be returned
+// right away. The race thread completes it through the real connect.
 
-token_ptr async_client::reconnect()
+token_ptr async_client::connect_race(connect_options opts, std::chrono::milliseconds stagger)
 {
-    auto tok = connTok_;
-
-    if (!tok)
-        throw exception(MQTTASYNC_FAILURE, "Can't reconnect before a successful connect");
-
-    tok->reset();
-    add_token(tok);
+    auto servers = opts.get_servers();
+    if (loopback_ || !servers || servers->size() < 2)
+        return connect(std::move(opts));
 
-    int rc = MQTTAsync_setConnected(cli_, this, &async_client::on_connected);
+    stop_race();
+    set_reconnect_backoff(opts);
 
-    if (rc == MQTTASYNC_SUCCESS)
-        rc = MQTTAsync_reconnect(cli_);
+    mqttVersion_ = opts.opts_.MQTTVersion;
+    connTok_ = token::create(token::Type::CONNECT, *this);
+    add_token(connTok_);
 
-    if (rc != MQTTASYNC_SUCCESS) {
-        remove_token(tok);
-        throw exception(rc);
+    {
+        guard g(raceLock_);
+        raceCancel_ = false;
+        raceRunning_ = true;
     }
-
-    return tok;
+    raceThread_ = std::thread([this, opts = std::move(opts), stagger]() mutable {
+        race_servers(std::move(opts), stagger);
+    });
+    return connTok_;
 }
 
-// --------------------------------------------------------------------------
-// Disconnect
-
-token_ptr async_client::disconnect(disconnect_options opts)
+void async_client::stop_race()
 {
-    auto tok = token::create(token::Type::DISCONNECT, *this);
-    add_token(tok);
+    {
+        guard g(raceLock_);
+        raceCancel_ = true;
+    }
+    raceCond_.notify_all();
+
+    // The race thread might get here through the connect token's callback,
+    // after it's done with the race, and can't join itself.
+    if (raceThread_.joinable()) {
+        if (raceThread_.get_id() == std::this_thread::get_id())
+            raceThread_.detach();
+        else
+            raceThread_.join();
+    }
+}
 
-    opts.set_token(tok, mqttVersion_);
+void async_client::race_servers(connect_options opts, std::chrono::milliseconds stagger)
+{
+    using clock = std::chrono::steady_clock;
+
+    auto servers = opts.get_servers();
+    const size_t n = servers->size();
+
+    auto trialOpts = opts;
+    trialOpts.set_servers(nullptr);
+    trialOpts.opts_.will = nullptr;
+    trialOpts.opts_.willProperties = nullptr;
+    trialOpts.set_automatic_reconnect(false);
+    if (mqttVersion_ < MQTTVERSION_5)
+        trialOpts.set_clean_session(true);
+    else
+        trialOpts.set_clean_start(true);
+
+    std::vector<std::unique_ptr<async_client>> trials;
+    std::vector<token_ptr> toks;
+    size_t winner = n, nFailed = 0;
+
+    auto start = clock::now();
+    auto start_of = [start, stagger](size_t i) { return start + stagger * int64_t(i); };
+    auto timeout = opts.get_connect_timeout();
+    auto deadline = start + (timeout.count() > 0 ? timeout : std::chrono::seconds{30});
+
+    unique_lock g(raceLock_);
+    while (!raceCancel_ && winner == n && nFailed < n && clock::now() < deadline) {
+        if (toks.size() < n && clock::now() >= start_of(toks.size())) {
+            g.unlock();
+            try {
+                auto cli = std::make_unique<async_client>(create_options_builder()
+                                                              .server_uri((*servers)[toks.size()])
+                                                              .client_id("")
+                                                              .mqtt_version(mqttVersion_)
+                                                              .finalize());
+                auto tok = cli->connect(trialOpts);
+                tok->notify_on_complete([this] {
+                    guard g(raceLock_);
+                    raceCond_.notify_all();
+                });
+                trials.push_back(std::move(cli));
+                toks.push_back(std::move(tok));
+            }
+            catch (...) {
+                trials.emplace_back();
+                toks.emplace_back();
+            }
+            g.lock();
+        }
+
+        nFailed = 0;
+        for (size_t i = 0; i < toks.size(); ++i) {
+            if (!toks[i])
+                ++nFailed;
+            else if (toks[i]->is_complete()) {
+                if (toks[i]->get_return_code() == MQTTASYNC_SUCCESS) {
+                    winner = i;
+                    break;
+                }
+                ++nFailed;
+            }
+        }
+
+        if (winner == n && nFailed < n) {
+            auto wakeup = (toks.size() < n) ? std::min(deadline, start_of(toks.size()))
+                                            : deadline;
+            raceCond_.wait_until(g, wakeup);
+        }
+    }
+    g.unlock();
+
+    // The trial connections aren't used for anything
+    for (auto& cli : trials) {
+        try {
+            if (cli && cli->is_connected())
+                cli->disconnect(0);
+        }
+        catch (...) {
+        }
+    }
+    trials.clear();
+
+    auto tok = connTok_;
+
+    // The cancel is checked again, and the real connect made, in the same
+    // critical section, so a disconnect can't slip in between them.
+    g.lock();
+    if (raceCancel_) {
+        raceRunning_ = false;
+        g.unlock();
+        MQTTAsync_failureData rsp{};
+        rsp.code = MQTTASYNC_OPERATION_INCOMPLETE;
+        tok->on_failure(&rsp);
+        return;
+    }
+
+    if (winner < n) {
+        auto order = string_collection::create((*servers)[winner]);
+        for (size_t i = 0; i < n; ++i) {
+            if (i != winner)
+                order->push_back((*servers)[i]);
+        }
+        opts.set_servers(order);
+    }
+
+    if (opts.opts_.MQTTVersion < 5)
+        opts.opts_.cleanstart = 0;
+    else
+        opts.opts_.cleansession = 0;
+
+    opts.set_token(tok);
+
+    int rc;
+    {
+        guard lg(lock_);
+        connOpts_ = std::move(opts);
+        rc = MQTTAsync_connect(cli_, &connOpts_.opts_);
+    }
+    raceRunning_ = false;
+    g.unlock();
+
+    if (rc != MQTTASYNC_SUCCESS) {
+        MQTTAsync_failureData rsp{};
+        rsp.code = rc;
+        tok->on_failure(&rsp);
+    }
+}
+
+// With a backoff policy, the client makes the reconnects itself, on its own
+// thread, so the C library's automatic reconnect is turned off.
+
+void async_client::set_reconnect_backoff(connect_options& opts)
+{
+    auto backoff = opts.get_reconnect_backoff();
+    if (backoff)
+        opts.set_automatic_reconnect(false);
+
+    guard g(reconnLock_);
+    backoff_ = std::move(backoff);
+    reconnPending_ = false;
+
+    if (backoff_ && !reconnThread_.joinable())
+        reconnThread_ = std::thread([this] { run_reconnects(); });
+}
+
+void async_client::schedule_reconnect()
+{
+    {
+        guard g(reconnLock_);
+        if (!backoff_ || reconnPending_)
+            return;
+        reconnPending_ = true;
+    }
+    reconnCond_.notify_all();
+}
+
+void async_client::run_reconnects()
+{
+    unique_lock g(reconnLock_);
+
+    while (!reconnStop_) {
+        reconnCond_.wait(g, [this] { return reconnStop_ || reconnPending_; });
+
+        while (!reconnStop_ && reconnPending_ && backoff_) {
+            auto delay = backoff_->next_delay();
+
+            if (reconnCond_.wait_for(g, delay, [this] {
+                    return reconnStop_ || !reconnPending_;
+                }))
+                break;
+
+            std::chrono::seconds timeout;
+            {
+                guard lg(lock_);
+                timeout = connOpts_.get_connect_timeout();
+            }
+            g.unlock();
+            try {
+                // Wait for the attempt, so they don't pile up. Success is
+                // seen by the connected callback, which clears the flag.
+                auto tok = reconnect();
+                tok->wait_for(timeout + std::chrono::seconds{5});
+            }
+            catch (...) {
+            }
+            g.lock();
+        }
+    }
+}
+
+// --------------------------------------------------------------------------
+// Re-connect
+
+token_ptr async_client::reconnect()
+{
+    auto tok = connTok_;
+
+    if (!tok)
+        throw exception(MQTTASYNC_FAILURE, "Can't reconnect before a successful connect");
+
+    {
+        guard g(raceLock_);
+        if (raceRunning_)
+            throw exception(MQTTASYNC_FAILURE, "Can't reconnect while racing the servers");
+    }
+
+    tok->reset();
+    add_token(tok);
+
+    if (loopback_) {
+        loopConnected_ = true;
+        on_connected(this, nullptr);
+        return tok;
+    }
+
+    int rc = MQTTAsync_setConnected(cli_, this, &async_client::on_connected);
+
+    if (rc == MQTTASYNC_SUCCESS)
+        rc = MQTTAsync_reconnect(cli_);
+
+    if (rc != MQTTASYNC_SUCCESS) {
+        remove_token(tok);
+        throw exception(rc);
+    }
+
+    return tok;
+}
+
+// --------------------------------------------------------------------------
+// Disconnect
+
+token_ptr async_client::disconnect(disconnect_options opts)
+{
+    auto tok = token::create(token::Type::DISCONNECT, *this);
+    add_token(tok);
+
+    opts.set_token(tok, mqttVersion_);
+
+    stop_race();
+
+    {
+        guard g(reconnLock_);
+        reconnPending_ = false;
+    }
+    reconnCond_.notify_all();
+
+    if (topicAliases_)
+        reset_topic_aliases(false);
+
+    if (offlineBuf_)
+        set_buffer_online(false);
+
+    fail_deferred(MQTTASYNC_DISCONNECTED);
+
+    if (loopback_) {
+        loopConnected_ = false;
+        tok->on_success(nullptr);
+        return tok;
+    }
 
     int rc = MQTTAsync_disconnect(cli_, &opts.opts_);
 
@@ -516,6 +1445,28 @@ token_ptr async_client::disconnect(int timeout, void* userContext, iaction_liste
     disconnect_options opts(timeout);
     opts.set_token(tok, mqttVersion_);
 
+    stop_race();
+
+    {
+        guard g(reconnLock_);
+        reconnPending_ = false;
+    }
+    reconnCond_.notify_all();
+
+    if (topicAliases_)
+        reset_topic_aliases(false);
+
+    if (offlineBuf_)
+        set_buffer_online(false);
+
+    fail_deferred(MQTTASYNC_DISCONNECTED);
+
+    if (loopback_) {
+        loopConnected_ = false;
+        tok->on_success(nullptr);
+        return tok;
+    }
+
     int rc = MQTTAsync_disconnect(cli_, &opts.opts_);
 
     if (rc != MQTTASYNC_SUCCESS) {
@@ -538,101 +1489,1226 @@ delivery_token_ptr async_client::get_pending_delivery_token(int msgID) const
     // msgID and signal it, indicating completion.
 
     if (msgID > 0) {
-        guard g(lock_);
+        guard g(deliveryTokLock_);
         const auto it = std::find_if(
             pendingDeliveryTokens_.cbegin(), pendingDeliveryTokens_.cend(),
-            [msgID](const auto& t) { return t->get_message_id() == msgID; }
+            [msgID](const auto& t) { return t.second->get_message_id() == msgID; }
         );
         if (it != pendingDeliveryTokens_.end())
-            return *it;
+            return it->second;
     }
     return delivery_token_ptr();
 }
 
+// The list is in the order the tokens were added, so the walk from the
+// oldest end stops at the first one that's too young.
+
+std::vector<delivery_token_ptr> async_client::get_pending_delivery_tokens(
+    std::chrono::steady_clock::duration age
+) const
+{
+    std::vector<delivery_token_ptr> toks;
+    auto since = std::chrono::steady_clock::now() - age;
+
+    guard g(deliveryTokLock_);
+    for (auto tok = oldestPending_; tok && tok->pendingSince_ <= since;
+         tok = tok->newerPending_)
+        toks.push_back(std::static_pointer_cast<delivery_token>(tok->shared_from_this()));
+    return toks;
+}
+
+std::chrono::steady_clock::duration async_client::oldest_pending_delivery_age() const
+{
+    std::chrono::steady_clock::time_point since;
+    {
+        guard g(deliveryTokLock_);
+        if (!oldestPending_)
+            return std::chrono::steady_clock::duration{0};
+        since = oldestPending_->pendingSince_;
+    }
+    return std::chrono::steady_clock::now() - since;
+}
+
 std::vector<delivery_token_ptr> async_client::get_pending_delivery_tokens() const
 {
     std::vector<delivery_token_ptr> toks;
-    guard g(lock_);
+    guard g(deliveryTokLock_);
     for (const auto& t : pendingDeliveryTokens_) {
-        if (t->get_message_id() > 0) {
-            toks.push_back(t);
+        if (t.second->get_message_id() > 0) {
+            toks.push_back(t.second);
         }
     }
     return toks;
 }
 
+client_stats async_client::get_stats() const
+{
+    client_stats st;
+
+    st.msgsPublished = nPublished_.load(std::memory_order_relaxed);
+    st.bytesPublished = nBytesPublished_.load(std::memory_order_relaxed);
+    st.msgsAcked = ackLatency_.count();
+    st.msgsReceived = nReceived_.load(std::memory_order_relaxed);
+    st.bytesReceived = nBytesReceived_.load(std::memory_order_relaxed);
+    st.pendingDeliveryTokens = num_pending_delivery_tokens();
+    st.oldestPendingDelivery =
+        std::chrono::duration_cast<std::chrono::microseconds>(oldest_pending_delivery_age());
+    st.pendingDeliveryBytes = pendingBytes_.load(std::memory_order_relaxed);
+    st.consumerQueueSize = consumer_queue_size();
+    if (meteredQue_)
+        st.consumerQueueBytes = meteredQue_->bytes();
+    st.consumerQueueHighWater = queHighWater_.load(std::memory_order_relaxed);
+    st.msgsDropped = nDropped_.load(std::memory_order_relaxed);
+    st.msgsDuplicated = nDuplicates_.load(std::memory_order_relaxed);
+    if (seqTracker_) {
+        auto seq = seqTracker_->get_stats();
+        st.seqGaps = seq.gaps;
+        st.seqDuplicates = seq.duplicates;
+        st.seqOutOfOrder = seq.outOfOrder;
+    }
+    st.publishErrors = nPublishErrors_.load(std::memory_order_relaxed);
+    {
+        guard g(flowLock_);
+        st.msgsInFlight = nInFlight_;
+        st.msgsDeferred = deferred_.size();
+    }
+    if (offlineBuf_) {
+        st.offlineBuffered = offlineBuf_->size();
+        st.offlineBufferBytes = offlineBuf_->bytes_in_memory();
+        st.offlineSpilled = offlineBuf_->num_spilled();
+    }
+    st.memoryUsed = memBudget_->used();
+    st.memoryHighWater = memBudget_->high_water();
+
+    auto nConn = nConnects_.load(std::memory_order_relaxed);
+    st.reconnects = (nConn > 0) ? (nConn - 1) : 0;
+
+    st.ackLatencyP50 = ackLatency_.percentile(50.0);
+    st.ackLatencyP99 = ackLatency_.percentile(99.0);
+    st.ackLatencyP999 = ackLatency_.percentile(99.9);
+    st.ackLatencyMax = ackLatency_.max();
+    st.callbacksTimed = callbackTime_.count();
+    st.slowCallbacks = nSlowCallbacks_.load(std::memory_order_relaxed);
+    st.callbackTimeP50 = callbackTime_.percentile(50.0);
+    st.callbackTimeP99 = callbackTime_.percentile(99.0);
+    st.callbackTimeMax = callbackTime_.max();
+    st.rttProbes = rttLatency_.count();
+    st.rttAverage = get_rtt();
+    st.rttP50 = rttLatency_.percentile(50.0);
+    st.rttP99 = rttLatency_.percentile(99.0);
+    st.rttMax = rttLatency_.max();
+    if (shaper_) {
+        st.shapedDelayed = shaper_->num_delayed();
+        st.shapedCoalesced = shaper_->num_coalesced();
+        st.shapedDropped = shaper_->num_dropped();
+    }
+    if (sampler_)
+        st.msgsSampledOut = sampler_->num_dropped();
+    if (topicStats_)
+        st.topicTraffic = topicStats_->get_traffic();
+    return st;
+}
+
 // --------------------------------------------------------------------------
-// Publish
+// Tracing
+//
+// When the library is built without tracing, trace_start() never picks a
+// message, so none of the trace points are reached.
 
-delivery_token_ptr async_client::publish(
-    string_ref topic, const void* payload, size_t n, int qos, bool retained,
-    const properties& props /*=properties()*/
-)
+void async_client::set_trace_handler(trace_handler cb, unsigned sampleRate /*=1*/)
 {
-    auto msg = message::create(std::move(topic), payload, n, qos, retained, props);
-    return publish(std::move(msg));
+    if (cb) {
+        traceHandler_.store(std::move(cb));
+        traceRate_.store(sampleRate, std::memory_order_relaxed);
+    }
+    else {
+        traceRate_.store(0, std::memory_order_relaxed);
+        traceHandler_.reset();
+    }
 }
 
-delivery_token_ptr async_client::publish(
-    string_ref topic, binary_ref payload, int qos, bool retained,
-    const properties& props /*=properties()*/
+trace_clock::time_point async_client::trace_start() noexcept
+{
+#if defined(PAHO_MQTTPP_NO_TRACE)
+    return trace_clock::time_point{};
+#else
+    auto rate = traceRate_.load(std::memory_order_relaxed);
+    if (rate == 0 || traceCount_.fetch_add(1, std::memory_order_relaxed) % rate != 0)
+        return trace_clock::time_point{};
+    return trace_clock::now();
+#endif
+}
+
+void async_client::trace(trace_point pt, const message& msg, trace_clock::time_point t) const
+{
+    // The handler is run on a library thread, so it can't be allowed to throw.
+    if (auto handler = traceHandler_.load()) {
+        try {
+            (*handler)(pt, msg, t);
+        }
+        catch (...) {
+        }
+    }
+}
+
+// --------------------------------------------------------------------------
+// Callback timing
+//
+// The callbacks all check for the epoch from callback_start(), so they
+// only pay for a second read of the clock when timing is on.
+
+void async_client::set_slow_callback_handler(
+    slow_callback_handler cb, std::chrono::microseconds threshold
 )
 {
-    auto msg = message::create(std::move(topic), std::move(payload), qos, retained, props);
-    return publish(std::move(msg));
+    if (cb) {
+        slowCbThreshold_.store(int64_t(threshold.count()), std::memory_order_relaxed);
+        slowCbHandler_.store(std::move(cb));
+        timeCallbacks_.store(true, std::memory_order_relaxed);
+    }
+    else {
+        timeCallbacks_.store(false, std::memory_order_relaxed);
+        slowCbHandler_.reset();
+    }
 }
 
-delivery_token_ptr async_client::publish(
-    string_ref topic, const void* payload, size_t n, int qos, bool retained,
-    void* userContext, iaction_listener& cb
+void async_client::callback_done(
+    callback_point pt, std::string_view what, trace_clock::time_point start
 )
 {
-    auto msg = message::create(std::move(topic), payload, n, qos, retained);
-    return publish(std::move(msg), userContext, cb);
+    if (start == trace_clock::time_point{})
+        return;
+
+    auto elapsed =
+        std::chrono::duration_cast<std::chrono::microseconds>(trace_clock::now() - start);
+    callbackTime_.record(elapsed);
+
+    if (elapsed.count() < slowCbThreshold_.load(std::memory_order_relaxed))
+        return;
+
+    nSlowCallbacks_.fetch_add(1, std::memory_order_relaxed);
+
+    // The handler is run on a library thread, so it can't be allowed to throw.
+    if (auto handler = slowCbHandler_.load()) {
+        try {
+            (*handler)(pt, what, elapsed);
+        }
+        catch (...) {
+        }
+    }
 }
 
-delivery_token_ptr async_client::publish(const_message_ptr msg)
+// The operation is named for the handler, along with the topic of a
+// publish or the first filter of a subscribe or unsubscribe.
+
+void async_client::listener_done(const token& tok, trace_clock::time_point start)
 {
-    auto tok = delivery_token::create(*this, msg);
-    add_token(tok);
+    if (start == trace_clock::time_point{})
+        return;
 
-    delivery_response_options rspOpts(tok, mqttVersion_);
+    string what;
+    switch (tok.get_type()) {
+        case token::Type::CONNECT:
+            what = "connect";
+            break;
+        case token::Type::SUBSCRIBE:
+            what = "subscribe";
+            break;
+        case token::Type::PUBLISH:
+            what = "publish";
+            break;
+        case token::Type::UNSUBSCRIBE:
+            what = "unsubscribe";
+            break;
+        case token::Type::DISCONNECT:
+            what = "disconnect";
+            break;
+    }
 
-    int rc =
-        MQTTAsync_sendMessage(cli_, msg->get_topic().c_str(), &(msg->msg_), &rspOpts.opts_);
+    if (tok.get_type() == token::Type::PUBLISH) {
+        if (auto msg = static_cast<const delivery_token&>(tok).get_message(); msg)
+            what += " " + msg->get_topic();
+    }
+    else if (auto topics = tok.get_topics(); topics && !topics->empty())
+        what += " " + (*topics)[0];
 
-    if (rc == MQTTASYNC_SUCCESS) {
-        tok->set_message_id(rspOpts.opts_.token);
+    callback_done(callback_point::ACTION, what, start);
+}
+
+// --------------------------------------------------------------------------
+// RTT probing
+//
+// The probes are sent without holding the lock, like the other messages,
+// so the acknowledgment can come back before the message ID is known. A
+// probe then matches any acknowledgment while its ID is unknown, which
+// only miscounts a stale probe answered in that brief window.
+
+void async_client::start_rtt_probe(std::chrono::milliseconds interval, const string& topic)
+{
+    if (interval.count() <= 0) {
+        stop_rtt_probe();
+        return;
     }
-    else {
-        remove_token(tok);
-        throw exception(rc);
+
+    uint64_t gen;
+    {
+        guard g(rttLock_);
+        rttTopic_ = topic.empty() ? ("paho/rtt/" + get_client_id()) : topic;
+        rttInterval_ = interval;
+        gen = ++rttGen_;
     }
+    schedule_rtt_probe(gen);
+}
 
-    return tok;
+// A probe still in flight is dropped, so the next one can go out as soon as
+// the probing starts again, and its late answer isn't counted.
+
+void async_client::stop_rtt_probe()
+{
+    guard g(rttLock_);
+    ++rttGen_;
+    rttPending_ = false;
+    rttTok_ = 0;
+}
+
+void async_client::schedule_rtt_probe(uint64_t gen)
+{
+    std::chrono::milliseconds interval;
+    {
+        guard g(rttLock_);
+        interval = rttInterval_;
+    }
+    timers()->schedule(interval, [this, gen] { send_rtt_probe(gen); });
+}
+
+// This runs on the timer thread, which the destructor stops before the
+// client goes away, so the timer can hold a plain pointer to the client.
+
+void async_client::send_rtt_probe(uint64_t gen)
+{
+    if (gen != rttGen_.load())
+        return;
+
+    // There's no server to time in loopback mode
+    if (!loopback_ && to_bool(MQTTAsync_isConnected(cli_))) {
+        auto now = trace_clock::now();
+        string topic;
+        bool send = false;
+        {
+            guard g(rttLock_);
+            if (!rttPending_ || now - rttSent_ >= rttInterval_) {
+                rttPending_ = send = true;
+                rttTok_ = 0;
+                rttSent_ = now;
+                topic = rttTopic_;
+            }
+        }
+
+        if (send) {
+            MQTTAsync_message msg = MQTTAsync_message_initializer;
+            msg.qos = 1;
+
+            MQTTAsync_responseOptions opts = MQTTAsync_responseOptions_initializer;
+            opts.context = this;
+            if (mqttVersion_ >= MQTTVERSION_5) {
+                opts.onSuccess5 = &async_client::on_rtt_success5;
+                opts.onFailure5 = &async_client::on_rtt_failure5;
+            }
+            else {
+                opts.onSuccess = &async_client::on_rtt_success;
+                opts.onFailure = &async_client::on_rtt_failure;
+            }
+
+            int rc = MQTTAsync_sendMessage(cli_, topic.c_str(), &msg, &opts);
+
+            guard g(rttLock_);
+            if (rc != MQTTASYNC_SUCCESS)
+                rttPending_ = false;
+            else if (rttPending_ && rttTok_ == 0)
+                rttTok_ = opts.token;
+        }
+    }
+
+    schedule_rtt_probe(gen);
+}
+
+// The average is smoothed like the TCP round trip estimate, with each new
+// time given a weight of 1/8.
+
+void async_client::record_rtt(trace_clock::duration rtt)
+{
+    auto us = std::chrono::duration_cast<std::chrono::microseconds>(rtt);
+    bool first = (rttLatency_.count() == 0);
+    rttLatency_.record(us);
+
+    int64_t avg = rttAvg_.load(std::memory_order_relaxed);
+    avg = first ? int64_t(us.count()) : (avg + (int64_t(us.count()) - avg) / 8);
+    rttAvg_.store(avg, std::memory_order_relaxed);
+}
+
+void async_client::on_rtt_complete(MQTTAsync_token tok, bool ok)
+{
+    trace_clock::time_point sent;
+    {
+        guard g(rttLock_);
+        if (!rttPending_ || (rttTok_ != 0 && rttTok_ != tok))
+            return;
+        rttPending_ = false;
+        sent = rttSent_;
+    }
+
+    if (ok)
+        record_rtt(trace_clock::now() - sent);
+}
+
+void async_client::on_rtt_success(void* context, MQTTAsync_successData* rsp)
+{
+    if (context)
+        static_cast<async_client*>(context)->on_rtt_complete(rsp ? rsp->token : 0, true);
+}
+
+void async_client::on_rtt_success5(void* context, MQTTAsync_successData5* rsp)
+{
+    if (context) {
+        bool ok = !rsp || rsp->reasonCode < MQTTREASONCODE_UNSPECIFIED_ERROR;
+        static_cast<async_client*>(context)->on_rtt_complete(rsp ? rsp->token : 0, ok);
+    }
 }
 
-delivery_token_ptr async_client::publish(
-    const_message_ptr msg, void* userContext, iaction_listener& cb
-)
-{
-    delivery_token_ptr tok = delivery_token::create(*this, msg, userContext, cb);
-    add_token(tok);
+void async_client::on_rtt_failure(void* context, MQTTAsync_failureData* rsp)
+{
+    if (context)
+        static_cast<async_client*>(context)->on_rtt_complete(rsp ? rsp->token : 0, false);
+}
+
+void async_client::on_rtt_failure5(void* context, MQTTAsync_failureData5* rsp)
+{
+    if (context)
+        static_cast<async_client*>(context)->on_rtt_complete(rsp ? rsp->token : 0, false);
+}
+
+// --------------------------------------------------------------------------
+// Publish
+
+delivery_token_ptr async_client::publish(
+    string_ref topic, const void* payload, size_t n, int qos, bool retained,
+    const properties& props /*=properties()*/
+)
+{
+    auto msg = message::create(std::move(topic), payload, n, qos, retained, props);
+    return publish(std::move(msg));
+}
+
+delivery_token_ptr async_client::publish(
+    string_ref topic, binary_ref payload, int qos, bool retained,
+    const properties& props /*=properties()*/
+)
+{
+    auto msg = message::create(std::move(topic), std::move(payload), qos, retained, props);
+    return publish(std::move(msg));
+}
+
+delivery_token_ptr async_client::publish(
+    string_ref topic, const void* payload, size_t n, int qos, bool retained,
+    void* userContext, iaction_listener& cb
+)
+{
+    auto msg = message::create(std::move(topic), payload, n, qos, retained);
+    return publish(std::move(msg), userContext, cb);
+}
+
+// The alias lock is held across the send, so that the message that tells
+// the server about a new alias is queued ahead of any that use it.
+
+int async_client::send_publish(const message& msg, MQTTAsync_responseOptions* opts)
+{
+    if (loopback_)
+        return loopback_publish(msg, opts);
+
+    const auto& topic = msg.get_topic();
+
+    if (!topicAliases_ || msg.get_qos() != 0 ||
+        msg.get_properties().contains(property::TOPIC_ALIAS))
+        return MQTTAsync_sendMessage(cli_, topic.c_str(), &(msg.msg_), opts);
+
+    guard g(aliasLock_);
+    bool known = false;
+    auto alias = topicAliases_->get(topic, known);
+
+    if (alias == 0)
+        return MQTTAsync_sendMessage(cli_, topic.c_str(), &(msg.msg_), opts);
+
+    properties props{msg.get_properties()};
+    props.add({property::TOPIC_ALIAS, alias});
+
+    MQTTAsync_message cmsg = msg.msg_;
+    cmsg.properties = props.c_struct();
+
+    int rc = MQTTAsync_sendMessage(cli_, known ? "" : topic.c_str(), &cmsg, opts);
+
+    if (rc != MQTTASYNC_SUCCESS && !known)
+        topicAliases_->remove(topic);
+    return rc;
+}
+
+// The arrival is made the way the C lib makes one, with its own copies
+// of everything, so that on_message_arrived() can take it over and free it.
+// Like a server, this clears the retained flag on the live delivery.
+
+int async_client::loopback_publish(const message& msg, MQTTAsync_responseOptions* opts)
+{
+    if (!loopConnected_)
+        return MQTTASYNC_DISCONNECTED;
+
+    const auto& topic = msg.get_topic();
+    const auto& cmsg = msg.msg_;
+    size_t n = size_t(std::max(cmsg.payloadlen, 0));
+
+    auto arrived = static_cast<MQTTAsync_message*>(MQTTAsync_malloc(sizeof(MQTTAsync_message)));
+    auto topicName = static_cast<char*>(MQTTAsync_malloc(topic.size() + 1));
+    void* payload = (n > 0) ? MQTTAsync_malloc(n) : nullptr;
+
+    if (!arrived || !topicName || (n > 0 && !payload)) {
+        MQTTAsync_free(arrived);
+        MQTTAsync_free(topicName);
+        MQTTAsync_free(payload);
+        return MQTTASYNC_FAILURE;
+    }
+
+    int msgId = loopMsgId_.fetch_add(1, std::memory_order_relaxed) % 65535 + 1;
+
+    *arrived = cmsg;
+    arrived->payload = payload;
+    arrived->payloadlen = int(n);
+    if (n > 0)
+        std::memcpy(payload, cmsg.payload, n);
+    arrived->retained = 0;
+    arrived->dup = 0;
+    arrived->msgid = (cmsg.qos > 0) ? msgId : 0;
+    arrived->properties = MQTTProperties_copy(&cmsg.properties);
+
+    std::memcpy(topicName, topic.data(), topic.size());
+    topicName[topic.size()] = '\0';
+
+    // A refused message would be offered again by the C lib, but here
+    // it's just dropped.
+    if (!on_message_arrived(this, topicName, int(topic.size()), arrived)) {
+        MQTTAsync_freeMessage(&arrived);
+        MQTTAsync_free(topicName);
+    }
+
+    if (opts) {
+        opts->token = msgId;
+        if (opts->onSuccess5) {
+            MQTTAsync_successData5 rsp = MQTTAsync_successData5_initializer;
+            rsp.token = msgId;
+            opts->onSuccess5(opts->context, &rsp);
+        }
+        else if (opts->onSuccess) {
+            MQTTAsync_successData rsp{};
+            rsp.token = msgId;
+            opts->onSuccess(opts->context, &rsp);
+        }
+    }
+    return MQTTASYNC_SUCCESS;
+}
+
+// Requests complete without a response from a server, such as the granted
+// QoS for a subscription.
+
+int async_client::loopback_complete(MQTTAsync_responseOptions* opts)
+{
+    if (!loopConnected_)
+        return MQTTASYNC_DISCONNECTED;
+
+    if (opts->onSuccess5)
+        opts->onSuccess5(opts->context, nullptr);
+    else if (opts->onSuccess)
+        opts->onSuccess(opts->context, nullptr);
+    return MQTTASYNC_SUCCESS;
+}
+
+// The connect token gets a response, as if from a server, for the
+// synchronous client, which reads it. It's kept out of the way of the
+// connected callback so that it isn't completed twice.
+
+void async_client::loopback_connect()
+{
+    loopConnected_ = true;
+
+    auto tok = std::move(connTok_);
+    auto uri = get_server_uri();
+
+    MQTTAsync_successData rsp{};
+    rsp.alt.connect.serverURI = const_cast<char*>(uri.c_str());
+    rsp.alt.connect.MQTTVersion = (mqttVersion_ > 0) ? mqttVersion_ : MQTTVERSION_3_1_1;
+    tok->on_success(&rsp);
+
+    on_connected(this, nullptr);
+    connTok_ = std::move(tok);
+}
+
+// If there's a publish window, room for the message must have been
+// acquired before this is called. It's released when the token is removed.
+
+delivery_token_ptr async_client::send_message(
+    delivery_token_ptr tok, trace_clock::time_point pubTime
+)
+{
+    int rc = send_token(tok, pubTime);
+    if (rc != MQTTASYNC_SUCCESS)
+        throw exception(rc);
+    return tok;
+}
+
+int async_client::send_token(const delivery_token_ptr& tok, trace_clock::time_point pubTime)
+{
+    add_token(tok);
+
+    if (defer_send(tok, pubTime))
+        return MQTTASYNC_SUCCESS;
+
+    delivery_response_options rspOpts(tok, mqttVersion_);
+    int rc = transmit(tok, pubTime, rspOpts);
+
+    if (rc != MQTTASYNC_SUCCESS)
+        remove_token(tok);
+
+    return rc;
+}
+
+int async_client::transmit(
+    const delivery_token_ptr& tok, trace_clock::time_point pubTime,
+    delivery_response_options& rspOpts
+)
+{
+    const auto& msg = tok->msg_;
+
+    tok->sendTime_ = std::chrono::steady_clock::now();
+    if (pubTime != trace_clock::time_point{}) {
+        tok->traced_ = true;
+        trace(trace_point::PUBLISH, *msg, pubTime);
+        trace(trace_point::SEND, *msg, tok->sendTime_);
+    }
+    int rc = send_publish(*msg, &rspOpts.opts_);
+
+    if (rc == MQTTASYNC_SUCCESS) {
+        tok->set_message_id(rspOpts.opts_.token);
+        nPublished_.fetch_add(1, std::memory_order_relaxed);
+        nBytesPublished_.fetch_add(window_size(msg), std::memory_order_relaxed);
+        if (topicStats_)
+            topicStats_->count_published(*msg);
+    }
+    return rc;
+}
+
+// Once anything is waiting, new messages queue up behind it, so that they
+// still go out in the order that they were published.
+
+bool async_client::defer_send(const delivery_token_ptr& tok, trace_clock::time_point pubTime)
+{
+    if (!flowControl_ || tok->msg_->get_qos() == 0)
+        return false;
+
+    guard g(flowLock_);
+    if (nInFlight_ < recvMax_ && deferred_.empty()) {
+        ++nInFlight_;
+        tok->inFlight_ = true;
+        return false;
+    }
+
+    deferred_.push_back({tok, pubTime});
+    return true;
+}
+
+// Only one thread sends the deferred messages at a time. A message that
+// fails here is completed from within the loop, which releases its slot
+// through remove_token(), so the flag also keeps that from recursing.
+
+void async_client::send_deferred()
+{
+    {
+        guard g(flowLock_);
+        if (sendingDeferred_)
+            return;
+        sendingDeferred_ = true;
+    }
+
+    delivery_response_options rspOpts(mqttVersion_);
+
+    while (true) {
+        deferred_send d;
+        {
+            guard g(flowLock_);
+            if (deferred_.empty() || nInFlight_ >= recvMax_) {
+                sendingDeferred_ = false;
+                return;
+            }
+            d = std::move(deferred_.front());
+            deferred_.pop_front();
+            ++nInFlight_;
+            d.tok->inFlight_ = true;
+        }
+
+        rspOpts.set_token(d.tok);
+        int rc = transmit(d.tok, d.pubTime, rspOpts);
+
+        if (rc != MQTTASYNC_SUCCESS) {
+            MQTTAsync_failureData rsp{};
+            rsp.code = rc;
+            d.tok->on_failure(&rsp);
+        }
+    }
+}
+
+// The tokens are completed outside the lock, since completing them calls
+// back into the client.
+
+void async_client::fail_deferred(int rc)
+{
+    std::deque<deferred_send> deferred;
+    {
+        guard g(flowLock_);
+        deferred.swap(deferred_);
+    }
+
+    for (auto& d : deferred) {
+        MQTTAsync_failureData rsp{};
+        rsp.code = rc;
+        d.tok->on_failure(&rsp);
+    }
+}
+
+// --------------------------------------------------------------------------
+// Offline buffer
+//
+// The messages are buffered as published, before the payload codec, since
+// the codec tags the payload with a property, and the properties are lost
+// if the message spills to disk.
+
+delivery_token_ptr async_client::buffer_offline(
+    const const_message_ptr& msg, void* userContext, iaction_listener* cb
+)
+{
+    delivery_token_ptr tok, spilled;
+    {
+        guard g(drainLock_);
+        if (drainOnline_ && !draining_ && offlineBuf_->empty())
+            return tok;
+
+        tok = cb ? make_delivery_token(msg, userContext, *cb) : make_delivery_token(msg);
+        spilled = tok;
+        if (!offlineBuf_->push(msg, spilled))
+            throw exception(MQTTASYNC_MAX_BUFFERED_MESSAGES);
+    }
+    drainCond_.notify_all();
+
+    // A message on disk can't keep its token, so it's done as far as the
+    // application can tell.
+    if (spilled)
+        spilled->on_success(nullptr);
+    return tok;
+}
+
+void async_client::set_buffer_online(bool on)
+{
+    {
+        guard g(drainLock_);
+        drainOnline_ = on;
+    }
+    drainCond_.notify_all();
+}
+
+// A message that can't be sent because the connection dropped again is
+// held, and sent first once the client is back. Any other failure loses
+// the message, and is counted as a publish error. A message from memory
+// is sent with the token that the application got for it.
+
+void async_client::run_drain()
+{
+    using clock = std::chrono::steady_clock;
+
+    unique_lock g(drainLock_);
+    const_message_ptr msg;
+    delivery_token_ptr msgTok;
+    auto nextTime = clock::now();
+
+    while (true) {
+        drainCond_.wait(g, [this, &msg] {
+            return drainStop_ || (drainOnline_ && (msg || !offlineBuf_->empty()));
+        });
+        if (drainStop_)
+            break;
+
+        auto rate = offlineBuf_->drain_rate();
+        if (rate > 0.0) {
+            if (drainCond_.wait_until(g, nextTime, [this] {
+                    return drainStop_ || !drainOnline_;
+                }))
+                continue;
+            nextTime = std::max(nextTime, clock::now()) +
+                       std::chrono::duration_cast<clock::duration>(
+                           std::chrono::duration<double>(1.0 / rate)
+                       );
+        }
+
+        if (!msg) {
+            try {
+                msg = offlineBuf_->try_pop(msgTok);
+            }
+            catch (const exception&) {
+                // The segment file can't be read, so what's in it is lost.
+                offlineBuf_->clear();
+                continue;
+            }
+        }
+
+        draining_ = true;
+        g.unlock();
+
+        bool sent = true;
+        try {
+            publish_now(msg, msgTok);
+        }
+        catch (const exception& ex) {
+            int rc = ex.get_return_code();
+            sent = (rc != MQTTASYNC_DISCONNECTED);
+            if (sent) {
+                nPublishErrors_.fetch_add(1, std::memory_order_relaxed);
+                if (msgTok) {
+                    MQTTAsync_failureData rsp{};
+                    rsp.code = rc;
+                    msgTok->on_failure(&rsp);
+                }
+            }
+        }
+
+        g.lock();
+        draining_ = false;
+        if (sent) {
+            msg.reset();
+            msgTok.reset();
+        }
+        else
+            drainOnline_ = false;
+    }
+
+    // A message held back for the next connection won't be sent now
+    if (msgTok) {
+        g.unlock();
+        MQTTAsync_failureData rsp{};
+        rsp.code = MQTTASYNC_OPERATION_INCOMPLETE;
+        msgTok->on_failure(&rsp);
+    }
+}
+
+const_message_ptr async_client::encode_payload(const_message_ptr msg) const
+{
+    const auto& codec = createOpts_.payloadCodec_;
+
+    if (!codec || !msg || mqttVersion_ < MQTTVERSION_5 ||
+        msg->get_payload_ref().size() <= createOpts_.codecThreshold_)
+        return msg;
+
+    const auto& props = msg->get_properties();
+    if (props.contains_user_property(payload_codec::PROPERTY_NAME))
+        return msg;
+
+    auto m = std::make_shared<message>(*msg);
+    m->set_payload(codec->encode(msg->get_payload_ref()));
+
+    auto encProps = props;
+    encProps.add({property::USER_PROPERTY, payload_codec::PROPERTY_NAME, codec->name()});
+    m->set_properties(std::move(encProps));
+    return m;
+}
+
+// A message that goes into the offline buffer in memory gets a token that
+// completes when it's finally sent. One that spills to disk gets a token
+// that's already complete, since the file can't hold the token.
+
+delivery_token_ptr async_client::publish(const_message_ptr msg)
+{
+    if (offlineBuf_) {
+        if (auto tok = buffer_offline(msg); tok)
+            return tok;
+    }
+    if (shaper_) {
+        auto tok = make_delivery_token(msg);
+        if (auto act = shape(msg, true, tok); act != publish_shaper::action::SEND)
+            return shaped_token(std::move(tok), act);
+        return publish_now(std::move(msg), std::move(tok));
+    }
+    return publish_now(std::move(msg));
+}
+
+delivery_token_ptr async_client::publish_now(const_message_ptr msg, delivery_token_ptr tok)
+{
+    auto t = trace_start();
+    msg = encode_payload(std::move(msg));
+    memBudget_->wait(token_memory(msg));
+    if (pubWindow_)
+        pubWindow_->acquire(window_size(msg));
+
+    if (tok)
+        tok->set_message(std::move(msg));
+    else
+        tok = make_delivery_token(std::move(msg));
+
+    return send_message(std::move(tok), t);
+}
+
+delivery_token_ptr async_client::try_publish(const_message_ptr msg)
+{
+    if (offlineBuf_) {
+        if (auto tok = buffer_offline(msg); tok)
+            return tok;
+    }
+    delivery_token_ptr tok;
+    if (shaper_) {
+        tok = make_delivery_token(msg);
+        if (auto act = shape(msg, false, tok); act != publish_shaper::action::SEND)
+            return (act == publish_shaper::action::WAIT) ? delivery_token_ptr{}
+                                                         : shaped_token(std::move(tok), act);
+    }
+
+    auto t = trace_start();
+    msg = encode_payload(std::move(msg));
+    if (!memBudget_->has_room(token_memory(msg)))
+        return delivery_token_ptr{};
+    if (pubWindow_ && !pubWindow_->try_acquire(window_size(msg)))
+        return delivery_token_ptr{};
+
+    if (tok)
+        tok->set_message(std::move(msg));
+    else
+        tok = make_delivery_token(std::move(msg));
+
+    return send_message(std::move(tok), t);
+}
+
+// The expected failures are return codes all the way down. Only the
+// unexpected ones, like running out of memory, are caught and converted.
+
+publish_result async_client::try_publish(const_message_ptr msg, const std::nothrow_t&) noexcept
+{
+    try {
+        if (!msg)
+            return MQTTASYNC_NULL_PARAMETER;
+
+        if (offlineBuf_) {
+            if (auto tok = buffer_offline(msg); tok)
+                return tok;
+        }
+        if (shaper_) {
+            auto tok = make_delivery_token(msg);
+            if (auto act = shape(msg, false, tok); act != publish_shaper::action::SEND) {
+                if (act == publish_shaper::action::WAIT)
+                    return MQTTASYNC_MAX_BUFFERED_MESSAGES;
+                return shaped_token(std::move(tok), act);
+            }
+            return try_send(std::move(msg), std::move(tok));
+        }
+        return try_send(std::move(msg));
+    }
+    catch (const exception& ex) {
+        return ex.get_return_code();
+    }
+    catch (...) {
+        return MQTTASYNC_FAILURE;
+    }
+}
+
+publish_result async_client::try_send(const_message_ptr msg, delivery_token_ptr tok)
+{
+    auto t = trace_start();
+    msg = encode_payload(std::move(msg));
+    if (!memBudget_->has_room(token_memory(msg)))
+        return MQTTASYNC_MAX_BUFFERED_MESSAGES;
+    if (pubWindow_ && !pubWindow_->try_acquire(window_size(msg)))
+        return MQTTASYNC_MAX_BUFFERED_MESSAGES;
+
+    if (tok)
+        tok->set_message(std::move(msg));
+    else
+        tok = make_delivery_token(std::move(msg));
+
+    int rc = send_token(tok, t);
+    if (rc != MQTTASYNC_SUCCESS)
+        return rc;
+    return tok;
+}
+
+publish_result async_client::try_publish(
+    string_ref topic, const void* payload, size_t n, int qos, bool retained,
+    const std::nothrow_t& nt
+) noexcept
+{
+    try {
+        return try_publish(make_message(std::move(topic), payload, n, qos, retained), nt);
+    }
+    catch (...) {
+        return MQTTASYNC_FAILURE;
+    }
+}
+
+// A message that has to wait is delayed on the publisher's own thread, so
+// the publishers over the rate are the ones that slow down. A held message
+// is released from the timer thread, which can't block, so it's only sent
+// if there's room for it.
+//
+// A held message keeps its token until it's sent, like one in the offline
+// buffer. The token is stored under the same lock as the shaper is asked,
+// so that a release can't come between them, and the one for a message
+// that was replaced is failed outside of it.
+
+publish_shaper::action async_client::shape(
+    const const_message_ptr& msg, bool canWait, const delivery_token_ptr& tok
+)
+{
+    publish_shaper::decision d;
+    delivery_token_ptr replaced;
+    {
+        guard g(shapedLock_);
+        d = shaper_->admit(msg, canWait);
+
+        if (d.act == publish_shaper::action::HOLD ||
+            d.act == publish_shaper::action::COALESCED)
+            replaced = std::exchange(shapedToks_[msg->get_topic()], tok);
+    }
+
+    if (replaced) {
+        MQTTAsync_failureData rsp{};
+        rsp.code = MQTTASYNC_MAX_BUFFERED_MESSAGES;
+        replaced->on_failure(&rsp);
+    }
+
+    if (d.act == publish_shaper::action::WAIT && canWait) {
+        std::this_thread::sleep_for(d.delay);
+        return publish_shaper::action::SEND;
+    }
+
+    if (d.act == publish_shaper::action::HOLD) {
+        auto topic = msg->get_topic();
+        timers()->schedule(d.delay, [this, topic] { release_shaped(topic); });
+    }
+    return d.act;
+}
+
+delivery_token_ptr async_client::shaped_token(
+    delivery_token_ptr tok, publish_shaper::action act
+)
+{
+    if (act == publish_shaper::action::DROP) {
+        MQTTAsync_failureData rsp{};
+        rsp.code = MQTTASYNC_MAX_BUFFERED_MESSAGES;
+        tok->on_failure(&rsp);
+    }
+    return tok;
+}
+
+// The message is gone if its rule was removed, so its token fails like
+// that of one that was dropped.
+
+void async_client::release_shaped(const string& topic)
+{
+    const_message_ptr msg;
+    delivery_token_ptr tok;
+    {
+        guard g(shapedLock_);
+        msg = shaper_->release(topic);
+        if (auto it = shapedToks_.find(topic); it != shapedToks_.end()) {
+            tok = std::move(it->second);
+            shapedToks_.erase(it);
+        }
+    }
+
+    int rc = MQTTASYNC_MAX_BUFFERED_MESSAGES;
+    if (msg) {
+        try {
+            auto res = try_send(std::move(msg), tok);
+            if (res.ok())
+                return;
+            rc = res.error();
+        }
+        catch (const exception& ex) {
+            rc = ex.get_return_code();
+        }
+        catch (...) {
+            rc = MQTTASYNC_FAILURE;
+        }
+        nPublishErrors_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    if (tok) {
+        MQTTAsync_failureData rsp{};
+        rsp.code = rc;
+        tok->on_failure(&rsp);
+    }
+}
+
+// The fire-and-forget path. There's no token to complete, so the message
+// is sent without callbacks and isn't held in the publish window.
+
+int async_client::publish_nowait(const_message_ptr msg) noexcept
+{
+    int rc = MQTTASYNC_NULL_PARAMETER;
+    auto act = publish_shaper::action::SEND;
+
+    try {
+        if (msg && msg->get_qos() != 0)
+            rc = MQTTASYNC_BAD_QOS;
+        else if (msg && shaper_ && (act = shape(msg, false)) != publish_shaper::action::SEND) {
+            // A held message is counted when it's sent
+            if (act == publish_shaper::action::HOLD || act == publish_shaper::action::COALESCED)
+                return MQTTASYNC_SUCCESS;
+            rc = MQTTASYNC_MAX_BUFFERED_MESSAGES;
+        }
+        else if (msg) {
+            auto t = trace_start();
+            msg = encode_payload(std::move(msg));
+
+            if (t != trace_clock::time_point{}) {
+                trace(trace_point::PUBLISH, *msg, t);
+                trace(trace_point::SEND, *msg, trace_clock::now());
+            }
+
+            MQTTAsync_responseOptions opts = MQTTAsync_responseOptions_initializer;
+            rc = send_publish(*msg, &opts);
+
+            if (rc == MQTTASYNC_SUCCESS && topicStats_)
+                topicStats_->count_published(*msg);
+        }
+    }
+    catch (const exception& ex) {
+        rc = ex.get_return_code();
+    }
+    catch (...) {
+        rc = MQTTASYNC_FAILURE;
+    }
+
+    if (rc == MQTTASYNC_SUCCESS) {
+        nPublished_.fetch_add(1, std::memory_order_relaxed);
+        nBytesPublished_.fetch_add(window_size(msg), std::memory_order_relaxed);
+    }
+    else
+        nPublishErrors_.fetch_add(1, std::memory_order_relaxed);
+
+    return rc;
+}
+
+int async_client::publish_nowait(
+    string_ref topic, const void* payload, size_t n, bool retained
+) noexcept
+{
+    try {
+        return publish_nowait(make_message(std::move(topic), payload, n, 0, retained));
+    }
+    catch (...) {
+        nPublishErrors_.fetch_add(1, std::memory_order_relaxed);
+        return MQTTASYNC_FAILURE;
+    }
+}
+
+delivery_token_ptr async_client::publish(
+    const_message_ptr msg, void* userContext, iaction_listener& cb
+)
+{
+    if (offlineBuf_) {
+        if (auto tok = buffer_offline(msg, userContext, &cb); tok)
+            return tok;
+    }
+    delivery_token_ptr tok;
+    if (shaper_) {
+        tok = make_delivery_token(msg, userContext, cb);
+        if (auto act = shape(msg, true, tok); act != publish_shaper::action::SEND)
+            return shaped_token(std::move(tok), act);
+    }
+
+    auto t = trace_start();
+    msg = encode_payload(std::move(msg));
+    memBudget_->wait(token_memory(msg));
+    if (pubWindow_)
+        pubWindow_->acquire(window_size(msg));
+
+    if (tok)
+        tok->set_message(std::move(msg));
+    else
+        tok = make_delivery_token(std::move(msg), userContext, cb);
+
+    return send_message(std::move(tok), t);
+}
+
+batch_token_ptr async_client::publish_batch(
+    batch_token_ptr btok, const std::vector<const_message_ptr>& msgs
+)
+{
+    btok->toks_.reserve(msgs.size());
+    for (const auto& msg : msgs) btok->add(encode_payload(msg));
+    return send_batch(std::move(btok));
+}
+
+// The messages all forward the one, so they share its payload and
+// properties, and it only goes through the codec once.
+
+batch_token_ptr async_client::publish_fanout(
+    batch_token_ptr btok, const std::vector<string>& topics, const_message_ptr msg
+)
+{
+    if (!msg)
+        throw std::invalid_argument("No message to fan out");
+
+    msg = encode_payload(std::move(msg));
+
+    btok->toks_.reserve(topics.size());
+    for (const auto& topic : topics) btok->add(message::forward(msg, topic));
+    return send_batch(std::move(btok));
+}
+
+batch_token_ptr async_client::send_batch(batch_token_ptr btok)
+{
+    auto& toks = btok->toks_;
+
+    // The batch is charged to the memory budget as a whole, up front.
+    size_t nbytes = 0;
+    for (const auto& tok : toks) nbytes += token_memory(tok->msg_);
+    memBudget_->wait(nbytes);
+
+    // The client holds the batch until it completes.
+    add_token(btok);
+    auto now = std::chrono::steady_clock::now();
+    {
+        guard g(deliveryTokLock_);
+        for (const auto& tok : toks) {
+            charge_token(*tok);
+            insert_pending(tok, now);
+        }
+    }
+
+    delivery_response_options rspOpts(mqttVersion_);
+
+    for (const auto& tok : toks) {
+        auto pubTime = trace_start();
+
+        if (pubWindow_)
+            pubWindow_->acquire(window_size(tok->msg_));
 
-    delivery_response_options rspOpts(tok, mqttVersion_);
+        if (defer_send(tok, pubTime))
+            continue;
 
-    int rc =
-        MQTTAsync_sendMessage(cli_, msg->get_topic().c_str(), &(msg->msg_), &rspOpts.opts_);
+        rspOpts.set_token(tok);
+        int rc = transmit(tok, pubTime, rspOpts);
 
-    if (rc == MQTTASYNC_SUCCESS) {
-        tok->set_message_id(rspOpts.opts_.token);
-    }
-    else {
-        remove_token(tok);
-        throw exception(rc);
+        if (rc != MQTTASYNC_SUCCESS) {
+            // Fail the message as if the library reported it.
+            MQTTAsync_failureData rsp{};
+            rsp.code = rc;
+            tok->on_failure(&rsp);
+        }
     }
 
-    return tok;
+    btok->sent();
+    return btok;
 }
 
 // --------------------------------------------------------------------------
@@ -654,13 +2730,17 @@ token_ptr async_client::subscribe(
                        .properties(props)
                        .finalize();
 
-    int rc = MQTTAsync_subscribe(cli_, topicFilter.c_str(), qos, &rspOpts.opts_);
+    int rc = loopback_ ? loopback_complete(&rspOpts.opts_)
+                       : MQTTAsync_subscribe(cli_, topicFilter.c_str(), qos, &rspOpts.opts_);
 
     if (rc != MQTTASYNC_SUCCESS) {
         remove_token(tok);
+        if (rc == MQTTASYNC_DISCONNECTED)
+            track_subscriptions(*tok->get_topics(), qos_collection{qos}, {opts});
         throw exception(rc);
     }
 
+    track_subscriptions(*tok->get_topics(), qos_collection{qos}, {opts});
     return tok;
 }
 
@@ -680,13 +2760,17 @@ token_ptr async_client::subscribe(
                        .properties(props)
                        .finalize();
 
-    int rc = MQTTAsync_subscribe(cli_, topicFilter.c_str(), qos, &rspOpts.opts_);
+    int rc = loopback_ ? loopback_complete(&rspOpts.opts_)
+                       : MQTTAsync_subscribe(cli_, topicFilter.c_str(), qos, &rspOpts.opts_);
 
     if (rc != MQTTASYNC_SUCCESS) {
         remove_token(tok);
+        if (rc == MQTTASYNC_DISCONNECTED)
+            track_subscriptions(*tok->get_topics(), qos_collection{qos}, {opts});
         throw exception(rc);
     }
 
+    track_subscriptions(*tok->get_topics(), qos_collection{qos}, {opts});
     return tok;
 }
 
@@ -712,15 +2796,20 @@ token_ptr async_client::subscribe(
                        .properties(props)
                        .finalize();
 
-    int rc = MQTTAsync_subscribeMany(
-        cli_, int(n), topicFilters->c_arr(), const_cast<int*>(qos.data()), &rspOpts.opts_
-    );
+    int rc = loopback_ ? loopback_complete(&rspOpts.opts_)
+                       : MQTTAsync_subscribeMany(
+                             cli_, int(n), topicFilters->c_arr(),
+                             const_cast<int*>(qos.data()), &rspOpts.opts_
+                         );
 
     if (rc != MQTTASYNC_SUCCESS) {
         remove_token(tok);
+        if (rc == MQTTASYNC_DISCONNECTED)
+            track_subscriptions(*topicFilters, qos, opts);
         throw exception(rc);
     }
 
+    track_subscriptions(*topicFilters, qos, opts);
     return tok;
 }
 
@@ -747,18 +2836,258 @@ token_ptr async_client::subscribe(
                        .properties(props)
                        .finalize();
 
-    int rc = MQTTAsync_subscribeMany(
-        cli_, int(n), topicFilters->c_arr(), const_cast<int*>(qos.data()), &rspOpts.opts_
-    );
+    int rc = loopback_ ? loopback_complete(&rspOpts.opts_)
+                       : MQTTAsync_subscribeMany(
+                             cli_, int(n), topicFilters->c_arr(),
+                             const_cast<int*>(qos.data()), &rspOpts.opts_
+                         );
 
     if (rc != MQTTASYNC_SUCCESS) {
         remove_token(tok);
+        if (rc == MQTTASYNC_DISCONNECTED)
+            track_subscriptions(*topicFilters, qos, opts);
         throw exception(rc);
     }
 
+    track_subscriptions(*topicFilters, qos, opts);
     return tok;
 }
 
+size_t async_client::max_packet_size() const
+{
+    auto props = connect_properties();
+    if (props.contains(property::MAXIMUM_PACKET_SIZE))
+        return size_t(get<uint32_t>(props, property::MAXIMUM_PACKET_SIZE));
+    return DFLT_MAX_PACKET_SIZE;
+}
+
+// The filters are packed greedily into chunks, using a worst-case size for
+// the header of each SUBSCRIBE packet: the fixed header, the packet ID,
+// and the properties, which are repeated in every chunk. A filter that is
+// too big for any packet goes out on its own, for the server to reject.
+
+bulk_subscribe_token_ptr async_client::subscribe_bulk(
+    bulk_subscribe_token_ptr btok, const qos_collection& qos,
+    const std::vector<subscribe_options>& opts, const properties& props
+)
+{
+    const auto& topicFilters = btok->get_topics();
+    size_t n = topicFilters ? topicFilters->size() : 0;
+
+    if (n != qos.size() || (!opts.empty() && n != opts.size()))
+        throw std::invalid_argument("Collection sizes don't match");
+
+    if (n > 0)
+        track_subscriptions(*topicFilters, qos, opts);
+
+    return send_bulk(std::move(btok), qos, opts, props);
+}
+
+bulk_subscribe_token_ptr async_client::send_bulk(
+    bulk_subscribe_token_ptr btok, const qos_collection& qos,
+    const std::vector<subscribe_options>& opts, const properties& props
+)
+{
+    const auto& topicFilters = btok->get_topics();
+    size_t n = topicFilters ? topicFilters->size() : 0;
+
+    const size_t maxSz = max_packet_size();
+    const size_t hdrSz = 5 + 2 + 4 + size_t(props.c_struct().length);
+
+    // The client holds the bulk token until it completes.
+    add_token(btok);
+
+    size_t first = 0;
+    while (first < n) {
+        size_t last = first, sz = hdrSz;
+        do {
+            sz += 2 + (*topicFilters)[last].size() + 1;
+            ++last;
+        } while (last < n && last - first < MAX_BULK_FILTERS &&
+                 sz + 2 + (*topicFilters)[last].size() + 1 <= maxSz);
+
+        size_t nChunk = last - first;
+        auto tok = token::create(token::Type::SUBSCRIBE, *this, topicFilters);
+        tok->set_num_expected(nChunk);
+        btok->add(tok, first);
+        add_token(tok);
+
+        std::vector<subscribe_options> chunkOpts;
+        if (!opts.empty())
+            chunkOpts.assign(opts.begin() + first, opts.begin() + last);
+
+        auto rspOpts = response_options_builder(mqttVersion_)
+                           .token(tok)
+                           .subscribe_opts(chunkOpts)
+                           .properties(props)
+                           .finalize();
+
+        int rc = loopback_ ? loopback_complete(&rspOpts.opts_)
+                           : MQTTAsync_subscribeMany(
+                                 cli_, int(nChunk), topicFilters->c_arr() + first,
+                                 const_cast<int*>(qos.data() + first), &rspOpts.opts_
+                             );
+
+        if (rc != MQTTASYNC_SUCCESS) {
+            // Fail the chunk as if the library reported it.
+            MQTTAsync_failureData rsp{};
+            rsp.code = rc;
+            tok->on_failure(&rsp);
+        }
+        first = last;
+    }
+
+    btok->sent();
+    return btok;
+}
+
+// The tracked subscriptions are those that the application asked for,
+// whether or not the server has acknowledged them yet. A subscribe that
+// fails because the client is disconnected is still tracked, so it's sent
+// when the client connects.
+
+void async_client::track_subscriptions(
+    const string_collection& filters, const qos_collection& qos,
+    const std::vector<subscribe_options>& opts
+)
+{
+    if (!restoreSubs_)
+        return;
+
+    guard g(subsLock_);
+    for (size_t i = 0; i < filters.size(); ++i) {
+        subs_[filters[i]] = tracked_subscription{
+            qos[i], i < opts.size() ? opts[i] : subscribe_options{}
+        };
+    }
+    subFilters_.reset();
+}
+
+void async_client::untrack_subscriptions(const string_collection& filters)
+{
+    if (!restoreSubs_)
+        return;
+
+    guard g(subsLock_);
+    for (size_t i = 0; i < filters.size(); ++i) subs_.erase(filters[i]);
+    subFilters_.reset();
+}
+
+void async_client::update_subscription_layout() const
+{
+    if (subFilters_)
+        return;
+
+    auto filters = std::make_shared<string_collection>();
+    subQos_.clear();
+    subOpts_.clear();
+    subQos_.reserve(subs_.size());
+    subOpts_.reserve(subs_.size());
+
+    for (const auto& [filter, sub] : subs_) {
+        filters->push_back(filter);
+        subQos_.push_back(sub.qos);
+        subOpts_.push_back(sub.opts);
+    }
+    subFilters_ = std::move(filters);
+}
+
+const_string_collection_ptr async_client::get_subscriptions() const
+{
+    guard g(subsLock_);
+    update_subscription_layout();
+    return subFilters_;
+}
+
+void async_client::restore_subscriptions()
+{
+    // If the server kept the session, it kept the subscriptions.
+    if (auto tok = connTok_; tok) {
+        token::guard g(tok->lock_);
+        if (tok->connRsp_ && tok->connRsp_->is_session_present())
+            return;
+    }
+
+    guard g(subsLock_);
+    update_subscription_layout();
+
+    if (subFilters_->empty()) {
+        restoreTok_.reset();
+        return;
+    }
+
+    // The failures are reported through the token, which is kept for the
+    // application. A chunk that can't be sent fails its own token, but
+    // anything else that goes wrong has to fail the bulk one.
+    auto btok = bulk_subscribe_token::create(*this, subFilters_);
+    restoreTok_ = btok;
+
+    try {
+        send_bulk(btok, subQos_, subOpts_, properties{});
+    }
+    catch (...) {
+        int expected = MQTTASYNC_SUCCESS;
+        btok->firstRc_.compare_exchange_strong(expected, MQTTASYNC_FAILURE);
+        btok->sent();
+    }
+}
+
+bulk_subscribe_token_ptr async_client::get_restore_token() const
+{
+    guard g(subsLock_);
+    return restoreTok_;
+}
+
+// --------------------------------------------------------------------------
+// Manual acknowledgment
+
+void async_client::track_unacked(const const_message_ptr& msg)
+{
+    guard g(ackLock_);
+    auto seq = nextAckSeq_++;
+    unacked_.emplace(seq, msg);
+    unackedSeq_.emplace(msg.get(), seq);
+    nUnacked_.store(unacked_.size(), std::memory_order_relaxed);
+}
+
+bool async_client::ack(const const_message_ptr& msg)
+{
+    guard g(ackLock_);
+    auto it = unackedSeq_.find(msg.get());
+    if (it == unackedSeq_.end())
+        return false;
+
+    unacked_.erase(it->second);
+    unackedSeq_.erase(it);
+    nUnacked_.store(unacked_.size(), std::memory_order_relaxed);
+    return true;
+}
+
+size_t async_client::ack_through(const const_message_ptr& msg)
+{
+    guard g(ackLock_);
+    auto it = unackedSeq_.find(msg.get());
+    if (it == unackedSeq_.end())
+        return 0;
+
+    auto last = unacked_.upper_bound(it->second);
+    size_t n = 0;
+    for (auto p = unacked_.begin(); p != last; ++p, ++n) unackedSeq_.erase(p->second.get());
+    unacked_.erase(unacked_.begin(), last);
+
+    nUnacked_.store(unacked_.size(), std::memory_order_relaxed);
+    return n;
+}
+
+std::vector<const_message_ptr> async_client::get_unacked() const
+{
+    std::vector<const_message_ptr> msgs;
+    guard g(ackLock_);
+    msgs.reserve(unacked_.size());
+    for (const auto& p : unacked_) msgs.push_back(p.second);
+    return msgs;
+}
+
 // --------------------------------------------------------------------------
 // Unsubscribe
 
@@ -768,11 +3097,13 @@ token_ptr async_client::
     auto tok = token::create(token::Type::UNSUBSCRIBE, *this, topicFilter);
     tok->set_num_expected(0);  // Indicates non-array response for single val
     add_token(tok);
+    untrack_subscriptions(*tok->get_topics());
 
     auto rspOpts =
         response_options_builder(mqttVersion_).token(tok).properties(props).finalize();
 
-    int rc = MQTTAsync_unsubscribe(cli_, topicFilter.c_str(), &rspOpts.opts_);
+    int rc = loopback_ ? loopback_complete(&rspOpts.opts_)
+                       : MQTTAsync_unsubscribe(cli_, topicFilter.c_str(), &rspOpts.opts_);
 
     if (rc != MQTTASYNC_SUCCESS) {
         remove_token(tok);
@@ -791,11 +3122,15 @@ token_ptr async_client::unsubscribe(
     auto tok = token::create(token::Type::UNSUBSCRIBE, *this, topicFilters);
     tok->set_num_expected(n);
     add_token(tok);
+    untrack_subscriptions(*tok->get_topics());
 
     auto rspOpts =
         response_options_builder(mqttVersion_).token(tok).properties(props).finalize();
 
-    int rc = MQTTAsync_unsubscribeMany(cli_, int(n), topicFilters->c_arr(), &rspOpts.opts_);
+    int rc = loopback_ ? loopback_complete(&rspOpts.opts_)
+                       : MQTTAsync_unsubscribeMany(
+                             cli_, int(n), topicFilters->c_arr(), &rspOpts.opts_
+                         );
 
     if (rc != MQTTASYNC_SUCCESS) {
         remove_token(tok);
@@ -815,11 +3150,15 @@ token_ptr async_client::unsubscribe(
     auto tok = token::create(token::Type::UNSUBSCRIBE, *this, topicFilters, userContext, cb);
     tok->set_num_expected(n);
     add_token(tok);
+    untrack_subscriptions(*tok->get_topics());
 
     auto rspOpts =
         response_options_builder(mqttVersion_).token(tok).properties(props).finalize();
 
-    int rc = MQTTAsync_unsubscribeMany(cli_, int(n), topicFilters->c_arr(), &rspOpts.opts_);
+    int rc = loopback_ ? loopback_complete(&rspOpts.opts_)
+                       : MQTTAsync_unsubscribeMany(
+                             cli_, int(n), topicFilters->c_arr(), &rspOpts.opts_
+                         );
 
     if (rc != MQTTASYNC_SUCCESS) {
         remove_token(tok);
@@ -836,11 +3175,13 @@ token_ptr async_client::unsubscribe(
 {
     auto tok = token::create(token::Type::UNSUBSCRIBE, *this, topicFilter, userContext, cb);
     add_token(tok);
+    untrack_subscriptions(*tok->get_topics());
 
     auto rspOpts =
         response_options_builder(mqttVersion_).token(tok).properties(props).finalize();
 
-    int rc = MQTTAsync_unsubscribe(cli_, topicFilter.c_str(), &rspOpts.opts_);
+    int rc = loopback_ ? loopback_complete(&rspOpts.opts_)
+                       : MQTTAsync_unsubscribe(cli_, topicFilter.c_str(), &rspOpts.opts_);
 
     if (rc != MQTTASYNC_SUCCESS) {
         remove_token(tok);
@@ -852,7 +3193,9 @@ token_ptr async_client::unsubscribe(
 
 // --------------------------------------------------------------------------
 
-void async_client::start_consuming()
+void async_client::start_consuming() { start_consuming(consumer_queue_type{}); }
+
+void async_client::start_consuming(consumer_queue_type que)
 {
     // Make sure callbacks don't happen while we update the que, etc
     disable_callbacks();
@@ -860,7 +3203,23 @@ void async_client::start_consuming()
     // TODO: Should we replace user callback?
     // userCallback_ = nullptr;
 
-    que_.reset(new thread_queue<event>);
+    if (!que)
+        que = std::make_unique<thread_consumer_queue>();
+
+    if (auto sw = createOpts_.get_spin_wait(); sw.enabled())
+        que->spin(sw);
+
+    // The incoming messages are only counted against a memory limit, so
+    // the queue isn't slowed by the metering without one.
+    if (memBudget_->limit() > 0 && que->can_meter()) {
+        auto mque = std::make_unique<metered_consumer_queue>(std::move(que), memBudget_.get());
+        meteredQue_ = mque.get();
+        que = std::move(mque);
+    }
+    else
+        meteredQue_ = nullptr;
+
+    que_ = std::move(que);
 
     int rc = MQTTAsync_setCallbacks(
         cli_, this, &async_client::on_connection_lost, &async_client::on_message_arrived,
@@ -872,20 +3231,93 @@ void async_client::start_consuming()
     check_ret(::MQTTAsync_setDisconnected(cli_, this, &async_client::on_disconnected));
 }
 
+void async_client::start_consuming(const consumer_options& opts)
+{
+    consumer_queue_type que;
+    auto cap = opts.get_capacity();
+    auto maxBytes = opts.get_max_bytes();
+
+    if (opts.get_backend() == queue_backend::RING) {
+        if (maxBytes > 0)
+            throw std::invalid_argument("max_bytes is not supported by the ring queue");
+
+        que = std::make_unique<lock_free_consumer_queue>(
+            (cap == 0) ? lock_free_queue<event>::DFLT_CAPACITY : cap
+        );
+    }
+    else if (maxBytes > 0) {
+        que = std::make_unique<thread_consumer_queue>(
+            (cap == 0) ? thread_queue<event>::MAX_CAPACITY : cap, maxBytes, event_bytes
+        );
+    }
+    else if (cap > 0) {
+        que = std::make_unique<thread_consumer_queue>(cap);
+    }
+
+    if (auto policy = opts.get_overflow_policy())
+        overflowPolicy_.store(*policy, std::memory_order_relaxed);
+
+    start_consuming(std::move(que));
+}
+
 void async_client::stop_consuming()
 {
     try {
         disable_callbacks();
-        if (que_)
+        if (que_) {
             que_->close();
+            notify_consumers();
+        }
     }
     catch (...) {
-        if (que_)
+        if (que_) {
             que_->close();
+            notify_consumers();
+        }
         throw;
     }
 }
 
+// --------------------------------------------------------------------------
+
+void async_client::start_dispatching(
+    message_handler cb, size_t nWorkers, message_dispatcher::key_func keyFunc
+)
+{
+    set_dispatcher(
+        std::make_unique<message_dispatcher>(std::move(cb), nWorkers, std::move(keyFunc))
+    );
+}
+
+void async_client::start_dispatching(message_handler cb, size_t nWorkers, dispatch_mode mode)
+{
+    set_dispatcher(std::make_unique<message_dispatcher>(std::move(cb), nWorkers, mode));
+}
+
+void async_client::set_dispatcher(message_dispatcher_ptr disp)
+{
+    // Make sure callbacks don't happen while we swap the dispatcher
+    disable_callbacks();
+
+    if (dispatcher_)
+        dispatcher_->stop();
+
+    dispatcher_ = std::move(disp);
+
+    check_ret(::MQTTAsync_setCallbacks(
+        cli_, this, &async_client::on_connection_lost, &async_client::on_message_arrived,
+        nullptr
+    ));
+    check_ret(::MQTTAsync_setConnected(cli_, this, &async_client::on_connected));
+    check_ret(::MQTTAsync_setDisconnected(cli_, this, &async_client::on_disconnected));
+}
+
+void async_client::stop_dispatching()
+{
+    if (dispatcher_)
+        dispatcher_->stop();
+}
+
 event async_client::consume_event()
 {
     event evt;
@@ -911,6 +3343,53 @@ bool async_client::try_consume_event(event* evt)
     return res;
 }
 
+size_t async_client::add_messages(
+    std::vector<event>& evts, std::vector<const_message_ptr>& msgs
+) const
+{
+    msgs.reserve(msgs.size() + evts.size());
+
+    // As with consume_message(), the 'connected' events are ignored, and
+    // disconnected/lost are reported as an empty pointer. They're still
+    // counted, so a batch of them isn't mistaken for a timeout.
+    for (auto& evt : evts) {
+        if (auto* pval = evt.get_message_if()) {
+            msgs.emplace_back(std::move(*pval));
+            trace_consumed(msgs.back());
+        }
+        else if (evt.is_any_disconnect())
+            msgs.emplace_back(const_message_ptr{});
+    }
+    return evts.size();
+}
+
+size_t async_client::try_consume_messages(
+    std::vector<const_message_ptr>& msgs, size_t maxMsgs
+)
+{
+    if (!que_)
+        throw mqtt::exception(-1, "Consumer not started");
+
+    std::vector<event> evts;
+    que_->try_get_bulk(evts, maxMsgs);
+    return add_messages(evts, msgs);
+}
+
+std::deque<event> async_client::drain_consumer_queue()
+{
+    if (!que_)
+        throw mqtt::exception(-1, "Consumer not started");
+
+    auto evts = que_->drain();
+    if (traceRate_.load(std::memory_order_relaxed) != 0) {
+        for (const auto& evt : evts) {
+            if (auto* pval = evt.get_message_if())
+                trace_consumed(*pval);
+        }
+    }
+    return evts;
+}
+
 const_message_ptr async_client::consume_message()
 {
     if (!que_)
@@ -921,8 +3400,10 @@ const_message_ptr async_client::consume_message()
     while (true) {
         auto evt = consume_event();
 
-        if (const auto* pval = evt.get_message_if())
-            return *pval;
+        if (auto* pval = evt.get_message_if()) {
+            trace_consumed(*pval);
+            return std::move(*pval);
+        }
 
         if (evt.is_any_disconnect())
             return const_message_ptr{};
@@ -940,8 +3421,9 @@ bool async_client::try_consume_message(const_message_ptr* msg)
         if (!try_consume_event(&evt))
             return false;
 
-        if (const auto* pval = evt.get_message_if()) {
+        if (auto* pval = evt.get_message_if()) {
             *msg = std::move(*pval);
+            trace_consumed(*msg);
             break;
         }
 
@@ -953,5 +3435,307 @@ bool async_client::try_consume_message(const_message_ptr* msg)
     return true;
 }
 
+// --------------------------------------------------------------------------
+// Asynchronous consumers
+
+// The consumers announce themselves in the count of waiters before
+// checking the queue, and the producer puts into the queue before checking
+// the count, so that one of them always sees the other.
+
+// Only blocking can wait on the consumer. The others use try_put(), which
+// also fails if the queue is closed, and just count the message as dropped.
+
+// The message is moved into the queue, except when it has to be retried.
+
+bool async_client::queue_message(message_ptr m)
+{
+    if (m->traced_)
+        trace(trace_point::QUEUED, *m, trace_clock::now());
+
+    if (meteredQue_ && memBudget_->limit() > 0 && !make_room(*m)) {
+        nDropped_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    switch (overflowPolicy_.load(std::memory_order_relaxed)) {
+        case overflow_policy::DROP_QOS0:
+            if (m->get_qos() > 0) {
+                que_->put(std::move(m));
+                return true;
+            }
+            [[fallthrough]];
+
+        case overflow_policy::DROP_NEWEST:
+            if (que_->try_put(std::move(m)))
+                return true;
+            break;
+
+        case overflow_policy::DROP_OLDEST: {
+            event evt;
+            while (true) {
+                if (que_->try_put(m))
+                    return true;
+                if (que_->closed() || !que_->try_get(&evt))
+                    break;
+                if (evt.is_message())
+                    nDropped_.fetch_add(1, std::memory_order_relaxed);
+            }
+            break;
+        }
+
+        case overflow_policy::BLOCK:
+        default:
+            que_->put(std::move(m));
+            return true;
+    }
+
+    nDropped_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+// The deliveries complete on the same thread that queues the incoming
+// messages, so only the consumer can make room while it waits. If the
+// queue is empty, the rest of the budget is held by the publishers, and
+// a blocking policy takes the message anyway, rather than wait forever.
+
+bool async_client::make_room(const message& m)
+{
+    const auto n = sizeof(event) + m.memory_size();
+    if (memBudget_->has_room(n))
+        return true;
+
+    switch (overflowPolicy_.load(std::memory_order_relaxed)) {
+        case overflow_policy::DROP_NEWEST:
+            return false;
+
+        case overflow_policy::DROP_OLDEST: {
+            event evt;
+            while (!memBudget_->has_room(n) && que_->try_get(&evt)) {
+                if (evt.is_message())
+                    nDropped_.fetch_add(1, std::memory_order_relaxed);
+            }
+            return memBudget_->has_room(n);
+        }
+
+        case overflow_policy::DROP_QOS0:
+            if (m.get_qos() == 0)
+                return false;
+            [[fallthrough]];
+
+        case overflow_policy::BLOCK:
+        default:
+            while (!memBudget_->has_room(n) && !que_->empty() && !que_->closed())
+                memBudget_->wait_for(n, std::chrono::milliseconds(100));
+            return true;
+    }
+}
+
+void async_client::notify_consumers()
+{
+    if (fdWrite_.load(std::memory_order_acquire) >= 0)
+        signal_consumer_fd();
+
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    while (nConsumeWaiters_ > 0) {
+        consume_waiter waiter;
+        event evt;
+        {
+            guard g(consumeLock_);
+            if (consumeWaiters_.empty())
+                return;
+
+            bool msgsOnly = consumeWaiters_.front().msgsOnly;
+            bool got = false;
+
+            while (que_->try_get(&evt)) {
+                if (!msgsOnly || !evt.is_connected()) {
+                    got = true;
+                    break;
+                }
+            }
+
+            if (!got) {
+                if (!que_->done())
+                    return;
+                evt = event{shutdown_event{}};
+            }
+
+            waiter = std::move(consumeWaiters_.front());
+            consumeWaiters_.pop_front();
+            --nConsumeWaiters_;
+        }
+        waiter.handler(std::move(evt));
+    }
+}
+
+// --------------------------------------------------------------------------
+// Pollable consumer
+//
+// The fd is only written when it goes from clear to signaled, so a burst
+// of messages costs one system call, not one for each. The consumer clears
+// the flag before it reads the queue, so anything put in after that
+// signals the fd again. It empties the fd before clearing the flag, so a
+// signal can't be read away while the flag stays set.
+
+int async_client::consumer_fd()
+{
+    if (!que_)
+        throw mqtt::exception(-1, "Consumer not started");
+
+#if defined(_WIN32)
+    throw mqtt::exception(MQTTASYNC_FAILURE, "The consumer fd is not supported on Windows");
+#else
+    guard g(consumeLock_);
+    if (fdRead_ >= 0)
+        return fdRead_;
+
+    int fdRead = -1, fdWrite = -1;
+
+    #if defined(__linux__)
+    fdRead = fdWrite = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (fdRead < 0)
+        throw mqtt::exception(MQTTASYNC_FAILURE, "Can't create the consumer eventfd");
+    #else
+    int fds[2];
+    if (::pipe(fds) != 0)
+        throw mqtt::exception(MQTTASYNC_FAILURE, "Can't create the consumer pipe");
+
+    for (int fd : fds) {
+        ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) | O_NONBLOCK);
+        ::fcntl(fd, F_SETFD, FD_CLOEXEC);
+    }
+    fdRead = fds[0];
+    fdWrite = fds[1];
+    #endif
+
+    fdRead_ = fdRead;
+    fdWrite_.store(fdWrite, std::memory_order_release);
+
+    // Anything that was queued before there was an fd
+    if (que_->size() > 0 || que_->done())
+        signal_consumer_fd();
+
+    return fdRead_;
+#endif
+}
+
+void async_client::signal_consumer_fd()
+{
+#if !defined(_WIN32)
+    if (fdSignaled_.exchange(true))
+        return;
+
+    int fd = fdWrite_.load(std::memory_order_acquire);
+    #if defined(__linux__)
+    uint64_t val = 1;
+    #else
+    char val = 0;
+    #endif
+    while (::write(fd, &val, sizeof(val)) < 0 && errno == EINTR);
+#endif
+}
+
+void async_client::clear_consumer_fd()
+{
+#if !defined(_WIN32)
+    int fd = fdRead_;
+    if (fd < 0)
+        return;
+
+    // An eventfd is reset by a single read, but a pipe may hold more than
+    // one byte if it was signaled again while being cleared.
+    // The errno is only looked at after a failed read, as it's left over
+    // from some earlier call otherwise.
+    char buf[64];
+    for (;;) {
+        auto n = ::read(fd, buf, sizeof(buf));
+        if (n > 0)
+            continue;
+        if (n < 0 && errno == EINTR)
+            continue;
+        break;
+    }
+
+    // The flag is only cleared once the fd is empty. Clearing it first would
+    // let a producer write to the fd in between, and have that write read
+    // away here, leaving the flag set with nothing in the fd to wake the
+    // loop again. This way, a signal that lands in between only costs a
+    // spurious wakeup.
+    fdSignaled_.store(false);
+#endif
+}
+
+bool async_client::consume_event_async(event* evt, consume_event_handler handler)
+{
+    if (!que_)
+        throw mqtt::exception(-1, "Consumer not started");
+
+    guard g(consumeLock_);
+    ++nConsumeWaiters_;
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    bool got = que_->try_get(evt);
+    if (!got && que_->done()) {
+        *evt = event{shutdown_event{}};
+        got = true;
+    }
+
+    if (got) {
+        --nConsumeWaiters_;
+        return true;
+    }
+
+    consumeWaiters_.push_back(consume_waiter{false, std::move(handler)});
+    return false;
+}
+
+bool async_client::consume_message_async(
+    const_message_ptr* msg, consume_message_handler handler
+)
+{
+    if (!que_)
+        throw mqtt::exception(-1, "Consumer not started");
+
+    guard g(consumeLock_);
+    ++nConsumeWaiters_;
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    event evt;
+    bool got = false;
+
+    while (!got && que_->try_get(&evt)) {
+        if (auto* pval = evt.get_message_if()) {
+            *msg = std::move(*pval);
+            trace_consumed(*msg);
+            got = true;
+        }
+        else if (evt.is_any_disconnect()) {
+            *msg = const_message_ptr{};
+            got = true;
+        }
+    }
+
+    if (!got && que_->done()) {
+        *msg = const_message_ptr{};
+        got = true;
+    }
+
+    if (got) {
+        --nConsumeWaiters_;
+        return true;
+    }
+
+    auto fn = [this, handler = std::move(handler)](event evt) {
+        auto* pval = evt.get_message_if();
+        if (pval)
+            trace_consumed(*pval);
+        handler(pval ? std::move(*pval) : const_message_ptr{});
+    };
+
+    consumeWaiters_.push_back(consume_waiter{true, std::move(fn)});
+    return false;
+}
+
 /////////////////////////////////////////////////////////////////////////////
 }  // namespace mqtt
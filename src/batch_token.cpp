@@ -0,0 +1,80 @@
+// batch_token.cpp
+
+/*******************************************************************************
+ * Copyright (c) 2025 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+#include "mqtt/batch_token.h"
+
+#include "mqtt/iasync_client.h"
+
+namespace mqtt {
+
+/////////////////////////////////////////////////////////////////////////////
+
+delivery_token_ptr batch_token::add(const_message_ptr msg)
+{
+    auto tok = delivery_token::create(*cli_, std::move(msg), nullptr, dlvrListener_);
+    ++nPending_;
+    toks_.push_back(tok);
+    return tok;
+}
+
+void batch_token::on_delivery_complete()
+{
+    if (--nPending_ == 0)
+        complete();
+}
+
+void batch_token::on_delivery_failure(const token& tok)
+{
+    int rc = tok.get_return_code();
+    if (rc == MQTTASYNC_SUCCESS)
+        rc = MQTTASYNC_FAILURE;
+
+    int expected = MQTTASYNC_SUCCESS;
+    firstRc_.compare_exchange_strong(expected, rc);
+    ++nFailed_;
+
+    on_delivery_complete();
+}
+
+void batch_token::complete()
+{
+    unique_lock g(lock_);
+    iaction_listener* listener = listener_;
+    token::rc_ = firstRc_;
+    complete_ = true;
+    auto handlers = std::move(completeHandlers_);
+    completeHandlers_.clear();
+    bool success = (token::rc_ == MQTTASYNC_SUCCESS);
+    g.unlock();
+
+    signal_complete(listener, success, std::move(handlers));
+}
+
+std::vector<delivery_token_ptr> batch_token::get_failed_tokens() const
+{
+    std::vector<delivery_token_ptr> toks;
+    for (const auto& tok : toks_) {
+        if (tok->is_complete() &&
+            (tok->get_return_code() != MQTTASYNC_SUCCESS || tok->get_reason_code() >= 0x80))
+            toks.push_back(tok);
+    }
+    return toks;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+}  // namespace mqtt
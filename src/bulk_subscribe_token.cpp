@@ -0,0 +1,110 @@
+// bulk_subscribe_token.cpp
+
+/*******************************************************************************
+ * Copyright (c) 2025 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+#include "mqtt/bulk_subscribe_token.h"
+
+#include "mqtt/iasync_client.h"
+
+namespace mqtt {
+
+/////////////////////////////////////////////////////////////////////////////
+
+void bulk_subscribe_token::add(token_ptr tok, size_t first)
+{
+    ++nPending_;
+    toks_.push_back(tok);
+    firsts_.push_back(first);
+
+    // As with the pool token, the chunks only get a weak reference back.
+    std::weak_ptr<bulk_subscribe_token> wself =
+        std::static_pointer_cast<bulk_subscribe_token>(shared_from_this());
+    const token* ptok = tok.get();
+
+    if (!tok->notify_on_complete([wself, ptok] {
+            if (auto self = wself.lock())
+                self->on_chunk_complete(ptok);
+        }))
+        on_chunk_complete(ptok);
+}
+
+void bulk_subscribe_token::on_chunk_complete(const token* tok)
+{
+    if (tok) {
+        int rc = tok->get_return_code();
+        if (rc == MQTTASYNC_SUCCESS && tok->get_reason_code() >= 0x80)
+            rc = MQTTASYNC_FAILURE;
+
+        if (rc != MQTTASYNC_SUCCESS) {
+            int expected = MQTTASYNC_SUCCESS;
+            firstRc_.compare_exchange_strong(expected, rc);
+        }
+    }
+
+    if (--nPending_ == 0)
+        complete();
+}
+
+void bulk_subscribe_token::complete()
+{
+    unique_lock g(lock_);
+    iaction_listener* listener = listener_;
+    token::rc_ = firstRc_;
+    complete_ = true;
+    auto handlers = std::move(completeHandlers_);
+    completeHandlers_.clear();
+    bool success = (token::rc_ == MQTTASYNC_SUCCESS);
+    g.unlock();
+
+    signal_complete(listener, success, std::move(handlers));
+}
+
+std::vector<ReasonCode> bulk_subscribe_token::get_reason_codes() const
+{
+    {
+        unique_lock g(lock_);
+        wait_complete(g);
+    }
+
+    const size_t nTopics = topics_ ? topics_->size() : 0;
+    std::vector<ReasonCode> codes;
+    codes.reserve(nTopics);
+
+    for (size_t i = 0; i < toks_.size(); ++i) {
+        const auto& tok = toks_[i];
+        const size_t n = ((i + 1 < firsts_.size()) ? firsts_[i + 1] : nTopics) - firsts_[i];
+        const size_t end = codes.size() + n;
+
+        if (tok->get_return_code() == MQTTASYNC_SUCCESS) {
+            try {
+                for (auto rc : tok->get_subscribe_response().get_reason_codes()) {
+                    if (codes.size() < end)
+                        codes.push_back(rc);
+                }
+            }
+            catch (const exception&) {
+            }
+        }
+
+        auto rc = tok->get_reason_code();
+        codes.resize(end, (rc >= 0x80) ? ReasonCode(rc) : ReasonCode::UNSPECIFIED_ERROR);
+    }
+    return codes;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+}  // namespace mqtt
@@ -0,0 +1,207 @@
+// chunk_reassembler.cpp
+
+/*******************************************************************************
+ * Copyright (c) 2025 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+#include "mqtt/chunk_reassembler.h"
+
+#include <algorithm>
+#include <cstring>
+#include <string_view>
+
+#include "mqtt/stream_publisher.h"
+
+namespace mqtt {
+
+/////////////////////////////////////////////////////////////////////////////
+
+// Gets a user property as a number, if it's there and is one.
+static bool get_number(const properties& props, const char* name, uint64_t& val)
+{
+    if (!props.contains_user_property(name))
+        return false;
+    try {
+        size_t pos = 0;
+        auto s = props.get_user_property(name);
+        val = uint64_t(std::stoull(s, &pos));
+        return pos == s.size();
+    }
+    catch (const std::exception&) {
+        return false;
+    }
+}
+
+// Determines if a property is one of those for the transfer.
+static bool is_transfer_property(const MQTTProperty& prop)
+{
+    if (prop.identifier != MQTTPROPERTY_CODE_USER_PROPERTY)
+        return false;
+
+    std::string_view name{prop.value.data.data, size_t(prop.value.data.len)};
+    return name == stream_publisher::TRANSFER_PROPERTY_NAME ||
+           name == stream_publisher::OFFSET_PROPERTY_NAME ||
+           name == stream_publisher::SIZE_PROPERTY_NAME ||
+           name == stream_publisher::LAST_PROPERTY_NAME;
+}
+
+void chunk_reassembler::drop(std::unordered_map<string, transfer>::iterator it)
+{
+    bytes_ -= it->second.charged;
+    xfers_.erase(it);
+    ++nDropped_;
+}
+
+size_t chunk_reassembler::expire(clock::time_point now)
+{
+    if (timeout_ <= clock::duration::zero())
+        return 0;
+
+    size_t n = 0;
+    for (auto it = xfers_.begin(); it != xfers_.end();) {
+        auto cur = it++;
+        if (now - cur->second.lastTime > timeout_) {
+            drop(cur);
+            ++n;
+        }
+    }
+    return n;
+}
+
+bool chunk_reassembler::make_room(size_t n, const transfer* keep)
+{
+    while (bytes_ + n > maxBytes_) {
+        auto oldest = xfers_.end();
+        for (auto it = xfers_.begin(); it != xfers_.end(); ++it) {
+            if (&it->second != keep &&
+                (oldest == xfers_.end() || it->second.lastTime < oldest->second.lastTime))
+                oldest = it;
+        }
+        if (oldest == xfers_.end())
+            return false;
+        drop(oldest);
+    }
+    return true;
+}
+
+message_ptr chunk_reassembler::add(message_ptr msg)
+{
+    if (!msg)
+        return msg;
+
+    const auto& props = msg->get_properties();
+    if (!props.contains_user_property(stream_publisher::TRANSFER_PROPERTY_NAME))
+        return msg;
+
+    uint64_t offset = 0, total = 0;
+    if (!get_number(props, stream_publisher::OFFSET_PROPERTY_NAME, offset))
+        return msg;
+
+    const bool haveTotal = get_number(props, stream_publisher::SIZE_PROPERTY_NAME, total);
+    const bool last = props.contains_user_property(stream_publisher::LAST_PROPERTY_NAME);
+    const auto& payload = msg->get_payload_ref();
+    const size_t len = payload.size();
+
+    auto key = msg->get_topic() + '\0' +
+               props.get_user_property(stream_publisher::TRANSFER_PROPERTY_NAME);
+    auto now = clock::now();
+
+    std::lock_guard<std::mutex> g{lock_};
+    expire(now);
+
+    auto it = xfers_.find(key);
+    if (it == xfers_.end())
+        it = xfers_.emplace(std::move(key), transfer{}).first;
+
+    auto& xfer = it->second;
+    xfer.lastTime = now;
+
+    if (haveTotal && !xfer.haveTotal) {
+        xfer.total = total;
+        xfer.haveTotal = true;
+    }
+    else if (last && !xfer.haveTotal) {
+        xfer.total = offset + len;
+        xfer.haveTotal = true;
+    }
+
+    const uint64_t end = offset + len;
+    if ((xfer.haveTotal && (end > xfer.total || xfer.total > maxBytes_)) || end > maxBytes_) {
+        drop(it);
+        return message_ptr{};
+    }
+
+    // A repeated chunk is ignored
+    if (!xfer.offsets.insert(offset).second)
+        return message_ptr{};
+
+    // Allocate the whole buffer once, if the size is known, otherwise
+    // grow it to hold this chunk.
+    size_t need = size_t(xfer.haveTotal ? xfer.total : end);
+    if (need > xfer.buf.size()) {
+        size_t cap = xfer.charged;
+        size_t newCap = xfer.haveTotal ? need : std::min(std::max(need, 2 * cap), maxBytes_);
+
+        if (newCap > cap) {
+            if (!make_room(newCap - cap, &xfer)) {
+                drop(it);
+                return message_ptr{};
+            }
+            xfer.buf.reserve(newCap);
+            bytes_ += newCap - cap;
+            xfer.charged = newCap;
+        }
+        xfer.buf.resize(need);
+    }
+
+    if (len > 0)
+        std::memcpy(&xfer.buf[size_t(offset)], payload.data(), len);
+    xfer.received += len;
+
+    if (!xfer.haveTotal || xfer.received < xfer.total)
+        return message_ptr{};
+
+    // The transfer is complete. The last chunk to arrive becomes the
+    // whole message, with the data as its payload.
+    properties wholeProps;
+    const auto& cprops = props.c_struct();
+    for (int i = 0; i < cprops.count; ++i) {
+        if (!is_transfer_property(cprops.array[i]))
+            wholeProps.add(property{cprops.array[i]});
+    }
+
+    bytes_ -= xfer.charged;
+    msg->set_payload(binary_ref{std::move(xfer.buf)});
+    msg->set_properties(std::move(wholeProps));
+    xfers_.erase(it);
+    ++nCompleted_;
+    return msg;
+}
+
+size_t chunk_reassembler::expire()
+{
+    std::lock_guard<std::mutex> g{lock_};
+    return expire(clock::now());
+}
+
+void chunk_reassembler::clear()
+{
+    std::lock_guard<std::mutex> g{lock_};
+    xfers_.clear();
+    bytes_ = 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+}  // namespace mqtt
@@ -32,6 +32,51 @@ PAHO_MQTTPP_EXPORT const int client::DFLT_QOS = 1;
 
 // --------------------------------------------------------------------------
 
+client::callback_thread::callback_thread()
+{
+    thr_ = std::thread([this] {
+        std::function<void()> fn;
+        while (que_.get(&fn)) {
+            fn();
+            fn = nullptr;
+        }
+    });
+}
+
+client::callback_thread::~callback_thread()
+{
+    que_.close();
+    if (thr_.joinable())
+        thr_.join();
+}
+
+void client::callback_thread::run(std::function<void()> fn)
+{
+    // Any exception from the user's callback is dropped, as it was
+    // when each callback was run with std::async().
+    if (std::this_thread::get_id() == thr_.get_id()) {
+        try {
+            fn();
+        }
+        catch (...) {
+        }
+        return;
+    }
+
+    std::packaged_task<void()> task{std::move(fn)};
+    auto fut = task.get_future();
+
+    try {
+        que_.put([&task] { task(); });
+    }
+    catch (const queue_closed&) {
+        return;
+    }
+    fut.wait();
+}
+
+// --------------------------------------------------------------------------
+
 client::client(
     const string& serverURI, const string& clientId /*=string{}*/,
     const persistence_type& persistence /*=NO_PERSISTENCE*/
@@ -69,6 +114,8 @@ client::client(const create_options& opts)
 
 void client::set_callback(callback& cb)
 {
+    if (!cbThread_)
+        cbThread_ = std::make_unique<callback_thread>();
     userCallback_ = &cb;
     cli_.set_callback(*this);
 }
@@ -0,0 +1,240 @@
+// client_pool.cpp
+
+/*******************************************************************************
+ * Copyright (c) 2025 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+#include "mqtt/client_pool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+
+namespace mqtt {
+
+/////////////////////////////////////////////////////////////////////////////
+// pool_token
+
+void pool_token::add(token_ptr tok)
+{
+    ++nPending_;
+    toks_.push_back(tok);
+
+    // The group holds the member tokens, so the members only get a weak
+    // reference back, in case the group is dropped before they complete.
+    std::weak_ptr<pool_token> wself =
+        std::static_pointer_cast<pool_token>(shared_from_this());
+    const token* ptok = tok.get();
+
+    if (!tok->notify_on_complete([wself, ptok] {
+            if (auto self = wself.lock())
+                self->on_member_complete(ptok);
+        }))
+        on_member_complete(ptok);
+}
+
+void pool_token::on_member_complete(const token* tok)
+{
+    if (tok) {
+        int rc = tok->get_return_code();
+        if (rc == MQTTASYNC_SUCCESS && tok->get_reason_code() >= 0x80)
+            rc = MQTTASYNC_FAILURE;
+
+        if (rc != MQTTASYNC_SUCCESS) {
+            int expected = MQTTASYNC_SUCCESS;
+            firstRc_.compare_exchange_strong(expected, rc);
+        }
+    }
+
+    if (--nPending_ == 0)
+        complete();
+}
+
+void pool_token::complete()
+{
+    unique_lock g(lock_);
+    iaction_listener* listener = listener_;
+    token::rc_ = firstRc_;
+    complete_ = true;
+    auto handlers = std::move(completeHandlers_);
+    completeHandlers_.clear();
+    bool success = (token::rc_ == MQTTASYNC_SUCCESS);
+    g.unlock();
+
+    signal_complete(listener, success, std::move(handlers));
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// client_pool
+
+client_pool::client_pool(const create_options& opts, size_t n)
+{
+    if (n == 0)
+        throw std::invalid_argument("A client pool needs at least one client");
+
+    const auto prefix = opts.get_client_id();
+    clis_.reserve(n);
+
+    for (size_t i = 0; i < n; ++i) {
+        auto cliOpts = opts;
+        cliOpts.set_client_id(make_client_id(prefix, i));
+        clis_.emplace_back(std::make_unique<async_client>(std::move(cliOpts)));
+    }
+}
+
+string client_pool::make_client_id(const string& prefix, size_t idx)
+{
+    return prefix.empty() ? string{} : (prefix + "-" + std::to_string(idx));
+}
+
+pool_token_ptr client_pool::connect(const connect_options& opts)
+{
+    auto tok = pool_token::create(token::Type::CONNECT, *clis_.front());
+    for (auto& cli : clis_) tok->add(cli->connect(opts));
+    tok->started();
+    return tok;
+}
+
+pool_token_ptr client_pool::connect(const connect_options& opts, double rate)
+{
+    using clock = std::chrono::steady_clock;
+
+    if (rate <= 0.0)
+        return connect(opts);
+
+    auto tok = pool_token::create(token::Type::CONNECT, *clis_.front());
+    const auto interval =
+        std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(1.0 / rate));
+    auto next = clock::now();
+
+    for (auto& cli : clis_) {
+        std::this_thread::sleep_until(next);
+        next += interval;
+        tok->add(cli->connect(opts));
+    }
+    tok->started();
+    return tok;
+}
+
+bool client_pool::is_connected() const
+{
+    return std::all_of(clis_.begin(), clis_.end(), [](const auto& cli) {
+        return cli->is_connected();
+    });
+}
+
+size_t client_pool::index_lowest_rtt() const
+{
+    size_t best = clis_.size();
+    std::chrono::microseconds bestRtt{0};
+
+    for (size_t i = 0; i < clis_.size(); ++i) {
+        if (!clis_[i]->is_connected())
+            continue;
+
+        auto rtt = clis_[i]->get_rtt();
+        if (best == clis_.size() ||
+            (rtt.count() > 0 && (bestRtt.count() == 0 || rtt < bestRtt))) {
+            best = i;
+            bestRtt = rtt;
+        }
+    }
+    return (best == clis_.size()) ? 0 : best;
+}
+
+pool_token_ptr client_pool::disconnect(const disconnect_options& opts)
+{
+    auto tok = pool_token::create(token::Type::DISCONNECT, *clis_.front());
+    for (auto& cli : clis_) tok->add(cli->disconnect(opts));
+    tok->started();
+    return tok;
+}
+
+std::vector<delivery_token_ptr> client_pool::get_pending_delivery_tokens() const
+{
+    std::vector<delivery_token_ptr> toks;
+    for (const auto& cli : clis_) {
+        auto cliToks = cli->get_pending_delivery_tokens();
+        toks.insert(toks.end(), cliToks.begin(), cliToks.end());
+    }
+    return toks;
+}
+
+client_stats client_pool::get_stats() const
+{
+    client_stats stats;
+
+    for (const auto& cli : clis_) {
+        auto s = cli->get_stats();
+
+        stats.msgsPublished += s.msgsPublished;
+        stats.bytesPublished += s.bytesPublished;
+        stats.msgsAcked += s.msgsAcked;
+        stats.msgsReceived += s.msgsReceived;
+        stats.bytesReceived += s.bytesReceived;
+        stats.pendingDeliveryTokens += s.pendingDeliveryTokens;
+        stats.pendingDeliveryBytes += s.pendingDeliveryBytes;
+        stats.oldestPendingDelivery =
+            std::max(stats.oldestPendingDelivery, s.oldestPendingDelivery);
+        stats.consumerQueueSize += s.consumerQueueSize;
+        stats.consumerQueueBytes += s.consumerQueueBytes;
+        stats.consumerQueueHighWater =
+            std::max(stats.consumerQueueHighWater, s.consumerQueueHighWater);
+        stats.msgsDropped += s.msgsDropped;
+        stats.msgsDuplicated += s.msgsDuplicated;
+        // The clients share the sequence tracker from the create options
+        stats.seqGaps = std::max(stats.seqGaps, s.seqGaps);
+        stats.seqDuplicates = std::max(stats.seqDuplicates, s.seqDuplicates);
+        stats.seqOutOfOrder = std::max(stats.seqOutOfOrder, s.seqOutOfOrder);
+        stats.publishErrors += s.publishErrors;
+        stats.msgsInFlight += s.msgsInFlight;
+        stats.msgsDeferred += s.msgsDeferred;
+        stats.offlineBuffered += s.offlineBuffered;
+        stats.offlineBufferBytes += s.offlineBufferBytes;
+        stats.offlineSpilled += s.offlineSpilled;
+        stats.memoryUsed += s.memoryUsed;
+        stats.memoryHighWater += s.memoryHighWater;
+        stats.reconnects += s.reconnects;
+        stats.ackLatencyP50 = std::max(stats.ackLatencyP50, s.ackLatencyP50);
+        stats.ackLatencyP99 = std::max(stats.ackLatencyP99, s.ackLatencyP99);
+        stats.ackLatencyP999 = std::max(stats.ackLatencyP999, s.ackLatencyP999);
+        stats.ackLatencyMax = std::max(stats.ackLatencyMax, s.ackLatencyMax);
+        stats.callbacksTimed += s.callbacksTimed;
+        stats.slowCallbacks += s.slowCallbacks;
+        stats.callbackTimeP50 = std::max(stats.callbackTimeP50, s.callbackTimeP50);
+        stats.callbackTimeP99 = std::max(stats.callbackTimeP99, s.callbackTimeP99);
+        stats.callbackTimeMax = std::max(stats.callbackTimeMax, s.callbackTimeMax);
+        stats.rttProbes += s.rttProbes;
+        stats.rttAverage = std::max(stats.rttAverage, s.rttAverage);
+        stats.rttP50 = std::max(stats.rttP50, s.rttP50);
+        stats.rttP99 = std::max(stats.rttP99, s.rttP99);
+        stats.rttMax = std::max(stats.rttMax, s.rttMax);
+        // The clients share the publish shaper from the create options
+        stats.shapedDelayed = std::max(stats.shapedDelayed, s.shapedDelayed);
+        stats.shapedCoalesced = std::max(stats.shapedCoalesced, s.shapedCoalesced);
+        stats.shapedDropped = std::max(stats.shapedDropped, s.shapedDropped);
+        // ...and the message sampler
+        stats.msgsSampledOut = std::max(stats.msgsSampledOut, s.msgsSampledOut);
+        // ...and the topic counters
+        if (stats.topicTraffic.empty())
+            stats.topicTraffic = std::move(s.topicTraffic);
+    }
+
+    return stats;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+}  // namespace mqtt
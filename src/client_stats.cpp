@@ -0,0 +1,94 @@
+// client_stats.cpp
+
+/*******************************************************************************
+ * Copyright (c) 2025 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+#include "mqtt/client_stats.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace mqtt {
+
+/////////////////////////////////////////////////////////////////////////////
+
+// Values below 2*SUB_COUNT get a bucket each. Above that, each power of two
+// is split into SUB_COUNT buckets, by the bits just below the highest one.
+
+size_t latency_histogram::index_of(uint64_t us)
+{
+    if (us < 2 * SUB_COUNT)
+        return size_t(us);
+
+    int msb = 0;
+    for (auto v = us; v > 1; v >>= 1) ++msb;
+
+    if (msb >= MAX_BITS)
+        return N_BUCKETS - 1;
+
+    int shift = msb - SUB_BITS;
+    return size_t(shift + 1) * SUB_COUNT + size_t(us >> shift) - SUB_COUNT;
+}
+
+uint64_t latency_histogram::value_of(size_t idx)
+{
+    if (idx < 2 * SUB_COUNT)
+        return uint64_t(idx);
+
+    int shift = int(idx / SUB_COUNT) - 1;
+    uint64_t sub = uint64_t(idx % SUB_COUNT) + SUB_COUNT;
+    return ((sub + 1) << shift) - 1;
+}
+
+void latency_histogram::record_us(uint64_t us)
+{
+    counts_[index_of(us)].fetch_add(1, std::memory_order_relaxed);
+    total_.fetch_add(1, std::memory_order_relaxed);
+
+    auto mx = max_.load(std::memory_order_relaxed);
+    while (us > mx && !max_.compare_exchange_weak(mx, us, std::memory_order_relaxed));
+}
+
+latency_histogram::duration latency_histogram::percentile(double pct) const
+{
+    auto total = count();
+    if (total == 0)
+        return duration{0};
+
+    auto target = uint64_t(std::ceil(double(total) * pct / 100.0));
+    target = std::min(std::max<uint64_t>(target, 1), total);
+
+    auto mx = max_.load(std::memory_order_relaxed);
+    uint64_t n = 0;
+
+    // The last bucket also holds everything past the range.
+    for (size_t i = 0; i < N_BUCKETS - 1; ++i) {
+        n += counts_[i].load(std::memory_order_relaxed);
+        if (n >= target)
+            return duration(std::min(value_of(i), mx));
+    }
+    return duration(mx);
+}
+
+void latency_histogram::clear()
+{
+    for (auto& n : counts_) n.store(0, std::memory_order_relaxed);
+    total_.store(0, std::memory_order_relaxed);
+    max_.store(0, std::memory_order_relaxed);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+}  // namespace mqtt
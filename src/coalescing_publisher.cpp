@@ -0,0 +1,222 @@
+// coalescing_publisher.cpp
+
+/*******************************************************************************
+ * Copyright (c) 2025 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+#include "mqtt/coalescing_publisher.h"
+
+#include <stdexcept>
+#include <vector>
+
+namespace mqtt {
+
+// The most bytes in a variable byte integer
+static constexpr size_t MAX_PREFIX_SIZE = 4;
+
+// Decodes the length prefix at a position, as an MQTT variable byte
+// integer, moving the position past it. Returns false if it's truncated
+// or too long.
+static bool decode_length(const char*& pos, const char* end, size_t& len)
+{
+    len = 0;
+    for (size_t i = 0, shift = 0; i < MAX_PREFIX_SIZE && pos < end; ++i, shift += 7) {
+        auto b = uint8_t(*pos++);
+        len |= size_t(b & 0x7F) << shift;
+        if ((b & 0x80) == 0)
+            return true;
+    }
+    return false;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// record_batch
+
+record_batch::const_iterator::const_iterator(const char* pos, const char* end)
+    : pos_{pos}, end_{end}
+{
+    size_t len;
+    if (pos_ < end_ && decode_length(pos_, end_, len)) {
+        rec_ = binary_view{pos_, len};
+        pos_ += len;
+    }
+}
+
+record_batch::record_batch(binary_ref payload) : payload_{std::move(payload)}
+{
+    const char *pos = payload_.data(), *end = pos + payload_.size();
+
+    while (pos < end) {
+        size_t len;
+        if (!decode_length(pos, end, len) || len > size_t(end - pos))
+            throw exception(MQTTASYNC_FAILURE, "Malformed record batch");
+        pos += len;
+        ++n_;
+    }
+}
+
+void record_batch::append(binary& buf, const void* data, size_t n)
+{
+    if (n > MAX_RECORD_SIZE)
+        throw std::invalid_argument("The record is too large for a batch");
+
+    auto len = n;
+    do {
+        auto b = uint8_t(len & 0x7F);
+        len >>= 7;
+        if (len > 0)
+            b |= 0x80;
+        buf.push_back(char(b));
+    } while (len > 0);
+
+    buf.append(static_cast<const char*>(data), n);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// coalescing_publisher
+
+coalescing_publisher::coalescing_publisher(
+    async_client& cli, int qos, std::chrono::milliseconds maxDelay, size_t maxBytes
+)
+    : cli_{cli}, qos_{qos}, maxDelay_{maxDelay}, maxBytes_{maxBytes}
+{
+    if (maxBytes_ == 0)
+        throw std::invalid_argument("The batch size can't be zero");
+
+    thr_ = std::thread([this] { run(); });
+}
+
+coalescing_publisher::~coalescing_publisher()
+{
+    {
+        std::lock_guard<std::mutex> g{lock_};
+        stop_ = true;
+    }
+    cond_.notify_all();
+    thr_.join();
+
+    try {
+        flush();
+    }
+    catch (...) {
+    }
+}
+
+void coalescing_publisher::publish(const string& topic, const void* data, size_t n)
+{
+    pending full;
+    bool notify = false;
+    std::unique_lock<std::mutex> sg;
+    {
+        std::lock_guard<std::mutex> g{lock_};
+        auto& recs = pending_[topic];
+
+        if (recs.n == 0) {
+            recs.deadline = clock::now() + maxDelay_;
+            notify = true;
+        }
+        record_batch::append(recs.buf, data, n);
+        ++recs.n;
+
+        if (recs.buf.size() >= maxBytes_) {
+            full = std::move(recs);
+            pending_.erase(topic);
+            sg = std::unique_lock<std::mutex>{sendLock_};
+        }
+    }
+
+    if (full.n > 0)
+        send(topic, std::move(full));
+    else if (notify)
+        cond_.notify_one();
+}
+
+void coalescing_publisher::send(const string& topic, pending&& recs)
+{
+    try {
+        properties props;
+        if (cli_.mqtt_version() >= MQTTVERSION_5)
+            props.add({property::USER_PROPERTY, COUNT_PROPERTY_NAME, std::to_string(recs.n)});
+
+        cli_.publish(make_message(topic, std::move(recs.buf), qos_, false, props));
+        nRecords_.fetch_add(recs.n, std::memory_order_relaxed);
+        nBatches_.fetch_add(1, std::memory_order_relaxed);
+    }
+    catch (...) {
+        nErrors_.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void coalescing_publisher::flush()
+{
+    std::map<string, pending> recs;
+    std::unique_lock<std::mutex> sg;
+    {
+        std::lock_guard<std::mutex> g{lock_};
+        recs.swap(pending_);
+        sg = std::unique_lock<std::mutex>{sendLock_};
+    }
+    for (auto& [topic, r] : recs) send(topic, std::move(r));
+}
+
+size_t coalescing_publisher::pending_records() const
+{
+    std::lock_guard<std::mutex> g{lock_};
+    size_t n = 0;
+    for (const auto& [topic, r] : pending_) n += r.n;
+    return n;
+}
+
+// The batches are sent without the lock for the records, so more can keep
+// coming in while the client publishes. The send lock is taken before the
+// other is released, so the batches go out in the order they were taken.
+
+void coalescing_publisher::run()
+{
+    std::unique_lock<std::mutex> g{lock_};
+
+    while (!stop_) {
+        if (pending_.empty()) {
+            cond_.wait(g);
+            continue;
+        }
+
+        auto next = clock::time_point::max();
+        for (const auto& [topic, r] : pending_) next = std::min(next, r.deadline);
+
+        if (cond_.wait_until(g, next, [this] { return stop_; }))
+            break;
+
+        auto now = clock::now();
+        std::vector<std::pair<string, pending>> due;
+        for (auto it = pending_.begin(); it != pending_.end();) {
+            if (it->second.deadline <= now) {
+                due.emplace_back(it->first, std::move(it->second));
+                it = pending_.erase(it);
+            }
+            else
+                ++it;
+        }
+
+        std::unique_lock<std::mutex> sg{sendLock_};
+        g.unlock();
+        for (auto& [topic, r] : due) send(topic, std::move(r));
+        sg.unlock();
+        g.lock();
+    }
+}
+
+/////////////////////////////////////////////////////////////////////////////
+}  // namespace mqtt
@@ -49,7 +49,8 @@ connect_options::connect_options(const connect_options& opt)
       props_(opt.props_),
       httpHeaders_(opt.httpHeaders_),
       httpProxy_(opt.httpProxy_),
-      httpsProxy_(opt.httpsProxy_)
+      httpsProxy_(opt.httpsProxy_),
+      backoff_(opt.backoff_)
 {
     if (opts_.will)
         set_will(opt.will_);
@@ -71,7 +72,8 @@ connect_options::connect_options(connect_options&& opt)
       props_(std::move(opt.props_)),
       httpHeaders_(std::move(opt.httpHeaders_)),
       httpProxy_(std::move(opt.httpProxy_)),
-      httpsProxy_(std::move(opt.httpsProxy_))
+      httpsProxy_(std::move(opt.httpsProxy_)),
+      backoff_(std::move(opt.backoff_))
 {
     if (opts_.will)
         opts_.will = &will_.opts_;
@@ -170,6 +172,7 @@ connect_options& connect_options::operator=(const connect_options& opt)
     httpHeaders_ = opt.httpHeaders_;
     httpProxy_ = opt.httpProxy_;
     httpsProxy_ = opt.httpsProxy_;
+    backoff_ = opt.backoff_;
 
     update_c_struct();
     return *this;
@@ -198,6 +201,7 @@ connect_options& connect_options::operator=(connect_options&& opt)
     httpHeaders_ = std::move(opt.httpHeaders_);
     httpProxy_ = std::move(opt.httpProxy_);
     httpsProxy_ = std::move(opt.httpsProxy_);
+    backoff_ = std::move(opt.backoff_);
 
     update_c_struct();
     return *this;
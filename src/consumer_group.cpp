@@ -0,0 +1,126 @@
+// consumer_group.cpp
+
+/*******************************************************************************
+ * Copyright (c) 2025 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+#include "mqtt/consumer_group.h"
+
+namespace mqtt {
+
+/////////////////////////////////////////////////////////////////////////////
+
+consumer_group::consumer_group(
+    const create_options& opts, const string& group, handler_type handler,
+    size_t nConnections, size_t nWorkers, key_func keyFunc
+)
+    : group_{group},
+      startTime_{std::chrono::steady_clock::now()},
+      dispatcher_{
+          [this, handler = std::move(handler)](const_message_ptr msg) {
+              try {
+                  handler(std::move(msg));
+              }
+              catch (...) {
+              }
+              nHandled_.fetch_add(1, std::memory_order_relaxed);
+          },
+          nWorkers, std::move(keyFunc)
+      },
+      pool_{opts, nConnections}
+{
+    for (size_t i = 0; i < pool_.size(); ++i) {
+        auto& cli = pool_.get_client(i);
+        cli.set_message_callback([this](const_message_ptr msg) {
+            on_message(std::move(msg));
+        });
+        cli.set_connected_handler([this, &cli](const string&) { on_connected(cli); });
+    }
+}
+
+consumer_group::~consumer_group()
+{
+    try {
+        for (size_t i = 0; i < pool_.size(); ++i) {
+            auto& cli = pool_.get_client(i);
+            cli.set_message_callback(async_client::message_handler{});
+            cli.set_connected_handler(async_client::connection_handler{});
+        }
+    }
+    catch (...) {
+    }
+    dispatcher_.stop();
+}
+
+void consumer_group::on_message(const_message_ptr msg)
+{
+    nReceived_.fetch_add(1, std::memory_order_relaxed);
+    nBytesReceived_.fetch_add(
+        msg->get_topic_ref().size() + msg->get_payload_ref().size(),
+        std::memory_order_relaxed
+    );
+    dispatcher_.dispatch(std::move(msg));
+}
+
+void consumer_group::on_connected(async_client& cli)
+{
+    std::lock_guard<std::mutex> g{subLock_};
+    for (const auto& sub : subs_) {
+        try {
+            cli.subscribe(share_filter(group_, sub.filter), sub.qos, sub.opts);
+        }
+        catch (...) {
+        }
+    }
+}
+
+void consumer_group::subscribe(const string& filter, int qos, const subscribe_options& opts)
+{
+    std::lock_guard<std::mutex> g{subLock_};
+    subs_.push_back(subscription{filter, qos, opts});
+
+    for (size_t i = 0; i < pool_.size(); ++i) {
+        auto& cli = pool_.get_client(i);
+        if (cli.is_connected())
+            cli.subscribe(share_filter(group_, filter), qos, opts);
+    }
+}
+
+consumer_group_stats consumer_group::get_stats() const
+{
+    consumer_group_stats stats;
+
+    stats.msgsReceived = nReceived_.load(std::memory_order_relaxed);
+    stats.bytesReceived = nBytesReceived_.load(std::memory_order_relaxed);
+    stats.msgsHandled = nHandled_.load(std::memory_order_relaxed);
+    stats.lag = dispatcher_.pending();
+
+    for (size_t i = 0; i < pool_.size(); ++i) {
+        const auto& cli = pool_.get_client(i);
+        if (cli.is_connected())
+            ++stats.connected;
+    }
+    stats.reconnects = pool_.get_stats().reconnects;
+
+    stats.elapsed = std::chrono::steady_clock::now() - startTime_;
+    auto secs = std::chrono::duration<double>(stats.elapsed).count();
+    if (secs > 0.0)
+        stats.handledRate = double(stats.msgsHandled) / secs;
+
+    return stats;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+}  // namespace mqtt
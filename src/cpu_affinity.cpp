@@ -0,0 +1,179 @@
+// cpu_affinity.cpp
+
+/*******************************************************************************
+ * Copyright (c) 2025 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+#include "mqtt/cpu_affinity.h"
+
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <stdexcept>
+
+#if defined(__linux__)
+    #include <pthread.h>
+    #include <sched.h>
+#elif defined(_WIN32)
+    #if !defined(NOMINMAX)
+        #define NOMINMAX
+    #endif
+    #if !defined(WIN32_LEAN_AND_MEAN)
+        #define WIN32_LEAN_AND_MEAN
+    #endif
+    #include <windows.h>
+#endif
+
+namespace mqtt {
+
+/////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+#if defined(__linux__)
+bool set_affinity(pthread_t thr, const std::vector<unsigned>& cpus)
+{
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (auto cpu : cpus) {
+        if (cpu < CPU_SETSIZE)
+            CPU_SET(cpu, &set);
+    }
+    return CPU_COUNT(&set) > 0 && ::pthread_setaffinity_np(thr, sizeof(set), &set) == 0;
+}
+#elif defined(_WIN32)
+bool set_affinity(HANDLE thr, const std::vector<unsigned>& cpus)
+{
+    DWORD_PTR mask = 0;
+    for (auto cpu : cpus) {
+        if (cpu < 8 * sizeof(DWORD_PTR))
+            mask |= DWORD_PTR(1) << cpu;
+    }
+    return mask != 0 && ::SetThreadAffinityMask(thr, mask) != 0;
+}
+#endif
+
+}  // namespace
+
+cpu_set::cpu_set(std::initializer_list<unsigned> cpus)
+{
+    for (auto cpu : cpus) add(cpu);
+}
+
+cpu_set::cpu_set(const std::vector<unsigned>& cpus)
+{
+    for (auto cpu : cpus) add(cpu);
+}
+
+cpu_set cpu_set::range(unsigned first, unsigned last)
+{
+    cpu_set set;
+    for (auto cpu = first; cpu <= last; ++cpu) set.cpus_.push_back(cpu);
+    return set;
+}
+
+cpu_set cpu_set::parse(const string& str)
+{
+    cpu_set set;
+    size_t pos = 0;
+
+    auto number = [&str, &pos]() {
+        size_t n = 0;
+        unsigned long val = std::stoul(str.substr(pos), &n);
+        pos += n;
+        return unsigned(val);
+    };
+
+    try {
+        while (pos < str.size() && str[pos] != '\n') {
+            if (!std::isdigit(static_cast<unsigned char>(str[pos])))
+                throw std::invalid_argument("");
+
+            auto first = number(), last = first;
+            if (pos < str.size() && str[pos] == '-') {
+                ++pos;
+                last = number();
+            }
+            if (last < first)
+                throw std::invalid_argument("");
+
+            for (auto cpu = first; cpu <= last; ++cpu) set.add(cpu);
+
+            if (pos < str.size() && str[pos] == ',')
+                ++pos;
+        }
+    }
+    catch (const std::exception&) {
+        throw std::invalid_argument("Bad CPU list: " + str);
+    }
+    return set;
+}
+
+cpu_set cpu_set::numa_node(unsigned node)
+{
+#if defined(__linux__)
+    std::ifstream in{"/sys/devices/system/node/node" + std::to_string(node) + "/cpulist"};
+    string str;
+    if (std::getline(in, str)) {
+        try {
+            return parse(str);
+        }
+        catch (const std::invalid_argument&) {
+        }
+    }
+#else
+    (void)node;
+#endif
+    return cpu_set{};
+}
+
+void cpu_set::add(unsigned cpu)
+{
+    auto p = std::lower_bound(cpus_.begin(), cpus_.end(), cpu);
+    if (p == cpus_.end() || *p != cpu)
+        cpus_.insert(p, cpu);
+}
+
+bool cpu_set::contains(unsigned cpu) const
+{
+    return std::binary_search(cpus_.begin(), cpus_.end(), cpu);
+}
+
+bool cpu_set::pin_current_thread() const
+{
+#if defined(__linux__)
+    return !cpus_.empty() && set_affinity(::pthread_self(), cpus_);
+#elif defined(_WIN32)
+    return !cpus_.empty() && set_affinity(::GetCurrentThread(), cpus_);
+#else
+    return false;
+#endif
+}
+
+bool cpu_set::pin(std::thread& thr) const
+{
+#if defined(__linux__)
+    return !cpus_.empty() && thr.joinable() && set_affinity(thr.native_handle(), cpus_);
+#elif defined(_WIN32) && defined(_MSC_VER)
+    return !cpus_.empty() && thr.joinable() &&
+           set_affinity(static_cast<HANDLE>(thr.native_handle()), cpus_);
+#else
+    (void)thr;
+    return false;
+#endif
+}
+
+/////////////////////////////////////////////////////////////////////////////
+}  // namespace mqtt
@@ -41,6 +41,34 @@ create_options& create_options::operator=(const create_options& rhs)
         serverURI_ = rhs.serverURI_;
         clientId_ = rhs.clientId_;
         persistence_ = rhs.persistence_;
+        zeroCopyPayloads_ = rhs.zeroCopyPayloads_;
+        messagePoolSize_ = rhs.messagePoolSize_;
+        memResource_ = rhs.memResource_;
+        tokenPoolSize_ = rhs.tokenPoolSize_;
+        maxInternedTopics_ = rhs.maxInternedTopics_;
+        maxTopicAliases_ = rhs.maxTopicAliases_;
+        flowControl_ = rhs.flowControl_;
+        offlineBuffer_ = rhs.offlineBuffer_;
+        retainedCache_ = rhs.retainedCache_;
+        publishShaper_ = rhs.publishShaper_;
+        dedupFilter_ = rhs.dedupFilter_;
+        seqTracker_ = rhs.seqTracker_;
+        topicStats_ = rhs.topicStats_;
+        sampler_ = rhs.sampler_;
+        reassembler_ = rhs.reassembler_;
+        libAffinity_ = rhs.libAffinity_;
+        spinWait_ = rhs.spinWait_;
+        opTimeout_ = rhs.opTimeout_;
+        maxMemory_ = rhs.maxMemory_;
+        restoreSubs_ = rhs.restoreSubs_;
+        loopback_ = rhs.loopback_;
+        manualAck_ = rhs.manualAck_;
+        maxUnacked_ = rhs.maxUnacked_;
+        maxPendingMessages_ = rhs.maxPendingMessages_;
+        maxPendingBytes_ = rhs.maxPendingBytes_;
+        payloadCodec_ = rhs.payloadCodec_;
+        codecThreshold_ = rhs.codecThreshold_;
+        overflowPolicy_ = rhs.overflowPolicy_;
     }
     return *this;
 }
@@ -52,6 +80,34 @@ create_options& create_options::operator=(create_options&& rhs)
         serverURI_ = std::move(rhs.serverURI_);
         clientId_ = std::move(rhs.clientId_);
         persistence_ = std::move(rhs.persistence_);
+        zeroCopyPayloads_ = rhs.zeroCopyPayloads_;
+        messagePoolSize_ = rhs.messagePoolSize_;
+        memResource_ = rhs.memResource_;
+        tokenPoolSize_ = rhs.tokenPoolSize_;
+        maxInternedTopics_ = rhs.maxInternedTopics_;
+        maxTopicAliases_ = rhs.maxTopicAliases_;
+        flowControl_ = rhs.flowControl_;
+        offlineBuffer_ = std::move(rhs.offlineBuffer_);
+        retainedCache_ = std::move(rhs.retainedCache_);
+        publishShaper_ = std::move(rhs.publishShaper_);
+        dedupFilter_ = std::move(rhs.dedupFilter_);
+        seqTracker_ = std::move(rhs.seqTracker_);
+        topicStats_ = std::move(rhs.topicStats_);
+        sampler_ = std::move(rhs.sampler_);
+        reassembler_ = std::move(rhs.reassembler_);
+        libAffinity_ = std::move(rhs.libAffinity_);
+        spinWait_ = rhs.spinWait_;
+        opTimeout_ = rhs.opTimeout_;
+        maxMemory_ = rhs.maxMemory_;
+        restoreSubs_ = rhs.restoreSubs_;
+        loopback_ = rhs.loopback_;
+        manualAck_ = rhs.manualAck_;
+        maxUnacked_ = rhs.maxUnacked_;
+        maxPendingMessages_ = rhs.maxPendingMessages_;
+        maxPendingBytes_ = rhs.maxPendingBytes_;
+        payloadCodec_ = std::move(rhs.payloadCodec_);
+        codecThreshold_ = rhs.codecThreshold_;
+        overflowPolicy_ = rhs.overflowPolicy_;
     }
     return *this;
 }
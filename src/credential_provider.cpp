@@ -0,0 +1,122 @@
+// credential_provider.cpp
+
+/*******************************************************************************
+ * Copyright (c) 2025 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+#include "mqtt/credential_provider.h"
+
+#include <algorithm>
+
+namespace mqtt {
+
+/////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+// The longest the thread sleeps at once, for credentials that don't expire
+constexpr auto MAX_SLEEP = std::chrono::hours(24);
+
+// Gets the time to make new credentials, on the steady clock of the thread
+std::chrono::steady_clock::time_point refresh_time(
+    const credentials& creds, refreshing_credential_provider::duration leadTime
+)
+{
+    using std::chrono::steady_clock;
+    auto now = steady_clock::now();
+
+    if (creds.expires == credentials::clock::time_point::max())
+        return now + MAX_SLEEP;
+
+    auto left = std::chrono::duration_cast<steady_clock::duration>(
+        creds.expires - credentials::clock::now()
+    );
+    return now + std::clamp(left - leadTime, steady_clock::duration::zero(),
+                            steady_clock::duration(MAX_SLEEP));
+}
+
+}  // namespace
+
+refreshing_credential_provider::refreshing_credential_provider(
+    mint_function mint, duration leadTime, duration retryInterval
+)
+    : mint_{std::move(mint)}, leadTime_{leadTime}, retryInterval_{retryInterval}
+{
+    creds_.store(mint_());
+    nRefreshes_ = 1;
+    thr_ = std::thread([this] { run(); });
+}
+
+refreshing_credential_provider::~refreshing_credential_provider()
+{
+    {
+        guard g{lock_};
+        stop_ = true;
+    }
+    cond_.notify_one();
+    if (thr_.joinable())
+        thr_.join();
+}
+
+bool refreshing_credential_provider::mint()
+{
+    try {
+        creds_.store(mint_());
+        nRefreshes_.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+    catch (...) {
+        nFailures_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+}
+
+void refreshing_credential_provider::refresh()
+{
+    {
+        guard g{lock_};
+        refreshNow_ = true;
+    }
+    cond_.notify_one();
+}
+
+// The mint function is called without the lock, so that it can take as
+// long as it needs without holding up refresh() or the destructor.
+
+void refreshing_credential_provider::run()
+{
+    unique_guard g{lock_};
+    auto next = refresh_time(*creds_.load(), leadTime_);
+
+    while (true) {
+        cond_.wait_until(g, next, [this] { return stop_ || refreshNow_; });
+        if (stop_)
+            break;
+
+        if (!refreshNow_ && std::chrono::steady_clock::now() < next)
+            continue;
+        refreshNow_ = false;
+
+        g.unlock();
+        bool ok = mint();
+        g.lock();
+
+        next = ok ? refresh_time(*creds_.load(), leadTime_)
+                  : std::chrono::steady_clock::now() + retryInterval_;
+    }
+}
+
+/////////////////////////////////////////////////////////////////////////////
+}  // namespace mqtt
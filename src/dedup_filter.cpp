@@ -0,0 +1,108 @@
+// dedup_filter.cpp
+
+/*******************************************************************************
+ * Copyright (c) 2025 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+#include "mqtt/dedup_filter.h"
+
+#include <algorithm>
+#include <string_view>
+
+namespace mqtt {
+
+/////////////////////////////////////////////////////////////////////////////
+
+// Mixes a hash into a running one. Zero is kept for "no key".
+static uint64_t hash_combine(uint64_t h, uint64_t v)
+{
+    h ^= v + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+    return (h == 0) ? 1 : h;
+}
+
+dedup_filter::dedup_filter(size_t maxSize, clock::duration window, key_function keyFunc)
+    : maxSize_{std::max<size_t>(maxSize, 1)},
+      window_{window},
+      keyFunc_{keyFunc ? std::move(keyFunc) : by_payload()}
+{
+}
+
+dedup_filter::key_function dedup_filter::by_payload()
+{
+    return [](const message& msg) -> uint64_t {
+        const auto& payload = msg.get_payload_ref();
+        auto h = uint64_t(std::hash<std::string_view>{}(msg.get_topic()));
+        return hash_combine(
+            h, std::hash<std::string_view>{}(std::string_view{payload.data(), payload.size()})
+        );
+    };
+}
+
+dedup_filter::key_function dedup_filter::by_user_property(const string& name)
+{
+    return [name](const message& msg) -> uint64_t {
+        const auto& props = msg.get_properties();
+        if (!props.contains_user_property(name))
+            return 0;
+        return hash_combine(0, std::hash<string>{}(props.get_user_property(name)));
+    };
+}
+
+void dedup_filter::expire(clock::time_point now)
+{
+    if (window_ <= clock::duration::zero())
+        return;
+
+    while (!order_.empty() && now - order_.front().time > window_) {
+        keys_.erase(order_.front().key);
+        order_.pop_front();
+    }
+}
+
+bool dedup_filter::is_duplicate(const message& msg) { return is_duplicate_key(keyFunc_(msg)); }
+
+bool dedup_filter::is_duplicate_key(uint64_t key)
+{
+    if (key == 0)
+        return false;
+
+    auto now = clock::now();
+    std::lock_guard<std::mutex> g{lock_};
+    expire(now);
+
+    if (keys_.count(key) != 0) {
+        ++nDuplicates_;
+        return true;
+    }
+
+    keys_.insert(key);
+    order_.push_back(entry{key, now});
+
+    if (order_.size() > maxSize_) {
+        keys_.erase(order_.front().key);
+        order_.pop_front();
+    }
+    return false;
+}
+
+void dedup_filter::clear()
+{
+    std::lock_guard<std::mutex> g{lock_};
+    order_.clear();
+    keys_.clear();
+}
+
+/////////////////////////////////////////////////////////////////////////////
+}  // namespace mqtt
@@ -0,0 +1,305 @@
+// group_commit_persistence.cpp
+
+/*******************************************************************************
+ * Copyright (c) 2025 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+#include "mqtt/group_commit_persistence.h"
+
+#include <cstring>
+#include <set>
+
+#include "mqtt/exception.h"
+
+namespace mqtt {
+
+/////////////////////////////////////////////////////////////////////////////
+
+group_commit_persistence::~group_commit_persistence()
+{
+    try {
+        if (running_)
+            close();
+    }
+    catch (...) {
+    }
+}
+
+// The lock ordering is lock_ then storeLock_. The committer only holds
+// storeLock_ while writing, and never asks for lock_ while it has it.
+
+void group_commit_persistence::run()
+{
+    std::unique_lock<std::mutex> lk{lock_};
+
+    while (true) {
+        cv_.wait_for(lk, interval_, [this] {
+            return stop_ || commitReq_ || pending_.size() >= maxBatch_;
+        });
+        commitReq_ = false;
+
+        if (pending_.empty()) {
+            committedSeq_ = queuedSeq_;
+            doneCv_.notify_all();
+            if (stop_)
+                break;
+            continue;
+        }
+
+        inflight_.swap(pending_);
+        auto seq = queuedSeq_;
+        lk.unlock();
+
+        std::exception_ptr err;
+        try {
+            write_batch(inflight_);
+        }
+        catch (...) {
+            err = std::current_exception();
+        }
+
+        lk.lock();
+        if (err) {
+            // Keep the batch for the next try, behind any newer changes.
+            err_ = err;
+            for (auto& chg : inflight_) pending_.insert(std::move(chg));
+        }
+        else {
+            committedSeq_ = seq;
+        }
+        inflight_.clear();
+        doneCv_.notify_all();
+
+        if (stop_ && (err || pending_.empty()))
+            break;
+    }
+}
+
+void group_commit_persistence::write_batch(const change_map& batch)
+{
+    std::lock_guard<std::mutex> g{storeLock_};
+
+    for (const auto& chg : batch) {
+        if (chg.second)
+            store_->put(chg.first, {string_view{*chg.second}});
+        else if (store_->contains_key(chg.first))
+            store_->remove(chg.first);
+    }
+    store_->sync();
+}
+
+void group_commit_persistence::queue_change(const string& key, std::optional<string> val)
+{
+    pending_[key] = std::move(val);
+    ++queuedSeq_;
+
+    if (pending_.size() >= maxBatch_)
+        cv_.notify_one();
+}
+
+const std::optional<string>* group_commit_persistence::find_change(const string& key) const
+{
+    if (auto it = pending_.find(key); it != pending_.end())
+        return &it->second;
+
+    if (auto it = inflight_.find(key); it != inflight_.end())
+        return &it->second;
+
+    return nullptr;
+}
+
+void group_commit_persistence::check_error()
+{
+    if (!running_)
+        throw persistence_exception("Persistence store is not open");
+
+    if (err_) {
+        err_ = nullptr;
+        throw persistence_exception("Error committing to the persistence store");
+    }
+}
+
+void group_commit_persistence::stop()
+{
+    {
+        std::lock_guard<std::mutex> g{lock_};
+        if (!running_)
+            return;
+        running_ = false;
+        stop_ = true;
+    }
+    cv_.notify_one();
+    thr_.join();
+
+    std::lock_guard<std::mutex> g{lock_};
+    stop_ = false;
+}
+
+// --------------------------------------------------------------------------
+
+void group_commit_persistence::commit()
+{
+    std::unique_lock<std::mutex> lk{lock_};
+    if (!running_)
+        return;
+
+    check_error();
+    if (pending_.empty() && inflight_.empty())
+        return;
+
+    auto seq = queuedSeq_;
+    commitReq_ = true;
+    cv_.notify_one();
+
+    doneCv_.wait(lk, [this, seq] {
+        return committedSeq_ >= seq || err_ || !running_;
+    });
+    check_error();
+}
+
+void group_commit_persistence::open(const string& clientId, const string& serverURI)
+{
+    {
+        std::lock_guard<std::mutex> g{storeLock_};
+        store_->open(clientId, serverURI);
+    }
+
+    std::lock_guard<std::mutex> g{lock_};
+    err_ = nullptr;
+    if (!running_) {
+        running_ = true;
+        thr_ = std::thread(&group_commit_persistence::run, this);
+    }
+}
+
+void group_commit_persistence::close()
+{
+    stop();
+
+    std::lock_guard<std::mutex> g{lock_};
+    pending_.clear();
+    err_ = nullptr;
+
+    std::lock_guard<std::mutex> sg{storeLock_};
+    store_->close();
+}
+
+void group_commit_persistence::clear()
+{
+    std::unique_lock<std::mutex> lk{lock_};
+    pending_.clear();
+
+    // Let a batch that's being written finish, so it lands before the clear.
+    doneCv_.wait(lk, [this] { return inflight_.empty(); });
+
+    std::lock_guard<std::mutex> g{storeLock_};
+    store_->clear();
+}
+
+bool group_commit_persistence::contains_key(const string& key)
+{
+    std::lock_guard<std::mutex> g{lock_};
+    if (auto chg = find_change(key); chg)
+        return chg->has_value();
+
+    std::lock_guard<std::mutex> sg{storeLock_};
+    return store_->contains_key(key);
+}
+
+string_collection group_commit_persistence::keys() const
+{
+    std::lock_guard<std::mutex> g{lock_};
+    std::set<string> ks;
+    {
+        std::lock_guard<std::mutex> sg{storeLock_};
+        auto sks = store_->keys();
+        for (size_t i = 0; i < sks.size(); ++i) ks.insert(sks[i]);
+    }
+
+    for (const auto* chgs : {&inflight_, &pending_}) {
+        for (const auto& chg : *chgs) {
+            if (chg.second)
+                ks.insert(chg.first);
+            else
+                ks.erase(chg.first);
+        }
+    }
+
+    string_collection coll;
+    for (const auto& k : ks) coll.push_back(k);
+    return coll;
+}
+
+void group_commit_persistence::put(const string& key, const std::vector<string_view>& bufs)
+{
+    string val;
+    for (const auto& b : bufs) val.append(b.data(), b.size());
+
+    std::lock_guard<std::mutex> g{lock_};
+    check_error();
+    queue_change(key, std::move(val));
+}
+
+string group_commit_persistence::get(const string& key) const
+{
+    std::lock_guard<std::mutex> g{lock_};
+    if (auto chg = find_change(key); chg) {
+        if (!chg->has_value())
+            throw persistence_exception();
+        return **chg;
+    }
+
+    std::lock_guard<std::mutex> sg{storeLock_};
+    return store_->get(key);
+}
+
+char* group_commit_persistence::get_buffer(const string& key, size_t& n) const
+{
+    std::lock_guard<std::mutex> g{lock_};
+    if (auto chg = find_change(key); chg) {
+        if (!chg->has_value())
+            throw persistence_exception();
+
+        const auto& val = **chg;
+        n = val.size();
+        char* buf = static_cast<char*>(persistence_malloc(n));
+        std::memcpy(buf, val.data(), n);
+        return buf;
+    }
+
+    std::lock_guard<std::mutex> sg{storeLock_};
+    return store_->get_buffer(key, n);
+}
+
+void group_commit_persistence::remove(const string& key)
+{
+    std::lock_guard<std::mutex> g{lock_};
+    check_error();
+
+    if (auto chg = find_change(key); chg) {
+        if (!chg->has_value())
+            throw persistence_exception();
+    }
+    else {
+        std::lock_guard<std::mutex> sg{storeLock_};
+        if (!store_->contains_key(key))
+            throw persistence_exception();
+    }
+
+    queue_change(key, std::nullopt);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+}  // namespace mqtt
@@ -28,6 +28,17 @@ using namespace std;
 
 namespace mqtt {
 
+/////////////////////////////////////////////////////////////////////////////
+
+char* iclient_persistence::get_buffer(const string& key, size_t& n) const
+{
+    auto s = get(key);
+    n = s.length();
+    char* buf = static_cast<char*>(persistence_malloc(n));
+    memcpy(buf, s.data(), n);
+    return buf;
+}
+
 /////////////////////////////////////////////////////////////////////////////
 // Functions to transition C persistence calls to the C++ persistence object.
 
@@ -89,10 +100,8 @@ int iclient_persistence::persistence_get(void* handle, char* key, char** buffer,
 {
     try {
         if (handle && key && buffer && buflen) {
-            auto s = static_cast<iclient_persistence*>(handle)->get(key);
-            size_t n = s.length();
-            *buffer = static_cast<char*>(MQTTAsync_malloc(n));
-            memcpy(*buffer, s.data(), n);
+            size_t n = 0;
+            *buffer = static_cast<iclient_persistence*>(handle)->get_buffer(key, n);
             *buflen = int(n);
             return MQTTASYNC_SUCCESS;
         }
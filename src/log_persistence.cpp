@@ -0,0 +1,379 @@
+// log_persistence.cpp
+
+/*******************************************************************************
+ * Copyright (c) 2025 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+#include "mqtt/log_persistence.h"
+
+#include <cctype>
+#include <cstdint>
+#include <cstring>
+
+#include "mqtt/exception.h"
+
+#if defined(_WIN32)
+    #include <io.h>
+#else
+    #include <unistd.h>
+#endif
+
+namespace mqtt {
+
+/////////////////////////////////////////////////////////////////////////////
+// Each record in the log is laid out as:
+//
+//   type (1) | key length (4) | value length (4) | key | value | checksum (4)
+//
+// with the integers in little-endian order, and the checksum (FNV-1a)
+// covering everything before it.
+
+namespace {
+
+constexpr size_t HDR_SIZE = 1 + 4 + 4;
+constexpr size_t CHECKSUM_SIZE = 4;
+
+// The size of a record with the specified key and value sizes.
+constexpr size_t record_size(size_t keyLen, size_t valLen) {
+    return HDR_SIZE + keyLen + valLen + CHECKSUM_SIZE;
+}
+
+void put_u32(string& s, uint32_t n) {
+    for (int i = 0; i < 4; ++i) s.push_back(char((n >> (8 * i)) & 0xFF));
+}
+
+uint32_t get_u32(const char* p) {
+    uint32_t n = 0;
+    for (int i = 0; i < 4; ++i) n |= uint32_t(uint8_t(p[i])) << (8 * i);
+    return n;
+}
+
+uint32_t checksum(const char* p, size_t n) {
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < n; ++i) {
+        h ^= uint8_t(p[i]);
+        h *= 16777619u;
+    }
+    return h;
+}
+
+}  // namespace
+
+/////////////////////////////////////////////////////////////////////////////
+
+log_persistence::~log_persistence() { close_log(); }
+
+string log_persistence::get_path() const
+{
+    std::lock_guard<std::mutex> g{lock_};
+    return path_;
+}
+
+size_t log_persistence::get_log_size() const
+{
+    std::lock_guard<std::mutex> g{lock_};
+    return logSize_;
+}
+
+size_t log_persistence::make_record(
+    char type, const string& key, const std::vector<string_view>& bufs
+)
+{
+    size_t valLen = 0;
+    for (const auto& b : bufs) valLen += b.size();
+
+    rec_.clear();
+    rec_.reserve(record_size(key.size(), valLen));
+
+    rec_.push_back(type);
+    put_u32(rec_, uint32_t(key.size()));
+    put_u32(rec_, uint32_t(valLen));
+    rec_.append(key);
+    for (const auto& b : bufs) rec_.append(b.data(), b.size());
+    put_u32(rec_, checksum(rec_.data(), rec_.size()));
+
+    return rec_.size();
+}
+
+void log_persistence::append_record()
+{
+    if (!file_)
+        throw persistence_exception("Persistence store is not open");
+
+    if (std::fwrite(rec_.data(), 1, rec_.size(), file_) != rec_.size() ||
+        std::fflush(file_) != 0) {
+        // Don't leave a partial record in front of the next one. The live
+        // data hasn't been updated yet, so rewrite the log from it.
+        try {
+            compact();
+        }
+        catch (...) {
+        }
+        throw persistence_exception("Error writing the persistence log");
+    }
+}
+
+bool log_persistence::recover()
+{
+    store_.clear();
+    logSize_ = liveSize_ = 0;
+
+    std::FILE* f = std::fopen(path_.c_str(), "rb");
+    if (!f)
+        return true;
+
+    string buf;
+    char chunk[16 * 1024];
+    size_t n;
+    while ((n = std::fread(chunk, 1, sizeof(chunk), f)) > 0) buf.append(chunk, n);
+    std::fclose(f);
+
+    const char* p = buf.data();
+    const size_t sz = buf.size();
+    size_t pos = 0;
+
+    while (sz - pos >= HDR_SIZE) {
+        const char* rec = p + pos;
+        size_t keyLen = get_u32(rec + 1), valLen = get_u32(rec + 5);
+
+        if (keyLen > sz || valLen > sz)
+            break;
+
+        size_t recLen = record_size(keyLen, valLen);
+        if (sz - pos < recLen)
+            break;
+
+        if (get_u32(rec + recLen - CHECKSUM_SIZE) != checksum(rec, recLen - CHECKSUM_SIZE))
+            break;
+
+        string key{rec + HDR_SIZE, keyLen};
+        auto it = store_.find(key);
+
+        if (it != store_.end()) {
+            liveSize_ -= record_size(keyLen, it->second.size());
+            if (rec[0] == REMOVE)
+                store_.erase(it);
+        }
+
+        if (rec[0] == PUT) {
+            store_[std::move(key)] = string{rec + HDR_SIZE + keyLen, valLen};
+            liveSize_ += recLen;
+        }
+        else if (rec[0] != REMOVE) {
+            break;
+        }
+
+        pos += recLen;
+    }
+
+    logSize_ = pos;
+    return pos == sz;
+}
+
+void log_persistence::compact()
+{
+    const string tmpPath = path_ + ".tmp";
+
+    std::FILE* f = std::fopen(tmpPath.c_str(), "wb");
+    if (!f)
+        throw persistence_exception("Can't create the persistence log: " + tmpPath);
+
+    bool ok = true;
+    for (const auto& kv : store_) {
+        make_record(PUT, kv.first, {string_view{kv.second}});
+        if (std::fwrite(rec_.data(), 1, rec_.size(), f) != rec_.size()) {
+            ok = false;
+            break;
+        }
+    }
+
+    if (std::fclose(f) != 0 || !ok) {
+        std::remove(tmpPath.c_str());
+        throw persistence_exception("Error writing the persistence log: " + tmpPath);
+    }
+
+    close_log();
+
+    // Some platforms won't rename over an existing file.
+    if (std::rename(tmpPath.c_str(), path_.c_str()) != 0) {
+        std::remove(path_.c_str());
+        if (std::rename(tmpPath.c_str(), path_.c_str()) != 0)
+            throw persistence_exception("Can't replace the persistence log: " + path_);
+    }
+
+    logSize_ = liveSize_;
+    open_log("ab");
+}
+
+void log_persistence::maybe_compact()
+{
+    if (logSize_ >= compactSize_ && logSize_ > 2 * liveSize_)
+        compact();
+}
+
+void log_persistence::open_log(const char* mode)
+{
+    file_ = std::fopen(path_.c_str(), mode);
+    if (!file_)
+        throw persistence_exception("Can't open the persistence log: " + path_);
+}
+
+void log_persistence::close_log()
+{
+    if (file_) {
+        std::fclose(file_);
+        file_ = nullptr;
+    }
+}
+
+// --------------------------------------------------------------------------
+
+void log_persistence::open(const string& clientId, const string& serverURI)
+{
+    std::lock_guard<std::mutex> g{lock_};
+
+    string name = clientId + "-" + serverURI;
+    for (auto& c : name) {
+        if (!std::isalnum(static_cast<unsigned char>(c)) && c != '-' && c != '_' && c != '.')
+            c = '-';
+    }
+
+    close_log();
+    path_ = dir_.empty() ? name : (dir_ + "/" + name);
+    path_ += ".log";
+
+    // A damaged tail is discarded by rewriting the log
+    if (!recover()) {
+        compact();
+    }
+    else {
+        open_log("ab");
+        maybe_compact();
+    }
+}
+
+void log_persistence::close()
+{
+    std::lock_guard<std::mutex> g{lock_};
+    close_log();
+    store_.clear();
+    logSize_ = liveSize_ = 0;
+}
+
+void log_persistence::clear()
+{
+    std::lock_guard<std::mutex> g{lock_};
+    store_.clear();
+    logSize_ = liveSize_ = 0;
+
+    if (file_) {
+        close_log();
+        open_log("wb");
+    }
+}
+
+bool log_persistence::contains_key(const string& key)
+{
+    std::lock_guard<std::mutex> g{lock_};
+    return store_.find(key) != store_.end();
+}
+
+string_collection log_persistence::keys() const
+{
+    std::lock_guard<std::mutex> g{lock_};
+    string_collection ks;
+    for (const auto& kv : store_) ks.push_back(kv.first);
+    return ks;
+}
+
+void log_persistence::put(const string& key, const std::vector<string_view>& bufs)
+{
+    std::lock_guard<std::mutex> g{lock_};
+
+    size_t n = make_record(PUT, key, bufs);
+    append_record();
+    logSize_ += n;
+
+    auto it = store_.find(key);
+    if (it != store_.end())
+        liveSize_ -= record_size(key.size(), it->second.size());
+    else
+        it = store_.emplace(key, string{}).first;
+
+    it->second.assign(rec_, HDR_SIZE + key.size(), n - record_size(key.size(), 0));
+    liveSize_ += n;
+
+    maybe_compact();
+}
+
+string log_persistence::get(const string& key) const
+{
+    std::lock_guard<std::mutex> g{lock_};
+    auto it = store_.find(key);
+    if (it == store_.end())
+        throw persistence_exception();
+    return it->second;
+}
+
+char* log_persistence::get_buffer(const string& key, size_t& n) const
+{
+    std::lock_guard<std::mutex> g{lock_};
+    auto it = store_.find(key);
+    if (it == store_.end())
+        throw persistence_exception();
+
+    n = it->second.size();
+    char* buf = static_cast<char*>(persistence_malloc(n));
+    std::memcpy(buf, it->second.data(), n);
+    return buf;
+}
+
+void log_persistence::remove(const string& key)
+{
+    std::lock_guard<std::mutex> g{lock_};
+
+    auto it = store_.find(key);
+    if (it == store_.end())
+        throw persistence_exception();
+
+    size_t n = make_record(REMOVE, key, {});
+    append_record();
+    logSize_ += n;
+
+    liveSize_ -= record_size(key.size(), it->second.size());
+    store_.erase(it);
+
+    maybe_compact();
+}
+
+void log_persistence::sync()
+{
+    std::lock_guard<std::mutex> g{lock_};
+
+    if (!file_)
+        throw persistence_exception("Persistence store is not open");
+
+#if defined(_WIN32)
+    int rc = _commit(_fileno(file_));
+#else
+    int rc = ::fsync(::fileno(file_));
+#endif
+
+    if (rc != 0)
+        throw persistence_exception("Error syncing the persistence log: " + path_);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+}  // namespace mqtt
@@ -0,0 +1,58 @@
+// memory_budget.cpp
+
+/*******************************************************************************
+ * Copyright (c) 2025 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+#include "mqtt/memory_budget.h"
+
+namespace mqtt {
+
+/////////////////////////////////////////////////////////////////////////////
+
+void memory_budget::charge(size_t n)
+{
+    auto used = used_.fetch_add(n, std::memory_order_relaxed) + n;
+    auto hw = highWater_.load(std::memory_order_relaxed);
+    while (used > hw && !highWater_.compare_exchange_weak(hw, used, std::memory_order_relaxed));
+}
+
+// The lock is only needed with a limit, for the threads waiting on room.
+// Notifying under it keeps a waiter from missing the release
+// between checking for room and starting to wait.
+
+void memory_budget::release(size_t n)
+{
+    auto used = used_.load(std::memory_order_relaxed);
+    while (!used_.compare_exchange_weak(
+        used, (n < used) ? (used - n) : 0, std::memory_order_relaxed
+    ));
+
+    if (limit_ != 0) {
+        guard g{lock_};
+        releasedCond_.notify_all();
+    }
+}
+
+void memory_budget::wait(size_t n)
+{
+    if (has_room(n))
+        return;
+    unique_guard g{lock_};
+    releasedCond_.wait(g, [this, n] { return has_room(n); });
+}
+
+/////////////////////////////////////////////////////////////////////////////
+}  // namespace mqtt
@@ -0,0 +1,185 @@
+// memory_persistence.cpp
+
+/*******************************************************************************
+ * Copyright (c) 2025 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+#include "mqtt/memory_persistence.h"
+
+#include <cstring>
+
+#include "mqtt/exception.h"
+
+namespace mqtt {
+
+/////////////////////////////////////////////////////////////////////////////
+
+memory_persistence::~memory_persistence()
+{
+    // Only the large entries have memory outside the slabs
+    for (const auto& kv : store_) {
+        if (kv.second.sizeIdx == N_SIZES)
+            delete[] kv.second.blk;
+    }
+}
+
+size_t memory_persistence::size_index(size_t n)
+{
+    size_t idx = 0;
+    for (size_t sz = MIN_BLOCK_SIZE; sz < n && idx < N_SIZES; sz <<= 1) ++idx;
+    return idx;
+}
+
+char* memory_persistence::allocate(size_t sizeIdx, size_t n)
+{
+    if (sizeIdx == N_SIZES)
+        return new char[n];
+
+    auto& blks = freeBlks_[sizeIdx];
+
+    // Carve a new slab into blocks of this size
+    if (blks.empty()) {
+        const size_t blkSize = MIN_BLOCK_SIZE << sizeIdx;
+        slabs_.emplace_back(new char[SLAB_SIZE]);
+        char* p = slabs_.back().get();
+        for (size_t off = 0; off + blkSize <= SLAB_SIZE; off += blkSize)
+            blks.push_back(p + off);
+    }
+
+    char* blk = blks.back();
+    blks.pop_back();
+    return blk;
+}
+
+void memory_persistence::deallocate(const entry& e) noexcept
+{
+    if (e.sizeIdx == N_SIZES)
+        delete[] e.blk;
+    else
+        freeBlks_[e.sizeIdx].push_back(e.blk);
+}
+
+// --------------------------------------------------------------------------
+
+size_t memory_persistence::size() const
+{
+    std::lock_guard<std::mutex> g{lock_};
+    return store_.size();
+}
+
+size_t memory_persistence::free_count() const
+{
+    std::lock_guard<std::mutex> g{lock_};
+    size_t n = 0;
+    for (const auto& blks : freeBlks_) n += blks.size();
+    return n;
+}
+
+void memory_persistence::clear()
+{
+    std::lock_guard<std::mutex> g{lock_};
+    for (const auto& kv : store_) {
+        if (kv.second.sizeIdx == N_SIZES)
+            delete[] kv.second.blk;
+    }
+    store_.clear();
+    for (auto& blks : freeBlks_) blks.clear();
+    slabs_.clear();
+}
+
+bool memory_persistence::contains_key(const string& key)
+{
+    std::lock_guard<std::mutex> g{lock_};
+    return store_.find(key) != store_.end();
+}
+
+string_collection memory_persistence::keys() const
+{
+    std::lock_guard<std::mutex> g{lock_};
+    string_collection ks;
+    for (const auto& kv : store_) ks.push_back(string{kv.first});
+    return ks;
+}
+
+void memory_persistence::put(const string& key, const std::vector<string_view>& bufs)
+{
+    size_t len = 0;
+    for (const auto& b : bufs) len += b.size();
+
+    const size_t n = key.size() + len;
+
+    std::lock_guard<std::mutex> g{lock_};
+
+    const size_t sizeIdx = size_index(n);
+    char* blk = allocate(sizeIdx, n);
+
+    char* p = blk;
+    std::memcpy(p, key.data(), key.size());
+    p += key.size();
+    for (const auto& b : bufs) {
+        if (b.size() > 0) {
+            std::memcpy(p, b.data(), b.size());
+            p += b.size();
+        }
+    }
+
+    // The key view must point into the new block, so replace the entry.
+    entry e{blk, len, sizeIdx};
+    auto it = store_.find(key);
+    if (it != store_.end()) {
+        deallocate(it->second);
+        store_.erase(it);
+    }
+    store_.emplace(std::string_view{blk, key.size()}, e);
+}
+
+string memory_persistence::get(const string& key) const
+{
+    std::lock_guard<std::mutex> g{lock_};
+    auto it = store_.find(key);
+    if (it == store_.end())
+        throw persistence_exception();
+
+    const auto& e = it->second;
+    return string{e.blk + it->first.size(), e.len};
+}
+
+char* memory_persistence::get_buffer(const string& key, size_t& n) const
+{
+    std::lock_guard<std::mutex> g{lock_};
+    auto it = store_.find(key);
+    if (it == store_.end())
+        throw persistence_exception();
+
+    const auto& e = it->second;
+    n = e.len;
+    char* buf = static_cast<char*>(persistence_malloc(n));
+    std::memcpy(buf, e.blk + it->first.size(), n);
+    return buf;
+}
+
+void memory_persistence::remove(const string& key)
+{
+    std::lock_guard<std::mutex> g{lock_};
+    auto it = store_.find(key);
+    if (it == store_.end())
+        throw persistence_exception();
+
+    deallocate(it->second);
+    store_.erase(it);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+}  // namespace mqtt
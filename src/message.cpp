@@ -42,7 +42,8 @@ message::message(
     set_payload(payload, len);
     set_qos(qos);
     set_retained(retained);
-    set_properties(props);
+    if (!props.empty())
+        set_properties(props);
 }
 
 message::message(
@@ -54,7 +55,8 @@ message::message(
     set_payload(std::move(payload));
     set_qos(qos);
     set_retained(retained);
-    set_properties(props);
+    if (!props.empty())
+        set_properties(props);
 }
 
 message::message(string_ref topic, const MQTTAsync_message& cmsg)
@@ -64,20 +66,65 @@ message::message(string_ref topic, const MQTTAsync_message& cmsg)
     msg_.properties = props_.c_struct();
 }
 
+message::message(string_ref topic, const MQTTAsync_message& cmsg, binary_ref payload)
+    : msg_(cmsg), topic_(std::move(topic)), props_(cmsg.properties)
+{
+    set_payload(std::move(payload));
+    msg_.properties = props_.c_struct();
+}
+
 message::message(const message& other)
-    : msg_(other.msg_), topic_(other.topic_), props_(other.props_)
+    : msg_(other.msg_),
+      topic_(other.topic_),
+      props_(other.props_),
+      sharedProps_(other.sharedProps_)
 {
     set_payload(other.payload_);
-    msg_.properties = props_.c_struct();
+    msg_.properties = get_properties().c_struct();
 }
 
 message::message(message&& other)
-    : msg_(other.msg_), topic_(std::move(other.topic_)), props_(std::move(other.props_))
+    : msg_(other.msg_),
+      topic_(std::move(other.topic_)),
+      props_(std::move(other.props_)),
+      sharedProps_(std::move(other.sharedProps_))
 {
     set_payload(std::move(other.payload_));
     other.msg_.payloadlen = 0;
     other.msg_.payload = nullptr;
-    msg_.properties = props_.c_struct();
+    msg_.properties = get_properties().c_struct();
+}
+
+// The properties are shared with an aliasing pointer into the original,
+// which works whether it owns them or shares them itself.
+
+message::ptr_t message::forward(const const_ptr_t& msg, string_ref topic)
+{
+    auto fwd = std::make_shared<message>(
+        topic ? std::move(topic) : msg->topic_, msg->payload_, msg->get_qos(),
+        msg->is_retained()
+    );
+
+    const auto& props = msg->get_properties();
+    if (props.empty())
+        return fwd;
+
+    if (props.contains(property::SUBSCRIPTION_IDENTIFIER) ||
+        props.contains(property::TOPIC_ALIAS)) {
+        properties fwdProps;
+        for (const auto& prop : props) {
+            auto typ = prop.type();
+            if (typ != property::SUBSCRIPTION_IDENTIFIER && typ != property::TOPIC_ALIAS)
+                fwdProps.add(prop);
+        }
+        fwd->set_properties(std::move(fwdProps));
+    }
+    else if (msg->sharedProps_)
+        fwd->share_properties(msg->sharedProps_);
+    else
+        fwd->share_properties(std::shared_ptr<const properties>{msg, &msg->props_});
+
+    return fwd;
 }
 
 message& message::operator=(const message& rhs)
@@ -86,7 +133,10 @@ message& message::operator=(const message& rhs)
         msg_ = rhs.msg_;
         topic_ = rhs.topic_;
         set_payload(rhs.payload_);
-        set_properties(rhs.props_);
+        if (rhs.sharedProps_)
+            share_properties(rhs.sharedProps_);
+        else
+            set_properties(rhs.props_);
     }
     return *this;
 }
@@ -97,7 +147,10 @@ message& message::operator=(message&& rhs)
         msg_ = rhs.msg_;
         topic_ = std::move(rhs.topic_);
         set_payload(std::move(rhs.payload_));
-        set_properties(std::move(rhs.props_));
+        if (rhs.sharedProps_)
+            share_properties(std::move(rhs.sharedProps_));
+        else
+            set_properties(std::move(rhs.props_));
 
         rhs.msg_ = DFLT_C_STRUCT;
     }
@@ -0,0 +1,192 @@
+// message_dispatcher.cpp
+
+/*******************************************************************************
+ * Copyright (c) 2025 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+#include "mqtt/message_dispatcher.h"
+
+#include <algorithm>
+#include <string_view>
+
+namespace mqtt {
+
+/////////////////////////////////////////////////////////////////////////////
+
+message_dispatcher::message_dispatcher(
+    handler_type handler, size_t nWorkers, key_func keyFunc /*=key_func{}*/
+)
+    : handler_{std::move(handler)}, keyFunc_{std::move(keyFunc)}
+{
+    if (!keyFunc_)
+        keyFunc_ = &message_dispatcher::topic_key;
+
+    start(nWorkers);
+}
+
+message_dispatcher::message_dispatcher(
+    handler_type handler, size_t nWorkers, dispatch_mode mode
+)
+    : handler_{std::move(handler)}, keyFunc_{&message_dispatcher::topic_key}, mode_{mode}
+{
+    start(nWorkers);
+}
+
+void message_dispatcher::start(size_t nWorkers)
+{
+    if (nWorkers == 0)
+        nWorkers = std::max(1u, std::thread::hardware_concurrency());
+
+    workers_.reserve(nWorkers);
+    for (size_t i = 0; i < nWorkers; ++i) workers_.push_back(std::make_unique<worker>());
+
+    for (size_t i = 0; i < nWorkers; ++i) {
+        workers_[i]->thr = (mode_ == dispatch_mode::ORDERED)
+                               ? std::thread(&message_dispatcher::run, this, std::ref(*workers_[i]))
+                               : std::thread(&message_dispatcher::run_unordered, this, i);
+    }
+}
+
+message_dispatcher::~message_dispatcher() { stop(); }
+
+size_t message_dispatcher::topic_key(const const_message_ptr& msg)
+{
+    const auto& topic = msg->get_topic_ref();
+    return std::hash<std::string_view>{}(std::string_view{topic.data(), topic.size()});
+}
+
+void message_dispatcher::run(worker& w)
+{
+    const_message_ptr msg;
+    while (w.que.get(&msg)) {
+        try {
+            handler_(std::move(msg));
+        }
+        catch (...) {
+        }
+        msg.reset();
+    }
+}
+
+// A worker only sleeps once there's nothing queued anywhere. The count is
+// raised before the dispatcher checks for idle workers, and checked by a
+// worker after it says that it's idle, so a wakeup can't be missed.
+
+void message_dispatcher::run_unordered(size_t idx)
+{
+    const_message_ptr msg;
+    while (true) {
+        if (take(idx, &msg)) {
+            nQueued_.fetch_sub(1);
+            try {
+                handler_(std::move(msg));
+            }
+            catch (...) {
+            }
+            msg.reset();
+            continue;
+        }
+
+        std::unique_lock<std::mutex> g{idleLock_};
+        if (stopping_ && nQueued_ == 0)
+            break;
+
+        ++nIdle_;
+        idleCond_.wait(g, [this] { return nQueued_ > 0 || stopping_; });
+        --nIdle_;
+    }
+}
+
+// The search for a message to steal starts with the next worker, so the
+// idle ones don't all pile onto the first.
+
+bool message_dispatcher::take(size_t idx, const_message_ptr* msg)
+{
+    if (workers_[idx]->que.try_get(msg))
+        return true;
+
+    const size_t n = workers_.size();
+    for (size_t i = 1; i < n; ++i) {
+        if (workers_[(idx + i) % n]->que.try_get(msg))
+            return true;
+    }
+    return false;
+}
+
+size_t message_dispatcher::pending() const
+{
+    size_t n = 0;
+    for (const auto& w : workers_) n += w->que.size();
+    return n;
+}
+
+bool message_dispatcher::set_cpu_affinity(const cpu_set& cpus, bool onePerWorker)
+{
+    if (cpus.empty())
+        return false;
+
+    bool ok = true;
+    for (size_t i = 0; i < workers_.size(); ++i) {
+        auto& thr = workers_[i]->thr;
+        ok = (onePerWorker ? cpu_set{cpus[i]}.pin(thr) : cpus.pin(thr)) && ok;
+    }
+    return ok;
+}
+
+bool message_dispatcher::dispatch(const_message_ptr msg)
+{
+    if (!msg)
+        return false;
+
+    if (mode_ == dispatch_mode::ORDERED) {
+        auto& w = *workers_[worker_index(keyFunc_(msg))];
+        return w.que.try_put(std::move(msg));
+    }
+
+    // Counted before it's queued, so that the count can't go below zero
+    ++nQueued_;
+    auto& w = *workers_[next_.fetch_add(1, std::memory_order_relaxed) % workers_.size()];
+    if (!w.que.try_put(std::move(msg))) {
+        --nQueued_;
+        return false;
+    }
+
+    if (nIdle_ > 0) {
+        std::lock_guard<std::mutex> g{idleLock_};
+        idleCond_.notify_one();
+    }
+    return true;
+}
+
+void message_dispatcher::stop()
+{
+    for (auto& w : workers_) w->que.close();
+
+    if (mode_ == dispatch_mode::UNORDERED) {
+        {
+            std::lock_guard<std::mutex> g{idleLock_};
+            stopping_ = true;
+        }
+        idleCond_.notify_all();
+    }
+
+    for (auto& w : workers_) {
+        if (w->thr.joinable())
+            w->thr.join();
+    }
+}
+
+/////////////////////////////////////////////////////////////////////////////
+}  // namespace mqtt
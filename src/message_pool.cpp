@@ -0,0 +1,182 @@
+// message_pool.cpp
+
+/*******************************************************************************
+ * Copyright (c) 2025 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+#include "mqtt/message_pool.h"
+
+#include <cstring>
+#include <new>
+
+namespace mqtt {
+
+/////////////////////////////////////////////////////////////////////////////
+// message_pool::arena
+
+message_pool::arena::~arena()
+{
+    for (auto& lst : lists_) {
+        for (auto p : lst.blks) {
+            if (upstream_)
+                upstream_->deallocate(p, lst.blkSize);
+            else
+                ::operator delete(p);
+        }
+    }
+}
+
+message_pool::arena::free_list& message_pool::arena::get_list(size_t n)
+{
+    for (auto& lst : lists_) {
+        if (lst.blkSize == n)
+            return lst;
+    }
+    lists_.push_back(free_list{n, {}});
+    lists_.back().blks.reserve(maxFree_);
+    return lists_.back();
+}
+
+void* message_pool::arena::allocate(size_t n)
+{
+    {
+        std::lock_guard<std::mutex> g{lock_};
+        auto& lst = get_list(n);
+        if (!lst.blks.empty()) {
+            void* p = lst.blks.back();
+            lst.blks.pop_back();
+            return p;
+        }
+        if (upstream_)
+            return upstream_->allocate(n);
+    }
+    return ::operator new(n);
+}
+
+void message_pool::arena::deallocate(void* p, size_t n) noexcept
+{
+    {
+        std::lock_guard<std::mutex> g{lock_};
+        for (auto& lst : lists_) {
+            if (lst.blkSize == n) {
+                if (lst.blks.size() < maxFree_) {
+                    lst.blks.push_back(p);
+                    return;
+                }
+                break;
+            }
+        }
+        if (upstream_) {
+            upstream_->deallocate(p, n);
+            return;
+        }
+    }
+    ::operator delete(p);
+}
+
+// The buffers too big to pool come straight from the heap or the resource.
+
+void* message_pool::arena::allocate_data(size_t n)
+{
+    if (!upstream_)
+        return ::operator new(n);
+
+    std::lock_guard<std::mutex> g{lock_};
+    return upstream_->allocate(n, 1);
+}
+
+void message_pool::arena::deallocate_data(void* p, size_t n) noexcept
+{
+    if (!upstream_) {
+        ::operator delete(p);
+        return;
+    }
+
+    std::lock_guard<std::mutex> g{lock_};
+    upstream_->deallocate(p, n, 1);
+}
+
+size_t message_pool::arena::free_count()
+{
+    std::lock_guard<std::mutex> g{lock_};
+    size_t n = 0;
+    for (const auto& lst : lists_) n += lst.blks.size();
+    return n;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// message_pool
+
+size_t message_pool::block_size(size_t n)
+{
+    if (n > MAX_POOLED_SIZE)
+        return 0;
+
+    size_t sz = MIN_BLOCK_SIZE;
+    while (sz < n) sz <<= 1;
+    return sz;
+}
+
+// The data is adopted by the buffer, with the shared state in the pool as
+// well. The shared state holds the arena, so the deleter only needs a
+// pointer to it, and stays small enough to not need an allocation itself.
+
+binary_ref message_pool::create_buffer(const void* buf, size_t n)
+{
+    using value_type = binary_ref::value_type;
+
+    // Small buffers are held in place, and don't need the pool.
+    if (n <= binary_ref::SMALL_SIZE)
+        return binary_ref{static_cast<const value_type*>(buf), n};
+
+    arena* a = arena_.get();
+
+    if (size_t sz = block_size(n); sz != 0) {
+        auto p = static_cast<value_type*>(a->allocate(sz));
+        std::memcpy(p, buf, n);
+        return binary_ref{
+            p, n, [a, sz](const value_type* q) { a->deallocate(const_cast<value_type*>(q), sz); },
+            allocator<char>{arena_}
+        };
+    }
+
+    auto p = static_cast<value_type*>(a->allocate_data(n));
+    std::memcpy(p, buf, n);
+    return binary_ref{
+        p, n, [a, n](const value_type* q) { a->deallocate_data(const_cast<value_type*>(q), n); },
+        allocator<char>{arena_}
+    };
+}
+
+message_ptr message_pool::create_message(string_ref topic, const MQTTAsync_message& msg)
+{
+    binary_ref payload;
+    if (msg.payload && msg.payloadlen > 0)
+        payload = create_buffer(msg.payload, size_t(msg.payloadlen));
+
+    return create_message(std::move(topic), msg, std::move(payload));
+}
+
+message_ptr message_pool::create_message(
+    string_ref topic, const MQTTAsync_message& msg, binary_ref payload
+)
+{
+    return std::allocate_shared<message>(
+        allocator<message>{arena_}, std::move(topic), msg, std::move(payload)
+    );
+}
+
+/////////////////////////////////////////////////////////////////////////////
+}  // namespace mqtt
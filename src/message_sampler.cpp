@@ -0,0 +1,59 @@
+// message_sampler.cpp
+
+/*******************************************************************************
+ * Copyright (c) 2025 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+#include "mqtt/message_sampler.h"
+
+namespace mqtt {
+
+/////////////////////////////////////////////////////////////////////////////
+
+void message_sampler::add_rule(const string& filter, uint64_t every)
+{
+    rules_.update([&](auto& tm) {
+        size_t order;
+        if (auto it = tm.find(filter); it != tm.end())
+            order = it->second->order;
+        else
+            order = nAdded_.fetch_add(1, std::memory_order_relaxed);
+
+        tm.insert({filter, std::make_shared<rule>(order, every)});
+    });
+}
+
+bool message_sampler::keep(std::string_view topic)
+{
+    rule* r = nullptr;
+    auto snap = rules_.snapshot();
+
+    snap->for_each_match(topic, [&r](const auto& val) {
+        if (!r || val.second->order < r->order)
+            r = val.second.get();
+    });
+
+    if (!r || r->every == 1)
+        return true;
+
+    if (r->every == 0 || r->count.fetch_add(1, std::memory_order_relaxed) % r->every != 0) {
+        nDropped_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    return true;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+}  // namespace mqtt
@@ -0,0 +1,211 @@
+// offline_buffer.cpp
+
+/*******************************************************************************
+ * Copyright (c) 2025 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+#include "mqtt/offline_buffer.h"
+
+#include <cstdint>
+
+#include "mqtt/exception.h"
+
+namespace mqtt {
+
+/////////////////////////////////////////////////////////////////////////////
+
+// Each message in the segment file is a fixed header, with the lengths of
+// the topic and payload in native byte order, followed by the topic and
+// payload. The file never outlives the process, so it needn't be portable.
+
+namespace {
+struct spill_header
+{
+    uint32_t topicLen;
+    uint32_t payloadLen;
+    uint8_t qos;
+    uint8_t retained;
+};
+}  // namespace
+
+offline_buffer::offline_buffer(size_t maxBytes, const string& spillPath, double drainRate)
+    : maxBytes_{maxBytes}, drainRate_{drainRate}, spillPath_{spillPath}
+{
+    if (!spillPath_.empty()) {
+        file_.open(
+            spillPath_, std::ios::in | std::ios::out | std::ios::binary | std::ios::trunc
+        );
+        if (!file_)
+            throw persistence_exception(
+                MQTTASYNC_PERSISTENCE_ERROR, "Can't open offline buffer file: " + spillPath_
+            );
+    }
+}
+
+void offline_buffer::spill(const message& msg)
+{
+    const auto& topic = msg.get_topic_ref();
+    const auto& payload = msg.get_payload_ref();
+
+    spill_header hdr{
+        uint32_t(topic.size()), uint32_t(payload.size()), uint8_t(msg.get_qos()),
+        uint8_t(msg.is_retained() ? 1 : 0)
+    };
+
+    file_.clear();
+    file_.seekp(writePos_);
+    file_.write(reinterpret_cast<const char*>(&hdr), sizeof(hdr));
+    file_.write(topic.data(), topic.size());
+    file_.write(payload.data(), payload.size());
+    file_.flush();
+
+    if (!file_)
+        throw persistence_exception(
+            MQTTASYNC_PERSISTENCE_ERROR, "Can't write offline buffer file: " + spillPath_
+        );
+
+    writePos_ = file_.tellp();
+    ++nSpilled_;
+}
+
+const_message_ptr offline_buffer::unspill()
+{
+    spill_header hdr{};
+
+    file_.clear();
+    file_.seekg(readPos_);
+    file_.read(reinterpret_cast<char*>(&hdr), sizeof(hdr));
+
+    string topic(hdr.topicLen, '\0'), payload(hdr.payloadLen, '\0');
+    if (file_) {
+        file_.read(&topic[0], topic.size());
+        file_.read(&payload[0], payload.size());
+    }
+
+    if (!file_)
+        throw persistence_exception(
+            MQTTASYNC_PERSISTENCE_ERROR, "Can't read offline buffer file: " + spillPath_
+        );
+
+    readPos_ = file_.tellg();
+    if (--nSpilled_ == 0)
+        truncate();
+
+    return message::create(
+        std::move(topic), std::move(payload), int(hdr.qos), hdr.retained != 0
+    );
+}
+
+// Reopening the file is the portable way to shrink it.
+
+void offline_buffer::truncate()
+{
+    readPos_ = writePos_ = 0;
+    nSpilled_ = 0;
+
+    file_.close();
+    file_.open(
+        spillPath_, std::ios::in | std::ios::out | std::ios::binary | std::ios::trunc
+    );
+}
+
+bool offline_buffer::push(const_message_ptr msg)
+{
+    delivery_token_ptr tok;
+    return push(std::move(msg), tok);
+}
+
+bool offline_buffer::push(const_message_ptr msg, delivery_token_ptr& tok)
+{
+    std::lock_guard<std::mutex> g{lock_};
+    auto n = size_of(msg);
+
+    // Once anything has spilled, the rest must follow it, to keep the order.
+    if (nSpilled_ == 0 && nBytes_ + n <= maxBytes_) {
+        nBytes_ += n;
+        msgs_.push_back(entry{std::move(msg), std::move(tok)});
+        tok.reset();
+        return true;
+    }
+
+    if (!file_.is_open())
+        return false;
+
+    spill(*msg);
+    return true;
+}
+
+const_message_ptr offline_buffer::try_pop(delivery_token_ptr& tok)
+{
+    std::lock_guard<std::mutex> g{lock_};
+
+    if (!msgs_.empty()) {
+        auto msg = std::move(msgs_.front().msg);
+        tok = std::move(msgs_.front().tok);
+        msgs_.pop_front();
+        nBytes_ -= size_of(msg);
+        return msg;
+    }
+
+    tok.reset();
+    return (nSpilled_ != 0) ? unspill() : const_message_ptr{};
+}
+
+std::vector<delivery_token_ptr> offline_buffer::release_tokens()
+{
+    std::vector<delivery_token_ptr> toks;
+    std::lock_guard<std::mutex> g{lock_};
+    for (auto& e : msgs_) {
+        if (e.tok)
+            toks.push_back(std::move(e.tok));
+    }
+    return toks;
+}
+
+bool offline_buffer::empty() const
+{
+    std::lock_guard<std::mutex> g{lock_};
+    return msgs_.empty() && nSpilled_ == 0;
+}
+
+size_t offline_buffer::size() const
+{
+    std::lock_guard<std::mutex> g{lock_};
+    return msgs_.size() + nSpilled_;
+}
+
+size_t offline_buffer::bytes_in_memory() const
+{
+    std::lock_guard<std::mutex> g{lock_};
+    return nBytes_;
+}
+
+size_t offline_buffer::num_spilled() const
+{
+    std::lock_guard<std::mutex> g{lock_};
+    return nSpilled_;
+}
+
+void offline_buffer::clear()
+{
+    std::lock_guard<std::mutex> g{lock_};
+    msgs_.clear();
+    nBytes_ = 0;
+    if (file_.is_open())
+        truncate();
+}
+
+/////////////////////////////////////////////////////////////////////////////
+}  // namespace mqtt
@@ -0,0 +1,78 @@
+// pem_file.cpp
+
+/*******************************************************************************
+ * Copyright (c) 2025 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+#include "mqtt/pem_file.h"
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+
+#include "mqtt/exception.h"
+
+#if defined(_WIN32)
+    #include <random>
+#else
+    #include <unistd.h>
+
+    #include <cerrno>
+    #include <cstdlib>
+#endif
+
+namespace mqtt {
+
+/////////////////////////////////////////////////////////////////////////////
+
+pem_file::pem_file(const string& pem)
+{
+    auto dir = std::filesystem::temp_directory_path().string();
+
+#if defined(_WIN32)
+    std::random_device rd;
+    path_ = dir + "\\paho-mqtt-" + std::to_string(rd()) + std::to_string(rd()) + ".pem";
+    std::ofstream os{path_, std::ios::binary | std::ios::trunc};
+    bool ok = bool(os) && bool(os.write(pem.data(), std::streamsize(pem.size())));
+    os.close();
+#else
+    // mkstemp() creates the file, only readable by the user
+    string tmpl = dir + "/paho-mqtt-XXXXXX";
+    int fd = ::mkstemp(&tmpl[0]);
+    if (fd < 0)
+        throw exception(MQTTASYNC_FAILURE, "Can't create PEM file in " + dir);
+
+    path_ = tmpl;
+    bool ok = true;
+    for (size_t n = 0; ok && n < pem.size();) {
+        auto ret = ::write(fd, pem.data() + n, pem.size() - n);
+        if (ret > 0)
+            n += size_t(ret);
+        else if (ret < 0 && errno != EINTR)
+            ok = false;
+    }
+    ok = (::close(fd) == 0) && ok;
+#endif
+
+    if (!ok) {
+        std::remove(path_.c_str());
+        throw exception(MQTTASYNC_FAILURE, "Can't write PEM file: " + path_);
+    }
+}
+
+pem_file::~pem_file() { std::remove(path_.c_str()); }
+
+/////////////////////////////////////////////////////////////////////////////
+}  // namespace mqtt
@@ -18,6 +18,8 @@
 
 #include "mqtt/properties.h"
 
+#include <memory>
+
 namespace mqtt {
 
 PAHO_MQTTPP_EXPORT const std::map<property::code, std::string_view> property::TYPE_NAME{
@@ -251,8 +253,10 @@ properties::properties(std::initializer_list<property> props)
 properties& properties::operator=(const properties& rhs)
 {
     if (&rhs != this) {
-        ::MQTTProperties_free(&props_);
-        props_ = ::MQTTProperties_copy(&rhs.props_);
+        reset_index();
+        if (props_.array)
+            ::MQTTProperties_free(&props_);
+        props_ = (rhs.props_.count > 0) ? ::MQTTProperties_copy(&rhs.props_) : DFLT_C_STRUCT;
     }
     return *this;
 }
@@ -260,23 +264,106 @@ properties& properties::operator=(const properties& rhs)
 properties& properties::operator=(properties&& rhs)
 {
     if (&rhs != this) {
-        ::MQTTProperties_free(&props_);
+        reset_index();
+        if (props_.array)
+            ::MQTTProperties_free(&props_);
         props_ = rhs.props_;
         rhs.props_ = DFLT_C_STRUCT;
+        idx_.store(rhs.idx_.exchange(nullptr));
     }
     return *this;
 }
 
+const properties::index& properties::get_index() const
+{
+    if (auto ix = idx_.load(std::memory_order_acquire))
+        return *ix;
+
+    auto ix = std::make_unique<index>();
+
+    for (int i = 0; i < props_.count; ++i) {
+        const auto& prop = props_.array[i];
+        auto code = size_t(prop.identifier);
+        if (code > MAX_CODE)
+            continue;
+
+        if (ix->count[code]++ == 0)
+            ix->first[code] = i + 1;
+
+        if (code == size_t(property::USER_PROPERTY)) {
+            std::string_view name{prop.value.data.data, size_t(prop.value.data.len)};
+            ix->userProps.emplace(name, i);
+        }
+    }
+
+    // If another thread beat us to it, use theirs.
+    index* expected = nullptr;
+    if (idx_.compare_exchange_strong(
+            expected, ix.get(), std::memory_order_acq_rel, std::memory_order_acquire
+        ))
+        return *ix.release();
+    return *expected;
+}
+
+const MQTTProperty* properties::find(property::code propid, size_t idx /*=0*/) const
+{
+    auto code = size_t(propid);
+
+    if (code > MAX_CODE) {
+        return ::MQTTProperties_getPropertyAt(
+            const_cast<MQTTProperties*>(&props_), MQTTPropertyCodes(propid), int(idx)
+        );
+    }
+
+    const auto& ix = get_index();
+    if (idx >= size_t(ix.count[code]))
+        return nullptr;
+
+    // Most properties can only appear once, so the first is usually it.
+    for (int i = ix.first[code] - 1; i < props_.count; ++i) {
+        if (size_t(props_.array[i].identifier) == code && idx-- == 0)
+            return &props_.array[i];
+    }
+    return nullptr;
+}
+
+size_t properties::count(property::code propid) const
+{
+    auto code = size_t(propid);
+
+    if (code > MAX_CODE) {
+        return size_t(::MQTTProperties_propertyCount(
+            const_cast<MQTTProperties*>(&props_), MQTTPropertyCodes(propid)
+        ));
+    }
+    return size_t(get_index().count[code]);
+}
+
 property properties::get(property::code propid, size_t idx /*=0*/) const
 {
-    MQTTProperty* prop = MQTTProperties_getPropertyAt(
-        const_cast<MQTTProperties*>(&props_), MQTTPropertyCodes(propid), int(idx)
-    );
+    const MQTTProperty* prop = find(propid, idx);
     if (!prop)
         throw bad_cast();
 
     return property(*prop);
 }
 
+bool properties::contains_user_property(std::string_view name) const
+{
+    const auto& ix = get_index();
+    return ix.userProps.find(name) != ix.userProps.end();
+}
+
+string properties::get_user_property(std::string_view name) const
+{
+    const auto& ix = get_index();
+    auto it = ix.userProps.find(name);
+    if (it == ix.userProps.end())
+        throw bad_cast();
+
+    const auto& val = props_.array[it->second].value.value;
+    return val.data ? string(val.data, size_t(val.len)) : string();
+}
+
 /////////////////////////////////////////////////////////////////////////////
 }  // namespace mqtt
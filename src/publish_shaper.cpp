@@ -0,0 +1,153 @@
+// publish_shaper.cpp
+
+/*******************************************************************************
+ * Copyright (c) 2025 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+#include "mqtt/publish_shaper.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace mqtt {
+
+/////////////////////////////////////////////////////////////////////////////
+
+void publish_shaper::add_rule(
+    const string& filter, double rate, size_t burst, shape_policy policy
+)
+{
+    if (rate <= 0.0)
+        throw std::invalid_argument("A publish shaper rule needs a positive rate");
+
+    auto interval =
+        std::chrono::duration_cast<duration>(std::chrono::duration<double>(1.0 / rate));
+    auto tolerance = interval * int64_t(std::max(burst, size_t(1)) - 1);
+
+    std::lock_guard<std::mutex> g{lock_};
+
+    if (auto it = rules_.find(filter); it != rules_.end()) {
+        auto& r = *it->second;
+        r.policy = policy;
+        r.interval = interval;
+        r.tolerance = tolerance;
+        r.nextTime = clock::time_point{};
+        return;
+    }
+
+    auto r = std::make_shared<rule>();
+    r->order = nAdded_++;
+    r->policy = policy;
+    r->interval = interval;
+    r->tolerance = tolerance;
+    rules_.insert({filter, std::move(r)});
+    ++nRules_;
+}
+
+bool publish_shaper::remove_rule(const string& filter)
+{
+    std::lock_guard<std::mutex> g{lock_};
+    if (!rules_.remove(filter))
+        return false;
+    --nRules_;
+    return true;
+}
+
+publish_shaper::rule* publish_shaper::find_rule(const string& topic) const
+{
+    rule* found = nullptr;
+    rules_.for_each_match(topic, [&found](const auto& val) {
+        if (!found || val.second->order < found->order)
+            found = val.second.get();
+    });
+    return found;
+}
+
+// The bucket is kept as the time of the next message at the steady rate,
+// like the one for the reconnect attempts. A message can't be more than
+// the tolerance ahead of it.
+
+publish_shaper::clock::time_point publish_shaper::reserve(rule& r, clock::time_point now)
+{
+    auto when = std::max(now, r.nextTime - r.tolerance);
+    r.nextTime = std::max(r.nextTime, when) + r.interval;
+    return when;
+}
+
+publish_shaper::decision publish_shaper::admit(const const_message_ptr& msg, bool canWait)
+{
+    if (!msg)
+        return decision{};
+
+    const auto& topic = msg->get_topic();
+    std::lock_guard<std::mutex> g{lock_};
+
+    auto r = find_rule(topic);
+    if (!r)
+        return decision{};
+
+    if (r->policy == shape_policy::COALESCE) {
+        if (auto it = r->held.find(topic); it != r->held.end()) {
+            it->second = msg;
+            nCoalesced_.fetch_add(1, std::memory_order_relaxed);
+            return decision{action::COALESCED};
+        }
+    }
+
+    auto now = clock::now();
+    if (r->nextTime - r->tolerance <= now) {
+        reserve(*r, now);
+        return decision{};
+    }
+
+    switch (r->policy) {
+        case shape_policy::DELAY:
+            if (!canWait)
+                return decision{action::WAIT, r->nextTime - r->tolerance - now};
+            nDelayed_.fetch_add(1, std::memory_order_relaxed);
+            return decision{action::WAIT, reserve(*r, now) - now};
+
+        case shape_policy::COALESCE:
+            r->held.emplace(topic, msg);
+            nDelayed_.fetch_add(1, std::memory_order_relaxed);
+            return decision{action::HOLD, reserve(*r, now) - now};
+
+        case shape_policy::DROP:
+            break;
+    }
+
+    nDropped_.fetch_add(1, std::memory_order_relaxed);
+    return decision{action::DROP};
+}
+
+const_message_ptr publish_shaper::release(const string& topic)
+{
+    std::lock_guard<std::mutex> g{lock_};
+
+    auto r = find_rule(topic);
+    if (!r)
+        return const_message_ptr{};
+
+    auto it = r->held.find(topic);
+    if (it == r->held.end())
+        return const_message_ptr{};
+
+    auto msg = std::move(it->second);
+    r->held.erase(it);
+    return msg;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+}  // namespace mqtt
@@ -0,0 +1,54 @@
+// publish_window.cpp
+
+/*******************************************************************************
+ * Copyright (c) 2025 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+#include "mqtt/publish_window.h"
+
+namespace mqtt {
+
+/////////////////////////////////////////////////////////////////////////////
+
+void publish_window::acquire(size_t n)
+{
+    unique_guard g{lock_};
+    notFullCond_.wait(g, [this, n] { return has_room(n); });
+    add(n);
+}
+
+bool publish_window::try_acquire(size_t n)
+{
+    guard g{lock_};
+    if (!has_room(n))
+        return false;
+    add(n);
+    return true;
+}
+
+void publish_window::release(size_t n)
+{
+    {
+        guard g{lock_};
+        if (nMsgs_ > 0)
+            --nMsgs_;
+        nBytes_ = (n < nBytes_) ? (nBytes_ - n) : 0;
+    }
+    // Waiters may be blocked on different sizes
+    notFullCond_.notify_all();
+}
+
+/////////////////////////////////////////////////////////////////////////////
+}  // namespace mqtt
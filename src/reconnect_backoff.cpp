@@ -0,0 +1,95 @@
+// reconnect_backoff.cpp
+
+/*******************************************************************************
+ * Copyright (c) 2025 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+#include "mqtt/reconnect_backoff.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace mqtt {
+
+PAHO_MQTTPP_EXPORT const string reconnect_backoff::HINT_PROPERTY{"retry-after"};
+
+/////////////////////////////////////////////////////////////////////////////
+
+reconnect_backoff::reconnect_backoff(duration minDelay, duration maxDelay)
+    : minDelay_{minDelay},
+      maxDelay_{maxDelay},
+      prevDelay_{minDelay},
+      rng_{std::random_device{}()}
+{
+    if (minDelay.count() <= 0 || minDelay > maxDelay)
+        throw std::invalid_argument("Bad reconnect backoff delays");
+}
+
+void reconnect_backoff::set_rate_limit(double rate, size_t burst)
+{
+    std::lock_guard<std::mutex> g{lock_};
+
+    if (rate > 0.0) {
+        interval_ = std::chrono::duration_cast<clock::duration>(
+            std::chrono::duration<double>(1.0 / rate)
+        );
+        tolerance_ = interval_ * int64_t(std::max(burst, size_t(1)) - 1);
+    }
+    else {
+        interval_ = tolerance_ = clock::duration{0};
+    }
+    nextTime_ = clock::time_point{};
+}
+
+void reconnect_backoff::hint(duration delay)
+{
+    std::lock_guard<std::mutex> g{lock_};
+    hint_ = std::max(hint_, delay);
+}
+
+reconnect_backoff::duration reconnect_backoff::next_delay()
+{
+    std::lock_guard<std::mutex> g{lock_};
+
+    // Decorrelated jitter: random between the minimum and 3x the last
+    auto hi = std::min(maxDelay_.count(), 3 * prevDelay_.count());
+    std::uniform_int_distribution<duration::rep> dist{
+        minDelay_.count(), std::max(hi, minDelay_.count())
+    };
+    prevDelay_ = duration{dist(rng_)};
+
+    auto delay = std::max(prevDelay_, hint_);
+    hint_ = duration{0};
+
+    if (interval_.count() > 0) {
+        // The token bucket, kept as the time of the next attempt at the
+        // steady rate. An attempt can't be more than the tolerance ahead.
+        auto now = clock::now();
+        auto when = std::max(now + delay, nextTime_ - tolerance_);
+        nextTime_ = std::max(nextTime_, when) + interval_;
+        delay = std::chrono::ceil<duration>(when - now);
+    }
+
+    return delay;
+}
+
+void reconnect_backoff::reset()
+{
+    std::lock_guard<std::mutex> g{lock_};
+    prevDelay_ = minDelay_;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+}  // namespace mqtt
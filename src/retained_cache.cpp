@@ -0,0 +1,82 @@
+// retained_cache.cpp
+
+/*******************************************************************************
+ * Copyright (c) 2025 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+#include "mqtt/retained_cache.h"
+
+namespace mqtt {
+
+// The empty nodes left by removed topics are pruned after this many
+// removals, so that a churn of topics doesn't grow the tree forever.
+static constexpr size_t PRUNE_INTERVAL = 1024;
+
+/////////////////////////////////////////////////////////////////////////////
+
+void retained_cache::update(const_message_ptr msg)
+{
+    if (!msg)
+        return;
+
+    const auto& topic = msg->get_topic();
+    std::lock_guard<std::mutex> g{lock_};
+
+    if (msg->get_payload_ref().empty()) {
+        if (msgs_.remove(topic)) {
+            --n_;
+            if (++nRemoved_ >= PRUNE_INTERVAL) {
+                msgs_.prune();
+                nRemoved_ = 0;
+            }
+        }
+        return;
+    }
+
+    auto it = msgs_.find(topic);
+    if (it != msgs_.end())
+        it->second = std::move(msg);
+    else {
+        msgs_.insert({topic, std::move(msg)});
+        ++n_;
+    }
+}
+
+const_message_ptr retained_cache::get(const string& topic) const
+{
+    std::lock_guard<std::mutex> g{lock_};
+    auto it = msgs_.find(topic);
+    return (it != msgs_.end()) ? it->second : const_message_ptr{};
+}
+
+std::vector<const_message_ptr> retained_cache::get_retained(std::string_view filter) const
+{
+    std::vector<const_message_ptr> msgs;
+    std::lock_guard<std::mutex> g{lock_};
+    msgs_.for_each_filtered(filter, [&msgs](const auto& val) {
+        msgs.push_back(val.second);
+    });
+    return msgs;
+}
+
+void retained_cache::clear()
+{
+    std::lock_guard<std::mutex> g{lock_};
+    msgs_ = topic_matcher<const_message_ptr>{};
+    n_ = nRemoved_ = 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+}  // namespace mqtt
@@ -0,0 +1,223 @@
+// rpc_client.cpp
+
+/*******************************************************************************
+ * Copyright (c) 2025 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+#include "mqtt/rpc_client.h"
+
+#include <algorithm>
+#include <charconv>
+
+namespace mqtt {
+
+/////////////////////////////////////////////////////////////////////////////
+// rpc_client::table
+
+rpc_client::table::table(size_t n)
+    : stripes{std::make_unique<stripe[]>(std::max<size_t>(n, 1))},
+      nStripes{std::max<size_t>(n, 1)}
+{
+    for (size_t i = 0; i < nStripes; ++i) stripes[i].wheel.resize(WHEEL_SLOTS);
+}
+
+void rpc_client::table::complete(uint64_t id, const_message_ptr msg)
+{
+    auto& st = stripe_for(id);
+    std::promise<const_message_ptr> prom;
+    {
+        std::lock_guard<std::mutex> g{st.lock};
+        auto it = st.calls.find(id);
+        if (it == st.calls.end())
+            return;  // Timed out, or an unknown response
+        prom = std::move(it->second.prom);
+        st.calls.erase(it);
+    }
+    --nPending;
+    prom.set_value(std::move(msg));
+}
+
+void rpc_client::table::expire(clock::time_point now, clock::duration tick)
+{
+    auto slot = (cursor.fetch_add(1) + 1) % WHEEL_SLOTS;
+    std::vector<std::promise<const_message_ptr>> expired;
+
+    for (size_t i = 0; i < nStripes; ++i) {
+        auto& st = stripes[i];
+        {
+            std::lock_guard<std::mutex> g{st.lock};
+            auto ids = std::move(st.wheel[slot]);
+            st.wheel[slot].clear();
+
+            // The IDs of completed calls are dropped here, and those past
+            // one turn of the wheel are put back for a later turn.
+            for (auto id : ids) {
+                auto it = st.calls.find(id);
+                if (it == st.calls.end())
+                    continue;
+
+                auto left = it->second.deadline - now;
+                if (left <= clock::duration::zero()) {
+                    expired.push_back(std::move(it->second.prom));
+                    st.calls.erase(it);
+                }
+                else {
+                    auto ticks = std::min<size_t>(size_t(left / tick) + 1, WHEEL_SLOTS - 1);
+                    st.wheel[(slot + ticks) % WHEEL_SLOTS].push_back(id);
+                }
+            }
+        }
+
+        for (auto& prom : expired) {
+            --nPending;
+            ++nTimeouts;
+            prom.set_exception(std::make_exception_ptr(timeout_error{}));
+        }
+        expired.clear();
+    }
+}
+
+void rpc_client::table::fail_all(const exception& exc)
+{
+    for (size_t i = 0; i < nStripes; ++i) {
+        auto& st = stripes[i];
+        std::unordered_map<uint64_t, pending> calls;
+        {
+            std::lock_guard<std::mutex> g{st.lock};
+            calls.swap(st.calls);
+            for (auto& ids : st.wheel) ids.clear();
+        }
+        for (auto& call : calls) {
+            --nPending;
+            call.second.prom.set_exception(std::make_exception_ptr(exc));
+        }
+    }
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// rpc_client
+
+rpc_client::rpc_client(
+    async_client& cli, const string& replyTopic, int qos, size_t nStripes,
+    clock::duration tick
+)
+    : cli_{cli},
+      replyTopic_{replyTopic},
+      qos_{qos},
+      tick_{std::max<clock::duration>(tick, std::chrono::milliseconds(1))},
+      tbl_{std::make_shared<table>(nStripes)}
+{
+    std::weak_ptr<table> wtbl = tbl_;
+    cli_.add_message_handler(replyTopic_, [wtbl](const_message_ptr msg) {
+        on_reply(wtbl, std::move(msg));
+    });
+    timerThread_ = std::thread(&rpc_client::timer_loop, this);
+}
+
+rpc_client::~rpc_client()
+{
+    try {
+        cli_.remove_message_handler(replyTopic_);
+    }
+    catch (...) {
+    }
+
+    {
+        std::lock_guard<std::mutex> g{timerLock_};
+        stop_ = true;
+    }
+    timerCond_.notify_all();
+    timerThread_.join();
+
+    tbl_->fail_all(exception{MQTTASYNC_OPERATION_INCOMPLETE, "RPC client destroyed"});
+}
+
+void rpc_client::timer_loop()
+{
+    auto next = clock::now() + tick_;
+    std::unique_lock<std::mutex> g{timerLock_};
+
+    while (!timerCond_.wait_until(g, next, [this] { return stop_; })) {
+        g.unlock();
+        tbl_->expire(clock::now(), tick_);
+        g.lock();
+        next += tick_;
+    }
+}
+
+void rpc_client::on_reply(const std::weak_ptr<table>& wtbl, const_message_ptr msg)
+{
+    auto tbl = wtbl.lock();
+    if (!tbl || !msg)
+        return;
+
+    const auto& props = msg->get_properties();
+    if (!props.contains(property::CORRELATION_DATA))
+        return;
+
+    auto corr = get<binary>(props, property::CORRELATION_DATA);
+    uint64_t id = 0;
+    auto end = corr.data() + corr.size();
+    auto [p, ec] = std::from_chars(corr.data(), end, id);
+    if (ec == std::errc{} && p == end)
+        tbl->complete(id, std::move(msg));
+}
+
+rpc_client::future_type rpc_client::call(message_ptr req, clock::duration timeout)
+{
+    if (!req)
+        throw std::invalid_argument("No request message");
+
+    auto id = nextId_.fetch_add(1, std::memory_order_relaxed);
+
+    auto props = req->get_properties();
+    props.add({property::RESPONSE_TOPIC, replyTopic_});
+    props.add({property::CORRELATION_DATA, std::to_string(id)});
+    req->set_properties(std::move(props));
+
+    auto& st = tbl_->stripe_for(id);
+    auto ticks = (timeout > clock::duration::zero())
+                     ? std::min<size_t>(size_t(timeout / tick_) + 1, WHEEL_SLOTS - 1)
+                     : size_t(1);
+    future_type fut;
+
+    ++tbl_->nPending;
+    {
+        std::lock_guard<std::mutex> g{st.lock};
+        pending call;
+        call.deadline = clock::now() + timeout;
+        fut = call.prom.get_future();
+        st.calls.emplace(id, std::move(call));
+        st.wheel[(tbl_->cursor.load() + ticks) % WHEEL_SLOTS].push_back(id);
+    }
+
+    try {
+        cli_.publish(std::move(req));
+    }
+    catch (...) {
+        bool erased;
+        {
+            std::lock_guard<std::mutex> g{st.lock};
+            erased = st.calls.erase(id) != 0;
+        }
+        if (erased)
+            --tbl_->nPending;
+        throw;
+    }
+    return fut;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+}  // namespace mqtt
@@ -0,0 +1,106 @@
+// sequence_tracker.cpp
+
+/*******************************************************************************
+ * Copyright (c) 2025 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+#include "mqtt/sequence_tracker.h"
+
+#include <charconv>
+
+namespace mqtt {
+
+/////////////////////////////////////////////////////////////////////////////
+
+std::optional<uint64_t> sequence_tracker::sequence_of(const message& msg) const
+{
+    const auto& props = msg.get_properties();
+    if (!props.contains_user_property(propName_))
+        return std::nullopt;
+
+    auto val = props.get_user_property(propName_);
+    uint64_t seq = 0;
+    auto end = val.data() + val.size();
+    auto [p, ec] = std::from_chars(val.data(), end, seq);
+    if (ec != std::errc{} || p != end)
+        return std::nullopt;
+    return seq;
+}
+
+sequence_tracker::result sequence_tracker::check(const message& msg)
+{
+    auto seq = sequence_of(msg);
+    return seq ? check(msg.get_topic(), *seq) : result::UNTRACKED;
+}
+
+sequence_tracker::result sequence_tracker::check(const string& topic, uint64_t seq)
+{
+    std::lock_guard<std::mutex> g{lock_};
+    ++stats_.msgsTracked;
+
+    auto it = last_.find(topic);
+    if (it == last_.end()) {
+        last_.emplace(topic, seq);
+        return result::FIRST;
+    }
+
+    auto& last = it->second;
+
+    if (seq == last) {
+        ++stats_.duplicates;
+        return result::DUPLICATE;
+    }
+
+    if (seq < last) {
+        ++stats_.outOfOrder;
+        return result::OUT_OF_ORDER;
+    }
+
+    auto skipped = seq - last - 1;
+    last = seq;
+
+    if (skipped == 0)
+        return result::IN_ORDER;
+
+    stats_.gaps += skipped;
+    return result::GAP;
+}
+
+std::optional<uint64_t> sequence_tracker::last_sequence(const string& topic) const
+{
+    std::lock_guard<std::mutex> g{lock_};
+    auto it = last_.find(topic);
+    if (it == last_.end())
+        return std::nullopt;
+    return it->second;
+}
+
+sequence_stats sequence_tracker::get_stats() const
+{
+    std::lock_guard<std::mutex> g{lock_};
+    auto stats = stats_;
+    stats.topics = last_.size();
+    return stats;
+}
+
+void sequence_tracker::clear()
+{
+    std::lock_guard<std::mutex> g{lock_};
+    last_.clear();
+    stats_ = sequence_stats{};
+}
+
+/////////////////////////////////////////////////////////////////////////////
+}  // namespace mqtt
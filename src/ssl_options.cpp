@@ -64,6 +64,9 @@ ssl_options::ssl_options(const ssl_options& other)
       keyStore_(other.keyStore_),
       privateKey_(other.privateKey_),
       privateKeyPassword_(other.privateKeyPassword_),
+      trustStorePem_(other.trustStorePem_),
+      keyStorePem_(other.keyStorePem_),
+      privateKeyPem_(other.privateKeyPem_),
       caPath_(other.caPath_),
       enabledCipherSuites_(other.enabledCipherSuites_),
       errHandler_(other.errHandler_),
@@ -79,6 +82,9 @@ ssl_options::ssl_options(ssl_options&& other)
       keyStore_(std::move(other.keyStore_)),
       privateKey_(std::move(other.privateKey_)),
       privateKeyPassword_(std::move(other.privateKeyPassword_)),
+      trustStorePem_(std::move(other.trustStorePem_)),
+      keyStorePem_(std::move(other.keyStorePem_)),
+      privateKeyPem_(std::move(other.privateKeyPem_)),
       caPath_(std::move(other.caPath_)),
       enabledCipherSuites_(std::move(other.enabledCipherSuites_)),
       errHandler_(std::move(other.errHandler_)),
@@ -188,6 +194,9 @@ ssl_options& ssl_options::operator=(const ssl_options& rhs)
     keyStore_ = rhs.keyStore_;
     privateKey_ = rhs.privateKey_;
     privateKeyPassword_ = rhs.privateKeyPassword_;
+    trustStorePem_ = rhs.trustStorePem_;
+    keyStorePem_ = rhs.keyStorePem_;
+    privateKeyPem_ = rhs.privateKeyPem_;
     caPath_ = rhs.caPath_;
     enabledCipherSuites_ = rhs.enabledCipherSuites_;
 
@@ -211,6 +220,9 @@ ssl_options& ssl_options::operator=(ssl_options&& rhs)
     keyStore_ = std::move(rhs.keyStore_);
     privateKey_ = std::move(rhs.privateKey_);
     privateKeyPassword_ = std::move(rhs.privateKeyPassword_);
+    trustStorePem_ = std::move(rhs.trustStorePem_);
+    keyStorePem_ = std::move(rhs.keyStorePem_);
+    privateKeyPem_ = std::move(rhs.privateKeyPem_);
     caPath_ = std::move(rhs.caPath_);
     enabledCipherSuites_ = std::move(rhs.enabledCipherSuites_);
 
@@ -228,21 +240,42 @@ ssl_options& ssl_options::operator=(ssl_options&& rhs)
 void ssl_options::set_trust_store(const string& trustStore)
 {
     trustStore_ = trustStore;
+    trustStorePem_.reset();
     opts_.trustStore = c_str(trustStore_);
 }
 
+void ssl_options::set_trust_store(pem_file_ptr trustStore)
+{
+    set_trust_store(trustStore ? trustStore->path() : string{});
+    trustStorePem_ = std::move(trustStore);
+}
+
 void ssl_options::set_key_store(const string& keyStore)
 {
     keyStore_ = keyStore;
+    keyStorePem_.reset();
     opts_.keyStore = c_str(keyStore_);
 }
 
+void ssl_options::set_key_store(pem_file_ptr keyStore)
+{
+    set_key_store(keyStore ? keyStore->path() : string{});
+    keyStorePem_ = std::move(keyStore);
+}
+
 void ssl_options::set_private_key(const string& privateKey)
 {
     privateKey_ = privateKey;
+    privateKeyPem_.reset();
     opts_.privateKey = c_str(privateKey_);
 }
 
+void ssl_options::set_private_key(pem_file_ptr privateKey)
+{
+    set_private_key(privateKey ? privateKey->path() : string{});
+    privateKeyPem_ = std::move(privateKey);
+}
+
 void ssl_options::set_private_key_password(const string& privateKeyPassword)
 {
     privateKeyPassword_ = privateKeyPassword;
@@ -0,0 +1,132 @@
+// stream_publisher.cpp
+
+/*******************************************************************************
+ * Copyright (c) 2025 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+#include "mqtt/stream_publisher.h"
+
+#include <chrono>
+#include <deque>
+#include <fstream>
+#include <istream>
+#include <stdexcept>
+
+namespace mqtt {
+
+/////////////////////////////////////////////////////////////////////////////
+
+stream_publisher::stream_publisher(
+    async_client& cli, string_ref topic, int qos, size_t chunkSize, size_t maxInFlight
+)
+    : cli_{cli},
+      topic_{std::move(topic)},
+      qos_{qos},
+      chunkSize_{chunkSize},
+      maxInFlight_{maxInFlight}
+{
+    if (chunkSize_ == 0)
+        throw std::invalid_argument("The chunk size can't be zero");
+    if (maxInFlight_ == 0)
+        throw std::invalid_argument("The in-flight limit can't be zero");
+}
+
+// The stream is read a chunk ahead of the one being published, to know
+// which chunk is the last without needing the size of the stream.
+
+uint64_t stream_publisher::publish(std::istream& is, const string& transferId /*=string{}*/)
+{
+    auto read_chunk = [&is, this] {
+        binary buf(chunkSize_, '\0');
+        is.read(&buf[0], std::streamsize(chunkSize_));
+        if (is.bad())
+            throw exception(MQTTASYNC_FAILURE, "Can't read the stream");
+        buf.resize(size_t(is.gcount()));
+        return buf;
+    };
+
+    const bool withProps = (cli_.mqtt_version() >= MQTTVERSION_5);
+    std::deque<delivery_token_ptr> toks;
+    uint64_t nbytes = 0;
+    nChunks_ = 0;
+
+    ++nTransfers_;
+    if (transferId.empty()) {
+        auto t = std::chrono::system_clock::now().time_since_epoch().count();
+        transferId_ = cli_.get_client_id() + "-" + std::to_string(t) + "-" +
+                      std::to_string(nTransfers_);
+    }
+    else
+        transferId_ = transferId;
+
+    // The size of the rest of the stream, if it can seek
+    string sizeStr;
+    if (auto pos = is.tellg(); pos != std::streampos(-1)) {
+        is.seekg(0, std::ios::end);
+        auto end = is.tellg();
+        is.seekg(pos);
+        if (end != std::streampos(-1) && is)
+            sizeStr = std::to_string(uint64_t(end - pos));
+        is.clear(is.rdstate() & ~std::ios::failbit);
+    }
+
+    binary cur = read_chunk();
+    bool last = false;
+
+    while (!last) {
+        binary next;
+        if (cur.size() == chunkSize_)
+            next = read_chunk();
+        last = next.empty();
+
+        properties props;
+        if (withProps) {
+            props.add({property::USER_PROPERTY, TRANSFER_PROPERTY_NAME, transferId_});
+            props.add({property::USER_PROPERTY, OFFSET_PROPERTY_NAME, std::to_string(nbytes)});
+            if (!sizeStr.empty())
+                props.add({property::USER_PROPERTY, SIZE_PROPERTY_NAME, sizeStr});
+            props.add({property::USER_PROPERTY, seqProp_, std::to_string(nChunks_)});
+            if (last)
+                props.add({property::USER_PROPERTY, LAST_PROPERTY_NAME, "1"});
+        }
+
+        if (toks.size() >= maxInFlight_) {
+            toks.front()->wait();
+            toks.pop_front();
+        }
+
+        nbytes += cur.size();
+        toks.push_back(
+            cli_.publish(make_message(topic_, std::move(cur), qos_, false, props))
+        );
+        ++nChunks_;
+        cur = std::move(next);
+    }
+
+    for (auto& tok : toks) tok->wait();
+    return nbytes;
+}
+
+uint64_t stream_publisher::
+    publish_file(const string& path, const string& transferId /*=string{}*/)
+{
+    std::ifstream is{path, std::ios::binary};
+    if (!is)
+        throw exception(MQTTASYNC_FAILURE, "Can't open file: " + path);
+    return publish(is, transferId);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+}  // namespace mqtt
@@ -0,0 +1,43 @@
+// string_intern.cpp
+
+/*******************************************************************************
+ * Copyright (c) 2025 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+#include "mqtt/string_intern.h"
+
+namespace mqtt {
+
+/////////////////////////////////////////////////////////////////////////////
+
+size_t string_intern::size() const
+{
+    std::lock_guard<std::mutex> g{lock_};
+    return tbl_.size();
+}
+
+void string_intern::clear()
+{
+    std::lock_guard<std::mutex> g{lock_};
+    tbl_.clear();
+}
+
+string_ref string_intern::get(std::string_view sv)
+{
+    return get(sv, [](std::string_view s) { return string_ref{string{s}}; });
+}
+
+/////////////////////////////////////////////////////////////////////////////
+}  // namespace mqtt
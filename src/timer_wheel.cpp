@@ -0,0 +1,175 @@
+// timer_wheel.cpp
+
+/*******************************************************************************
+ * Copyright (c) 2025 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+#include "mqtt/timer_wheel.h"
+
+#include <algorithm>
+
+namespace mqtt {
+
+/////////////////////////////////////////////////////////////////////////////
+
+timer_wheel::timer_wheel(duration tick)
+    : tick_{std::max<duration>(tick, std::chrono::milliseconds(1))}, base_{clock::now()}
+{
+    thr_ = std::thread(&timer_wheel::run, this);
+}
+
+timer_wheel::~timer_wheel()
+{
+    {
+        std::lock_guard<std::mutex> g{lock_};
+        stop_ = true;
+    }
+    cond_.notify_all();
+    thr_.join();
+}
+
+uint64_t timer_wheel::ticks_at(clock::time_point tp) const
+{
+    return (tp <= base_) ? uint64_t(0) : uint64_t((tp - base_) / tick_);
+}
+
+// A timer goes into the lowest level that shares the current slots of all
+// the levels above it, so it's moved down as soon as its slot of that
+// level comes around. One that is due goes into the current slot, which is
+// run right after the cascade. One past the range of the wheel is held in
+// the last slot of the top level to come around, and placed again from
+// there.
+
+void timer_wheel::insert(const entry& ent)
+{
+    auto expires = std::max(ent.expires, now_);
+
+    for (unsigned lvl = 0; lvl < N_LEVELS; ++lvl) {
+        auto shift = LEVEL_BITS * (lvl + 1);
+        if ((expires >> shift) == (now_ >> shift)) {
+            auto idx = (expires >> (LEVEL_BITS * lvl)) & (N_SLOTS - 1);
+            wheel_[lvl][idx].push_back(entry{ent.id, ent.expires});
+            return;
+        }
+    }
+
+    constexpr auto top = N_LEVELS - 1;
+    auto idx = ((now_ >> (LEVEL_BITS * top)) + N_SLOTS - 1) & (N_SLOTS - 1);
+    wheel_[top][idx].push_back(entry{ent.id, ent.expires});
+}
+
+void timer_wheel::cascade(unsigned level)
+{
+    auto idx = (now_ >> (LEVEL_BITS * level)) & (N_SLOTS - 1);
+    slot_type ents;
+    ents.swap(wheel_[level][idx]);
+
+    for (const auto& ent : ents) {
+        if (handlers_.count(ent.id) != 0)
+            insert(ent);
+    }
+}
+
+void timer_wheel::advance(std::vector<handler_type>& due)
+{
+    ++now_;
+
+    // The higher levels come around when all the ones below them wrap.
+    unsigned n = 0;
+    while (n + 1 < N_LEVELS && (now_ & ((uint64_t(1) << (LEVEL_BITS * (n + 1))) - 1)) == 0)
+        ++n;
+    for (unsigned lvl = n; lvl > 0; --lvl) cascade(lvl);
+
+    slot_type ents;
+    ents.swap(wheel_[0][now_ & (N_SLOTS - 1)]);
+
+    for (const auto& ent : ents) {
+        auto it = handlers_.find(ent.id);
+        if (it == handlers_.end())
+            continue;  // Cancelled
+
+        if (ent.expires > now_) {
+            insert(ent);
+            continue;
+        }
+        due.push_back(std::move(it->second));
+        handlers_.erase(it);
+    }
+}
+
+void timer_wheel::run()
+{
+    std::vector<handler_type> due;
+    std::unique_lock<std::mutex> g{lock_};
+
+    while (!stop_) {
+        if (handlers_.empty()) {
+            cond_.wait(g, [this] { return stop_ || !handlers_.empty(); });
+            continue;
+        }
+
+        auto next = base_ + tick_ * (now_ + 1);
+        if (cond_.wait_until(g, next, [this] { return stop_; }))
+            break;
+
+        auto target = ticks_at(clock::now());
+        while (now_ < target && !handlers_.empty()) advance(due);
+
+        if (!due.empty()) {
+            g.unlock();
+            for (auto& fn : due) {
+                try {
+                    fn();
+                }
+                catch (...) {
+                }
+            }
+            due.clear();
+            g.lock();
+        }
+    }
+}
+
+timer_wheel::timer_id timer_wheel::schedule(duration delay, handler_type fn)
+{
+    bool wasEmpty;
+    timer_id id;
+    {
+        std::lock_guard<std::mutex> g{lock_};
+        wasEmpty = handlers_.empty();
+
+        // An idle wheel doesn't tick, so it's brought up to date first
+        if (wasEmpty)
+            now_ = ticks_at(clock::now());
+
+        auto ticks = (delay > duration::zero()) ? uint64_t((delay + tick_ - duration(1)) / tick_)
+                                                : uint64_t(0);
+        id = nextId_++;
+        handlers_.emplace(id, std::move(fn));
+        insert(entry{id, now_ + std::max<uint64_t>(ticks, 1)});
+    }
+    if (wasEmpty)
+        cond_.notify_all();
+    return id;
+}
+
+bool timer_wheel::cancel(timer_id id)
+{
+    std::lock_guard<std::mutex> g{lock_};
+    return handlers_.erase(id) != 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+}  // namespace mqtt
@@ -105,12 +105,103 @@ void token::on_failure5(void* context, MQTTAsync_failureData5* rsp)
 // --------------------------------------------------------------------------
 // Object callbacks
 
+// If the client has an executor, the listener and completion handlers are
+// posted to it, holding a reference to the token. Waiting threads are
+// signaled immediately. Tokens that are not owned by a shared pointer can't
+// be kept alive that way, so they're always completed in place.
+
+void token::signal_complete(
+    iaction_listener* listener, bool success, std::vector<std::function<void()>> handlers,
+    bool release
+)
+{
+    auto ex = cli_->get_executor();
+    auto self = ex ? weak_from_this().lock() : ptr_t{};
+
+    if (self) {
+        notify_waiters();
+
+        if (listener || !handlers.empty()) {
+            (*ex)([self, listener, success, handlers = std::move(handlers)] {
+                auto t = self->cli_->callback_start();
+                if (listener) {
+                    if (success)
+                        listener->on_success(*self);
+                    else
+                        listener->on_failure(*self);
+                }
+                for (const auto& fn : handlers) fn();
+                self->cli_->listener_done(*self, t);
+            });
+        }
+        if (release)
+            cli_->remove_token(this);
+        return;
+    }
+
+    // Note: callback always completes before the object is signaled.
+    if (listener) {
+        auto t = cli_->callback_start();
+        if (success)
+            listener->on_success(*this);
+        else
+            listener->on_failure(*this);
+        cli_->listener_done(*this, t);
+    }
+    notify_waiters();
+
+    // Releasing the token might drop the last reference to it, so it's
+    // held while the completion handlers are timed.
+    auto t = handlers.empty() ? std::chrono::steady_clock::time_point{} : cli_->callback_start();
+    auto timed = (t != std::chrono::steady_clock::time_point{}) ? weak_from_this().lock() : ptr_t{};
+
+    if (release)
+        cli_->remove_token(this);
+
+    for (const auto& fn : handlers) fn();
+
+    if (timed)
+        timed->cli_->listener_done(*timed, t);
+}
+
+bool token::release_expired(unique_lock& g)
+{
+    if (!timedOut_)
+        return false;
+
+    g.unlock();
+    cli_->remove_token(this);
+    return true;
+}
+
+bool token::expire()
+{
+    unique_lock g(lock_);
+    if (complete_)
+        return false;
+
+    iaction_listener* listener = listener_;
+    rc_ = MQTTASYNC_FAILURE;
+    errMsg_ = "Timeout";
+    timedOut_ = true;
+    complete_ = true;
+    auto handlers = std::move(completeHandlers_);
+    completeHandlers_.clear();
+    g.unlock();
+
+    signal_complete(listener, false, std::move(handlers), false);
+    return true;
+}
+
 //
 // The success callback for MQTT v3 connections
 //
 void token::on_success(MQTTAsync_successData* rsp)
 {
     unique_lock g(lock_);
+    if (release_expired(g))
+        return;
+
     iaction_listener* listener = listener_;
 
     if (rsp) {
@@ -137,14 +228,11 @@ void token::on_success(MQTTAsync_successData* rsp)
 
     rc_ = MQTTASYNC_SUCCESS;
     complete_ = true;
+    auto handlers = std::move(completeHandlers_);
+    completeHandlers_.clear();
     g.unlock();
 
-    // Note: callback always completes before the object is signaled.
-    if (listener)
-        listener->on_success(*this);
-    cond_.notify_all();
-
-    cli_->remove_token(this);
+    signal_complete(listener, true, std::move(handlers));
 }
 
 //
@@ -153,6 +241,9 @@ void token::on_success(MQTTAsync_successData* rsp)
 void token::on_success5(MQTTAsync_successData5* rsp)
 {
     unique_lock g(lock_);
+    if (release_expired(g))
+        return;
+
     iaction_listener* listener = listener_;
     if (rsp) {
         msgId_ = rsp->token;
@@ -178,14 +269,11 @@ void token::on_success5(MQTTAsync_successData5* rsp)
     }
     rc_ = MQTTASYNC_SUCCESS;
     complete_ = true;
+    auto handlers = std::move(completeHandlers_);
+    completeHandlers_.clear();
     g.unlock();
 
-    // Note: callback always completes before the object is signaled.
-    if (listener)
-        listener->on_success(*this);
-    cond_.notify_all();
-
-    cli_->remove_token(this);
+    signal_complete(listener, true, std::move(handlers));
 }
 
 //
@@ -194,6 +282,9 @@ void token::on_success5(MQTTAsync_successData5* rsp)
 void token::on_failure(MQTTAsync_failureData* rsp)
 {
     unique_lock g(lock_);
+    if (release_expired(g))
+        return;
+
     iaction_listener* listener = listener_;
     if (rsp) {
         msgId_ = rsp->token;
@@ -207,14 +298,11 @@ void token::on_failure(MQTTAsync_failureData* rsp)
         rc_ = -1;
     }
     complete_ = true;
+    auto handlers = std::move(completeHandlers_);
+    completeHandlers_.clear();
     g.unlock();
 
-    // Note: callback always completes before the object is signaled.
-    if (listener)
-        listener->on_failure(*this);
-    cond_.notify_all();
-
-    cli_->remove_token(this);
+    signal_complete(listener, false, std::move(handlers));
 }
 
 //
@@ -223,6 +311,9 @@ void token::on_failure(MQTTAsync_failureData* rsp)
 void token::on_failure5(MQTTAsync_failureData5* rsp)
 {
     unique_lock g(lock_);
+    if (release_expired(g))
+        return;
+
     iaction_listener* listener = listener_;
     if (rsp) {
         msgId_ = rsp->token;
@@ -235,19 +326,25 @@ void token::on_failure5(MQTTAsync_failureData5* rsp)
         rc_ = -1;
     }
     complete_ = true;
+    auto handlers = std::move(completeHandlers_);
+    completeHandlers_.clear();
     g.unlock();
 
-    // Note: callback always completes before the object is signaled.
-    if (listener)
-        listener->on_failure(*this);
-    cond_.notify_all();
-
-    cli_->remove_token(this);
+    signal_complete(listener, false, std::move(handlers));
 }
 
 // --------------------------------------------------------------------------
 // API
 
+bool token::notify_on_complete(std::function<void()> fn)
+{
+    guard g(lock_);
+    if (complete_)
+        return false;
+    completeHandlers_.push_back(std::move(fn));
+    return true;
+}
+
 void token::reset()
 {
     guard g(lock_);
@@ -255,6 +352,7 @@ void token::reset()
     rc_ = MQTTASYNC_SUCCESS;
     reasonCode_ = ReasonCode::SUCCESS;
     errMsg_.clear();
+    timedOut_ = false;
 }
 
 void token::set_action_callback(iaction_listener& listener)
@@ -272,10 +370,21 @@ void token::set_action_callback(iaction_listener& listener)
     }
 }
 
+void token::spin_complete() const
+{
+    if (complete_.load(std::memory_order_acquire) || !cli_)
+        return;
+
+    auto sw = cli_->get_spin_wait();
+    if (sw.enabled())
+        sw([this] { return complete_.load(std::memory_order_acquire); });
+}
+
 void token::wait()
 {
+    spin_complete();
     unique_lock g(lock_);
-    cond_.wait(g, [this] { return complete_; });
+    wait_complete(g);
     check_ret();
 }
 
@@ -285,7 +394,7 @@ connect_response token::get_connect_response() const
         throw bad_cast();
 
     unique_lock g(lock_);
-    cond_.wait(g, [this] { return complete_; });
+    wait_complete(g);
     check_ret();
 
     if (!connRsp_)
@@ -300,7 +409,7 @@ subscribe_response token::get_subscribe_response() const
         throw bad_cast();
 
     unique_lock g(lock_);
-    cond_.wait(g, [this] { return complete_; });
+    wait_complete(g);
     check_ret();
 
     if (!subRsp_)
@@ -315,7 +424,7 @@ unsubscribe_response token::get_unsubscribe_response() const
         throw bad_cast();
 
     unique_lock g(lock_);
-    cond_.wait(g, [this] { return complete_; });
+    wait_complete(g);
     check_ret();
 
     if (!unsubRsp_)
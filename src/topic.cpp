@@ -19,11 +19,170 @@
 #include "mqtt/topic.h"
 
 #include <algorithm>
+#include <cstdint>
+#include <cstring>
 
 #include "mqtt/async_client.h"
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #include <emmintrin.h>
+    #define PAHO_MQTTPP_TOPIC_SSE2
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+    #include <arm_neon.h>
+    #define PAHO_MQTTPP_TOPIC_NEON
+#endif
+
 namespace mqtt {
 
+// Nearly every topic is plain ASCII, so the validation skips over it a
+// block at a time, looking for anything that needs a closer look: a null,
+// a wildcard, or the lead byte of a multi-byte UTF-8 character. Only those
+// are checked one at a time.
+
+namespace {
+
+constexpr size_t BLOCK_SIZE = 16;
+
+#if defined(PAHO_MQTTPP_TOPIC_SSE2)
+
+// Determines if a block has only plain ASCII characters
+inline bool is_plain_block(const char* p) noexcept
+{
+    const auto v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    const auto special = _mm_or_si128(
+        _mm_cmpeq_epi8(v, _mm_setzero_si128()),
+        _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('+')), _mm_cmpeq_epi8(v, _mm_set1_epi8('#')))
+    );
+    // The high bit is set for a special or non-ASCII char
+    return _mm_movemask_epi8(_mm_or_si128(special, v)) == 0;
+}
+
+#elif defined(PAHO_MQTTPP_TOPIC_NEON)
+
+inline bool is_plain_block(const char* p) noexcept
+{
+    const auto v = vld1q_u8(reinterpret_cast<const uint8_t*>(p));
+    const auto special = vorrq_u8(
+        vceqzq_u8(v), vorrq_u8(vceqq_u8(v, vdupq_n_u8('+')), vceqq_u8(v, vdupq_n_u8('#')))
+    );
+    return vmaxvq_u8(vorrq_u8(special, vandq_u8(v, vdupq_n_u8(0x80)))) == 0;
+}
+
+#else
+
+// Without SIMD, the block is checked as two words, a byte in each lane
+
+constexpr uint64_t LO_BITS = 0x0101010101010101ULL;
+constexpr uint64_t HI_BITS = 0x8080808080808080ULL;
+
+inline bool has_zero_byte(uint64_t w) noexcept { return ((w - LO_BITS) & ~w & HI_BITS) != 0; }
+
+inline bool is_plain_word(uint64_t w) noexcept
+{
+    return (w & HI_BITS) == 0 && !has_zero_byte(w) && !has_zero_byte(w ^ (LO_BITS * '+')) &&
+           !has_zero_byte(w ^ (LO_BITS * '#'));
+}
+
+inline bool is_plain_block(const char* p) noexcept
+{
+    uint64_t w[2];
+    std::memcpy(w, p, sizeof(w));
+    return is_plain_word(w[0]) && is_plain_word(w[1]);
+}
+
+#endif
+
+// Gets the position of the first char, at or after pos, that isn't plain
+// ASCII, or the length of the string if there isn't one.
+size_t find_special(const char* s, size_t pos, size_t n) noexcept
+{
+    while (pos + BLOCK_SIZE <= n && is_plain_block(s + pos)) pos += BLOCK_SIZE;
+
+    for (; pos < n; ++pos) {
+        auto c = uint8_t(s[pos]);
+        if (c == 0 || c >= 0x80 || c == '+' || c == '#')
+            break;
+    }
+    return pos;
+}
+
+// Gets the length of the well-formed UTF-8 character that starts at the
+// position, or zero if it isn't one. Overlong forms, surrogates, and
+// values past U+10FFFF are not well-formed.
+size_t utf8_length(const char* s, size_t pos, size_t n) noexcept
+{
+    auto c = uint8_t(s[pos]);
+    size_t len = 0;
+    uint8_t lo = 0x80, hi = 0xBF;
+
+    if (c >= 0xC2 && c <= 0xDF)
+        len = 2;
+    else if (c >= 0xE0 && c <= 0xEF) {
+        len = 3;
+        if (c == 0xE0)
+            lo = 0xA0;
+        else if (c == 0xED)
+            hi = 0x9F;
+    }
+    else if (c >= 0xF0 && c <= 0xF4) {
+        len = 4;
+        if (c == 0xF0)
+            lo = 0x90;
+        else if (c == 0xF4)
+            hi = 0x8F;
+    }
+    else
+        return 0;
+
+    if (n - pos < len)
+        return 0;
+
+    auto c1 = uint8_t(s[pos + 1]);
+    if (c1 < lo || c1 > hi)
+        return 0;
+
+    for (size_t i = 2; i < len; ++i) {
+        auto ci = uint8_t(s[pos + i]);
+        if (ci < 0x80 || ci > 0xBF)
+            return 0;
+    }
+    return len;
+}
+
+bool is_valid_topic(std::string_view s, bool isFilter) noexcept
+{
+    const auto n = s.size();
+    if (n == 0 || n > topic::MAX_LENGTH)
+        return false;
+
+    const auto p = s.data();
+    size_t i = 0;
+
+    while ((i = find_special(p, i, n)) < n) {
+        auto c = p[i];
+
+        if (c == '+' || c == '#') {
+            // A wildcard must be the whole field, and '#' the last one
+            if (!isFilter || (i > 0 && p[i - 1] != '/'))
+                return false;
+            if (c == '#' ? (i + 1 != n) : (i + 1 < n && p[i + 1] != '/'))
+                return false;
+            ++i;
+        }
+        else if (c == '\0')
+            return false;
+        else {
+            auto len = utf8_length(p, i, n);
+            if (len == 0)
+                return false;
+            i += len;
+        }
+    }
+    return true;
+}
+
+}  // namespace
+
 /////////////////////////////////////////////////////////////////////////////
 //  							topic
 /////////////////////////////////////////////////////////////////////////////
@@ -37,6 +196,7 @@ std::vector<string> topic::split(const string& s)
         return v;
 
     const auto delim = '/';
+    v.reserve(size_t(std::count(s.cbegin(), s.cend(), delim)) + 1);
     string::size_type startPos = 0, pos;
 
     do {
@@ -49,29 +209,43 @@ std::vector<string> topic::split(const string& s)
     return v;
 }
 
+bool topic::is_valid_name(std::string_view name) noexcept
+{
+    return is_valid_topic(name, false);
+}
+
+// The messages are made from the template, so they all share the one
+// copy of the name, rather than each making its own.
+
 delivery_token_ptr topic::publish(const void* payload, size_t n)
 {
-    return cli_.publish(name_, payload, n, qos_, retained_);
+    return cli_.publish(tmpl_.make(payload, n));
 }
 
 delivery_token_ptr topic::publish(const void* payload, size_t n, int qos, bool retained)
 {
-    return cli_.publish(name_, payload, n, qos, retained);
+    auto msg = tmpl_.make(payload, n);
+    msg->set_qos(qos);
+    msg->set_retained(retained);
+    return cli_.publish(std::move(msg));
 }
 
 delivery_token_ptr topic::publish(binary_ref payload)
 {
-    return cli_.publish(name_, std::move(payload), qos_, retained_);
+    return cli_.publish(tmpl_.make(std::move(payload)));
 }
 
 delivery_token_ptr topic::publish(binary_ref payload, int qos, bool retained)
 {
-    return cli_.publish(name_, std::move(payload), qos, retained);
+    auto msg = tmpl_.make(std::move(payload));
+    msg->set_qos(qos);
+    msg->set_retained(retained);
+    return cli_.publish(std::move(msg));
 }
 
 token_ptr topic::subscribe(const subscribe_options& opts)
 {
-    return cli_.subscribe(name_, qos_, opts);
+    return cli_.subscribe(get_name(), get_qos(), opts);
 }
 
 /////////////////////////////////////////////////////////////////////////////
@@ -80,6 +254,11 @@ token_ptr topic::subscribe(const subscribe_options& opts)
 
 topic_filter::topic_filter(const string& filter) : fields_(topic::split(filter)) {}
 
+bool topic_filter::is_valid(std::string_view filter) noexcept
+{
+    return is_valid_topic(filter, true);
+}
+
 bool topic_filter::has_wildcards(const string& filter)
 {
     auto n = filter.size();
@@ -102,45 +281,67 @@ bool topic_filter::has_wildcards() const
 }
 
 // See if the topic matches this filter.
-// OPTIMIZE: If the filter string doesn't contain any wildcards, then a
-// match is a simple string comparison. We wouldn't need to split the filter
-// or topic into fields.
-bool topic_filter::matches(const string& topic) const
+// This walks the fields of the topic in place, without splitting it.
+bool topic_filter::matches(std::string_view topic) const
 {
-    auto n = fields_.size();
+    const auto n = fields_.size();
 
-    auto topic_fields = topic::split(topic);
-    auto nt = topic_fields.size();
+    // Topics starting with '$' don't match wildcards in the first field
+    // MQTT v5 Spec, Section 4.7.2:
+    // https://docs.oasis-open.org/mqtt/mqtt/v5.0/os/mqtt-v5.0-os.html#_Toc3901246
 
-    // Filter can't match a topic that is shorter
-    if (n > nt) {
+    if (n > 0 && is_wildcard(fields_[0]) && !topic.empty() && topic[0] == '$') {
         return false;
     }
 
-    // Might match a longer topic, but only with '#' wildcard
-    if (n < nt && fields_[n - 1] != "#") {
-        return false;
+    size_t i = 0;
+    for (auto field : topic::split_view(topic)) {
+        // The topic is longer than the filter
+        if (i == n) {
+            return false;
+        }
+        const auto& filt = fields_[i++];
+        if (filt == "#") {
+            return true;
+        }
+        if (filt != "+" && filt != field) {
+            return false;
+        }
     }
 
-    // Topics starting with '$' don't match wildcards in the first field
-    // MQTT v5 Spec, Section 4.7.2:
-    // https://docs.oasis-open.org/mqtt/mqtt/v5.0/os/mqtt-v5.0-os.html#_Toc3901246
+    // Filter can't match a topic that is shorter
+    return i == n;
+}
+
+// Same as matches(), but saving the fields that match the wildcards.
+bool topic_filter::match(std::string_view topic, std::vector<std::string_view>& captures) const
+{
+    const auto n = fields_.size();
+    captures.clear();
 
-    if (n > 0 && is_wildcard(fields_[0]) && nt > 0 && topic_fields[0].size() > 0 &&
-        topic_fields[0][0] == '$') {
+    if (n > 0 && is_wildcard(fields_[0]) && !topic.empty() && topic[0] == '$') {
         return false;
     }
 
-    for (size_t i = 0; i < n; ++i) {
-        if (fields_[i] == "#") {
-            break;
+    size_t i = 0;
+    for (auto field : topic::split_view(topic)) {
+        if (i == n) {
+            return false;
+        }
+        const auto& filt = fields_[i++];
+        if (filt == "#") {
+            captures.push_back(topic.substr(size_t(field.data() - topic.data())));
+            return true;
         }
-        if (fields_[i] != "+" && fields_[i] != topic_fields[i]) {
+        if (filt == "+") {
+            captures.push_back(field);
+        }
+        else if (filt != field) {
             return false;
         }
     }
 
-    return true;
+    return i == n;
 }
 
 /////////////////////////////////////////////////////////////////////////////
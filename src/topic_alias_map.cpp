@@ -0,0 +1,82 @@
+// topic_alias_map.cpp
+
+/*******************************************************************************
+ * Copyright (c) 2025 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+#include "mqtt/topic_alias_map.h"
+
+#include <algorithm>
+
+namespace mqtt {
+
+/////////////////////////////////////////////////////////////////////////////
+
+void topic_alias_map::reset(size_t serverMax)
+{
+    lru_.clear();
+    aliases_.clear();
+    free_.clear();
+    limit_ = std::min({maxAliases_, serverMax, size_t(UINT16_MAX)});
+}
+
+uint16_t topic_alias_map::get(const string& topic, bool& known)
+{
+    known = false;
+    if (limit_ == 0)
+        return 0;
+
+    auto p = aliases_.find(topic);
+    if (p != aliases_.end()) {
+        known = true;
+        lru_.splice(lru_.begin(), lru_, p->second.pos);
+        return p->second.alias;
+    }
+
+    uint16_t alias;
+    if (!free_.empty()) {
+        alias = free_.back();
+        free_.pop_back();
+    }
+    else if (aliases_.size() < limit_) {
+        alias = uint16_t(aliases_.size() + 1);
+    }
+    else {
+        // Take over the alias of the least recently used topic
+        auto oldest = aliases_.find(*lru_.back());
+        alias = oldest->second.alias;
+        lru_.pop_back();
+        aliases_.erase(oldest);
+    }
+
+    p = aliases_.emplace(topic, entry{alias, {}}).first;
+    lru_.push_front(&p->first);
+    p->second.pos = lru_.begin();
+    return alias;
+}
+
+void topic_alias_map::remove(const string& topic)
+{
+    auto p = aliases_.find(topic);
+    if (p == aliases_.end())
+        return;
+
+    free_.push_back(p->second.alias);
+    lru_.erase(p->second.pos);
+    aliases_.erase(p);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+}  // namespace mqtt
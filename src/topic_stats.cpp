@@ -0,0 +1,143 @@
+// topic_stats.cpp
+
+/*******************************************************************************
+ * Copyright (c) 2025 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+#include "mqtt/topic_stats.h"
+
+#include <algorithm>
+
+namespace mqtt {
+
+/////////////////////////////////////////////////////////////////////////////
+
+topic_stats::topic_stats(std::initializer_list<string> filters) : topic_stats()
+{
+    groups_.update([&filters](auto& tm) {
+        for (const auto& filter : filters) {
+            if (tm.find(filter) != tm.end())
+                continue;
+            tm.insert({filter, std::make_shared<group>()});
+        }
+    });
+}
+
+// Each thread gets the next stripe the first time it counts anything, so
+// the threads are spread evenly over them.
+
+size_t topic_stats::stripe() noexcept
+{
+    static std::atomic<size_t> next{0};
+    thread_local size_t idx = next.fetch_add(1, std::memory_order_relaxed) % N_STRIPES;
+    return idx;
+}
+
+topic_traffic topic_stats::merge(const string& filter, const group& grp)
+{
+    topic_traffic t;
+    t.filter = filter;
+
+    for (const auto& c : grp.stripes) {
+        t.msgsReceived += c.msgsReceived.load(std::memory_order_relaxed);
+        t.bytesReceived += c.bytesReceived.load(std::memory_order_relaxed);
+        t.msgsPublished += c.msgsPublished.load(std::memory_order_relaxed);
+        t.bytesPublished += c.bytesPublished.load(std::memory_order_relaxed);
+    }
+    return t;
+}
+
+bool topic_stats::add_filter(const string& filter)
+{
+    bool added = false;
+    groups_.update([&](auto& tm) {
+        if (tm.find(filter) != tm.end())
+            return;
+        tm.insert({filter, std::make_shared<group>()});
+        added = true;
+    });
+    return added;
+}
+
+bool topic_stats::remove_filter(const string& filter) { return bool(groups_.remove(filter)); }
+
+void topic_stats::count_received(std::string_view topic, size_t nbytes)
+{
+    const auto idx = stripe();
+    groups_.for_each_match(topic, [idx, nbytes](const auto& val) {
+        auto& c = val.second->stripes[idx];
+        c.msgsReceived.fetch_add(1, std::memory_order_relaxed);
+        c.bytesReceived.fetch_add(nbytes, std::memory_order_relaxed);
+    });
+}
+
+void topic_stats::count_published(std::string_view topic, size_t nbytes)
+{
+    const auto idx = stripe();
+    groups_.for_each_match(topic, [idx, nbytes](const auto& val) {
+        auto& c = val.second->stripes[idx];
+        c.msgsPublished.fetch_add(1, std::memory_order_relaxed);
+        c.bytesPublished.fetch_add(nbytes, std::memory_order_relaxed);
+    });
+}
+
+std::vector<topic_traffic> topic_stats::get_traffic() const
+{
+    auto snap = groups_.snapshot();
+
+    std::vector<topic_traffic> traffic;
+    for (auto it = snap->cbegin(); it != snap->cend(); ++it)
+        traffic.push_back(merge(it->first, *it->second));
+
+    std::sort(traffic.begin(), traffic.end(), [](const auto& a, const auto& b) {
+        return a.filter < b.filter;
+    });
+    return traffic;
+}
+
+std::optional<topic_traffic> topic_stats::get_traffic(const string& filter) const
+{
+    auto snap = groups_.snapshot();
+    if (auto it = snap->find(filter); it != snap->cend())
+        return merge(filter, *it->second);
+    return std::nullopt;
+}
+
+std::chrono::steady_clock::duration topic_stats::elapsed() const
+{
+    std::lock_guard<std::mutex> g{lock_};
+    return std::chrono::steady_clock::now() - startTime_;
+}
+
+// Messages counted while this runs can land on either side of the reset.
+
+void topic_stats::reset()
+{
+    auto snap = groups_.snapshot();
+    for (auto it = snap->cbegin(); it != snap->cend(); ++it) {
+        for (auto& c : it->second->stripes) {
+            c.msgsReceived.store(0, std::memory_order_relaxed);
+            c.bytesReceived.store(0, std::memory_order_relaxed);
+            c.msgsPublished.store(0, std::memory_order_relaxed);
+            c.bytesPublished.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    std::lock_guard<std::mutex> g{lock_};
+    startTime_ = std::chrono::steady_clock::now();
+}
+
+/////////////////////////////////////////////////////////////////////////////
+}  // namespace mqtt
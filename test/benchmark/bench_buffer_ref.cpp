@@ -0,0 +1,39 @@
+// bench_buffer_ref.cpp
+//
+// Micro-benchmarks for the buffer_ref class.
+//
+
+/*******************************************************************************
+ * Copyright (c) 2025 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation
+ *******************************************************************************/
+
+#include "catch2_version.h"
+#include "mqtt/buffer_ref.h"
+
+using namespace mqtt;
+
+TEST_CASE("buffer_ref copy", "[buffer_ref]")
+{
+    const binary_ref smallBuf{"hello"};
+    const binary_ref largeBuf{string(1024, 'x')};
+
+    BENCHMARK("create small") { return binary_ref{"hello"}; };
+    BENCHMARK("create large") { return binary_ref{string(1024, 'x')}; };
+
+    BENCHMARK("copy small") { return binary_ref{smallBuf}; };
+    BENCHMARK("copy large") { return binary_ref{largeBuf}; };
+
+    BENCHMARK("str large") { return largeBuf.str().size(); };
+}
@@ -0,0 +1,65 @@
+// bench_message.cpp
+//
+// Micro-benchmarks for creating messages.
+//
+
+/*******************************************************************************
+ * Copyright (c) 2025 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation
+ *******************************************************************************/
+
+#include <cstring>
+
+#include "catch2_version.h"
+#include "mqtt/message.h"
+#include "mqtt/message_pool.h"
+
+using namespace mqtt;
+
+static const string TOPIC{"sensors/building1/floor2/temp"};
+static const string PAYLOAD(256, 'x');
+
+TEST_CASE("message create", "[message]")
+{
+    const string_ref topicRef{TOPIC};
+    const binary_ref payloadRef{PAYLOAD};
+
+    BENCHMARK("create from strings") { return message::create(TOPIC, PAYLOAD); };
+
+    BENCHMARK("create from buffer") {
+        return message::create(TOPIC, PAYLOAD.data(), PAYLOAD.size());
+    };
+
+    BENCHMARK("create from refs") { return message::create(topicRef, payloadRef); };
+
+    BENCHMARK("create from segments") {
+        auto msg = message::create(topicRef, binary_ref{});
+        msg->set_payload({std::string_view{PAYLOAD}, std::string_view{PAYLOAD}});
+        return msg;
+    };
+
+    // As an incoming message is created from the C struct
+    MQTTAsync_message cmsg = MQTTAsync_message_initializer;
+    cmsg.payload = const_cast<char*>(PAYLOAD.data());
+    cmsg.payloadlen = int(PAYLOAD.size());
+    cmsg.qos = 1;
+
+    BENCHMARK("create from C struct") { return message::create(TOPIC, cmsg); };
+
+    auto pool = message_pool::create();
+
+    BENCHMARK("create from C struct, pooled") {
+        return pool->create_message(pool->create_buffer(TOPIC.data(), TOPIC.size()), cmsg);
+    };
+}
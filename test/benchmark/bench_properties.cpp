@@ -0,0 +1,46 @@
+// bench_properties.cpp
+//
+// Micro-benchmarks for the properties class.
+//
+
+/*******************************************************************************
+ * Copyright (c) 2025 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation
+ *******************************************************************************/
+
+#include "catch2_version.h"
+#include "mqtt/properties.h"
+
+using namespace mqtt;
+
+TEST_CASE("properties copy and lookup", "[properties]")
+{
+    const properties props{
+        {property::PAYLOAD_FORMAT_INDICATOR, 1},
+        {property::MESSAGE_EXPIRY_INTERVAL, 70},
+        {property::CONTENT_TYPE, "application/json"},
+        {property::RESPONSE_TOPIC, "replies/client1"},
+        {property::USER_PROPERTY, "region", "us-east"},
+        {property::USER_PROPERTY, "device", "sensor-42"},
+        {property::USER_PROPERTY, "trace-id", "7a3f52b1"},
+    };
+
+    BENCHMARK("copy") { return properties{props}; };
+
+    BENCHMARK("get by code") { return get<string>(props, property::RESPONSE_TOPIC); };
+
+    BENCHMARK("contains missing code") { return props.contains(property::TOPIC_ALIAS); };
+
+    BENCHMARK("get user property") { return props.get_user_property("trace-id"); };
+}
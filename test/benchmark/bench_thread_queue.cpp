@@ -0,0 +1,72 @@
+// bench_thread_queue.cpp
+//
+// Micro-benchmarks for the thread_queue class.
+//
+
+/*******************************************************************************
+ * Copyright (c) 2025 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation
+ *******************************************************************************/
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "catch2_version.h"
+#include "mqtt/thread_queue.h"
+
+using namespace mqtt;
+
+// The number of items moved through the queue in each contention run
+static constexpr int N_ITEMS = 10000;
+
+// Runs producers and consumers that move N_ITEMS through the queue.
+static int run_contention(thread_queue<int>& que, int nProducers, int nConsumers)
+{
+    std::vector<std::thread> thrs;
+    std::atomic<int> sum{0};
+
+    for (int i = 0; i < nConsumers; ++i) {
+        thrs.emplace_back([&que, &sum, n = N_ITEMS / nConsumers] {
+            for (int j = 0; j < n; ++j) sum += que.get();
+        });
+    }
+    for (int i = 0; i < nProducers; ++i) {
+        thrs.emplace_back([&que, n = N_ITEMS / nProducers] {
+            for (int j = 0; j < n; ++j) que.put(1);
+        });
+    }
+    for (auto& thr : thrs) thr.join();
+    return sum;
+}
+
+TEST_CASE("thread_queue put get", "[thread_queue]")
+{
+    thread_queue<int> que;
+
+    BENCHMARK("put then get") {
+        que.put(42);
+        return que.get();
+    };
+
+    BENCHMARK("1 producer, 1 consumer") { return run_contention(que, 1, 1); };
+    BENCHMARK("4 producers, 1 consumer") { return run_contention(que, 4, 1); };
+    BENCHMARK("4 producers, 4 consumers") { return run_contention(que, 4, 4); };
+
+    thread_queue<int> boundedQue{100};
+
+    BENCHMARK("4 producers, 1 consumer, bounded") {
+        return run_contention(boundedQue, 4, 1);
+    };
+}
@@ -0,0 +1,69 @@
+// bench_topic_matcher.cpp
+//
+// Micro-benchmarks for the topic_matcher class.
+//
+
+/*******************************************************************************
+ * Copyright (c) 2025 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation
+ *******************************************************************************/
+
+#include "catch2_version.h"
+#include "mqtt/topic_matcher.h"
+
+using namespace mqtt;
+
+// Makes a collection of filters, like a fleet of devices with a few
+// wildcard subscriptions mixed in.
+static void fill(topic_matcher<int>& tm, int n)
+{
+    for (int i = 0; i < n; ++i) {
+        auto dev = std::to_string(i);
+        if (i % 10 == 0)
+            tm.insert({"fleet/" + dev + "/#", i});
+        else if (i % 10 == 1)
+            tm.insert({"fleet/+/" + dev, i});
+        else
+            tm.insert({"fleet/" + dev + "/temp", i});
+    }
+}
+
+static size_t count_matches(const topic_matcher<int>& tm, std::string_view topic)
+{
+    size_t n = 0;
+    tm.for_each_match(topic, [&n](const auto&) { ++n; });
+    return n;
+}
+
+TEST_CASE("topic_matcher insert", "[topic_matcher]")
+{
+    BENCHMARK_ADVANCED("insert 1k")(Catch::Benchmark::Chronometer meter) {
+        std::vector<topic_matcher<int>> tms(meter.runs());
+        meter.measure([&tms](int i) { fill(tms[i], 1000); });
+    };
+}
+
+TEST_CASE("topic_matcher match", "[topic_matcher]")
+{
+    for (int n : {1000, 100000}) {
+        topic_matcher<int> tm;
+        fill(tm, n);
+        const auto sz = std::to_string(n);
+
+        BENCHMARK("match exact, " + sz) { return count_matches(tm, "fleet/500/temp"); };
+        BENCHMARK("match wildcards, " + sz) { return count_matches(tm, "fleet/990/temp"); };
+        BENCHMARK("no match, " + sz) { return count_matches(tm, "other/500/temp"); };
+        BENCHMARK("has_match, " + sz) { return tm.has_match("fleet/500/temp"); };
+    }
+}
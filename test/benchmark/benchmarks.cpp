@@ -0,0 +1,25 @@
+// benchmarks.cpp
+//
+// Main for the Catch2 micro-benchmarks for the Paho MQTT C++ library.
+//
+
+/*******************************************************************************
+ * Copyright (c) 2025 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation
+ *******************************************************************************/
+
+#define CATCH_CONFIG_RUNNER
+#include "catch2_version.h"
+
+int main(int argc, char* argv[]) { return Catch::Session().run(argc, argv); }
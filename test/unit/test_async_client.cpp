@@ -29,6 +29,12 @@
 #include "mqtt/async_client.h"
 #include "mqtt/iasync_client.h"
 
+#include <thread>
+
+#if !defined(_WIN32)
+    #include <poll.h>
+#endif
+
 using namespace mqtt;
 
 /////////////////////////////////////////////////////////////////////////////
@@ -1009,6 +1015,163 @@ TEST_CASE("async_client consumer timeout", "[client]")
     cli.try_consume_message_until(std::chrono::steady_clock::now());
 }
 
+TEST_CASE("async_client consumer user queue", "[client]")
+{
+    async_client cli{GOOD_SERVER_URI, CLIENT_ID};
+    cli.start_consuming(std::make_unique<lock_free_consumer_queue>(16));
+    REQUIRE(!cli.consumer_closed());
+    REQUIRE(0 == cli.consumer_queue_size());
+
+    event evt;
+    REQUIRE(!cli.try_consume_event(&evt));
+    REQUIRE(!cli.try_consume_event_for(&evt, std::chrono::milliseconds(5)));
+
+    cli.stop_consuming();
+    REQUIRE(cli.consumer_closed());
+    REQUIRE(cli.consumer_done());
+}
+
+TEST_CASE("async_client consume messages", "[client]")
+{
+    async_client cli{GOOD_SERVER_URI, CLIENT_ID};
+
+    std::vector<const_message_ptr> msgs;
+    REQUIRE_THROWS_AS(cli.try_consume_messages(msgs, 10), mqtt::exception);
+
+    cli.start_consuming();
+    REQUIRE(0 == cli.try_consume_messages(msgs, 10));
+    REQUIRE(0 == cli.consume_messages(msgs, 10, std::chrono::milliseconds(5)));
+    REQUIRE(msgs.empty());
+
+    cli.stop_consuming();
+}
+
+TEST_CASE("async_client drain consumer queue", "[client]")
+{
+    async_client cli{
+        create_options_builder().server_uri(GOOD_SERVER_URI).client_id(CLIENT_ID).loopback().finalize()
+    };
+    REQUIRE_THROWS_AS(cli.drain_consumer_queue(), mqtt::exception);
+
+    cli.start_consuming();
+    cli.connect()->wait();
+    for (int i = 0; i < 100; ++i) cli.publish(make_message(TOPIC, std::to_string(i)));
+
+    cli.stop_consuming();
+    auto evts = cli.drain_consumer_queue();
+    REQUIRE(0 == cli.consumer_queue_size());
+
+    // The connected event, then the messages in order
+    REQUIRE(101 == evts.size());
+    REQUIRE(evts.front().is_connected());
+    for (int i = 0; i < 100; ++i) {
+        auto pmsg = evts[i + 1].get_message_if();
+        REQUIRE(pmsg);
+        REQUIRE(std::to_string(i) == (*pmsg)->to_string());
+    }
+}
+
+TEST_CASE("async_client topic stats", "[client]")
+{
+    auto tstats = topic_stats::create({"data/#", "cmd/#"});
+    async_client cli{create_options_builder()
+                         .server_uri(GOOD_SERVER_URI)
+                         .client_id(CLIENT_ID)
+                         .loopback()
+                         .topic_stats(tstats)
+                         .finalize()};
+    cli.start_consuming();
+    cli.connect()->wait();
+
+    cli.publish(make_message("data/a", "1234"))->wait();
+    cli.publish_nowait(make_message("data/b", "5678"));
+    cli.publish(make_message("other", "x"))->wait();
+
+    // Loopback receives each message it sends
+    auto traffic = cli.get_stats().topicTraffic;
+    REQUIRE(2 == traffic.size());
+    REQUIRE("cmd/#" == traffic[0].filter);
+    REQUIRE(0 == traffic[0].msgsPublished);
+    REQUIRE("data/#" == traffic[1].filter);
+    REQUIRE(2 == traffic[1].msgsPublished);
+    REQUIRE(20 == traffic[1].bytesPublished);
+    REQUIRE(2 == traffic[1].msgsReceived);
+    REQUIRE(20 == traffic[1].bytesReceived);
+}
+
+TEST_CASE("async_client deferred messages fail", "[client]")
+{
+    auto opts = create_options_builder()
+                    .server_uri(GOOD_SERVER_URI)
+                    .client_id(CLIENT_ID)
+                    .loopback()
+                    .flow_control()
+                    .finalize();
+    auto msg = make_message(TOPIC, PAYLOAD, 1, false);
+
+    SECTION("on disconnect")
+    {
+        async_client cli{opts};
+        cli.connect()->wait();
+
+        // Nothing more can be in flight, so the messages are held back
+        cli.set_receive_maximum(0);
+        auto tok = cli.publish(msg);
+        auto tok2 = cli.publish(msg);
+        REQUIRE(2 == cli.get_stats().msgsDeferred);
+        REQUIRE(!tok->is_complete());
+
+        cli.disconnect()->wait();
+        REQUIRE(0 == cli.get_stats().msgsDeferred);
+        REQUIRE(tok->is_complete());
+        REQUIRE(MQTTASYNC_DISCONNECTED == tok->get_return_code());
+        REQUIRE(MQTTASYNC_DISCONNECTED == tok2->get_return_code());
+    }
+
+    SECTION("on destruction")
+    {
+        delivery_token_ptr tok;
+        {
+            async_client cli{opts};
+            cli.connect()->wait();
+            cli.set_receive_maximum(0);
+            tok = cli.publish(msg);
+            REQUIRE(!tok->is_complete());
+        }
+        REQUIRE(tok->is_complete());
+        REQUIRE(MQTTASYNC_OPERATION_INCOMPLETE == tok->get_return_code());
+    }
+}
+
+TEST_CASE("async_client message sampler", "[client]")
+{
+    auto sampler = message_sampler::create();
+    sampler->add_rule("data/#", 2);
+    sampler->drop("debug/#");
+
+    async_client cli{create_options_builder()
+                         .server_uri(GOOD_SERVER_URI)
+                         .client_id(CLIENT_ID)
+                         .loopback()
+                         .message_sampler(sampler)
+                         .finalize()};
+
+    std::vector<string> payloads;
+    cli.set_message_callback([&](const_message_ptr msg) { payloads.push_back(msg->get_payload()); });
+    cli.connect()->wait();
+
+    for (int i = 0; i < 4; ++i) cli.publish(make_message("data/a", std::to_string(i)))->wait();
+    cli.publish(make_message("debug/a", "d"))->wait();
+    cli.publish(make_message("other", "o"))->wait();
+
+    // The dropped messages never reach the callback, but are still received
+    REQUIRE((std::vector<string>{"0", "2", "o"}) == payloads);
+
+    auto st = cli.get_stats();
+    REQUIRE(3 == st.msgsSampledOut);
+    REQUIRE(6 == st.msgsReceived);
+}
+
 TEST_CASE("async_client consumer queue size", "[client]")
 {
     async_client cli{GOOD_SERVER_URI, CLIENT_ID};
@@ -1028,3 +1191,1113 @@ TEST_CASE("async_client consumer queue size", "[client]")
     cli.stop_consuming();
     cli.disconnect()->wait();
 }
+
+TEST_CASE("async_client dispatching", "[client]")
+{
+    async_client cli{GOOD_SERVER_URI, CLIENT_ID};
+
+    cli.start_dispatching([](const_message_ptr) {}, 2);
+    cli.stop_dispatching();
+
+    // Can be restarted
+    cli.start_dispatching([](const_message_ptr) {});
+    cli.stop_dispatching();
+}
+
+TEST_CASE("async_client dispatching unordered", "[client]")
+{
+    async_client cli{
+        create_options_builder().server_uri(GOOD_SERVER_URI).client_id(CLIENT_ID).loopback().finalize()
+    };
+
+    std::atomic<int> n{0};
+    cli.start_dispatching([&n](const_message_ptr) { ++n; }, 4, dispatch_mode::UNORDERED);
+    cli.connect()->wait();
+
+    for (int i = 0; i < 100; ++i) cli.publish(make_message(TOPIC, PAYLOAD, 0, false));
+
+    // Stopping the workers handles everything that was queued
+    cli.stop_dispatching();
+    REQUIRE(100 == n);
+}
+
+TEST_CASE("async_client publish batch", "[client]")
+{
+    async_client cli{GOOD_SERVER_URI, CLIENT_ID};
+
+    // An empty batch completes immediately
+    auto btok = cli.publish_batch({});
+    REQUIRE(btok);
+    REQUIRE(btok->is_complete());
+    REQUIRE(0 == btok->size());
+    REQUIRE(MQTTASYNC_SUCCESS == btok->get_return_code());
+
+    // Not connected, so all the messages fail
+    std::vector<const_message_ptr> msgs;
+    for (int i = 0; i < 3; ++i) msgs.push_back(make_message(TOPIC, PAYLOAD, GOOD_QOS, RETAINED));
+
+    btok = cli.publish_batch(msgs);
+    REQUIRE(btok->is_complete());
+    REQUIRE(3 == btok->size());
+    REQUIRE(3 == btok->failed_count());
+    REQUIRE(3 == btok->get_failed_tokens().size());
+    REQUIRE(MQTTASYNC_DISCONNECTED == btok->get_return_code());
+    REQUIRE_THROWS_AS(btok->wait(), mqtt::exception);
+
+    const auto& toks = btok->get_delivery_tokens();
+    for (size_t i = 0; i < toks.size(); ++i) {
+        REQUIRE(toks[i]->get_message() == msgs[i]);
+        REQUIRE(MQTTASYNC_DISCONNECTED == toks[i]->get_return_code());
+    }
+    REQUIRE(cli.get_pending_delivery_tokens().empty());
+}
+
+TEST_CASE("async_client publish fanout", "[client]")
+{
+    async_client cli{
+        create_options_builder().server_uri(GOOD_SERVER_URI).client_id(CLIENT_ID).loopback().finalize()
+    };
+
+    std::mutex lock;
+    std::vector<string> topics;
+    cli.set_message_callback([&](const_message_ptr msg) {
+        std::lock_guard<std::mutex> g{lock};
+        REQUIRE(binary{"a configuration blob, shared by all"} == msg->get_payload());
+        topics.push_back(msg->get_topic());
+    });
+    cli.connect()->wait();
+
+    const std::vector<string> devTopics{"dev/1/cfg", "dev/2/cfg", "dev/3/cfg"};
+    auto btok = cli.publish_fanout(devTopics, binary{"a configuration blob, shared by all"}, 1);
+    btok->wait();
+
+    REQUIRE(MQTTASYNC_SUCCESS == btok->get_return_code());
+    REQUIRE(devTopics == topics);
+
+    // The messages all share the one payload
+    const auto& toks = btok->get_delivery_tokens();
+    REQUIRE(3 == toks.size());
+    const auto* data = toks[0]->get_message()->get_payload_ref().data();
+    for (size_t i = 0; i < toks.size(); ++i) {
+        REQUIRE(devTopics[i] == toks[i]->get_message()->get_topic());
+        REQUIRE(1 == toks[i]->get_message()->get_qos());
+        REQUIRE(data == toks[i]->get_message()->get_payload_ref().data());
+    }
+
+    // No topics completes immediately
+    btok = cli.publish_fanout({}, binary{"x"});
+    REQUIRE(btok->is_complete());
+    REQUIRE(0 == btok->size());
+}
+
+TEST_CASE("async_client publish window", "[client]")
+{
+    auto opts = create_options_builder()
+                    .server_uri(GOOD_SERVER_URI)
+                    .client_id(CLIENT_ID)
+                    .max_pending_messages(1)
+                    .finalize();
+    async_client cli{opts};
+
+    // Not connected, so the publish fails and releases its room
+    auto msg = make_message(TOPIC, PAYLOAD, GOOD_QOS, RETAINED);
+    REQUIRE_THROWS_AS(cli.try_publish(msg), mqtt::exception);
+    REQUIRE(0 == cli.get_pending_window_count());
+
+    REQUIRE_THROWS_AS(cli.publish(msg), mqtt::exception);
+    REQUIRE_THROWS_AS(cli.try_publish_for(msg, std::chrono::milliseconds(5)), mqtt::exception);
+    REQUIRE(0 == cli.get_pending_window_count());
+}
+
+TEST_CASE("async_client consume async", "[client]")
+{
+    async_client cli{GOOD_SERVER_URI, CLIENT_ID};
+
+    event evt;
+    const_message_ptr msg;
+    REQUIRE_THROWS_AS(cli.consume_event_async(&evt, [](event) {}), mqtt::exception);
+
+    cli.start_consuming();
+
+    int nEvt = 0, nMsg = 0;
+    bool shutdown = false, nullMsg = false;
+
+    REQUIRE(!cli.consume_event_async(&evt, [&](event e) {
+        ++nEvt;
+        shutdown = e.is_any_disconnect();
+    }));
+    REQUIRE(!cli.consume_message_async(&msg, [&](const_message_ptr m) {
+        ++nMsg;
+        nullMsg = !m;
+    }));
+    REQUIRE(0 == nEvt);
+    REQUIRE(0 == nMsg);
+
+    // Stopping wakes the waiting consumers
+    cli.stop_consuming();
+    REQUIRE(1 == nEvt);
+    REQUIRE(shutdown);
+    REQUIRE(1 == nMsg);
+    REQUIRE(nullMsg);
+
+    // Once closed, they return immediately
+    REQUIRE(cli.consume_event_async(&evt, [](event) {}));
+    REQUIRE(cli.consume_message_async(&msg, [](const_message_ptr) {}));
+    REQUIRE(!msg);
+}
+
+#if !defined(_WIN32)
+TEST_CASE("async_client consumer fd", "[client]")
+{
+    async_client cli{GOOD_SERVER_URI, CLIENT_ID};
+    REQUIRE_THROWS_AS(cli.consumer_fd(), mqtt::exception);
+
+    cli.start_consuming();
+
+    int fd = cli.consumer_fd();
+    REQUIRE(fd >= 0);
+    REQUIRE(fd == cli.consumer_fd());
+
+    auto readable = [fd] {
+        pollfd pfd{fd, POLLIN, 0};
+        return ::poll(&pfd, 1, 0) == 1 && (pfd.revents & POLLIN);
+    };
+    REQUIRE(!readable());
+
+    // Closing the queue signals the fd, until it's cleared
+    cli.stop_consuming();
+    REQUIRE(readable());
+    REQUIRE(readable());
+
+    cli.clear_consumer_fd();
+    REQUIRE(!readable());
+}
+
+TEST_CASE("async_client consumer fd wakeups", "[client]")
+{
+    async_client cli{
+        create_options_builder().server_uri(GOOD_SERVER_URI).client_id(CLIENT_ID).loopback().finalize()
+    };
+    cli.start_consuming();
+    cli.connect()->wait();
+
+    int fd = cli.consumer_fd();
+
+    // A producer keeps putting messages in while the consumer clears,
+    // drains, and polls. Every message must wake the poll loop, so it
+    // never times out with some still to come.
+    const int N = 20000;
+
+    std::thread thr([&cli] {
+        for (int i = 0; i < N; ++i) cli.publish(TOPIC, "x", 1, 0, false);
+    });
+
+    int n = 0;
+    bool timedOut = false;
+
+    while (n < N) {
+        pollfd pfd{fd, POLLIN, 0};
+        if (::poll(&pfd, 1, 2000) != 1) {
+            timedOut = true;
+            break;
+        }
+        cli.clear_consumer_fd();
+
+        const_message_ptr msg;
+        while (cli.try_consume_message(&msg)) ++n;
+    }
+    thr.join();
+
+    REQUIRE(!timedOut);
+    REQUIRE(N == n);
+}
+#endif
+
+TEST_CASE("async_client executor", "[client]")
+{
+    async_client cli{GOOD_SERVER_URI, CLIENT_ID};
+
+    std::vector<async_client::task_type> tasks;
+    cli.set_executor([&tasks](async_client::task_type task) {
+        tasks.push_back(std::move(task));
+    });
+
+    auto run_tasks = [&tasks] {
+        size_t n = 0;
+        while (!tasks.empty()) {
+            auto v = std::move(tasks);
+            tasks.clear();
+            for (auto& task : v) task();
+            n += v.size();
+        }
+        return n;
+    };
+
+    // Not connected, so the message fails, but the listeners are posted
+    mock_action_listener listener;
+    std::vector<const_message_ptr> msgs{make_message(TOPIC, PAYLOAD, GOOD_QOS, RETAINED)};
+
+    auto btok = cli.publish_batch(msgs, nullptr, listener);
+    REQUIRE(!tasks.empty());
+    REQUIRE(!listener.failed());
+
+    REQUIRE(run_tasks() >= 2);
+    REQUIRE(btok->is_complete());
+    REQUIRE(listener.failed());
+    REQUIRE(1 == btok->failed_count());
+
+    // With the executor removed, the listeners run in place
+    cli.set_executor(nullptr);
+
+    mock_action_listener listener2;
+    btok = cli.publish_batch(msgs, nullptr, listener2);
+    REQUIRE(tasks.empty());
+    REQUIRE(btok->is_complete());
+    REQUIRE(listener2.failed());
+}
+
+TEST_CASE("async_client message handlers", "[client]")
+{
+    async_client cli{GOOD_SERVER_URI, CLIENT_ID};
+
+    cli.add_message_handler("data/#", [](const_message_ptr) {});
+    cli.add_message_handler("data/+/temp", [](const_message_ptr) {});
+
+    REQUIRE(cli.remove_message_handler("data/#"));
+    REQUIRE(!cli.remove_message_handler("data/#"));
+
+    // An empty handler removes the filter
+    cli.add_message_handler("data/+/temp", async_client::message_handler{});
+    REQUIRE(!cli.remove_message_handler("data/+/temp"));
+}
+
+TEST_CASE("async_client swap message handlers", "[client]")
+{
+    async_client cli{
+        create_options_builder().server_uri(GOOD_SERVER_URI).client_id(CLIENT_ID).loopback().finalize()
+    };
+
+    std::mutex lock;
+    std::vector<string> routed;
+    auto route = [&](const string& name) {
+        return [&, name](const_message_ptr) {
+            std::lock_guard<std::mutex> g{lock};
+            routed.push_back(name);
+        };
+    };
+
+    cli.add_message_handler("data/#", route("old"));
+    cli.connect()->wait();
+
+    // Build the new table off to the side, then swap it in
+    async_client::message_handler_table tbl;
+    tbl.insert({"data/+/temp", route("temp")});
+    tbl.insert({"cmd/#", route("cmd")});
+
+    auto old = cli.set_message_handlers(std::move(tbl));
+    REQUIRE(old);
+    REQUIRE(old->has_match("data/x"));
+
+    auto snap = cli.get_message_handlers();
+    REQUIRE(!snap->has_match("data/x"));
+    REQUIRE(snap->has_match("cmd/reboot"));
+
+    cli.publish(make_message("data/1/temp", PAYLOAD))->wait();
+    cli.publish(make_message("data/1/humidity", PAYLOAD))->wait();
+    cli.publish(make_message("cmd/reboot", PAYLOAD))->wait();
+
+    REQUIRE((std::vector<string>{"temp", "cmd"}) == routed);
+
+    // An empty table clears all the handlers
+    cli.set_message_handlers(async_client::message_handler_table{});
+    REQUIRE(cli.get_message_handlers()->empty());
+}
+
+TEST_CASE("async_client pending delivery tokens by age", "[client]")
+{
+    async_client cli{
+        create_options_builder().server_uri(GOOD_SERVER_URI).client_id(CLIENT_ID).loopback().finalize()
+    };
+    REQUIRE(0 == cli.num_pending_delivery_tokens());
+    REQUIRE(0 == cli.oldest_pending_delivery_age().count());
+    REQUIRE(cli.get_pending_delivery_tokens(std::chrono::seconds(0)).empty());
+
+    // Loopback delivers the message before completing the publish, so the
+    // tokens are still pending in the callback.
+    size_t nPending = 0;
+    std::vector<delivery_token_ptr> old, young;
+    std::chrono::steady_clock::duration age{0};
+
+    cli.set_message_callback([&](const_message_ptr msg) {
+        if (msg->get_topic() == "first") {
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            cli.publish(make_message("second", PAYLOAD, 1, false));
+            return;
+        }
+        nPending = cli.num_pending_delivery_tokens();
+        age = cli.oldest_pending_delivery_age();
+        old = cli.get_pending_delivery_tokens(std::chrono::milliseconds(10));
+        young = cli.get_pending_delivery_tokens(std::chrono::seconds(0));
+    });
+    cli.connect()->wait();
+    cli.publish(make_message("first", PAYLOAD, 1, false))->wait();
+
+    REQUIRE(2 == nPending);
+    REQUIRE(age >= std::chrono::milliseconds(20));
+
+    REQUIRE(1 == old.size());
+    REQUIRE("first" == old[0]->get_message()->get_topic());
+
+    // Oldest first
+    REQUIRE(2 == young.size());
+    REQUIRE("first" == young[0]->get_message()->get_topic());
+    REQUIRE("second" == young[1]->get_message()->get_topic());
+
+    REQUIRE(0 == cli.num_pending_delivery_tokens());
+    REQUIRE(0 == cli.get_stats().oldestPendingDelivery.count());
+}
+
+TEST_CASE("async_client stats", "[client]")
+{
+    async_client cli{GOOD_SERVER_URI, CLIENT_ID};
+
+    auto st = cli.get_stats();
+    REQUIRE(0 == st.msgsPublished);
+    REQUIRE(0 == st.bytesPublished);
+    REQUIRE(0 == st.msgsAcked);
+    REQUIRE(0 == st.msgsReceived);
+    REQUIRE(0 == st.pendingDeliveryTokens);
+    REQUIRE(0 == st.consumerQueueSize);
+    REQUIRE(0 == st.reconnects);
+    REQUIRE(0 == st.ackLatencyMax.count());
+
+    // Not connected, so nothing is counted as published
+    auto msg = make_message(TOPIC, PAYLOAD, GOOD_QOS, RETAINED);
+    REQUIRE_THROWS_AS(cli.publish(msg), mqtt::exception);
+    cli.publish_batch({msg, msg});
+
+    st = cli.get_stats();
+    REQUIRE(0 == st.msgsPublished);
+    REQUIRE(0 == st.msgsAcked);
+    REQUIRE(0 == st.pendingDeliveryTokens);
+}
+
+TEST_CASE("async_client publish nowait", "[client]")
+{
+    async_client cli{GOOD_SERVER_URI, CLIENT_ID};
+
+    // Not connected, so the error comes back as the return code
+    REQUIRE(MQTTASYNC_DISCONNECTED == cli.publish_nowait(make_message(TOPIC, PAYLOAD)));
+    REQUIRE(MQTTASYNC_DISCONNECTED == cli.publish_nowait(TOPIC, PAYLOAD.data(), PAYLOAD.size()));
+
+    // Only QoS 0 can be sent without tracking
+    REQUIRE(MQTTASYNC_BAD_QOS == cli.publish_nowait(make_message(TOPIC, PAYLOAD, 1, false)));
+    REQUIRE(MQTTASYNC_NULL_PARAMETER == cli.publish_nowait(const_message_ptr{}));
+
+    auto st = cli.get_stats();
+    REQUIRE(0 == st.msgsPublished);
+    REQUIRE(4 == st.publishErrors);
+    REQUIRE(0 == st.pendingDeliveryTokens);
+}
+
+TEST_CASE("callback delivery complete batch", "[callback]")
+{
+    struct counting_callback : public callback
+    {
+        int n = 0;
+        void delivery_complete(delivery_token_ptr) override { ++n; }
+    };
+
+    // By default, a batch is passed to delivery_complete() one at a time
+    counting_callback cb;
+    std::vector<delivery_token_ptr> toks(3);
+    cb.delivery_complete_batch(toks);
+    REQUIRE(3 == cb.n);
+
+    cb.delivery_complete_batch({});
+    REQUIRE(3 == cb.n);
+}
+
+TEST_CASE("async_client connect race", "[client]")
+{
+    async_client cli{GOOD_SERVER_URI, CLIENT_ID};
+
+    auto opts = connect_options_builder()
+                    .servers(string_collection::create(
+                        {"tcp://localhost:1883", "tcp://127.0.0.1:1883"}
+                    ))
+                    .connect_timeout(std::chrono::seconds{5})
+                    .finalize();
+
+    auto tok = cli.connect_race(opts, std::chrono::milliseconds{10});
+    REQUIRE(tok);
+    REQUIRE(token::Type::CONNECT == tok->get_type());
+
+    // Disconnecting calls off the race, which fails the connect
+    try {
+        cli.disconnect();
+    }
+    catch (const mqtt::exception&) {
+    }
+    REQUIRE(tok->is_complete());
+    REQUIRE(MQTTASYNC_OPERATION_INCOMPLETE == tok->get_return_code());
+}
+
+TEST_CASE("async_client trace handler", "[client]")
+{
+    async_client cli{GOOD_SERVER_URI, CLIENT_ID};
+    std::vector<trace_point> pts;
+
+    cli.set_trace_handler(
+        [&pts](trace_point pt, const message& msg, trace_clock::time_point t) {
+            REQUIRE(TOPIC == msg.get_topic());
+            REQUIRE(t.time_since_epoch().count() != 0);
+            pts.push_back(pt);
+        },
+        2
+    );
+
+    // Not connected, but the messages get as far as the send
+    auto msg = make_message(TOPIC, PAYLOAD, GOOD_QOS, RETAINED);
+    for (int i = 0; i < 4; ++i) REQUIRE_THROWS_AS(cli.publish(msg), mqtt::exception);
+
+    REQUIRE(4 == pts.size());
+    REQUIRE(trace_point::PUBLISH == pts[0]);
+    REQUIRE(trace_point::SEND == pts[1]);
+    REQUIRE(trace_point::PUBLISH == pts[2]);
+    REQUIRE(trace_point::SEND == pts[3]);
+
+    pts.clear();
+    cli.set_trace_handler(trace_handler{});
+    REQUIRE_THROWS_AS(cli.publish(msg), mqtt::exception);
+    REQUIRE(pts.empty());
+
+    REQUIRE(string{"DELIVERED"} == trace_point_name(trace_point::DELIVERED));
+}
+
+TEST_CASE("async_client start consuming options", "[client]")
+{
+    async_client cli{GOOD_SERVER_URI, CLIENT_ID};
+
+    // The default is unbounded
+    cli.start_consuming(consumer_options{});
+    REQUIRE(0 == cli.consumer_queue_size());
+    cli.stop_consuming();
+
+    auto opts = consumer_options_builder()
+                    .capacity(1000)
+                    .backend(queue_backend::RING)
+                    .overflow_policy(overflow_policy::DROP_OLDEST)
+                    .finalize();
+
+    REQUIRE(1000 == opts.get_capacity());
+    REQUIRE(queue_backend::RING == opts.get_backend());
+    REQUIRE(overflow_policy::DROP_OLDEST == *opts.get_overflow_policy());
+    REQUIRE(!consumer_options{}.get_overflow_policy());
+
+    cli.start_consuming(opts);
+    REQUIRE(0 == cli.consumer_queue_size());
+
+    const_message_ptr msg;
+    REQUIRE(!cli.try_consume_message(&msg));
+    cli.stop_consuming();
+
+    // Bounded by bytes
+    opts = consumer_options_builder().max_bytes(1024 * 1024).finalize();
+    REQUIRE(1024 * 1024 == opts.get_max_bytes());
+    REQUIRE(0 == consumer_options{}.get_max_bytes());
+
+    cli.start_consuming(opts);
+    REQUIRE(0 == cli.consumer_queue_size());
+    cli.stop_consuming();
+
+    opts.set_backend(queue_backend::RING);
+    REQUIRE_THROWS_AS(cli.start_consuming(opts), std::invalid_argument);
+}
+
+TEST_CASE("async_client deadline", "[client]")
+{
+    async_client cli{GOOD_SERVER_URI, CLIENT_ID};
+
+    auto tok = cli.connect();
+    REQUIRE(tok);
+
+    std::atomic<bool> handled{false};
+    tok->notify_on_complete([&handled] { handled = true; });
+
+    cli.set_deadline(tok, std::chrono::milliseconds{20});
+
+    REQUIRE_THROWS_AS(tok->wait_for(std::chrono::seconds{2}), timeout_error);
+    REQUIRE(tok->is_complete());
+    REQUIRE(tok->is_timed_out());
+    REQUIRE_THROWS_AS(tok->wait(), timeout_error);
+
+    // The handlers run after the waiters are woken
+    for (int i = 0; i < 100 && !handled; ++i)
+        std::this_thread::sleep_for(std::chrono::milliseconds{10});
+    REQUIRE(handled);
+
+    // A deadline for a completed token does nothing
+    cli.set_deadline(tok, std::chrono::milliseconds{1});
+}
+
+TEST_CASE("async_client memory accounting", "[client]")
+{
+    auto opts = create_options_builder()
+                    .server_uri(GOOD_SERVER_URI)
+                    .client_id(CLIENT_ID)
+                    .max_memory(1)
+                    .finalize();
+    async_client cli{opts};
+    cli.start_consuming();
+
+    auto st = cli.get_stats();
+    REQUIRE(0 == st.memoryUsed);
+    REQUIRE(0 == st.pendingDeliveryBytes);
+    REQUIRE(0 == st.consumerQueueBytes);
+
+    // Not connected, so the messages fail and release their memory, but
+    // they were counted while pending. A batch can go over the budget when
+    // nothing else is held.
+    auto msg = make_message(TOPIC, PAYLOAD, GOOD_QOS, RETAINED);
+    REQUIRE_THROWS_AS(cli.try_publish(msg), mqtt::exception);
+    cli.publish_batch({msg, msg});
+
+    st = cli.get_stats();
+    REQUIRE(0 == st.memoryUsed);
+    REQUIRE(0 == st.pendingDeliveryBytes);
+    REQUIRE(st.memoryHighWater >= 2 * msg->memory_size());
+}
+
+TEST_CASE("async_client credential provider", "[client]")
+{
+    async_client cli{GOOD_SERVER_URI, CLIENT_ID};
+
+    auto prov = std::make_shared<refreshing_credential_provider>([] {
+        return credentials{"user", "secret"};
+    });
+    REQUIRE_NOTHROW(cli.set_credential_provider(prov));
+    REQUIRE_NOTHROW(cli.set_credential_provider(nullptr));
+}
+
+TEST_CASE("async_client subscribe bulk", "[client]")
+{
+    async_client cli{GOOD_SERVER_URI, CLIENT_ID};
+
+    // An empty collection completes immediately
+    auto btok = cli.subscribe_bulk(std::make_shared<string_collection>(), iasync_client::qos_collection{});
+    REQUIRE(btok);
+    REQUIRE(btok->is_complete());
+    REQUIRE(0 == btok->num_chunks());
+    REQUIRE(MQTTASYNC_SUCCESS == btok->get_return_code());
+    REQUIRE(btok->get_reason_codes().empty());
+
+    // Long filters, so that they don't all fit in one packet
+    const size_t N = 600;
+    auto filters = std::make_shared<string_collection>();
+    for (size_t i = 0; i < N; ++i) filters->push_back(string(1000, 'a') + std::to_string(i));
+    iasync_client::qos_collection qos(N, GOOD_QOS);
+
+    iasync_client::qos_collection badQos(N - 1, GOOD_QOS);
+    REQUIRE_THROWS_AS(cli.subscribe_bulk(filters, badQos), std::invalid_argument);
+
+    // Not connected, so all of the chunks fail
+    btok = cli.subscribe_bulk(filters, qos);
+    REQUIRE(btok->is_complete());
+    REQUIRE(btok->num_chunks() == 3);
+    REQUIRE(0 == btok->chunk_start(0));
+
+    size_t prev = 0;
+    for (size_t i = 1; i < btok->num_chunks(); ++i) {
+        REQUIRE(btok->chunk_start(i) > prev);
+        prev = btok->chunk_start(i);
+    }
+    for (const auto& tok : btok->get_tokens())
+        REQUIRE(MQTTASYNC_DISCONNECTED == tok->get_return_code());
+
+    REQUIRE(MQTTASYNC_DISCONNECTED == btok->get_return_code());
+    REQUIRE_THROWS_AS(btok->wait(), mqtt::exception);
+
+    auto codes = btok->get_reason_codes();
+    REQUIRE(N == codes.size());
+    for (auto rc : codes) REQUIRE(ReasonCode::UNSPECIFIED_ERROR == rc);
+}
+
+TEST_CASE("async_client restore subscriptions", "[client]")
+{
+    auto filters = string_collection::create({"a/#", "b/+", "c"});
+    iasync_client::qos_collection qos{0, 1, 2};
+
+    SECTION("not tracked by default")
+    {
+        async_client cli{GOOD_SERVER_URI, CLIENT_ID};
+        cli.subscribe_bulk(filters, qos);
+        REQUIRE(cli.get_subscriptions()->empty());
+    }
+
+    SECTION("tracked")
+    {
+        async_client cli{create_options_builder()
+                             .server_uri(GOOD_SERVER_URI)
+                             .client_id(CLIENT_ID)
+                             .restore_subscriptions()
+                             .finalize()};
+
+        // Subscribes made while disconnected are kept to send on connect
+        cli.subscribe_bulk(filters, qos);
+        auto subs = cli.get_subscriptions();
+        REQUIRE(3 == subs->size());
+        REQUIRE("a/#" == (*subs)[0]);
+
+        // The same collection is returned until the subscriptions change
+        REQUIRE(subs == cli.get_subscriptions());
+
+        cli.subscribe_bulk(string_collection::create({"c"}), iasync_client::qos_collection{1});
+        REQUIRE(3 == cli.get_subscriptions()->size());
+
+        REQUIRE_THROWS(cli.unsubscribe("b/+"));
+        subs = cli.get_subscriptions();
+        REQUIRE(2 == subs->size());
+        REQUIRE("c" == (*subs)[1]);
+
+        // A single subscribe throws, but is still kept
+        REQUIRE_THROWS(cli.subscribe("d", 1));
+        REQUIRE(3 == cli.get_subscriptions()->size());
+    }
+
+    SECTION("restored on connect")
+    {
+        async_client cli{create_options_builder()
+                             .server_uri(GOOD_SERVER_URI)
+                             .client_id(CLIENT_ID)
+                             .restore_subscriptions()
+                             .loopback()
+                             .finalize()};
+
+        REQUIRE_THROWS(cli.subscribe("a/#", 1));
+        REQUIRE(!cli.get_restore_token());
+
+        cli.connect()->wait();
+
+        auto btok = cli.get_restore_token();
+        REQUIRE(btok);
+        REQUIRE(btok->is_complete());
+        REQUIRE(MQTTASYNC_SUCCESS == btok->get_return_code());
+        REQUIRE(1 == btok->get_topics()->size());
+        REQUIRE("a/#" == (*btok->get_topics())[0]);
+    }
+}
+
+TEST_CASE("async_client offline buffer tokens", "[client]")
+{
+    auto buf = offline_buffer::create(1024);
+    auto opts = create_options_builder()
+                    .server_uri(GOOD_SERVER_URI)
+                    .client_id(CLIENT_ID)
+                    .offline_buffer(buf)
+                    .loopback()
+                    .finalize();
+
+    SECTION("complete on delivery")
+    {
+        async_client cli{opts};
+
+        auto tok = cli.publish(make_message(TOPIC, PAYLOAD, 1, false));
+        REQUIRE(tok);
+        REQUIRE(!tok->is_complete());
+        REQUIRE(1 == buf->size());
+
+        cli.connect()->wait();
+        REQUIRE(tok->wait_for(std::chrono::seconds(5)));
+        REQUIRE(MQTTASYNC_SUCCESS == tok->get_return_code());
+        REQUIRE(buf->empty());
+    }
+
+    SECTION("fail on destruction")
+    {
+        delivery_token_ptr tok;
+        {
+            async_client cli{opts};
+            tok = cli.publish(make_message(TOPIC, PAYLOAD, 1, false));
+            REQUIRE(!tok->is_complete());
+        }
+        REQUIRE(tok->is_complete());
+        REQUIRE(MQTTASYNC_OPERATION_INCOMPLETE == tok->get_return_code());
+    }
+}
+
+TEST_CASE("async_client incoming topic aliases", "[client]")
+{
+    async_client cli{create_options_builder()
+                         .server_uri(GOOD_SERVER_URI)
+                         .client_id(CLIENT_ID)
+                         .mqtt_version(MQTTVERSION_5)
+                         .loopback()
+                         .finalize()};
+
+    std::vector<string> topics;
+    cli.set_message_callback([&topics](const_message_ptr msg) {
+        topics.push_back(msg->get_topic());
+    });
+
+    auto aliased = [](const string& topic, uint16_t alias) {
+        auto msg = make_message(topic, PAYLOAD);
+        msg->set_properties({{property::TOPIC_ALIAS, alias}});
+        return msg;
+    };
+
+    cli.connect()->wait();
+
+    // The first message sets the alias, and the next only has the alias
+    cli.publish(aliased("a/b", 3));
+    cli.publish(aliased("", 3));
+    REQUIRE(2 == topics.size());
+    REQUIRE("a/b" == topics[0]);
+    REQUIRE("a/b" == topics[1]);
+    REQUIRE("a/b" == cli.incoming_topic_alias(3).str());
+
+    // An alias that was never set has no topic
+    cli.publish(aliased("", 4));
+    REQUIRE(3 == topics.size());
+    REQUIRE(topics[2].empty());
+
+    SECTION("cleared on connect")
+    {
+        cli.connect()->wait();
+        REQUIRE(!cli.incoming_topic_alias(3));
+
+        cli.publish(aliased("", 3));
+        REQUIRE(4 == topics.size());
+        REQUIRE(topics[3].empty());
+    }
+
+    SECTION("cleared on connection lost")
+    {
+        cli.lose_connection();
+        REQUIRE(!cli.incoming_topic_alias(3));
+    }
+}
+
+TEST_CASE("async_client try publish nothrow", "[client]")
+{
+    async_client cli{GOOD_SERVER_URI, CLIENT_ID};
+
+    // Not connected, so the error comes back without an exception
+    auto msg = make_message(TOPIC, PAYLOAD, GOOD_QOS, RETAINED);
+    publish_result res = MQTTASYNC_FAILURE;
+    REQUIRE_NOTHROW(res = cli.try_publish(msg, std::nothrow));
+    REQUIRE(!res);
+    REQUIRE(!res.ok());
+    REQUIRE(MQTTASYNC_DISCONNECTED == res.error());
+    REQUIRE(!res.token());
+    REQUIRE(cli.get_pending_delivery_tokens().empty());
+
+    res = cli.try_publish(TOPIC, PAYLOAD.data(), PAYLOAD.size(), GOOD_QOS, RETAINED, std::nothrow);
+    REQUIRE(MQTTASYNC_DISCONNECTED == res.error());
+
+    res = cli.try_publish(const_message_ptr{}, std::nothrow);
+    REQUIRE(MQTTASYNC_NULL_PARAMETER == res.error());
+
+    // A token makes a successful result
+    publish_result ok{delivery_token::create(cli, msg)};
+    REQUIRE(ok);
+    REQUIRE(MQTTASYNC_SUCCESS == ok.error());
+    REQUIRE(msg == ok->get_message());
+}
+
+TEST_CASE("async_client loopback", "[client]")
+{
+    auto createOpts = create_options_builder()
+                          .server_uri(GOOD_SERVER_URI)
+                          .client_id(CLIENT_ID)
+                          .loopback()
+                          .finalize();
+    async_client cli{createOpts};
+    REQUIRE(!cli.is_connected());
+
+    // Nothing goes out until it's "connected"
+    auto msg = make_message(TOPIC, PAYLOAD, GOOD_QOS, RETAINED);
+    REQUIRE_THROWS_AS(cli.publish(msg), exception);
+
+    cli.start_consuming();
+
+    auto tok = cli.connect();
+    REQUIRE(tok->is_complete());
+    REQUIRE(cli.is_connected());
+
+    tok = cli.subscribe(TOPIC, GOOD_QOS);
+    REQUIRE(tok->is_complete());
+    REQUIRE(MQTTASYNC_SUCCESS == tok->get_return_code());
+
+    // The publish comes back as an arrival, and completes
+    auto dtok = cli.publish(msg);
+    REQUIRE(dtok->is_complete());
+    REQUIRE(MQTTASYNC_SUCCESS == dtok->get_return_code());
+    REQUIRE(cli.get_pending_delivery_tokens().empty());
+
+    const_message_ptr rmsg;
+    REQUIRE(cli.try_consume_message(&rmsg));
+    REQUIRE(rmsg);
+    REQUIRE(TOPIC == rmsg->get_topic());
+    REQUIRE(PAYLOAD == rmsg->get_payload_str());
+    REQUIRE(GOOD_QOS == rmsg->get_qos());
+    REQUIRE(!rmsg->is_retained());
+
+    auto stats = cli.get_stats();
+    REQUIRE(1 == stats.msgsPublished);
+    REQUIRE(1 == stats.msgsReceived);
+
+    tok = cli.disconnect();
+    REQUIRE(tok->is_complete());
+    REQUIRE(!cli.is_connected());
+}
+
+TEST_CASE("async_client forward", "[client]")
+{
+    async_client cli{
+        create_options_builder().server_uri(GOOD_SERVER_URI).client_id(CLIENT_ID).loopback().finalize()
+    };
+    cli.start_consuming();
+    cli.connect()->wait();
+
+    auto orig = make_message(TOPIC, PAYLOAD, GOOD_QOS, false);
+    REQUIRE(cli.publish(orig, "fwd/topic")->is_complete());
+
+    // The message that arrives back was sent with the shared payload
+    const_message_ptr rmsg;
+    REQUIRE(cli.try_consume_message(&rmsg));
+    REQUIRE("fwd/topic" == rmsg->get_topic());
+    REQUIRE(PAYLOAD == rmsg->get_payload_str());
+    REQUIRE(GOOD_QOS == rmsg->get_qos());
+}
+
+TEST_CASE("async_client slow callbacks", "[client]")
+{
+    async_client cli{
+        create_options_builder().server_uri(GOOD_SERVER_URI).client_id(CLIENT_ID).loopback().finalize()
+    };
+
+    std::vector<std::pair<callback_point, string>> slow;
+    cli.set_slow_callback_handler(
+        [&slow](callback_point pt, std::string_view what, std::chrono::microseconds) {
+            slow.emplace_back(pt, string{what});
+        },
+        std::chrono::milliseconds(5)
+    );
+
+    cli.set_message_callback([](const_message_ptr msg) {
+        if (msg->get_topic() == "slow")
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    });
+
+    cli.connect()->wait();
+    cli.publish(make_message(TOPIC, PAYLOAD, GOOD_QOS, false));
+    REQUIRE(slow.empty());
+
+    cli.publish(make_message("slow", PAYLOAD, GOOD_QOS, false));
+    REQUIRE(1 == slow.size());
+    REQUIRE(callback_point::MESSAGE_ARRIVED == slow[0].first);
+    REQUIRE("slow" == slow[0].second);
+
+    // Action listeners are timed with their operation
+    struct slow_listener : public iaction_listener
+    {
+        void on_success(const token&) override {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        void on_failure(const token&) override {}
+    } listener;
+
+    cli.subscribe(TOPIC, GOOD_QOS, nullptr, listener);
+    REQUIRE(2 == slow.size());
+    REQUIRE(callback_point::ACTION == slow[1].first);
+    REQUIRE("subscribe " + TOPIC == slow[1].second);
+
+    auto stats = cli.get_stats();
+    REQUIRE(3 == stats.callbacksTimed);
+    REQUIRE(2 == stats.slowCallbacks);
+    REQUIRE(stats.callbackTimeMax >= std::chrono::milliseconds(10));
+
+    // Once it's stopped, nothing more is timed
+    cli.set_slow_callback_handler(slow_callback_handler{});
+    cli.publish(make_message("slow", PAYLOAD, GOOD_QOS, false));
+    REQUIRE(2 == slow.size());
+    REQUIRE(stats.callbacksTimed == cli.get_stats().callbacksTimed);
+}
+
+TEST_CASE("async_client rtt probe", "[client]")
+{
+    using namespace std::chrono;
+
+    async_client cli{
+        create_options_builder().server_uri(GOOD_SERVER_URI).client_id(CLIENT_ID).loopback().finalize()
+    };
+
+    size_t nArrived = 0;
+    cli.set_message_callback([&nArrived](const_message_ptr) { ++nArrived; });
+
+    // Nothing is probed while disconnected
+    cli.start_rtt_probe(milliseconds(5));
+    std::this_thread::sleep_for(milliseconds(30));
+    REQUIRE(0 == cli.get_stats().rttProbes);
+
+    // Nor in loopback mode, where there's no server to time
+    cli.connect()->wait();
+    std::this_thread::sleep_for(milliseconds(30));
+
+    auto stats = cli.get_stats();
+    REQUIRE(0 == stats.rttProbes);
+    REQUIRE(0 == cli.get_rtt().count());
+
+    // The probes aren't seen as the app's messages
+    REQUIRE(0 == nArrived);
+    REQUIRE(0 == stats.msgsPublished);
+
+    cli.stop_rtt_probe();
+
+    // The times that are measured go into the stats
+    cli.record_rtt_sample(microseconds(100));
+    cli.record_rtt_sample(microseconds(300));
+
+    stats = cli.get_stats();
+    REQUIRE(2 == stats.rttProbes);
+    REQUIRE(stats.rttMax >= stats.rttP50);
+    REQUIRE(cli.get_rtt() >= microseconds(100));
+    REQUIRE(cli.get_rtt() <= microseconds(300));
+}
+
+TEST_CASE("async_client publish shaper", "[client]")
+{
+    using namespace std::chrono;
+
+    auto shaper = publish_shaper::create();
+    shaper->add_rule("drop/#", 1.0, 1, shape_policy::DROP);
+    shaper->add_rule("latest/#", 20.0, 1, shape_policy::COALESCE);
+
+    async_client cli{create_options_builder()
+                         .server_uri(GOOD_SERVER_URI)
+                         .client_id(CLIENT_ID)
+                         .loopback()
+                         .publish_shaper(shaper)
+                         .finalize()};
+
+    std::mutex lock;
+    std::vector<string> arrived;
+    cli.set_message_callback([&](const_message_ptr msg) {
+        std::lock_guard<std::mutex> g{lock};
+        arrived.push_back(msg->to_string());
+    });
+
+    cli.connect()->wait();
+
+    // Over the rate, a message is dropped and its token fails
+    REQUIRE(cli.publish(make_message("drop/a", "1"))->get_return_code() == MQTTASYNC_SUCCESS);
+    auto tok = cli.publish(make_message("drop/a", "2", 1, false));
+    REQUIRE(tok->is_complete());
+    REQUIRE(MQTTASYNC_MAX_BUFFERED_MESSAGES == tok->get_return_code());
+    REQUIRE(MQTTASYNC_MAX_BUFFERED_MESSAGES == cli.publish_nowait(make_message("drop/a", "3")));
+
+    // Only the latest of the held messages is sent. A held message's token
+    // is pending until it's sent, and one that's replaced fails.
+    auto tok4 = cli.publish(make_message("latest/a", "4", 1, false));
+    REQUIRE(tok4->is_complete());
+    REQUIRE(MQTTASYNC_SUCCESS == tok4->get_return_code());
+
+    auto tok5 = cli.publish(make_message("latest/a", "5", 1, false));
+    REQUIRE(!tok5->is_complete());
+
+    auto tok6 = cli.publish(make_message("latest/a", "6", 1, false));
+    REQUIRE(tok5->is_complete());
+    REQUIRE(MQTTASYNC_MAX_BUFFERED_MESSAGES == tok5->get_return_code());
+    REQUIRE(!tok6->is_complete());
+
+    REQUIRE(tok6->wait_for(seconds(2)));
+    REQUIRE(MQTTASYNC_SUCCESS == tok6->get_return_code());
+    REQUIRE("6" == tok6->get_message()->to_string());
+
+    auto until = steady_clock::now() + seconds(2);
+    for (;;) {
+        {
+            std::lock_guard<std::mutex> g{lock};
+            if (arrived.size() >= 3 || steady_clock::now() > until)
+                break;
+        }
+        std::this_thread::sleep_for(milliseconds(5));
+    }
+
+    {
+        std::lock_guard<std::mutex> g{lock};
+        REQUIRE((std::vector<string>{"1", "4", "6"}) == arrived);
+    }
+
+    auto stats = cli.get_stats();
+    REQUIRE(2 == stats.shapedDropped);
+    REQUIRE(1 == stats.shapedCoalesced);
+    REQUIRE(1 == stats.shapedDelayed);
+
+    // A message still held when the client goes away fails its token
+    auto held = publish_shaper::create();
+    held->add_rule("held/#", 0.1, 1, shape_policy::COALESCE);
+
+    delivery_token_ptr heldTok;
+    {
+        async_client cli2{create_options_builder()
+                              .server_uri(GOOD_SERVER_URI)
+                              .client_id(CLIENT_ID)
+                              .loopback()
+                              .publish_shaper(held)
+                              .finalize()};
+        cli2.connect()->wait();
+
+        cli2.publish(make_message("held/a", "1", 1, false));
+        heldTok = cli2.publish(make_message("held/a", "2", 1, false));
+        REQUIRE(!heldTok->is_complete());
+    }
+    REQUIRE(heldTok->is_complete());
+    REQUIRE(MQTTASYNC_OPERATION_INCOMPLETE == heldTok->get_return_code());
+}
+
+TEST_CASE("async_client manual ack", "[client]")
+{
+    async_client cli{create_options_builder()
+                         .server_uri(GOOD_SERVER_URI)
+                         .client_id(CLIENT_ID)
+                         .loopback()
+                         .manual_ack(3)
+                         .finalize()};
+    cli.start_consuming();
+    cli.connect()->wait();
+
+    // QoS 0 messages aren't acknowledged
+    cli.publish(make_message(TOPIC, PAYLOAD, 0, false));
+    REQUIRE(0 == cli.unacked_count());
+
+    for (int i = 0; i < 3; ++i) cli.publish(make_message(TOPIC, PAYLOAD, 1, false));
+    REQUIRE(3 == cli.unacked_count());
+
+    // Once the limit is reached, messages are refused
+    cli.publish(make_message(TOPIC, PAYLOAD, 1, false));
+    REQUIRE(3 == cli.unacked_count());
+
+    std::vector<const_message_ptr> msgs;
+    const_message_ptr msg;
+    while (cli.try_consume_message(&msg)) msgs.push_back(msg);
+    REQUIRE(4 == msgs.size());
+
+    REQUIRE(!cli.ack(msgs[0]));
+    REQUIRE(cli.ack(msgs[2]));
+    REQUIRE(!cli.ack(msgs[2]));
+    REQUIRE(2 == cli.unacked_count());
+
+    auto unacked = cli.get_unacked();
+    REQUIRE(2 == unacked.size());
+    REQUIRE(msgs[1] == unacked[0]);
+    REQUIRE(msgs[3] == unacked[1]);
+
+    // Acknowledges everything up to the message
+    cli.publish(make_message(TOPIC, PAYLOAD, 2, false));
+    REQUIRE(cli.try_consume_message(&msg));
+    REQUIRE(3 == cli.ack_through(msg));
+    REQUIRE(0 == cli.unacked_count());
+    REQUIRE(cli.get_unacked().empty());
+}
@@ -22,6 +22,7 @@
 #define UNIT_TESTS
 
 #include <cstring>
+#include <memory>
 
 #include "catch2_version.h"
 #include "mqtt/buffer_ref.h"
@@ -119,7 +120,8 @@ TEST_CASE("copy_ctor", "[collections]")
 
     REQUIRE(STR == sr.str());
     REQUIRE(orgSR.ptr().get() == sr.ptr().get());
-    REQUIRE(2 == sr.ptr().use_count());
+    // The references share the buffer, along with the pointer we got
+    REQUIRE(3 == sr.ptr().use_count());
 }
 
 // ----------------------------------------------------------------------
@@ -134,7 +136,7 @@ TEST_CASE("move_ctor", "[collections]")
     REQUIRE(STR == sr.str());
 
     REQUIRE_FALSE(orgSR);
-    REQUIRE(1 == sr.ptr().use_count());
+    REQUIRE(2 == sr.ptr().use_count());
 }
 
 // ----------------------------------------------------------------------
@@ -149,7 +151,8 @@ TEST_CASE("copy_assignment", "[collections]")
 
     REQUIRE(STR == sr.str());
     REQUIRE(orgSR.ptr().get() == sr.ptr().get());
-    REQUIRE(2 == sr.ptr().use_count());
+    // The references share the buffer, along with the pointer we got
+    REQUIRE(3 == sr.ptr().use_count());
 
     // Test for true copy
     orgSR = EMPTY_STR;
@@ -169,7 +172,7 @@ TEST_CASE("move_assignment", "[collections]")
     REQUIRE(STR == sr.str());
 
     REQUIRE_FALSE(orgSR);
-    REQUIRE(1 == sr.ptr().use_count());
+    REQUIRE(2 == sr.ptr().use_count());
 }
 
 // ----------------------------------------------------------------------
@@ -201,7 +204,7 @@ TEST_CASE("str_move_assignment", "[collections]")
     REQUIRE(STR == sr.str());
 
     REQUIRE(EMPTY_STR == str);
-    REQUIRE(1 == sr.ptr().use_count());
+    REQUIRE(2 == sr.ptr().use_count());
 }
 
 // ----------------------------------------------------------------------
@@ -258,3 +261,127 @@ TEST_CASE("reset", "[collections]")
     REQUIRE_FALSE(sr);
     REQUIRE(sr.empty());
 }
+
+// ----------------------------------------------------------------------
+// Test adopting an external buffer
+// ----------------------------------------------------------------------
+
+TEST_CASE("adopt_ctor", "[collections]")
+{
+    char* buf = new char[CSTR_LEN];
+    memcpy(buf, CSTR, CSTR_LEN);
+
+    int nfree = 0;
+    {
+        binary_ref br(buf, CSTR_LEN, [&nfree](const char* p) {
+            ++nfree;
+            delete[] p;
+        });
+
+        REQUIRE(br);
+        REQUIRE(br.is_external());
+        REQUIRE(CSTR_LEN == br.size());
+        REQUIRE(buf == br.data());
+        REQUIRE(CSTR[1] == br[1]);
+
+        // Copies share the same buffer
+        binary_ref br2{br};
+        REQUIRE(buf == br2.data());
+
+        // A string is created on request, and only once.
+        REQUIRE(string(CSTR) == br.str());
+        REQUIRE(&br.str() == &br2.str());
+        REQUIRE(buf == br.data());
+
+        br.reset();
+        REQUIRE_FALSE(br);
+        REQUIRE(0 == nfree);
+    }
+    REQUIRE(1 == nfree);
+}
+
+TEST_CASE("owner_ctor", "[collections]")
+{
+    auto owner = std::make_shared<string>(CSTR);
+    const char* buf = owner->data();
+
+    {
+        binary_ref br(buf, owner->size(), owner);
+
+        REQUIRE(br);
+        REQUIRE(br.is_external());
+        REQUIRE(CSTR_LEN == br.size());
+        REQUIRE(buf == br.data());
+        REQUIRE(2 == owner.use_count());
+
+        // Copies share the owner
+        binary_ref br2{br};
+        REQUIRE(buf == br2.data());
+        REQUIRE(2 == owner.use_count());
+
+        br.reset();
+        REQUIRE(2 == owner.use_count());
+    }
+    REQUIRE(1 == owner.use_count());
+}
+
+// ----------------------------------------------------------------------
+// Test small buffers
+// ----------------------------------------------------------------------
+
+TEST_CASE("small_buffer", "[collections]")
+{
+    const string SMALL{"small"};
+
+    string_ref sr{SMALL};
+    REQUIRE(sr);
+    REQUIRE(sr.is_small());
+    REQUIRE(!sr.is_external());
+    REQUIRE(SMALL == sr.str());
+    REQUIRE(SMALL.size() == sr.size());
+    REQUIRE(0 == memcmp(SMALL.data(), sr.data(), SMALL.size()));
+
+    // Larger buffers are shared
+    REQUIRE(!string_ref{STR}.is_small());
+    REQUIRE(string_ref{string(string_ref::SMALL_SIZE, 'x')}.is_small());
+    REQUIRE(!string_ref{string(string_ref::SMALL_SIZE + 1, 'x')}.is_small());
+
+    // Copies hold their own data
+    string_ref sr2{sr};
+    REQUIRE(sr2.is_small());
+    REQUIRE(SMALL == sr2.str());
+    REQUIRE(sr.data() != sr2.data());
+
+    // A small buffer is never shared, so each pointer is to a new copy
+    auto p = sr.ptr();
+    REQUIRE(p);
+    REQUIRE(SMALL == *p);
+    REQUIRE(p != sr.ptr());
+    REQUIRE(sr.is_small());
+
+    // The reference is only a word bigger than the string it can hold
+    REQUIRE(sizeof(string_ref) <= sizeof(string::size_type) + sizeof(string));
+
+    // Moving leaves the other reference null
+    string_ref sr3{std::move(sr)};
+    REQUIRE(SMALL == sr3.str());
+    REQUIRE(sr.is_null());
+
+    sr = std::move(sr3);
+    REQUIRE(SMALL == sr.str());
+    REQUIRE(sr3.is_null());
+
+    // Reassigning to a large buffer
+    sr = STR;
+    REQUIRE(!sr.is_small());
+    REQUIRE(STR == sr.str());
+
+    sr = "tiny";
+    REQUIRE(sr.is_small());
+    REQUIRE("tiny" == sr.str());
+
+    sr.reset();
+    REQUIRE(sr.is_null());
+    REQUIRE(sr.empty());
+    REQUIRE(!sr.is_small());
+}
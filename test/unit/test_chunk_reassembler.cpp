@@ -0,0 +1,144 @@
+// test_chunk_reassembler.cpp
+//
+// Unit tests for the chunk_reassembler class in the Paho MQTT C++ library.
+//
+
+/*******************************************************************************
+ * Copyright (c) 2025 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - Initial implementation
+ *******************************************************************************/
+
+#define UNIT_TESTS
+
+#include <chrono>
+#include <string>
+#include <thread>
+
+#include "catch2_version.h"
+#include "mqtt/chunk_reassembler.h"
+#include "mqtt/stream_publisher.h"
+
+using namespace mqtt;
+using namespace std::chrono;
+
+/////////////////////////////////////////////////////////////////////////////
+
+static const string TOPIC{"firmware/image"};
+
+static message_ptr chunk(
+    const string& xfer, size_t offset, const string& data, bool last = false, size_t total = 0
+)
+{
+    properties props{
+        {property::USER_PROPERTY, stream_publisher::TRANSFER_PROPERTY_NAME, xfer},
+        {property::USER_PROPERTY, stream_publisher::OFFSET_PROPERTY_NAME, std::to_string(offset)},
+        {property::USER_PROPERTY, "app", "fw"}
+    };
+    if (total > 0)
+        props.add({property::USER_PROPERTY, stream_publisher::SIZE_PROPERTY_NAME,
+                   std::to_string(total)});
+    if (last)
+        props.add({property::USER_PROPERTY, stream_publisher::LAST_PROPERTY_NAME, "1"});
+
+    return make_message(TOPIC, data, 1, false, props);
+}
+
+TEST_CASE("chunk_reassembler pass through", "[reassembler]")
+{
+    chunk_reassembler ra;
+
+    auto msg = make_message(TOPIC, "hello");
+    REQUIRE(msg == ra.add(msg));
+    REQUIRE(0 == ra.pending());
+}
+
+TEST_CASE("chunk_reassembler in order", "[reassembler]")
+{
+    chunk_reassembler ra;
+
+    REQUIRE(!ra.add(chunk("x", 0, "abc")));
+    REQUIRE(!ra.add(chunk("x", 3, "def")));
+    REQUIRE(1 == ra.pending());
+    REQUIRE(ra.bytes() > 0);
+
+    auto msg = ra.add(chunk("x", 6, "gh", true));
+    REQUIRE(msg);
+    REQUIRE("abcdefgh" == msg->get_payload_str());
+    REQUIRE(TOPIC == msg->get_topic());
+
+    // The transfer properties are dropped, the others kept
+    const auto& props = msg->get_properties();
+    REQUIRE(!props.contains_user_property(stream_publisher::TRANSFER_PROPERTY_NAME));
+    REQUIRE(!props.contains_user_property(stream_publisher::OFFSET_PROPERTY_NAME));
+    REQUIRE("fw" == props.get_user_property("app"));
+
+    REQUIRE(0 == ra.pending());
+    REQUIRE(0 == ra.bytes());
+    REQUIRE(1 == ra.completed());
+}
+
+TEST_CASE("chunk_reassembler out of order with size", "[reassembler]")
+{
+    chunk_reassembler ra;
+
+    REQUIRE(!ra.add(chunk("x", 6, "gh", true, 8)));
+    REQUIRE(8 == ra.bytes());
+    REQUIRE(!ra.add(chunk("y", 0, "123", false, 6)));
+    REQUIRE(!ra.add(chunk("x", 0, "abc", false, 8)));
+
+    // A repeated chunk is ignored
+    REQUIRE(!ra.add(chunk("x", 0, "abc", false, 8)));
+
+    auto msg = ra.add(chunk("x", 3, "def", false, 8));
+    REQUIRE(msg);
+    REQUIRE("abcdefgh" == msg->get_payload_str());
+
+    msg = ra.add(chunk("y", 3, "456", true, 6));
+    REQUIRE(msg);
+    REQUIRE("123456" == msg->get_payload_str());
+    REQUIRE(2 == ra.completed());
+}
+
+TEST_CASE("chunk_reassembler memory limit", "[reassembler]")
+{
+    chunk_reassembler ra{16};
+
+    // Bigger than the whole limit
+    REQUIRE(!ra.add(chunk("big", 0, "abc", false, 100)));
+    REQUIRE(0 == ra.pending());
+    REQUIRE(1 == ra.dropped());
+
+    // The one idle longest is dropped to make room
+    REQUIRE(!ra.add(chunk("a", 0, "abc", false, 10)));
+    std::this_thread::sleep_for(milliseconds(2));
+    REQUIRE(!ra.add(chunk("b", 0, "abc", false, 10)));
+    REQUIRE(1 == ra.pending());
+    REQUIRE(10 == ra.bytes());
+    REQUIRE(2 == ra.dropped());
+}
+
+TEST_CASE("chunk_reassembler timeout", "[reassembler]")
+{
+    chunk_reassembler ra{chunk_reassembler::DFLT_MAX_BYTES, milliseconds(20)};
+
+    REQUIRE(!ra.add(chunk("x", 0, "abc")));
+    REQUIRE(1 == ra.pending());
+    REQUIRE(0 == ra.expire());
+
+    std::this_thread::sleep_for(milliseconds(50));
+    REQUIRE(1 == ra.expire());
+    REQUIRE(0 == ra.pending());
+    REQUIRE(0 == ra.bytes());
+    REQUIRE(1 == ra.dropped());
+}
@@ -26,6 +26,10 @@
 
 #define UNIT_TESTS
 
+#include <atomic>
+#include <thread>
+#include <vector>
+
 #include "catch2_version.h"
 #include "mock_action_listener.h"
 #include "mock_callback.h"
@@ -281,6 +285,24 @@ TEST_CASE("client publish pointer 2 args failure", "[client]")
     REQUIRE(MQTTASYNC_DISCONNECTED == return_code);
 }
 
+TEST_CASE("client publish many failure", "[client]")
+{
+    mqtt::client cli{GOOD_SERVER_URI, CLIENT_ID};
+    REQUIRE(!cli.is_connected());
+
+    std::vector<mqtt::const_message_ptr> msgs;
+    for (int i = 0; i < 4; ++i) msgs.push_back(mqtt::message::create(TOPIC, PAYLOAD, 1, false));
+
+    int return_code = MQTTASYNC_SUCCESS;
+    try {
+        cli.publish_many(msgs);
+    }
+    catch (mqtt::exception& ex) {
+        return_code = ex.get_return_code();
+    }
+    REQUIRE(MQTTASYNC_DISCONNECTED == return_code);
+}
+
 TEST_CASE("client publish reference 2 args", "[client]")
 {
     mqtt::client cli{GOOD_SERVER_URI, CLIENT_ID};
@@ -325,6 +347,74 @@ TEST_CASE("client set callback", "[client]")
     cli.set_callback(cb);
 }
 
+// Sets a flag when the thread that touched it exits
+struct thread_exit_flag
+{
+    std::atomic<bool>* flag{nullptr};
+    ~thread_exit_flag() {
+        if (flag)
+            *flag = true;
+    }
+};
+
+static thread_local thread_exit_flag exitFlag;
+
+// A callback that calls back into the client
+class reentrant_callback : public mqtt::callback
+{
+public:
+    mqtt::client* cli{nullptr};
+    std::atomic<bool>* exited{nullptr};
+    std::vector<std::thread::id> connThreads;
+    std::vector<string> topics;
+
+    void connected(const string&) override {
+        connThreads.push_back(std::this_thread::get_id());
+        exitFlag.flag = exited;
+        cli->publish(TOPIC, PAYLOAD.data(), PAYLOAD.size(), GOOD_QOS, RETAINED);
+    }
+
+    void message_arrived(const_message_ptr msg) override {
+        topics.push_back(msg->get_topic());
+        if (msg->get_topic() == TOPIC)
+            cli->publish("reply", PAYLOAD.data(), PAYLOAD.size(), GOOD_QOS, RETAINED);
+    }
+};
+
+TEST_CASE("client callback calls into client", "[client]")
+{
+    std::atomic<bool> exited{false};
+    {
+        reentrant_callback cb;
+        mqtt::client cli{
+            create_options_builder().server_uri(GOOD_SERVER_URI).client_id(CLIENT_ID).loopback().finalize()
+        };
+        cb.cli = &cli;
+        cb.exited = &exited;
+        cli.set_callback(cb);
+
+        // The callbacks publish without deadlocking the client
+        cli.connect();
+        REQUIRE(1 == cb.connThreads.size());
+        REQUIRE(std::this_thread::get_id() != cb.connThreads[0]);
+        REQUIRE(2 == cb.topics.size());
+        REQUIRE(TOPIC == cb.topics[0]);
+        REQUIRE("reply" == cb.topics[1]);
+        cli.disconnect();
+
+        // The callbacks keep the same thread
+        cli.connect();
+        REQUIRE(2 == cb.connThreads.size());
+        REQUIRE(cb.connThreads[0] == cb.connThreads[1]);
+        cli.disconnect();
+
+        REQUIRE(!exited);
+    }
+
+    // The callback thread is joined when the client is destroyed
+    REQUIRE(exited);
+}
+
 //----------------------------------------------------------------------
 // Test client::subscribe()
 //----------------------------------------------------------------------
@@ -514,3 +604,45 @@ TEST_CASE("client unsubscribe many topics 1 arg failure", "[client]")
     }
     REQUIRE(MQTTASYNC_DISCONNECTED == return_code);
 }
+
+//----------------------------------------------------------------------
+// Test client::consume_messages()
+//----------------------------------------------------------------------
+
+TEST_CASE("client consume messages", "[client]")
+{
+    mqtt::client cli{
+        create_options_builder().server_uri(GOOD_SERVER_URI).client_id(CLIENT_ID).loopback().finalize()
+    };
+
+    cli.start_consuming();
+
+    // Nothing there yet
+    REQUIRE(cli.consume_messages(10, milliseconds(10)).empty());
+
+    cli.connect();
+
+    // The connected event is skipped, but counted, so it's not a timeout
+    std::vector<const_message_ptr> msgs;
+    REQUIRE(1 == cli.consume_messages(msgs, 10, milliseconds(100)));
+    REQUIRE(msgs.empty());
+
+    for (int i = 0; i < 3; ++i) cli.publish(TOPIC, PAYLOAD.data(), PAYLOAD.size(), GOOD_QOS, RETAINED);
+
+    msgs = cli.consume_messages(10, milliseconds(100));
+    REQUIRE(3 == msgs.size());
+    REQUIRE(TOPIC == msgs[0]->get_topic());
+    REQUIRE(PAYLOAD == msgs[2]->to_string());
+
+    REQUIRE(0 == cli.try_consume_messages(msgs, 10));
+    REQUIRE(0 == cli.consume_messages(msgs, 10, milliseconds(10)));
+
+    for (int i = 0; i < 3; ++i) cli.publish(TOPIC, PAYLOAD.data(), PAYLOAD.size(), GOOD_QOS, RETAINED);
+
+    REQUIRE(2 == cli.try_consume_messages(msgs, 2));
+    REQUIRE(1 == cli.consume_messages(msgs, 2, milliseconds(100)));
+    REQUIRE(6 == msgs.size());
+
+    cli.stop_consuming();
+    cli.disconnect();
+}
@@ -0,0 +1,164 @@
+// test_client_pool.cpp
+//
+// Unit tests for the client_pool class in the Paho MQTT C++ library.
+//
+
+/*******************************************************************************
+ * Copyright (c) 2025 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - Initial implementation
+ *******************************************************************************/
+
+#define UNIT_TESTS
+
+#include <set>
+#include <string>
+
+#include "catch2_version.h"
+#include "mqtt/client_pool.h"
+
+using namespace mqtt;
+
+static const std::string SERVER_URI{"tcp://localhost:1883"};
+static const std::string CLIENT_ID{"test_client_pool"};
+
+/////////////////////////////////////////////////////////////////////////////
+
+TEST_CASE("client_pool constructor", "[client_pool]")
+{
+    client_pool pool{SERVER_URI, CLIENT_ID, 4};
+
+    REQUIRE(4 == pool.size());
+    REQUIRE(!pool.is_connected());
+
+    for (size_t i = 0; i < pool.size(); ++i) {
+        REQUIRE(SERVER_URI == pool.get_client(i).get_server_uri());
+        REQUIRE(
+            CLIENT_ID + "-" + std::to_string(i) == pool.get_client(i).get_client_id()
+        );
+    }
+
+    REQUIRE_THROWS_AS(pool.get_client(4), std::out_of_range);
+    REQUIRE_THROWS_AS(client_pool(SERVER_URI, CLIENT_ID, 0), std::invalid_argument);
+}
+
+TEST_CASE("client_pool create options", "[client_pool]")
+{
+    auto opts = create_options_builder()
+                    .server_uri(SERVER_URI)
+                    .client_id("")
+                    .mqtt_version(MQTTVERSION_5)
+                    .finalize();
+
+    client_pool pool{opts, 2};
+    REQUIRE(2 == pool.size());
+
+    for (size_t i = 0; i < pool.size(); ++i) {
+        REQUIRE(pool.get_client(i).get_client_id().empty());
+        REQUIRE(MQTTVERSION_5 == pool.get_client(i).mqtt_version());
+    }
+
+    REQUIRE("pub-3" == client_pool::make_client_id("pub", 3));
+    REQUIRE(client_pool::make_client_id("", 3).empty());
+}
+
+TEST_CASE("client_pool topic hash", "[client_pool]")
+{
+    client_pool pool{SERVER_URI, CLIENT_ID, 8};
+    std::set<size_t> used;
+
+    for (int i = 0; i < 64; ++i) {
+        auto topic = "sensor/" + std::to_string(i);
+        auto idx = pool.index_for(topic);
+
+        REQUIRE(idx < pool.size());
+        REQUIRE(idx == pool.index_for(topic));
+        REQUIRE(&pool.get_client(idx) == &pool.client_for(topic));
+        used.insert(idx);
+    }
+
+    // The topics are spread over the clients
+    REQUIRE(used.size() > 1);
+}
+
+TEST_CASE("client_pool publish failure", "[client_pool]")
+{
+    client_pool pool{SERVER_URI, CLIENT_ID, 2};
+
+    int rc = MQTTASYNC_SUCCESS;
+    try {
+        pool.publish("topic", "payload", 7);
+    }
+    catch (const mqtt::exception& ex) {
+        rc = ex.get_return_code();
+    }
+    REQUIRE(MQTTASYNC_DISCONNECTED == rc);
+
+    rc = MQTTASYNC_SUCCESS;
+    try {
+        pool.disconnect();
+    }
+    catch (const mqtt::exception& ex) {
+        rc = ex.get_return_code();
+    }
+    REQUIRE(MQTTASYNC_DISCONNECTED == rc);
+}
+
+TEST_CASE("client_pool stats", "[client_pool]")
+{
+    client_pool pool{SERVER_URI, CLIENT_ID, 3};
+
+    auto stats = pool.get_stats();
+    REQUIRE(0 == stats.msgsPublished);
+    REQUIRE(0 == stats.pendingDeliveryTokens);
+    REQUIRE(0 == stats.reconnects);
+    REQUIRE(pool.get_pending_delivery_tokens().empty());
+}
+
+TEST_CASE("client_pool lowest rtt", "[client_pool]")
+{
+    client_pool pool{SERVER_URI, CLIENT_ID, 3};
+
+    // With none connected, it falls back to the first client
+    REQUIRE(0 == pool.index_lowest_rtt());
+    REQUIRE(&pool.get_client(0) == &pool.lowest_rtt_client());
+
+    pool.start_rtt_probe(std::chrono::milliseconds(10));
+    pool.stop_rtt_probe();
+    REQUIRE(0 == pool.get_stats().rttProbes);
+}
+
+TEST_CASE("client_pool ramped connect", "[client_pool]")
+{
+    using namespace std::chrono;
+
+    client_pool pool{SERVER_URI, CLIENT_ID, 3};
+
+    // Three connections at 200/sec are started over at least 10ms
+    auto start = steady_clock::now();
+    auto tok = pool.connect(connect_options{}, 200.0);
+    auto elapsed = steady_clock::now() - start;
+
+    REQUIRE(elapsed >= milliseconds(9));
+    REQUIRE(3 == tok->size());
+    REQUIRE(3 == tok->get_tokens().size());
+}
+
+TEST_CASE("client_pool moved create options", "[client_pool]")
+{
+    auto opts = create_options_builder().server_uri(SERVER_URI).client_id(CLIENT_ID).finalize();
+    async_client cli{std::move(opts)};
+
+    REQUIRE(SERVER_URI == cli.get_server_uri());
+    REQUIRE(CLIENT_ID == cli.get_client_id());
+}
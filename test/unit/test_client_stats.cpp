@@ -0,0 +1,113 @@
+// test_client_stats.cpp
+//
+// Unit tests for the latency_histogram class in the Paho MQTT C++ library.
+//
+
+/*******************************************************************************
+ * Copyright (c) 2025 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+#define UNIT_TESTS
+
+#include <thread>
+#include <vector>
+
+#include "catch2_version.h"
+#include "mqtt/client_stats.h"
+
+using namespace mqtt;
+using namespace std::chrono;
+
+// ----------------------------------------------------------------------
+
+TEST_CASE("latency_histogram empty", "[stats]")
+{
+    latency_histogram hist;
+
+    REQUIRE(0 == hist.count());
+    REQUIRE(0 == hist.max().count());
+    REQUIRE(0 == hist.percentile(50.0).count());
+    REQUIRE(0 == hist.percentile(99.9).count());
+}
+
+TEST_CASE("latency_histogram small values", "[stats]")
+{
+    latency_histogram hist;
+
+    // The small values are exact
+    for (int i = 1; i <= 50; ++i) hist.record(microseconds(i));
+
+    REQUIRE(50 == hist.count());
+    REQUIRE(50 == hist.max().count());
+    REQUIRE(25 == hist.percentile(50.0).count());
+    REQUIRE(50 == hist.percentile(99.0).count());
+    REQUIRE(1 == hist.percentile(0.0).count());
+
+    hist.clear();
+    REQUIRE(0 == hist.count());
+    REQUIRE(0 == hist.max().count());
+}
+
+TEST_CASE("latency_histogram precision", "[stats]")
+{
+    latency_histogram hist;
+
+    for (int i = 0; i < 990; ++i) hist.record(milliseconds(1));
+    for (int i = 0; i < 9; ++i) hist.record(milliseconds(100));
+    hist.record(seconds(2));
+
+    REQUIRE(1000 == hist.count());
+    REQUIRE(2000000 == hist.max().count());
+
+    auto p50 = hist.percentile(50.0).count();
+    REQUIRE(p50 >= 1000);
+    REQUIRE(p50 <= 1032);
+
+    auto p999 = hist.percentile(99.9).count();
+    REQUIRE(p999 >= 100000);
+    REQUIRE(p999 <= 103200);
+
+    REQUIRE(2000000 == hist.percentile(100.0).count());
+
+    // Negative values are counted as zero
+    hist.record(microseconds(-5));
+    REQUIRE(1001 == hist.count());
+}
+
+TEST_CASE("latency_histogram huge values", "[stats]")
+{
+    latency_histogram hist;
+    hist.record(hours(1000));
+
+    REQUIRE(1 == hist.count());
+    REQUIRE(hist.max() == hours(1000));
+    REQUIRE(hist.percentile(50.0) == hours(1000));
+}
+
+TEST_CASE("latency_histogram threads", "[stats]")
+{
+    latency_histogram hist;
+    std::vector<std::thread> thrs;
+
+    for (int i = 0; i < 4; ++i) {
+        thrs.emplace_back([&hist, i] {
+            for (int j = 0; j < 1000; ++j) hist.record(microseconds(i * 1000 + j));
+        });
+    }
+    for (auto& thr : thrs) thr.join();
+
+    REQUIRE(4000 == hist.count());
+    REQUIRE(3999 == hist.max().count());
+}
@@ -0,0 +1,160 @@
+// test_coalescing_publisher.cpp
+//
+// Unit tests for the coalescing_publisher and record_batch classes in the
+// Paho MQTT C++ library.
+//
+
+/*******************************************************************************
+ * Copyright (c) 2025 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - Initial implementation
+ *******************************************************************************/
+
+#define UNIT_TESTS
+
+#include <chrono>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "catch2_version.h"
+#include "mqtt/coalescing_publisher.h"
+
+using namespace mqtt;
+using namespace std::chrono;
+
+static const std::string SERVER_URI{"tcp://localhost:1883"};
+static const std::string CLIENT_ID{"test_coalescing_publisher"};
+
+/////////////////////////////////////////////////////////////////////////////
+
+static std::vector<string> records_of(const record_batch& batch)
+{
+    std::vector<string> recs;
+    for (const auto& rec : batch) recs.push_back(rec.to_string());
+    return recs;
+}
+
+TEST_CASE("record_batch round trip", "[record_batch]")
+{
+    binary buf;
+    REQUIRE(record_batch{binary_ref{buf}}.empty());
+
+    const string big(200, 'x');
+    record_batch::append(buf, "one", 3);
+    record_batch::append(buf, "", 0);
+    record_batch::append(buf, big.data(), big.size());
+
+    // A short record has a one-byte prefix, a longer one two
+    REQUIRE(buf.size() == 1 + 3 + 1 + 0 + 2 + big.size());
+
+    record_batch batch{binary_ref{std::move(buf)}};
+    REQUIRE(3 == batch.size());
+    REQUIRE((std::vector<string>{"one", "", big}) == records_of(batch));
+}
+
+TEST_CASE("record_batch zero copy", "[record_batch]")
+{
+    binary buf;
+    for (int i = 0; i < 10; ++i) record_batch::append(buf, "reading", 7);
+
+    auto msg = make_message("data", std::move(buf));
+    record_batch batch{*msg};
+
+    const auto& payload = msg->get_payload_ref();
+    size_t n = 0;
+    for (const auto& rec : batch) {
+        REQUIRE(rec.data() > payload.data());
+        REQUIRE(rec.data() + rec.size() <= payload.data() + payload.size());
+        ++n;
+    }
+    REQUIRE(10 == n);
+}
+
+TEST_CASE("record_batch malformed", "[record_batch]")
+{
+    // The length runs past the end
+    REQUIRE_THROWS_AS(record_batch{binary_ref{binary{"\x05" "abc"}}}, mqtt::exception);
+    // The prefix is cut off
+    REQUIRE_THROWS_AS(record_batch{binary_ref{binary{"\x80"}}}, mqtt::exception);
+    // The prefix is longer than four bytes
+    REQUIRE_THROWS_AS(record_batch{binary_ref{binary{"\x80\x80\x80\x80\x01"}}}, mqtt::exception);
+}
+
+TEST_CASE("coalescing_publisher", "[record_batch]")
+{
+    async_client cli{
+        create_options_builder().server_uri(SERVER_URI).client_id(CLIENT_ID).loopback().finalize()
+    };
+
+    std::mutex lock;
+    std::vector<std::pair<string, std::vector<string>>> batches;
+    cli.set_message_callback([&](const_message_ptr msg) {
+        std::lock_guard<std::mutex> g{lock};
+        batches.emplace_back(msg->get_topic(), records_of(record_batch{*msg}));
+    });
+    cli.connect()->wait();
+
+    REQUIRE_THROWS_AS(coalescing_publisher(cli, 0, milliseconds(10), 0), std::invalid_argument);
+
+    SECTION("size limit") {
+        coalescing_publisher pub{cli, 0, seconds(10), 16};
+        pub.publish("a", "12345");
+        pub.publish("b", "xyz");
+        pub.publish("a", "67890");
+        REQUIRE(3 == pub.pending_records());
+
+        // The third record for "a" fills the batch
+        pub.publish("a", "abcde");
+        REQUIRE(1 == pub.batches());
+        REQUIRE(3 == pub.records());
+        REQUIRE(1 == pub.pending_records());
+        {
+            std::lock_guard<std::mutex> g{lock};
+            REQUIRE(1 == batches.size());
+            REQUIRE("a" == batches[0].first);
+            REQUIRE((std::vector<string>{"12345", "67890", "abcde"}) == batches[0].second);
+        }
+
+        pub.flush();
+        REQUIRE(0 == pub.pending_records());
+        REQUIRE(2 == pub.batches());
+        std::lock_guard<std::mutex> g{lock};
+        REQUIRE("b" == batches[1].first);
+    }
+
+    SECTION("time limit") {
+        coalescing_publisher pub{cli, 0, milliseconds(20)};
+        pub.publish("a", "1");
+        pub.publish("a", "2");
+
+        auto until = steady_clock::now() + seconds(2);
+        while (pub.batches() == 0 && steady_clock::now() < until)
+            std::this_thread::sleep_for(milliseconds(5));
+
+        REQUIRE(1 == pub.batches());
+        std::lock_guard<std::mutex> g{lock};
+        REQUIRE((std::vector<string>{"1", "2"}) == batches[0].second);
+    }
+
+    SECTION("destructor") {
+        {
+            coalescing_publisher pub{cli, 0, seconds(10)};
+            pub.publish("a", "1");
+        }
+        std::lock_guard<std::mutex> g{lock};
+        REQUIRE(1 == batches.size());
+    }
+}
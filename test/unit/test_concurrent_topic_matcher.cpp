@@ -0,0 +1,123 @@
+// test_concurrent_topic_matcher.cpp
+//
+// Unit tests for the concurrent_topic_matcher class in the Paho MQTT C++
+// library.
+//
+
+/*******************************************************************************
+ * Copyright (c) 2025 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+#define UNIT_TESTS
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "catch2_version.h"
+#include "mqtt/concurrent_topic_matcher.h"
+
+using namespace mqtt;
+
+/////////////////////////////////////////////////////////////////////////////
+
+TEST_CASE("concurrent matcher insert/remove", "[topic_matcher]")
+{
+    concurrent_topic_matcher<int> tm{{"some/#", 99}};
+    REQUIRE(!tm.empty());
+
+    auto snap = tm.snapshot();
+
+    tm.insert({"some/random/topic", 42});
+    REQUIRE(tm.has_match("some/random/topic"));
+
+    int sum = 0;
+    tm.for_each_match("some/random/topic", [&sum](const auto& val) { sum += val.second; });
+    REQUIRE(99 + 42 == sum);
+
+    // The old snapshot doesn't see the change
+    sum = 0;
+    snap->for_each_match("some/random/topic", [&sum](const auto& val) { sum += val.second; });
+    REQUIRE(99 == sum);
+
+    auto val = tm.remove("some/#");
+    REQUIRE(val);
+    REQUIRE(99 == *val);
+    REQUIRE(!tm.has_match("some/other"));
+    REQUIRE(snap->has_match("some/other"));
+
+    tm.update([](topic_matcher<int>& m) {
+        m.insert({"a/b", 1});
+        m.insert({"a/+", 2});
+    });
+    REQUIRE(tm.has_match("a/b"));
+    REQUIRE(tm.has_match("a/c"));
+    REQUIRE(tm.has_match("some/random/topic"));
+}
+
+TEST_CASE("concurrent matcher exchange", "[topic_matcher]")
+{
+    concurrent_topic_matcher<int> tm{{"old/#", 1}};
+    auto snap = tm.snapshot();
+
+    topic_matcher<int> next;
+    next.insert({"new/+", 2});
+    next.insert({"new/a/#", 3});
+
+    auto old = tm.exchange(std::move(next));
+    REQUIRE(old == snap);
+    REQUIRE(old->has_match("old/x"));
+
+    REQUIRE(!tm.has_match("old/x"));
+    REQUIRE(tm.has_match("new/a"));
+    REQUIRE(tm.has_match("new/a/b/c"));
+
+    // Later updates start from the new collection
+    tm.insert({"more/#", 4});
+    REQUIRE(tm.has_match("new/a"));
+    REQUIRE(tm.has_match("more/x"));
+}
+
+TEST_CASE("concurrent matcher threads", "[topic_matcher]")
+{
+    const int N = 100;
+    concurrent_topic_matcher<int> tm{{"data/#", -1}};
+
+    std::atomic<bool> done{false};
+    std::atomic<int> nFail{0};
+
+    // Readers should always see the wildcard, whatever else is added
+    std::vector<std::thread> readers;
+    for (int i = 0; i < 4; ++i) {
+        readers.emplace_back([&] {
+            while (!done) {
+                if (!tm.has_match("data/7"))
+                    ++nFail;
+            }
+        });
+    }
+
+    for (int i = 0; i < N; ++i) tm.insert({"data/" + std::to_string(i), i});
+
+    done = true;
+    for (auto& thr : readers) thr.join();
+
+    REQUIRE(0 == nFail);
+
+    int n = 0;
+    tm.for_each_match("data/7", [&n](const auto&) { ++n; });
+    REQUIRE(2 == n);
+}
@@ -0,0 +1,157 @@
+// test_conflating_queue.cpp
+//
+// Unit tests for the conflating_queue class in the Paho MQTT C++ library.
+//
+
+/*******************************************************************************
+ * Copyright (c) 2025 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - Initial implementation
+ *******************************************************************************/
+
+#define UNIT_TESTS
+
+#include <chrono>
+#include <future>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "catch2_version.h"
+#include "mqtt/conflating_queue.h"
+#include "mqtt/consumer_queue.h"
+#include "mqtt/types.h"
+
+using namespace mqtt;
+using namespace std::chrono;
+
+// Items are (key, value) pairs, keyed by the first string
+using item = std::pair<std::string, int>;
+
+static std::string_view key_of(const item& it) { return it.first; }
+
+TEST_CASE("conflating_queue replaces in place", "[conflating_queue]")
+{
+    conflating_queue<item> que{key_of};
+
+    que.put({"a", 1});
+    que.put({"b", 1});
+    que.put({"a", 2});
+    que.put({"a", 3});
+    que.put({"c", 1});
+
+    REQUIRE(3 == que.size());
+    REQUIRE(2 == que.conflated());
+
+    auto v = que.get_all();
+    REQUIRE(3 == v.size());
+    REQUIRE(item{"a", 3} == v[0]);
+    REQUIRE(item{"b", 1} == v[1]);
+    REQUIRE(item{"c", 1} == v[2]);
+
+    // Once removed, the key starts again at the back
+    que.put({"b", 2});
+    que.put({"a", 4});
+    que.put({"b", 3});
+
+    REQUIRE(item{"b", 3} == que.get());
+    REQUIRE(item{"a", 4} == que.get());
+    REQUIRE(que.empty());
+}
+
+TEST_CASE("conflating_queue empty key", "[conflating_queue]")
+{
+    conflating_queue<item> que{key_of};
+
+    que.put({"", 1});
+    que.put({"", 2});
+    que.put({"a", 1});
+    que.put({"a", 2});
+
+    REQUIRE(3 == que.size());
+    REQUIRE(item{"", 1} == que.get());
+    REQUIRE(item{"", 2} == que.get());
+    REQUIRE(item{"a", 2} == que.get());
+}
+
+TEST_CASE("conflating_queue capacity", "[conflating_queue]")
+{
+    conflating_queue<item> que{key_of, 2};
+
+    REQUIRE(que.try_put({"a", 1}));
+    REQUIRE(que.try_put({"b", 1}));
+
+    // Full, so a new key is refused, but a waiting one is replaced
+    REQUIRE(!que.try_put({"c", 1}));
+    REQUIRE(!que.try_put_for({"c", 1}, 5ms));
+    REQUIRE(que.try_put({"b", 2}));
+    que.put({"a", 2});
+    REQUIRE(2 == que.size());
+
+    auto fut = std::async(std::launch::async, [&que] {
+        std::this_thread::sleep_for(10ms);
+        que.get();
+    });
+
+    REQUIRE(que.try_put_for({"c", 1}, 500ms));
+    fut.wait();
+
+    REQUIRE(item{"b", 2} == que.get());
+    REQUIRE(item{"c", 1} == que.get());
+}
+
+TEST_CASE("conflating_queue close", "[conflating_queue]")
+{
+    conflating_queue<item> que{key_of};
+    que.put({"a", 1});
+    que.close();
+
+    REQUIRE(!que.try_put({"a", 2}));
+    REQUIRE_THROWS_AS(que.put({"b", 1}), queue_closed);
+
+    REQUIRE(!que.done());
+    REQUIRE(item{"a", 1} == que.get());
+    REQUIRE(que.done());
+
+    item it;
+    REQUIRE(!que.get(&it));
+}
+
+TEST_CASE("conflating_consumer_queue by topic", "[conflating_queue]")
+{
+    auto byTopic = conflate_by_topic();
+    REQUIRE("a/b" == byTopic(event{make_message("a/b", "x")}));
+    REQUIRE(byTopic(event{connection_lost_event{}}).empty());
+
+    conflating_consumer_queue que{byTopic};
+    REQUIRE(!que.can_meter());
+
+    que.put(event{make_message("temp", "20")});
+    que.put(event{make_message("humidity", "50")});
+    que.put(event{connection_lost_event{}});
+    que.put(event{make_message("temp", "21")});
+    que.put(event{make_message("temp", "22")});
+
+    REQUIRE(3 == que.size());
+
+    auto evt = que.get();
+    REQUIRE(evt.is_message());
+    REQUIRE("temp" == evt.get_message()->get_topic());
+    REQUIRE("22" == evt.get_message()->to_string());
+
+    evt = que.get();
+    REQUIRE("humidity" == evt.get_message()->get_topic());
+    REQUIRE(que.get().is_connection_lost());
+}
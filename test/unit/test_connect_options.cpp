@@ -645,6 +645,23 @@ TEST_CASE("connect_options_builder set", "[options]")
     REQUIRE(nullptr != copts.connectProperties);
 }
 
+TEST_CASE("connect_options_builder reconnect backoff", "[options]")
+{
+    auto backoff = reconnect_backoff::create(milliseconds{100}, seconds{30});
+
+    auto opts = connect_options_builder().reconnect_backoff(backoff).finalize();
+    REQUIRE(backoff == opts.get_reconnect_backoff());
+
+    connect_options optsCopy{opts};
+    REQUIRE(backoff == optsCopy.get_reconnect_backoff());
+
+    connect_options optsMove{std::move(optsCopy)};
+    REQUIRE(backoff == optsMove.get_reconnect_backoff());
+
+    opts.set_reconnect_backoff(nullptr);
+    REQUIRE(!opts.get_reconnect_backoff());
+}
+
 // ----------------------------------------------------------------------
 // Test the builder's copy assignment operator=(const&)
 // ----------------------------------------------------------------------
@@ -0,0 +1,84 @@
+// test_consumer_group.cpp
+//
+// Unit tests for the consumer_group class in the Paho MQTT C++ library.
+//
+
+/*******************************************************************************
+ * Copyright (c) 2025 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - Initial implementation
+ *******************************************************************************/
+
+#define UNIT_TESTS
+
+#include <string>
+
+#include "catch2_version.h"
+#include "mqtt/consumer_group.h"
+
+using namespace mqtt;
+
+static const std::string SERVER_URI{"tcp://localhost:1883"};
+static const std::string CLIENT_ID{"test_consumer_group"};
+static const std::string GROUP{"workers"};
+
+static void handle_message(const_message_ptr) {}
+
+/////////////////////////////////////////////////////////////////////////////
+
+TEST_CASE("consumer_group share filter", "[consumer_group]")
+{
+    REQUIRE("$share/workers/data/#" == consumer_group::share_filter(GROUP, "data/#"));
+    REQUIRE("$share/g/a/+/b" == consumer_group::share_filter("g", "a/+/b"));
+}
+
+TEST_CASE("consumer_group constructor", "[consumer_group]")
+{
+    consumer_group grp{create_options{SERVER_URI, CLIENT_ID}, GROUP, handle_message, 3, 2};
+
+    REQUIRE(GROUP == grp.get_group());
+    REQUIRE(3 == grp.num_connections());
+    REQUIRE(2 == grp.num_workers());
+    REQUIRE(!grp.is_connected());
+
+    for (size_t i = 0; i < grp.num_connections(); ++i)
+        REQUIRE(CLIENT_ID + "-" + std::to_string(i) == grp.get_client(i).get_client_id());
+
+    REQUIRE_THROWS_AS(
+        consumer_group(create_options{SERVER_URI, CLIENT_ID}, GROUP, handle_message, 0),
+        std::invalid_argument
+    );
+}
+
+TEST_CASE("consumer_group subscribe disconnected", "[consumer_group]")
+{
+    consumer_group grp{create_options{SERVER_URI, CLIENT_ID}, GROUP, handle_message, 2, 1};
+
+    // The subscription is kept for when the connections come up
+    REQUIRE_NOTHROW(grp.subscribe("data/#", 1));
+    REQUIRE_NOTHROW(grp.subscribe("cmd/+", 2, subscribe_options{subscribe_options::NO_LOCAL}));
+}
+
+TEST_CASE("consumer_group stats", "[consumer_group]")
+{
+    consumer_group grp{create_options{SERVER_URI, CLIENT_ID}, GROUP, handle_message, 2, 1};
+
+    auto stats = grp.get_stats();
+    REQUIRE(0 == stats.msgsReceived);
+    REQUIRE(0 == stats.bytesReceived);
+    REQUIRE(0 == stats.msgsHandled);
+    REQUIRE(0 == stats.lag);
+    REQUIRE(0 == stats.connected);
+    REQUIRE(0 == stats.reconnects);
+    REQUIRE(stats.handledRate == 0.0);
+}
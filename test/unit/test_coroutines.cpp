@@ -0,0 +1,171 @@
+// test_coroutines.cpp
+//
+//  Unit tests for the C++20 coroutine support in the Paho MQTT C++ library.
+//
+
+/*******************************************************************************
+ * Copyright (c) 2025 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation
+ *******************************************************************************/
+
+#define UNIT_TESTS
+
+#include "catch2_version.h"
+#include "mock_async_client.h"
+#include "mqtt/async_client.h"
+
+#if defined(PAHO_MQTTPP_COROUTINES)
+
+    #include <coroutine>
+    #include <exception>
+    #include <utility>
+    #include <vector>
+
+using namespace mqtt;
+
+static const std::string GOOD_SERVER_URI{"mqtt://localhost:1883"};
+static const std::string CLIENT_ID{"test_coroutines"};
+
+static mock_async_client mock_cli;
+
+// A coroutine that starts right away and is never awaited itself. It
+// keeps its frame to the end, so an exception can be checked.
+struct task
+{
+    struct promise_type
+    {
+        std::exception_ptr eptr;
+
+        task get_return_object() {
+            return task{std::coroutine_handle<promise_type>::from_promise(*this)};
+        }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_always final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { eptr = std::current_exception(); }
+    };
+
+    std::coroutine_handle<promise_type> h;
+
+    explicit task(std::coroutine_handle<promise_type> hd) : h{hd} {}
+    task(task&& other) noexcept : h{std::exchange(other.h, nullptr)} {}
+    ~task() {
+        if (h)
+            h.destroy();
+    }
+
+    bool done() const { return h.done(); }
+    std::exception_ptr exception() const { return h.promise().eptr; }
+};
+
+static task await_token(token_ptr tok, token_ptr* result)
+{
+    *result = co_await tok;
+}
+
+static task await_token_rc(token_ptr tok, int* rc)
+{
+    try {
+        co_await tok;
+        *rc = MQTTASYNC_SUCCESS;
+    }
+    catch (const exception& exc) {
+        *rc = exc.get_return_code();
+    }
+}
+
+// --------------------------------------------------------------------------
+
+TEST_CASE("co_await token resumes on completion", "[coroutine]")
+{
+    auto tok = token::create(token::Type::CONNECT, mock_cli);
+    token_ptr result;
+
+    auto t = await_token(tok, &result);
+    REQUIRE(!t.done());
+    REQUIRE(!result);
+
+    mock_async_client::succeed(tok.get(), nullptr);
+    REQUIRE(t.done());
+    REQUIRE(tok == result);
+    REQUIRE(!t.exception());
+}
+
+TEST_CASE("co_await token throws on failure", "[coroutine]")
+{
+    const int RC = MQTTASYNC_DISCONNECTED;
+    auto tok = token::create(token::Type::SUBSCRIBE, mock_cli);
+    int rc = MQTTASYNC_SUCCESS;
+
+    auto t = await_token_rc(tok, &rc);
+    REQUIRE(!t.done());
+
+    MQTTAsync_failureData rsp{};
+    rsp.code = RC;
+    mock_async_client::fail(tok.get(), &rsp);
+
+    REQUIRE(t.done());
+    REQUIRE(RC == rc);
+}
+
+TEST_CASE("co_await token already complete", "[coroutine]")
+{
+    auto tok = token::create(token::Type::CONNECT, mock_cli);
+    mock_async_client::succeed(tok.get(), nullptr);
+
+    // It's ready, so the coroutine runs straight through
+    token_ptr result;
+    auto t = await_token(tok, &result);
+    REQUIRE(t.done());
+    REQUIRE(tok == result);
+}
+
+TEST_CASE("async_consume", "[coroutine]")
+{
+    async_client cli{
+        create_options_builder().server_uri(GOOD_SERVER_URI).client_id(CLIENT_ID).loopback().finalize()
+    };
+    cli.start_consuming();
+    cli.connect()->wait();
+
+    std::vector<const_message_ptr> msgs;
+    bool closed = false;
+
+    auto consume = [](async_client& cli, std::vector<const_message_ptr>* msgs,
+                      bool* closed) -> task {
+        while (auto msg = co_await cli.async_consume()) msgs->push_back(std::move(msg));
+        *closed = true;
+    };
+
+    // Nothing is here yet, other than the connected event, which is skipped
+    auto t = consume(cli, &msgs, &closed);
+    REQUIRE(!t.done());
+    REQUIRE(msgs.empty());
+
+    cli.publish("hello", "one", 3, 0, false);
+    REQUIRE(1 == msgs.size());
+    REQUIRE("one" == msgs[0]->get_payload_str());
+
+    cli.publish("hello", "two", 3, 0, false);
+    REQUIRE(2 == msgs.size());
+    REQUIRE(!t.done());
+
+    // Closing the queue ends the loop with an empty message
+    cli.stop_consuming();
+    REQUIRE(closed);
+    REQUIRE(t.done());
+    REQUIRE(!t.exception());
+}
+
+#endif  // PAHO_MQTTPP_COROUTINES
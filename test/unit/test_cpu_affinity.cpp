@@ -0,0 +1,90 @@
+// test_cpu_affinity.cpp
+//
+// Unit tests for the cpu_set class in the Paho MQTT C++ library.
+//
+
+/*******************************************************************************
+ * Copyright (c) 2025 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - Initial implementation
+ *******************************************************************************/
+
+#define UNIT_TESTS
+
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+
+#include "catch2_version.h"
+#include "mqtt/cpu_affinity.h"
+
+#if defined(__linux__)
+    #include <sched.h>
+#endif
+
+using namespace mqtt;
+
+/////////////////////////////////////////////////////////////////////////////
+
+TEST_CASE("cpu_set constructors", "[affinity]")
+{
+    cpu_set empty;
+    REQUIRE(empty.empty());
+    REQUIRE(0 == empty.size());
+
+    cpu_set set{5, 1, 3, 1};
+    REQUIRE(3 == set.size());
+    REQUIRE((std::vector<unsigned>{1, 3, 5}) == set.cpus());
+    REQUIRE(set.contains(3));
+    REQUIRE(!set.contains(2));
+
+    // Indexing wraps around
+    REQUIRE(1 == set[0]);
+    REQUIRE(5 == set[2]);
+    REQUIRE(1 == set[3]);
+
+    set.add(2);
+    REQUIRE(set.contains(2));
+    REQUIRE(4 == set.size());
+
+    REQUIRE(cpu_set{0, 1, 2, 3} == cpu_set::range(0, 3));
+    REQUIRE(cpu_set::range(3, 2).empty());
+}
+
+TEST_CASE("cpu_set parse", "[affinity]")
+{
+    REQUIRE(cpu_set{0, 1, 2, 3, 8, 10, 11} == cpu_set::parse("0-3,8,10-11"));
+    REQUIRE(cpu_set{7} == cpu_set::parse("7\n"));
+    REQUIRE(cpu_set::parse("").empty());
+
+    REQUIRE_THROWS_AS(cpu_set::parse("a-b"), std::invalid_argument);
+    REQUIRE_THROWS_AS(cpu_set::parse("4-2"), std::invalid_argument);
+    REQUIRE_THROWS_AS(cpu_set::parse("1,,2"), std::invalid_argument);
+}
+
+TEST_CASE("cpu_set pin", "[affinity]")
+{
+    std::thread none;
+    REQUIRE(!cpu_set{}.pin_current_thread());
+    REQUIRE(!cpu_set{0}.pin(none));
+
+#if defined(__linux__)
+    // The CPU this is running on is always allowed
+    int cpu = ::sched_getcpu();
+    if (cpu >= 0) {
+        std::thread thr{[] { std::this_thread::sleep_for(std::chrono::milliseconds{10}); }};
+        REQUIRE(cpu_set{unsigned(cpu)}.pin(thr));
+        thr.join();
+    }
+#endif
+}
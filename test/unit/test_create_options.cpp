@@ -22,9 +22,12 @@
 #define UNIT_TESTS
 
 #include <cstring>
+#include <memory>
+#include <memory_resource>
 
 #include "catch2_version.h"
 #include "mock_async_client.h"
+#include "mqtt/async_client.h"
 #include "mqtt/create_options.h"
 
 using namespace mqtt;
@@ -42,6 +45,11 @@ TEST_CASE("create_options default ctor", "[options]")
 
     REQUIRE(opts.get_restore_messages());
     REQUIRE(opts.get_persist_qos0());
+    REQUIRE(!opts.get_zero_copy_payloads());
+    REQUIRE(0 == opts.get_message_pool_size());
+    REQUIRE(0 == opts.get_max_interned_topics());
+    REQUIRE(0 == opts.get_max_pending_messages());
+    REQUIRE(0 == opts.get_max_pending_bytes());
 }
 
 /////////////////////////////////////////////////////////////////////////////
@@ -61,6 +69,11 @@ TEST_CASE("create_options_builder default ctor", "[options]")
 
     REQUIRE(opts.get_restore_messages());
     REQUIRE(opts.get_persist_qos0());
+    REQUIRE(!opts.get_zero_copy_payloads());
+    REQUIRE(0 == opts.get_message_pool_size());
+    REQUIRE(0 == opts.get_max_interned_topics());
+    REQUIRE(0 == opts.get_max_pending_messages());
+    REQUIRE(0 == opts.get_max_pending_bytes());
 }
 
 TEST_CASE("create_options_builder sets", "[options]")
@@ -75,3 +88,487 @@ TEST_CASE("create_options_builder sets", "[options]")
     REQUIRE(opts.get_restore_messages());
     REQUIRE(opts.get_persist_qos0());
 }
+
+TEST_CASE("create_options_builder zero copy", "[options]")
+{
+    const auto opts = create_options_builder().zero_copy_payloads().finalize();
+    REQUIRE(opts.get_zero_copy_payloads());
+
+    // Survives a copy
+    create_options opts2{opts};
+    REQUIRE(opts2.get_zero_copy_payloads());
+
+    create_options opts3;
+    opts3 = opts2;
+    REQUIRE(opts3.get_zero_copy_payloads());
+
+    opts3.set_zero_copy_payloads(false);
+    REQUIRE(!opts3.get_zero_copy_payloads());
+}
+
+TEST_CASE("create_options_builder memory resource", "[options]")
+{
+    REQUIRE(!create_options{}.get_memory_resource());
+
+    std::pmr::monotonic_buffer_resource mr;
+    const auto opts = create_options_builder().memory_resource(&mr).finalize();
+    REQUIRE(&mr == opts.get_memory_resource());
+
+    create_options opts2;
+    opts2 = opts;
+    REQUIRE(&mr == opts2.get_memory_resource());
+}
+
+TEST_CASE("create_options_builder message pool", "[options]")
+{
+    const auto opts = create_options_builder().message_pool_size(64).finalize();
+    REQUIRE(64 == opts.get_message_pool_size());
+
+    // Survives a copy
+    create_options opts2{opts};
+    REQUIRE(64 == opts2.get_message_pool_size());
+
+    create_options opts3;
+    opts3 = opts2;
+    REQUIRE(64 == opts3.get_message_pool_size());
+
+    opts3.set_message_pool_size(0);
+    REQUIRE(0 == opts3.get_message_pool_size());
+}
+
+TEST_CASE("create_options_builder token pool", "[options]")
+{
+    REQUIRE(0 == create_options{}.get_token_pool_size());
+
+    const auto opts = create_options_builder().token_pool_size(256).finalize();
+    REQUIRE(256 == opts.get_token_pool_size());
+
+    // Survives a copy
+    create_options opts2{opts};
+    REQUIRE(256 == opts2.get_token_pool_size());
+
+    create_options opts3;
+    opts3 = opts2;
+    REQUIRE(256 == opts3.get_token_pool_size());
+
+    // The client creates its tokens from the pool. Since it's not
+    // connected, they're released again right away when the publish fails.
+    async_client cli{
+        create_options_builder().server_uri("tcp://localhost:1883").token_pool_size(16).finalize()
+    };
+
+    for (int i = 0; i < 4; ++i)
+        REQUIRE_THROWS_AS(cli.publish("topic", "payload", 7, 1, false), mqtt::exception);
+    REQUIRE(cli.get_pending_delivery_tokens().empty());
+}
+
+TEST_CASE("create_options_builder topic aliases", "[options]")
+{
+    REQUIRE(0 == create_options{}.get_max_topic_aliases());
+
+    const auto opts = create_options_builder().max_topic_aliases(64).finalize();
+    REQUIRE(64 == opts.get_max_topic_aliases());
+
+    // Survives a copy
+    create_options opts2{opts};
+    REQUIRE(64 == opts2.get_max_topic_aliases());
+
+    create_options opts3;
+    opts3 = opts2;
+    REQUIRE(64 == opts3.get_max_topic_aliases());
+
+    // Not connected, so the messages fail as usual
+    async_client cli{create_options_builder()
+                         .server_uri("tcp://localhost:1883")
+                         .mqtt_version(MQTTVERSION_5)
+                         .max_topic_aliases(16)
+                         .finalize()};
+
+    REQUIRE(MQTTASYNC_DISCONNECTED == cli.publish_nowait("topic", "payload", 7));
+    REQUIRE_THROWS_AS(cli.publish("topic", "payload", 7, 0, false), mqtt::exception);
+}
+
+TEST_CASE("create_options_builder flow control", "[options]")
+{
+    REQUIRE(!create_options{}.get_flow_control());
+
+    const auto opts = create_options_builder().flow_control().finalize();
+    REQUIRE(opts.get_flow_control());
+
+    // Survives a copy
+    create_options opts2{opts};
+    REQUIRE(opts2.get_flow_control());
+
+    create_options opts3;
+    opts3 = opts2;
+    REQUIRE(opts3.get_flow_control());
+
+    // Not connected, so a message fails, and gives back its slot
+    async_client cli{create_options_builder()
+                         .server_uri("tcp://localhost:1883")
+                         .mqtt_version(MQTTVERSION_5)
+                         .flow_control()
+                         .finalize()};
+
+    REQUIRE_THROWS_AS(cli.publish("topic", "payload", 7, 1, false), mqtt::exception);
+
+    auto st = cli.get_stats();
+    REQUIRE(0 == st.msgsInFlight);
+    REQUIRE(0 == st.msgsDeferred);
+    REQUIRE(0 == st.pendingDeliveryTokens);
+}
+
+TEST_CASE("create_options_builder offline buffer", "[options]")
+{
+    REQUIRE(!create_options{}.get_offline_buffer());
+
+    auto buf = offline_buffer::create(16);
+    const auto opts = create_options_builder()
+                          .server_uri("tcp://localhost:1883")
+                          .offline_buffer(buf)
+                          .finalize();
+    REQUIRE(buf == opts.get_offline_buffer());
+
+    // Survives a copy
+    create_options opts2{opts};
+    REQUIRE(buf == opts2.get_offline_buffer());
+
+    // Not connected, so messages go into the buffer until it's full
+    async_client cli{opts};
+
+    // The token waits for the message to be sent from the buffer
+    auto tok = cli.publish("topic", "payload", 7, 1, false);
+    REQUIRE(!tok->is_complete());
+
+    auto st = cli.get_stats();
+    REQUIRE(1 == st.offlineBuffered);
+    REQUIRE(12 == st.offlineBufferBytes);
+    REQUIRE(0 == st.offlineSpilled);
+    REQUIRE(0 == st.msgsPublished);
+
+    int rc = MQTTASYNC_SUCCESS;
+    try {
+        cli.publish("topic", "payload", 7, 1, false);
+    }
+    catch (const mqtt::exception& ex) {
+        rc = ex.get_return_code();
+    }
+    REQUIRE(MQTTASYNC_MAX_BUFFERED_MESSAGES == rc);
+    REQUIRE(1 == buf->size());
+}
+
+TEST_CASE("create_options_builder library affinity", "[options]")
+{
+    REQUIRE(create_options{}.get_library_affinity().empty());
+
+    const auto opts = create_options_builder().library_affinity(cpu_set{0, 1}).finalize();
+    REQUIRE(cpu_set{0, 1} == opts.get_library_affinity());
+
+    // Survives a copy
+    create_options opts2{opts};
+    REQUIRE(cpu_set{0, 1} == opts2.get_library_affinity());
+
+    create_options opts3;
+    opts3 = opts2;
+    REQUIRE(cpu_set{0, 1} == opts3.get_library_affinity());
+}
+
+TEST_CASE("create_options_builder retained cache", "[options]")
+{
+    REQUIRE(!create_options{}.get_retained_cache());
+
+    auto cache = retained_cache::create();
+    const auto opts = create_options_builder().retained_cache(cache).finalize();
+    REQUIRE(cache == opts.get_retained_cache());
+
+    // Survives a copy, sharing the cache
+    create_options opts2{opts};
+    REQUIRE(cache == opts2.get_retained_cache());
+
+    create_options opts3;
+    opts3 = opts2;
+    REQUIRE(cache == opts3.get_retained_cache());
+}
+
+TEST_CASE("create_options_builder publish shaper", "[options]")
+{
+    REQUIRE(!create_options{}.get_publish_shaper());
+
+    auto shaper = publish_shaper::create();
+    const auto opts = create_options_builder().publish_shaper(shaper).finalize();
+    REQUIRE(shaper == opts.get_publish_shaper());
+
+    // Survives a copy, sharing the shaper
+    create_options opts2{opts};
+    REQUIRE(shaper == opts2.get_publish_shaper());
+
+    create_options opts3;
+    opts3 = std::move(opts2);
+    REQUIRE(shaper == opts3.get_publish_shaper());
+}
+
+TEST_CASE("create_options_builder dedup filter", "[options]")
+{
+    REQUIRE(!create_options{}.get_dedup_filter());
+
+    auto filt = dedup_filter::create();
+    const auto opts = create_options_builder()
+                          .server_uri("tcp://localhost:1883")
+                          .dedup_filter(filt)
+                          .finalize();
+    REQUIRE(filt == opts.get_dedup_filter());
+
+    create_options opts2{opts};
+    REQUIRE(filt == opts2.get_dedup_filter());
+
+    async_client cli{opts2};
+    REQUIRE(filt == cli.get_dedup_filter());
+    REQUIRE(0 == cli.get_stats().msgsDuplicated);
+}
+
+TEST_CASE("create_options_builder chunk reassembler", "[options]")
+{
+    REQUIRE(!create_options{}.get_chunk_reassembler());
+
+    auto ra = chunk_reassembler::create(1024 * 1024);
+    const auto opts = create_options_builder()
+                          .server_uri("tcp://localhost:1883")
+                          .chunk_reassembler(ra)
+                          .finalize();
+    REQUIRE(ra == opts.get_chunk_reassembler());
+
+    async_client cli{opts};
+    REQUIRE(ra == cli.get_chunk_reassembler());
+}
+
+TEST_CASE("create_options_builder sequence tracker", "[options]")
+{
+    REQUIRE(!create_options{}.get_sequence_tracker());
+
+    auto trk = sequence_tracker::create("msg-seq");
+    const auto opts = create_options_builder()
+                          .server_uri("tcp://localhost:1883")
+                          .sequence_tracker(trk)
+                          .finalize();
+    REQUIRE(trk == opts.get_sequence_tracker());
+
+    async_client cli{opts};
+    REQUIRE(trk == cli.get_sequence_tracker());
+
+    trk->check("a", 1);
+    trk->check("a", 3);
+    REQUIRE(1 == cli.get_stats().seqGaps);
+}
+
+TEST_CASE("create_options_builder message sampler", "[options]")
+{
+    REQUIRE(!create_options{}.get_message_sampler());
+
+    auto sampler = message_sampler::create();
+    const auto opts = create_options_builder()
+                          .server_uri("tcp://localhost:1883")
+                          .message_sampler(sampler)
+                          .finalize();
+    REQUIRE(sampler == opts.get_message_sampler());
+
+    create_options opts2{opts};
+    REQUIRE(sampler == opts2.get_message_sampler());
+
+    async_client cli{opts};
+    REQUIRE(sampler == cli.get_message_sampler());
+    REQUIRE(0 == cli.get_stats().msgsSampledOut);
+}
+
+TEST_CASE("create_options_builder topic stats", "[options]")
+{
+    REQUIRE(!create_options{}.get_topic_stats());
+
+    auto stats = topic_stats::create({"data/#"});
+    const auto opts = create_options_builder()
+                          .server_uri("tcp://localhost:1883")
+                          .topic_stats(stats)
+                          .finalize();
+    REQUIRE(stats == opts.get_topic_stats());
+
+    async_client cli{opts};
+    REQUIRE(stats == cli.get_topic_stats());
+    REQUIRE(1 == cli.get_stats().topicTraffic.size());
+    REQUIRE(async_client{"tcp://localhost:1883", ""}.get_stats().topicTraffic.empty());
+}
+
+TEST_CASE("create_options_builder max memory", "[options]")
+{
+    REQUIRE(0 == create_options{}.get_max_memory());
+
+    const auto opts = create_options_builder().max_memory(1024 * 1024).finalize();
+    REQUIRE(1024 * 1024 == opts.get_max_memory());
+
+    create_options opts2;
+    opts2 = opts;
+    REQUIRE(1024 * 1024 == opts2.get_max_memory());
+}
+
+TEST_CASE("create_options_builder restore subscriptions", "[options]")
+{
+    REQUIRE(!create_options{}.get_restore_subscriptions());
+
+    const auto opts = create_options_builder().restore_subscriptions().finalize();
+    REQUIRE(opts.get_restore_subscriptions());
+
+    create_options opts2;
+    opts2 = opts;
+    REQUIRE(opts2.get_restore_subscriptions());
+}
+
+TEST_CASE("create_options_builder loopback", "[options]")
+{
+    REQUIRE(!create_options{}.get_loopback());
+
+    const auto opts = create_options_builder().loopback().finalize();
+    REQUIRE(opts.get_loopback());
+
+    create_options opts2;
+    opts2 = opts;
+    REQUIRE(opts2.get_loopback());
+}
+
+TEST_CASE("create_options_builder manual ack", "[options]")
+{
+    REQUIRE(!create_options{}.get_manual_ack());
+    REQUIRE(0 == create_options{}.get_max_unacked());
+
+    const auto opts = create_options_builder().manual_ack(64).finalize();
+    REQUIRE(opts.get_manual_ack());
+    REQUIRE(64 == opts.get_max_unacked());
+
+    create_options opts2;
+    opts2 = opts;
+    REQUIRE(opts2.get_manual_ack());
+    REQUIRE(64 == opts2.get_max_unacked());
+}
+
+TEST_CASE("create_options_builder operation timeout", "[options]")
+{
+    REQUIRE(0 == create_options{}.get_operation_timeout().count());
+
+    const auto opts =
+        create_options_builder().operation_timeout(std::chrono::seconds(5)).finalize();
+    REQUIRE(std::chrono::milliseconds(5000) == opts.get_operation_timeout());
+
+    create_options opts2;
+    opts2 = opts;
+    REQUIRE(std::chrono::milliseconds(5000) == opts2.get_operation_timeout());
+}
+
+TEST_CASE("create_options_builder spin wait", "[options]")
+{
+    REQUIRE(!create_options{}.get_spin_wait().enabled());
+
+    const auto opts = create_options_builder().spin_wait(1000, 10).finalize();
+    REQUIRE(1000 == opts.get_spin_wait().spins());
+    REQUIRE(10 == opts.get_spin_wait().yields());
+
+    // Survives a copy
+    create_options opts2{opts};
+    REQUIRE(spin_wait{1000, 10} == opts2.get_spin_wait());
+
+    create_options opts3;
+    opts3 = opts2;
+    REQUIRE(spin_wait{1000, 10} == opts3.get_spin_wait());
+}
+
+TEST_CASE("create_options_builder interned topics", "[options]")
+{
+    const auto opts = create_options_builder().max_interned_topics(128).finalize();
+    REQUIRE(128 == opts.get_max_interned_topics());
+
+    // Survives a copy
+    create_options opts2{opts};
+    REQUIRE(128 == opts2.get_max_interned_topics());
+
+    create_options opts3;
+    opts3 = opts2;
+    REQUIRE(128 == opts3.get_max_interned_topics());
+
+    opts3.set_max_interned_topics(0);
+    REQUIRE(0 == opts3.get_max_interned_topics());
+}
+
+TEST_CASE("create_options_builder pending window", "[options]")
+{
+    const auto opts =
+        create_options_builder().max_pending_messages(100).max_pending_bytes(4096).finalize();
+    REQUIRE(100 == opts.get_max_pending_messages());
+    REQUIRE(4096 == opts.get_max_pending_bytes());
+
+    // Survives a copy
+    create_options opts2{opts};
+    REQUIRE(100 == opts2.get_max_pending_messages());
+    REQUIRE(4096 == opts2.get_max_pending_bytes());
+
+    create_options opts3;
+    opts3 = opts2;
+    REQUIRE(100 == opts3.get_max_pending_messages());
+    REQUIRE(4096 == opts3.get_max_pending_bytes());
+}
+
+// A trivial codec that reverses the payload
+class reverse_codec : public payload_codec
+{
+public:
+    string name() const override { return "reverse"; }
+    binary encode(std::string_view data) const override {
+        return binary{data.rbegin(), data.rend()};
+    }
+    binary decode(std::string_view data) const override {
+        return binary{data.rbegin(), data.rend()};
+    }
+};
+
+TEST_CASE("create_options_builder payload codec", "[options]")
+{
+    REQUIRE(!create_options{}.get_payload_codec());
+
+    auto codec = std::make_shared<reverse_codec>();
+
+    const auto opts = create_options_builder().payload_codec(codec, 256).finalize();
+    REQUIRE(codec == opts.get_payload_codec());
+    REQUIRE(256 == opts.get_payload_codec_threshold());
+    REQUIRE("cba" == opts.get_payload_codec()->encode("abc"));
+
+    // Survives a copy
+    create_options opts2{opts};
+    REQUIRE(codec == opts2.get_payload_codec());
+    REQUIRE(256 == opts2.get_payload_codec_threshold());
+
+    create_options opts3;
+    opts3 = opts2;
+    REQUIRE(codec == opts3.get_payload_codec());
+
+    opts3.set_payload_codec(nullptr);
+    REQUIRE(!opts3.get_payload_codec());
+    REQUIRE(0 == opts3.get_payload_codec_threshold());
+}
+
+TEST_CASE("create_options_builder overflow policy", "[options]")
+{
+    REQUIRE(overflow_policy::BLOCK == create_options{}.get_overflow_policy());
+
+    const auto opts =
+        create_options_builder().overflow_policy(overflow_policy::DROP_OLDEST).finalize();
+    REQUIRE(overflow_policy::DROP_OLDEST == opts.get_overflow_policy());
+
+    create_options opts2{opts};
+    REQUIRE(overflow_policy::DROP_OLDEST == opts2.get_overflow_policy());
+
+    opts2.set_overflow_policy(overflow_policy::DROP_QOS0);
+    REQUIRE(overflow_policy::DROP_QOS0 == opts2.get_overflow_policy());
+
+    // A client can be made with the policy
+    async_client cli{create_options_builder()
+                         .server_uri("mqtt://localhost:1883")
+                         .overflow_policy(overflow_policy::DROP_NEWEST)
+                         .finalize()};
+    cli.start_consuming(std::make_unique<lock_free_consumer_queue>(16));
+    REQUIRE(0 == cli.get_stats().msgsDropped);
+}
@@ -0,0 +1,121 @@
+// test_credential_provider.cpp
+//
+// Unit tests for the refreshing_credential_provider class in the Paho MQTT C++ library.
+//
+
+/*******************************************************************************
+ * Copyright (c) 2025 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+#define UNIT_TESTS
+
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+
+#include "catch2_version.h"
+#include "mqtt/credential_provider.h"
+
+using namespace std::chrono;
+using namespace mqtt;
+
+// Waits a while for a condition to become true
+template <typename Pred>
+static bool wait_until(Pred pred, milliseconds timeout = milliseconds(2000))
+{
+    auto end = steady_clock::now() + timeout;
+    while (!pred()) {
+        if (steady_clock::now() > end)
+            return false;
+        std::this_thread::sleep_for(milliseconds(1));
+    }
+    return true;
+}
+
+// --------------------------------------------------------------------------
+
+TEST_CASE("refreshing_credential_provider ctor", "[credentials]")
+{
+    std::atomic<int> n{0};
+    refreshing_credential_provider prov{[&n] {
+        return credentials{"user", "token-" + std::to_string(++n)};
+    }};
+
+    auto creds = prov.get_credentials();
+    REQUIRE(creds);
+    REQUIRE("user" == creds->userName);
+    REQUIRE("token-1" == creds->password);
+    REQUIRE(1 == prov.refreshes());
+    REQUIRE(0 == prov.failures());
+
+    // Credentials that don't expire are kept
+    std::this_thread::sleep_for(milliseconds(20));
+    REQUIRE(1 == n);
+
+    REQUIRE_THROWS_AS(
+        refreshing_credential_provider([]() -> credentials {
+            throw std::runtime_error("no auth server");
+        }),
+        std::runtime_error
+    );
+}
+
+TEST_CASE("refreshing_credential_provider refresh", "[credentials]")
+{
+    std::atomic<int> n{0};
+    refreshing_credential_provider prov{[&n] {
+        return credentials{"user", "token-" + std::to_string(++n)};
+    }};
+
+    prov.refresh();
+    REQUIRE(wait_until([&prov] { return prov.refreshes() == 2; }));
+    REQUIRE("token-2" == prov.get_credentials()->password);
+}
+
+TEST_CASE("refreshing_credential_provider expiry", "[credentials]")
+{
+    std::atomic<int> n{0};
+    refreshing_credential_provider prov{
+        [&n] {
+            ++n;
+            return credentials{"user", "token", credentials::clock::now() + milliseconds(60)};
+        },
+        milliseconds(50)
+    };
+
+    // Made again ahead of each expiry
+    REQUIRE(wait_until([&n] { return n >= 3; }));
+    REQUIRE(prov.get_credentials()->expires > credentials::clock::now() - milliseconds(60));
+}
+
+TEST_CASE("refreshing_credential_provider failure", "[credentials]")
+{
+    std::atomic<int> n{0};
+    refreshing_credential_provider prov{
+        [&n] {
+            if (++n > 1)
+                throw std::runtime_error("no auth server");
+            return credentials{"user", "token"};
+        },
+        seconds(60), milliseconds(5)
+    };
+
+    // The first credentials are kept, and minting is tried again
+    prov.refresh();
+    REQUIRE(wait_until([&prov] { return prov.failures() >= 2; }));
+    REQUIRE(1 == prov.refreshes());
+    REQUIRE("token" == prov.get_credentials()->password);
+}
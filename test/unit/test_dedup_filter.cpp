@@ -0,0 +1,107 @@
+// test_dedup_filter.cpp
+//
+// Unit tests for the dedup_filter class in the Paho MQTT C++ library.
+//
+
+/*******************************************************************************
+ * Copyright (c) 2025 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - Initial implementation
+ *******************************************************************************/
+
+#define UNIT_TESTS
+
+#include <chrono>
+#include <string>
+#include <thread>
+
+#include "catch2_version.h"
+#include "mqtt/dedup_filter.h"
+
+using namespace mqtt;
+using namespace std::chrono;
+
+/////////////////////////////////////////////////////////////////////////////
+
+static message_ptr with_id(const string& topic, const string& payload, const string& id)
+{
+    auto msg = make_message(topic, payload, 1, false);
+    msg->set_properties(properties{{property::USER_PROPERTY, "msg-id", id}});
+    return msg;
+}
+
+TEST_CASE("dedup_filter by payload", "[dedup]")
+{
+    dedup_filter filt;
+
+    REQUIRE(!filt.is_duplicate(*make_message("a", "1")));
+    REQUIRE(!filt.is_duplicate(*make_message("a", "2")));
+    REQUIRE(!filt.is_duplicate(*make_message("b", "1")));
+
+    REQUIRE(filt.is_duplicate(*make_message("a", "1")));
+    REQUIRE(filt.is_duplicate(*make_message("b", "1")));
+
+    REQUIRE(3 == filt.size());
+    REQUIRE(2 == filt.duplicates());
+
+    filt.clear();
+    REQUIRE(0 == filt.size());
+    REQUIRE(!filt.is_duplicate(*make_message("a", "1")));
+}
+
+TEST_CASE("dedup_filter by user property", "[dedup]")
+{
+    dedup_filter filt{16, dedup_filter::clock::duration::zero(),
+                      dedup_filter::by_user_property("msg-id")};
+
+    REQUIRE(!filt.is_duplicate(*with_id("a", "1", "x1")));
+    REQUIRE(!filt.is_duplicate(*with_id("a", "1", "x2")));
+    REQUIRE(filt.is_duplicate(*with_id("b", "2", "x1")));
+
+    // Without the property, a message is never checked
+    REQUIRE(!filt.is_duplicate(*make_message("a", "1")));
+    REQUIRE(!filt.is_duplicate(*make_message("a", "1")));
+    REQUIRE(2 == filt.size());
+}
+
+TEST_CASE("dedup_filter size window", "[dedup]")
+{
+    dedup_filter filt{2};
+    REQUIRE(2 == filt.max_size());
+
+    REQUIRE(!filt.is_duplicate_key(1));
+    REQUIRE(!filt.is_duplicate_key(2));
+    REQUIRE(!filt.is_duplicate_key(3));
+    REQUIRE(2 == filt.size());
+
+    // The oldest key was pushed out
+    REQUIRE(filt.is_duplicate_key(3));
+    REQUIRE(!filt.is_duplicate_key(1));
+
+    // Zero is never a duplicate
+    REQUIRE(!filt.is_duplicate_key(0));
+    REQUIRE(!filt.is_duplicate_key(0));
+}
+
+TEST_CASE("dedup_filter time window", "[dedup]")
+{
+    dedup_filter filt{16, milliseconds(20)};
+    REQUIRE(milliseconds(20) == filt.window());
+
+    REQUIRE(!filt.is_duplicate_key(1));
+    REQUIRE(filt.is_duplicate_key(1));
+
+    std::this_thread::sleep_for(milliseconds(50));
+    REQUIRE(!filt.is_duplicate_key(1));
+    REQUIRE(1 == filt.size());
+}
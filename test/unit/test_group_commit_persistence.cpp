@@ -0,0 +1,147 @@
+// test_group_commit_persistence.cpp
+//
+// Unit tests for the group_commit_persistence class in the Paho MQTT C++
+// library.
+//
+
+/*******************************************************************************
+ * Copyright (c) 2025 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+#define UNIT_TESTS
+
+#include <atomic>
+#include <map>
+#include <thread>
+
+#include "catch2_version.h"
+#include "mock_persistence.h"
+#include "mqtt/group_commit_persistence.h"
+
+using namespace mqtt;
+using namespace std::chrono;
+
+static const char* CLIENT_ID = "clientid";
+static const char* SERVER_URI = "serveruri";
+
+static const string KEY{"s-1"};
+static const string KEY2{"s-2"};
+
+static const string PAYLOAD{"some random data"};
+static const string PAYLOAD2{"some other random data"};
+
+// An in-memory store that counts the calls to it.
+class counting_persistence : public mock_persistence
+{
+public:
+    std::atomic<int> nput{0};
+    std::atomic<int> nsync{0};
+
+    void put(const std::string& key, const std::vector<mqtt::string_view>& bufs) override
+    {
+        ++nput;
+        mock_persistence::put(key, bufs);
+    }
+    void sync() override { ++nsync; }
+};
+
+// ----------------------------------------------------------------------
+
+TEST_CASE("group_commit_persistence commit", "[persistence]")
+{
+    auto store = std::make_shared<counting_persistence>();
+    group_commit_persistence per{store, seconds(10)};
+
+    REQUIRE_THROWS_AS(per.put(KEY, {string_view{PAYLOAD}}), persistence_exception);
+
+    per.open(CLIENT_ID, SERVER_URI);
+
+    per.put(KEY, {string_view{PAYLOAD}});
+    per.put(KEY2, {string_view{PAYLOAD2}});
+
+    // Visible right away, but not yet in the store
+    REQUIRE(per.contains_key(KEY));
+    REQUIRE(PAYLOAD == per.get(KEY));
+    REQUIRE(2 == per.keys().size());
+
+    // From the queue
+    size_t n = 0;
+    char* buf = per.get_buffer(KEY2, n);
+    REQUIRE(PAYLOAD2 == string(buf, n));
+    persistence_free(buf);
+    REQUIRE(!store->contains_key(KEY));
+
+    per.commit();
+    REQUIRE(2 == store->nput);
+    REQUIRE(1 == store->nsync);
+    REQUIRE(PAYLOAD == store->get(KEY));
+    REQUIRE(PAYLOAD2 == store->get(KEY2));
+
+    // From the store
+    buf = per.get_buffer(KEY2, n);
+    REQUIRE(PAYLOAD2 == string(buf, n));
+    persistence_free(buf);
+
+    per.remove(KEY);
+    REQUIRE(!per.contains_key(KEY));
+    REQUIRE_THROWS_AS(per.get(KEY), persistence_exception);
+    REQUIRE_THROWS_AS(per.remove(KEY), persistence_exception);
+    REQUIRE(1 == per.keys().size());
+
+    per.commit();
+    REQUIRE(!store->contains_key(KEY));
+    REQUIRE(2 == store->nsync);
+
+    per.close();
+}
+
+TEST_CASE("group_commit_persistence put remove", "[persistence]")
+{
+    auto store = std::make_shared<counting_persistence>();
+    group_commit_persistence per{store, seconds(10)};
+    per.open(CLIENT_ID, SERVER_URI);
+
+    // A message that completes within a batch never reaches the store
+    per.put(KEY, {string_view{PAYLOAD}});
+    per.remove(KEY);
+    per.commit();
+
+    REQUIRE(0 == store->nput);
+    REQUIRE(!store->contains_key(KEY));
+    REQUIRE(per.keys().empty());
+
+    per.close();
+}
+
+TEST_CASE("group_commit_persistence batch", "[persistence]")
+{
+    auto store = std::make_shared<counting_persistence>();
+    group_commit_persistence per{store, seconds(10), 4};
+    per.open(CLIENT_ID, SERVER_URI);
+
+    // Filling a batch commits it without waiting for the interval
+    for (int i = 0; i < 4; ++i) per.put("s-" + std::to_string(i), {string_view{PAYLOAD}});
+
+    for (int i = 0; i < 500 && store->nsync == 0; ++i)
+        std::this_thread::sleep_for(milliseconds(10));
+
+    REQUIRE(1 == store->nsync);
+    REQUIRE(4 == store->nput);
+
+    // Closing commits what's left
+    per.put(KEY, {string_view{PAYLOAD2}});
+    per.close();
+    REQUIRE(PAYLOAD2 == store->get(KEY));
+}
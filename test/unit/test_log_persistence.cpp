@@ -0,0 +1,165 @@
+// test_log_persistence.cpp
+//
+// Unit tests for the log_persistence class in the Paho MQTT C++ library.
+//
+
+/*******************************************************************************
+ * Copyright (c) 2025 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+#define UNIT_TESTS
+
+#include <cstdio>
+
+#include "catch2_version.h"
+#include "mqtt/exception.h"
+#include "mqtt/log_persistence.h"
+
+using namespace mqtt;
+
+static const string CLIENT_ID{"log_persist_test"};
+static const string SERVER_URI{"tcp://localhost:1883"};
+
+static const string KEY{"s-1"};
+static const string KEY2{"s-2"};
+
+static const string PAYLOAD{"some random data"};
+static const string PAYLOAD2{"some other random data"};
+
+// Makes sure that a test starts with no log file.
+static void remove_log()
+{
+    log_persistence per;
+    per.open(CLIENT_ID, SERVER_URI);
+    auto path = per.get_path();
+    per.close();
+    std::remove(path.c_str());
+}
+
+// ----------------------------------------------------------------------
+
+TEST_CASE("log_persistence put get remove", "[persistence]")
+{
+    remove_log();
+
+    log_persistence per;
+    per.open(CLIENT_ID, SERVER_URI);
+
+    REQUIRE(per.keys().empty());
+    REQUIRE(!per.contains_key(KEY));
+    REQUIRE_THROWS_AS(per.get(KEY), persistence_exception);
+    REQUIRE_THROWS_AS(per.remove(KEY), persistence_exception);
+
+    per.put(KEY, {string_view{"some "}, string_view{"random data"}});
+    per.put(KEY2, {string_view{PAYLOAD2}});
+
+    REQUIRE(per.contains_key(KEY));
+    REQUIRE(PAYLOAD == per.get(KEY));
+    REQUIRE(PAYLOAD2 == per.get(KEY2));
+    REQUIRE(2 == per.keys().size());
+
+    size_t n = 0;
+    char* buf = per.get_buffer(KEY2, n);
+    REQUIRE(PAYLOAD2 == string(buf, n));
+    persistence_free(buf);
+    REQUIRE_THROWS_AS(per.get_buffer("bad-key", n), persistence_exception);
+
+    per.remove(KEY);
+    REQUIRE(!per.contains_key(KEY));
+    REQUIRE(1 == per.keys().size());
+
+    per.clear();
+    REQUIRE(per.keys().empty());
+    REQUIRE(0 == per.get_log_size());
+
+    per.close();
+    std::remove(per.get_path().c_str());
+}
+
+TEST_CASE("log_persistence recover", "[persistence]")
+{
+    remove_log();
+    string path;
+
+    {
+        log_persistence per;
+        per.open(CLIENT_ID, SERVER_URI);
+        path = per.get_path();
+
+        per.put(KEY, {string_view{PAYLOAD}});
+        per.put(KEY2, {string_view{PAYLOAD}});
+        per.put(KEY2, {string_view{PAYLOAD2}});
+        per.remove(KEY);
+        per.put(KEY, {string_view{PAYLOAD2}});
+        per.remove(KEY);
+    }
+
+    log_persistence per;
+    per.open(CLIENT_ID, SERVER_URI);
+
+    REQUIRE(1 == per.keys().size());
+    REQUIRE(!per.contains_key(KEY));
+    REQUIRE(PAYLOAD2 == per.get(KEY2));
+    auto sz = per.get_log_size();
+    per.close();
+
+    // A partial record at the end, as after a crash, is discarded.
+    std::FILE* f = std::fopen(path.c_str(), "ab");
+    std::fwrite("P\x05\x00", 1, 3, f);
+    std::fclose(f);
+
+    per.open(CLIENT_ID, SERVER_URI);
+    REQUIRE(1 == per.keys().size());
+    REQUIRE(PAYLOAD2 == per.get(KEY2));
+    REQUIRE(sz >= per.get_log_size());
+
+    // ...and the log is still good for appending
+    per.put(KEY, {string_view{PAYLOAD}});
+    per.close();
+
+    per.open(CLIENT_ID, SERVER_URI);
+    REQUIRE(2 == per.keys().size());
+    REQUIRE(PAYLOAD == per.get(KEY));
+
+    per.close();
+    std::remove(path.c_str());
+}
+
+TEST_CASE("log_persistence compact", "[persistence]")
+{
+    remove_log();
+
+    log_persistence per{".", 1024};
+    per.open(CLIENT_ID, SERVER_URI);
+
+    // Only ever a couple of keys live, so the log should stay small.
+    for (int i = 0; i < 1000; ++i) {
+        auto key = "s-" + std::to_string(i);
+        per.put(key, {string_view{PAYLOAD}});
+        if (i > 0)
+            per.remove("s-" + std::to_string(i - 1));
+    }
+
+    REQUIRE(1 == per.keys().size());
+    REQUIRE(per.get_log_size() < 1024);
+    per.close();
+
+    per.open(CLIENT_ID, SERVER_URI);
+    REQUIRE(1 == per.keys().size());
+    REQUIRE(PAYLOAD == per.get("s-999"));
+
+    per.close();
+    std::remove(per.get_path().c_str());
+}
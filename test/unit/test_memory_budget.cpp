@@ -0,0 +1,149 @@
+// test_memory_budget.cpp
+//
+// Unit tests for the memory_budget class in the Paho MQTT C++ library.
+//
+
+/*******************************************************************************
+ * Copyright (c) 2025 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+#define UNIT_TESTS
+
+#include <chrono>
+#include <thread>
+
+#include "catch2_version.h"
+#include "mqtt/consumer_queue.h"
+#include "mqtt/memory_budget.h"
+#include "mqtt/message.h"
+
+using namespace std::chrono;
+using namespace mqtt;
+
+// --------------------------------------------------------------------------
+
+TEST_CASE("memory_budget ctor", "[memory]")
+{
+    memory_budget budget{1024};
+    REQUIRE(1024 == budget.limit());
+    REQUIRE(0 == budget.used());
+    REQUIRE(0 == budget.high_water());
+}
+
+TEST_CASE("memory_budget charge and release", "[memory]")
+{
+    memory_budget budget{100};
+
+    budget.charge(60);
+    REQUIRE(budget.has_room(40));
+    REQUIRE(!budget.has_room(41));
+
+    budget.charge(60);
+    REQUIRE(120 == budget.used());
+    REQUIRE(!budget.has_room(1));
+
+    budget.release(100);
+    REQUIRE(20 == budget.used());
+    REQUIRE(120 == budget.high_water());
+
+    // A release of more than was charged stops at zero
+    budget.release(50);
+    REQUIRE(0 == budget.used());
+
+    // A large message fits when nothing is charged
+    REQUIRE(budget.has_room(1000));
+}
+
+TEST_CASE("memory_budget no limit", "[memory]")
+{
+    memory_budget budget;
+    budget.charge(1'000'000);
+    REQUIRE(budget.has_room(1'000'000));
+    REQUIRE(budget.wait_for(1, milliseconds(0)));
+}
+
+TEST_CASE("memory_budget waits", "[memory]")
+{
+    memory_budget budget{10};
+    budget.charge(10);
+
+    auto start = steady_clock::now();
+    REQUIRE(!budget.wait_for(1, milliseconds(25)));
+    REQUIRE(steady_clock::now() - start >= milliseconds(20));
+
+    std::thread thr([&budget] {
+        std::this_thread::sleep_for(milliseconds(10));
+        budget.release(5);
+    });
+
+    // Blocks until the other thread releases
+    budget.wait(5);
+    REQUIRE(5 == budget.used());
+    thr.join();
+}
+
+// --------------------------------------------------------------------------
+
+TEST_CASE("message memory_size", "[memory]")
+{
+    auto msg = make_message("some/topic", "0123456789");
+    REQUIRE(msg->memory_size() >= sizeof(message) + 20);
+
+    auto bigger = make_message("some/topic", string(1000, 'x'));
+    REQUIRE(bigger->memory_size() - msg->memory_size() == 990);
+}
+
+TEST_CASE("metered_consumer_queue", "[memory]")
+{
+    memory_budget budget;
+    auto msg = make_message("some/topic", "payload");
+    const auto n = event_memory(event{msg});
+
+    {
+        metered_consumer_queue que{std::make_unique<thread_consumer_queue>(), &budget};
+        REQUIRE(que.can_meter());
+
+        que.put(event{msg});
+        REQUIRE(que.try_put(event{msg}));
+        que.put(event{connected_event{}});
+        REQUIRE(3 == que.size());
+        REQUIRE(2 * n + sizeof(event) == que.bytes());
+        REQUIRE(que.bytes() == budget.used());
+
+        event evt;
+        REQUIRE(que.try_get(&evt));
+        REQUIRE(n + sizeof(event) == que.bytes());
+
+        std::vector<event> evts;
+        REQUIRE(1 == que.try_get_bulk(evts, 1));
+        REQUIRE(sizeof(event) == que.bytes());
+
+        que.put(event{msg});
+        que.clear();
+        REQUIRE(0 == que.bytes());
+        REQUIRE(0 == budget.used());
+
+        que.put(event{msg});
+        que.put(event{msg});
+        REQUIRE(2 == que.drain().size());
+        REQUIRE(0 == que.bytes());
+        REQUIRE(0 == budget.used());
+
+        // What's left in the queue is released when it goes away
+        que.put(event{msg});
+        REQUIRE(n == budget.used());
+    }
+    REQUIRE(0 == budget.used());
+}
@@ -0,0 +1,107 @@
+// test_memory_persistence.cpp
+//
+// Unit tests for the memory_persistence class in the Paho MQTT C++ library.
+//
+
+/*******************************************************************************
+ * Copyright (c) 2025 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+#define UNIT_TESTS
+
+#include "catch2_version.h"
+#include "mqtt/exception.h"
+#include "mqtt/memory_persistence.h"
+
+using namespace mqtt;
+
+static const char* CLIENT_ID = "clientid";
+static const char* SERVER_URI = "serveruri";
+
+static const string KEY{"s-1"};
+static const string KEY2{"s-2"};
+
+static const string PAYLOAD{"some random data"};
+static const string PAYLOAD2{"some other random data"};
+
+// ----------------------------------------------------------------------
+
+TEST_CASE("memory_persistence put get remove", "[persistence]")
+{
+    memory_persistence per;
+    per.open(CLIENT_ID, SERVER_URI);
+
+    REQUIRE(0 == per.size());
+    REQUIRE(!per.contains_key(KEY));
+    REQUIRE_THROWS_AS(per.get(KEY), persistence_exception);
+    REQUIRE_THROWS_AS(per.remove(KEY), persistence_exception);
+
+    per.put(KEY, {string_view{"some "}, string_view{"", 0}, string_view{"random data"}});
+    per.put(KEY2, {string_view{PAYLOAD2}});
+
+    REQUIRE(2 == per.size());
+    REQUIRE(per.contains_key(KEY));
+    REQUIRE(PAYLOAD == per.get(KEY));
+    REQUIRE(PAYLOAD2 == per.get(KEY2));
+    REQUIRE(2 == per.keys().size());
+
+    size_t n = 0;
+    char* buf = per.get_buffer(KEY2, n);
+    REQUIRE(PAYLOAD2 == string(buf, n));
+    persistence_free(buf);
+    REQUIRE_THROWS_AS(per.get_buffer("bad-key", n), persistence_exception);
+
+    // Replace
+    per.put(KEY, {string_view{PAYLOAD2}});
+    REQUIRE(2 == per.size());
+    REQUIRE(PAYLOAD2 == per.get(KEY));
+
+    per.remove(KEY);
+    REQUIRE(!per.contains_key(KEY));
+    REQUIRE(1 == per.size());
+
+    // Survives a close and re-open
+    per.close();
+    per.open(CLIENT_ID, SERVER_URI);
+    REQUIRE(PAYLOAD2 == per.get(KEY2));
+
+    per.clear();
+    REQUIRE(0 == per.size());
+    REQUIRE(0 == per.free_count());
+}
+
+TEST_CASE("memory_persistence block reuse", "[persistence]")
+{
+    memory_persistence per;
+
+    per.put(KEY, {string_view{PAYLOAD}});
+    auto nfree = per.free_count();
+    REQUIRE(nfree > 0);
+
+    // A removed entry's block goes back on the free list, to be reused.
+    per.remove(KEY);
+    REQUIRE(nfree + 1 == per.free_count());
+
+    per.put(KEY2, {string_view{PAYLOAD2}});
+    REQUIRE(nfree == per.free_count());
+
+    // Large entries come from the heap
+    const string big(memory_persistence::MAX_BLOCK_SIZE + 1, 'x');
+    per.put(KEY, {string_view{big}});
+    REQUIRE(nfree == per.free_count());
+    REQUIRE(big == per.get(KEY));
+    per.remove(KEY);
+    REQUIRE(nfree == per.free_count());
+}
@@ -22,8 +22,11 @@
 #define UNIT_TESTS
 
 #include <cstring>
+#include <memory>
+#include <vector>
 
 #include "catch2_version.h"
+#include "mqtt/buffer_view.h"
 #include "mqtt/message.h"
 
 using namespace mqtt;
@@ -200,6 +203,56 @@ TEST_CASE("c struct constructor", "[message]")
     REQUIRE(c_struct.dup != 0);
 }
 
+TEST_CASE("c struct adopt payload constructor", "[message]")
+{
+    MQTTAsync_message c_msg = MQTTAsync_message_initializer;
+    c_msg.qos = QOS;
+    c_msg.retained = 1;
+
+    char* buf = new char[N];
+    memcpy(buf, BUF, N);
+
+    bool freed = false;
+    {
+        binary_ref payload{buf, N, [&freed](const char* p) {
+                               freed = true;
+                               delete[] p;
+                           }};
+        mqtt::message msg(TOPIC, c_msg, std::move(payload));
+
+        REQUIRE(TOPIC == msg.get_topic());
+        REQUIRE(QOS == msg.get_qos());
+        REQUIRE(msg.is_retained());
+        REQUIRE(buf == msg.get_payload_ref().data());
+        REQUIRE(N == msg.get_payload_ref().size());
+
+        const auto& c_struct = msg.c_struct();
+        REQUIRE(int(N) == c_struct.payloadlen);
+        REQUIRE(buf == c_struct.payload);
+
+        REQUIRE(PAYLOAD == msg.get_payload_str());
+        REQUIRE(!freed);
+    }
+    REQUIRE(freed);
+}
+
+TEST_CASE("owner payload constructor", "[message]")
+{
+    auto owner = std::make_shared<std::vector<char>>(BUF, BUF + N);
+    const char* buf = owner->data();
+
+    {
+        mqtt::message msg(TOPIC, binary_ref{buf, N, owner}, QOS, false);
+
+        REQUIRE(buf == msg.get_payload_ref().data());
+        REQUIRE(buf == msg.c_struct().payload);
+        REQUIRE(int(N) == msg.c_struct().payloadlen);
+        REQUIRE(PAYLOAD == msg.get_payload_str());
+        REQUIRE(2 == owner.use_count());
+    }
+    REQUIRE(1 == owner.use_count());
+}
+
 // --------------------------------------------------------------------------
 // Test the copy constructor
 // --------------------------------------------------------------------------
@@ -353,6 +406,75 @@ TEST_CASE("move assignment", "[message]")
 #endif
 }
 
+// --------------------------------------------------------------------------
+// Test setting a payload from segments
+// --------------------------------------------------------------------------
+
+TEST_CASE("segmented payload", "[message]")
+{
+    const binary HDR{"\x01\x02"};
+    const binary_ref BODY{"the body of the message"};
+    const binary_view TRLR{"end", 3};
+
+    mqtt::message msg;
+    msg.set_payload({HDR, BODY, TRLR});
+
+    const auto& c_struct = msg.c_struct();
+    REQUIRE(int(HDR.size() + BODY.size() + TRLR.size()) == c_struct.payloadlen);
+    REQUIRE(msg.get_payload_ref().data() == c_struct.payload);
+    REQUIRE((HDR + BODY.str() + TRLR.str()) == msg.get_payload_str());
+
+    std::vector<binary> segs{"one", "/", "two"};
+    msg.set_payload(segs.cbegin(), segs.cend());
+    REQUIRE("one/two" == msg.get_payload_str());
+
+    msg.set_payload(segs.cend(), segs.cend());
+    REQUIRE(0 == msg.c_struct().payloadlen);
+    REQUIRE(nullptr == msg.c_struct().payload);
+}
+
+// --------------------------------------------------------------------------
+// Test forwarding a message, sharing its contents
+// --------------------------------------------------------------------------
+
+TEST_CASE("forward", "[message]")
+{
+    properties props{
+        {property::USER_PROPERTY, "key", "val"}, {property::CONTENT_TYPE, "text/plain"}
+    };
+    // Big enough to be shared, rather than held in the small buffers
+    const string BIG_TOPIC(64, 't'), BIG_PAYLOAD(256, 'p');
+    const_message_ptr orig = message::create(BIG_TOPIC, BIG_PAYLOAD, QOS, true, props);
+
+    // The topic can be overridden, with everything else shared
+    auto fwd = message::forward(orig, "other/topic");
+    REQUIRE("other/topic" == fwd->get_topic());
+    REQUIRE(BIG_PAYLOAD == fwd->get_payload_str());
+    REQUIRE(orig->get_payload_ref().data() == fwd->get_payload_ref().data());
+    REQUIRE(QOS == fwd->get_qos());
+    REQUIRE(fwd->is_retained());
+    REQUIRE(&orig->get_properties() == &fwd->get_properties());
+    REQUIRE(fwd->c_struct().properties.array == orig->c_struct().properties.array);
+
+    // ...or kept
+    fwd = message::forward(orig);
+    REQUIRE(orig->get_topic_ref().data() == fwd->get_topic_ref().data());
+
+    // The properties outlive the original
+    orig.reset();
+    REQUIRE(2 == fwd->get_properties().size());
+    REQUIRE("text/plain" == get<string>(fwd->get_properties(), property::CONTENT_TYPE));
+
+    // Server-to-client properties aren't sent on
+    props.add({property::SUBSCRIPTION_IDENTIFIER, 42});
+    orig = message::create(BIG_TOPIC, BIG_PAYLOAD, QOS, true, props);
+    fwd = message::forward(orig);
+    REQUIRE(&orig->get_properties() != &fwd->get_properties());
+    REQUIRE(2 == fwd->get_properties().size());
+    REQUIRE(!fwd->get_properties().contains(property::SUBSCRIPTION_IDENTIFIER));
+    REQUIRE(orig->get_payload_ref().data() == fwd->get_payload_ref().data());
+}
+
 // --------------------------------------------------------------------------
 // Test the validate_qos()
 // --------------------------------------------------------------------------
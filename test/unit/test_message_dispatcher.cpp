@@ -0,0 +1,236 @@
+// test_message_dispatcher.cpp
+//
+// Unit tests for the message_dispatcher class in the Paho MQTT C++ library.
+//
+
+/*******************************************************************************
+ * Copyright (c) 2025 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+#define UNIT_TESTS
+
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "catch2_version.h"
+#include "mqtt/message_dispatcher.h"
+
+using namespace mqtt;
+
+static const int N_TOPICS = 8;
+static const int N_PER_TOPIC = 100;
+
+// --------------------------------------------------------------------------
+
+TEST_CASE("message_dispatcher ctor", "[dispatcher]")
+{
+    message_dispatcher disp{[](const_message_ptr) {}, 4};
+    REQUIRE(4 == disp.num_workers());
+    REQUIRE(disp.worker_index(5) == 1);
+
+    message_dispatcher disp2{[](const_message_ptr) {}, 0};
+    REQUIRE(disp2.num_workers() >= 1);
+}
+
+TEST_CASE("message_dispatcher topic key", "[dispatcher]")
+{
+    auto msg1 = make_message("a/b", "x");
+    auto msg2 = make_message("a/b", "y");
+    REQUIRE(message_dispatcher::topic_key(msg1) == message_dispatcher::topic_key(msg2));
+}
+
+TEST_CASE("message_dispatcher ordering", "[dispatcher]")
+{
+    std::mutex lock;
+    std::map<std::string, std::vector<int>> rcvd;
+
+    message_dispatcher disp{
+        [&](const_message_ptr msg) {
+            std::lock_guard<std::mutex> g{lock};
+            rcvd[msg->get_topic()].push_back(std::stoi(msg->get_payload_str()));
+        },
+        4
+    };
+
+    for (int i = 0; i < N_PER_TOPIC; ++i) {
+        for (int j = 0; j < N_TOPICS; ++j) {
+            auto topic = "topic/" + std::to_string(j);
+            REQUIRE(disp.dispatch(make_message(topic, std::to_string(i))));
+        }
+    }
+
+    // Stop drains the queues
+    disp.stop();
+
+    REQUIRE(N_TOPICS == int(rcvd.size()));
+    for (const auto& tv : rcvd) {
+        const auto& v = tv.second;
+        REQUIRE(N_PER_TOPIC == int(v.size()));
+        for (int i = 0; i < N_PER_TOPIC; ++i) REQUIRE(i == v[i]);
+    }
+}
+
+TEST_CASE("message_dispatcher key func", "[dispatcher]")
+{
+    std::mutex lock;
+    std::vector<std::thread::id> ids;
+
+    // All messages use the same key, so go to the same worker
+    message_dispatcher disp{
+        [&](const_message_ptr) {
+            std::lock_guard<std::mutex> g{lock};
+            ids.push_back(std::this_thread::get_id());
+        },
+        4, [](const const_message_ptr&) -> size_t { return 42; }
+    };
+
+    for (int i = 0; i < N_TOPICS; ++i) disp.dispatch(make_message("topic/" + std::to_string(i), "x"));
+
+    disp.stop();
+
+    REQUIRE(N_TOPICS == int(ids.size()));
+    for (const auto& id : ids) REQUIRE(id == ids.front());
+}
+
+TEST_CASE("message_dispatcher handler throws", "[dispatcher]")
+{
+    std::atomic<int> n{0};
+
+    message_dispatcher disp{
+        [&](const_message_ptr) {
+            ++n;
+            throw std::runtime_error("oops");
+        },
+        1
+    };
+
+    disp.dispatch(make_message("a", "x"));
+    disp.dispatch(make_message("a", "y"));
+    disp.stop();
+
+    REQUIRE(2 == n);
+}
+
+TEST_CASE("message_dispatcher stopped", "[dispatcher]")
+{
+    message_dispatcher disp{[](const_message_ptr) {}, 2};
+    disp.stop();
+
+    REQUIRE(!disp.dispatch(make_message("a", "x")));
+    REQUIRE(!disp.dispatch(const_message_ptr{}));
+
+    // Stop is idempotent
+    disp.stop();
+}
+
+TEST_CASE("message_dispatcher pending", "[dispatcher]")
+{
+    std::atomic<bool> go{false};
+    message_dispatcher disp{
+        [&go](const_message_ptr) {
+            while (!go) std::this_thread::yield();
+        },
+        1
+    };
+    REQUIRE(0 == disp.pending());
+
+    for (int i = 0; i < 4; ++i) disp.dispatch(make_message("a", "x"));
+
+    // One of them may already be in the handler
+    REQUIRE(disp.pending() >= 3);
+
+    go = true;
+    disp.stop();
+    REQUIRE(0 == disp.pending());
+}
+
+TEST_CASE("message_dispatcher affinity", "[dispatcher]")
+{
+    message_dispatcher disp{[](const_message_ptr) {}, 2};
+    REQUIRE(!disp.set_cpu_affinity(cpu_set{}));
+
+#if defined(__linux__)
+    // Every machine has a CPU 0, though it may not be allowed in a container
+    std::thread thr{[] { std::this_thread::sleep_for(std::chrono::milliseconds{10}); }};
+    bool allowed = cpu_set{0}.pin(thr);
+    thr.join();
+
+    if (allowed) {
+        REQUIRE(disp.set_cpu_affinity(cpu_set{0}));
+        REQUIRE(disp.set_cpu_affinity(cpu_set{0}, true));
+    }
+#endif
+}
+
+TEST_CASE("message_dispatcher unordered", "[dispatcher]")
+{
+    std::mutex lock;
+    std::map<std::thread::id, int> nByThread;
+    std::atomic<int> n{0};
+
+    message_dispatcher disp{
+        [&](const_message_ptr) {
+            std::this_thread::sleep_for(std::chrono::microseconds{200});
+            {
+                std::lock_guard<std::mutex> g{lock};
+                ++nByThread[std::this_thread::get_id()];
+            }
+            ++n;
+        },
+        4, dispatch_mode::UNORDERED
+    };
+    REQUIRE(dispatch_mode::UNORDERED == disp.get_mode());
+
+    // A single hot topic is still spread over all the workers
+    for (int i = 0; i < 200; ++i) REQUIRE(disp.dispatch(make_message("hot", "x")));
+
+    disp.stop();
+    REQUIRE(200 == n);
+    REQUIRE(nByThread.size() > 1);
+    REQUIRE(!disp.dispatch(make_message("hot", "x")));
+}
+
+TEST_CASE("message_dispatcher unordered stealing", "[dispatcher]")
+{
+    std::atomic<bool> go{false};
+    std::atomic<int> n{0};
+
+    message_dispatcher disp{
+        [&](const_message_ptr msg) {
+            if (msg->get_topic() == "slow")
+                while (!go) std::this_thread::yield();
+            ++n;
+        },
+        2, dispatch_mode::UNORDERED
+    };
+
+    // The first worker is stuck, so its share is taken by the other one
+    disp.dispatch(make_message("slow", "x"));
+    for (int i = 0; i < 20; ++i) disp.dispatch(make_message("fast", "x"));
+
+    auto until = std::chrono::steady_clock::now() + std::chrono::seconds{5};
+    while (n < 20 && std::chrono::steady_clock::now() < until)
+        std::this_thread::sleep_for(std::chrono::milliseconds{1});
+    REQUIRE(20 == n);
+
+    go = true;
+    disp.stop();
+    REQUIRE(21 == n);
+}
@@ -0,0 +1,226 @@
+// test_message_pool.cpp
+//
+// Unit tests for the message_pool class in the Paho MQTT C++ library.
+//
+
+/*******************************************************************************
+ * Copyright (c) 2025 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+#define UNIT_TESTS
+
+#include <cstring>
+#include <memory_resource>
+#include <vector>
+
+#include "catch2_version.h"
+#include "mqtt/message_pool.h"
+
+using namespace mqtt;
+
+static const std::string TOPIC{"hello"};
+static const char* BUF = "Hello there, from the pool";
+static const size_t N = std::strlen(BUF);
+static const int QOS = 1;
+
+// Makes a C message struct pointing at the test payload
+static MQTTAsync_message c_message()
+{
+    MQTTAsync_message c_msg = MQTTAsync_message_initializer;
+    c_msg.payload = const_cast<char*>(BUF);
+    c_msg.payloadlen = int(N);
+    c_msg.qos = QOS;
+    return c_msg;
+}
+
+// A memory resource that counts what it hands out
+class counting_resource : public std::pmr::memory_resource
+{
+    std::pmr::monotonic_buffer_resource upstream_;
+
+    void* do_allocate(size_t n, size_t align) override {
+        ++nAlloc;
+        nBytes += n;
+        return upstream_.allocate(n, align);
+    }
+    void do_deallocate(void* p, size_t n, size_t align) override {
+        ++nDealloc;
+        upstream_.deallocate(p, n, align);
+    }
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+
+public:
+    size_t nAlloc{0}, nDealloc{0}, nBytes{0};
+};
+
+// --------------------------------------------------------------------------
+
+TEST_CASE("message_pool ctor", "[message]")
+{
+    message_pool pool;
+    REQUIRE(message_pool::DFLT_MAX_FREE == pool.max_free());
+    REQUIRE(0 == pool.free_count());
+
+    auto pool2 = message_pool::create(8);
+    REQUIRE(pool2);
+    REQUIRE(8 == pool2->max_free());
+}
+
+TEST_CASE("message_pool create buffer", "[message]")
+{
+    message_pool pool;
+
+    auto buf = pool.create_buffer(BUF, N);
+    REQUIRE(N == buf.size());
+    REQUIRE(0 == std::memcmp(BUF, buf.data(), N));
+    REQUIRE(0 == pool.free_count());
+
+    auto data = buf.data();
+
+    // The data and the shared state both go back to the pool
+    buf.reset();
+    REQUIRE(2 == pool.free_count());
+
+    // The next one re-uses the blocks, even if it's a bit smaller
+    buf = pool.create_buffer(BUF, N - 1);
+    REQUIRE(0 == pool.free_count());
+    REQUIRE(data == buf.data());
+}
+
+TEST_CASE("message_pool large buffer", "[message]")
+{
+    message_pool pool;
+
+    // The data of a buffer that's too big isn't pooled
+    std::vector<char> v(message_pool::MAX_POOLED_SIZE + 1, 'x');
+    auto buf = pool.create_buffer(v.data(), v.size());
+    REQUIRE(v.size() == buf.size());
+    REQUIRE('x' == buf.data()[v.size() - 1]);
+
+    buf.reset();
+    REQUIRE(1 == pool.free_count());
+}
+
+TEST_CASE("message_pool small buffer", "[message]")
+{
+    message_pool pool;
+
+    // Small buffers are held in place and don't use the pool
+    auto buf = pool.create_buffer("hi", 2);
+    REQUIRE(buf.is_small());
+    REQUIRE("hi" == buf.str());
+
+    buf.reset();
+    REQUIRE(0 == pool.free_count());
+}
+
+TEST_CASE("message_pool create message", "[message]")
+{
+    message_pool pool;
+    auto c_msg = c_message();
+
+    auto msg = pool.create_message(TOPIC, c_msg);
+    REQUIRE(msg);
+    REQUIRE(TOPIC == msg->get_topic());
+    REQUIRE(BUF == msg->get_payload_str());
+    REQUIRE(QOS == msg->get_qos());
+
+    // The message block, and the payload data and its shared state, go
+    // back to the pool
+    msg.reset();
+    REQUIRE(3 == pool.free_count());
+
+    msg = pool.create_message(TOPIC, c_msg);
+    REQUIRE(0 == pool.free_count());
+    REQUIRE(BUF == msg->get_payload_str());
+}
+
+TEST_CASE("message_pool create message with payload", "[message]")
+{
+    message_pool pool;
+    auto c_msg = c_message();
+
+    auto msg = pool.create_message(TOPIC, c_msg, binary_ref{"other"});
+    REQUIRE("other" == msg->get_payload_str());
+
+    // Only the message block came from the pool
+    msg.reset();
+    REQUIRE(1 == pool.free_count());
+}
+
+TEST_CASE("message_pool max free", "[message]")
+{
+    const size_t MAX_FREE = 4;
+    message_pool pool{MAX_FREE};
+
+    std::vector<binary_ref> bufs;
+    for (size_t i = 0; i < 2 * MAX_FREE; ++i) bufs.push_back(pool.create_buffer(BUF, N));
+
+    // Up to the maximum of each, the data blocks and the shared states
+    bufs.clear();
+    REQUIRE(2 * MAX_FREE == pool.free_count());
+}
+
+TEST_CASE("message_pool memory resource", "[message]")
+{
+    counting_resource mr;
+    message_pool pool{&mr, 0};
+    REQUIRE(&mr == pool.upstream_resource());
+    REQUIRE(!message_pool{}.upstream_resource());
+
+    auto c_msg = c_message();
+    auto msg = pool.create_message(TOPIC, c_msg);
+    REQUIRE(BUF == msg->get_payload_str());
+
+    // The message, the payload data, and its shared state
+    REQUIRE(3 == mr.nAlloc);
+    REQUIRE(mr.nBytes >= N);
+
+    // All of them go back to the resource, with nothing held in the pool
+    msg.reset();
+    REQUIRE(3 == mr.nDealloc);
+    REQUIRE(0 == pool.free_count());
+}
+
+TEST_CASE("message_pool outlived", "[message]")
+{
+    const_message_ptr msg;
+    {
+        auto pool = message_pool::create();
+        msg = pool->create_message(TOPIC, c_message());
+    }
+    REQUIRE(TOPIC == msg->get_topic());
+    REQUIRE(BUF == msg->get_payload_str());
+}
+
+TEST_CASE("message_pool make shared", "[message]")
+{
+    message_pool pool;
+
+    auto p = pool.make_shared<std::vector<int>>(3, 42);
+    REQUIRE(3 == p->size());
+    REQUIRE(42 == (*p)[2]);
+
+    auto addr = p.get();
+    p.reset();
+    REQUIRE(1 == pool.free_count());
+
+    // The block is recycled
+    auto p2 = pool.make_shared<std::vector<int>>(1, 7);
+    REQUIRE(addr == p2.get());
+    REQUIRE(0 == pool.free_count());
+}
@@ -0,0 +1,79 @@
+// test_message_sampler.cpp
+//
+// Unit tests for the message_sampler class in the Paho MQTT C++ library.
+//
+
+/*******************************************************************************
+ * Copyright (c) 2025 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - Initial implementation
+ *******************************************************************************/
+
+#define UNIT_TESTS
+
+#include <string>
+
+#include "catch2_version.h"
+#include "mqtt/message_sampler.h"
+
+using namespace mqtt;
+
+/////////////////////////////////////////////////////////////////////////////
+
+TEST_CASE("message_sampler rules", "[sampler]")
+{
+    message_sampler sampler;
+    REQUIRE(sampler.empty());
+    REQUIRE(sampler.keep("any/topic"));
+
+    sampler.add_rule("data/#", 3);
+    sampler.drop("debug/#");
+    REQUIRE(!sampler.empty());
+
+    // Topics without a rule are kept
+    REQUIRE(sampler.keep("other"));
+
+    // One in three, starting with the first, shared by all the topics
+    REQUIRE(sampler.keep("data/a"));
+    REQUIRE(!sampler.keep("data/b"));
+    REQUIRE(!sampler.keep("data/a"));
+    REQUIRE(sampler.keep("data/c"));
+
+    REQUIRE(!sampler.keep("debug/x"));
+    REQUIRE(!sampler.keep("debug/y"));
+    REQUIRE(4 == sampler.num_dropped());
+
+    // Replacing a rule starts the count over
+    sampler.add_rule("data/#", 1);
+    for (int i = 0; i < 5; ++i) REQUIRE(sampler.keep("data/a"));
+
+    REQUIRE(sampler.remove_rule("debug/#"));
+    REQUIRE(!sampler.remove_rule("debug/#"));
+    REQUIRE(sampler.keep("debug/x"));
+    REQUIRE(4 == sampler.num_dropped());
+}
+
+TEST_CASE("message_sampler first rule wins", "[sampler]")
+{
+    auto sampler = message_sampler::create();
+    sampler->drop("data/+/raw");
+    sampler->add_rule("data/#", 1);
+
+    REQUIRE(!sampler->keep("data/1/raw"));
+    REQUIRE(sampler->keep("data/1/avg"));
+
+    // A replaced rule keeps its place in the order
+    sampler->add_rule("data/+/raw", 2);
+    REQUIRE(sampler->keep("data/1/raw"));
+    REQUIRE(!sampler->keep("data/2/raw"));
+}
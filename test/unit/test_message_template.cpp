@@ -0,0 +1,105 @@
+// test_message_template.cpp
+//
+// Unit tests for the message_template class in the Paho MQTT C++ library.
+//
+
+/*******************************************************************************
+ * Copyright (c) 2025 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - Initial implementation
+ *******************************************************************************/
+
+#define UNIT_TESTS
+
+#include <string>
+
+#include "catch2_version.h"
+#include "mqtt/message_template.h"
+
+using namespace mqtt;
+
+static const std::string TOPIC{"data/temp"};
+static const std::string CONTENT_TYPE{"application/json"};
+
+/////////////////////////////////////////////////////////////////////////////
+
+TEST_CASE("message_template make", "[message]")
+{
+    properties props{{property::CONTENT_TYPE, CONTENT_TYPE}};
+    message_template tmpl{TOPIC, 1, true, props};
+
+    REQUIRE(TOPIC == tmpl.get_topic());
+    REQUIRE(1 == tmpl.get_qos());
+    REQUIRE(tmpl.is_retained());
+
+    auto msg = tmpl.make("22.5");
+    REQUIRE(TOPIC == msg->get_topic());
+    REQUIRE("22.5" == msg->get_payload_str());
+    REQUIRE(1 == msg->get_qos());
+    REQUIRE(msg->is_retained());
+    REQUIRE(CONTENT_TYPE == get<string>(msg->get_properties(), property::CONTENT_TYPE));
+
+    auto msg2 = tmpl.make("23.0", 4);
+    REQUIRE("23.0" == msg2->get_payload_str());
+
+    // The messages share the properties of the template
+    REQUIRE(&msg->get_properties() == &msg2->get_properties());
+    REQUIRE(&tmpl.get_properties() == &msg->get_properties());
+
+    REQUIRE_THROWS(message_template(TOPIC, 3));
+}
+
+TEST_CASE("message_template copy", "[message]")
+{
+    properties props{{property::CONTENT_TYPE, CONTENT_TYPE}};
+    message_template tmpl{TOPIC, 0, false, props};
+    auto msg = tmpl.make("x");
+
+    // A copy still shares the properties
+    message msg2{*msg};
+    REQUIRE(&msg->get_properties() == &msg2.get_properties());
+    REQUIRE(1 == msg2.get_properties().size());
+
+    message msg3;
+    msg3 = msg2;
+    REQUIRE(&msg->get_properties() == &msg3.get_properties());
+
+    // Setting the properties gives the message its own, and leaves the
+    // template alone.
+    msg3.set_properties(properties{});
+    REQUIRE(msg3.get_properties().empty());
+    REQUIRE(1 == tmpl.get_properties().size());
+    REQUIRE(1 == msg->get_properties().size());
+}
+
+TEST_CASE("message_template set", "[message]")
+{
+    message_template tmpl{TOPIC};
+    auto msg = tmpl.make("x");
+
+    tmpl.set_qos(2);
+    tmpl.set_retained(true);
+    tmpl.set_properties(properties{{property::CONTENT_TYPE, CONTENT_TYPE}});
+    REQUIRE_THROWS(tmpl.set_qos(3));
+
+    auto msg2 = tmpl.make("y");
+    REQUIRE(2 == msg2->get_qos());
+    REQUIRE(msg2->is_retained());
+    REQUIRE(1 == msg2->get_properties().size());
+
+    // The messages already made are unchanged
+    REQUIRE(0 == msg->get_qos());
+    REQUIRE(msg->get_properties().empty());
+
+    REQUIRE(msg->get_topic() == msg2->get_topic());
+}
@@ -0,0 +1,192 @@
+// test_multi_lane_queue.cpp
+//
+// Unit tests for the multi_lane_queue class in the Paho MQTT C++ library.
+//
+
+/*******************************************************************************
+ * Copyright (c) 2025 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - Initial implementation
+ *******************************************************************************/
+
+#define UNIT_TESTS
+
+#include <chrono>
+#include <future>
+#include <thread>
+#include <vector>
+
+#include "catch2_version.h"
+#include "mqtt/consumer_queue.h"
+#include "mqtt/multi_lane_queue.h"
+#include "mqtt/types.h"
+
+using namespace mqtt;
+using namespace std::chrono;
+
+// Items >= 100 go in the low priority lane
+static size_t lane_of(const int& n) { return (n >= 100) ? 1 : 0; }
+
+TEST_CASE("multi_lane_queue priority", "[multi_lane_queue]")
+{
+    multi_lane_queue<int> que{2, lane_of};
+    REQUIRE(2 == que.num_lanes());
+    REQUIRE(que.empty());
+
+    que.put(100);
+    que.put(101);
+    que.put(1);
+    que.put(2);
+
+    REQUIRE(4 == que.size());
+    REQUIRE(2 == que.lane_size(0));
+    REQUIRE(2 == que.lane_size(1));
+    REQUIRE(0 == que.lane_size(2));
+
+    REQUIRE(1 == que.get());
+    REQUIRE(2 == que.get());
+    REQUIRE(100 == que.get());
+
+    que.put(3);
+    REQUIRE(3 == que.get());
+    REQUIRE(101 == que.get());
+    REQUIRE(que.empty());
+}
+
+TEST_CASE("multi_lane_queue clamps lane", "[multi_lane_queue]")
+{
+    multi_lane_queue<int> que{2, [](const int& n) { return size_t(n); }};
+
+    que.put(5);
+    que.put(0);
+
+    REQUIRE(1 == que.lane_size(0));
+    REQUIRE(1 == que.lane_size(1));
+    REQUIRE(0 == que.get());
+    REQUIRE(5 == que.get());
+}
+
+TEST_CASE("multi_lane_queue no starvation", "[multi_lane_queue]")
+{
+    multi_lane_queue<int> que{2, lane_of, multi_lane_queue<int>::MAX_CAPACITY, 3};
+
+    que.put(100);
+    que.put(101);
+    for (int i = 0; i < 8; ++i) que.put(i);
+
+    // Three from the top, then one from below
+    auto vec = que.get_all();
+    std::vector<int> expected{0, 1, 2, 100, 3, 4, 5, 101, 6, 7};
+    REQUIRE(expected == vec);
+}
+
+TEST_CASE("multi_lane_queue round robin", "[multi_lane_queue]")
+{
+    multi_lane_queue<int> que{
+        3, [](const int& n) { return size_t(n / 100); }, multi_lane_queue<int>::MAX_CAPACITY,
+        1
+    };
+
+    que.put(100);
+    que.put(101);
+    que.put(200);
+    que.put(201);
+    for (int i = 0; i < 4; ++i) que.put(i);
+
+    // The lower lanes take turns
+    std::vector<int> vec;
+    que.try_get_bulk(vec, 8);
+    std::vector<int> expected{0, 100, 1, 200, 2, 101, 3, 201};
+    REQUIRE(expected == vec);
+}
+
+TEST_CASE("multi_lane_queue capacity", "[multi_lane_queue]")
+{
+    multi_lane_queue<int> que{2, lane_of, 2};
+
+    REQUIRE(que.try_put(100));
+    REQUIRE(que.try_put(1));
+
+    // Full across the lanes
+    REQUIRE(!que.try_put(2));
+    REQUIRE(!que.try_put_for(2, 5ms));
+
+    auto fut = std::async(std::launch::async, [&que] { que.put(2); });
+    REQUIRE(fut.wait_for(10ms) == std::future_status::timeout);
+
+    REQUIRE(1 == que.get());
+    REQUIRE(fut.wait_for(500ms) == std::future_status::ready);
+    REQUIRE(2 == que.get());
+}
+
+TEST_CASE("multi_lane_queue close", "[multi_lane_queue]")
+{
+    multi_lane_queue<int> que{2, lane_of};
+
+    que.put(100);
+    que.close();
+
+    REQUIRE(que.closed());
+    REQUIRE(!que.done());
+    REQUIRE(!que.try_put(1));
+    REQUIRE_THROWS_AS(que.put(1), queue_closed);
+
+    int n;
+    REQUIRE(que.get(&n));
+    REQUIRE(100 == n);
+    REQUIRE(que.done());
+    REQUIRE(!que.get(&n));
+    REQUIRE_THROWS_AS(que.get(), queue_closed);
+}
+
+TEST_CASE("multi_lane_queue get wait", "[multi_lane_queue]")
+{
+    multi_lane_queue<int> que{2, lane_of};
+
+    int n;
+    REQUIRE(!que.try_get(&n));
+    REQUIRE(!que.try_get_for(&n, 5ms));
+
+    auto fut = std::async(std::launch::async, [&que] {
+        std::this_thread::sleep_for(10ms);
+        que.put(42);
+    });
+
+    REQUIRE(que.try_get_for(&n, 500ms));
+    REQUIRE(42 == n);
+    fut.wait();
+}
+
+TEST_CASE("priority_consumer_queue lanes", "[multi_lane_queue]")
+{
+    auto byQos = lanes_by_qos();
+    REQUIRE(0 == byQos(event{make_message("a", "x", 2, false)}));
+    REQUIRE(1 == byQos(event{make_message("a", "x", 1, false)}));
+    REQUIRE(2 == byQos(event{make_message("a", "x", 0, false)}));
+    REQUIRE(0 == byQos(event{connection_lost_event{}}));
+
+    auto byTopic = lanes_by_topic({"cmd/#", "alarm/+"});
+    REQUIRE(0 == byTopic(event{make_message("cmd/reboot", "x")}));
+    REQUIRE(1 == byTopic(event{make_message("alarm/fire", "x")}));
+    REQUIRE(2 == byTopic(event{make_message("telemetry/temp", "x")}));
+    REQUIRE(0 == byTopic(event{connection_lost_event{}}));
+
+    priority_consumer_queue que{3, byTopic};
+    que.put(event{make_message("telemetry/temp", "x")});
+    que.put(event{make_message("cmd/reboot", "x")});
+
+    REQUIRE(2 == que.size());
+    auto evt = que.get();
+    REQUIRE(evt.is_message());
+    REQUIRE("cmd/reboot" == evt.get_message()->get_topic());
+}
@@ -0,0 +1,151 @@
+// test_offline_buffer.cpp
+//
+// Unit tests for the offline_buffer class in the Paho MQTT C++ library.
+//
+
+/*******************************************************************************
+ * Copyright (c) 2025 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - Initial implementation
+ *******************************************************************************/
+
+#define UNIT_TESTS
+
+#include <cstdio>
+#include <string>
+
+#include "catch2_version.h"
+#include "mock_async_client.h"
+#include "mqtt/exception.h"
+#include "mqtt/offline_buffer.h"
+
+using namespace mqtt;
+
+static const string SPILL_PATH{"offline_buffer_test.seg"};
+
+static mock_async_client cli;
+
+/////////////////////////////////////////////////////////////////////////////
+
+TEST_CASE("offline_buffer memory", "[offline]")
+{
+    // Each message is 10 bytes: a 4-byte topic and 6-byte payload
+    offline_buffer buf{25, 10.0};
+
+    REQUIRE(25 == buf.max_bytes());
+    REQUIRE(10.0 == buf.drain_rate());
+    REQUIRE(buf.spill_path().empty());
+    REQUIRE(buf.empty());
+    REQUIRE(!buf.try_pop());
+
+    REQUIRE(buf.push(make_message("t/01", "data-1")));
+    REQUIRE(buf.push(make_message("t/02", "data-2")));
+    REQUIRE(2 == buf.size());
+    REQUIRE(20 == buf.bytes_in_memory());
+
+    // No room and no file
+    REQUIRE(!buf.push(make_message("t/03", "data-3")));
+    REQUIRE(2 == buf.size());
+
+    auto msg = buf.try_pop();
+    REQUIRE(msg);
+    REQUIRE("t/01" == msg->get_topic());
+    REQUIRE(10 == buf.bytes_in_memory());
+
+    buf.clear();
+    REQUIRE(buf.empty());
+    REQUIRE(0 == buf.bytes_in_memory());
+}
+
+TEST_CASE("offline_buffer spill", "[offline]")
+{
+    {
+        offline_buffer buf{25, SPILL_PATH};
+        REQUIRE(SPILL_PATH == buf.spill_path());
+
+        for (int i = 0; i < 6; ++i) {
+            auto topic = "t/0" + std::to_string(i);
+            REQUIRE(buf.push(make_message(topic, "data-" + std::to_string(i), i % 3, i == 4)));
+        }
+
+        REQUIRE(6 == buf.size());
+        REQUIRE(4 == buf.num_spilled());
+        REQUIRE(20 == buf.bytes_in_memory());
+
+        // Memory frees up, but the next still spills, to keep the order
+        REQUIRE("t/00" == buf.try_pop()->get_topic());
+        REQUIRE(buf.push(make_message("t/06", "data-6")));
+        REQUIRE(5 == buf.num_spilled());
+
+        for (int i = 1; i < 7; ++i) {
+            auto msg = buf.try_pop();
+            REQUIRE(msg);
+            REQUIRE("t/0" + std::to_string(i) == msg->get_topic());
+            REQUIRE("data-" + std::to_string(i) == msg->get_payload_str());
+            REQUIRE((i % 3) == msg->get_qos());
+            REQUIRE((i == 4) == msg->is_retained());
+        }
+
+        REQUIRE(buf.empty());
+        REQUIRE(0 == buf.num_spilled());
+
+        // Once empty, messages go back into memory
+        REQUIRE(buf.push(make_message("t/07", "data-7")));
+        REQUIRE(0 == buf.num_spilled());
+        REQUIRE(10 == buf.bytes_in_memory());
+    }
+    std::remove(SPILL_PATH.c_str());
+
+    REQUIRE_THROWS_AS(
+        offline_buffer(10, "no_such_dir/offline.seg"), persistence_exception
+    );
+}
+
+TEST_CASE("offline_buffer tokens", "[offline]")
+{
+    {
+        offline_buffer buf{25, SPILL_PATH};
+
+        // The tokens are kept for the messages in memory
+        auto msg = make_message("t/01", "data-1");
+        delivery_token_ptr tok = delivery_token::create(cli, msg), held = tok;
+        REQUIRE(buf.push(msg, held));
+        REQUIRE(!held);
+
+        auto msg2 = make_message("t/02", "data-2");
+        delivery_token_ptr tok2 = delivery_token::create(cli, msg2), held2 = tok2;
+        REQUIRE(buf.push(msg2, held2));
+        REQUIRE(!held2);
+
+        // ...but given back for one that spills
+        auto msg3 = make_message("t/03", "data-3");
+        delivery_token_ptr held3 = delivery_token::create(cli, msg3);
+        REQUIRE(buf.push(msg3, held3));
+        REQUIRE(held3);
+
+        delivery_token_ptr popped;
+        REQUIRE(msg == buf.try_pop(popped));
+        REQUIRE(tok == popped);
+
+        auto toks = buf.release_tokens();
+        REQUIRE(1 == toks.size());
+        REQUIRE(tok2 == toks[0]);
+
+        REQUIRE("t/02" == buf.try_pop(popped)->get_topic());
+        REQUIRE(!popped);
+
+        REQUIRE("t/03" == buf.try_pop(popped)->get_topic());
+        REQUIRE(!popped);
+    }
+    std::remove(SPILL_PATH.c_str());
+}
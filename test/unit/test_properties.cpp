@@ -22,6 +22,7 @@
 
 #include <cstring>
 #include <iostream>
+#include <vector>
 
 #include "catch2_version.h"
 #include "mqtt/properties.h"
@@ -521,6 +522,44 @@ TEST_CASE("properties count and contains", "[properties]")
         props.add({property::USER_PROPERTY, "usr3", "some longer property value"});
         REQUIRE(props.count(property::USER_PROPERTY) == 3);
     }
+
+    SECTION("user properties by name")
+    {
+        properties props{
+            {property::USER_PROPERTY, "usr1", "bubba"},
+            {property::RESPONSE_TOPIC, "some/topic"},
+            {property::USER_PROPERTY, "usr2", "wally"},
+            {property::USER_PROPERTY, "usr1", "again"}
+        };
+
+        REQUIRE(props.contains_user_property("usr1"));
+        REQUIRE(props.contains_user_property("usr2"));
+        REQUIRE(!props.contains_user_property("usr3"));
+
+        // Gets the first one with the name
+        REQUIRE("bubba" == props.get_user_property("usr1"));
+        REQUIRE("wally" == props.get_user_property("usr2"));
+        REQUIRE_THROWS_AS(props.get_user_property("usr3"), bad_cast);
+
+        REQUIRE(3 == props.count(property::USER_PROPERTY));
+        REQUIRE("some/topic" == get<string>(props, property::RESPONSE_TOPIC));
+
+        string name, value;
+        std::tie(name, value) = get<string_pair>(props, property::USER_PROPERTY, 2);
+        REQUIRE("usr1" == name);
+        REQUIRE("again" == value);
+        REQUIRE_THROWS_AS(get<string_pair>(props, property::USER_PROPERTY, 3), bad_cast);
+
+        // The index is rebuilt when the list changes
+        props.add({property::USER_PROPERTY, "usr3", "new"});
+        REQUIRE("new" == props.get_user_property("usr3"));
+
+        properties copy{props};
+        REQUIRE("new" == copy.get_user_property("usr3"));
+
+        properties moved{std::move(props)};
+        REQUIRE("new" == moved.get_user_property("usr3"));
+    }
 }
 
 TEST_CASE("getting properties", "[properties]")
@@ -654,6 +693,23 @@ TEST_CASE("properties copy and move", "[properties]")
         REQUIRE(nullptr == orgCprops.array);
     }
 
+    SECTION("adopt C struct")
+    {
+        MQTTProperties cprops = ::MQTTProperties_copy(&orgProps.c_struct());
+        const auto* arr = cprops.array;
+
+        properties props{std::move(cprops)};
+
+        // Takes over the C array, leaving the C struct empty
+        REQUIRE(arr == props.c_struct().array);
+        REQUIRE(nullptr == cprops.array);
+        REQUIRE(0 == cprops.count);
+
+        REQUIRE(7 == props.size());
+        REQUIRE(get<uint16_t>(props, property::TOPIC_ALIAS) == TOP_ALIAS);
+        REQUIRE(get<string>(props, property::RESPONSE_TOPIC) == TOPIC);
+    }
+
     SECTION("copy assignment")
     {
         properties props;
@@ -707,4 +763,55 @@ TEST_CASE("properties copy and move", "[properties]")
         REQUIRE(orgProps.empty());
         REQUIRE(0 == orgProps.size());
     }
+
+    SECTION("empty copy")
+    {
+        // An empty list copies without allocating
+        const properties empty;
+        properties props{empty};
+        REQUIRE(props.empty());
+        REQUIRE(nullptr == props.c_struct().array);
+
+        // Assigning an empty list releases the old one
+        props = orgProps;
+        REQUIRE(orgProps.size() == props.size());
+        props = empty;
+        REQUIRE(props.empty());
+        REQUIRE(nullptr == props.c_struct().array);
+
+        props.add({property::TOPIC_ALIAS, TOP_ALIAS});
+        REQUIRE(get<uint16_t>(props, property::TOPIC_ALIAS) == TOP_ALIAS);
+    }
+}
+
+TEST_CASE("properties user property iteration", "[properties]")
+{
+    properties props;
+    REQUIRE(props.user_properties().empty());
+    REQUIRE(props.user_properties().begin() == props.user_properties().end());
+
+    props.add({property::PAYLOAD_FORMAT_INDICATOR, FMT_IND});
+    props.add({property::USER_PROPERTY, NAME1, VALUE1});
+    props.add({property::RESPONSE_TOPIC, TOPIC});
+    props.add({property::USER_PROPERTY, NAME2, VALUE2});
+    props.add({property::USER_PROPERTY, NAME1, ""});
+
+    std::vector<string_view_pair> vec;
+    for (auto [name, value] : props.user_properties()) vec.push_back({name, value});
+
+    REQUIRE(3 == vec.size());
+    REQUIRE(vec[0].first == NAME1);
+    REQUIRE(vec[0].second == VALUE1);
+    REQUIRE(vec[1].first == NAME2);
+    REQUIRE(vec[1].second == VALUE2);
+    REQUIRE(vec[2].first == NAME1);
+    REQUIRE(vec[2].second.empty());
+
+    // The views point into the list itself
+    auto it = props.user_properties().begin();
+    REQUIRE((*it).first.data() == props.c_struct().array[1].value.data.data);
+
+    // Only other properties
+    properties other{{property::PAYLOAD_FORMAT_INDICATOR, FMT_IND}};
+    REQUIRE(other.user_properties().empty());
 }
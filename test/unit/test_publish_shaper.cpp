@@ -0,0 +1,149 @@
+// test_publish_shaper.cpp
+//
+// Unit tests for the publish_shaper class in the Paho MQTT C++ library.
+//
+
+/*******************************************************************************
+ * Copyright (c) 2025 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - Initial implementation
+ *******************************************************************************/
+
+#define UNIT_TESTS
+
+#include <chrono>
+#include <stdexcept>
+#include <string>
+
+#include "catch2_version.h"
+#include "mqtt/publish_shaper.h"
+
+using namespace mqtt;
+using namespace std::chrono;
+
+using action = publish_shaper::action;
+
+/////////////////////////////////////////////////////////////////////////////
+
+static const_message_ptr msg(const string& topic, const string& payload = "x")
+{
+    return make_message(topic, payload);
+}
+
+TEST_CASE("publish_shaper no rules", "[shaper]")
+{
+    publish_shaper shaper;
+    REQUIRE(shaper.empty());
+
+    for (int i = 0; i < 100; ++i) REQUIRE(action::SEND == shaper.admit(msg("a/b")).act);
+
+    REQUIRE_THROWS_AS(shaper.add_rule("a/#", 0.0), std::invalid_argument);
+}
+
+TEST_CASE("publish_shaper unmatched topics", "[shaper]")
+{
+    publish_shaper shaper;
+    shaper.add_rule("slow/#", 1.0, 1, shape_policy::DROP);
+    REQUIRE(1 == shaper.size());
+
+    REQUIRE(action::SEND == shaper.admit(msg("slow/a")).act);
+    REQUIRE(action::DROP == shaper.admit(msg("slow/b")).act);
+
+    // Other topics aren't limited
+    for (int i = 0; i < 10; ++i) REQUIRE(action::SEND == shaper.admit(msg("fast/a")).act);
+    REQUIRE(1 == shaper.num_dropped());
+
+    REQUIRE(shaper.remove_rule("slow/#"));
+    REQUIRE(!shaper.remove_rule("slow/#"));
+    REQUIRE(action::SEND == shaper.admit(msg("slow/c")).act);
+}
+
+TEST_CASE("publish_shaper burst", "[shaper]")
+{
+    publish_shaper shaper;
+    shaper.add_rule("data/+", 1.0, 3, shape_policy::DROP);
+
+    // The topics for the filter share the bucket
+    REQUIRE(action::SEND == shaper.admit(msg("data/a")).act);
+    REQUIRE(action::SEND == shaper.admit(msg("data/b")).act);
+    REQUIRE(action::SEND == shaper.admit(msg("data/c")).act);
+    REQUIRE(action::DROP == shaper.admit(msg("data/a")).act);
+}
+
+TEST_CASE("publish_shaper delay", "[shaper]")
+{
+    publish_shaper shaper;
+    shaper.add_rule("data/#", 10.0, 1, shape_policy::DELAY);
+
+    REQUIRE(action::SEND == shaper.admit(msg("data/a")).act);
+
+    // One that can't wait doesn't take a slot
+    auto d = shaper.admit(msg("data/a"), false);
+    REQUIRE(action::WAIT == d.act);
+    REQUIRE(d.delay > milliseconds(50));
+    REQUIRE(d.delay <= milliseconds(100));
+    REQUIRE(0 == shaper.num_delayed());
+
+    // Those that wait are spaced out at the rate
+    d = shaper.admit(msg("data/a"));
+    REQUIRE(action::WAIT == d.act);
+    REQUIRE(d.delay <= milliseconds(100));
+
+    d = shaper.admit(msg("data/a"));
+    REQUIRE(action::WAIT == d.act);
+    REQUIRE(d.delay > milliseconds(150));
+    REQUIRE(2 == shaper.num_delayed());
+}
+
+TEST_CASE("publish_shaper coalesce", "[shaper]")
+{
+    publish_shaper shaper;
+    shaper.add_rule("data/#", 10.0, 1, shape_policy::COALESCE);
+
+    REQUIRE(action::SEND == shaper.admit(msg("data/a", "1")).act);
+
+    auto d = shaper.admit(msg("data/a", "2"));
+    REQUIRE(action::HOLD == d.act);
+    REQUIRE(d.delay <= milliseconds(100));
+
+    // Later ones replace the held message
+    REQUIRE(action::COALESCED == shaper.admit(msg("data/a", "3")).act);
+    REQUIRE(action::COALESCED == shaper.admit(msg("data/a", "4")).act);
+    REQUIRE(2 == shaper.num_coalesced());
+
+    // Each topic is held on its own
+    REQUIRE(action::HOLD == shaper.admit(msg("data/b", "5")).act);
+
+    auto m = shaper.release("data/a");
+    REQUIRE(m);
+    REQUIRE("4" == m->to_string());
+    REQUIRE(!shaper.release("data/a"));
+
+    REQUIRE("5" == shaper.release("data/b")->to_string());
+}
+
+TEST_CASE("publish_shaper first rule", "[shaper]")
+{
+    publish_shaper shaper;
+    shaper.add_rule("data/#", 1.0, 1, shape_policy::DROP);
+    shaper.add_rule("data/critical", 1000.0, 100, shape_policy::DROP);
+
+    // The earlier, broader rule is the one that applies
+    REQUIRE(action::SEND == shaper.admit(msg("data/critical")).act);
+    REQUIRE(action::DROP == shaper.admit(msg("data/critical")).act);
+
+    // Replacing a rule keeps its place, with a full bucket
+    shaper.add_rule("data/#", 1000.0, 100, shape_policy::DROP);
+    REQUIRE(2 == shaper.size());
+    for (int i = 0; i < 10; ++i) REQUIRE(action::SEND == shaper.admit(msg("data/critical")).act);
+}
@@ -0,0 +1,101 @@
+// test_publish_window.cpp
+//
+// Unit tests for the publish_window class in the Paho MQTT C++ library.
+//
+
+/*******************************************************************************
+ * Copyright (c) 2025 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+#define UNIT_TESTS
+
+#include <chrono>
+#include <thread>
+
+#include "catch2_version.h"
+#include "mqtt/publish_window.h"
+
+using namespace std::chrono;
+using namespace mqtt;
+
+// --------------------------------------------------------------------------
+
+TEST_CASE("publish_window ctor", "[window]")
+{
+    publish_window win{10, 1024};
+    REQUIRE(10 == win.max_messages());
+    REQUIRE(1024 == win.max_bytes());
+    REQUIRE(0 == win.messages());
+    REQUIRE(0 == win.bytes());
+}
+
+TEST_CASE("publish_window message limit", "[window]")
+{
+    publish_window win{2};
+
+    REQUIRE(win.try_acquire(100));
+    REQUIRE(win.try_acquire(100));
+    REQUIRE(!win.try_acquire(100));
+    REQUIRE(2 == win.messages());
+    REQUIRE(200 == win.bytes());
+
+    win.release(100);
+    REQUIRE(1 == win.messages());
+    REQUIRE(win.try_acquire(100));
+}
+
+TEST_CASE("publish_window byte limit", "[window]")
+{
+    publish_window win{0, 100};
+
+    REQUIRE(win.try_acquire(60));
+    REQUIRE(!win.try_acquire(60));
+    REQUIRE(win.try_acquire(40));
+    REQUIRE(!win.try_acquire(1));
+
+    win.release(60);
+    win.release(40);
+    REQUIRE(0 == win.bytes());
+
+    // A large message fits in an empty window
+    REQUIRE(win.try_acquire(1000));
+    REQUIRE(!win.try_acquire(1));
+}
+
+TEST_CASE("publish_window timed acquire", "[window]")
+{
+    publish_window win{1};
+    REQUIRE(win.try_acquire(1));
+
+    auto start = steady_clock::now();
+    REQUIRE(!win.try_acquire_for(1, milliseconds(25)));
+    REQUIRE(steady_clock::now() - start >= milliseconds(20));
+}
+
+TEST_CASE("publish_window blocking acquire", "[window]")
+{
+    publish_window win{1};
+    win.acquire(1);
+
+    std::thread thr([&win] {
+        std::this_thread::sleep_for(milliseconds(10));
+        win.release(1);
+    });
+
+    // Blocks until the other thread releases
+    win.acquire(1);
+    REQUIRE(1 == win.messages());
+    thr.join();
+}
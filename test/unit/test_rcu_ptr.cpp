@@ -0,0 +1,83 @@
+// test_rcu_ptr.cpp
+//
+// Unit tests for the rcu_ptr class template in the Paho MQTT C++ library.
+//
+
+/*******************************************************************************
+ * Copyright (c) 2025 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+#define UNIT_TESTS
+
+#include <atomic>
+#include <functional>
+#include <string>
+#include <thread>
+
+#include "catch2_version.h"
+#include "mqtt/rcu_ptr.h"
+
+using namespace mqtt;
+
+// --------------------------------------------------------------------------
+
+TEST_CASE("rcu_ptr default ctor", "[rcu_ptr]")
+{
+    rcu_ptr<std::string> p;
+    REQUIRE(!p.load());
+}
+
+TEST_CASE("rcu_ptr store", "[rcu_ptr]")
+{
+    rcu_ptr<std::string> p;
+
+    p.store(std::string{"hello"});
+    auto snap = p.load();
+    REQUIRE(snap);
+    REQUIRE("hello" == *snap);
+
+    // A snapshot survives a replacement
+    p.store(std::string{"bye"});
+    REQUIRE("hello" == *snap);
+    REQUIRE("bye" == *p.load());
+
+    p.reset();
+    REQUIRE(!p.load());
+    REQUIRE("hello" == *snap);
+}
+
+TEST_CASE("rcu_ptr concurrent", "[rcu_ptr]")
+{
+    rcu_ptr<std::function<int()>> p;
+    p.store(std::function<int()>{[] { return 1; }});
+
+    std::atomic<bool> done{false};
+    std::atomic<bool> ok{true};
+
+    std::thread rdr([&] {
+        while (!done) {
+            auto fn = p.load();
+            if (!fn || (*fn)() < 1)
+                ok = false;
+        }
+    });
+
+    for (int i = 2; i < 1000; ++i) p.store(std::function<int()>{[i] { return i; }});
+
+    done = true;
+    rdr.join();
+    REQUIRE(ok);
+    REQUIRE(999 == (*p.load())());
+}
@@ -0,0 +1,97 @@
+// test_reconnect_backoff.cpp
+//
+// Unit tests for the reconnect_backoff class in the Paho MQTT C++ library.
+//
+
+/*******************************************************************************
+ * Copyright (c) 2025 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - Initial implementation
+ *******************************************************************************/
+
+#define UNIT_TESTS
+
+#include <set>
+#include <stdexcept>
+
+#include "catch2_version.h"
+#include "mqtt/reconnect_backoff.h"
+
+using namespace mqtt;
+using namespace std::chrono;
+
+/////////////////////////////////////////////////////////////////////////////
+
+TEST_CASE("reconnect_backoff constructor", "[backoff]")
+{
+    reconnect_backoff backoff{milliseconds{100}, seconds{30}};
+    REQUIRE(milliseconds{100} == backoff.min_delay());
+    REQUIRE(milliseconds{30000} == backoff.max_delay());
+
+    REQUIRE_THROWS_AS(reconnect_backoff(milliseconds{0}, seconds{1}), std::invalid_argument);
+    REQUIRE_THROWS_AS(reconnect_backoff(seconds{2}, seconds{1}), std::invalid_argument);
+}
+
+TEST_CASE("reconnect_backoff jitter", "[backoff]")
+{
+    auto backoff = reconnect_backoff::create(milliseconds{100}, seconds{10});
+    std::set<milliseconds::rep> delays;
+    auto prev = milliseconds{100};
+
+    for (int i = 0; i < 50; ++i) {
+        auto d = backoff->next_delay();
+        REQUIRE(d >= milliseconds{100});
+        REQUIRE(d <= seconds{10});
+        REQUIRE(d <= 3 * prev);
+        delays.insert(d.count());
+        prev = d;
+    }
+
+    // The delays are spread out, not a fixed sequence
+    REQUIRE(delays.size() > 10);
+
+    // Starting over gets back down to the minimum range
+    backoff->reset();
+    REQUIRE(backoff->next_delay() <= milliseconds{300});
+}
+
+TEST_CASE("reconnect_backoff hint", "[backoff]")
+{
+    reconnect_backoff backoff{milliseconds{10}, milliseconds{20}};
+
+    backoff.hint(seconds{5});
+    REQUIRE(seconds{5} == backoff.next_delay());
+
+    // The hint is only used once
+    REQUIRE(backoff.next_delay() <= milliseconds{20});
+}
+
+TEST_CASE("reconnect_backoff rate limit", "[backoff]")
+{
+    reconnect_backoff backoff{milliseconds{1}, milliseconds{1}};
+    backoff.set_rate_limit(1.0, 3);
+
+    // The burst goes out right away, then one per second
+    for (int i = 0; i < 3; ++i) REQUIRE(backoff.next_delay() <= milliseconds{5});
+
+    auto d = backoff.next_delay();
+    REQUIRE(d >= milliseconds{900});
+    REQUIRE(d <= milliseconds{1100});
+
+    d = backoff.next_delay();
+    REQUIRE(d >= milliseconds{1900});
+
+    // Removing the limit
+    backoff.set_rate_limit(0.0);
+    REQUIRE(backoff.next_delay() <= milliseconds{5});
+}
@@ -0,0 +1,121 @@
+// test_retained_cache.cpp
+//
+// Unit tests for the retained_cache class in the Paho MQTT C++ library.
+//
+
+/*******************************************************************************
+ * Copyright (c) 2025 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - Initial implementation
+ *******************************************************************************/
+
+
+#define UNIT_TESTS
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "catch2_version.h"
+#include "mqtt/retained_cache.h"
+
+using namespace mqtt;
+
+/////////////////////////////////////////////////////////////////////////////
+
+static const_message_ptr retained(const string& topic, const string& payload)
+{
+    return make_message(topic, payload, 1, true);
+}
+
+static std::vector<string> topics(const std::vector<const_message_ptr>& msgs)
+{
+    std::vector<string> v;
+    for (const auto& msg : msgs) v.push_back(msg->get_topic());
+    std::sort(v.begin(), v.end());
+    return v;
+}
+
+TEST_CASE("retained_cache update", "[retained]")
+{
+    retained_cache cache;
+    REQUIRE(cache.empty());
+
+    cache.update(retained("a/b", "1"));
+    cache.update(retained("a/c", "2"));
+    REQUIRE(2 == cache.size());
+    REQUIRE("1" == cache.get("a/b")->get_payload_str());
+
+    // A new message replaces the old one
+    cache.update(retained("a/b", "3"));
+    REQUIRE(2 == cache.size());
+    REQUIRE("3" == cache.get("a/b")->get_payload_str());
+
+    // An empty payload clears the topic
+    cache.update(retained("a/b", ""));
+    REQUIRE(1 == cache.size());
+    REQUIRE(!cache.get("a/b"));
+
+    // ...even if it wasn't there
+    cache.update(retained("x/y", ""));
+    REQUIRE(1 == cache.size());
+    cache.update(const_message_ptr{});
+
+    cache.clear();
+    REQUIRE(cache.empty());
+    REQUIRE(!cache.get("a/c"));
+}
+
+TEST_CASE("retained_cache get retained", "[retained]")
+{
+    auto cache = retained_cache::create();
+
+    cache->update(retained("home/kitchen/temp", "21"));
+    cache->update(retained("home/kitchen/light", "on"));
+    cache->update(retained("home/garage/temp", "12"));
+    cache->update(retained("office/temp", "20"));
+
+    using strvec = std::vector<string>;
+
+    REQUIRE(
+        strvec{"home/garage/temp", "home/kitchen/light", "home/kitchen/temp"} ==
+        topics(cache->get_retained("home/#"))
+    );
+    REQUIRE(
+        strvec{"home/garage/temp", "home/kitchen/temp"} == topics(cache->get_retained("home/+/temp"))
+    );
+    REQUIRE(strvec{"office/temp"} == topics(cache->get_retained("office/temp")));
+    REQUIRE(4 == cache->get_retained("#").size());
+    REQUIRE(cache->get_retained("garage/#").empty());
+
+    // Removed topics are no longer found
+    cache->update(retained("home/kitchen/light", ""));
+    REQUIRE(strvec{"home/kitchen/temp"} == topics(cache->get_retained("home/kitchen/#")));
+}
+
+TEST_CASE("retained_cache churn", "[retained]")
+{
+    retained_cache cache;
+
+    // Enough topics come and go for the tree to be pruned along the way
+    for (int i = 0; i < 3000; ++i) {
+        auto topic = "dev/" + std::to_string(i) + "/state";
+        cache.update(retained(topic, "up"));
+        cache.update(retained(topic, ""));
+    }
+    REQUIRE(cache.empty());
+    REQUIRE(cache.get_retained("#").empty());
+
+    cache.update(retained("dev/1/state", "up"));
+    REQUIRE(1 == cache.get_retained("dev/+/state").size());
+}
@@ -0,0 +1,118 @@
+// test_rpc_client.cpp
+//
+// Unit tests for the rpc_client class in the Paho MQTT C++ library.
+//
+
+/*******************************************************************************
+ * Copyright (c) 2025 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - Initial implementation
+ *******************************************************************************/
+
+#define UNIT_TESTS
+
+#include <chrono>
+#include <future>
+#include <string>
+
+#include "catch2_version.h"
+#include "mqtt/rpc_client.h"
+
+using namespace mqtt;
+using namespace std::chrono;
+
+/////////////////////////////////////////////////////////////////////////////
+
+static const string SERVER_URI{"tcp://localhost:1883"};
+
+// A client that queues its publishes while disconnected, so that the
+// calls can be made without a server.
+static async_client make_client()
+{
+    return async_client{create_options_builder()
+                            .server_uri(SERVER_URI)
+                            .client_id("rpc")
+                            .offline_buffer(offline_buffer::create(64))
+                            .finalize()};
+}
+
+static const_message_ptr response(const string& corrId, const string& payload)
+{
+    return message_ptr_builder()
+        .topic("replies/rpc")
+        .payload(payload)
+        .properties({{property::CORRELATION_DATA, corrId}})
+        .finalize();
+}
+
+TEST_CASE("rpc_client response", "[rpc]")
+{
+    auto cli = make_client();
+    rpc_client rpc{cli, "replies/rpc"};
+    REQUIRE("replies/rpc" == rpc.get_reply_topic());
+
+    auto fut1 = rpc.call("requests/add", "[ 1, 2 ]", seconds(10));
+    auto fut2 = rpc.call("requests/add", "[ 3, 4 ]", seconds(10));
+    REQUIRE(2 == rpc.pending_calls());
+
+    // Out of order, with an unknown one mixed in
+    rpc.deliver(response("2", "7"));
+    rpc.deliver(response("99", "0"));
+    rpc.deliver(response("1", "3"));
+
+    REQUIRE(std::future_status::ready == fut1.wait_for(seconds(1)));
+    REQUIRE("3" == fut1.get()->to_string());
+    REQUIRE("7" == fut2.get()->to_string());
+    REQUIRE(0 == rpc.pending_calls());
+}
+
+TEST_CASE("rpc_client timeout", "[rpc]")
+{
+    auto cli = make_client();
+    rpc_client rpc{cli, "replies/rpc", 1, 4, milliseconds(1)};
+
+    auto fut = rpc.call("requests/add", "[ 1, 2 ]", milliseconds(20));
+    auto futLong = rpc.call("requests/add", "[ 3, 4 ]", seconds(10));
+
+    REQUIRE(std::future_status::ready == fut.wait_for(seconds(2)));
+    REQUIRE_THROWS_AS(fut.get(), timeout_error);
+    REQUIRE(1 == rpc.timeouts());
+    REQUIRE(1 == rpc.pending_calls());
+
+    // A late response for the timed-out call is ignored
+    rpc.deliver(response("1", "3"));
+    rpc.deliver(response("2", "7"));
+    REQUIRE("7" == futLong.get()->to_string());
+    REQUIRE(0 == rpc.pending_calls());
+}
+
+TEST_CASE("rpc_client destroyed", "[rpc]")
+{
+    auto cli = make_client();
+    rpc_client::future_type fut;
+    {
+        rpc_client rpc{cli, "replies/rpc"};
+        fut = rpc.call("requests/add", "[ 1, 2 ]", seconds(10));
+    }
+    REQUIRE(std::future_status::ready == fut.wait_for(seconds(0)));
+    REQUIRE_THROWS_AS(fut.get(), exception);
+}
+
+TEST_CASE("rpc_client publish error", "[rpc]")
+{
+    async_client cli{SERVER_URI, "rpc"};
+    rpc_client rpc{cli, "replies/rpc"};
+
+    REQUIRE_THROWS_AS(rpc.call("requests/add", "[ 1, 2 ]", seconds(10)), exception);
+    REQUIRE(0 == rpc.pending_calls());
+}
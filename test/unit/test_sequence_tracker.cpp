@@ -0,0 +1,100 @@
+// test_sequence_tracker.cpp
+//
+// Unit tests for the sequence_tracker class in the Paho MQTT C++ library.
+//
+
+/*******************************************************************************
+ * Copyright (c) 2025 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - Initial implementation
+ *******************************************************************************/
+
+#define UNIT_TESTS
+
+#include <string>
+
+#include "catch2_version.h"
+#include "mqtt/sequence_tracker.h"
+
+using namespace mqtt;
+
+/////////////////////////////////////////////////////////////////////////////
+
+static message_ptr with_seq(const string& topic, const string& seq)
+{
+    auto msg = make_message(topic, "x", 1, false);
+    msg->set_properties(properties{{property::USER_PROPERTY, "seq", seq}});
+    return msg;
+}
+
+using result = sequence_tracker::result;
+
+TEST_CASE("sequence_tracker in order", "[sequence]")
+{
+    sequence_tracker trk;
+    REQUIRE("seq" == trk.get_property_name());
+
+    REQUIRE(result::FIRST == trk.check(*with_seq("a", "1")));
+    REQUIRE(result::IN_ORDER == trk.check(*with_seq("a", "2")));
+    REQUIRE(result::FIRST == trk.check(*with_seq("b", "7")));
+    REQUIRE(result::IN_ORDER == trk.check(*with_seq("a", "3")));
+
+    REQUIRE(3 == *trk.last_sequence("a"));
+    REQUIRE(7 == *trk.last_sequence("b"));
+    REQUIRE(!trk.last_sequence("c"));
+
+    auto stats = trk.get_stats();
+    REQUIRE(4 == stats.msgsTracked);
+    REQUIRE(0 == stats.gaps);
+    REQUIRE(0 == stats.duplicates);
+    REQUIRE(0 == stats.outOfOrder);
+    REQUIRE(2 == stats.topics);
+}
+
+TEST_CASE("sequence_tracker gaps and reordering", "[sequence]")
+{
+    sequence_tracker trk;
+
+    trk.check("a", 1);
+    REQUIRE(result::GAP == trk.check("a", 5));
+    REQUIRE(result::OUT_OF_ORDER == trk.check("a", 3));
+    REQUIRE(result::DUPLICATE == trk.check("a", 5));
+    REQUIRE(result::IN_ORDER == trk.check("a", 6));
+
+    auto stats = trk.get_stats();
+    REQUIRE(5 == stats.msgsTracked);
+    REQUIRE(3 == stats.gaps);
+    REQUIRE(1 == stats.duplicates);
+    REQUIRE(1 == stats.outOfOrder);
+
+    trk.clear();
+    REQUIRE(0 == trk.get_stats().msgsTracked);
+    REQUIRE(0 == trk.get_stats().topics);
+}
+
+TEST_CASE("sequence_tracker untracked", "[sequence]")
+{
+    sequence_tracker trk{"id"};
+
+    REQUIRE(result::UNTRACKED == trk.check(*make_message("a", "x")));
+    REQUIRE(result::UNTRACKED == trk.check(*with_seq("a", "1")));
+
+    auto msg = make_message("a", "x");
+    msg->set_properties(properties{{property::USER_PROPERTY, "id", "12x"}});
+    REQUIRE(!trk.sequence_of(*msg));
+    REQUIRE(result::UNTRACKED == trk.check(*msg));
+
+    msg->set_properties(properties{{property::USER_PROPERTY, "id", "12"}});
+    REQUIRE(12 == *trk.sequence_of(*msg));
+    REQUIRE(0 == trk.get_stats().msgsTracked);
+}
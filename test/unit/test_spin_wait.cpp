@@ -0,0 +1,71 @@
+// test_spin_wait.cpp
+//
+// Unit tests for the spin_wait class in the Paho MQTT C++ library.
+//
+
+/*******************************************************************************
+ * Copyright (c) 2025 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - Initial implementation
+ *******************************************************************************/
+
+
+#define UNIT_TESTS
+
+#include "catch2_version.h"
+#include "mqtt/spin_wait.h"
+
+using namespace mqtt;
+
+/////////////////////////////////////////////////////////////////////////////
+
+TEST_CASE("spin_wait default", "[spin_wait]")
+{
+    spin_wait sw;
+    REQUIRE(0 == sw.spins());
+    REQUIRE(0 == sw.yields());
+    REQUIRE(!sw.enabled());
+
+    // Checks the condition once
+    int n = 0;
+    REQUIRE(!sw([&n] { return ++n > 100; }));
+    REQUIRE(1 == n);
+
+    n = 0;
+    REQUIRE(sw([&n] { return ++n > 0; }));
+}
+
+TEST_CASE("spin_wait spins and yields", "[spin_wait]")
+{
+    spin_wait sw{10, 5};
+    REQUIRE(10 == sw.spins());
+    REQUIRE(5 == sw.yields());
+    REQUIRE(sw.enabled());
+    REQUIRE(spin_wait{0, 1}.enabled());
+
+    // Gives up after all the spins and yields, and a last check
+    int n = 0;
+    REQUIRE(!sw([&n] {
+        ++n;
+        return false;
+    }));
+    REQUIRE(16 == n);
+
+    // Stops as soon as the condition is met
+    n = 0;
+    REQUIRE(sw([&n] { return ++n == 12; }));
+    REQUIRE(12 == n);
+
+    REQUIRE(spin_wait{10, 5} == sw);
+    REQUIRE(spin_wait{10} != sw);
+}
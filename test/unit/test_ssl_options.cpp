@@ -23,6 +23,11 @@
 
 #define UNIT_TESTS
 
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+
 #include "catch2_version.h"
 #include "mqtt/ssl_options.h"
 
@@ -406,3 +411,38 @@ TEST_CASE("ssl_options test error handler", "[options]")
         std::cerr << "SSL Error: " << msg << std::endl;
     });
 }
+
+TEST_CASE("ssl_options in-memory pem", "[options]")
+{
+    const std::string PEM{"-----BEGIN CERTIFICATE-----\nMIIB\n-----END CERTIFICATE-----\n"};
+    std::string path;
+
+    {
+        auto pem = pem_file::create(PEM);
+        path = pem->path();
+
+        std::ifstream is{path, std::ios::binary};
+        std::string contents{std::istreambuf_iterator<char>{is}, {}};
+        REQUIRE(PEM == contents);
+
+        auto opts = ssl_options_builder().trust_store(pem).private_key(pem).finalize();
+        REQUIRE(path == opts.get_trust_store());
+        REQUIRE(path == opts.get_private_key());
+        REQUIRE(0 == strcmp(path.c_str(), opts.c_struct().trustStore));
+
+        // The file is shared by the copies, and outlives the original ptr
+        ssl_options opts2{opts};
+        pem.reset();
+        opts = ssl_options{};
+        REQUIRE(std::ifstream{path}.good());
+        REQUIRE(path == opts2.get_trust_store());
+
+        // Replacing it with a path drops the reference
+        opts2.set_trust_store(TRUST_STORE);
+        REQUIRE(std::ifstream{path}.good());
+        opts2.set_private_key(PRIVATE_KEY);
+    }
+
+    // Removed with the last reference
+    REQUIRE(!std::ifstream{path}.good());
+}
@@ -0,0 +1,76 @@
+// test_static_topic_filter.cpp
+//
+// Unit tests for the static_topic_filter class in the Paho MQTT C++
+// library.
+//
+
+/*******************************************************************************
+ * Copyright (c) 2025 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+#define UNIT_TESTS
+
+#include <string>
+
+#include "catch2_version.h"
+#include "mqtt/static_topic_filter.h"
+#include "mqtt/topic.h"
+
+using namespace mqtt;
+
+/////////////////////////////////////////////////////////////////////////////
+
+// The layout and matching can be done at compile time
+static constexpr static_topic_filter TEMP_FILTER{"sensors/+/temp"};
+
+static_assert(TEMP_FILTER.num_fields() == 3);
+static_assert(TEMP_FILTER.has_wildcards());
+static_assert(TEMP_FILTER.matches("sensors/engine/temp"));
+static_assert(!TEMP_FILTER.matches("sensors/engine/pressure"));
+static_assert(!static_topic_filter{"sensors/temp"}.has_wildcards());
+
+TEST_CASE("static filter layout", "[topic_filter]")
+{
+    REQUIRE("sensors/+/temp" == TEMP_FILTER.str());
+
+    REQUIRE(0 == static_topic_filter{""}.num_fields());
+    REQUIRE(1 == static_topic_filter{"#"}.num_fields());
+    REQUIRE(2 == static_topic_filter{"/"}.num_fields());
+    REQUIRE(4 == static_topic_filter{"a/+/b/#"}.num_fields());
+}
+
+TEST_CASE("static filter matches", "[topic_filter]")
+{
+    const char* FILTERS[] = {
+        "foo/bar", "foo/+", "foo/+/baz", "foo/+/#", "A/B/+/#", "#", "/#",
+        "$SYS/bar", "$SYS/#", "foo/#", "+/bar", "test/6/#", "+", "+/+", "",
+    };
+    const char* TOPICS[] = {
+        "foo/bar", "foo/bar/baz", "A/B/B/C", "/foo/bar", "$SYS/bar", "foo/$bar",
+        "foo/$bar/baz", "test/3", "foo", "foo/bar/bar", "fo2/bar/baz", "foo/",
+        "/", "", "$BOB/bar",
+    };
+
+    // Should give the same results as the runtime filter
+    for (auto filter : FILTERS) {
+        static_topic_filter sfilt{filter};
+        topic_filter filt{filter};
+
+        for (auto topic : TOPICS) {
+            INFO("filter: '" << filter << "', topic: '" << topic << "'");
+            REQUIRE(filt.matches(topic) == sfilt.matches(topic));
+        }
+    }
+}
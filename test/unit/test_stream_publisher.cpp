@@ -0,0 +1,66 @@
+// test_stream_publisher.cpp
+//
+// Unit tests for the stream_publisher class in the Paho MQTT C++ library.
+//
+
+/*******************************************************************************
+ * Copyright (c) 2025 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - Initial implementation
+ *******************************************************************************/
+
+#define UNIT_TESTS
+
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+#include "catch2_version.h"
+#include "mqtt/stream_publisher.h"
+
+using namespace mqtt;
+
+/////////////////////////////////////////////////////////////////////////////
+
+static const string SERVER_URI{"tcp://localhost:1883"};
+static const string TOPIC{"firmware/image"};
+
+TEST_CASE("stream_publisher ctor", "[stream]")
+{
+    async_client cli{SERVER_URI, "stream"};
+
+    stream_publisher pub{cli, TOPIC};
+    REQUIRE(TOPIC == pub.get_topic());
+    REQUIRE(stream_publisher::DFLT_CHUNK_SIZE == pub.get_chunk_size());
+    REQUIRE(stream_publisher::DFLT_MAX_IN_FLIGHT == pub.get_max_in_flight());
+    REQUIRE(string{sequence_tracker::DFLT_PROPERTY_NAME} == pub.get_sequence_property());
+    REQUIRE(0 == pub.chunks());
+
+    pub.set_sequence_property("chunk");
+    REQUIRE("chunk" == pub.get_sequence_property());
+
+    REQUIRE_THROWS_AS((stream_publisher{cli, TOPIC, 1, 0}), std::invalid_argument);
+    REQUIRE_THROWS_AS((stream_publisher{cli, TOPIC, 1, 1024, 0}), std::invalid_argument);
+}
+
+TEST_CASE("stream_publisher errors", "[stream]")
+{
+    async_client cli{SERVER_URI, "stream"};
+    stream_publisher pub{cli, TOPIC, 1, 16, 2};
+
+    // Not connected, so the first chunk can't be published
+    std::istringstream is{string(100, 'x')};
+    REQUIRE_THROWS_AS(pub.publish(is), mqtt::exception);
+
+    REQUIRE_THROWS_AS(pub.publish_file("/no/such/file"), mqtt::exception);
+}
@@ -0,0 +1,114 @@
+// test_string_intern.cpp
+//
+// Unit tests for the string_intern class in the Paho MQTT C++ library.
+//
+
+/*******************************************************************************
+ * Copyright (c) 2025 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+#define UNIT_TESTS
+
+#include <string>
+
+#include "catch2_version.h"
+#include "mqtt/string_intern.h"
+
+using namespace mqtt;
+
+static const std::string TOPIC1{"some/longer/topic"};
+static const std::string TOPIC2{"some/other/topic"};
+
+// --------------------------------------------------------------------------
+
+TEST_CASE("string_intern ctor", "[intern]")
+{
+    string_intern tbl{8};
+    REQUIRE(8 == tbl.max_size());
+    REQUIRE(0 == tbl.size());
+
+    auto tblp = string_intern::create(16);
+    REQUIRE(tblp);
+    REQUIRE(16 == tblp->max_size());
+}
+
+TEST_CASE("string_intern get", "[intern]")
+{
+    string_intern tbl{8};
+
+    auto s1 = tbl.get(TOPIC1);
+    REQUIRE(TOPIC1 == s1.str());
+    REQUIRE(1 == tbl.size());
+
+    // A repeat shares the same buffer
+    auto s2 = tbl.get(std::string{TOPIC1});
+    REQUIRE(s1.ptr() == s2.ptr());
+    REQUIRE(1 == tbl.size());
+
+    auto s3 = tbl.get(TOPIC2);
+    REQUIRE(TOPIC2 == s3.str());
+    REQUIRE(s1.ptr() != s3.ptr());
+    REQUIRE(2 == tbl.size());
+}
+
+TEST_CASE("string_intern get with func", "[intern]")
+{
+    string_intern tbl{8};
+    int n = 0;
+
+    auto fn = [&n](std::string_view sv) {
+        ++n;
+        return string_ref{string{sv}};
+    };
+
+    auto s1 = tbl.get(TOPIC1, fn);
+    auto s2 = tbl.get(TOPIC1, fn);
+
+    REQUIRE(1 == n);
+    REQUIRE(TOPIC1 == s2.str());
+    REQUIRE(s1.ptr() == s2.ptr());
+}
+
+TEST_CASE("string_intern full", "[intern]")
+{
+    string_intern tbl{1};
+
+    auto s1 = tbl.get(TOPIC1);
+    auto s2 = tbl.get(TOPIC2);
+    auto s3 = tbl.get(TOPIC2);
+
+    REQUIRE(1 == tbl.size());
+    REQUIRE(TOPIC2 == s2.str());
+    REQUIRE(TOPIC2 == s3.str());
+
+    // Not added to the table, so not shared
+    REQUIRE(s2.ptr() != s3.ptr());
+
+    // ...but the first is still interned
+    REQUIRE(s1.ptr() == tbl.get(TOPIC1).ptr());
+}
+
+TEST_CASE("string_intern clear", "[intern]")
+{
+    string_intern tbl{8};
+
+    auto s1 = tbl.get(TOPIC1);
+    tbl.clear();
+    REQUIRE(0 == tbl.size());
+
+    // Outstanding references are still valid
+    REQUIRE(TOPIC1 == s1.str());
+    REQUIRE(s1.ptr() != tbl.get(TOPIC1).ptr());
+}
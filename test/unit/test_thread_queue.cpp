@@ -22,7 +22,9 @@
 #define UNIT_TESTS
 
 #include <chrono>
+#include <deque>
 #include <future>
+#include <string>
 #include <thread>
 #include <vector>
 
@@ -89,6 +91,132 @@ TEST_CASE("thread_queue tryput", "[thread_queue]")
     REQUIRE(!que.try_put_until(3, timeout));
 }
 
+TEST_CASE("thread_queue weight", "[thread_queue]")
+{
+    thread_queue<std::string> que{
+        thread_queue<std::string>::MAX_CAPACITY, 10,
+        [](const std::string& s) { return s.size(); }
+    };
+
+    REQUIRE(10 == que.max_weight());
+    REQUIRE(0 == que.weight());
+
+    REQUIRE(que.try_put("abcd"));
+    REQUIRE(que.try_put("efgh"));
+    REQUIRE(8 == que.weight());
+
+    // Too heavy to fit
+    REQUIRE(!que.try_put("ijk"));
+    REQUIRE(!que.try_put_for("ijk", 5ms));
+    REQUIRE(que.try_put("ij"));
+    REQUIRE(10 == que.weight());
+
+    REQUIRE("abcd" == que.get());
+    REQUIRE(6 == que.weight());
+    REQUIRE(que.try_put("ijk"));
+    REQUIRE(9 == que.weight());
+
+    auto vec = que.get_all();
+    REQUIRE(3 == vec.size());
+    REQUIRE(0 == que.weight());
+
+    // An empty queue always takes one item
+    REQUIRE(que.try_put("this is too heavy"));
+    REQUIRE(17 == que.weight());
+    REQUIRE(!que.try_put("a"));
+
+    que.clear();
+    REQUIRE(0 == que.weight());
+}
+
+TEST_CASE("thread_queue weight signals", "[thread_queue]")
+{
+    thread_queue<std::string> que{
+        thread_queue<std::string>::MAX_CAPACITY, 4,
+        [](const std::string& s) { return s.size(); }
+    };
+
+    que.put("abcd");
+
+    auto fut = std::async(std::launch::async, [&que] { que.put("ef"); });
+    REQUIRE(fut.wait_for(10ms) == std::future_status::timeout);
+
+    REQUIRE("abcd" == que.get());
+    REQUIRE(fut.wait_for(500ms) == std::future_status::ready);
+    REQUIRE(2 == que.weight());
+}
+
+TEST_CASE("thread_queue bulk get", "[thread_queue]")
+{
+    thread_queue<int> que;
+    std::vector<int> vec;
+
+    // Empty queue gets nothing
+    REQUIRE(que.get_all().empty());
+    REQUIRE(que.try_get_bulk(vec, 10) == 0);
+    REQUIRE(que.try_get_bulk_for(vec, 10, 5ms) == 0);
+    REQUIRE(que.try_get_bulk_until(vec, 10, steady_clock::now() + 5ms) == 0);
+    REQUIRE(vec.empty());
+
+    for (int i = 0; i < 5; ++i) que.put(i);
+
+    REQUIRE(que.try_get_bulk(vec, 3) == 3);
+    REQUIRE(vec == std::vector<int>{0, 1, 2});
+    REQUIRE(que.size() == 2);
+
+    // Appends to the vector
+    REQUIRE(que.try_get_bulk_for(vec, 10, 5ms) == 2);
+    REQUIRE(vec == std::vector<int>{0, 1, 2, 3, 4});
+    REQUIRE(que.empty());
+
+    que.put(5);
+    que.put(6);
+    REQUIRE(que.get_all() == std::vector<int>{5, 6});
+    REQUIRE(que.empty());
+}
+
+TEST_CASE("thread_queue drain", "[thread_queue]")
+{
+    thread_queue<std::string> que{
+        4, 100, [](const std::string& s) { return s.size(); }
+    };
+
+    REQUIRE(que.drain().empty());
+
+    for (auto s : {"a", "bb", "ccc", "dddd"}) que.put(s);
+    REQUIRE(10 == que.weight());
+
+    // A full queue makes room for a waiting put
+    auto fut = std::async(std::launch::async, [&que] { que.put("e"); });
+
+    auto items = que.drain();
+    REQUIRE((std::deque<std::string>{"a", "bb", "ccc", "dddd"}) == items);
+    REQUIRE(fut.wait_for(500ms) == std::future_status::ready);
+    REQUIRE(1 == que.size());
+    REQUIRE(1 == que.weight());
+
+    // Still works once closed
+    que.close();
+    REQUIRE((std::deque<std::string>{"e"}) == que.drain());
+    REQUIRE(que.done());
+}
+
+TEST_CASE("thread_queue bulk get signals", "[thread_queue]")
+{
+    thread_queue<int> que;
+    std::vector<int> vec;
+
+    auto thr = std::thread([&que] {
+        std::this_thread::sleep_for(10ms);
+        que.put(1);
+    });
+
+    // Should block until the other thread adds an item.
+    REQUIRE(que.try_get_bulk_for(vec, 10, 1s) == 1);
+    REQUIRE(vec[0] == 1);
+    thr.join();
+}
+
 TEST_CASE("thread_queue mt put/get", "[thread_queue]")
 {
     thread_queue<string> que;
@@ -185,3 +313,26 @@ TEST_CASE("thread_queue close_signals", "[thread_queue]")
 
     thr.join();
 }
+
+TEST_CASE("thread_queue spin", "[thread_queue]")
+{
+    thread_queue<int> que;
+    REQUIRE(!que.spin().enabled());
+
+    que.spin(spin_wait{1000, 10});
+    REQUIRE(spin_wait{1000, 10} == que.spin());
+
+    // A spinning get still picks up an item from another thread
+    auto fut = std::async(std::launch::async, [&que] { return que.get(); });
+    std::this_thread::sleep_for(5ms);
+    que.put(42);
+    REQUIRE(42 == fut.get());
+
+    // ...and a timed one still times out
+    int n;
+    REQUIRE(!que.try_get_for(&n, 5ms));
+
+    // ...and it doesn't spin past a close
+    que.close();
+    REQUIRE(!que.get(&n));
+}
@@ -0,0 +1,131 @@
+// test_timer_wheel.cpp
+//
+// Unit tests for the timer_wheel class in the Paho MQTT C++ library.
+//
+
+/*******************************************************************************
+ * Copyright (c) 2025 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - Initial implementation
+ *******************************************************************************/
+
+#define UNIT_TESTS
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "catch2_version.h"
+#include "mqtt/timer_wheel.h"
+
+using namespace mqtt;
+using namespace std::chrono;
+
+/////////////////////////////////////////////////////////////////////////////
+
+// Waits for a condition, up to a limit
+template <typename Pred>
+static bool wait_for_cond(Pred pred, milliseconds limit = milliseconds(2000))
+{
+    auto end = steady_clock::now() + limit;
+    while (!pred()) {
+        if (steady_clock::now() > end)
+            return false;
+        std::this_thread::sleep_for(milliseconds(1));
+    }
+    return true;
+}
+
+TEST_CASE("timer_wheel fires", "[timer_wheel]")
+{
+    timer_wheel tw{milliseconds(1)};
+    REQUIRE(milliseconds(1) == tw.tick());
+    REQUIRE(tw.empty());
+
+    std::atomic<int> n{0};
+    auto start = steady_clock::now();
+    steady_clock::time_point fired;
+
+    tw.schedule(milliseconds(20), [&] {
+        fired = steady_clock::now();
+        ++n;
+    });
+    REQUIRE(1 == tw.size());
+
+    REQUIRE(wait_for_cond([&] { return n == 1; }));
+    REQUIRE(fired - start >= milliseconds(20));
+    REQUIRE(tw.empty());
+}
+
+TEST_CASE("timer_wheel cancel", "[timer_wheel]")
+{
+    timer_wheel tw{milliseconds(1)};
+    std::atomic<int> n{0};
+
+    auto id = tw.schedule(milliseconds(20), [&] { ++n; });
+    tw.schedule(milliseconds(40), [&] { n += 10; });
+
+    REQUIRE(tw.cancel(id));
+    REQUIRE(!tw.cancel(id));
+    REQUIRE(!tw.cancel(0));
+
+    REQUIRE(wait_for_cond([&] { return n != 0; }));
+    std::this_thread::sleep_for(milliseconds(30));
+    REQUIRE(10 == n);
+}
+
+TEST_CASE("timer_wheel order across levels", "[timer_wheel]")
+{
+    timer_wheel tw{milliseconds(1)};
+
+    // Past one turn of the first level (64 ticks), so some are cascaded
+    const std::vector<int> delays{150, 5, 90, 63, 64, 65, 30};
+
+    std::mutex lock;
+    std::vector<int> order;
+
+    for (auto d : delays) {
+        tw.schedule(milliseconds(d), [&lock, &order, d] {
+            std::lock_guard<std::mutex> g{lock};
+            order.push_back(d);
+        });
+    }
+
+    REQUIRE(wait_for_cond([&] {
+        std::lock_guard<std::mutex> g{lock};
+        return order.size() == delays.size();
+    }));
+
+    // Timers in the same tick may fire in any order
+    for (size_t i = 1; i < order.size(); ++i) REQUIRE(order[i - 1] <= order[i] + 1);
+}
+
+TEST_CASE("timer_wheel many timers", "[timer_wheel]")
+{
+    constexpr int N = 10000;
+    timer_wheel tw{milliseconds(1)};
+    std::atomic<int> n{0};
+
+    std::vector<timer_wheel::timer_id> ids;
+    for (int i = 0; i < N; ++i)
+        ids.push_back(tw.schedule(milliseconds(200 + i % 100), [&] { ++n; }));
+
+    // Cancel every other one
+    for (size_t i = 0; i < ids.size(); i += 2) tw.cancel(ids[i]);
+    REQUIRE(size_t(N / 2) == tw.size());
+
+    REQUIRE(wait_for_cond([&] { return tw.empty(); }));
+    REQUIRE(N / 2 == n);
+}
@@ -199,6 +199,30 @@ TEST_CASE("token action callback", "[token]")
     REQUIRE(listener.failed());
 }
 
+// ----------------------------------------------------------------------
+// Test the notification of completion
+// ----------------------------------------------------------------------
+
+TEST_CASE("token notify on complete", "[token]")
+{
+    mqtt::token tok{TYPE, cli};
+    int n = 0;
+
+    REQUIRE(tok.notify_on_complete([&n] { ++n; }));
+    REQUIRE(tok.notify_on_complete([&n] { ++n; }));
+    REQUIRE(0 == n);
+
+    mock_async_client::succeed(&tok, nullptr);
+    REQUIRE(2 == n);
+
+    // Already complete, so not registered
+    REQUIRE(!tok.notify_on_complete([&n] { ++n; }));
+
+    // The handlers are only called once
+    mock_async_client::fail(&tok, nullptr);
+    REQUIRE(2 == n);
+}
+
 // ----------------------------------------------------------------------
 // Test wait for completion on success case
 // All wait's should succeed immediately on successful completion.
@@ -0,0 +1,92 @@
+// test_token_wait.cpp
+//
+// Unit tests for waiting on a number of tokens in the Paho MQTT C++ library.
+//
+
+/*******************************************************************************
+ * Copyright (c) 2025 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - Initial implementation
+ *******************************************************************************/
+
+
+#define UNIT_TESTS
+
+#include <chrono>
+#include <future>
+#include <thread>
+#include <vector>
+
+#include "catch2_version.h"
+#include "mock_async_client.h"
+#include "mqtt/token_wait.h"
+
+using namespace mqtt;
+using namespace std::chrono;
+
+static mock_async_client cli;
+
+static std::vector<token_ptr> make_tokens(size_t n)
+{
+    std::vector<token_ptr> toks;
+    for (size_t i = 0; i < n; ++i) toks.push_back(token::create(token::Type::PUBLISH, cli));
+    return toks;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+TEST_CASE("wait_all", "[token_wait]")
+{
+    auto toks = make_tokens(100);
+
+    // Some complete before the wait, some during it
+    for (size_t i = 0; i < 50; ++i) mock_async_client::succeed(toks[i].get(), nullptr);
+    REQUIRE(!wait_all(toks, 5ms));
+
+    auto fut = std::async(std::launch::async, [&toks] {
+        for (size_t i = 50; i < toks.size(); ++i) {
+            if (i % 2)
+                mock_async_client::succeed(toks[i].get(), nullptr);
+            else
+                mock_async_client::fail(toks[i].get(), nullptr);
+        }
+    });
+    wait_all(toks);
+    fut.get();
+
+    for (const auto& tok : toks) REQUIRE(tok->is_complete());
+    REQUIRE(wait_all(toks, 0ms));
+
+    // Nothing to wait on
+    REQUIRE(wait_all(std::vector<token_ptr>{}, 0ms));
+}
+
+TEST_CASE("wait_any", "[token_wait]")
+{
+    auto toks = make_tokens(8);
+
+    REQUIRE(toks.size() == wait_any(toks, 5ms));
+
+    auto fut = std::async(std::launch::async, [&toks] {
+        std::this_thread::sleep_for(5ms);
+        mock_async_client::succeed(toks[5].get(), nullptr);
+    });
+    REQUIRE(5 == wait_any(toks));
+    fut.get();
+
+    // The first that is already complete is found
+    mock_async_client::succeed(toks[2].get(), nullptr);
+    REQUIRE(2 == wait_any(toks, 0ms));
+
+    REQUIRE_THROWS_AS(wait_any(std::vector<token_ptr>{}), std::invalid_argument);
+}
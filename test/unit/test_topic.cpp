@@ -115,6 +115,61 @@ TEST_CASE("split", "[topic]")
     REQUIRE("name" == v[2]);
 }
 
+TEST_CASE("split view", "[topic]")
+{
+    auto same_as_split = [](const std::string& topic) {
+        auto v = topic::split(topic);
+        std::vector<std::string> fields;
+        for (auto field : topic::split_view(topic)) fields.emplace_back(field);
+        return fields == v;
+    };
+
+    REQUIRE(same_as_split(TOPIC));
+    REQUIRE(same_as_split(""));
+    REQUIRE(same_as_split("/"));
+    REQUIRE(same_as_split("a/"));
+    REQUIRE(same_as_split("/a//b"));
+
+    auto fields = topic::split_view(TOPIC);
+    auto it = fields.begin();
+    REQUIRE("my" == *it++);
+    REQUIRE("topic" == *it);
+    REQUIRE("name" == *++it);
+    REQUIRE(++it == fields.end());
+}
+
+TEST_CASE("topic is_valid_name", "[topic]")
+{
+    REQUIRE(topic::is_valid_name(TOPIC));
+    REQUIRE(topic::is_valid_name("/"));
+    REQUIRE(topic::is_valid_name("$SYS/broker/uptime"));
+
+    // Long enough to go through the blocks, with a tail
+    const std::string longTopic{"building/floor-12/room-1234/sensors/temperature/celsius"};
+    REQUIRE(topic::is_valid_name(longTopic));
+
+    REQUIRE(!topic::is_valid_name(""));
+    REQUIRE(!topic::is_valid_name(std::string(topic::MAX_LENGTH + 1, 'a')));
+    REQUIRE(topic::is_valid_name(std::string(topic::MAX_LENGTH, 'a')));
+
+    // No wildcards or nulls, anywhere in a block or the tail
+    for (size_t i = 0; i < longTopic.size(); ++i) {
+        for (char c : {'+', '#', '\0'}) {
+            auto t = longTopic;
+            t[i] = c;
+            REQUIRE(!topic::is_valid_name(t));
+        }
+    }
+
+    // UTF-8
+    REQUIRE(topic::is_valid_name("caf\xC3\xA9/\xE2\x82\xAC/\xF0\x9F\x98\x80/and/some/more/ascii"));
+    REQUIRE(!topic::is_valid_name("bad/\xC3"));         // truncated
+    REQUIRE(!topic::is_valid_name("bad/\xC0\xAF"));     // overlong
+    REQUIRE(!topic::is_valid_name("bad/\xED\xA0\x80")); // surrogate
+    REQUIRE(!topic::is_valid_name("bad/\xF4\x90\x80\x80"));  // past U+10FFFF
+    REQUIRE(!topic::is_valid_name("bad/\x80/continuation/byte/first"));
+}
+
 // ----------------------------------------------------------------------
 // Publish
 // ----------------------------------------------------------------------
@@ -138,6 +193,34 @@ TEST_CASE("publish C str", "[topic]")
 
 // ----------------------------------------------------------------------
 
+TEST_CASE("publish shares the topic", "[topic]")
+{
+    // Long enough that the name isn't kept inline in each message
+    const string LONG_TOPIC{"building/floor3/room12/temperature"};
+
+    mqtt::topic topic{
+        cli, LONG_TOPIC, QOS, RETAINED, properties{{property::CONTENT_TYPE, "text/plain"}}
+    };
+    REQUIRE(1 == topic.get_properties().size());
+
+    auto msg = topic.publish(BUF, N)->get_message();
+    auto msg2 = topic.publish(PAYLOAD, 0, false)->get_message();
+
+    REQUIRE(LONG_TOPIC == msg2->get_topic());
+    REQUIRE(msg->get_topic_ref().data() == msg2->get_topic_ref().data());
+    REQUIRE(&msg->get_properties() == &msg2->get_properties());
+    REQUIRE("text/plain" == get<string>(msg2->get_properties(), property::CONTENT_TYPE));
+    REQUIRE(0 == msg2->get_qos());
+    REQUIRE(!msg2->is_retained());
+
+    topic.set_properties(properties{});
+    REQUIRE(topic.publish(PAYLOAD)->get_message()->get_properties().empty());
+
+    REQUIRE_THROWS(mqtt::topic(cli, TOPIC, 3));
+}
+
+// ----------------------------------------------------------------------
+
 TEST_CASE("publish full C str", "[topic]")
 {
     mqtt::topic topic{cli, TOPIC};
@@ -203,6 +286,25 @@ TEST_CASE("topic has_wildcards", "[topic_filter]")
     REQUIRE(topic_filter::has_wildcards("some/multi/wild/#"));
 }
 
+TEST_CASE("topic_filter is_valid", "[topic_filter]")
+{
+    REQUIRE(topic_filter::is_valid(TOPIC));
+    REQUIRE(topic_filter::is_valid("#"));
+    REQUIRE(topic_filter::is_valid("+"));
+    REQUIRE(topic_filter::is_valid("+/+"));
+    REQUIRE(topic_filter::is_valid("some/wild/+/topic"));
+    REQUIRE(topic_filter::is_valid("some/multi/wild/#"));
+    REQUIRE(topic_filter::is_valid("$share/group/sensors/+/temperature/of/the/room/#"));
+
+    REQUIRE(!topic_filter::is_valid(""));
+    REQUIRE(!topic_filter::is_valid("some/multi/wild/#/more"));
+    REQUIRE(!topic_filter::is_valid("some/multi/wild#"));
+    REQUIRE(!topic_filter::is_valid("some/wild+/topic"));
+    REQUIRE(!topic_filter::is_valid("some/wild/+topic"));
+    REQUIRE(!topic_filter::is_valid(std::string("nul/\0/in/the/middle/of/the/filter", 33)));
+    REQUIRE(!topic_filter::is_valid("bad/\xC3/utf8"));
+}
+
 TEST_CASE("topic matches", "[topic_filter]")
 {
     SECTION("no_wildcards")
@@ -273,5 +375,44 @@ TEST_CASE("topic matches", "[topic_filter]")
         REQUIRE(!topic_filter{"#"}.matches("$SYS/bar"));
         REQUIRE(!topic_filter{"$BOB/bar"}.matches("$SYS/bar"));
         REQUIRE(!topic_filter{"+/bar"}.matches("$SYS/bar"));
+        REQUIRE(!topic_filter{"foo/bar"}.matches(""));
+        REQUIRE(!topic_filter{"foo/#"}.matches("foo"));
+    }
+
+    SECTION("captures")
+    {
+        std::vector<std::string_view> caps;
+
+        REQUIRE(topic_filter{"site/+/device/+/temp"}.match("site/a/device/b/temp", caps));
+        REQUIRE(2 == caps.size());
+        REQUIRE("a" == caps[0]);
+        REQUIRE("b" == caps[1]);
+
+        REQUIRE(topic_filter{"site/+/device/#"}.match("site/a/device/b/temp", caps));
+        REQUIRE(2 == caps.size());
+        REQUIRE("a" == caps[0]);
+        REQUIRE("b/temp" == caps[1]);
+
+        REQUIRE(topic_filter{"#"}.match("/foo/bar", caps));
+        REQUIRE(1 == caps.size());
+        REQUIRE("/foo/bar" == caps[0]);
+
+        REQUIRE(topic_filter{"foo/+"}.match("foo/", caps));
+        REQUIRE(1 == caps.size());
+        REQUIRE(caps[0].empty());
+
+        REQUIRE(topic_filter{"foo/bar"}.match("foo/bar", caps));
+        REQUIRE(caps.empty());
+
+        REQUIRE(!topic_filter{"foo/+"}.match("foo/bar/baz", caps));
+        REQUIRE(!topic_filter{"+/bar"}.match("$SYS/bar", caps));
+    }
+
+    SECTION("string_ref")
+    {
+        string_ref topic{"my/topic/name"};
+        REQUIRE(topic_filter{"my/+/name"}.matches(topic));
+        REQUIRE(!topic_filter{"my/+/id"}.matches(topic));
+        REQUIRE(!topic_filter{"my/#"}.matches(string_ref{}));
     }
 }
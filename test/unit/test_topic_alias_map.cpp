@@ -0,0 +1,119 @@
+// test_topic_alias_map.cpp
+//
+// Unit tests for the topic_alias_map class in the Paho MQTT C++ library.
+//
+
+/*******************************************************************************
+ * Copyright (c) 2025 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - Initial implementation
+ *******************************************************************************/
+
+#define UNIT_TESTS
+
+#include "catch2_version.h"
+#include "mqtt/topic_alias_map.h"
+
+using namespace mqtt;
+
+/////////////////////////////////////////////////////////////////////////////
+
+TEST_CASE("topic_alias_map limit", "[topic_alias]")
+{
+    topic_alias_map aliases{8};
+    bool known = true;
+
+    // No aliases until reset for a connection
+    REQUIRE(8 == aliases.max_aliases());
+    REQUIRE(0 == aliases.limit());
+    REQUIRE(0 == aliases.get("a/b", known));
+    REQUIRE(!known);
+
+    // The server limit applies when it's lower
+    aliases.reset(4);
+    REQUIRE(4 == aliases.limit());
+
+    aliases.reset(100);
+    REQUIRE(8 == aliases.limit());
+
+    // A server that doesn't accept aliases
+    aliases.reset(0);
+    REQUIRE(0 == aliases.get("a/b", known));
+}
+
+TEST_CASE("topic_alias_map get", "[topic_alias]")
+{
+    topic_alias_map aliases{8};
+    aliases.reset(8);
+    bool known = true;
+
+    REQUIRE(1 == aliases.get("a/b", known));
+    REQUIRE(!known);
+    REQUIRE(2 == aliases.get("a/c", known));
+    REQUIRE(!known);
+
+    REQUIRE(1 == aliases.get("a/b", known));
+    REQUIRE(known);
+    REQUIRE(2 == aliases.size());
+
+    // A new connection starts over
+    aliases.reset(8);
+    REQUIRE(0 == aliases.size());
+    REQUIRE(1 == aliases.get("a/c", known));
+    REQUIRE(!known);
+}
+
+TEST_CASE("topic_alias_map lru", "[topic_alias]")
+{
+    topic_alias_map aliases{2};
+    aliases.reset(10);
+    bool known;
+
+    REQUIRE(1 == aliases.get("a", known));
+    REQUIRE(2 == aliases.get("b", known));
+    REQUIRE(1 == aliases.get("a", known));
+
+    // "b" is the least recently used, so its alias goes to "c"
+    REQUIRE(2 == aliases.get("c", known));
+    REQUIRE(!known);
+    REQUIRE(2 == aliases.size());
+
+    REQUIRE(1 == aliases.get("a", known));
+    REQUIRE(known);
+
+    // "b" comes back with the alias from "c"
+    REQUIRE(2 == aliases.get("b", known));
+    REQUIRE(!known);
+}
+
+TEST_CASE("topic_alias_map remove", "[topic_alias]")
+{
+    topic_alias_map aliases{3};
+    aliases.reset(3);
+    bool known;
+
+    REQUIRE(1 == aliases.get("a", known));
+    REQUIRE(2 == aliases.get("b", known));
+    REQUIRE(3 == aliases.get("c", known));
+
+    // A removed alias is reused, and the others keep theirs
+    aliases.remove("b");
+    REQUIRE(2 == aliases.size());
+    REQUIRE(2 == aliases.get("d", known));
+    REQUIRE(!known);
+    REQUIRE(3 == aliases.get("c", known));
+    REQUIRE(known);
+
+    aliases.remove("x");
+    REQUIRE(3 == aliases.size());
+}
@@ -89,3 +89,135 @@ TEST_CASE("matcher matches", "[topic_matcher]")
     REQUIRE(!(topic_matcher<int>{{"$BOB/bar", 42}}.has_match("$SYS/bar")));
     REQUIRE(!(topic_matcher<int>{{"+/bar", 42}}.has_match("$SYS/bar")));
 }
+
+TEST_CASE("matcher for each match", "[topic_matcher]")
+{
+    const topic_matcher<int> tm{
+        {"#", -1},
+        {"some/random/topic", 42},
+        {"some/#", 99},
+        {"some/+/topic", 33},
+        {"some/+/", 11},
+        {"$SYS/#", 55},
+    };
+
+    auto sum_matches = [&tm](const char* topic) {
+        int sum = 0;
+        tm.for_each_match(topic, [&sum](const auto& val) { sum += val.second; });
+        return sum;
+    };
+
+    REQUIRE(-1 + 42 + 99 + 33 == sum_matches("some/random/topic"));
+    REQUIRE(-1 + 99 + 11 == sum_matches("some/random/"));
+    REQUIRE(-1 + 99 == sum_matches("some/other"));
+    REQUIRE(-1 == sum_matches("other"));
+    REQUIRE(55 == sum_matches("$SYS/bar"));
+
+    // The iterator finds the same matches
+    int sum = 0;
+    for (auto it = tm.matches("some/random/topic"); it != tm.matches_cend(); ++it)
+        sum += it->second;
+    REQUIRE(-1 + 42 + 99 + 33 == sum);
+}
+
+TEST_CASE("matcher remove and prune", "[topic_matcher]")
+{
+    topic_matcher<int> tm;
+
+    // Enough filters to grow the child tables a few times
+    for (int i = 0; i < 100; ++i) tm.insert({"data/" + std::to_string(i) + "/value", i});
+    tm.insert({"data/+/value", -1});
+
+    REQUIRE(tm.has_match("data/42/value"));
+    REQUIRE(42 == tm.find("data/42/value")->second);
+
+    size_t n = 0;
+    for (auto it = tm.begin(); it != tm.end(); ++it) ++n;
+    REQUIRE(101 == n);
+
+    for (int i = 0; i < 100; i += 2) {
+        auto val = tm.remove("data/" + std::to_string(i) + "/value");
+        REQUIRE(val);
+        REQUIRE(i == *val);
+    }
+    REQUIRE(!tm.remove("data/0/value"));
+    REQUIRE(!tm.remove("no/such/filter"));
+
+    tm.prune();
+
+    n = 0;
+    for (auto it = tm.begin(); it != tm.end(); ++it) ++n;
+    REQUIRE(51 == n);
+
+    REQUIRE(!(tm.find("data/42/value") != tm.end()));
+    REQUIRE(43 == tm.find("data/43/value")->second);
+
+    // The pruned nodes are reused
+    tm.insert({"data/42/value", 42});
+    REQUIRE(42 == tm.find("data/42/value")->second);
+
+    tm.remove("data/+/value");
+    for (int i = 1; i < 100; i += 2) tm.remove("data/" + std::to_string(i) + "/value");
+    tm.remove("data/42/value");
+    tm.prune();
+    REQUIRE(tm.empty());
+}
+
+TEST_CASE("matcher match cache", "[topic_matcher]")
+{
+    topic_matcher<int> tm{{"some/#", 99}, {"some/+/topic", 33}};
+    REQUIRE(0 == tm.get_match_cache_size());
+
+    tm.set_match_cache_size(2);
+    REQUIRE(2 == tm.get_match_cache_size());
+
+    auto sum_matches = [&tm](const char* topic) {
+        int sum = 0;
+        tm.for_each_match(topic, [&sum](auto& val) { sum += val.second; });
+        return sum;
+    };
+
+    REQUIRE(99 + 33 == sum_matches("some/random/topic"));
+    REQUIRE(99 + 33 == sum_matches("some/random/topic"));
+    REQUIRE(99 == sum_matches("some/other"));
+    REQUIRE(0 == sum_matches("other"));
+    REQUIRE(99 + 33 == sum_matches("some/random/topic"));
+
+    // Inserting and removing invalidate the cache
+    tm.insert({"some/random/topic", 42});
+    REQUIRE(99 + 33 + 42 == sum_matches("some/random/topic"));
+
+    tm.remove("some/#");
+    REQUIRE(33 + 42 == sum_matches("some/random/topic"));
+    REQUIRE(0 == sum_matches("some/other"));
+
+    tm.set_match_cache_size(0);
+    REQUIRE(33 + 42 == sum_matches("some/random/topic"));
+}
+
+TEST_CASE("matcher for each filtered", "[topic_matcher]")
+{
+    const topic_matcher<int> tm{
+        {"a", 1},       {"a/b", 2},       {"a/b/c", 4},  {"a/x/c", 8},
+        {"d/b/c", 16},  {"$SYS/load", 32}, {"a/b/c/d", 64}
+    };
+
+    auto sum_filtered = [&tm](const char* filter) {
+        int sum = 0;
+        tm.for_each_filtered(filter, [&sum](const auto& val) { sum += val.second; });
+        return sum;
+    };
+
+    REQUIRE(4 == sum_filtered("a/b/c"));
+    REQUIRE(0 == sum_filtered("a/b/z"));
+    REQUIRE(4 + 8 == sum_filtered("a/+/c"));
+    REQUIRE(4 + 16 == sum_filtered("+/b/c"));
+    REQUIRE(2 + 4 + 64 == sum_filtered("a/b/#"));
+    REQUIRE(1 + 2 + 4 + 8 + 64 == sum_filtered("a/#"));
+
+    // Wildcards in the first level don't match '$' topics
+    REQUIRE(1 + 2 + 4 + 8 + 16 + 64 == sum_filtered("#"));
+    REQUIRE(0 == sum_filtered("+/load"));
+    REQUIRE(32 == sum_filtered("$SYS/#"));
+    REQUIRE(32 == sum_filtered("$SYS/+"));
+}
@@ -0,0 +1,114 @@
+// test_topic_stats.cpp
+//
+// Unit tests for the topic_stats class in the Paho MQTT C++ library.
+//
+
+/*******************************************************************************
+ * Copyright (c) 2025 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - Initial implementation
+ *******************************************************************************/
+
+#define UNIT_TESTS
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "catch2_version.h"
+#include "mqtt/topic_stats.h"
+
+using namespace mqtt;
+
+/////////////////////////////////////////////////////////////////////////////
+
+TEST_CASE("topic_stats filters", "[topic_stats]")
+{
+    topic_stats stats;
+    REQUIRE(stats.empty());
+    REQUIRE(stats.get_traffic().empty());
+
+    REQUIRE(stats.add_filter("data/#"));
+    REQUIRE(!stats.add_filter("data/#"));
+    REQUIRE(stats.add_filter("cmd/+"));
+    REQUIRE(!stats.empty());
+
+    auto traffic = stats.get_traffic();
+    REQUIRE(2 == traffic.size());
+    REQUIRE("cmd/+" == traffic[0].filter);
+    REQUIRE("data/#" == traffic[1].filter);
+
+    REQUIRE(stats.remove_filter("cmd/+"));
+    REQUIRE(!stats.remove_filter("cmd/+"));
+    REQUIRE(!stats.get_traffic("cmd/+"));
+    REQUIRE(1 == stats.get_traffic().size());
+}
+
+TEST_CASE("topic_stats counts", "[topic_stats]")
+{
+    auto stats = topic_stats::create({"data/#", "data/temp", "cmd/+"});
+
+    stats->count_received(*make_message("data/temp", "12345"));
+    stats->count_received(*make_message("data/humidity", "1"));
+    stats->count_published(*make_message("cmd/reset", "now"));
+    stats->count_published(*make_message("other", "ignored"));
+
+    // A message is counted in every filter that matches it
+    auto t = stats->get_traffic("data/#");
+    REQUIRE(t);
+    REQUIRE(2 == t->msgsReceived);
+    REQUIRE(9 + 5 + 13 + 1 == t->bytesReceived);
+    REQUIRE(0 == t->msgsPublished);
+
+    t = stats->get_traffic("data/temp");
+    REQUIRE(1 == t->msgsReceived);
+    REQUIRE(14 == t->bytesReceived);
+
+    t = stats->get_traffic("cmd/+");
+    REQUIRE(0 == t->msgsReceived);
+    REQUIRE(1 == t->msgsPublished);
+    REQUIRE(12 == t->bytesPublished);
+
+    // The counts survive a change to the filters
+    stats->add_filter("other");
+    REQUIRE(2 == stats->get_traffic("data/#")->msgsReceived);
+    REQUIRE(0 == stats->get_traffic("other")->msgsPublished);
+
+    auto start = stats->elapsed();
+    stats->reset();
+    REQUIRE(stats->elapsed() <= start);
+    for (const auto& tr : stats->get_traffic()) {
+        REQUIRE(0 == tr.msgsReceived);
+        REQUIRE(0 == tr.bytesReceived);
+        REQUIRE(0 == tr.msgsPublished);
+        REQUIRE(0 == tr.bytesPublished);
+    }
+}
+
+TEST_CASE("topic_stats threads", "[topic_stats]")
+{
+    topic_stats stats{"#"};
+    const int N_THREADS = 12, N = 1000;
+
+    std::vector<std::thread> thrs;
+    for (int i = 0; i < N_THREADS; ++i) {
+        thrs.emplace_back([&stats] {
+            for (int j = 0; j < N; ++j) stats.count_received("a/b", 10);
+        });
+    }
+    for (auto& thr : thrs) thr.join();
+
+    auto t = stats.get_traffic("#");
+    REQUIRE(uint64_t(N_THREADS * N) == t->msgsReceived);
+    REQUIRE(uint64_t(N_THREADS * N * 10) == t->bytesReceived);
+}